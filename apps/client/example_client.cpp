@@ -1,9 +1,23 @@
 #include <iostream>
 #include <thread>
 #include <chrono>
+#include <QCoreApplication>
 #include "network/config.h"
 #include "network/websocketimageclient.h"
-#include <QByteArray>
+#include "network/jpegcodec.h"
+#include "network/framebufferpool.h"
+#include "network/frametrace.h"
+#include "network/rawframe.h"
+#include "network/videocodec.h"
+#include "network/replaypacer.h"
+#include "network/replaysource.h"
+#include "network/capturesource.h"
+#include "network/encodepipeline.h"
+#include "network/changedetector.h"
+#include "network/tiledjpeg.h"
+#include "network/simulcast.h"
+#include "network/threadroles.h"
+#include <sstream>
 #include <opencv2/opencv.hpp>
 
 /// Example client application: Connects to server and streams video frames.
@@ -18,13 +32,172 @@
 ///   send_image_client [video_file_path]
 ///   send_image_client --video /path/to/video.mp4
 ///   send_image_client --server 192.168.1.100 --port 5000 --video video.mp4
+///   send_image_client --raw --video video.mp4   (uncompressed I420, for fast LANs)
+///   send_image_client --codec h264 --video video.mp4   (offer H.264, MJPEG if refused)
+///   send_image_client --codec tiles --video dashboard.mp4   (only the JPEG tiles that changed)
+///   send_image_client --replay recordings/cam-1 --speed 2   (pre-encoded frames, see below)
+///   send_image_client --trace client-trace.json --video video.mp4
+///   send_image_client --alias cam-1 --session cam-1 --video video.mp4   (stable session id)
+///   send_image_client --server node-a --standby node-b:5000 --video video.mp4   (failover)
+///   send_image_client --no-shm --video video.mp4   (loopback WebSocket even on the server's host)
+///   send_image_client --encode-threads 0 --video 4k.mp4   (JPEG encoding on every core)
+///   send_image_client --static-threshold 1.5 --video camera.mp4   (leave out static frames)
+///   send_image_client --simulcast 3 --layer-fps 30,15,5 --video camera.mp4   (several sizes at once)
+///   send_image_client --udp --udp-fec 30 --video camera.mp4   (frames over UDP on a lossy Wi-Fi link)
+///   send_image_client --tls --tls-ca ca.pem --video camera.mp4   (wss:// to a server with --tls-cert)
+///
+/// Every reconnect resumes the previous session (configured FPS, active status
+/// on the server) with the token the server issued; --session <id> sets a
+/// stable one that also survives restarts of this program.
+///
+/// --standby <host[:port]> (repeatable) adds a server to fail over to: every
+/// connect races the standbys behind the primary, and the time from losing a
+/// connection to streaming again is printed after each failover.
+///
+/// --thread-roles <spec> places the threads on CPUs with a priority, e.g.
+/// "client-encode=0-2;io=3/-5" on a 4-core board: encoders off the core the
+/// connection's I/O runs on (threadroles.h; IMAGESOCKET_THREAD_ROLES too).
+///
+/// --keepalive <ms> is the dead-server detection: a connection that stays
+/// silent for 3 x <ms>, pinged half way, counts as lost and the reconnect (or
+/// failover) starts (default 2000: within 6 s; 0: off, TCP timeouts only).
+///
+/// With the server on the same host, frames go through a shared-memory ring
+/// instead of the socket; --no-shm keeps them on the WebSocket.
+///
+/// --udp offers UDP for the frames: with a server started with --udp-frames,
+/// each frame goes out as datagrams plus Reed-Solomon parity, --udp-fec
+/// <percent> of its data datagrams (default 20), so losses up to that share
+/// cost nothing and heavier ones only the frames they hit: nothing waits for
+/// a retransmission as on TCP. Control stays on the WebSocket.
+///
+/// --tls connects with TLS to a server started with --tls-cert. The server's
+/// certificate must be signed by --tls-ca <pem> (default: the system's trust
+/// store) and name the --server host or address; --tls-insecure skips that
+/// check (self-signed test setups). Reconnects resume the TLS session, and
+/// where the kernel supports it (kTLS) it encrypts the frames, not OpenSSL.
+///
+/// --encode-threads <n> JPEG-encodes frames on n threads (0: one per core,
+/// default 1) for sources one core can't keep up with, such as 4K cameras.
+/// Frames still reach the send queue in capture order. Raw frames and the
+/// H.264/H.265 mode (one encoder with references) stay on a single thread.
+///
+/// --static-threshold <mean> leaves out frames that barely differ from the
+/// last one sent: mean luma difference per cell of a 16x16 grid below <mean>
+/// (0-255, e.g. 1.5) and no single cell off by 12 or more. The server gets a
+/// small UNCHANGED heartbeat instead and keeps the stream live; a static
+/// scene is still sent every 5 s. Off by default; not used with H.264/H.265,
+/// whose encoder already makes static frames cheap.
+///
+/// --codec tiles offers the tiled JPEG mode: frames are cut into tiles
+/// (--tile-size <px>, default 64) and only the tiles whose mean difference
+/// per byte from their last sent version is above --tile-threshold <mean>
+/// (default 1) are sent; a frame without any is an UNCHANGED heartbeat. The
+/// server keeps the whole frame and patches the tiles in. Meant for
+/// dashboards and fixed cameras on links without an H.264 stack.
+///
+/// --simulcast <n> (2-4) sends the capture as n JPEG layers at once, layer k
+/// at 1/2^k of the size (the server's size bound applies to layer 0), and
+/// --layer-fps a,b,... gives each its own rate (default: every captured frame).
+/// The server shows and relays the layer each consumer needs, so a thumbnail,
+/// a full-screen view and a viewer on a slow link are served without
+/// re-encoding, and pauses the layers nobody takes. MJPEG only.
+///
+/// --trace <file> records the frame lifecycle (capture, encode, queue, write)
+/// and writes it as a Chrome trace (chrome://tracing, ui.perfetto.dev) after
+/// every streaming cycle; IMAGESOCKET_TRACE=1 only turns the recording on.
+///
+/// Replay mode (--replay <path>) sends pre-encoded frames without touching
+/// OpenCV, so the load generator costs next to nothing and every run sends the
+/// same bytes: a recorded segment or client directory (server --record) or a
+/// directory of JPEG files (--replay-fps apart, default 30). Frames are paced
+/// at their recorded timestamps, --speed times faster (0: as fast as the link
+/// takes them). The server's FPS and size requests don't apply to a replay;
+/// recorded video packets are skipped (they need a negotiated codec).
 ///
 /// The application loops 100 times, each iteration:
 ///   - Connects to the server (with exponential backoff if needed).
 ///   - Opens the video file.
-///   - Streams all frames at ~30 FPS.
+///   - Streams the video at the server's FPS (30 by default), read on a
+///     capture thread paced to absolute deadlines; encoding takes the newest
+///     frame. Below the video's own rate the video still plays in real time:
+///     frames off the schedule are grabbed but never decoded or encoded. A lost connection is re-established in the background; capture
+///     goes on and frames are dropped until it is back.
 ///   - Disconnects and repeats.
 ///
+// A captured frame for the encode workers, and what they hand to the send queue
+struct EncodeJob {
+    cv::Mat image;
+    FrameInfo info;
+    FrameSize target;
+    int quality = 75;
+};
+
+struct EncodedJpeg {
+    std::shared_ptr<FrameBufferPool::Buffer> buffer;
+    FrameInfo info;
+};
+
+// Streams `source` once over a connected client; false when the connection was lost
+static bool replayFrames(WebSocketImageClient& client, ReplaySource& source, ReplayPacer& pacer)
+{
+    using namespace std::chrono;
+    const auto nowUs = [] {
+        return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+    };
+    source.rewind();
+    pacer.reset();
+
+    ReplaySource::Frame frame;
+    std::uint64_t sentFrames = 0;
+    std::uint64_t skippedFrames = 0;
+    std::uint64_t videoPackets = 0;
+    while (source.next(frame)) {
+        const std::int64_t wait = pacer.dueUs(frame.timestampUs, nowUs()) - nowUs();
+        if (wait > 0)
+            std::this_thread::sleep_for(microseconds(wait));
+
+        SendResult state = client.sendQueueState();
+        while (state.connected() && state.paused()) {
+            std::this_thread::sleep_for(milliseconds(100));
+            state = client.sendQueueState();
+        }
+        if (!state.connected())
+            return false;
+        // Saturated link: the frame's slot passes, the schedule stays
+        if (state.saturated()) {
+            ++skippedFrames;
+            continue;
+        }
+
+        // Capture time is the send time: latency is measured from here, not from the recording
+        FrameInfo info;
+        info.width = frame.width;
+        info.height = frame.height;
+        SendResult sent;
+        switch (frame.payload) {
+        case FramePayload::Jpeg:
+            sent = client.sendFrame(frame.data, info);
+            break;
+        case FramePayload::RawYuv:
+            sent = client.sendRawFrame(std::vector<std::uint8_t>(frame.data.cbegin(), frame.data.cend()), info);
+            break;
+        case FramePayload::Video:
+            ++videoPackets;
+            continue;
+        }
+        if (!sent.connected())
+            return false;
+        ++sentFrames;
+    }
+
+    std::cout << "Replayed " << sentFrames << " frames, " << skippedFrames << " skipped (uplink saturated)";
+    if (videoPackets > 0)
+        std::cout << ", " << videoPackets << " video packets not sent";
+    std::cout << "." << std::endl;
+    return true;
+}
+
 int main(int argc, char** argv)
 {
     // Simple CLI: use flags --server <addr> --port <port> --video <path>
@@ -32,6 +205,28 @@ int main(int argc, char** argv)
     int serverPort = kDefaultServerPort;
     std::string videoPath;
     std::string alias;
+    bool rawFrames = false;
+    VideoCodec offeredCodec = VideoCodec::Mjpeg;
+    std::string replayPath;
+    double replaySpeed = 1.0;
+    int replayFps = 30;
+    std::string tracePath;
+    std::string sessionToken;
+    std::vector<std::string> standbys;
+    int keepaliveMs = -1;
+    std::string threadRoles;
+    bool sharedMemory = true;
+    bool udpFrames = false;
+    double udpFecPercent = 20.0;
+    bool tls = false;
+    std::string tlsCa;
+    bool tlsVerify = true;
+    int encodeThreads = 1;
+    double staticThreshold = 0.0;
+    int tileSize = 64;
+    double tileThreshold = 1.0;
+    int simulcastLayers = 0;
+    std::vector<int> layerFps;
 
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
@@ -43,15 +238,181 @@ int main(int argc, char** argv)
             videoPath = argv[++i];
         } else if (arg == "--alias" && i + 1 < argc) {
             alias = argv[++i];
+        } else if (arg == "--raw") {
+            rawFrames = true;
+        } else if (arg == "--codec" && i + 1 < argc) {
+            const std::string name = argv[++i];
+            if (name == "h264")
+                offeredCodec = VideoCodec::H264;
+            else if (name == "h265")
+                offeredCodec = VideoCodec::H265;
+            else if (name == "tiles")
+                offeredCodec = VideoCodec::TiledJpeg;
+        } else if (arg == "--replay" && i + 1 < argc) {
+            replayPath = argv[++i];
+        } else if (arg == "--speed" && i + 1 < argc) {
+            replaySpeed = std::stod(argv[++i]);
+        } else if (arg == "--replay-fps" && i + 1 < argc) {
+            replayFps = std::stoi(argv[++i]);
+        } else if (arg == "--trace" && i + 1 < argc) {
+            tracePath = argv[++i];
+        } else if (arg == "--session" && i + 1 < argc) {
+            sessionToken = argv[++i];
+        } else if (arg == "--standby" && i + 1 < argc) {
+            standbys.push_back(argv[++i]);
+        } else if (arg == "--thread-roles" && i + 1 < argc) {
+            threadRoles = argv[++i];
+        } else if (arg == "--keepalive" && i + 1 < argc) {
+            keepaliveMs = std::max(0, std::stoi(argv[++i]));
+        } else if (arg == "--no-shm") {
+            sharedMemory = false;
+        } else if (arg == "--udp") {
+            udpFrames = true;
+        } else if (arg == "--udp-fec" && i + 1 < argc) {
+            udpFecPercent = std::max(0.0, std::stod(argv[++i]));
+        } else if (arg == "--tls") {
+            tls = true;
+        } else if (arg == "--tls-ca" && i + 1 < argc) {
+            tls = true;
+            tlsCa = argv[++i];
+        } else if (arg == "--tls-insecure") {
+            tls = true;
+            tlsVerify = false;
+        } else if (arg == "--encode-threads" && i + 1 < argc) {
+            encodeThreads = std::stoi(argv[++i]);
+        } else if (arg == "--static-threshold" && i + 1 < argc) {
+            staticThreshold = std::stod(argv[++i]);
+        } else if (arg == "--tile-size" && i + 1 < argc) {
+            tileSize = std::stoi(argv[++i]);
+        } else if (arg == "--tile-threshold" && i + 1 < argc) {
+            tileThreshold = std::stod(argv[++i]);
+        } else if (arg == "--simulcast" && i + 1 < argc) {
+            simulcastLayers = std::min(std::stoi(argv[++i]), kMaxSimulcastLayers);
+        } else if (arg == "--layer-fps" && i + 1 < argc) {
+            std::istringstream list(argv[++i]);
+            std::string item;
+            while (std::getline(list, item, ','))
+                layerFps.push_back(std::stoi(item));
         } else if (videoPath.empty()) {
             // Backwards-compatible positional first argument treated as video path
             videoPath = arg;
         }
     }
 
+    if (!tracePath.empty())
+        FrameTrace::setEnabled(true);
+    FrameTrace::enableFromEnvironment();
+    FrameTrace::setThreadName("encode");
+    {
+        std::string error;
+        ThreadRoleConfig roles;
+        if (!ThreadRoles::configureFromEnvironment(&error))
+            std::cerr << "IMAGESOCKET_THREAD_ROLES ignored: " << error << std::endl;
+        if (!threadRoles.empty() && ThreadRoles::parse(threadRoles, roles, &error))
+            ThreadRoles::configure(roles);
+        else if (!threadRoles.empty())
+            std::cerr << "--thread-roles ignored: " << error << std::endl;
+    }
+    ThreadRoles::apply(ThreadRole::ClientEncode); // this thread encodes unless --encode-threads says otherwise
+    const auto writeTrace = [&tracePath]() {
+        const int pid = static_cast<int>(QCoreApplication::applicationPid());
+        if (!tracePath.empty() && !FrameTrace::writeChromeJson(tracePath, pid, "client"))
+            std::cerr << "Could not write the trace to " << tracePath << std::endl;
+    };
+
     // Use the new WebSocket-based client
     WebSocketImageClient client(QString::fromStdString(serverAddr), static_cast<quint16>(serverPort));
     if (!alias.empty()) client.setAlias(QString::fromStdString(alias));
+    if (!sessionToken.empty()) client.setSessionToken(QString::fromStdString(sessionToken));
+    client.setSharedMemoryTransport(sharedMemory);
+    client.setUdpTransport(udpFrames, udpFecPercent / 100.0);
+    if (tls && !client.setTls(true, QString::fromStdString(tlsCa), tlsVerify))
+        return 1;
+    if (keepaliveMs >= 0) {
+        KeepaliveConfig keepalive = client.keepalive();
+        keepalive.intervalMs = keepaliveMs;
+        client.setKeepalive(keepalive);
+    }
+    std::vector<ServerEndpoint> standbyServers;
+    for (const std::string& standby : standbys) {
+        ServerEndpoint server;
+        const std::size_t colon = standby.rfind(':');
+        server.host = QString::fromStdString(standby.substr(0, colon));
+        server.port = static_cast<quint16>(colon == std::string::npos ? serverPort : std::stoi(standby.substr(colon + 1)));
+        standbyServers.push_back(server);
+    }
+    client.setStandbyServers(standbyServers);
+    client.setOnFailover([](int server, std::int64_t ms) {
+        std::cout << "Streaming again via " << (server == 0 ? std::string("the primary") : "standby " + std::to_string(server))
+                  << " after " << ms << " ms." << std::endl;
+    });
+
+    // Encoder for this thread and recycled output buffers: once the send path releases
+    // a frame its buffer comes back here, so steady-state encoding does not allocate.
+    JpegCodec& codec = JpegCodec::forCurrentThread();
+    if (encodeThreads <= 0)
+        encodeThreads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    FrameBufferPool encodeBuffers(static_cast<std::size_t>(std::max(4, encodeThreads * 3)));
+    std::cout << "JPEG codec: " << codec.name() << std::endl;
+
+    // Inter-frame codecs are only offered when an encoder is built in; the
+    // server picks one per connection (SET_CODEC) and MJPEG stays the fallback.
+    // Tiles only need the JPEG codec.
+    if (offeredCodec == VideoCodec::TiledJpeg) {
+        client.setSupportedCodecs({offeredCodec});
+    } else if (isInterFrameCodec(offeredCodec)) {
+        if (VideoEncoder::available(offeredCodec))
+            client.setSupportedCodecs({offeredCodec});
+        else
+            std::cerr << "No " << videoCodecName(offeredCodec) << " encoder available, sending MJPEG." << std::endl;
+    }
+    if (simulcastLayers > 1) {
+        if (offeredCodec != VideoCodec::Mjpeg || rawFrames) {
+            std::cerr << "Simulcast layers are JPEG: sending MJPEG." << std::endl;
+            offeredCodec = VideoCodec::Mjpeg;
+            rawFrames = false;
+            client.setSupportedCodecs({});
+        }
+        client.setSimulcastLayers(simulcastLayers);
+        std::cout << "Simulcast: " << simulcastLayers << " layers." << std::endl;
+    } else {
+        simulcastLayers = 0;
+    }
+    // Parallel JPEG encoding: workers scale and encode with their own codec,
+    // the pipeline queues the results in capture order
+    std::unique_ptr<EncodePipeline<EncodeJob, EncodedJpeg>> encoders;
+    if (encodeThreads > 1) {
+        encoders.reset(new EncodePipeline<EncodeJob, EncodedJpeg>(encodeThreads,
+            [&encodeBuffers](EncodeJob& job, EncodedJpeg& out) {
+                FrameTrace::setThreadName("encode");
+                ThreadRoles::apply(ThreadRole::ClientEncode);
+                FrameTraceScope trace("encode", "client");
+                cv::Mat scaled;
+                const cv::Mat* image = &job.image;
+                if (job.target.width != image->cols || job.target.height != image->rows) {
+                    cv::resize(*image, scaled, cv::Size(job.target.width, job.target.height), 0, 0, cv::INTER_AREA);
+                    image = &scaled;
+                }
+                out.buffer = encodeBuffers.acquire();
+                out.info = job.info;
+                return JpegCodec::forCurrentThread().encodeBgr(image->data, image->cols, image->rows,
+                                                               static_cast<int>(image->step), job.quality, *out.buffer);
+            },
+            [&client](std::uint64_t, EncodedJpeg& out) {
+                client.sendFrame(SharedFrameBuffer(std::move(out.buffer)), out.info);
+            }));
+        std::cout << "JPEG encoding on " << encodeThreads << " threads." << std::endl;
+    }
+    std::unique_ptr<VideoEncoder> videoEncoder;
+    TiledJpegEncoder tiledEncoder(tileSize, tileThreshold);
+    cv::Mat yuv; // reused I420 conversion target for the video encoder
+
+    ReplaySource replaySource;
+    ReplayPacer replayPacer(replaySpeed);
+    if (!replayPath.empty() && !replaySource.open(QString::fromStdString(replayPath), replayFps)) {
+        std::cerr << "Nothing to replay in: " << replayPath << std::endl;
+        return 1;
+    }
 
     // Main loop: demonstrates the client's connect, stream and disconnect cycle.
     for( int i = 0; i < 100; i++ )
@@ -66,6 +427,15 @@ int main(int argc, char** argv)
         }
 
         std::cout << "Socket client connected." << std::endl;
+        if (!replayPath.empty()) {
+            if (!replayFrames(client, replaySource, replayPacer))
+                std::cout << "Connection lost, disconnecting." << std::endl;
+            client.disconnectFromServer();
+            std::cout << "Socket client disconnected." << std::endl;
+            writeTrace();
+            continue;
+        }
+
         // Open the video file using OpenCV.
         // If no path was provided on the command line, use a default (for testing).
         if (videoPath.empty()) {
@@ -80,31 +450,258 @@ int main(int argc, char** argv)
             return 1;
         }
 
-        // Stream video frames at approximately 30 FPS.
-        // Each frame is encoded to JPEG and sent to the server by the client's send thread.
-        cv::Mat frame;
-        while (videoCapture.read(frame)) {
+        // Frames are read on their own thread at the configured FPS, on a fixed
+        // schedule; this loop encodes the newest one and sends it through the
+        // client's send thread, so encoding time doesn't slow the capture rate.
+        // With the server asking for fewer frames than the video has, the
+        // others are only grabbed: never decoded, converted or encoded.
+        CaptureSource capture([&videoCapture](cv::Mat& frame) {
+            FrameTraceScope trace("capture", "client");
+            return videoCapture.retrieve(frame);
+        });
+        capture.setGrabber([&videoCapture]() {
+            FrameTrace::setThreadName("capture");
+            return videoCapture.grab();
+        });
+        capture.setSourceFps(videoCapture.get(cv::CAP_PROP_FPS));
+        capture.start();
+        CaptureSource::Frame captured;
+        cv::Mat scaled; // reused between frames while a size bound is set
+        int skippedFrames = 0;
+        ChangeDetector staticScene(staticThreshold);
+        std::int64_t nextLayerUs[kMaxSimulcastLayers] = {};
+        bool wasPaused = false;
+        bool offline = false;
+        int offlineFrames = 0;
+        for (;;) {
+            // Read configured FPS from server (if provided) and capture at that rate.
+            int fps = client.configuredFps();
+            if (fps <= 0) fps = 30; // default fallback
+            capture.setFps(fps);
+
+            // The client reconnects on its own: keep the capture running and drop what it reads
+            const SendResult state = client.sendQueueState();
+            if (!state.connected()) {
+                if (!offline)
+                    std::cout << "Connection lost, dropping frames until the client reconnects." << std::endl;
+                offline = true;
+                capture.setPaused(false);
+                if (capture.take(captured, 1000))
+                    ++offlineFrames;
+                else if (capture.finished())
+                    break;
+                continue;
+            }
+            if (offline) {
+                std::cout << "Reconnected, " << offlineFrames << " frames dropped meanwhile." << std::endl;
+                staticScene.reset(); // the server may have lost the last frame
+            }
+            offline = false;
+            offlineFrames = 0;
+
+            // Another client is active on the server: stop capturing and encoding until resumed
+            if (state.paused()) {
+                if (!wasPaused)
+                    std::cout << "Paused by server." << std::endl;
+                wasPaused = true;
+                capture.setPaused(true);
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                continue;
+            }
+            if (wasPaused) {
+                std::cout << "Resumed by server." << std::endl;
+                staticScene.reset();
+            }
+            wasPaused = false;
+            capture.setPaused(false);
+
+            if (!capture.take(captured, 1000)) {
+                if (capture.finished())
+                    break;
+                continue;
+            }
+            const cv::Mat& frame = captured.image;
+            // Stamped at capture so the server's latency figures include encoding
+            FrameInfo info;
+            info.captureTimeUs = captured.captureTimeUs;
+
+            // Link saturated: don't spend CPU encoding a frame that would only be dropped
+            if (state.saturated()) {
+                if (++skippedFrames % 30 == 1)
+                    std::cout << "Uplink saturated, skipped " << skippedFrames << " frames so far." << std::endl;
+                continue;
+            }
+
             // Encode frame as JPEG
-            std::vector<int> params = {cv::IMWRITE_JPEG_QUALITY, 75};
-            std::vector<unsigned char> buf;
-            cv::imencode(".jpg", frame, buf, params);
-            QByteArray jpegData(reinterpret_cast<const char*>(buf.data()), static_cast<int>(buf.size()));
-
-            if (!client.sendFrame(jpegData)) {
-                std::cout << "Failed to send frame, disconnecting." << std::endl;
-                break;
+            if (frame.type() != CV_8UC3)
+                continue;
+
+            // Region of interest from the server: a view into the captured frame, nothing is copied
+            const FrameRegion roi = client.regionOfInterest();
+            if (!roi.isFull()) {
+                const FrameRect crop = cropRect(frame.cols, frame.rows, roi);
+                captured.image = captured.image(cv::Rect(crop.x, crop.y, crop.width, crop.height));
             }
 
-            // Read configured FPS from server (if provided) and simulate that rate.
-            int fps = client.configuredFps();
-            if (fps <= 0) fps = 30; // default fallback
-            int delay = std::max(1, 1000 / fps);
-            std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+            // Static scene: a heartbeat instead of encoding and sending the same picture again
+            const VideoCodec streamCodec = client.negotiatedCodec();
+            if (staticThreshold > 0.0 && !usesVideoPackets(streamCodec)
+                && !staticScene.shouldSend(frame.data, frame.cols, frame.rows, frame.step, 3, captured.captureTimeUs)) {
+                client.sendUnchanged(info);
+                for (int layer = 1; layer < simulcastLayers; ++layer) {
+                    info.streamId = static_cast<std::uint16_t>(layer);
+                    client.sendUnchanged(info); // refused for a paused layer
+                }
+                continue;
+            }
+
+            // Trace span from here (scaling included) until the payload is handed to the client
+            const std::int64_t encodeStartUs = FrameTrace::isEnabled() ? FrameTrace::nowUs() : -1;
+            const auto traceEncoded = [encodeStartUs]() {
+                if (encodeStartUs >= 0)
+                    FrameTrace::complete("encode", "client", encodeStartUs, FrameTrace::nowUs() - encodeStartUs);
+            };
+
+            // Thumbnail substream or display-sized stream: downscale to the server's bound before encoding
+            const FrameSize target = fitFrameSize(frame.cols, frame.rows,
+                                                  client.maxFrameWidth(), client.maxFrameHeight());
+            if (simulcastLayers > 1) {
+                // Every layer the server takes, due at its own rate, from this one capture
+                const int quality = client.configuredQuality() > 0 ? client.configuredQuality() : 75;
+                const std::int64_t slackUs = 500000 / fps; // half a capture interval of jitter
+                for (int layer = 0; layer < simulcastLayers; ++layer) {
+                    if (client.isPaused(static_cast<std::uint16_t>(layer))
+                        || captured.captureTimeUs + slackUs < nextLayerUs[layer])
+                        continue;
+                    const int rate = layer < static_cast<int>(layerFps.size()) ? layerFps[layer] : 0;
+                    nextLayerUs[layer] = rate > 0 ? captured.captureTimeUs + 1000000 / rate : 0;
+                    const FrameSize size = fitFrameSize(frame.cols, frame.rows, std::max(1, target.width >> layer),
+                                                        std::max(1, target.height >> layer));
+                    FrameInfo layerInfo = info;
+                    layerInfo.streamId = static_cast<std::uint16_t>(layer);
+                    if (encoders) {
+                        EncodeJob job;
+                        job.image = frame; // shared, not copied: the workers only read it
+                        job.info = layerInfo;
+                        job.target = size;
+                        job.quality = quality;
+                        encoders->submit(std::move(job));
+                        continue;
+                    }
+                    const cv::Mat* image = &frame;
+                    if (size.width != frame.cols || size.height != frame.rows) {
+                        cv::resize(frame, scaled, cv::Size(size.width, size.height), 0, 0, cv::INTER_AREA);
+                        image = &scaled;
+                    }
+                    std::shared_ptr<FrameBufferPool::Buffer> buf = encodeBuffers.acquire();
+                    if (!codec.encodeBgr(image->data, image->cols, image->rows, static_cast<int>(image->step), quality, *buf))
+                        continue;
+                    if (!client.sendFrame(SharedFrameBuffer(std::move(buf)), layerInfo).connected())
+                        ++offlineFrames;
+                }
+                traceEncoded();
+                captured.image = cv::Mat(); // the workers hold the frame now
+                continue;
+            }
+            if (encoders && !rawFrames && !usesVideoPackets(streamCodec)) {
+                // Waits while every worker is busy; the capture thread meanwhile keeps the newest frame
+                EncodeJob job;
+                job.image = std::move(captured.image);
+                job.info = info;
+                job.target = target;
+                job.quality = client.configuredQuality() > 0 ? client.configuredQuality() : 75;
+                encoders->submit(std::move(job));
+                continue;
+            }
+            if (encoders)
+                encoders->flush(); // frames encoded here must not overtake the workers' ones
+            const cv::Mat* image = &frame;
+            if (target.width != frame.cols || target.height != frame.rows) {
+                cv::resize(frame, scaled, cv::Size(target.width, target.height), 0, 0, cv::INTER_AREA);
+                image = &scaled;
+            }
+            std::shared_ptr<FrameBufferPool::Buffer> buf = encodeBuffers.acquire();
+            SendResult sent;
+            if (streamCodec == VideoCodec::TiledJpeg) {
+                // The tiles that changed since they were last sent; none at all: a heartbeat
+                int quality = client.configuredQuality();
+                if (quality <= 0) quality = 75; // default fallback
+                if (!tiledEncoder.encode(image->data, image->cols, image->rows, static_cast<int>(image->step), quality,
+                                         client.takeKeyframeRequest(), *buf))
+                    continue;
+                traceEncoded();
+                sent = buf->empty() ? client.sendUnchanged(info)
+                                    : client.sendVideoPacket(SharedFrameBuffer(std::move(buf)), info);
+            } else if (isInterFrameCodec(streamCodec)) {
+                // One encoder per negotiated codec; it keeps its references across frames
+                if (!videoEncoder || videoEncoder->codec() != streamCodec) {
+                    videoEncoder = VideoEncoder::create(streamCodec);
+                    if (videoEncoder)
+                        std::cout << videoCodecName(streamCodec) << " encoder: " << videoEncoder->name() << std::endl;
+                }
+                if (!videoEncoder)
+                    continue;
+                const int width = image->cols & ~1;
+                const int height = image->rows & ~1;
+                cv::cvtColor((*image)(cv::Rect(0, 0, width, height)), yuv, cv::COLOR_BGR2YUV_I420);
+                YuvFrameView picture;
+                picture.layout = YuvLayout::I420;
+                picture.width = width;
+                picture.height = height;
+                picture.y = yuv.data;
+                picture.u = picture.y + width * height;
+                picture.v = picture.u + width * height / 4;
+                picture.yStride = width;
+                picture.uvStride = width / 2;
+                picture.limitedRange = true;
+                int quality = client.configuredQuality();
+                if (quality <= 0) quality = 75; // default fallback
+                if (!videoEncoder->encode(picture, fps, quality, client.takeKeyframeRequest(), *buf) || buf->empty())
+                    continue;
+                traceEncoded();
+                sent = client.sendVideoPacket(SharedFrameBuffer(std::move(buf)), info);
+            } else if (rawFrames) {
+                // Raw I420 (OpenCV converts to video range), written straight after the header
+                RawFrameHeader header;
+                header.width = image->cols & ~1;
+                header.height = image->rows & ~1;
+                header.limitedRange = true;
+                if (!prepareRawFrame(header, *buf))
+                    continue;
+                cv::Mat planes(header.height * 3 / 2, header.width, CV_8UC1, buf->data() + kRawFrameHeaderSize);
+                cv::cvtColor((*image)(cv::Rect(0, 0, header.width, header.height)), planes, cv::COLOR_BGR2YUV_I420);
+                traceEncoded();
+                sent = client.sendRawFrame(SharedFrameBuffer(std::move(buf)), info);
+            } else {
+                // Quality follows the server's rate controller (SET_QUALITY)
+                int quality = client.configuredQuality();
+                if (quality <= 0) quality = 75; // default fallback
+                if (!codec.encodeBgr(image->data, image->cols, image->rows, static_cast<int>(image->step), quality, *buf))
+                    continue;
+                traceEncoded();
+                sent = client.sendFrame(SharedFrameBuffer(std::move(buf)), info);
+            }
+
+            // Buffers are handed over without copying them; a frame lost with the
+            // connection is counted with the ones dropped until it is back
+            if (!sent.connected())
+                ++offlineFrames;
         }
+        capture.stop();
+        if (encoders)
+            encoders->flush();
+        if (capture.skippedFrames() > 0)
+            std::cout << capture.skippedFrames() << " source frames left out for the server's FPS, not decoded." << std::endl;
+        if (staticScene.unchangedFrames() > 0)
+            std::cout << staticScene.unchangedFrames() << " frames of a static scene sent as UNCHANGED heartbeats." << std::endl;
+        if (capture.droppedFrames() > 0)
+            std::cout << capture.droppedFrames() << " captured frames replaced before encoding (encoder slower than "
+                      << "the capture rate)." << std::endl;
 
         // Gracefully disconnect and repeat.
         client.disconnectFromServer();
         std::cout << "Socket client disconnected." << std::endl;
+        writeTrace();
     }
 
     std::cout << "Socket client finished." << std::endl;
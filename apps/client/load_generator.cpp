@@ -0,0 +1,252 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "network/config.h"
+#include "network/websocketimageclient.h"
+#include "network/jpegcodec.h"
+#include "network/replaysource.h"
+
+/// Synthetic multi-client load for server capacity runs.
+///
+/// Opens --clients connections (WebSocketImageClient, one IO thread each) and
+/// sends --fps frames per second on every one of them from a single pacing
+/// thread. Frames are encoded once before the run (or read from --replay), and
+/// all clients send the same shared buffers, so the generator itself costs
+/// little CPU and every run sends the same bytes.
+///
+/// Usage:
+///   load_generator --clients 32 --fps 30 --width 1280 --height 720
+///                  [--quality 75] [--duration 30] [--server 127.0.0.1] [--port 5000]
+///                  [--replay <recording, segment or JPEG directory>]
+///
+/// Prints a "load" line per second and a "summary" line at the end:
+///   clients connected, target and achieved send fps, frames dropped by the
+///   clients' send queues (link or server not keeping up) and frames the server
+///   paused. Server-side fps, latency and CPU come from the server's --stats
+///   lines; scripts/capacity_sweep.sh runs both and finds the saturation point.
+///
+
+namespace {
+
+const int kSyntheticFrames = 30;   // distinct frames cycled through
+const int kMaxReplayFrames = 300;  // replay frames held in memory
+
+struct Options {
+    std::string server = kDefaultServerAddress;
+    int port = kDefaultServerPort;
+    int clients = 8;
+    int fps = 30;
+    int width = 1280;
+    int height = 720;
+    int quality = 75;
+    int durationSec = 30;
+    std::string replayPath;
+};
+
+struct Counters {
+    std::uint64_t sent = 0;
+    std::uint64_t dropped = 0; // rejected or evicted by a send queue
+    std::uint64_t paused = 0;  // the server paused the client
+    std::uint64_t late = 0;    // slots missed because the pacing thread fell behind
+};
+
+// BGR test pattern: gradient, moving block and fixed noise, so JPEG sizes and
+// decode cost are close to camera frames rather than flat colour
+std::vector<SharedFrameBuffer> syntheticFrames(const Options& options)
+{
+    std::vector<SharedFrameBuffer> frames;
+    JpegCodec& codec = JpegCodec::forCurrentThread();
+    const int stride = options.width * 3;
+    std::vector<unsigned char> pixels(static_cast<std::size_t>(stride) * options.height);
+    std::uint32_t seed = 12345;
+    std::vector<unsigned char> noise(pixels.size());
+    for (unsigned char& value : noise) {
+        seed = seed * 1664525u + 1013904223u;
+        value = static_cast<unsigned char>(seed >> 27); // 0-31
+    }
+
+    for (int f = 0; f < kSyntheticFrames; ++f) {
+        const int blockX = (options.width - options.width / 4) * f / kSyntheticFrames;
+        for (int y = 0; y < options.height; ++y) {
+            unsigned char* row = pixels.data() + static_cast<std::size_t>(y) * stride;
+            const unsigned char* noiseRow = noise.data() + static_cast<std::size_t>(y) * stride;
+            for (int x = 0; x < options.width; ++x) {
+                const bool block = x >= blockX && x < blockX + options.width / 4 && y > options.height / 3
+                    && y < options.height * 2 / 3;
+                row[x * 3 + 0] = static_cast<unsigned char>(block ? 40 : 255 * x / options.width);
+                row[x * 3 + 1] = static_cast<unsigned char>(block ? 200 : 255 * y / options.height);
+                row[x * 3 + 2] = static_cast<unsigned char>(128 + noiseRow[x * 3]);
+            }
+        }
+        std::vector<unsigned char> jpeg;
+        if (!codec.encodeBgr(pixels.data(), options.width, options.height, stride, options.quality, jpeg))
+            break;
+        frames.push_back(std::make_shared<const std::vector<std::uint8_t>>(std::move(jpeg)));
+    }
+    return frames;
+}
+
+// JPEG frames of a recording or directory; other payloads are left out
+std::vector<SharedFrameBuffer> replayFrames(const std::string& path)
+{
+    std::vector<SharedFrameBuffer> frames;
+    ReplaySource source;
+    if (!source.open(QString::fromStdString(path)))
+        return frames;
+    ReplaySource::Frame frame;
+    while (frames.size() < static_cast<std::size_t>(kMaxReplayFrames) && source.next(frame)) {
+        if (frame.payload != FramePayload::Jpeg)
+            continue;
+        frames.push_back(std::make_shared<const std::vector<std::uint8_t>>(frame.data.cbegin(), frame.data.cend()));
+    }
+    return frames;
+}
+
+std::int64_t nowUs()
+{
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+void printLine(const char* kind, const Options& options, int connected, const Counters& counters,
+               double seconds)
+{
+    const double sentFps = seconds > 0.0 ? counters.sent / seconds : 0.0;
+    const std::uint64_t offered = counters.sent + counters.dropped;
+    const double dropPercent = offered > 0 ? 100.0 * counters.dropped / offered : 0.0;
+    std::printf("%s clients=%d connected=%d target_fps=%d sent_fps=%.1f dropped=%llu drop_percent=%.2f "
+                "paused=%llu late=%llu\n",
+                kind, options.clients, connected, options.clients * options.fps, sentFps,
+                static_cast<unsigned long long>(counters.dropped), dropPercent,
+                static_cast<unsigned long long>(counters.paused), static_cast<unsigned long long>(counters.late));
+    std::fflush(stdout);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--server" && hasValue)
+            options.server = argv[++i];
+        else if (arg == "--port" && hasValue)
+            options.port = std::stoi(argv[++i]);
+        else if (arg == "--clients" && hasValue)
+            options.clients = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--fps" && hasValue)
+            options.fps = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--width" && hasValue)
+            options.width = std::max(16, std::stoi(argv[++i]));
+        else if (arg == "--height" && hasValue)
+            options.height = std::max(16, std::stoi(argv[++i]));
+        else if (arg == "--quality" && hasValue)
+            options.quality = std::stoi(argv[++i]);
+        else if (arg == "--duration" && hasValue)
+            options.durationSec = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--replay" && hasValue)
+            options.replayPath = argv[++i];
+        else
+            std::cerr << "Ignoring argument: " << arg << std::endl;
+    }
+
+    const std::vector<SharedFrameBuffer> frames =
+        options.replayPath.empty() ? syntheticFrames(options) : replayFrames(options.replayPath);
+    if (frames.empty()) {
+        std::cerr << "No frames to send." << std::endl;
+        return 1;
+    }
+    std::size_t frameBytes = 0;
+    for (const SharedFrameBuffer& frame : frames)
+        frameBytes += frame->size();
+    std::cout << "Sending " << frames.size() << " distinct frames, " << frameBytes / frames.size() / 1024
+              << " KiB on average." << std::endl;
+
+    std::vector<std::unique_ptr<WebSocketImageClient>> clients;
+    int connected = 0;
+    for (int i = 0; i < options.clients; ++i) {
+        std::unique_ptr<WebSocketImageClient> client(new WebSocketImageClient(
+            QString::fromStdString(options.server), static_cast<quint16>(options.port)));
+        client->setAlias(QString("load-%1").arg(i));
+        if (client->connectToServer())
+            ++connected;
+        clients.push_back(std::move(client));
+    }
+    if (connected == 0) {
+        std::cerr << "No client could connect to " << options.server << ":" << options.port << std::endl;
+        return 1;
+    }
+
+    // Clients take turns within each frame period instead of sending in one burst
+    const std::int64_t periodUs = 1000000 / options.fps;
+    const std::int64_t startUs = nowUs();
+    std::vector<std::int64_t> dueUs(clients.size());
+    std::vector<std::size_t> nextFrame(clients.size());
+    for (std::size_t i = 0; i < clients.size(); ++i) {
+        dueUs[i] = startUs + periodUs * static_cast<std::int64_t>(i) / static_cast<std::int64_t>(clients.size());
+        nextFrame[i] = i % frames.size();
+    }
+
+    Counters total;
+    Counters second;
+    std::int64_t secondStartUs = startUs;
+    const std::int64_t endUs = startUs + static_cast<std::int64_t>(options.durationSec) * 1000000;
+    for (std::int64_t now = nowUs(); now < endUs; now = nowUs()) {
+        std::int64_t nextDueUs = endUs;
+        for (std::size_t i = 0; i < clients.size(); ++i) {
+            if (dueUs[i] <= now) {
+                const SendResult sent = clients[i]->sendFrame(frames[nextFrame[i]]);
+                nextFrame[i] = (nextFrame[i] + 1) % frames.size();
+                if (sent.accepted()) {
+                    ++second.sent;
+                } else if (sent.paused()) {
+                    ++second.paused;
+                } else if (sent.connected()) {
+                    ++second.dropped;
+                }
+                second.dropped += sent.evicted;
+                dueUs[i] += periodUs;
+                // Behind by more than a period: skip the missed slots rather than bursting
+                if (dueUs[i] + periodUs <= now) {
+                    const std::int64_t missed = (now - dueUs[i]) / periodUs;
+                    second.late += static_cast<std::uint64_t>(missed);
+                    dueUs[i] += missed * periodUs;
+                }
+            }
+            nextDueUs = std::min(nextDueUs, dueUs[i]);
+        }
+
+        if (now - secondStartUs >= 1000000) {
+            int live = 0;
+            for (const std::unique_ptr<WebSocketImageClient>& client : clients)
+                live += client->sendQueueState().connected() ? 1 : 0;
+            printLine("load", options, live, second, (now - secondStartUs) / 1e6);
+            total.sent += second.sent;
+            total.dropped += second.dropped;
+            total.paused += second.paused;
+            total.late += second.late;
+            second = Counters();
+            secondStartUs = now;
+        }
+
+        const std::int64_t waitUs = nextDueUs - nowUs();
+        if (waitUs > 0)
+            std::this_thread::sleep_for(std::chrono::microseconds(waitUs));
+    }
+    total.sent += second.sent;
+    total.dropped += second.dropped;
+    total.paused += second.paused;
+    total.late += second.late;
+    printLine("summary", options, connected, total, (nowUs() - startUs) / 1e6);
+
+    for (const std::unique_ptr<WebSocketImageClient>& client : clients)
+        client->disconnectFromServer();
+    return 0;
+}
@@ -3,9 +3,13 @@
 #include <QObject>
 #include <QDateTime>
 #include <QHash>
+#include <QSet>
 #include <QTimer>
 #include <QMutex>
+#include <atomic>
+#include <vector>
 #include "diagnosticsmodel.h"
+#include "mpscqueue.h"
 
 class DiagnosticsManager : public QObject {
     Q_OBJECT
@@ -42,6 +46,7 @@ public slots:
     void setAggregationWindowMs(int ms);
     void setRateLimitUniquePerMinute(int count);
     void setVerbose(bool v);
+    // Writes the frame trace (Chrome trace JSON) when tracing is on
     void dumpLogs(const QString &path);
     Q_INVOKABLE void clear();
 
@@ -60,8 +65,18 @@ signals:
 private:
     QString makeSignature(int code, const QString &message, const QString &source) const;
 
+    // Events posted from other threads wait in m_ingest (lock-free) and are
+    // aggregated in batches on this object's thread
+    void enqueue(DiagnosticEntry entry);
+    void drainIngest();
+    void processBatch(const std::vector<DiagnosticEntry> &batch);
+    // Requires m_mutex; false when the model is left to the burst consolidation
+    bool aggregateLocked(const DiagnosticEntry &entry);
+
     DiagnosticsModel *m_model;
     QMutex m_mutex; // guards internal maps
+    MpscQueue<DiagnosticEntry> m_ingest;
+    std::atomic<bool> m_drainScheduled{false};
     struct AggState { QDateTime first; QDateTime last; int count; bool suppressed; DiagnosticEntry entry; };
     QHash<QString, AggState> m_aggregation;
 
@@ -74,6 +89,7 @@ private:
     // burst handling
     bool m_burstMode = false;
     QTimer m_burstTimer;
+    QSet<QString> m_consolidationPending; // signatures aggregated since the last consolidation
     int m_burstConsolidationMs = 5000; // 5s
 
     // UI state: whether the diagnostics panel is visible
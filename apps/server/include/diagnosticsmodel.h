@@ -2,6 +2,8 @@
 
 #include <QAbstractListModel>
 #include <QDateTime>
+#include <QHash>
+#include <QVector>
 #include <deque>
 
 struct DiagnosticEntry {
@@ -41,6 +43,9 @@ public:
 
     // update or append an entry; owns copy of entry
     void upsertEntry(const DiagnosticEntry &entry);
+    // Same for a batch: one insert for the new entries (the last on top), one
+    // removal for what falls off the end, dataChanged per run of updated rows
+    void upsertEntries(const QVector<DiagnosticEntry> &entries);
 
     // configuration
     void setMaxEntries(int maxEntries);
@@ -49,6 +54,13 @@ public:
     Q_INVOKABLE void clear();
 
 private:
+    // Rows are only added at the front and removed at the back, so an entry's
+    // row follows from its insertion serial without reindexing
+    int rowOf(quint64 serial) const { return static_cast<int>(m_nextSerial - 1 - serial); }
+    void trimTo(int maxEntries);
+
     std::deque<DiagnosticEntry> m_entries;
+    QHash<QString, quint64> m_serials; // id -> insertion serial
+    quint64 m_nextSerial = 0;
     int m_maxEntries = 500; // user agreed memory limit
 };
@@ -28,11 +28,7 @@ QImage LiveImageProvider::requestImage(const QString &id, QSize *size, const QSi
         *size = result.size();
     }
 
-    if(requestedSize.width() > 0 && requestedSize.height() > 0) {
-        result = result.scaled(requestedSize.width(), requestedSize.height(), Qt::KeepAspectRatio);
-    }
-
-    return result;
+    return scaledImage.scaled(result, requestedSize);
 }
 
 void LiveImageProvider::updateImage(const QImage &image_recv)
@@ -3,6 +3,7 @@
 
 #include <QImage>
 #include <QQuickImageProvider>
+#include "network/scaledimagecache.h"
 
 class LiveImageProvider : public QObject, public QQuickImageProvider
 {
@@ -22,6 +23,7 @@ signals:
 private:
     QImage image;
     QImage no_image;
+    ScaledImageCache scaledImage; // last scaled result, reused until the image or size changes
 };
 
 #endif // LIVEIMAGEPROVIDER_H
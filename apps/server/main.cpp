@@ -1,12 +1,32 @@
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
 #include <QGuiApplication>
 #include <QQmlApplicationEngine>
 #include <QQmlContext>
+#include <QQuickWindow>
 #include <QTimer>
 #include <qqml.h>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#ifdef Q_OS_UNIX
+#include <QSocketNotifier>
+#include <csignal>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
 
 #include "diagnosticsmanager.h"
 #include "qmlimageprovider.h"
+#include "mosaicitem.h"
+#include "videosurfaceitem.h"
 #include "imageserverbridge.h"
+#include "keepalive.h"
+#include "threadroles.h"
+#include "sharddirectory.h"
+#include "frametrace.h"
 #include "config.h"
 
 /// Server application: Qt-based image streaming server for QML.
@@ -24,13 +44,243 @@
 /// Command-line options:
 ///   --host <address>  Listening address (default: all interfaces)
 ///   --port <port>     Listening port (default: 5000)
+///   --reuse-port      Share the port with other instances (SO_REUSEPORT); the
+///                     kernel spreads the clients over them
+///   --udp-frames      Clients on lossy links (Wi-Fi) that offer it send their
+///                     frames over UDP with FEC, each to a port of its own
+///   --tls-cert <pem> --tls-key <pem>  Serve WSS (wss://) with this certificate
+///                     chain and key; with the Beast backend record encryption
+///                     moves to the kernel where it supports it (kTLS), and
+///                     reconnecting clients resume their session
+///   --thread-roles <spec>  CPUs and priority per thread role, e.g. on a 4-core Pi
+///                     "io=3/-5;decode=0-1;processing=2/5;render=3/fifo:10"
+///                     (threadroles.h; IMAGESOCKET_THREAD_ROLES does the same)
+///   --keepalive <ms>  Ping a client after <ms> without traffic and drop it after
+///                     two unanswered pings (default 2000; 0: off, TCP timeouts only)
+///   --headless        No GUI: a QCoreApplication without QML or a platform
+///                     plugin. Every client streams and frames are only decoded
+///                     for frame processors (or --mosaic); recording, processors
+///                     and stats run as usual (also one shard of a multi-process
+///                     deployment)
+///   --list-clients    Print which instance on the port holds which client, then exit
+///   --record <dir>    Record every client's stream, as received, under <dir>
+///   --preroll <s>     Keep each client's last <s> seconds in memory, compressed, for
+///                     event clips (captureEventClip() writes them as a recording)
+///   --preroll-mb <n>  Memory per client for the pre-roll (default 16)
+///   --mosaic          Every client streams at full rate and is decoded (video wall)
+///   --stats <seconds> Headless: print a load line (clients, fps, drops, latency,
+///                     CPU) every <seconds>, for capacity runs (scripts/capacity_sweep.sh)
+///   --budget-mbps <n> Ingress budget: received Mbit/s over every client, split by
+///                     priority (active > pinned > background) with SET_FPS/SET_QUALITY
+///   --budget-decode-ms <n>  Decode time per second the clients may cost (1000 = one core)
+///   --motion-fps <n>  Motion-adaptive frame rate: a client whose scene stays still
+///                     is lowered to <n> fps and raised again when it moves (0: off)
+///   --max-sessions <n>  Refuse connections beyond <n> concurrent clients
+///   --max-message-mb <n>  Close a session whose message exceeds <n> MB (default 64)
+///   --client-max-mbps <n> Per-client ingress cap: over it a client is sent SET_FPS,
+///                     and disconnected when it stays over it for 5 s
+///   --accept-rate <n> Take at most <n> new connections per second; the others are
+///                     told when to come back (RETRY_AFTER), spreading reconnect storms
+///   --accept-burst <n> Connections taken at once after a quiet spell (default: 1 s worth)
+///   --memory-mb <n>   Memory budget: what the server holds for its clients (frames
+///                     in flight, decoded images, caches); frames over it are dropped
+///                     on arrival, near it thumbnails and snapshots are evicted
+///   --client-memory-mb <n>  Received frames one client may have in flight
+///   --metrics <port>  Prometheus endpoint: GET http://<host>:<port>/metrics
+///                     (per-client frames, bytes, drops, decode times, queues, latency)
+///   --cluster-node <id>  Cluster mode: this node's id. Nodes report their load
+///                     (sessions, ingress, decode, CPU) to each other over UDP and
+///                     send a connecting camera to the least-loaded node (REDIRECT)
+///   --cluster-peers <host:port,...>  The other nodes' cluster ports
+///   --cluster-port <port>  UDP port for the reports (default: the server port)
+///   --cluster-advertise <host>  Where clients reach this node (default: the
+///                     address its reports come from)
+///   --cluster-key <n> Only nodes with the same key form a cluster (default 0)
+///   --viewer <port>   Browser monitoring: http://<host>:<port>/ shows any client's
+///                     JPEG stream as MJPEG, passed through without decoding;
+///                     /snapshot?client=<id> is its latest JPEG (ETag, 304)
+///   --startup-time    Exit once the first window frame is shown (the "startup"
+///                     line is printed on every GUI start; scripts/startup_time.sh)
+///   --trace <file>    Record the frame lifecycle (socket read, dispatch, decode,
+///                     bridge, provider request, render) and write it to <file> as a
+///                     Chrome trace on SIGUSR1 and at exit; IMAGESOCKET_TRACE=1 does
+///                     the same into imagesocket-trace-<pid>.json
 ///
+namespace {
+
+// Command-line budget limits (-1: not given, keep the saved one)
+void applyIngressBudget(ImageServerBridge& bridge, double mbps, double decodeMs)
+{
+    if (mbps < 0.0 && decodeMs < 0.0)
+        return;
+    const QVariantMap saved = bridge.ingressBudget();
+    bridge.setIngressBudget(mbps >= 0.0 ? mbps : saved.value("mbitPerSecond").toDouble(),
+                            decodeMs >= 0.0 ? decodeMs : saved.value("decodeMsPerSecond").toDouble());
+}
+
+// Command-line admission limits (-1: not given, keep the saved one)
+void applyAdmissionLimits(ImageServerBridge& bridge, int maxSessions, double maxMessageMb, double clientMaxMbps)
+{
+    if (maxSessions < 0 && maxMessageMb < 0.0 && clientMaxMbps < 0.0)
+        return;
+    const QVariantMap saved = bridge.admissionLimits();
+    bridge.setAdmissionLimits(maxSessions >= 0 ? maxSessions : saved.value("maxSessions").toInt(),
+                              maxMessageMb >= 0.0 ? maxMessageMb : saved.value("maxMessageMb").toDouble(),
+                              clientMaxMbps >= 0.0 ? clientMaxMbps : saved.value("clientMaxMbps").toDouble());
+}
+
+// Command-line accept pacing (-1: not given, keep the saved one)
+void applyAcceptRate(ImageServerBridge& bridge, double perSecond, int burst)
+{
+    if (perSecond < 0.0 && burst < 0)
+        return;
+    const QVariantMap saved = bridge.admissionLimits();
+    bridge.setAcceptRate(perSecond >= 0.0 ? perSecond : saved.value("acceptRate").toDouble(),
+                         burst >= 0 ? burst : saved.value("acceptBurst").toInt());
+}
+
+// Command-line pre-roll (-1: not given, keep the saved one)
+void applyPreroll(ImageServerBridge& bridge, int seconds, double mbPerClient)
+{
+    if (seconds < 0 && mbPerClient < 0.0)
+        return;
+    const QVariantMap saved = bridge.prerollStats();
+    const int savedSeconds = saved.value("running").toBool() ? saved.value("windowMs").toInt() / 1000 : 0;
+    bridge.setPreroll(seconds >= 0 ? seconds : savedSeconds,
+                      mbPerClient > 0.0 ? mbPerClient : saved.value("bytesPerClient").toDouble() / (1024 * 1024));
+}
+
+// Command-line memory budget (-1: not given, keep the saved one)
+void applyMemoryBudget(ImageServerBridge& bridge, double totalMb, double perClientMb)
+{
+    if (totalMb < 0.0 && perClientMb < 0.0)
+        return;
+    const QVariantMap saved = bridge.memoryUsage();
+    bridge.setMemoryBudget(totalMb >= 0.0 ? totalMb : saved.value("totalMb").toDouble(),
+                           perClientMb >= 0.0 ? perClientMb : saved.value("perClientMb").toDouble());
+}
+
+// Command-line cluster mode; nothing without a node id
+bool applyCluster(ImageServerBridge& bridge, const QString& nodeId, int clusterPort, const QString& peers,
+                  const QString& advertiseHost, quint32 key, quint16 serverPort)
+{
+    if (nodeId.isEmpty())
+        return true;
+    const quint16 udpPort = static_cast<quint16>(clusterPort >= 0 ? clusterPort : serverPort);
+    QStringList peerList = peers.split(QLatin1Char(','));
+    peerList.removeAll(QString());
+    return bridge.startCluster(nodeId, udpPort, peerList, advertiseHost, key);
+}
+
+// IMAGESOCKET_THREAD_ROLES, then --thread-roles over it; a malformed spec pins nothing
+void configureThreadRoles(const QString& spec)
+{
+    std::string error;
+    if (!ThreadRoles::configureFromEnvironment(&error))
+        qWarning() << "IMAGESOCKET_THREAD_ROLES ignored:" << QString::fromStdString(error);
+    if (spec.isEmpty())
+        return;
+    ThreadRoleConfig config;
+    if (ThreadRoles::parse(spec.toStdString(), config, &error))
+        ThreadRoles::configure(config);
+    else
+        qWarning() << "--thread-roles ignored:" << QString::fromStdString(error);
+}
+
+bool writeTrace(const QString& path)
+{
+    const bool ok = FrameTrace::writeChromeJson(QFile::encodeName(path).toStdString(),
+                                                static_cast<int>(QCoreApplication::applicationPid()), "server");
+    if (ok)
+        qInfo() << "Frame trace written to" << path;
+    else
+        qWarning() << "Could not write the frame trace to" << path;
+    return ok;
+}
+
+#ifdef Q_OS_UNIX
+int traceSignalFds[2] = {-1, -1};
+
+void onTraceSignal(int)
+{
+    // Only async-signal-safe work here: the dump itself runs on the event loop
+    const char byte = 1;
+    if (::write(traceSignalFds[0], &byte, 1) < 0) {
+        // Full socket: a dump is already pending
+    }
+}
+
+// SIGUSR1 writes the trace to `path` without stopping the server
+void dumpTraceOnSignal(const QString& path, QObject* context)
+{
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, traceSignalFds) != 0)
+        return;
+    QSocketNotifier* notifier = new QSocketNotifier(traceSignalFds[1], QSocketNotifier::Read, context);
+    QObject::connect(notifier, &QSocketNotifier::activated, context, [path]() {
+        char byte = 0;
+        if (::read(traceSignalFds[1], &byte, 1) > 0)
+            writeTrace(path);
+    });
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = onTraceSignal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    ::sigaction(SIGUSR1, &action, nullptr);
+}
+#endif
+
+} // namespace
+
 int main(int argc, char *argv[])
 {
-    QGuiApplication app(argc, argv);
+    QElapsedTimer startup;
+    startup.start();
+
+    // Headless instances never load the GUI stack (no display, GPU or QML
+    // engine needed); decided before the application exists
+    bool headless = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--headless") == 0)
+            headless = true;
+    }
+
+    std::unique_ptr<QCoreApplication> app(headless ? new QCoreApplication(argc, argv)
+                                                   : new QGuiApplication(argc, argv));
 
     // Parse optional command-line arguments for server configuration.
     quint16 port = kDefaultServerPort;
+    bool reusePort = false;
+    bool udpFrames = false;
+    QString tlsCert;
+    QString tlsKey;
+    int keepaliveMs = -1;
+    QString threadRoles;
+    bool listClients = false;
+    QString recordDirectory;
+    int prerollSeconds = -1;
+    double prerollMb = -1.0;
+    int statsIntervalSec = 0;
+    bool mosaic = false;
+    bool exitAfterStartup = false;
+    int metricsPort = -1;
+    int viewerPort = -1;
+    QString tracePath;
+    double budgetMbps = -1.0;
+    double budgetDecodeMs = -1.0;
+    int motionIdleFps = -1;
+    int maxSessions = -1;
+    double maxMessageMb = -1.0;
+    double clientMaxMbps = -1.0;
+    double acceptRate = -1.0;
+    int acceptBurst = -1;
+    double memoryMb = -1.0;
+    double clientMemoryMb = -1.0;
+    QString clusterNode;
+    QString clusterPeers;
+    QString clusterAdvertise;
+    int clusterPort = -1;
+    quint32 clusterKey = 0;
 
     for (int i = 1; i < argc; ++i) {
         QString arg = QString::fromLocal8Bit(argv[i]);
@@ -38,7 +288,148 @@ int main(int argc, char *argv[])
             bool ok = false;
             quint16 parsed = QString::fromLocal8Bit(argv[++i]).toUShort(&ok);
             if (ok) port = parsed;
+        } else if (arg == "--reuse-port") {
+            reusePort = true;
+        } else if (arg == "--udp-frames") {
+            udpFrames = true;
+        } else if (arg == "--tls-cert" && i + 1 < argc) {
+            tlsCert = QString::fromLocal8Bit(argv[++i]);
+        } else if (arg == "--tls-key" && i + 1 < argc) {
+            tlsKey = QString::fromLocal8Bit(argv[++i]);
+        } else if (arg == "--thread-roles" && i + 1 < argc) {
+            threadRoles = QString::fromLocal8Bit(argv[++i]);
+        } else if (arg == "--keepalive" && i + 1 < argc) {
+            keepaliveMs = qMax(0, QString::fromLocal8Bit(argv[++i]).toInt());
+        } else if (arg == "--list-clients") {
+            listClients = true;
+        } else if (arg == "--record" && i + 1 < argc) {
+            recordDirectory = QString::fromLocal8Bit(argv[++i]);
+        } else if (arg == "--preroll" && i + 1 < argc) {
+            prerollSeconds = QString::fromLocal8Bit(argv[++i]).toInt();
+        } else if (arg == "--preroll-mb" && i + 1 < argc) {
+            prerollMb = QString::fromLocal8Bit(argv[++i]).toDouble();
+        } else if (arg == "--mosaic") {
+            mosaic = true;
+        } else if (arg == "--stats" && i + 1 < argc) {
+            statsIntervalSec = QString::fromLocal8Bit(argv[++i]).toInt();
+        } else if (arg == "--metrics" && i + 1 < argc) {
+            metricsPort = QString::fromLocal8Bit(argv[++i]).toInt();
+        } else if (arg == "--viewer" && i + 1 < argc) {
+            viewerPort = QString::fromLocal8Bit(argv[++i]).toInt();
+        } else if (arg == "--startup-time") {
+            exitAfterStartup = true;
+        } else if (arg == "--trace" && i + 1 < argc) {
+            tracePath = QString::fromLocal8Bit(argv[++i]);
+        } else if (arg == "--budget-mbps" && i + 1 < argc) {
+            budgetMbps = QString::fromLocal8Bit(argv[++i]).toDouble();
+        } else if (arg == "--budget-decode-ms" && i + 1 < argc) {
+            budgetDecodeMs = QString::fromLocal8Bit(argv[++i]).toDouble();
+        } else if (arg == "--motion-fps" && i + 1 < argc) {
+            motionIdleFps = QString::fromLocal8Bit(argv[++i]).toInt();
+        } else if (arg == "--max-sessions" && i + 1 < argc) {
+            maxSessions = QString::fromLocal8Bit(argv[++i]).toInt();
+        } else if (arg == "--max-message-mb" && i + 1 < argc) {
+            maxMessageMb = QString::fromLocal8Bit(argv[++i]).toDouble();
+        } else if (arg == "--client-max-mbps" && i + 1 < argc) {
+            clientMaxMbps = QString::fromLocal8Bit(argv[++i]).toDouble();
+        } else if (arg == "--accept-rate" && i + 1 < argc) {
+            acceptRate = QString::fromLocal8Bit(argv[++i]).toDouble();
+        } else if (arg == "--accept-burst" && i + 1 < argc) {
+            acceptBurst = QString::fromLocal8Bit(argv[++i]).toInt();
+        } else if (arg == "--memory-mb" && i + 1 < argc) {
+            memoryMb = QString::fromLocal8Bit(argv[++i]).toDouble();
+        } else if (arg == "--client-memory-mb" && i + 1 < argc) {
+            clientMemoryMb = QString::fromLocal8Bit(argv[++i]).toDouble();
+        } else if (arg == "--cluster-node" && i + 1 < argc) {
+            clusterNode = QString::fromLocal8Bit(argv[++i]);
+        } else if (arg == "--cluster-peers" && i + 1 < argc) {
+            clusterPeers = QString::fromLocal8Bit(argv[++i]);
+        } else if (arg == "--cluster-port" && i + 1 < argc) {
+            clusterPort = QString::fromLocal8Bit(argv[++i]).toInt();
+        } else if (arg == "--cluster-advertise" && i + 1 < argc) {
+            clusterAdvertise = QString::fromLocal8Bit(argv[++i]);
+        } else if (arg == "--cluster-key" && i + 1 < argc) {
+            clusterKey = QString::fromLocal8Bit(argv[++i]).toUInt();
+        }
+    }
+
+    if (listClients) {
+        const QList<ShardDirectory::Entry> entries = ShardDirectory::entriesOn(port);
+        for (const ShardDirectory::Entry& entry : entries) {
+            std::printf("%lld\t%s\t%s\t%s\n", static_cast<long long>(entry.pid), qPrintable(entry.clientId),
+                        qPrintable(entry.alias), qPrintable(entry.address));
+        }
+        return 0;
+    }
+
+    if (!tracePath.isEmpty())
+        FrameTrace::setEnabled(true);
+    const bool tracing = FrameTrace::enableFromEnvironment();
+    if (tracing) {
+        if (tracePath.isEmpty())
+            tracePath = QString("imagesocket-trace-%1.json").arg(QCoreApplication::applicationPid());
+        FrameTrace::setThreadName("main");
+#ifdef Q_OS_UNIX
+        dumpTraceOnSignal(tracePath, app.get());
+#endif
+    }
+    // Before the first I/O, decode or render thread starts
+    configureThreadRoles(threadRoles);
+
+    if (headless) {
+        ImageServerBridge bridge;
+        bridge.setDisplayEnabled(false);
+        bridge.setPort(port);
+        bridge.setReusePort(reusePort);
+        if (udpFrames)
+            bridge.setUdpFrames(true);
+        if (!tlsCert.isEmpty())
+            bridge.setTls(tlsCert, tlsKey);
+        if (keepaliveMs >= 0)
+            bridge.setKeepalive(keepaliveMs, KeepaliveConfig().maxMissed);
+        applyIngressBudget(bridge, budgetMbps, budgetDecodeMs);
+        if (motionIdleFps >= 0)
+            bridge.setMotionAdaptiveFps(motionIdleFps);
+        applyAdmissionLimits(bridge, maxSessions, maxMessageMb, clientMaxMbps);
+        applyAcceptRate(bridge, acceptRate, acceptBurst);
+        applyMemoryBudget(bridge, memoryMb, clientMemoryMb);
+        if (mosaic)
+            bridge.setMosaicMode(true);
+        if (!bridge.start())
+            return 1;
+        if (!recordDirectory.isEmpty() && !bridge.startRecording(recordDirectory))
+            return 1;
+        applyPreroll(bridge, prerollSeconds, prerollMb);
+        if (metricsPort >= 0 && !bridge.startMetrics(static_cast<quint16>(metricsPort)))
+            return 1;
+        if (viewerPort >= 0 && !bridge.startBrowserViewer(static_cast<quint16>(viewerPort)))
+            return 1;
+        if (!applyCluster(bridge, clusterNode, clusterPort, clusterPeers, clusterAdvertise, clusterKey,
+                          bridge.serverPort()))
+            return 1;
+        QTimer statsTimer;
+        if (statsIntervalSec > 0) {
+            bridge.serverStats(); // starts the CPU interval
+            QObject::connect(&statsTimer, &QTimer::timeout, &bridge, [&bridge]() {
+                const QVariantMap stats = bridge.serverStats();
+                const QVariantMap memory = bridge.memoryUsage();
+                std::printf("stats clients=%d fps=%.1f dropped=%llu network_p50_ms=%.1f network_p99_ms=%.1f "
+                            "decode_p50_ms=%.1f decode_p99_ms=%.1f cpu_percent=%.1f memory_mb=%.1f "
+                            "memory_refused=%llu\n",
+                            stats.value("clients").toInt(), stats.value("fps").toDouble(),
+                            stats.value("dropped").toULongLong(), stats.value("networkP50Ms").toDouble(),
+                            stats.value("networkP99Ms").toDouble(), stats.value("decodeP50Ms").toDouble(),
+                            stats.value("decodeP99Ms").toDouble(), stats.value("cpuPercent").toDouble(),
+                            memory.value("receivedMb").toDouble() + memory.value("decodedMb").toDouble(),
+                            memory.value("refused").toULongLong());
+                std::fflush(stdout);
+            });
+            statsTimer.start(statsIntervalSec * 1000);
         }
+        const int code = app->exec();
+        if (tracing)
+            writeTrace(tracePath);
+        return code;
     }
 
     // Create the QML application engine (manages the event loop and QML context).
@@ -54,9 +445,37 @@ int main(int argc, char *argv[])
 
     // Make enums available via ImageServerBridge.<Enum> in QML
     qmlRegisterUncreatableType<ImageServerBridge>("ImageServerBridge", 1, 0, "ImageServerBridge", "Enums only");
+    // GPU-composited multi-client video wall
+    qmlRegisterType<MosaicItem>("ImageSocketViews", 1, 0, "MosaicView");
+    // Active client video, uploaded straight to a texture (no image provider round trip)
+    qmlRegisterType<VideoSurfaceItem>("ImageSocketViews", 1, 0, "VideoSurface");
 
     // Set the initial host and port from command-line arguments.
     imageBridge->setPort(port);
+    if (reusePort)
+        imageBridge->setReusePort(true);
+    if (udpFrames)
+        imageBridge->setUdpFrames(true);
+    if (!tlsCert.isEmpty())
+        imageBridge->setTls(tlsCert, tlsKey);
+    if (keepaliveMs >= 0)
+        imageBridge->setKeepalive(keepaliveMs, KeepaliveConfig().maxMissed);
+    applyIngressBudget(*imageBridge, budgetMbps, budgetDecodeMs);
+    if (motionIdleFps >= 0)
+        imageBridge->setMotionAdaptiveFps(motionIdleFps);
+    applyAdmissionLimits(*imageBridge, maxSessions, maxMessageMb, clientMaxMbps);
+    applyAcceptRate(*imageBridge, acceptRate, acceptBurst);
+    applyMemoryBudget(*imageBridge, memoryMb, clientMemoryMb);
+    if (!recordDirectory.isEmpty())
+        imageBridge->startRecording(recordDirectory);
+    applyPreroll(*imageBridge, prerollSeconds, prerollMb);
+    if (metricsPort >= 0)
+        imageBridge->startMetrics(static_cast<quint16>(metricsPort));
+    if (viewerPort >= 0)
+        imageBridge->startBrowserViewer(static_cast<quint16>(viewerPort));
+    applyCluster(*imageBridge, clusterNode, clusterPort, clusterPeers, clusterAdvertise, clusterKey, port);
+    if (mosaic)
+        imageBridge->setMosaicMode(true);
 
     // Create DiagnosticsManager and expose to QML
     DiagnosticsManager *diagnostics = new DiagnosticsManager(&engine);
@@ -67,6 +486,8 @@ int main(int argc, char *argv[])
 
     // Register an image provider that reads frames from the bridge.
     engine.addImageProvider("live", new QmlImageProvider(imageBridge));
+    // Per-client thumbnails for the preview grid
+    engine.addImageProvider("thumbnails", new ThumbnailImageProvider(imageBridge));
 
     // Forward ImageServerBridge events to DiagnosticsManager so logs are captured centrally
     QObject::connect(imageBridge, &ImageServerBridge::eventOccurred, diagnostics,
@@ -93,7 +514,7 @@ int main(int argc, char *argv[])
     // Connect the objectCreated signal to detect QML loading errors.
     // If the QML file fails to load, objectCreated will be called with nullptr.
     QObject::connect(&engine, &QQmlApplicationEngine::objectCreated,
-                         &app, [url](QObject *obj, const QUrl &objUrl) {
+                         app.get(), [url](QObject *obj, const QUrl &objUrl) {
             if (!obj && url == objUrl)
                 QCoreApplication::exit(-1);
         }, Qt::QueuedConnection);
@@ -106,7 +527,29 @@ int main(int argc, char *argv[])
     if (engine.rootObjects().isEmpty()) {
         return -1;
     }
+    const qint64 qmlLoadedMs = startup.elapsed();
+
+    // Time to first window: main() entry to the first frame on screen (the
+    // QML part is the load above; the rest is scene graph and GPU setup)
+    if (QQuickWindow *window = qobject_cast<QQuickWindow *>(engine.rootObjects().first())) {
+        // Emitted on the render thread (the GUI thread with the basic render loop)
+        QObject::connect(window, &QQuickWindow::sceneGraphInitialized, window,
+                         []() { ThreadRoles::apply(ThreadRole::Render); }, Qt::DirectConnection);
+        auto firstFrame = std::make_shared<QMetaObject::Connection>();
+        *firstFrame = QObject::connect(window, &QQuickWindow::frameSwapped, app.get(),
+                                       [firstFrame, &startup, qmlLoadedMs, exitAfterStartup]() {
+            QObject::disconnect(*firstFrame);
+            std::printf("startup qml_ms=%lld first_frame_ms=%lld\n", static_cast<long long>(qmlLoadedMs),
+                        static_cast<long long>(startup.elapsed()));
+            std::fflush(stdout);
+            if (exitAfterStartup)
+                QCoreApplication::quit();
+        }, Qt::QueuedConnection);
+    }
 
     // Start the Qt event loop. This blocks until QCoreApplication::quit() is called.
-    return app.exec();
+    const int code = app->exec();
+    if (tracing)
+        writeTrace(tracePath);
+    return code;
 }
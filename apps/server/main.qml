@@ -18,6 +18,11 @@ import ImageServerBridge 1.0
 ///
 /// Layout: Responsive ColumnLayout with no fixed size; window is resizable.
 ///
+/// Startup: only what the first frame shows is created with the window. The
+/// diagnostics and clients panels (and the preview grid inside the latter) are
+/// Loaders, created when first opened and released when closed; their state
+/// lives in the C++ models.
+///
 ApplicationWindow {
     id: appWindow
     visible: true
@@ -128,27 +133,33 @@ ApplicationWindow {
             }
         }
 
-        /// Diagnostics panel (hidden by default)
-        DiagnosticsPanel {
+        /// Diagnostics panel (hidden by default, created on demand)
+        Loader {
             id: diagnosticsPanel
-            themeMode: mainTheme.themeMode
-            visible: diagnostics.panelVisible
+            active: diagnostics.panelVisible
+            visible: active
             Layout.fillWidth: true
             Layout.preferredHeight: mainTheme.controlPanelHeight * 3
-            onVisibleChanged: {
-                if (visible) clients.panelVisible = false
+            sourceComponent: DiagnosticsPanel {
+                themeMode: mainTheme.themeMode
+            }
+            onActiveChanged: {
+                if (active) clients.panelVisible = false
             }
         }
 
-        /// Clients panel (hidden by default)
-        ClientsPanel {
+        /// Clients panel (hidden by default, created on demand)
+        Loader {
             id: clientsPanel
-            themeMode: mainTheme.themeMode
-            visible: clients.panelVisible
+            active: clients.panelVisible
+            visible: active
             Layout.fillWidth: true
             Layout.preferredHeight: mainTheme.controlPanelHeight * 3
-            onVisibleChanged: {
-                if (visible) diagnostics.panelVisible = false
+            sourceComponent: ClientsPanel {
+                themeMode: mainTheme.themeMode
+            }
+            onActiveChanged: {
+                if (active) diagnostics.panelVisible = false
             }
         }
     }
@@ -32,6 +32,16 @@ Rectangle {
             }
             Item { Layout.fillWidth: true }
 
+            // Dual-rate mode: other clients stream thumbnails into a live grid
+            StyledButton {
+                text: imageSocket.thumbnailMode ? "☰" : "▦"
+                implicitWidth: activeTheme.buttonHeight
+                onClicked: imageSocket.setThumbnailMode(!imageSocket.thumbnailMode)
+                theme: activeTheme
+                ToolTip.visible: hovered
+                ToolTip.text: imageSocket.thumbnailMode ? "Show client list" : "Show live preview grid"
+            }
+
             StyledButton {
                 text: "✖"
                 implicitWidth: activeTheme.buttonHeight
@@ -40,16 +50,24 @@ Rectangle {
             }
         }
 
+        PreviewGrid {
+            Layout.fillWidth: true
+            Layout.fillHeight: true
+            visible: imageSocket.thumbnailMode
+            theme: activeTheme
+        }
+
         ListView {
             id: listView
             Layout.fillWidth: true
             Layout.fillHeight: true
+            visible: !imageSocket.thumbnailMode
             clip: true
             z: 1
             model: imageSocket.clientModel
             delegate: Rectangle {
                 width: listView.width
-                height: 52
+                height: 64
                 color: clientId === imageSocket.activeClient ? activeTheme.panelAccentColor : (index % 2 === 0 ? "transparent" : "#11111122")
                 border.color: clientId === imageSocket.activeClient ? activeTheme.panelAccentColor : "transparent"
                 border.width: clientId === imageSocket.activeClient ? 1 : 0
@@ -69,11 +87,23 @@ Rectangle {
                             elide: Text.ElideRight
                         }
                         Text {
-                            text: status + " • " + clientId;
+                            text: status + " • " + codec + " • " + clientId;
                             font.pixelSize: 12;
                             color: clientId === imageSocket.activeClient ? activeTheme.textOnAccentColorSecondary : activeTheme.textMutedColor
                             elide: Text.ElideRight
                         }
+                        // Link and CPU use: traffic, frame size, decode time, arrival jitter, client queue
+                        Text {
+                            visible: bytesPerSecond > 0
+                            text: (bytesPerSecond / 1048576).toFixed(2) + " MB/s • "
+                                  + Math.round(avgFrameBytes / 1024) + " KB/frame"
+                                  + (decodeMs >= 0 ? (" • decode " + decodeMs.toFixed(1) + " ms") : "")
+                                  + (jitterMs >= 0 ? (" • jitter " + jitterMs.toFixed(1) + " ms") : "")
+                                  + (queueDepth >= 0 ? (" • queue " + queueDepth) : "")
+                            font.pixelSize: 11
+                            color: clientId === imageSocket.activeClient ? activeTheme.textOnAccentColorSecondary : activeTheme.textMutedColor
+                            elide: Text.ElideRight
+                        }
                     }
 
                     // Right: FPS info (measured and configured)
@@ -89,6 +119,16 @@ Rectangle {
                         }
                         Text {
                             text: (configuredFps > 0 ? ("set " + configuredFps + " FPS") : "")
+                                  + (droppedFrames > 0 ? ((configuredFps > 0 ? " • " : "") + droppedFrames + " dropped") : "")
+                            font.pixelSize: 11
+                            color: clientId === imageSocket.activeClient ? activeTheme.textOnAccentColorSecondary : activeTheme.textMutedColor
+                            horizontalAlignment: Text.AlignRight
+                            elide: Text.ElideRight
+                        }
+                        Text {
+                            visible: throughputKbps > 0
+                            text: "Q" + quality + " • " + throughputKbps + " kbps"
+                                  + (queueDelayMs >= 0 ? (" • +" + queueDelayMs + " ms") : "")
                             font.pixelSize: 11
                             color: clientId === imageSocket.activeClient ? activeTheme.textOnAccentColorSecondary : activeTheme.textMutedColor
                             horizontalAlignment: Text.AlignRight
@@ -113,6 +113,36 @@ Rectangle {
             }
         }
 
+        // Video wall: show every client at once (GPU mosaic)
+        StyledButton {
+            id: mosaicBtn
+            theme: activeTheme
+            text: imageSocket.mosaicMode ? "▣" : "⊞"
+            implicitWidth: activeTheme.buttonHeight
+            onClicked: imageSocket.setMosaicMode(!imageSocket.mosaicMode)
+
+            ToolTip {
+                visible: mosaicBtn.hovered
+                text: imageSocket.mosaicMode ? "Show the active client only" : "Show all clients (video wall)"
+                delay: 300
+            }
+        }
+
+        // Display-sized streams: clients send only the pixels the view shows
+        StyledButton {
+            id: fitBtn
+            theme: activeTheme
+            text: imageSocket.resolutionFollowsDisplay ? "⤡" : "⤢"
+            implicitWidth: activeTheme.buttonHeight
+            onClicked: imageSocket.setResolutionFollowsDisplay(!imageSocket.resolutionFollowsDisplay)
+
+            ToolTip {
+                visible: fitBtn.hovered
+                text: imageSocket.resolutionFollowsDisplay ? "Stream at full resolution" : "Fit streams to display (less bandwidth and decoding)"
+                delay: 300
+            }
+        }
+
         // Separator between client controls and FPS control
         Rectangle {
             width: 1
@@ -149,6 +179,38 @@ Rectangle {
                     delay: 300
                 }
             }
+
+            // Stream codec; clients without the codec keep sending MJPEG
+            ComboBox {
+                id: codecCombo
+                model: ["MJPEG", "H.264", "H.265", "Tiles"] // index == VideoCodec value
+                currentIndex: imageSocket.videoCodec
+                onActivated: imageSocket.setVideoCodec(index)
+
+                ToolTip {
+                    visible: codecCombo.hovered
+                    text: imageSocket.videoCodecSupported(codecCombo.currentIndex)
+                          ? "Codec requested from clients that support it"
+                          : "No decoder for this codec on the server: clients stay on MJPEG"
+                    delay: 300
+                }
+            }
+
+            // Display pacing of the active client (jitter buffer)
+            ComboBox {
+                id: pacingCombo
+                model: ["Live", "Low latency", "Smooth"] // index == JitterMode value
+                currentIndex: imageSocket.jitterMode
+                onActivated: imageSocket.setJitterMode(index)
+
+                ToolTip {
+                    visible: pacingCombo.hovered
+                    text: pacingCombo.currentIndex === 0
+                          ? "Show each frame as soon as it is decoded"
+                          : "Show frames at their capture pace, a little later, to even out network jitter"
+                    delay: 300
+                }
+            }
         }
         
         // Separator between FPS control and Diagnostics
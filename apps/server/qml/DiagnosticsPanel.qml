@@ -5,7 +5,7 @@ import QtQuick.Layouts 1.15
 Rectangle {
     id: panel
     width: 420
-    height: 320
+    height: 580
     color: activeTheme.panelBackgroundColor
     visible: diagnostics ? diagnostics.panelVisible : false // hidden by default
 
@@ -57,6 +57,127 @@ Rectangle {
             }
         }
 
+        // Latency of the active client per pipeline stage (p50 / p99, fading ~5 s window)
+        ColumnLayout {
+            Layout.fillWidth: true
+            spacing: 2
+            visible: imageSocket.activeClient !== ""
+
+            RowLayout {
+                Layout.fillWidth: true
+                Label { text: "Latency"; font.bold: true; color: activeTheme.textColor; Layout.fillWidth: true }
+                Label { text: "p50"; color: activeTheme.textMutedColor; horizontalAlignment: Text.AlignRight; Layout.preferredWidth: 72 }
+                Label { text: "p99"; color: activeTheme.textMutedColor; horizontalAlignment: Text.AlignRight; Layout.preferredWidth: 72 }
+            }
+
+            Repeater {
+                model: [
+                    { key: "captureToSend", label: "Capture → send" },
+                    { key: "network", label: "Network" },
+                    { key: "decode", label: "Decode" },
+                    { key: "display", label: "Display" },
+                    { key: "endToEnd", label: "End to end" }
+                ]
+                delegate: RowLayout {
+                    property var stats: imageSocket.activeClientLatency[modelData.key]
+                    Layout.fillWidth: true
+                    Label { text: modelData.label; color: activeTheme.textColor; Layout.fillWidth: true }
+                    Label {
+                        text: stats ? stats.p50 + " ms" : "--"
+                        color: activeTheme.textColor
+                        horizontalAlignment: Text.AlignRight
+                        Layout.preferredWidth: 72
+                    }
+                    Label {
+                        text: stats ? stats.p99 + " ms" : "--"
+                        color: activeTheme.textColor
+                        horizontalAlignment: Text.AlignRight
+                        Layout.preferredWidth: 72
+                    }
+                }
+            }
+        }
+
+        // Trend of the active client (ClientModel history): fps and end-to-end latency
+        ColumnLayout {
+            id: trend
+            Layout.fillWidth: true
+            spacing: 2
+            visible: imageSocket.activeClient !== ""
+
+            property int resolutionSeconds: 1
+            property var history: ({})
+
+            function refresh() {
+                if (!panel.visible || !visible)
+                    return
+                var model = imageSocket.clientModel
+                history = model.historyAt(model.indexOfClient(imageSocket.activeClient), resolutionSeconds, 120)
+                chart.requestPaint()
+            }
+
+            RowLayout {
+                Layout.fillWidth: true
+                Label { text: "Trend"; font.bold: true; color: activeTheme.textColor; Layout.fillWidth: true }
+                Label { text: "fps"; color: activeTheme.successColor }
+                Label { text: "latency"; color: activeTheme.warningColor }
+                Repeater {
+                    model: [ { seconds: 1, label: "2 min" }, { seconds: 10, label: "20 min" }, { seconds: 60, label: "2 h" } ]
+                    delegate: StyledButton {
+                        text: modelData.label
+                        theme: activeTheme
+                        implicitWidth: activeTheme.buttonHeight * 1.6
+                        enabled: trend.resolutionSeconds !== modelData.seconds // the one shown
+                        onClicked: { trend.resolutionSeconds = modelData.seconds; trend.refresh() }
+                    }
+                }
+            }
+
+            Canvas {
+                id: chart
+                Layout.fillWidth: true
+                Layout.preferredHeight: 100
+
+                // One line per series, each scaled to its own maximum
+                function drawSeries(ctx, values, color) {
+                    if (!values || values.length < 2)
+                        return
+                    var max = 0
+                    for (var i = 0; i < values.length; ++i)
+                        max = Math.max(max, values[i])
+                    if (max <= 0)
+                        return
+                    ctx.strokeStyle = color
+                    ctx.lineWidth = 1.5
+                    ctx.beginPath()
+                    var started = false
+                    for (var j = 0; j < values.length; ++j) {
+                        if (values[j] < 0) { started = false; continue }   // unmeasured
+                        var x = width * j / (values.length - 1)
+                        var y = height - 2 - (height - 4) * values[j] / max
+                        if (started) ctx.lineTo(x, y); else ctx.moveTo(x, y)
+                        started = true
+                    }
+                    ctx.stroke()
+                }
+
+                onPaint: {
+                    var ctx = getContext("2d")
+                    ctx.reset()
+                    ctx.strokeStyle = activeTheme.textMutedColor
+                    ctx.lineWidth = 1
+                    ctx.strokeRect(0, 0, width, height)
+                    drawSeries(ctx, trend.history.fps, activeTheme.successColor)
+                    drawSeries(ctx, trend.history.latencyMs, activeTheme.warningColor)
+                }
+            }
+
+            Connections {
+                target: imageSocket.clientModel
+                function onHistoryUpdated() { trend.refresh() }
+            }
+        }
+
         ListView {
             id: listView
             Layout.fillWidth: true
@@ -18,6 +18,9 @@ QtObject {
         2001: "Cliente desconectado: {alias}",
         2002: "Exibindo: {alias}",
         2003: "Nenhum cliente disponível",
+        2004: "Conexão recusada ({address}): {reason}",
+        2005: "Cliente limitado a {fps} FPS: {alias}",
+        2006: "Cliente desconectado por excesso de tráfego: {clientId}",
 
         // FPS
         3000: "FPS configurado: {fps}",
@@ -26,7 +29,7 @@ QtObject {
 
         // Frames
         4000: "Frame recebido",
-        4001: "Frame perdido",
+        4001: "Frames descartados ({dropped}): {alias}",
 
         // Genérico
         9999: "Erro desconhecido"
@@ -45,6 +45,26 @@ Rectangle {
             opacity: 0.5
         }
 
+        // End-to-end latency (capture to screen) of the active client
+        Label {
+            property var endToEnd: imageSocket.activeClientLatency["endToEnd"]
+            text: "⏱ " + (endToEnd ? (endToEnd.p50 + " / " + endToEnd.p99 + " ms") : "--")
+            color: "white"
+            font.pixelSize: 13
+            elide: Text.ElideRight
+
+            ToolTip.visible: latencyHover.hovered
+            ToolTip.text: "Capture-to-display latency, p50 / p99"
+            HoverHandler { id: latencyHover }
+        }
+
+        Rectangle {
+            width: 1
+            height: overlay.height - 20
+            color: "white"
+            opacity: 0.5
+        }
+
         Label {
             text: "🌐 WebSocket"
             color: "white"
@@ -0,0 +1,81 @@
+import QtQuick 2.15
+import QtQuick.Controls 2.15
+import QtQuick.Layouts 1.15
+
+/// PreviewGrid: Live mosaic of all connected clients.
+///
+/// The active client is drawn from the full-rate "live" provider; every other
+/// client shows the low-fps thumbnail it streams in thumbnail mode.
+/// Clicking a tile makes that client active.
+///
+GridView {
+    id: previewGrid
+    clip: true
+    model: imageSocket.clientModel
+
+    // Theme shared from parent, with fallback to local Theme
+    property var theme
+    Theme {
+        id: defaultTheme
+    }
+    readonly property var activeTheme: theme ? theme : defaultTheme
+
+    // 16:9 tiles, as many columns as fit
+    readonly property int tileWidth: 200
+    cellWidth: width / Math.max(1, Math.floor(width / tileWidth))
+    cellHeight: cellWidth * 9 / 16 + 20
+
+    delegate: Item {
+        width: previewGrid.cellWidth
+        height: previewGrid.cellHeight
+
+        readonly property bool isActive: clientId === imageSocket.activeClient
+
+        Rectangle {
+            anchors.fill: parent
+            anchors.margins: 3
+            color: previewGrid.activeTheme.videoBackgroundColor
+            border.color: isActive ? previewGrid.activeTheme.panelAccentColor : previewGrid.activeTheme.borderColor
+            border.width: isActive ? 2 : 1
+            radius: previewGrid.activeTheme.borderRadius
+
+            Image {
+                id: tile
+                anchors.fill: parent
+                anchors.margins: 2
+                anchors.bottomMargin: 18
+                fillMode: Image.PreserveAspectFit
+                cache: false
+                asynchronous: false
+                // The counter in the URL forces a reload for every new thumbnail / frame
+                source: isActive ? ("image://live/image?id=" + imageSocket.frameId)
+                                 : (thumbnailId > 0 ? ("image://thumbnails/" + encodeURIComponent(clientId) + "/" + thumbnailId) : "")
+            }
+
+            Text {
+                anchors.centerIn: tile
+                visible: tile.status !== Image.Ready
+                text: status
+                color: previewGrid.activeTheme.textMutedColor
+                font.pixelSize: previewGrid.activeTheme.fontSizeSmall
+            }
+
+            Text {
+                anchors.left: parent.left
+                anchors.right: parent.right
+                anchors.bottom: parent.bottom
+                anchors.margins: 3
+                text: alias
+                elide: Text.ElideRight
+                color: previewGrid.activeTheme.textColor
+                font.pixelSize: previewGrid.activeTheme.fontSizeSmall
+                font.bold: isActive
+            }
+
+            MouseArea {
+                anchors.fill: parent
+                onClicked: imageSocket.setActiveClient(clientId)
+            }
+        }
+    }
+}
@@ -1,6 +1,8 @@
 import QtQuick 2.15
 import QtQuick.Controls 2.15
+import QtQuick.Window 2.15
 import ImageServerBridge 1.0
+import ImageSocketViews 1.0
 
 /// VideoDisplayArea: Component for displaying the live video stream.
 ///
@@ -96,38 +98,60 @@ Rectangle {
         z: 2
     }
     
-    /// Live image display.
-    Image {
-        id: img
-        asynchronous: false
-        source: "image://live/image"
+    /// Live video: frames go from the bridge to a texture on the render thread.
+    VideoSurface {
+        id: surface
         anchors.fill: parent
-        fillMode: Image.PreserveAspectFit
-        cache: false
-        visible: videoArea.hasImage
+        bridge: imageSocket
+        visible: videoArea.hasImage && !imageSocket.mosaicMode
         z: 1
     }
-    
-    /// Update metrics when a new frame is available from the backend bridge.
-    Connections {
-        target: imageSocket
-        function onFrameIdChanged(newId) {
-            // Force image provider to reload by changing the id query parameter
-            img.source = "image://live/image?id=" + newId
-            videoArea.hasImage = true
 
-            if (statusBar !== undefined && statusBar !== null) {
-                statusBar.frameCount++
-                statusBar.lastUpdateTime = new Date()
-            }
+    /// Size of the view in device pixels: display-sized streams are bounded to it.
+    function reportViewport() {
+        var ratio = Screen.devicePixelRatio > 0 ? Screen.devicePixelRatio : 1
+        imageSocket.setDisplayViewport(Math.round(width * ratio), Math.round(height * ratio))
+    }
+    onWidthChanged: reportViewport()
+    onHeightChanged: reportViewport()
+    Component.onCompleted: reportViewport()
+
+    /// Zoom: the wheel narrows the active client's region of interest around the
+    /// pointer (the client crops before encoding), a double click shows all of it.
+    MouseArea {
+        anchors.fill: surface
+        enabled: surface.visible && imageSocket.activeClient !== ""
+        acceptedButtons: Qt.LeftButton
+        z: 1
+
+        onWheel: {
+            var region = imageSocket.clientRegion(imageSocket.activeClient)
+            var factor = wheel.angleDelta.y > 0 ? 0.8 : 1.25
+            var w = Math.min(1, Math.max(0.05, region.width * factor))
+            var h = Math.min(1, Math.max(0.05, region.height * factor))
+            // Keep the point under the pointer in place
+            var px = region.x + region.width * (wheel.x / width)
+            var py = region.y + region.height * (wheel.y / height)
+            var x = Math.min(1 - w, Math.max(0, px - w * (wheel.x / width)))
+            var y = Math.min(1 - h, Math.max(0, py - h * (wheel.y / height)))
+            imageSocket.setClientRegion(imageSocket.activeClient, x, y, w, h)
         }
+        onDoubleClicked: imageSocket.setClientRegion(imageSocket.activeClient, 0, 0, 0, 0)
     }
 
-    // Also listen to newFrameReady for compatibility (frame object is ignored in QML)
+    /// Video wall: all clients composited on the GPU in one scene-graph node.
+    MosaicView {
+        id: mosaic
+        anchors.fill: parent
+        bridge: imageSocket
+        visible: imageSocket.mosaicMode && tileCount > 0
+        z: 1
+    }
+    
+    /// Update metrics when a new frame is available from the backend bridge.
     Connections {
         target: imageSocket
-        function onNewFrameReady(frame) {
-            img.source = "image://live/image?id=" + frame
+        function onFrameIdChanged(newId) {
             videoArea.hasImage = true
 
             if (statusBar !== undefined && statusBar !== null) {
@@ -145,8 +169,7 @@ Rectangle {
             if (statusBar !== undefined && statusBar !== null) {
                 statusBar.reset()
             }
-            // reset image source to placeholder
-            img.source = "image://live/image?id=0"
+            // the surface drops its frame itself (connectionLost)
         }
     }
 
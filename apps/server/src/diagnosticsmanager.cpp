@@ -1,7 +1,17 @@
 #include "diagnosticsmanager.h"
-#include <QCryptographicHash>
+#include <QCoreApplication>
 #include <QDebug>
+#include <QFile>
+#include <QSet>
 #include <QThread>
+#include <QVector>
+#include <vector>
+#include "frametrace.h"
+
+namespace {
+// Queued events handled per event loop turn; the rest waits for the next drain
+const std::size_t kDrainBatch = 512;
+}
 
 DiagnosticsManager::DiagnosticsManager(QObject *parent)
     : QObject(parent), m_model(new DiagnosticsModel(this))
@@ -10,27 +20,40 @@ DiagnosticsManager::DiagnosticsManager(QObject *parent)
     m_burstTimer.setSingleShot(false);
     m_burstTimer.setInterval(m_burstConsolidationMs);
     connect(&m_burstTimer, &QTimer::timeout, this, [this]() {
-        // On consolidation, push current aggregation snapshot to model
+        // On consolidation, push what changed since the last one to the model
         QMutexLocker locker(&m_mutex);
-        for (auto it = m_aggregation.begin(); it != m_aggregation.end(); ++it) {
-            const AggState &s = it.value();
-            if (s.count > 0) {
-                m_model->upsertEntry(s.entry);
-            }
+        QVector<DiagnosticEntry> changed;
+        changed.reserve(m_consolidationPending.size());
+        for (const QString &sig : qAsConst(m_consolidationPending)) {
+            auto it = m_aggregation.constFind(sig);
+            if (it != m_aggregation.constEnd() && it.value().count > 0)
+                changed.append(it.value().entry);
         }
+        m_consolidationPending.clear();
+        m_model->upsertEntries(changed);
     });
 }
 
+// FNV-1a (64 bit) over the code, the source and the first 256 characters of
+// the message, read straight from the strings' UTF-16 storage. It only has to
+// tell kinds of errors apart, on every post: no encoding or cryptographic hash.
 QString DiagnosticsManager::makeSignature(int code, const QString &message, const QString &source) const
 {
-    QByteArray data;
-    data.append(QString::number(code).toUtf8());
-    data.append("|");
-    data.append(source.toUtf8());
-    data.append("|");
-    data.append(message.left(256).toUtf8()); // normalize
-    QByteArray hash = QCryptographicHash::hash(data, QCryptographicHash::Sha1);
-    return QString::fromLatin1(hash.toHex());
+    quint64 hash = 14695981039346656037ull;
+    const auto mix = [&hash](quint32 value) {
+        hash ^= value;
+        hash *= 1099511628211ull;
+    };
+    mix(static_cast<quint32>(code));
+    mix(0xFFFFu); // separator: not a character
+    for (const QChar c : source)
+        mix(c.unicode());
+    mix(0xFFFFu);
+    const QChar *chars = message.constData();
+    const int length = qMin(message.size(), 256); // normalize
+    for (int i = 0; i < length; ++i)
+        mix(chars[i].unicode());
+    return QString::number(hash, 16).rightJustified(16, QLatin1Char('0'));
 }
 
 void DiagnosticsManager::postError(int code, const QString &message, ErrorSeverity severity, const QString &source, const QVariantMap &metadata)
@@ -49,9 +72,9 @@ void DiagnosticsManager::postError(int code, const QString &message, ErrorSeveri
     e.count = 1;
     e.metadata = metadata;
 
-    // ensure thread-safe post: marshal to this object's thread (usually main)
+    // ensure thread-safe post: other threads queue, this object's thread (usually main) drains
     if (QThread::currentThread() != thread()) {
-        QMetaObject::invokeMethod(this, [this, e]() { postErrorEvent(e); }, Qt::QueuedConnection);
+        enqueue(std::move(e));
         return;
     }
 
@@ -62,11 +85,80 @@ void DiagnosticsManager::postErrorEvent(const DiagnosticEntry &entry)
 {
     if (!m_enabled) return;
 
+    if (QThread::currentThread() != thread()) {
+        enqueue(entry);
+        return;
+    }
+
+    // After the events other threads queued before this one
+    std::vector<DiagnosticEntry> batch;
+    m_ingest.drain([&batch](DiagnosticEntry &&queued) { batch.push_back(std::move(queued)); });
+    batch.push_back(entry);
+    processBatch(batch);
+}
+
+void DiagnosticsManager::enqueue(DiagnosticEntry entry)
+{
+    m_ingest.push(std::move(entry));
+    // One drain per batch: only the first event queued since the last drain posts it
+    if (!m_drainScheduled.exchange(true))
+        QMetaObject::invokeMethod(this, [this]() { drainIngest(); }, Qt::QueuedConnection);
+}
+
+void DiagnosticsManager::drainIngest()
+{
+    // Events queued from here on post the next drain; the exchange also makes
+    // every event whose producer found the flag set visible to this drain
+    m_drainScheduled.exchange(false, std::memory_order_acq_rel);
+    std::vector<DiagnosticEntry> batch;
+    batch.reserve(64);
+    const std::size_t drained = m_ingest.drain(
+        [&batch](DiagnosticEntry &&queued) { batch.push_back(std::move(queued)); }, kDrainBatch);
+    if (drained == kDrainBatch && !m_drainScheduled.exchange(true))
+        QMetaObject::invokeMethod(this, [this]() { drainIngest(); }, Qt::QueuedConnection);
+    if (m_enabled && !batch.empty())
+        processBatch(batch);
+}
+
+void DiagnosticsManager::processBatch(const std::vector<DiagnosticEntry> &batch)
+{
     QMutexLocker locker(&m_mutex);
 
+    // The model is updated once per signature and batch, with its final counts
+    QVector<QString> shown;
+    QSet<QString> seen;
+    const DiagnosticEntry *last = nullptr;
+    for (const DiagnosticEntry &entry : batch) {
+        if (!aggregateLocked(entry))
+            continue;
+        if (!seen.contains(entry.id)) {
+            seen.insert(entry.id);
+            shown.append(entry.id);
+        }
+        last = &entry;
+    }
+
+    QVector<DiagnosticEntry> updates;
+    updates.reserve(shown.size());
+    for (const QString &sig : shown) {
+        AggState &s = m_aggregation[sig];
+        s.entry.count = s.count;
+        s.entry.lastTimestamp = s.last;
+        updates.append(s.entry);
+    }
+    m_model->upsertEntries(updates);
+    if (last) {
+        m_lastErrorMessage = last->message;
+        emit lastErrorChanged();
+    }
+}
+
+bool DiagnosticsManager::aggregateLocked(const DiagnosticEntry &entry)
+{
     QString sig = entry.id;
     auto it = m_aggregation.find(sig);
-    QDateTime now = QDateTime::currentDateTimeUtc();
+    // Posting time: a queued event counts when it happened, not when drained
+    QDateTime now = entry.lastTimestamp.isValid() ? entry.lastTimestamp : QDateTime::currentDateTimeUtc();
 
     if (it == m_aggregation.end()) {
         AggState s;
@@ -111,17 +203,12 @@ void DiagnosticsManager::postErrorEvent(const DiagnosticEntry &entry)
         AggState &s = m_aggregation[sig];
         s.suppressed = true;
         // model will be updated on consolidation timer; record last message too
-        return;
+        m_consolidationPending.insert(sig);
+        return false;
     }
 
-    // not in burst mode: push immediate update to model
-    AggState &s = m_aggregation[sig];
-    s.entry.count = s.count;
-    s.entry.lastTimestamp = s.last;
-    m_model->upsertEntry(s.entry);
-
-    m_lastErrorMessage = entry.message;
-    emit lastErrorChanged();
+    // not in burst mode: the batch pushes the update to the model
+    return true;
 }
 
 void DiagnosticsManager::setEnabled(bool v)
@@ -148,14 +235,24 @@ void DiagnosticsManager::setVerbose(bool v)
 
 void DiagnosticsManager::dumpLogs(const QString &path)
 {
-    Q_UNUSED(path);
-    qInfo() << "DiagnosticsManager::dumpLogs not implemented yet";
+    // The frame-lifecycle trace, as Chrome trace JSON (see frametrace.h)
+    if (!FrameTrace::isEnabled()) {
+        qInfo() << "DiagnosticsManager::dumpLogs: frame tracing is off (start with --trace or IMAGESOCKET_TRACE=1)";
+        return;
+    }
+    if (FrameTrace::writeChromeJson(QFile::encodeName(path).toStdString(),
+                                    static_cast<int>(QCoreApplication::applicationPid()), "server"))
+        qInfo() << "Frame trace written to" << path;
+    else
+        qWarning() << "Could not write the frame trace to" << path;
 }
 
 void DiagnosticsManager::clear()
 {
+    m_ingest.drain([](DiagnosticEntry &&) {});
     QMutexLocker locker(&m_mutex);
     m_aggregation.clear();
+    m_consolidationPending.clear();
     m_model->clear();
 }
 
@@ -1,5 +1,7 @@
 #include "diagnosticsmodel.h"
 #include <QDebug>
+#include <algorithm>
+#include <functional>
 
 DiagnosticsModel::DiagnosticsModel(QObject *parent)
     : QAbstractListModel(parent)
@@ -52,43 +54,97 @@ QHash<int, QByteArray> DiagnosticsModel::roleNames() const
 
 void DiagnosticsModel::upsertEntry(const DiagnosticEntry &entry)
 {
-    // Try to find an existing entry with same id
-    for (size_t i = 0; i < m_entries.size(); ++i) {
-        if (m_entries[i].id == entry.id) {
-            // update in place and emit dataChanged
-            m_entries[i].count = entry.count;
-            m_entries[i].lastTimestamp = entry.lastTimestamp;
-            m_entries[i].message = entry.message;
-            m_entries[i].metadata = entry.metadata;
-            m_entries[i].suppressed = entry.suppressed;
-            QModelIndex idx = index(static_cast<int>(i));
-            emit dataChanged(idx, idx);
-            return;
+    upsertEntries(QVector<DiagnosticEntry>{entry});
+}
+
+void DiagnosticsModel::upsertEntries(const QVector<DiagnosticEntry> &entries)
+{
+    const auto update = [](DiagnosticEntry &target, const DiagnosticEntry &entry) {
+        target.count = entry.count;
+        target.lastTimestamp = entry.lastTimestamp;
+        target.message = entry.message;
+        target.metadata = entry.metadata;
+        target.suppressed = entry.suppressed;
+    };
+
+    // Existing entries are updated in place (by index, no scan); new ones are
+    // collected so the batch inserts once
+    QVector<quint64> updated;
+    QVector<DiagnosticEntry> added;
+    QHash<QString, int> addedIndex;
+    for (const DiagnosticEntry &entry : entries) {
+        auto serial = m_serials.constFind(entry.id);
+        if (serial != m_serials.constEnd()) {
+            update(m_entries[static_cast<size_t>(rowOf(serial.value()))], entry);
+            updated.append(serial.value());
+            continue;
         }
+        auto pending = addedIndex.constFind(entry.id);
+        if (pending != addedIndex.constEnd()) {
+            update(added[pending.value()], entry);
+            continue;
+        }
+        addedIndex.insert(entry.id, added.size());
+        added.append(entry);
     }
 
-    // append new entry at front (most recent first)
-    beginInsertRows(QModelIndex(), 0, 0);
-    m_entries.push_front(entry);
-    endInsertRows();
+    // new entries at front (most recent first)
+    if (!added.isEmpty()) {
+        beginInsertRows(QModelIndex(), 0, added.size() - 1);
+        for (const DiagnosticEntry &entry : added) {
+            m_serials.insert(entry.id, m_nextSerial++);
+            m_entries.push_front(entry);
+        }
+        endInsertRows();
+    }
 
     // enforce max entries
-    while (static_cast<int>(m_entries.size()) > m_maxEntries) {
-        beginRemoveRows(QModelIndex(), static_cast<int>(m_entries.size()) - 1, static_cast<int>(m_entries.size()) - 1);
+    trimTo(m_maxEntries);
+
+    if (updated.isEmpty())
+        return;
+    // Highest serial first == top row first; evicted rows are skipped
+    std::sort(updated.begin(), updated.end(), std::greater<quint64>());
+    updated.erase(std::unique(updated.begin(), updated.end()), updated.end());
+    const int rows = static_cast<int>(m_entries.size());
+    int runStart = -1;
+    int runEnd = -1;
+    for (quint64 serial : updated) {
+        const int row = rowOf(serial);
+        if (row >= rows)
+            break;
+        if (row == runEnd + 1 && runStart >= 0) {
+            runEnd = row;
+            continue;
+        }
+        if (runStart >= 0)
+            emit dataChanged(index(runStart), index(runEnd));
+        runStart = row;
+        runEnd = row;
+    }
+    if (runStart >= 0)
+        emit dataChanged(index(runStart), index(runEnd));
+}
+
+void DiagnosticsModel::trimTo(int maxEntries)
+{
+    const int rows = static_cast<int>(m_entries.size());
+    const int keep = std::max(0, maxEntries);
+    if (rows <= keep)
+        return;
+    beginRemoveRows(QModelIndex(), keep, rows - 1);
+    while (static_cast<int>(m_entries.size()) > keep) {
+        m_serials.remove(m_entries.back().id);
         m_entries.pop_back();
-        endRemoveRows();
     }
+    endRemoveRows();
 }
 
 void DiagnosticsModel::setMaxEntries(int maxEntries)
 {
     m_maxEntries = maxEntries;
     // trim if necessary
-    while (static_cast<int>(m_entries.size()) > m_maxEntries) {
-        beginRemoveRows(QModelIndex(), static_cast<int>(m_entries.size()) - 1, static_cast<int>(m_entries.size()) - 1);
-        m_entries.pop_back();
-        endRemoveRows();
-    }
+    trimTo(m_maxEntries);
 }
 
 int DiagnosticsModel::maxEntries() const { return m_maxEntries; }
@@ -98,5 +154,6 @@ void DiagnosticsModel::clear()
     if (m_entries.empty()) return;
     beginResetModel();
     m_entries.clear();
+    m_serials.clear();
     endResetModel();
 }
@@ -1,51 +1,79 @@
 #include "videoreader.h"
+#include <QDebug>
+#include <QMetaObject>
+#include "network/pixelswizzle.h"
 
 VideoClass::VideoClass(LiveImageProvider *obj)
+    : source([this](cv::Mat &frame) {
+          // Capture thread: decode and the one pixel pass stay off the GUI thread.
+          // VideoCapture only delivers BGR; it is widened straight into the
+          // RGB32 layout the scene graph uploads as is (no RGB888 conversion there)
+          if (!capture.read(bgr) || bgr.empty() || bgr.type() != CV_8UC3)
+              return false;
+          frame.create(bgr.rows, bgr.cols, CV_8UC4); // a fresh Mat per frame (CaptureSource)
+          bgrToRgb32(bgr.data, static_cast<int>(bgr.step), frame.data, static_cast<int>(frame.step), bgr.cols, bgr.rows);
+          return true;
+      })
 {
-    capture.open("/home/david/Projetos/digit-reader/input_source.mp4");
-    if (!capture.isOpened()) {
-        qDebug() << "Failed to open video: /home/david/Projetos/digit-reader/input_source.mp4";
-    }
-
     this->lip = obj;
 
-    QObject::connect(&timer, &QTimer::timeout, this, &VideoClass::readFrame);
+    source.setOnFrame([this]() {
+        QMetaObject::invokeMethod(this, &VideoClass::readFrame, Qt::QueuedConnection);
+    });
+    openVideo();
 }
 
 VideoClass::~VideoClass()
 {
+    source.stop();
     capture.release();
 }
 
-void VideoClass::readFrame()
+void VideoClass::openVideo()
 {
-    cv::Mat frame;
-    capture >> frame;  // Read a frame from the camera
+    capture.open("/home/david/Projetos/digit-reader/input_source.mp4");
+    if (!capture.isOpened()) {
+        qDebug() << "Failed to open video: /home/david/Projetos/digit-reader/input_source.mp4";
+        return;
+    }
+    const double fps = capture.get(cv::CAP_PROP_FPS);
+    source.setFps(fps > 0 ? fps : 30.0);
+}
 
-    if (!frame.empty()) {
-        cv::cvtColor(frame, frame, cv::COLOR_BGR2RGB);  // Convert the frame to RGB format
+void VideoClass::readFrame()
+{
+    // GUI thread: the newest frame, if the capture thread has one since the last call
+    CaptureSource::Frame frame;
+    if (!source.take(frame, 0))
+        return;
 
-        QImage image(frame.data, frame.cols, frame.rows, frame.step, QImage::Format_RGB888);
-        this->lip->updateImage(image);  // Update the image in the LiveImageProvider
-    }
+    // The QImage shares the Mat's pixels (a reference, released with the last
+    // copy of the image) instead of copying them
+    cv::Mat *pixels = new cv::Mat(frame.image);
+    QImage image(pixels->data, pixels->cols, pixels->rows, static_cast<int>(pixels->step), QImage::Format_RGB32,
+                 [](void *mat) { delete static_cast<cv::Mat *>(mat); }, pixels);
+    this->lip->updateImage(image);  // Update the image in the LiveImageProvider
 }
 
 void VideoClass::startVideo()
 {
-    timer.start(30);
+    source.setPaused(false);
+    if (source.finished())
+        source.stop(); // end of the file: the thread is done, start it again
+    source.start();
 }
 
 void VideoClass::stopVideo()
 {
-    timer.stop();
+    source.setPaused(true);
 }
 
 void VideoClass::resetVideo()
 {
-    if (!capture.isOpened())
-        capture.release();
-
-    capture.open("/home/david/Projetos/digit-reader/input_source.mp4");
-    if (!capture.isOpened())
-        qDebug() << "Failed to open video: /home/david/Projetos/digit-reader/input_source.mp4";
-};
+    const bool running = source.isRunning();
+    source.stop();
+    capture.release();
+    openVideo();
+    if (running)
+        source.start();
+}
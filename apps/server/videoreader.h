@@ -1,16 +1,21 @@
 #ifndef VIDEOREADER_H
 #define VIDEOREADER_H
 
-#include <QTimer>
+#include <QObject>
 #include <opencv2/opencv.hpp>
 #include "liveimageprovider.h"
+#include "network/capturesource.h"
 
+// Reads and converts frames on a CaptureSource thread at the file's rate
+// (30 fps when it doesn't say); the GUI thread only receives the newest one,
+// as a Format_RGB32 QImage sharing the frame's pixels.
 class VideoClass : public QObject
 {
     Q_OBJECT
-    cv::VideoCapture capture;
+    cv::VideoCapture capture; // used by the capture thread while it runs
+    cv::Mat bgr;              // capture thread: decoded frame, reused
     LiveImageProvider *lip = nullptr;
-    QTimer timer;
+    CaptureSource source;
 public:
     VideoClass(LiveImageProvider *obj);
     ~VideoClass();
@@ -20,6 +25,9 @@ public slots:
     void startVideo();
     void stopVideo();
     void resetVideo();
+
+private:
+    void openVideo();
 };
 
 
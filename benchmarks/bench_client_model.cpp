@@ -0,0 +1,38 @@
+#include <benchmark/benchmark.h>
+#include <QString>
+#include <QVector>
+#include "network/clientmodel.h"
+
+// ClientModel::recordFrameReceived() runs on the GUI thread once per frame of
+// every client: with N clients at 30 fps that is 30 N calls per second, each
+// looking the client up by id. Timestamps start at the model's monotonic clock
+// and advance 1 ms per call, so every client republishes its rate (every
+// 250 ms) and closes its one-second traffic window regularly, each emitting
+// dataChanged.
+
+namespace {
+
+void BM_RecordFrameReceived(benchmark::State& state)
+{
+    const int clients = static_cast<int>(state.range(0));
+    ClientModel model;
+    QVector<QString> ids;
+    ids.reserve(clients);
+    for (int i = 0; i < clients; ++i) {
+        ids.append(QStringLiteral("{client-%1}").arg(i));
+        model.addClient(ids.back(), QStringLiteral("active"));
+    }
+
+    qint64 timestampMs = ClientModel::monotonicMs();
+    int next = 0;
+    for (auto _ : state) {
+        model.recordFrameReceived(ids[next], ++timestampMs);
+        if (++next == clients)
+            next = 0;
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+} // namespace
+
+BENCHMARK(BM_RecordFrameReceived)->Arg(1)->Arg(8)->Arg(64)->Arg(256);
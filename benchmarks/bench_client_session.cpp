@@ -0,0 +1,91 @@
+#include <benchmark/benchmark.h>
+#include <QByteArray>
+#include <QWebSocket>
+#include <string>
+#include <vector>
+#include "network/clientsession.h"
+#include "network/frameheader.h"
+#include "control.pb.h"
+
+// ClientSession::onBinaryMessageReceived() as the socket drives it: the
+// binaryMessageReceived signal, parsing (InboundParser) and the signal out to
+// the bridge. The frame payload is viewed in place, so the cost must not grow
+// with the frame size.
+
+namespace {
+
+const int kFrameHeaderWire = static_cast<int>(kFrameHeaderSize);
+
+QByteArray legacyJpegMessage(int payloadBytes)
+{
+    QByteArray message(1 + payloadBytes, '\x55');
+    message[0] = '\x00';
+    return message;
+}
+
+QByteArray framedJpegMessage(int payloadBytes)
+{
+    QByteArray message(1 + kFrameHeaderWire + payloadBytes, '\x55');
+    message[0] = '\x04';
+    FrameHeader header;
+    header.sequence = 1;
+    header.captureTimeUs = 1700000000000000;
+    header.width = 1280;
+    header.height = 720;
+    writeFrameHeader(header, reinterpret_cast<std::uint8_t*>(message.data()) + 1);
+    return message;
+}
+
+QByteArray controlMessage()
+{
+    imagesocket::control::ControlMessage msg;
+    msg.set_type(imagesocket::control::STATS);
+    msg.set_queued_frames(2);
+    msg.set_dropped_frames(15);
+    const std::string bytes = msg.SerializeAsString();
+    QByteArray message(1, '\x01');
+    message.append(bytes.data(), static_cast<int>(bytes.size()));
+    return message;
+}
+
+void dispatch(benchmark::State& state, const QByteArray& message)
+{
+    QWebSocket* socket = new QWebSocket(); // owned by the session
+    ClientSession session(socket);
+    quint64 frames = 0;
+    quint64 controls = 0;
+    QObject::connect(&session, &ClientSession::encodedFrameReceived,
+                     [&frames](const QString&, const EncodedFrame&) { ++frames; });
+    QObject::connect(&session, &ClientSession::controlMessageReceived,
+                     [&controls](const QString&, const ControlMessagePtr&) { ++controls; });
+
+    for (auto _ : state)
+        emit socket->binaryMessageReceived(message);
+
+    if (frames + controls != static_cast<quint64>(state.iterations()))
+        state.SkipWithError("message was not dispatched");
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * message.size());
+}
+
+void BM_SessionLegacyJpeg(benchmark::State& state)
+{
+    dispatch(state, legacyJpegMessage(static_cast<int>(state.range(0))));
+}
+
+void BM_SessionFramedJpeg(benchmark::State& state)
+{
+    dispatch(state, framedJpegMessage(static_cast<int>(state.range(0))));
+}
+
+void BM_SessionControl(benchmark::State& state)
+{
+    dispatch(state, controlMessage());
+}
+
+} // namespace
+
+// 16 KiB: 640x480 thumbnail, 256 KiB: 1920x1080 at quality 80
+BENCHMARK(BM_SessionLegacyJpeg)->Arg(16 << 10)->Arg(256 << 10);
+BENCHMARK(BM_SessionFramedJpeg)->Arg(16 << 10)->Arg(256 << 10);
+BENCHMARK(BM_SessionControl);
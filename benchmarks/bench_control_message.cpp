@@ -0,0 +1,59 @@
+#include <benchmark/benchmark.h>
+#include <string>
+#include "control.pb.h"
+
+using imagesocket::control::ControlMessage;
+
+namespace {
+
+// STATS: sent by every client with each batch of frames (rate control)
+ControlMessage statsMessage()
+{
+    ControlMessage msg;
+    msg.set_type(imagesocket::control::STATS);
+    msg.set_client_id(7);
+    msg.set_timestamp_ms(1700000000000);
+    msg.set_queued_frames(2);
+    msg.set_dropped_frames(15);
+    return msg;
+}
+
+// PONG: answer to the server's clock probe, the largest periodic message
+ControlMessage pongMessage()
+{
+    ControlMessage msg;
+    msg.set_type(imagesocket::control::PONG);
+    msg.set_timestamp_us(1700000000123456);
+    msg.set_echo_timestamp_us(1700000000120000);
+    msg.set_receive_timestamp_us(1700000000122000);
+    return msg;
+}
+
+void BM_ControlSerialize(benchmark::State& state, ControlMessage (*make)())
+{
+    const ControlMessage msg = make();
+    std::string out; // reused, as the clients reuse their send buffer
+    for (auto _ : state) {
+        msg.SerializeToString(&out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(out.size()));
+}
+
+void BM_ControlParse(benchmark::State& state, ControlMessage (*make)())
+{
+    const std::string bytes = make().SerializeAsString();
+    for (auto _ : state) {
+        ControlMessage msg;
+        const bool ok = msg.ParseFromArray(bytes.data(), static_cast<int>(bytes.size()));
+        benchmark::DoNotOptimize(ok);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(bytes.size()));
+}
+
+} // namespace
+
+BENCHMARK_CAPTURE(BM_ControlSerialize, stats, statsMessage);
+BENCHMARK_CAPTURE(BM_ControlSerialize, pong, pongMessage);
+BENCHMARK_CAPTURE(BM_ControlParse, stats, statsMessage);
+BENCHMARK_CAPTURE(BM_ControlParse, pong, pongMessage);
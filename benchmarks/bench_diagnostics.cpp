@@ -0,0 +1,101 @@
+#include <benchmark/benchmark.h>
+#include <QCoreApplication>
+#include <QString>
+#include <QVector>
+#include <thread>
+#include <vector>
+#include "diagnosticsmanager.h"
+
+// DiagnosticsManager::postError() under an error burst (a client flooding bad
+// frames, a failing decoder): the same error repeated, which aggregates into
+// one entry, and a spread of distinct errors. Each iteration posts one burst
+// on the manager's own thread, or from worker threads (decoders failing) with
+// the manager's thread draining what they queued.
+// DiagnosticsModel: a consolidation pass refreshing every row of a full model,
+// entry by entry and as one batch.
+
+namespace {
+
+const int kBurst = 1000;
+
+void BM_PostErrorRepeated(benchmark::State& state)
+{
+    DiagnosticsManager manager;
+    const QString message = QStringLiteral("Invalid frame header");
+    const QString source = QStringLiteral("ClientSession");
+    for (auto _ : state) {
+        for (int i = 0; i < kBurst; ++i)
+            manager.postError(1001, message, DiagnosticsManager::Warning, source);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * kBurst);
+}
+
+void BM_PostErrorDistinct(benchmark::State& state)
+{
+    const int distinct = static_cast<int>(state.range(0));
+    DiagnosticsManager manager;
+    QVector<QString> messages;
+    for (int i = 0; i < distinct; ++i)
+        messages.append(QStringLiteral("Decode failed for client %1").arg(i));
+    const QString source = QStringLiteral("FrameDecoder");
+    for (auto _ : state) {
+        for (int i = 0; i < kBurst; ++i)
+            manager.postError(2000 + i % distinct, messages[i % distinct], DiagnosticsManager::Error, source);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * kBurst);
+}
+
+void BM_PostErrorFromThreads(benchmark::State& state)
+{
+    const int threads = static_cast<int>(state.range(0));
+    DiagnosticsManager manager;
+    const QString source = QStringLiteral("FrameDecoder");
+    for (auto _ : state) {
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back([&manager, &source, t, threads]() {
+                const QString message = QStringLiteral("Decode failed for client %1").arg(t);
+                for (int i = 0; i < kBurst / threads; ++i)
+                    manager.postError(3000 + t, message, DiagnosticsManager::Error, source);
+            });
+        }
+        for (std::thread& worker : workers)
+            worker.join();
+        QCoreApplication::processEvents(); // the batched drain
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * (kBurst / threads) * threads);
+}
+
+void BM_ModelConsolidate(benchmark::State& state)
+{
+    const bool batched = state.range(0) != 0;
+    const int rows = 500; // the model's default limit
+    DiagnosticsModel model;
+    QVector<DiagnosticEntry> entries;
+    for (int i = 0; i < rows; ++i) {
+        DiagnosticEntry entry;
+        entry.id = QStringLiteral("signature-%1").arg(i);
+        entry.message = QStringLiteral("Decode failed for client %1").arg(i);
+        entry.count = 1;
+        entries.append(entry);
+    }
+    model.upsertEntries(entries);
+    for (auto _ : state) {
+        for (DiagnosticEntry& entry : entries)
+            ++entry.count;
+        if (batched) {
+            model.upsertEntries(entries);
+        } else {
+            for (const DiagnosticEntry& entry : entries)
+                model.upsertEntry(entry);
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * rows);
+}
+
+} // namespace
+
+BENCHMARK(BM_PostErrorRepeated);
+BENCHMARK(BM_PostErrorDistinct)->Arg(16)->Arg(256);
+BENCHMARK(BM_PostErrorFromThreads)->Arg(1)->Arg(4)->UseRealTime();
+BENCHMARK(BM_ModelConsolidate)->Arg(0)->Arg(1);
@@ -0,0 +1,66 @@
+#include <benchmark/benchmark.h>
+#include <QImage>
+#include <cstdint>
+#include <vector>
+#include "network/jpegcodec.h"
+
+// JPEG decode on the server's ingest path (JpegCodec::forCurrentThread(), so
+// the backend the process would pick: V4L2, TurboJPEG or the generic one) at
+// the resolutions clients send. The decoded image returns to the ImagePool
+// each iteration, as it does once the display releases a frame.
+
+namespace {
+
+// BGR gradient with a block and fixed noise: compresses like camera frames
+std::vector<unsigned char> encodedTestFrame(int width, int height, int quality)
+{
+    const int stride = width * 3;
+    std::vector<unsigned char> pixels(static_cast<std::size_t>(stride) * height);
+    std::uint32_t seed = 12345;
+    for (int y = 0; y < height; ++y) {
+        unsigned char* row = pixels.data() + static_cast<std::size_t>(y) * stride;
+        for (int x = 0; x < width; ++x) {
+            seed = seed * 1664525u + 1013904223u;
+            const bool block = x > width / 3 && x < width / 2 && y > height / 3 && y < height * 2 / 3;
+            row[x * 3 + 0] = static_cast<unsigned char>(block ? 40 : 255 * x / width);
+            row[x * 3 + 1] = static_cast<unsigned char>(block ? 200 : 255 * y / height);
+            row[x * 3 + 2] = static_cast<unsigned char>(128 + (seed >> 27));
+        }
+    }
+    std::vector<unsigned char> jpeg;
+    JpegCodec::forCurrentThread().encodeBgr(pixels.data(), width, height, stride, quality, jpeg);
+    return jpeg;
+}
+
+void BM_JpegDecode(benchmark::State& state)
+{
+    const int width = static_cast<int>(state.range(0));
+    const int height = static_cast<int>(state.range(1));
+    const std::vector<unsigned char> jpeg = encodedTestFrame(width, height, 75);
+    if (jpeg.empty()) {
+        state.SkipWithError("encoding the test frame failed");
+        return;
+    }
+
+    JpegCodec& codec = JpegCodec::forCurrentThread();
+    for (auto _ : state) {
+        QImage image;
+        if (!codec.decode(jpeg.data(), static_cast<int>(jpeg.size()), image)) {
+            state.SkipWithError("decode failed");
+            break;
+        }
+        benchmark::DoNotOptimize(image.constBits());
+    }
+    state.SetLabel(codec.name());
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(jpeg.size()));
+    state.counters["jpeg_bytes"] = static_cast<double>(jpeg.size());
+}
+
+} // namespace
+
+BENCHMARK(BM_JpegDecode)
+    ->Args({640, 480})
+    ->Args({1280, 720})
+    ->Args({1920, 1080})
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,20 @@
+#include <benchmark/benchmark.h>
+#include <QCoreApplication>
+#include <QLoggingCategory>
+
+// The sessions and models under test are QObjects: they need an application
+// object, not a running event loop (every benchmark is single threaded).
+// Debug and info logging stays off as in a release deployment, so the hot
+// paths pay the category check but never the console write.
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+    QLoggingCategory::setFilterRules(QStringLiteral("*.debug=false\n*.info=false"));
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
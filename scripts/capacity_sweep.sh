@@ -0,0 +1,106 @@
+#!/usr/bin/env bash
+set -eu
+
+# Varredura de capacidade do servidor: para cada quantidade de clientes sobe um
+# servidor headless novo (--mosaic: todos os streams completos e decodificados),
+# roda o load_generator e junta as linhas "stats" do servidor com o "summary"
+# do gerador. O ponto de saturação é o primeiro passo em que o servidor recebe
+# menos de SATURATION_RATIO do fps alvo.
+#
+# Uso: ./scripts/capacity_sweep.sh [clientes...]      (padrão: 1 2 4 8 16 32 64)
+# Variáveis: FPS WIDTH HEIGHT QUALITY DURATION PORT BUILD_DIR SATURATION_RATIO
+# Saída: CSV em stdout, um passo por linha, para comparar builds.
+
+ROOT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+BUILD_DIR="${BUILD_DIR:-$ROOT_DIR/build}"
+SERVER_BIN="$BUILD_DIR/apps/server/server-receiver"
+LOAD_BIN="$BUILD_DIR/apps/client/load_generator"
+
+FPS="${FPS:-30}"
+WIDTH="${WIDTH:-1280}"
+HEIGHT="${HEIGHT:-720}"
+QUALITY="${QUALITY:-75}"
+DURATION="${DURATION:-20}"
+PORT="${PORT:-5031}"
+SATURATION_RATIO="${SATURATION_RATIO:-0.95}"
+STEPS=("$@")
+if [[ ${#STEPS[@]} -eq 0 ]]; then
+    STEPS=(1 2 4 8 16 32 64)
+fi
+
+WORK_DIR="$(mktemp -d)"
+SERVER_PID=""
+cleanup() {
+    if [[ -n "$SERVER_PID" ]]; then
+        kill "$SERVER_PID" 2>/dev/null || true
+        wait "$SERVER_PID" 2>/dev/null || true
+    fi
+    rm -rf "$WORK_DIR"
+}
+trap cleanup EXIT
+
+info() { echo "[INFO] $*" >&2; }
+err() { echo "[ERROR] $*" >&2; }
+
+for bin in "$SERVER_BIN" "$LOAD_BIN"; do
+    if [[ ! -x "$bin" ]]; then
+        err "Binário não encontrado: $bin (compile antes)"
+        exit 1
+    fi
+done
+
+# Configurações do servidor isoladas: --mosaic não altera as preferências do usuário
+export XDG_CONFIG_HOME="$WORK_DIR/config"
+
+# Média de um campo chave=valor na segunda metade das linhas (regime estável)
+steady_mean() {
+    local field="$1" file="$2"
+    grep '^stats ' "$file" | awk -v key="$field" '
+        { for (i = 2; i <= NF; ++i) { split($i, kv, "="); if (kv[1] == key) values[n++] = kv[2] } }
+        END {
+            if (n == 0) { print "nan"; exit }
+            start = int(n / 2); sum = 0
+            for (i = start; i < n; ++i) sum += values[i]
+            printf "%.1f", sum / (n - start)
+        }'
+}
+
+field() {
+    local key="$1" line="$2"
+    echo "$line" | tr ' ' '\n' | awk -F= -v key="$key" '$1 == key { print $2 }'
+}
+
+echo "clients,target_fps,server_fps,sent_fps,client_drop_percent,network_p99_ms,decode_p99_ms,server_cpu_percent"
+SATURATED_AT=""
+for clients in "${STEPS[@]}"; do
+    SERVER_LOG="$WORK_DIR/server_$clients.log"
+    "$SERVER_BIN" --headless --mosaic --port "$PORT" --stats 1 > "$SERVER_LOG" 2>&1 &
+    SERVER_PID=$!
+    for _ in $(seq 1 20); do
+        grep -q "WebSocketServer started on port" "$SERVER_LOG" && break
+        sleep 0.5
+    done
+
+    info "Passo: $clients clientes x $FPS fps (${WIDTH}x${HEIGHT}, ${DURATION}s)"
+    SUMMARY="$("$LOAD_BIN" --port "$PORT" --clients "$clients" --fps "$FPS" --width "$WIDTH" \
+        --height "$HEIGHT" --quality "$QUALITY" --duration "$DURATION" | grep '^summary ' || true)"
+
+    kill "$SERVER_PID" 2>/dev/null || true
+    wait "$SERVER_PID" 2>/dev/null || true
+    SERVER_PID=""
+
+    target=$((clients * FPS))
+    server_fps="$(steady_mean fps "$SERVER_LOG")"
+    echo "$clients,$target,$server_fps,$(field sent_fps "$SUMMARY"),$(field drop_percent "$SUMMARY"),$(steady_mean network_p99_ms "$SERVER_LOG"),$(steady_mean decode_p99_ms "$SERVER_LOG"),$(steady_mean cpu_percent "$SERVER_LOG")"
+
+    if [[ -z "$SATURATED_AT" ]] && awk -v got="$server_fps" -v want="$target" -v ratio="$SATURATION_RATIO" \
+        'BEGIN { exit !(got == "nan" || got < want * ratio) }'; then
+        SATURATED_AT="$clients"
+        info "Saturação: $clients clientes (servidor recebeu $server_fps de $target fps)"
+        break
+    fi
+done
+
+if [[ -z "$SATURATED_AT" ]]; then
+    info "Sem saturação até ${STEPS[-1]} clientes."
+fi
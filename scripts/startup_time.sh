@@ -0,0 +1,47 @@
+#!/usr/bin/env bash
+set -eu
+
+# Tempo até a primeira janela do servidor (GUI): roda o servidor com
+# --startup-time N vezes e junta a linha "startup" de cada execução com o tempo
+# de parede medido aqui (inclui carregar as bibliotecas, antes do main()).
+#
+# Uso: ./scripts/startup_time.sh [execuções]          (padrão: 5)
+# Variáveis: BUILD_DIR PORT (QT_QPA_PLATFORM=offscreen em máquinas sem tela)
+# Saída: CSV em stdout, uma execução por linha, e a mediana no stderr.
+
+ROOT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+BUILD_DIR="${BUILD_DIR:-$ROOT_DIR/build}"
+SERVER_BIN="$BUILD_DIR/apps/server/server-receiver"
+PORT="${PORT:-5032}"
+RUNS="${1:-5}"
+
+info() { echo "[INFO] $*" >&2; }
+err() { echo "[ERROR] $*" >&2; }
+
+if [[ ! -x "$SERVER_BIN" ]]; then
+    err "Binário não encontrado: $SERVER_BIN (compile antes)"
+    exit 1
+fi
+
+field() {
+    local key="$1" line="$2"
+    echo "$line" | tr ' ' '\n' | awk -F= -v key="$key" '$1 == key { print $2 }'
+}
+
+echo "run,process_ms,qml_ms,first_frame_ms"
+TOTALS=()
+for run in $(seq 1 "$RUNS"); do
+    start_ns="$(date +%s%N)"
+    LINE="$(timeout 60 "$SERVER_BIN" --startup-time --port "$PORT" 2>/dev/null | grep '^startup ' || true)"
+    end_ns="$(date +%s%N)"
+    if [[ -z "$LINE" ]]; then
+        err "Execução $run: nenhuma linha \"startup\" (QML falhou ou sem tela?)"
+        exit 1
+    fi
+    process_ms=$(((end_ns - start_ns) / 1000000))
+    TOTALS+=("$process_ms")
+    echo "$run,$process_ms,$(field qml_ms "$LINE"),$(field first_frame_ms "$LINE")"
+done
+
+median="$(printf '%s\n' "${TOTALS[@]}" | sort -n | awk '{ v[NR] = $1 } END { print v[int((NR + 1) / 2)] }')"
+info "Mediana (processo, até sair após o primeiro quadro): ${median} ms em $RUNS execuções"
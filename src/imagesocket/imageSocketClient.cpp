@@ -1,6 +1,14 @@
 #include "imageSocketClient.h"
+#include <array>
+#include "jpegcodec.h"
 
-ImageSocketClient::ImageSocketClient(const std::string &serverAddress, int serverPort)
+namespace
+{
+// imencode's default, which this client sent before it used JpegCodec
+const int kJpegQuality = 95;
+}
+
+ImageSocketClient::ImageSocketClient(const std::string &serverAddress, int serverPort, Framing framing)
     : serverAddress_(serverAddress),
       serverPort_(serverPort),
       ioService_(),
@@ -9,6 +17,7 @@ ImageSocketClient::ImageSocketClient(const std::string &serverAddress, int serve
       mutex_(),
       cv_(),
       currentImage_(),
+      framing_(framing),
       connected_(false)
 {
 }
@@ -45,7 +54,11 @@ void ImageSocketClient::disconnect()
 {
     if (connected_)
     {
-        connected_ = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            connected_ = false;
+        }
+        cv_.notify_all(); // wake the sending thread so it can be joined
         socket_.close();
 
         if(receiveThread_.joinable())
@@ -60,9 +73,23 @@ bool ImageSocketClient::setImage(const cv::Mat &image)
         return false; // Not connected
     }
 
-    // Lock the mutex and update the current image
-    std::unique_lock<std::mutex> lock(mutex_);
-    currentImage_ = image.clone();
+    // The caller keeps writing into its Mat (capture loops do): copy it, but
+    // outside the lock, then hand the copy over like a moved one
+    return setImage(image.clone());
+}
+
+bool ImageSocketClient::setImage(cv::Mat &&image)
+{
+    if (!connected_)
+    {
+        return false; // Not connected
+    }
+
+    {
+        // Only the Mat header changes hands; an unsent frame is replaced
+        std::lock_guard<std::mutex> lock(mutex_);
+        currentImage_ = std::move(image);
+    }
     cv_.notify_one(); // Notify the sending thread that a new image is available
     return true;
 }
@@ -71,39 +98,65 @@ void ImageSocketClient::sendImages()
 {
     while (connected_)
     {
-        // Wait for a new image to be available
-        std::unique_lock<std::mutex> lock(mutex_);
-        cv_.wait(lock, [this]()
-                { return !connected_ || !currentImage_.empty(); });
+        {
+            // Wait for a new image to be available and take it; encoding and
+            // sending run without the lock so setImage() never waits on them
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this]()
+                    { return !connected_ || !currentImage_.empty(); });
+            cv::swap(sendingImage_, currentImage_);
+            currentImage_.release();
+        }
 
         // Check if still connected and an image is available
-        if (!connected_ || currentImage_.empty())
+        if (!connected_ || sendingImage_.empty())
         {
             continue;
         }
 
         try
         {
-            // Convert the OpenCV image to a buffer
-            std::vector<uchar> buffer;
-            cv::imencode(".jpg", currentImage_, buffer);
-
-            const size_t chunkSize = 2048; // Set your desired chunk size
-
-            // Send datastart
-            boost::asio::write(socket_, boost::asio::buffer("datastart"));
-
-            std::this_thread::sleep_for(std::chrono::microseconds(200));
+            // Convert the OpenCV image to a buffer (reused between frames, so it
+            // only grows when a frame is larger than any before). BGR frames go to
+            // this thread's JPEG codec (a hardware encoder when present); other
+            // pixel formats to imencode
+            std::vector<uchar>& buffer = encodeBuffer_;
+            bool encoded;
+            if (sendingImage_.type() == CV_8UC3)
+                encoded = JpegCodec::forCurrentThread().encodeBgr(sendingImage_.data, sendingImage_.cols, sendingImage_.rows,
+                                                                  static_cast<int>(sendingImage_.step), kJpegQuality, buffer);
+            else
+                encoded = cv::imencode(".jpg", sendingImage_, buffer, {cv::IMWRITE_JPEG_QUALITY, kJpegQuality});
+            sendingImage_.release();
+            if (!encoded)
+            {
+                continue;
+            }
 
-            for (size_t i = 0; i < buffer.size(); i += chunkSize)
+            if (framing_ == Framing::LengthPrefixed)
             {
-                boost::asio::write(socket_, boost::asio::buffer(&buffer[i], std::min<size_t>(chunkSize, buffer.size() - i)));
+                // Header and JPEG in one gathered write: the server parses by length
+                uint8_t header[kStreamFrameHeaderSize];
+                writeStreamFrameHeader(static_cast<uint32_t>(buffer.size()), header);
+                const std::array<boost::asio::const_buffer, 2> frame = {
+                    boost::asio::buffer(header), boost::asio::buffer(buffer)};
+                boost::asio::write(socket_, frame);
             }
+            else
+            {
+                // Send datastart
+                boost::asio::write(socket_, boost::asio::buffer("datastart"));
+
+                // Older servers only find the markers in reads of their own
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
 
-            std::this_thread::sleep_for(std::chrono::microseconds(200));
+                boost::asio::write(socket_, boost::asio::buffer(buffer));
 
-            // Send dataend marker
-            boost::asio::write(socket_, boost::asio::buffer("dataend"));
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+
+                // Send dataend marker
+                boost::asio::write(socket_, boost::asio::buffer("dataend"));
+            }
         }
         catch (const std::exception &ex)
         {
@@ -119,8 +172,5 @@ void ImageSocketClient::sendImages()
             // Print or log the error message
             std::cerr << "Send error: " << ex.what() << std::endl;
         }
-
-        // Reset the current image
-        currentImage_.release();
     }
 }
@@ -8,6 +8,7 @@
 #include <condition_variable>
 #include <boost/asio.hpp>
 #include <opencv2/opencv.hpp>
+#include "streamFramer.h"
 
 #define SERVER_ADDRESS "127.0.0.1"
 #define SERVER_PORT 5000
@@ -15,12 +16,21 @@
 class ImageSocketClient
 {
 public:
-    ImageSocketClient(const std::string &serverAddress, int serverPort);
+    // LengthPrefixed: each frame is one write of a streamFramer.h header and
+    // the JPEG, no pauses. Markers: datastart/JPEG/dataend with 200 us pauses,
+    // for servers older than the length-prefixed mode.
+    enum class Framing { LengthPrefixed, Markers };
+
+    ImageSocketClient(const std::string &serverAddress, int serverPort, Framing framing = Framing::LengthPrefixed);
     ~ImageSocketClient();
 
     bool connect();
     void disconnect();
+    // Queue `image` for sending, replacing one not sent yet. The const&
+    // overload copies the pixels; pass an rvalue to hand the Mat over
+    // without a copy.
     bool setImage(const cv::Mat &image);
+    bool setImage(cv::Mat &&image);
 
 private:
     void sendImages();
@@ -32,7 +42,10 @@ private:
     std::thread receiveThread_;
     std::mutex mutex_;
     std::condition_variable cv_;
-    cv::Mat currentImage_;
+    cv::Mat currentImage_; // latest from setImage(), guarded by mutex_
+    cv::Mat sendingImage_; // taken by the sending thread, encoded without the lock
+    std::vector<uchar> encodeBuffer_;
+    Framing framing_;
     bool connected_;
 };
 
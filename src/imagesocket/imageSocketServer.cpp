@@ -1,5 +1,8 @@
 #include "imageSocketServer.h"
 #include <QDebug>
+#include "network/imagepool.h"
+#include "network/jpegcodec.h"
+#include "network/pixelswizzle.h"
 
 ImageSocketServer::ImageSocketServer(QObject* parent)
     : QObject(parent), QQuickImageProvider(QQuickImageProvider::Image)
@@ -13,6 +16,8 @@ ImageSocketServer::ImageSocketServer(QObject* parent)
     connect(server, &QTcpServer::newConnection, this, &ImageSocketServer::handleNewConnection);
     connect(server, &QTcpServer::acceptError, this, &ImageSocketServer::handleError);
 
+    readBuffer.resize(64 * 1024);
+
     server->setMaxPendingConnections(1);
     server->close();
 }
@@ -78,6 +83,7 @@ void ImageSocketServer::handleNewConnection()
 
     server->pauseAccepting();
     waitToClose = false;
+    framer.reset();
 
     connect(clientSocket, &QTcpSocket::readyRead, this, &ImageSocketServer::readData);
     connect(clientSocket, &QTcpSocket::disconnected, clientSocket, &QTcpSocket::deleteLater);
@@ -95,38 +101,48 @@ void ImageSocketServer::readData()
     if(waitToClose)
     {
         closeConnection(clientSocket);
-    }
-
-    QByteArray dataRead = clientSocket->readAll();
-    bool tryDecode = false;
-
-    //Reset the image data when receive datastart
-    if (dataRead.startsWith("datastart")) {
-        imageData.clear();
         return;
     }
-    if (dataRead.startsWith("dataend")) {
-        tryDecode = true;
-    }
-    else
+
+    // Length-prefixed or datastart/dataend, told from the first bytes; frames
+    // may span reads or share one, the framer sorts that out
+    qint64 read;
+    while ((read = clientSocket->read(readBuffer.data(), static_cast<qint64>(readBuffer.size()))) > 0)
     {
-        imageData.append(dataRead);
+        const bool ok = framer.feed(reinterpret_cast<const uchar*>(readBuffer.data()), static_cast<size_t>(read),
+                                    [this](const uchar* data, size_t size) { decodeFrame(data, size); });
+        if (!ok)
+        {
+            emit updateLabel("Error: corrupt image stream");
+            closeConnection(clientSocket);
+            return;
+        }
     }
+}
 
-    if(!tryDecode) {
+void ImageSocketServer::decodeFrame(const uchar* data, size_t size)
+{
+    if (size == 0)
         return;
-    }
 
-    cv::Mat frame = cv::imdecode(cv::Mat(imageData.size(), 1, CV_8UC1, imageData.data()), cv::IMREAD_COLOR);
-
-    if (!frame.empty())
+    // The payload is decoded where it lies, no copy into a QByteArray, straight
+    // into pooled Format_RGB32 storage the image owns a share of (ImagePool):
+    // no colour conversion, no copy, nothing left pointing at freed pixels
+    QImage decoded;
+    if (!JpegCodec::forCurrentThread().decode(data, static_cast<int>(size), decoded))
     {
-        cv::cvtColor(frame, frame, cv::COLOR_BGR2RGB);  // Convert the frame to RGB format
-        QImage image(frame.data, frame.cols, frame.rows, frame.step, QImage::Format_RGB888);
-
-        this->image = image;
-        emit imageChanged();
+        // Not a JPEG (PNG, BMP): OpenCV decodes to BGR, widened into the same layout
+        const cv::Mat frame = cv::imdecode(cv::Mat(1, static_cast<int>(size), CV_8UC1, const_cast<uchar*>(data)),
+                                           cv::IMREAD_COLOR);
+        if (frame.empty())
+            return;
+        decoded = ImagePool::shared().acquire(frame.cols, frame.rows);
+        if (decoded.isNull())
+            return;
+        bgrToRgb32(frame.data, static_cast<int>(frame.step), decoded.bits(), decoded.bytesPerLine(), frame.cols, frame.rows);
     }
+    this->image = decoded;
+    emit imageChanged();
 }
 
 void ImageSocketServer::handleError(QAbstractSocket::SocketError error)
@@ -151,11 +167,7 @@ QImage ImageSocketServer::requestImage(const QString& id, QSize* size, const QSi
         *size = result.size();
     }
 
-    if(requestedSize.width() > 0 && requestedSize.height() > 0) {
-        result = result.scaled(requestedSize.width(), requestedSize.height(), Qt::KeepAspectRatio);
-    }
-
-    return result;
+    return scaledImage.scaled(result, requestedSize);
 }
 
 /*
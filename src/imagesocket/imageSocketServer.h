@@ -7,6 +7,9 @@
 #include <QTimer>
 #include <QQuickImageProvider>
 #include <opencv2/opencv.hpp>
+#include <vector>
+#include "streamFramer.h"
+#include "network/scaledimagecache.h"
 
 #define SOCKET_ADD "127.0.0.1"
 #define SOCKET_PORT 5000
@@ -31,6 +34,9 @@ private slots:
     void handleError(QAbstractSocket::SocketError error);
     void closeConnection(QTcpSocket *clientSocket);
 
+private:
+    void decodeFrame(const uchar* data, size_t size);
+
 public slots:
     void startVideo(); //Start to listen clients
     void stopVideo(); //Stop listen clients
@@ -39,11 +45,13 @@ public slots:
 private:
     QTcpServer* server;
     QTimer* reconnectTimer_;
-    QByteArray imageData;
+    StreamFramer framer; // one connection at a time, reset for each
+    std::vector<char> readBuffer; // socket reads land here, reused
     bool waitToClose = false;
 
     QImage image;
     QImage no_image;
+    ScaledImageCache scaledImage; // last scaled result, reused until the image or size changes
 };
 
 #endif
@@ -0,0 +1,226 @@
+#ifndef STREAM_FRAMER_H
+#define STREAM_FRAMER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Framing of the legacy raw-TCP image stream (ImageSocketServer /
+// ImageSocketClient). Two modes, told apart by the first bytes a connection
+// sends:
+//
+//   length-prefixed   "ISLF", payload size (uint32 little-endian), payload;
+//                     repeated. Nothing to scan for, no pause needed between
+//                     frames, so producers can write at line rate.
+//   markers           "datastart", payload, "dataend" (each marker possibly
+//                     followed by its NUL, as the old client sends them). Kept
+//                     for existing producers; a payload containing "dataend"
+//                     is cut short, which is why the prefix mode exists.
+//
+// The parser is incremental: chunks may split a header, a marker or a
+// payload anywhere, or hold several frames. Bytes are gathered in one buffer
+// reserved up front and reused for every frame; a payload that arrives whole
+// in a single chunk is handed out in place without being copied at all.
+const std::size_t kStreamFrameHeaderSize = 8;
+const std::uint8_t kStreamFrameMagic[4] = {'I', 'S', 'L', 'F'};
+// Larger declared sizes are treated as a corrupt stream
+const std::size_t kStreamFrameMaxSize = 64u * 1024 * 1024;
+
+// Write the kStreamFrameHeaderSize bytes ahead of a payload of `size` bytes
+inline void writeStreamFrameHeader(std::uint32_t size, std::uint8_t* out)
+{
+    std::memcpy(out, kStreamFrameMagic, sizeof(kStreamFrameMagic));
+    for (int i = 0; i < 4; ++i)
+        out[4 + i] = static_cast<std::uint8_t>((size >> (8 * i)) & 0xFF);
+}
+
+namespace streamframer_detail {
+const char kStart[] = "datastart";
+const char kEnd[] = "dataend";
+const std::size_t kStartSize = sizeof(kStart) - 1;
+const std::size_t kEndSize = sizeof(kEnd) - 1;
+const std::size_t npos = static_cast<std::size_t>(-1);
+} // namespace streamframer_detail
+
+class StreamFramer
+{
+public:
+    enum class Mode { Detect, LengthPrefixed, Markers };
+
+    explicit StreamFramer(std::size_t maxFrameSize = kStreamFrameMaxSize,
+                          std::size_t initialCapacity = 512 * 1024)
+        : m_maxFrameSize(maxFrameSize)
+    {
+        m_buffer.reserve(initialCapacity);
+    }
+
+    // Consume a chunk, calling onFrame(const std::uint8_t* data, std::size_t
+    // size) for every complete payload; the pointer is valid during the call
+    // only. False once the stream is corrupt (oversized frame, bad magic); the
+    // connection should be closed, later chunks are ignored until reset().
+    template <typename OnFrame>
+    bool feed(const std::uint8_t* data, std::size_t size, OnFrame&& onFrame)
+    {
+        while (size > 0 && !m_failed) {
+            std::size_t used = 0;
+            switch (m_mode) {
+            case Mode::Detect:
+                used = detect(data, size);
+                break;
+            case Mode::LengthPrefixed:
+                used = feedLength(data, size, onFrame);
+                break;
+            case Mode::Markers:
+                used = feedMarkers(data, size, onFrame);
+                break;
+            }
+            data += used;
+            size -= used;
+        }
+        return !m_failed;
+    }
+
+    // Forget any partial frame and detect the mode again (new connection)
+    void reset()
+    {
+        m_mode = Mode::Detect;
+        m_failed = false;
+        m_headerFill = 0;
+        m_expected = 0;
+        m_inFrame = false;
+        m_scanned = 0;
+        m_buffer.clear();
+    }
+
+    Mode mode() const { return m_mode; }
+    bool failed() const { return m_failed; }
+    // Bytes held for a frame not complete yet
+    std::size_t pending() const { return m_buffer.size() + m_headerFill; }
+    std::size_t capacity() const { return m_buffer.capacity(); }
+
+private:
+    std::size_t detect(const std::uint8_t* data, std::size_t size)
+    {
+        // The magic goes through the header bytes, so nothing is lost either way
+        const std::size_t take = std::min(sizeof(kStreamFrameMagic) - m_headerFill, size);
+        std::memcpy(m_header + m_headerFill, data, take);
+        m_headerFill += take;
+        if (std::memcmp(m_header, kStreamFrameMagic, m_headerFill) != 0) {
+            m_mode = Mode::Markers;
+            m_buffer.assign(m_header, m_header + m_headerFill);
+            m_headerFill = 0;
+        } else if (m_headerFill == sizeof(kStreamFrameMagic)) {
+            m_mode = Mode::LengthPrefixed;
+        }
+        return take;
+    }
+
+    template <typename OnFrame>
+    std::size_t feedLength(const std::uint8_t* data, std::size_t size, OnFrame& onFrame)
+    {
+        if (m_headerFill < kStreamFrameHeaderSize) {
+            const std::size_t take = std::min(kStreamFrameHeaderSize - m_headerFill, size);
+            std::memcpy(m_header + m_headerFill, data, take);
+            m_headerFill += take;
+            if (m_headerFill < kStreamFrameHeaderSize)
+                return take;
+            if (std::memcmp(m_header, kStreamFrameMagic, sizeof(kStreamFrameMagic)) != 0) {
+                m_failed = true;
+                return take;
+            }
+            m_expected = 0;
+            for (int i = 3; i >= 0; --i)
+                m_expected = (m_expected << 8) | m_header[4 + i];
+            if (m_expected > m_maxFrameSize) {
+                m_failed = true;
+                return take;
+            }
+            if (m_expected == 0) {
+                onFrame(m_buffer.data(), std::size_t(0));
+                m_headerFill = 0;
+            }
+            return take;
+        }
+
+        // Whole payload in this chunk and nothing gathered: hand it out in place
+        if (m_buffer.empty() && size >= m_expected) {
+            onFrame(data, m_expected);
+            m_headerFill = 0;
+            return m_expected;
+        }
+        const std::size_t take = std::min(m_expected - m_buffer.size(), size);
+        m_buffer.insert(m_buffer.end(), data, data + take);
+        if (m_buffer.size() == m_expected) {
+            onFrame(m_buffer.data(), m_buffer.size());
+            m_buffer.clear();
+            m_headerFill = 0;
+        }
+        return take;
+    }
+
+    template <typename OnFrame>
+    std::size_t feedMarkers(const std::uint8_t* data, std::size_t size, OnFrame& onFrame)
+    {
+        using namespace streamframer_detail;
+        m_buffer.insert(m_buffer.end(), data, data + size);
+        std::size_t begin = 0; // start of what is still unparsed in m_buffer
+        for (;;) {
+            if (!m_inFrame) {
+                const std::size_t start = find(kStart, kStartSize, begin);
+                if (start == npos) {
+                    // Keep a possible marker prefix, drop what precedes it
+                    begin = std::max(begin, m_buffer.size() - std::min(m_buffer.size(), kStartSize - 1));
+                    break;
+                }
+                begin = start + kStartSize;
+                m_inFrame = true;
+                m_scanned = begin;
+            }
+            const std::size_t end = find(kEnd, kEndSize, m_scanned);
+            if (end == npos) {
+                // A marker split over chunks is found from here on the next call
+                m_scanned = std::max(m_scanned, m_buffer.size() - std::min(m_buffer.size(), kEndSize - 1));
+                if (m_buffer.size() - begin > m_maxFrameSize)
+                    m_failed = true;
+                break;
+            }
+            // The NUL the old client sends after "datastart" is not JPEG data
+            std::size_t payload = begin;
+            if (payload < end && m_buffer[payload] == 0)
+                ++payload;
+            onFrame(m_buffer.data() + payload, end - payload);
+            begin = end + kEndSize;
+            m_inFrame = false;
+        }
+        // Move the unparsed tail to the front; the capacity stays
+        m_buffer.erase(m_buffer.begin(), m_buffer.begin() + static_cast<std::ptrdiff_t>(begin));
+        if (m_inFrame)
+            m_scanned -= std::min(m_scanned, begin);
+        return size;
+    }
+
+    std::size_t find(const char* marker, std::size_t markerSize, std::size_t from) const
+    {
+        using streamframer_detail::npos;
+        if (m_buffer.size() < markerSize || from > m_buffer.size() - markerSize)
+            return npos;
+        const auto first = m_buffer.begin() + static_cast<std::ptrdiff_t>(from);
+        const auto it = std::search(first, m_buffer.end(), marker, marker + markerSize,
+                                    [](std::uint8_t a, char b) { return a == static_cast<std::uint8_t>(b); });
+        return it == m_buffer.end() ? npos : static_cast<std::size_t>(it - m_buffer.begin());
+    }
+
+    std::size_t m_maxFrameSize;
+    Mode m_mode = Mode::Detect;
+    bool m_failed = false;
+    std::uint8_t m_header[kStreamFrameHeaderSize] = {};
+    std::size_t m_headerFill = 0;
+    std::size_t m_expected = 0; // length-prefixed: payload size of the current frame
+    bool m_inFrame = false;     // markers: "datastart" seen
+    std::size_t m_scanned = 0;  // markers: where the search for "dataend" resumes
+    std::vector<std::uint8_t> m_buffer;
+};
+
+#endif // STREAM_FRAMER_H
@@ -0,0 +1,78 @@
+#ifndef ACCEPTPACER_H
+#define ACCEPTPACER_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// Paces new connections after a restart or failover, when a whole fleet of
+// cameras reconnects at once. A token bucket admits `perSecond` connections
+// (up to `burst` at once after a quiet spell); a connection over the rate is
+// told when to come back (RETRY_AFTER) instead of going through HELLO,
+// session setup and decoding.
+//
+// Each refused connection gets a slot of its own, one refill interval after
+// the previous one's, so the refused clients come back spread out at the rate
+// the bucket refills and find a token waiting: N clients are all admitted
+// within about N / perSecond seconds, however they arrived. Clients that
+// return early get a new slot.
+//
+// Not thread-safe; times are milliseconds on any monotonic clock.
+class AcceptPacer
+{
+public:
+    // perSecond 0: every connection is admitted. burst 0: one second's worth.
+    void configure(double perSecond, int burst = 0)
+    {
+        m_perSecond = std::max(0.0, perSecond);
+        m_burst = burst > 0 ? burst : std::max(1.0, std::ceil(m_perSecond));
+        m_tokens = m_burst;
+        m_lastMs = -1;
+        m_nextSlotMs = 0;
+    }
+
+    bool enabled() const { return m_perSecond > 0.0; }
+    double perSecond() const { return m_perSecond; }
+    double burst() const { return m_burst; }
+
+    // A connection arriving at `nowMs`: 0 if it is admitted, otherwise how
+    // many ms it should wait before trying again (at least 1)
+    std::int64_t admit(std::int64_t nowMs)
+    {
+        if (!enabled())
+            return 0;
+        refill(nowMs);
+        if (m_tokens >= 1.0) {
+            m_tokens -= 1.0;
+            return 0;
+        }
+        const double intervalMs = 1000.0 / m_perSecond;
+        // The earliest time the bucket holds a token, or after the last slot given out
+        const double tokenAtMs = static_cast<double>(nowMs) + (1.0 - m_tokens) * intervalMs;
+        const double slotMs = std::max(m_nextSlotMs, tokenAtMs);
+        m_nextSlotMs = slotMs + intervalMs;
+        ++m_deferred;
+        return std::max<std::int64_t>(1, static_cast<std::int64_t>(std::ceil(slotMs - static_cast<double>(nowMs))));
+    }
+
+    // Connections told to come back later, since configure()
+    std::uint64_t deferred() const { return m_deferred; }
+
+private:
+    void refill(std::int64_t nowMs)
+    {
+        if (m_lastMs >= 0 && nowMs > m_lastMs)
+            m_tokens = std::min(m_burst, m_tokens + static_cast<double>(nowMs - m_lastMs) * m_perSecond / 1000.0);
+        if (m_lastMs < 0 || nowMs > m_lastMs)
+            m_lastMs = nowMs;
+    }
+
+    double m_perSecond = 0.0;
+    double m_burst = 1.0;
+    double m_tokens = 1.0;
+    std::int64_t m_lastMs = -1;
+    double m_nextSlotMs = 0.0;
+    std::uint64_t m_deferred = 0;
+};
+
+#endif // ACCEPTPACER_H
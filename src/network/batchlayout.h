@@ -0,0 +1,85 @@
+#ifndef BATCHLAYOUT_H
+#define BATCHLAYOUT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Memory layout of a batch of RGB images handed to inference processors as
+// one contiguous tensor: N images of H x W, 3 channels, 8 bits each.
+//   NHWC: per image, rows of interleaved R,G,B
+//   NCHW: per image, an R plane, then G, then B (planar)
+// Rows start on `alignment`-byte boundaries (the padding is zero), planes and
+// images follow each other, so every image and plane is aligned too.
+enum class BatchLayout {
+    NHWC,
+    NCHW
+};
+
+struct BatchGeometry {
+    static const int kChannels = 3;
+
+    BatchLayout layout = BatchLayout::NHWC;
+    int width = 0;
+    int height = 0;
+    std::size_t rowStride = 0;   // bytes per row (per plane row for NCHW)
+    std::size_t planeStride = 0; // NCHW: bytes per channel plane; NHWC: same as imageStride
+    std::size_t imageStride = 0; // bytes per image
+
+    // `alignment` must be a power of two
+    static BatchGeometry make(int width, int height, BatchLayout layout, std::size_t alignment = 64)
+    {
+        BatchGeometry geometry;
+        geometry.layout = layout;
+        geometry.width = width > 0 ? width : 0;
+        geometry.height = height > 0 ? height : 0;
+        const std::size_t rowBytes = static_cast<std::size_t>(geometry.width)
+            * (layout == BatchLayout::NHWC ? kChannels : 1);
+        geometry.rowStride = alignUp(rowBytes, alignment);
+        geometry.planeStride = geometry.rowStride * static_cast<std::size_t>(geometry.height);
+        geometry.imageStride = layout == BatchLayout::NHWC ? geometry.planeStride : geometry.planeStride * kChannels;
+        return geometry;
+    }
+
+    std::size_t bytesFor(int count) const { return imageStride * static_cast<std::size_t>(count > 0 ? count : 0); }
+
+    static std::size_t alignUp(std::size_t value, std::size_t alignment)
+    {
+        return alignment > 1 ? (value + alignment - 1) & ~(alignment - 1) : value;
+    }
+};
+
+// Pack one image of 32-bit 0xAARRGGBB pixels (QImage::Format_RGB32, native
+// byte order) of geometry.width x geometry.height into `dst`, the start of its
+// slot in the batch. Padding bytes are cleared.
+inline void packRgb32(const std::uint8_t* src, std::size_t srcStride, const BatchGeometry& geometry, std::uint8_t* dst)
+{
+    std::memset(dst, 0, geometry.imageStride);
+    for (int y = 0; y < geometry.height; ++y) {
+        const std::uint8_t* srcRow = src + static_cast<std::size_t>(y) * srcStride;
+        if (geometry.layout == BatchLayout::NHWC) {
+            std::uint8_t* out = dst + static_cast<std::size_t>(y) * geometry.rowStride;
+            for (int x = 0; x < geometry.width; ++x) {
+                std::uint32_t pixel;
+                std::memcpy(&pixel, srcRow + static_cast<std::size_t>(x) * 4, sizeof(pixel));
+                *out++ = static_cast<std::uint8_t>(pixel >> 16);
+                *out++ = static_cast<std::uint8_t>(pixel >> 8);
+                *out++ = static_cast<std::uint8_t>(pixel);
+            }
+        } else {
+            const std::size_t rowOffset = static_cast<std::size_t>(y) * geometry.rowStride;
+            std::uint8_t* r = dst + rowOffset;
+            std::uint8_t* g = r + geometry.planeStride;
+            std::uint8_t* b = g + geometry.planeStride;
+            for (int x = 0; x < geometry.width; ++x) {
+                std::uint32_t pixel;
+                std::memcpy(&pixel, srcRow + static_cast<std::size_t>(x) * 4, sizeof(pixel));
+                r[x] = static_cast<std::uint8_t>(pixel >> 16);
+                g[x] = static_cast<std::uint8_t>(pixel >> 8);
+                b[x] = static_cast<std::uint8_t>(pixel);
+            }
+        }
+    }
+}
+
+#endif // BATCHLAYOUT_H
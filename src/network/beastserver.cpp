@@ -0,0 +1,692 @@
+#include "beastserver.h"
+#include <boost/asio.hpp>
+#include <boost/beast.hpp>
+#include <QDebug>
+#include <QMutexLocker>
+#include <QUuid>
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include "frametrace.h"
+#include "imagepool.h"
+#include "inboundparser.h"
+#include "relayqueue.h"
+#include "shmframering.h"
+#include "streamingjpeg.h"
+#include "threadroles.h"
+#include "tlsstream.h"
+
+namespace asio = boost::asio;
+namespace beast = boost::beast;
+namespace websocket = beast::websocket;
+using tcp = asio::ip::tcp;
+
+namespace {
+// First read buffer of a session; later ones are sized from the previous message
+const int kInitialReadBytes = 64 * 1024;
+// A TLS client that hasn't finished its handshake by then is dropped
+const int kTlsHandshakeMs = 10000;
+} // namespace
+
+struct BeastServer::Impl {
+    using WorkGuard = asio::executor_work_guard<asio::io_context::executor_type>;
+
+    std::vector<std::unique_ptr<asio::io_context>> contexts;
+    std::vector<WorkGuard> work; // keeps idle threads running until stop()
+    std::vector<std::thread> threads;
+    std::unique_ptr<tcp::acceptor> acceptor; // on contexts[0]
+    std::size_t nextContext = 0;             // round-robin, accept handler only
+};
+
+// One client connection. Lives on the io_context it was accepted onto and is
+// only touched from that context's thread (a single-threaded context is an
+// implicit strand); other threads post to it.
+class BeastSession : public std::enable_shared_from_this<BeastSession>
+{
+public:
+    BeastSession(BeastServer* server, tcp::socket&& socket)
+        : m_server(server), m_ws(std::move(socket), server->m_tls), m_id(QUuid::createUuid().toString()), m_parser(m_id)
+    {
+        if (m_server->m_memory)
+            m_parser.setMemoryAccount(m_server->m_memory->openAccount(m_id.toStdString()));
+    }
+
+    const QString& id() const { return m_id; }
+
+    void run()
+    {
+        asio::dispatch(m_ws.get_executor(), [self = shared_from_this()]() { self->onRun(); });
+    }
+
+    // `message` carries its prefix byte
+    void send(const QByteArray& message)
+    {
+        asio::post(m_ws.get_executor(), [self = shared_from_this(), message]() { self->queueWrite(message); });
+    }
+
+    // Viewer session: relayed frames queue up to `depth`, then `policy` applies
+    void startRelay(std::size_t depth, OutboundDropPolicy policy)
+    {
+        asio::post(m_ws.get_executor(), [self = shared_from_this(), depth, policy]() {
+            self->m_relaying = true;
+            self->m_writeQueue.configure(depth, policy);
+        });
+    }
+
+    // Another client's frame message, forwarded as received
+    void relay(const QByteArray& message, RelayFrameKind kind)
+    {
+        asio::post(m_ws.get_executor(), [self = shared_from_this(), message, kind]() {
+            if (!self->m_open || !self->m_relaying)
+                return;
+            if (self->m_writeQueue.pushFrame(message, kind))
+                self->doWrite();
+        });
+    }
+
+    // Same-host client: read its frames from the shared-memory ring `ringName` as well
+    void attachSharedMemory(const std::string& ringName)
+    {
+        asio::post(m_ws.get_executor(), [self = shared_from_this(), ringName]() { self->onAttachSharedMemory(ringName); });
+    }
+
+    void setStreamingDecode(bool enabled, const QSize& target)
+    {
+        asio::post(m_ws.get_executor(), [self = shared_from_this(), enabled, target]() {
+            self->m_streamDecode = enabled && StreamingJpegDecoder::available();
+            self->m_decodeTarget = target;
+        });
+    }
+
+    // Drop the connection; pending operations fail and finish() reports it
+    void shutdown()
+    {
+        asio::post(m_ws.get_executor(), [self = shared_from_this()]() {
+            beast::error_code ignored;
+            beast::get_lowest_layer(self->m_ws).socket().shutdown(tcp::socket::shutdown_both, ignored);
+            beast::get_lowest_layer(self->m_ws).socket().close(ignored);
+        });
+    }
+
+private:
+    void onRun()
+    {
+        beast::error_code ignored;
+        beast::get_lowest_layer(m_ws).socket().set_option(tcp::no_delay(true), ignored);
+        // Beast pings a quiet client after half the keepalive timeout and
+        // drops it once all of it passed without hearing from it
+        auto timeout = websocket::stream_base::timeout::suggested(beast::role_type::server);
+        const std::int64_t idleMs = m_server->m_keepaliveTimeoutMs.load(std::memory_order_relaxed);
+        if (idleMs > 0) {
+            timeout.idle_timeout = std::chrono::milliseconds(idleMs);
+            timeout.keep_alive_pings = true;
+        }
+        m_ws.set_option(timeout);
+        m_ws.set_option(websocket::stream_base::decorator([](websocket::response_type& response) {
+            response.set(beast::http::field::server, "ImageSocketServer");
+        }));
+        m_ws.read_message_max(m_server->m_maxMessageBytes.load(std::memory_order_relaxed));
+        m_ws.auto_fragment(false);
+        m_ws.binary(true);
+        if (!m_ws.next_layer().secure()) {
+            m_ws.async_accept([self = shared_from_this()](beast::error_code ec) { self->onHandshake(ec); });
+            return;
+        }
+
+        // TLS first; the WebSocket timeouts only cover the WebSocket handshake
+        m_handshakeTimer.expires_after(std::chrono::milliseconds(kTlsHandshakeMs));
+        m_handshakeTimer.async_wait([self = shared_from_this()](beast::error_code ec) {
+            if (ec)
+                return; // handshake done first
+            beast::error_code ignored;
+            beast::get_lowest_layer(self->m_ws).socket().close(ignored);
+        });
+        m_ws.next_layer().async_handshake([self = shared_from_this()](beast::error_code ec) {
+            self->m_handshakeTimer.cancel();
+            if (ec) {
+                self->finish(ec);
+                return;
+            }
+            const TlsStream& tls = self->m_ws.next_layer();
+            qDebug() << "Beast session" << self->m_id << QString::fromStdString(tls.protocol())
+                     << QString::fromStdString(tls.cipher()) << (tls.resumed() ? "resumed" : "full handshake")
+                     << "kTLS send" << tls.kernelSend() << "receive" << tls.kernelReceive();
+            self->m_ws.async_accept([self](beast::error_code ec) { self->onHandshake(ec); });
+        });
+    }
+
+    void onHandshake(beast::error_code ec)
+    {
+        if (ec) {
+            finish(ec);
+            return;
+        }
+        beast::error_code endpointError;
+        const tcp::endpoint peer = beast::get_lowest_layer(m_ws).socket().remote_endpoint(endpointError);
+        const QHostAddress address = endpointError
+            ? QHostAddress() : QHostAddress(QString::fromStdString(peer.address().to_string()));
+
+        m_open = true;
+        m_server->opened(m_id, address);
+        readMessage();
+    }
+
+    void readMessage()
+    {
+        // A fresh buffer per message: the EncodedFrame handed out keeps the previous one
+        m_message = QByteArray(m_expectedBytes, Qt::Uninitialized);
+        m_received = 0;
+        m_jpegState = JpegState::Idle;
+        readSome();
+    }
+
+    void readSome()
+    {
+        if (m_received == m_message.size())
+            m_message.resize(m_message.size() * 2);
+        m_ws.async_read_some(asio::buffer(m_message.data() + m_received,
+                                          static_cast<std::size_t>(m_message.size() - m_received)),
+                             [self = shared_from_this()](beast::error_code ec, std::size_t bytes) {
+                                 self->onRead(ec, bytes);
+                             });
+    }
+
+    void onRead(beast::error_code ec, std::size_t bytes)
+    {
+        if (ec) {
+            finish(ec);
+            return;
+        }
+        m_received += static_cast<int>(bytes);
+        if (!m_ws.is_message_done()) {
+            decodeArrived(false);
+            readSome();
+            return;
+        }
+        if (!m_ws.got_binary()) {
+            readMessage(); // text messages are not part of the protocol
+            return;
+        }
+
+        // Shrinking keeps the allocation; the next buffer fits a similar message in one piece
+        m_message.resize(m_received);
+        m_expectedBytes = std::max(kInitialReadBytes, m_received + m_received / 8);
+        dispatch(m_message, decodeArrived(true));
+        m_message = QByteArray();
+        readMessage();
+    }
+
+    // Feed a JPEG frame's bytes received so far to the streaming decoder, so
+    // decoding overlaps its transfer. Starts with the first read that leaves a
+    // message unfinished: smaller frames are decoded once complete as before.
+    // Returns the picture once `complete` finished it.
+    QImage decodeArrived(bool complete)
+    {
+        if (m_jpegState == JpegState::Idle) {
+            if (complete || !m_streamDecode || !m_ws.got_binary())
+                return QImage();
+            const int offset = jpegPayloadOffset();
+            if (offset < 0) {
+                m_jpegState = JpegState::Skipped;
+                return QImage();
+            }
+            m_jpegOffset = offset;
+            m_jpegState = JpegState::Decoding;
+            m_jpeg.begin(m_decodeTarget.width(), m_decodeTarget.height(),
+                         [this](int width, int height, std::size_t& stride) -> std::uint8_t* {
+                             m_decoded = ImagePool::shared().acquire(width, height);
+                             if (m_decoded.isNull())
+                                 return nullptr;
+                             stride = static_cast<std::size_t>(m_decoded.bytesPerLine());
+                             return m_decoded.bits();
+                         });
+        }
+        if (m_jpegState != JpegState::Decoding)
+            return QImage();
+
+        FrameTraceScope trace("stream decode", "server");
+        const auto* data = reinterpret_cast<const std::uint8_t*>(m_message.constData()) + m_jpegOffset;
+        const StreamingJpegDecoder::Status status =
+            m_jpeg.feed(data, static_cast<std::size_t>(m_received - m_jpegOffset), complete);
+        if (status == StreamingJpegDecoder::Status::NeedData)
+            return QImage();
+        m_jpegState = JpegState::Skipped;
+        QImage decoded;
+        decoded.swap(m_decoded);
+        return status == StreamingJpegDecoder::Status::Done ? decoded : QImage();
+    }
+
+    // Where the JPEG starts in the message read so far (prefix 0x00, a framed
+    // JPEG of stream 0, or a bare one); -1 for anything else
+    int jpegPayloadOffset() const
+    {
+        if (m_received < 2)
+            return -1;
+        const auto* data = reinterpret_cast<const std::uint8_t*>(m_message.constData());
+        if (data[0] == 0x04) {
+            FrameHeader header;
+            std::size_t headerSize = 0;
+            if (!parseFrameHeader(data + 1, static_cast<std::size_t>(m_received - 1), header, headerSize)
+                || header.payload != FramePayload::Jpeg || header.streamId != 0)
+                return -1;
+            return 1 + static_cast<int>(headerSize);
+        }
+        if (data[0] == 0x00)
+            return 1;
+        return data[0] == 0xFF && data[1] == 0xD8 ? 0 : -1;
+    }
+
+    void dispatch(const QByteArray& message, const QImage& decoded = QImage())
+    {
+        FrameTraceScope trace("socket read", "server");
+        EncodedFrame frame;
+        ControlMessages control;
+        const qint64 decodedBytes = static_cast<qint64>(decoded.bytesPerLine()) * decoded.height();
+        switch (m_parser.parse(message, frame, control, decodedBytes)) {
+        case InboundParser::Control:
+            for (const ControlMessagePtr& msg : control)
+                emit m_server->controlMessageReceived(m_id, msg);
+            break;
+        case InboundParser::Frame: {
+            trace.setFrame(frame.timing().sequence);
+            if (frame.format == EncodedFrame::Jpeg)
+                frame.decoded = decoded;
+            FrameTraceScope dispatch("dispatch", "server", frame.timing().sequence);
+            emit m_server->encodedFrameReceived(m_id, frame);
+            break;
+        }
+        case InboundParser::Refused:
+            emit m_server->frameRefused(m_id, m_parser.lastRefusal().streamId, m_parser.lastRefusal().keyframeNeeded);
+            break;
+        case InboundParser::Invalid:
+            break;
+        }
+    }
+
+    void onAttachSharedMemory(const std::string& ringName)
+    {
+        if (!m_open || m_shmRing.isOpen())
+            return;
+#ifdef BOOST_ASIO_HAS_POSIX_STREAM_DESCRIPTOR
+        // The doorbell first: the client may ring it as soon as the ring is mapped
+        if (!m_shmDoorbell.listen(ringName) || !m_shmRing.open(ringName)) {
+            qWarning() << "Beast session" << m_id << "shared memory ring" << QString::fromStdString(ringName) << "unusable:"
+                       << QString::fromStdString(m_shmDoorbell.isOpen() ? m_shmRing.errorString() : m_shmDoorbell.errorString());
+            m_shmDoorbell.close();
+            return;
+        }
+        beast::error_code ec;
+        m_shmWait.assign(::dup(m_shmDoorbell.fd()), ec);
+        if (ec) {
+            m_shmRing.close();
+            m_shmDoorbell.close();
+            return;
+        }
+        qInfo() << "Beast session" << m_id << "reads frames from shared memory" << QString::fromStdString(ringName);
+        readSharedMemory();
+#else
+        Q_UNUSED(ringName);
+#endif
+    }
+
+#ifdef BOOST_ASIO_HAS_POSIX_STREAM_DESCRIPTOR
+    void readSharedMemory()
+    {
+        if (!m_open)
+            return;
+        m_shmDoorbell.drain();
+        // One ring's worth per turn: the context's other sessions get their turn in between
+        for (std::uint32_t i = 0; i < m_shmRing.slotCount(); ++i) {
+            const bool read = m_shmRing.read([this](const std::uint8_t* data, std::size_t size) {
+                dispatch(QByteArray(reinterpret_cast<const char*>(data), static_cast<int>(size)));
+            });
+            if (!read)
+                break;
+        }
+        if (!m_shmRing.prepareToWait()) {
+            asio::post(m_ws.get_executor(), [self = shared_from_this()]() { self->readSharedMemory(); });
+            return;
+        }
+        m_shmWait.async_wait(asio::posix::stream_descriptor::wait_read, [self = shared_from_this()](beast::error_code ec) {
+            if (!ec)
+                self->readSharedMemory();
+        });
+    }
+#endif
+
+    void queueWrite(const QByteArray& message)
+    {
+        if (!m_open)
+            return;
+        m_writeQueue.pushControl(message);
+        doWrite();
+    }
+
+    // Starts the next write unless one is in flight
+    void doWrite()
+    {
+        if (m_writeQueue.writing() || m_writeQueue.empty())
+            return;
+        m_writeQueue.beginWrite();
+        const QByteArray& front = m_writeQueue.front();
+        m_ws.async_write(asio::buffer(front.constData(), static_cast<std::size_t>(front.size())),
+                         [self = shared_from_this()](beast::error_code ec, std::size_t) {
+                             if (ec) {
+                                 self->finish(ec);
+                                 return;
+                             }
+                             self->m_writeQueue.finishWrite();
+                             if (self->m_open)
+                                 self->doWrite();
+                         });
+    }
+
+    void finish(beast::error_code ec)
+    {
+        if (m_finished)
+            return;
+        m_finished = true;
+        if (ec != websocket::error::closed && ec != asio::error::operation_aborted && ec != asio::error::eof)
+            qWarning() << "Beast session" << m_id << "closed:" << QString::fromStdString(ec.message());
+
+        const bool wasOpen = m_open;
+        m_open = false; // queued writes are dropped; the one in flight still owns its buffer
+        if (m_relaying)
+            qInfo() << "Beast session" << m_id << "viewer missed" << m_writeQueue.droppedTotal() << "relayed frames";
+        beast::error_code ignored;
+        beast::get_lowest_layer(m_ws).socket().close(ignored);
+#ifdef BOOST_ASIO_HAS_POSIX_STREAM_DESCRIPTOR
+        m_shmWait.close(ignored);
+#endif
+        m_shmRing.close();
+        m_shmDoorbell.close();
+        m_server->closed(m_id, wasOpen);
+    }
+
+    BeastServer* m_server;
+    websocket::stream<TlsStream> m_ws; // plain TCP unless the server has TLS
+    asio::steady_timer m_handshakeTimer{m_ws.get_executor()};
+    QString m_id;
+    InboundParser m_parser;
+
+    QByteArray m_message;
+    int m_received = 0;
+    int m_expectedBytes = kInitialReadBytes;
+
+    // Decoding JPEG frames while they arrive (setStreamingDecode())
+    enum class JpegState { Idle, Decoding, Skipped }; // of the message being read
+    bool m_streamDecode = false;
+    QSize m_decodeTarget;
+    StreamingJpegDecoder m_jpeg;
+    JpegState m_jpegState = JpegState::Idle;
+    int m_jpegOffset = 0;
+    QImage m_decoded; // storage of the picture in progress
+    // Control messages only, unless this is a viewer: then also relayed frames
+    RelayQueue<QByteArray> m_writeQueue;
+    bool m_relaying = false;
+    ShmFrameRing m_shmRing;
+    ShmDoorbell m_shmDoorbell;
+#ifdef BOOST_ASIO_HAS_POSIX_STREAM_DESCRIPTOR
+    asio::posix::stream_descriptor m_shmWait{m_ws.get_executor()}; // a duplicate of the doorbell, for async_wait
+#endif
+    bool m_open = false;
+    bool m_finished = false;
+};
+
+const std::size_t BeastServer::kDefaultMaxMessageBytes;
+
+BeastServer::BeastServer(QObject* parent)
+    : QObject(parent), m_maxMessageBytes(kDefaultMaxMessageBytes)
+{
+}
+
+void BeastServer::setMaxSessions(int sessions)
+{
+    m_maxSessions.store(std::max(0, sessions), std::memory_order_relaxed);
+}
+
+void BeastServer::setMaxMessageBytes(std::size_t bytes)
+{
+    m_maxMessageBytes.store(bytes > 0 ? bytes : kDefaultMaxMessageBytes, std::memory_order_relaxed);
+}
+
+void BeastServer::setKeepalive(const KeepaliveConfig& config)
+{
+    m_keepaliveTimeoutMs.store(keepaliveTimeoutMs(config), std::memory_order_relaxed);
+}
+
+void BeastServer::setMemoryBudget(const std::shared_ptr<MemoryBudget>& budget)
+{
+    m_memory = budget;
+}
+
+void BeastServer::setTls(const std::shared_ptr<TlsContext>& tls)
+{
+    m_tls = tls;
+}
+
+bool BeastServer::attachSharedMemory(const QString& clientId, const QString& ringName)
+{
+    std::shared_ptr<BeastSession> session;
+    {
+        QMutexLocker lock(&m_sessionsMutex);
+        session = m_sessions.value(clientId).lock();
+    }
+    if (!session)
+        return false;
+    session->attachSharedMemory(ringName.toStdString());
+    return true;
+}
+
+bool BeastServer::startRelay(const QString& clientId, int depth, OutboundDropPolicy policy)
+{
+    std::shared_ptr<BeastSession> session;
+    {
+        QMutexLocker lock(&m_sessionsMutex);
+        session = m_sessions.value(clientId).lock();
+    }
+    if (!session)
+        return false;
+    session->startRelay(static_cast<std::size_t>(std::max(1, depth)), policy);
+    return true;
+}
+
+bool BeastServer::relayFrame(const QString& clientId, const QByteArray& message, RelayFrameKind kind)
+{
+    std::shared_ptr<BeastSession> session;
+    {
+        QMutexLocker lock(&m_sessionsMutex);
+        session = m_sessions.value(clientId).lock();
+    }
+    if (!session)
+        return false;
+    session->relay(message, kind);
+    return true;
+}
+
+bool BeastServer::setStreamingDecode(const QString& clientId, bool enabled, const QSize& target)
+{
+    std::shared_ptr<BeastSession> session;
+    {
+        QMutexLocker lock(&m_sessionsMutex);
+        session = m_sessions.value(clientId).lock();
+    }
+    if (!session)
+        return false;
+    session->setStreamingDecode(enabled, target);
+    return true;
+}
+
+bool BeastServer::closeSession(const QString& clientId)
+{
+    std::shared_ptr<BeastSession> session;
+    {
+        QMutexLocker lock(&m_sessionsMutex);
+        session = m_sessions.value(clientId).lock();
+    }
+    if (!session)
+        return false;
+    session->shutdown();
+    return true;
+}
+
+BeastServer::~BeastServer()
+{
+    stop();
+}
+
+bool BeastServer::start(quint16 port, int threads, bool reusePort)
+{
+    if (m_impl)
+        return false; // already started
+
+    std::unique_ptr<Impl> impl(new Impl);
+    threads = std::max(1, threads);
+    for (int i = 0; i < threads; ++i) {
+        impl->contexts.emplace_back(new asio::io_context(1)); // one thread per context: no internal locking
+        impl->work.emplace_back(asio::make_work_guard(*impl->contexts.back()));
+    }
+
+    beast::error_code ec;
+    const tcp::endpoint endpoint(tcp::v4(), port);
+    impl->acceptor.reset(new tcp::acceptor(*impl->contexts.front()));
+    impl->acceptor->open(endpoint.protocol(), ec);
+    if (!ec)
+        impl->acceptor->set_option(asio::socket_base::reuse_address(true), ec);
+    if (!ec && reusePort) {
+#ifdef SO_REUSEPORT
+        impl->acceptor->set_option(asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>(true), ec);
+#else
+        ec = asio::error::operation_not_supported;
+#endif
+    }
+    if (!ec)
+        impl->acceptor->bind(endpoint, ec);
+    if (!ec)
+        impl->acceptor->listen(asio::socket_base::max_listen_connections, ec);
+    if (ec) {
+        m_error = QString::fromStdString(ec.message());
+        return false;
+    }
+    m_port = impl->acceptor->local_endpoint(ec).port();
+    m_error.clear();
+
+    m_impl = std::move(impl);
+    accept();
+    for (auto& context : m_impl->contexts) {
+        asio::io_context* ioc = context.get();
+        m_impl->threads.emplace_back([ioc]() {
+            FrameTrace::setThreadName("beast io");
+            ThreadRoles::apply(ThreadRole::Io);
+            ioc->run();
+        });
+    }
+    qInfo() << "Beast WebSocket server listening on port" << m_port << "with" << threads << "I/O threads"
+            << (m_tls ? "(TLS)" : "");
+    return true;
+}
+
+void BeastServer::stop()
+{
+    if (!m_impl)
+        return;
+
+    // On the accepting thread, so no session can be added after the sweep
+    tcp::acceptor* acceptor = m_impl->acceptor.get();
+    asio::post(acceptor->get_executor(), [this, acceptor]() {
+        beast::error_code ignored;
+        acceptor->close(ignored);
+        QMutexLocker lock(&m_sessionsMutex);
+        for (const std::weak_ptr<BeastSession>& weak : qAsConst(m_sessions)) {
+            if (std::shared_ptr<BeastSession> session = weak.lock())
+                session->shutdown();
+        }
+    });
+
+    // Threads return once the closed sessions have run their last handlers
+    m_impl->work.clear();
+    for (std::thread& thread : m_impl->threads)
+        thread.join();
+    m_impl.reset();
+    m_port = 0;
+    qInfo() << "Beast WebSocket server stopped";
+}
+
+quint16 BeastServer::port() const
+{
+    return m_port;
+}
+
+QString BeastServer::errorString() const
+{
+    return m_error;
+}
+
+bool BeastServer::sendControl(const QString& clientId, const QByteArray& serialized, MessagePrefix prefix)
+{
+    std::shared_ptr<BeastSession> session;
+    {
+        QMutexLocker lock(&m_sessionsMutex);
+        session = m_sessions.value(clientId).lock();
+    }
+    if (!session)
+        return false;
+
+    QByteArray out;
+    out.reserve(serialized.size() + 1);
+    out.append(static_cast<char>(prefix));
+    out.append(serialized);
+    session->send(out);
+    return true;
+}
+
+void BeastServer::accept()
+{
+    Impl* impl = m_impl.get();
+    asio::io_context& target = *impl->contexts[impl->nextContext];
+    impl->nextContext = (impl->nextContext + 1) % impl->contexts.size();
+
+    impl->acceptor->async_accept(target, [this, impl](beast::error_code ec, tcp::socket socket) {
+        if (!impl->acceptor->is_open())
+            return; // stopped
+        const int maxSessions = m_maxSessions.load(std::memory_order_relaxed);
+        bool full = false;
+        if (!ec && maxSessions > 0) {
+            QMutexLocker lock(&m_sessionsMutex);
+            full = m_sessions.size() >= maxSessions;
+        }
+        if (ec) {
+            qWarning() << "Beast accept failed:" << QString::fromStdString(ec.message());
+        } else if (full) {
+            // Closed before the handshake: nothing is allocated for the connection
+            beast::error_code peerError;
+            const tcp::endpoint peer = socket.remote_endpoint(peerError);
+            beast::error_code ignored;
+            socket.close(ignored);
+            emit sessionRejected(peerError ? QHostAddress() : QHostAddress(QString::fromStdString(peer.address().to_string())));
+        } else {
+            auto session = std::make_shared<BeastSession>(this, std::move(socket));
+            {
+                QMutexLocker lock(&m_sessionsMutex);
+                m_sessions.insert(session->id(), session);
+            }
+            session->run();
+        }
+        accept();
+    });
+}
+
+void BeastServer::opened(const QString& clientId, const QHostAddress& address)
+{
+    emit sessionOpened(clientId, address);
+}
+
+void BeastServer::closed(const QString& clientId, bool wasOpen)
+{
+    {
+        QMutexLocker lock(&m_sessionsMutex);
+        m_sessions.remove(clientId);
+    }
+    if (wasOpen)
+        emit sessionClosed(clientId);
+}
@@ -0,0 +1,118 @@
+#ifndef BEASTSERVER_H
+#define BEASTSERVER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QHash>
+#include <QHostAddress>
+#include <QMutex>
+#include <QSize>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "controlmessage.h"
+#include "encodedframe.h"
+#include "keepalive.h"
+#include "memorybudget.h"
+#include "outboundmessage.h"
+#include "relayqueue.h"
+
+class BeastSession;
+class TlsContext;
+
+// WebSocket server backend on Boost.Beast, for many concurrent streams.
+// One io_context per I/O thread, each running on its own thread; accepted
+// connections are spread round-robin over them and never change thread, so
+// a session needs no locking. Messages are read straight into the QByteArray
+// the EncodedFrame then shares (no intermediate buffer, no copy), and parsed
+// with the same InboundParser as the Qt backend.
+//
+// Signals are emitted from the I/O threads: connect to them with
+// Qt::QueuedConnection. start(), stop() and sendControl() are called from
+// the thread the object lives on.
+class BeastServer : public QObject
+{
+    Q_OBJECT
+public:
+    // Largest accepted message by default (a 4K raw I420 frame is ~12 MB)
+    static const std::size_t kDefaultMaxMessageBytes = 64 * 1024 * 1024;
+
+    explicit BeastServer(QObject* parent = nullptr);
+    ~BeastServer() override;
+
+    // Listen on `port` (0 = any) with `threads` I/O threads; false if the port is unavailable.
+    // `reusePort` lets other processes listen on the same port (SO_REUSEPORT).
+    bool start(quint16 port, int threads, bool reusePort = false);
+    void stop();
+    quint16 port() const;
+    QString errorString() const;
+
+    // Queue a serialized ControlMessage (prefix added here) on the session's
+    // thread; a serialized ControlBatch with MessagePrefix::ControlBatch
+    bool sendControl(const QString& clientId, const QByteArray& serialized,
+                     MessagePrefix prefix = MessagePrefix::Control);
+    // Drop a session (admission control); sessionClosed() follows
+    bool closeSession(const QString& clientId);
+    // Same-host client: the session also reads frames from its shared-memory ring
+    bool attachSharedMemory(const QString& clientId, const QString& ringName);
+    // Viewer session: relay another client's frame messages to it, queued per viewer
+    bool startRelay(const QString& clientId, int depth, OutboundDropPolicy policy);
+    bool relayFrame(const QString& clientId, const QByteArray& message, RelayFrameKind kind);
+    // Decode the session's JPEG frames (stream 0) while they arrive: a frame
+    // that takes more than one read is fed to a StreamingJpegDecoder as its
+    // bytes come in, at the DCT scale that covers `target` (empty: full size),
+    // and reaches encodedFrameReceived() decoded (EncodedFrame::decoded).
+    // For clients whose frames the server decodes anyway.
+    bool setStreamingDecode(const QString& clientId, bool enabled, const QSize& target);
+
+    // Admission limits, from any thread; they apply to connections accepted
+    // (sessions) or messages read (size) afterwards. 0 sessions: unlimited.
+    void setMaxSessions(int sessions);
+    void setMaxMessageBytes(std::size_t bytes);
+    // Dead-peer detection for connections accepted afterwards: Beast's idle
+    // timeout of keepaliveTimeoutMs(), with keep-alive pings. intervalMs 0
+    // leaves Beast's suggested server timeout (minutes).
+    void setKeepalive(const KeepaliveConfig& config);
+    // Charge every session's frames to its own account of `budget`; set it
+    // before start(). Refused frames are dropped and reported with frameRefused().
+    void setMemoryBudget(const std::shared_ptr<MemoryBudget>& budget);
+    // Serve WSS: every connection accepted afterwards starts with a TLS
+    // handshake (tlsstream.h); null serves plain WebSocket. Set it before start().
+    void setTls(const std::shared_ptr<TlsContext>& tls);
+
+signals:
+    void sessionOpened(const QString& clientId, const QHostAddress& address);
+    void controlMessageReceived(const QString& clientId, const ControlMessagePtr& message);
+    void encodedFrameReceived(const QString& clientId, const EncodedFrame& frame);
+    // A frame of `streamId` dropped on arrival, over the memory budget
+    void frameRefused(const QString& clientId, quint16 streamId, bool keyframeNeeded);
+    void sessionClosed(const QString& clientId);
+    // A connection closed on accept because the session limit was reached
+    void sessionRejected(const QHostAddress& address);
+
+private:
+    friend class BeastSession;
+
+    struct Impl;
+
+    void accept();
+    // Called on the session's thread
+    void opened(const QString& clientId, const QHostAddress& address);
+    void closed(const QString& clientId, bool wasOpen);
+
+    std::unique_ptr<Impl> m_impl;
+    quint16 m_port = 0;
+    QString m_error;
+    std::atomic<int> m_maxSessions{0};
+    std::atomic<std::size_t> m_maxMessageBytes;
+    std::atomic<std::int64_t> m_keepaliveTimeoutMs{0};
+    std::shared_ptr<MemoryBudget> m_memory;
+    std::shared_ptr<TlsContext> m_tls;
+
+    // Every live session, handshaking ones included (so stop() can close them)
+    mutable QMutex m_sessionsMutex;
+    QHash<QString, std::weak_ptr<BeastSession>> m_sessions;
+};
+
+#endif // BEASTSERVER_H
@@ -0,0 +1,64 @@
+#ifndef BOXSCALE_H
+#define BOXSCALE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Area-average (box filter) downscale of 8-bit interleaved pixels, `channels`
+// bytes each (3 for RGB888, 4 for RGB32). Every output pixel is the rounded
+// mean of the source block it covers, blocks being cut at integer positions
+// (x * srcWidth / dstWidth), so no source pixel is skipped as with nearest
+// neighbour, and nothing is blurred across blocks.
+//
+// Two passes per output row: the rows of its block are summed into `sums`
+// (one add per byte over contiguous memory, which the compiler vectorizes),
+// then each block of columns is summed and divided. `sums` is scratch, sized
+// on first use and reused by later calls.
+//
+// Only shrinks: false when the destination is larger than the source in
+// either dimension, or for empty sizes.
+inline bool boxDownscale(const std::uint8_t* src, int srcWidth, int srcHeight, std::size_t srcStride,
+                         std::uint8_t* dst, int dstWidth, int dstHeight, std::size_t dstStride,
+                         int channels, std::vector<std::uint32_t>& sums)
+{
+    if (!src || !dst || channels <= 0 || dstWidth <= 0 || dstHeight <= 0 || dstWidth > srcWidth
+        || dstHeight > srcHeight)
+        return false;
+
+    const std::size_t rowBytes = static_cast<std::size_t>(srcWidth) * static_cast<std::size_t>(channels);
+    sums.resize(rowBytes);
+    std::uint32_t* const sum = sums.data();
+
+    for (int y = 0; y < dstHeight; ++y) {
+        const int y0 = static_cast<int>(static_cast<std::int64_t>(y) * srcHeight / dstHeight);
+        const int y1 = static_cast<int>(static_cast<std::int64_t>(y + 1) * srcHeight / dstHeight);
+
+        // Vertical pass: sum of the block's source rows
+        const std::uint8_t* row = src + static_cast<std::size_t>(y0) * srcStride;
+        for (std::size_t i = 0; i < rowBytes; ++i)
+            sum[i] = row[i];
+        for (int sy = y0 + 1; sy < y1; ++sy) {
+            row = src + static_cast<std::size_t>(sy) * srcStride;
+            for (std::size_t i = 0; i < rowBytes; ++i)
+                sum[i] += row[i];
+        }
+
+        // Horizontal pass: sum over each block of columns, rounded mean
+        std::uint8_t* out = dst + static_cast<std::size_t>(y) * dstStride;
+        for (int x = 0; x < dstWidth; ++x) {
+            const int x0 = static_cast<int>(static_cast<std::int64_t>(x) * srcWidth / dstWidth);
+            const int x1 = static_cast<int>(static_cast<std::int64_t>(x + 1) * srcWidth / dstWidth);
+            const std::uint32_t count = static_cast<std::uint32_t>((x1 - x0) * (y1 - y0));
+            for (int c = 0; c < channels; ++c) {
+                std::uint32_t total = 0;
+                for (int sx = x0; sx < x1; ++sx)
+                    total += sum[static_cast<std::size_t>(sx) * static_cast<std::size_t>(channels) + static_cast<std::size_t>(c)];
+                *out++ = static_cast<std::uint8_t>((total + count / 2) / count);
+            }
+        }
+    }
+    return true;
+}
+
+#endif // BOXSCALE_H
@@ -0,0 +1,326 @@
+#include "browserviewer.h"
+#include <QDebug>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMetaObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QUrl>
+#include <QUrlQuery>
+#include "framebus.h"
+
+namespace {
+// Browsers send a request line and a few headers; anything bigger is not one
+const int kMaxRequestBytes = 8 * 1024;
+const char kBoundary[] = "imagesocketframe";
+
+const char kPage[] = R"(<!DOCTYPE html>
+<html>
+<head>
+<meta charset="utf-8">
+<title>ImageSocket</title>
+<style>
+body { font-family: sans-serif; background: #111; color: #eee; margin: 1em; }
+a { color: #8cf; margin-right: 1em; }
+a.shown { color: #fff; font-weight: bold; }
+img { display: block; max-width: 100%; margin-top: 1em; }
+</style>
+</head>
+<body>
+<div id="clients">Loading clients...</div>
+<img id="view" alt="">
+<script>
+const view = document.getElementById('view');
+const box = document.getElementById('clients');
+function show(link, id) {
+  for (const other of box.querySelectorAll('a')) other.className = '';
+  link.className = 'shown';
+  view.src = '/stream?client=' + encodeURIComponent(id);
+}
+fetch('/clients').then(r => r.json()).then(list => {
+  box.textContent = list.length ? '' : 'No clients connected';
+  for (const client of list) {
+    const link = document.createElement('a');
+    link.href = '#';
+    link.textContent = client.alias || client.id;
+    link.onclick = e => { e.preventDefault(); show(link, client.id); };
+    box.appendChild(link);
+  }
+  if (list.length) show(box.firstChild, list[0].id);
+});
+</script>
+</body>
+</html>
+)";
+
+QByteArray httpResponse(const char* status, const char* contentType, const QByteArray& body)
+{
+    QByteArray response;
+    response.reserve(body.size() + 128);
+    response += "HTTP/1.1 ";
+    response += status;
+    response += "\r\nContent-Type: ";
+    response += contentType;
+    response += "\r\nContent-Length: ";
+    response += QByteArray::number(body.size());
+    response += "\r\nConnection: close\r\n\r\n";
+    response += body;
+    return response;
+}
+
+// Client id of the `client` query item, matched by id, else by alias; empty when unknown
+QString findClient(const QUrl& url, const StreamMetrics& metrics)
+{
+    const std::string wanted = QUrlQuery(url).queryItemValue("client", QUrl::FullyDecoded).toStdString();
+    if (wanted.empty())
+        return QString();
+    const auto clients = metrics.clients();
+    const std::pair<std::string, std::string>* match = nullptr;
+    for (const auto& client : clients) {
+        if (client.first == wanted)
+            return QString::fromStdString(client.first);
+        if (!match && client.second == wanted)
+            match = &client;
+    }
+    return match ? QString::fromStdString(match->first) : QString();
+}
+
+// Value of a request header (case-insensitive name), empty when absent
+QByteArray headerValue(const QByteArray& request, const QByteArray& name)
+{
+    const QList<QByteArray> lines = request.split('\n');
+    for (int i = 1; i < lines.size(); ++i) {
+        const QByteArray line = lines.at(i).trimmed();
+        const int colon = line.indexOf(':');
+        if (colon > 0 && line.left(colon).trimmed().toLower() == name)
+            return line.mid(colon + 1).trimmed();
+    }
+    return QByteArray();
+}
+
+QByteArray snapshotResponse(const SnapshotCache::Snapshot& snapshot, const QByteArray& ifNoneMatch)
+{
+    const QByteArray etag = '"' + QByteArray::number(snapshot.version) + '"';
+    const EncodedFrame& frame = snapshot.frame;
+    const FrameTiming timing = frame.timing();
+    QByteArray headers;
+    headers += "\r\nETag: ";
+    headers += etag;
+    headers += "\r\nX-Frame-Sequence: ";
+    headers += QByteArray::number(timing.sequence);
+    if (timing.hasCapture) {
+        headers += "\r\nX-Capture-Time-Us: ";
+        headers += QByteArray::number(timing.captureTimeUs);
+    }
+    headers += "\r\nCache-Control: no-cache\r\nConnection: close\r\n";
+
+    if (!ifNoneMatch.isEmpty() && (ifNoneMatch == etag || ifNoneMatch == "*"))
+        return "HTTP/1.1 304 Not Modified" + headers + "\r\n";
+
+    QByteArray response;
+    response.reserve(frame.size() + headers.size() + 96);
+    response += "HTTP/1.1 200 OK\r\nContent-Type: image/jpeg\r\nContent-Length: ";
+    response += QByteArray::number(frame.size());
+    response += headers;
+    response += "\r\n";
+    response.append(frame.data(), frame.size());
+    return response;
+}
+
+QByteArray streamHeaders()
+{
+    QByteArray headers("HTTP/1.1 200 OK\r\nContent-Type: multipart/x-mixed-replace; boundary=");
+    headers += kBoundary;
+    headers += "\r\nCache-Control: no-cache, no-store\r\nPragma: no-cache\r\nConnection: close\r\n\r\n";
+    return headers;
+}
+} // namespace
+
+BrowserViewer::BrowserViewer(FrameBus* bus, std::shared_ptr<const StreamMetrics> metrics,
+                             std::shared_ptr<const SnapshotCache> snapshots, QObject* parent)
+    : QObject(parent), m_bus(bus), m_metrics(std::move(metrics)), m_snapshots(std::move(snapshots))
+{
+    m_thread.setObjectName("BrowserViewer");
+}
+
+BrowserViewer::~BrowserViewer()
+{
+    stop();
+}
+
+bool BrowserViewer::start(quint16 port, const QHostAddress& address)
+{
+    if (m_listener || !m_bus || !m_metrics || !m_snapshots)
+        return false;
+
+    m_listener = new QTcpServer;
+    m_listener->moveToThread(&m_thread);
+    m_thread.start();
+
+    bool listening = false;
+    QMetaObject::invokeMethod(m_listener, [this, port, address, &listening]() {
+        listening = m_listener->listen(address, port);
+        if (!listening)
+            return;
+        m_port = m_listener->serverPort();
+        QObject::connect(m_listener, &QTcpServer::newConnection, m_listener, [this]() { onNewConnection(); });
+    }, Qt::BlockingQueuedConnection);
+
+    if (!listening) {
+        qWarning() << "BrowserViewer: can't listen on port" << port << ":" << m_listener->errorString();
+        stop();
+        return false;
+    }
+    qInfo() << "BrowserViewer: serving http://<host>:" << m_port << "/";
+    return true;
+}
+
+void BrowserViewer::stop()
+{
+    if (!m_listener)
+        return;
+    // Open connections (and their bus subscriptions) are children of the listener and go with it
+    QMetaObject::invokeMethod(m_listener, [this]() { m_listener->close(); }, Qt::BlockingQueuedConnection);
+    m_thread.quit();
+    m_thread.wait();
+    delete m_listener;
+    m_listener = nullptr;
+    m_port = 0;
+}
+
+bool BrowserViewer::isRunning() const
+{
+    return m_listener != nullptr;
+}
+
+quint16 BrowserViewer::port() const
+{
+    return m_port;
+}
+
+int BrowserViewer::streamCount() const
+{
+    return m_streams.load(std::memory_order_relaxed);
+}
+
+QByteArray BrowserViewer::respond(const QByteArray& request, const StreamMetrics& metrics,
+                                 const SnapshotCache& snapshots, QString* streamClient)
+{
+    const int lineEnd = request.indexOf("\r\n");
+    const QList<QByteArray> requestLine = request.left(lineEnd < 0 ? request.size() : lineEnd).split(' ');
+    if (requestLine.size() < 2 || !requestLine.at(1).startsWith('/'))
+        return httpResponse("400 Bad Request", "text/plain", "bad request\n");
+    if (requestLine.at(0) != "GET")
+        return httpResponse("405 Method Not Allowed", "text/plain", "GET only\n");
+
+    const QUrl url = QUrl::fromEncoded(requestLine.at(1));
+    const QString path = url.path();
+    if (path == QLatin1String("/"))
+        return httpResponse("200 OK", "text/html; charset=utf-8", QByteArray(kPage));
+
+    if (path == QLatin1String("/clients")) {
+        QJsonArray list;
+        for (const auto& client : metrics.clients()) {
+            QJsonObject entry;
+            entry["id"] = QString::fromStdString(client.first);
+            entry["alias"] = QString::fromStdString(client.second);
+            list.append(entry);
+        }
+        return httpResponse("200 OK", "application/json", QJsonDocument(list).toJson(QJsonDocument::Compact));
+    }
+    if (path != QLatin1String("/stream") && path != QLatin1String("/snapshot"))
+        return httpResponse("404 Not Found", "text/plain", "not found, try /\n");
+
+    const QString clientId = findClient(url, metrics);
+    if (clientId.isEmpty())
+        return httpResponse("404 Not Found", "text/plain", "no such client, see /clients\n");
+
+    if (path == QLatin1String("/snapshot")) {
+        SnapshotCache::Snapshot snapshot;
+        if (!snapshots.find(clientId, snapshot))
+            return httpResponse("404 Not Found", "text/plain", "no JPEG frame from this client yet\n");
+        return snapshotResponse(snapshot, headerValue(request, "if-none-match"));
+    }
+
+    if (streamClient)
+        *streamClient = clientId;
+    return streamHeaders();
+}
+
+QByteArray BrowserViewer::partHeader(int size)
+{
+    QByteArray header("--");
+    header += kBoundary;
+    header += "\r\nContent-Type: image/jpeg\r\nContent-Length: ";
+    header += QByteArray::number(size);
+    header += "\r\n\r\n";
+    return header;
+}
+
+void BrowserViewer::onNewConnection()
+{
+    // Listener thread
+    while (QTcpSocket* socket = m_listener->nextPendingConnection()) {
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        connect(socket, &QTcpSocket::readyRead, socket, [this, socket]() {
+            if (socket->property("answered").toBool()) {
+                socket->readAll(); // a streaming browser has nothing more to say
+                return;
+            }
+            const QByteArray pending = socket->peek(kMaxRequestBytes + 1);
+            const bool complete = pending.contains("\r\n\r\n");
+            if (!complete && pending.size() <= kMaxRequestBytes)
+                return; // wait for the rest of the headers
+            socket->setProperty("answered", true);
+            socket->readAll();
+            QString streamClient;
+            const QByteArray response = complete
+                ? respond(pending, *m_metrics, *m_snapshots, &streamClient)
+                : httpResponse("431 Request Header Fields Too Large", "text/plain", "request too large\n");
+            socket->write(response);
+            if (streamClient.isEmpty())
+                socket->disconnectFromHost();
+            else
+                startStream(socket, streamClient);
+        });
+    }
+}
+
+void BrowserViewer::startStream(QTcpSocket* socket, const QString& clientId)
+{
+    // Listener thread. The latest frame that found the socket still busy, sent
+    // once it has flushed; a null buffer when there is none.
+    auto waiting = std::make_shared<EncodedFrame>();
+    auto send = [socket](const EncodedFrame& frame) {
+        socket->write(partHeader(frame.size()));
+        socket->write(frame.data(), frame.size());
+        socket->write("\r\n");
+    };
+
+    FrameBus::Options options;
+    options.kinds = BusFrame::Encoded;
+    options.clientId = clientId;
+    options.depth = 1;
+    options.policy = FrameBus::DropPolicy::DropOldest;
+    m_bus->subscribe(socket, [socket, waiting, send](const FramePtr& frame) {
+        const EncodedFrame& encoded = frame->encoded;
+        if (encoded.format != EncodedFrame::Jpeg || encoded.isEmpty())
+            return;
+        if (socket->bytesToWrite() > 0)
+            *waiting = encoded;
+        else
+            send(encoded);
+    }, options);
+    connect(socket, &QTcpSocket::bytesWritten, socket, [socket, waiting, send]() {
+        if (socket->bytesToWrite() > 0 || waiting->buffer.isNull())
+            return;
+        const EncodedFrame frame = *waiting;
+        *waiting = EncodedFrame();
+        send(frame);
+    });
+
+    m_streams.fetch_add(1, std::memory_order_relaxed);
+    connect(socket, &QObject::destroyed, [this]() { m_streams.fetch_sub(1, std::memory_order_relaxed); });
+    qInfo() << "BrowserViewer:" << socket->peerAddress().toString() << "watches" << clientId;
+}
@@ -0,0 +1,73 @@
+#ifndef BROWSERVIEWER_H
+#define BROWSERVIEWER_H
+
+#include <QByteArray>
+#include <QHostAddress>
+#include <QObject>
+#include <QString>
+#include <QThread>
+#include <atomic>
+#include <memory>
+#include "snapshotcache.h"
+#include "streammetrics.h"
+
+class FrameBus;
+class QTcpServer;
+class QTcpSocket;
+
+// Remote monitoring from a browser, without decoding anything on the server:
+//   GET /                              a small page to pick a client and watch it
+//   GET /clients                       [{"id": ..., "alias": ...}] of every client
+//   GET /stream?client=<id or alias>   multipart/x-mixed-replace MJPEG stream
+//   GET /snapshot?client=<id or alias> the client's latest JPEG (SnapshotCache)
+// Each part of a stream is a client's JPEG payload exactly as it arrived,
+// taken from the FrameBus. Frames in other formats (raw YUV, H.264/H.265)
+// are skipped: a browser can't show them without a decoder.
+//
+// A snapshot comes with its cache version as ETag and the client's frame
+// sequence (X-Frame-Sequence); pollers that send If-None-Match get 304 until
+// a newer frame arrived.
+//
+// Every stream connection is a bus subscriber of its own with a one-frame
+// queue, run on this server's thread. While its socket is still flushing a
+// frame the newest one waits in its place, so a slow browser sees fewer
+// frames and never holds the others (or the receive path) back.
+class BrowserViewer : public QObject
+{
+    Q_OBJECT
+public:
+    BrowserViewer(FrameBus* bus, std::shared_ptr<const StreamMetrics> metrics,
+                  std::shared_ptr<const SnapshotCache> snapshots, QObject* parent = nullptr);
+    ~BrowserViewer() override; // stops
+
+    // Port 0 picks a free one (see port()); false when already running or
+    // the port can't be bound
+    bool start(quint16 port, const QHostAddress& address = QHostAddress::Any);
+    void stop();
+    bool isRunning() const;
+    quint16 port() const;
+    // Browsers watching a stream right now
+    int streamCount() const;
+
+    // Response to one raw HTTP request (status line, headers and body). A
+    // GET /stream of a known client gets the stream's headers instead, and
+    // the client's id in `streamClient`; the parts follow from the bus.
+    static QByteArray respond(const QByteArray& request, const StreamMetrics& metrics,
+                              const SnapshotCache& snapshots, QString* streamClient);
+    // Boundary and headers ahead of a JPEG part of `size` bytes
+    static QByteArray partHeader(int size);
+
+private:
+    void onNewConnection();
+    void startStream(QTcpSocket* socket, const QString& clientId);
+
+    FrameBus* m_bus;
+    std::shared_ptr<const StreamMetrics> m_metrics;
+    std::shared_ptr<const SnapshotCache> m_snapshots;
+    QThread m_thread;
+    QTcpServer* m_listener = nullptr; // lives on m_thread
+    quint16 m_port = 0;
+    std::atomic<int> m_streams{0};
+};
+
+#endif // BROWSERVIEWER_H
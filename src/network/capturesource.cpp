@@ -0,0 +1,186 @@
+#include "capturesource.h"
+#include <chrono>
+#include <utility>
+#include "framepacer.h"
+
+namespace {
+std::int64_t steadyUs()
+{
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+} // namespace
+
+CaptureSource::CaptureSource(Reader reader, double fps)
+    : m_reader(std::move(reader)), m_fps(fps)
+{
+}
+
+CaptureSource::~CaptureSource()
+{
+    stop();
+}
+
+bool CaptureSource::start()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running || !m_reader)
+        return false;
+    m_running = true;
+    m_stopping = false;
+    m_finished = false;
+    m_thread = std::thread(&CaptureSource::run, this);
+    return true;
+}
+
+void CaptureSource::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running)
+            return;
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    // A reader blocked on a device returns with its next frame
+    if (m_thread.joinable())
+        m_thread.join();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_running = false;
+}
+
+bool CaptureSource::isRunning() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_running && !m_finished;
+}
+
+void CaptureSource::setFps(double fps)
+{
+    m_fps.store(fps, std::memory_order_relaxed);
+}
+
+void CaptureSource::setSourceFps(double fps)
+{
+    m_sourceFps.store(fps, std::memory_order_relaxed);
+}
+
+void CaptureSource::setPaused(bool paused)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_paused = paused;
+    }
+    m_wake.notify_all();
+}
+
+void CaptureSource::setOnFrame(std::function<void()> onFrame)
+{
+    m_onFrame = std::move(onFrame);
+}
+
+void CaptureSource::setGrabber(Grabber grabber)
+{
+    m_grabber = std::move(grabber);
+}
+
+bool CaptureSource::take(Frame& out, int timeoutMs)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (timeoutMs > 0)
+        m_ready.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+                         [this]() { return !m_slot.empty() || m_finished || !m_running; });
+    return m_slot.take(out);
+}
+
+bool CaptureSource::finished() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_finished;
+}
+
+std::uint64_t CaptureSource::capturedFrames() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_captured;
+}
+
+std::uint64_t CaptureSource::droppedFrames() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_slot.droppedTotal();
+}
+
+std::uint64_t CaptureSource::skippedFrames() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_skipped;
+}
+
+void CaptureSource::run()
+{
+    // Capture thread
+    FramePacer pacer(m_fps.load(std::memory_order_relaxed));
+    FrameDecimator decimator;
+    std::uint64_t index = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (m_paused) {
+                m_wake.wait(lock, [this]() { return !m_paused || m_stopping; });
+                pacer.reset();
+                decimator.reset();
+            }
+            if (m_stopping)
+                return;
+        }
+
+        // Sleep until the frame's deadline, not for a period after the last
+        // one. A decimated source is paced at its own rate (a file plays in
+        // real time) and only the frames on the wanted schedule are kept.
+        const double fps = m_fps.load(std::memory_order_relaxed);
+        decimator.setRates(fps, m_sourceFps.load(std::memory_order_relaxed));
+        pacer.setFps(decimator.keepsAll() ? fps : m_sourceFps.load(std::memory_order_relaxed));
+        const std::int64_t dueUs = pacer.nextDueUs(steadyUs());
+        const std::int64_t waitUs = dueUs - steadyUs();
+        if (waitUs > 0) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (m_wake.wait_for(lock, std::chrono::microseconds(waitUs),
+                                [this]() { return m_stopping || m_paused; }))
+                continue;
+        }
+
+        // Left-out frames are only grabbed; without a grabber they are read
+        // (the source has to advance) but not handed out
+        const bool keep = decimator.keep(dueUs);
+        Frame frame;
+        const bool read = m_grabber ? m_grabber() && (!keep || m_reader(frame.image))
+                                    : m_reader(frame.image);
+        if (!read) {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_finished = true;
+            }
+            m_ready.notify_all();
+            if (m_onFrame)
+                m_onFrame();
+            return;
+        }
+        if (!keep) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_skipped;
+            continue;
+        }
+        frame.captureTimeUs = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        frame.index = index++;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_slot.push(std::move(frame));
+            ++m_captured;
+        }
+        m_ready.notify_one();
+        if (m_onFrame)
+            m_onFrame();
+    }
+}
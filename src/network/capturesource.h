@@ -0,0 +1,99 @@
+#ifndef CAPTURESOURCE_H
+#define CAPTURESOURCE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <opencv2/core.hpp>
+#include "framemailbox.h"
+
+// Frames read on a thread of their own at a steady rate (FramePacer: absolute
+// deadlines, no drift from the time spent per frame), handed over through a
+// latest-wins slot. A consumer that falls behind gets the newest frame and
+// the ones in between count as dropped; reading never waits on it, and the
+// consumer (a GUI thread, an encoder) never waits on the device.
+//
+// The reader does the device work, e.g. VideoCapture::read() plus any color
+// conversion, so that runs on the capture thread too. It fills a Mat of its
+// own each time: a frame still held by the consumer is never written to.
+//
+// A source faster than the wanted rate (setSourceFps()) is read at its own
+// rate and decimated (FrameDecimator): frames off the schedule are never
+// handed out, so nothing decodes or encodes them. With a grabber set they are
+// only grabbed (VideoCapture::grab()) and the reader just decodes the kept
+// ones (VideoCapture::retrieve()).
+class CaptureSource
+{
+public:
+    struct Frame {
+        cv::Mat image;
+        std::int64_t captureTimeUs = 0; // wall clock, when the reader returned
+        std::uint64_t index = 0;        // frames read before this one
+    };
+
+    // False at the end of the stream (file done, device gone)
+    using Reader = std::function<bool(cv::Mat&)>;
+    using Grabber = std::function<bool()>;
+
+    explicit CaptureSource(Reader reader, double fps = 30.0);
+    ~CaptureSource(); // stops
+    CaptureSource(const CaptureSource&) = delete;
+    CaptureSource& operator=(const CaptureSource&) = delete;
+
+    // False when already running (after the end of the stream, stop() first)
+    bool start();
+    // Joins the thread; a frame in the slot stays there
+    void stop();
+    bool isRunning() const;
+
+    // Take effect at the next frame
+    void setFps(double fps);
+    // Rate the source delivers frames at (0: unknown, every frame is kept)
+    void setSourceFps(double fps);
+    // Paused: nothing is read (a file doesn't advance); resuming starts a new schedule
+    void setPaused(bool paused);
+    // Called on the capture thread after each frame is in the slot (e.g. to
+    // queue a call to the consumer's thread); set before start()
+    void setOnFrame(std::function<void()> onFrame);
+    // Advances the source without decoding; the reader then only decodes
+    // the frame grabbed last. Set before start()
+    void setGrabber(Grabber grabber);
+
+    // Wait up to `timeoutMs` for a frame not taken yet (0: don't wait). False
+    // on timeout, and once the stream ended with nothing left to take.
+    bool take(Frame& out, int timeoutMs);
+    // The reader returned false; frames may still be waiting
+    bool finished() const;
+
+    std::uint64_t capturedFrames() const;
+    // Replaced in the slot before the consumer took them
+    std::uint64_t droppedFrames() const;
+    // Source frames left out for the wanted rate (only grabbed, with a grabber)
+    std::uint64_t skippedFrames() const;
+
+private:
+    void run();
+
+    Reader m_reader;
+    Grabber m_grabber;
+    std::function<void()> m_onFrame;
+    std::thread m_thread;
+    std::atomic<double> m_fps;
+    std::atomic<double> m_sourceFps{0.0};
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;  // capture thread: stop, unpause
+    std::condition_variable m_ready; // consumer: frame or end
+    FrameMailbox<Frame> m_slot;
+    bool m_running = false;
+    bool m_stopping = false;
+    bool m_paused = false;
+    bool m_finished = false;
+    std::uint64_t m_captured = 0;
+    std::uint64_t m_skipped = 0;
+};
+
+#endif // CAPTURESOURCE_H
@@ -0,0 +1,142 @@
+#ifndef CHANGEDETECTOR_H
+#define CHANGEDETECTOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+// Static-scene detection on the sender: every frame is reduced to a luma
+// fingerprint, the mean brightness of each cell of a kGrid x kGrid grid
+// (sampled on at most kSamples x kSamples pixels per cell, so the cost does
+// not grow with the resolution), and compared with the fingerprint of the
+// last frame that was sent. Both the sum of absolute differences over the
+// grid (the whole picture drifted) and the largest single cell difference
+// (something moved in a corner) count; below both thresholds the frame is
+// left out and an UNCHANGED heartbeat goes instead.
+//
+// The comparison is against the last frame sent, not the previous one, so a
+// slow change adds up until it is sent. A frame is sent anyway once
+// `maxStaticUs` passed without one (a new viewer, a snapshot, or a change
+// too gradual for the thresholds is at most that old).
+//
+// The fingerprint is kCells bytes and the difference loop runs over plain
+// uint8 arrays, which compilers turn into PSADBW / UABAL.
+class ChangeDetector
+{
+public:
+    static const int kGrid = 16;
+    static const int kCells = kGrid * kGrid;
+    static const int kSamples = 8;
+
+    struct Fingerprint {
+        std::uint8_t cells[kCells] = {};
+    };
+
+    struct Difference {
+        std::uint32_t sad = 0;     // over every cell
+        std::uint8_t maxCell = 0;  // largest single cell difference
+        double mean() const { return static_cast<double>(sad) / kCells; }
+    };
+
+    // `meanThreshold`: mean luma difference per cell (0-255) that counts as
+    // a change; `cellThreshold`: the same for a single cell. 0 disables it.
+    explicit ChangeDetector(double meanThreshold = 1.5, int cellThreshold = 12,
+                            std::int64_t maxStaticUs = 5000000)
+        : m_meanThreshold(meanThreshold), m_cellThreshold(cellThreshold), m_maxStaticUs(maxStaticUs)
+    {
+    }
+
+    // 8-bit interleaved pixels: 1 channel (gray), 3 (BGR) or 4 (BGRA)
+    static bool fingerprint(const std::uint8_t* data, int width, int height, std::size_t stride,
+                            int channels, Fingerprint& out)
+    {
+        if (!data || width < kGrid || height < kGrid || (channels != 1 && channels != 3 && channels != 4))
+            return false;
+        for (int gy = 0; gy < kGrid; ++gy) {
+            const int y0 = gy * height / kGrid;
+            const int y1 = (gy + 1) * height / kGrid;
+            const int ys = (y1 - y0 + kSamples - 1) / kSamples;
+            for (int gx = 0; gx < kGrid; ++gx) {
+                const int x0 = gx * width / kGrid;
+                const int x1 = (gx + 1) * width / kGrid;
+                const int xs = (x1 - x0 + kSamples - 1) / kSamples;
+                std::uint32_t sum = 0;
+                std::uint32_t count = 0;
+                for (int y = y0; y < y1; y += ys) {
+                    const std::uint8_t* row = data + static_cast<std::size_t>(y) * stride;
+                    for (int x = x0; x < x1; x += xs) {
+                        sum += luma(row + static_cast<std::size_t>(x) * channels, channels);
+                        ++count;
+                    }
+                }
+                out.cells[gy * kGrid + gx] = static_cast<std::uint8_t>(sum / count);
+            }
+        }
+        return true;
+    }
+
+    static Difference compare(const Fingerprint& a, const Fingerprint& b)
+    {
+        Difference diff;
+        for (int i = 0; i < kCells; ++i) {
+            const int d = std::abs(static_cast<int>(a.cells[i]) - static_cast<int>(b.cells[i]));
+            diff.sad += static_cast<std::uint32_t>(d);
+            if (d > diff.maxCell)
+                diff.maxCell = static_cast<std::uint8_t>(d);
+        }
+        return diff;
+    }
+
+    // Whether to send this frame; `nowUs` is any monotonic clock. The first
+    // frame, and any frame that can't be fingerprinted, is sent.
+    bool shouldSend(const std::uint8_t* data, int width, int height, std::size_t stride, int channels,
+                    std::int64_t nowUs)
+    {
+        Fingerprint current;
+        if (!fingerprint(data, width, height, stride, channels, current)) {
+            m_haveReference = false;
+            return true;
+        }
+        if (m_haveReference && (m_maxStaticUs <= 0 || nowUs - m_sentUs < m_maxStaticUs)) {
+            m_last = compare(current, m_reference);
+            const bool changed = (m_meanThreshold > 0.0 && m_last.mean() >= m_meanThreshold)
+                || (m_cellThreshold > 0 && m_last.maxCell >= m_cellThreshold);
+            if (!changed) {
+                ++m_unchanged;
+                return false;
+            }
+        }
+        m_reference = current;
+        m_haveReference = true;
+        m_sentUs = nowUs;
+        return true;
+    }
+
+    // The next frame is sent whatever it holds (after a pause, a keyframe request)
+    void reset() { m_haveReference = false; }
+
+    // Frames left out as unchanged
+    std::uint64_t unchangedFrames() const { return m_unchanged; }
+    // Difference of the last frame compared with the reference
+    Difference lastDifference() const { return m_last; }
+
+private:
+    // BT.601 luma with 8-bit weights (29 + 150 + 77 == 256)
+    static std::uint32_t luma(const std::uint8_t* pixel, int channels)
+    {
+        if (channels == 1)
+            return pixel[0];
+        return (29u * pixel[0] + 150u * pixel[1] + 77u * pixel[2]) >> 8;
+    }
+
+    double m_meanThreshold;
+    int m_cellThreshold;
+    std::int64_t m_maxStaticUs;
+    Fingerprint m_reference;
+    bool m_haveReference = false;
+    std::int64_t m_sentUs = 0;
+    Difference m_last;
+    std::uint64_t m_unchanged = 0;
+};
+
+#endif // CHANGEDETECTOR_H
@@ -1,10 +1,131 @@
 #include "clientmodel.h"
+#include <chrono>
 #include <cmath>
 #include <QDateTime>
+#include <QTimer>
+
+namespace {
+// The measured fps and bytes/s go out at most this often per client
+const qint64 kRatePublishUs = 250000;
+
+qint64 monotonicUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+}
+
+void ClientTrafficStats::append()
+{
+    rate.append(RateEstimator());
+    ratePublishedUs.append(0);
+    windowBytes.append(0);
+    windowDecodeUs.append(0);
+    windowDecodes.append(0);
+    lastArrivalMs.append(0);
+    lastGapMs.append(-1);
+    jitterMs.append(0.0);
+    bytesPerSecond.append(-1);
+    avgFrameBytes.append(-1);
+    decodeMs.append(-1.0);
+    publishedJitterMs.append(-1.0);
+    queueDepth.append(-1);
+    history.append(std::make_shared<StatsHistory>());
+    historyDrops.append(0);
+}
+
+void ClientTrafficStats::removeAt(int row)
+{
+    rate.removeAt(row);
+    ratePublishedUs.removeAt(row);
+    windowBytes.removeAt(row);
+    windowDecodeUs.removeAt(row);
+    windowDecodes.removeAt(row);
+    lastArrivalMs.removeAt(row);
+    lastGapMs.removeAt(row);
+    jitterMs.removeAt(row);
+    bytesPerSecond.removeAt(row);
+    avgFrameBytes.removeAt(row);
+    decodeMs.removeAt(row);
+    publishedJitterMs.removeAt(row);
+    queueDepth.removeAt(row);
+    history.removeAt(row);
+    historyDrops.removeAt(row);
+}
+
+void ClientTrafficStats::clear()
+{
+    *this = ClientTrafficStats();
+}
 
 ClientModel::ClientModel(QObject* parent)
     : QAbstractListModel(parent)
 {
+    m_flushTimer = new QTimer(this);
+    m_flushTimer->setSingleShot(true);
+    connect(m_flushTimer, &QTimer::timeout, this, &ClientModel::flushChanges);
+    m_historyTimer = new QTimer(this);
+    m_historyTimer->setInterval(int(StatsHistory::periodMs(StatsHistory::Seconds)));
+    connect(m_historyTimer, &QTimer::timeout, this, &ClientModel::sampleHistory);
+    m_historyTimer->start();
+}
+
+qint64 ClientModel::monotonicMs()
+{
+    return monotonicUs() / 1000;
+}
+
+int ClientModel::updateIntervalMs() const
+{
+    return m_flushTimer->interval();
+}
+
+void ClientModel::setUpdateIntervalMs(int ms)
+{
+    ms = qMax(0, ms);
+    if (ms == 0)
+        flushChanges(); // nothing may stay pending once updates are immediate
+    m_flushTimer->setInterval(ms);
+}
+
+void ClientModel::notifyChanged(int row, const QVector<int>& roles)
+{
+    if (m_flushTimer->interval() == 0) {
+        const QModelIndex modelIndex = index(row, 0);
+        emit dataChanged(modelIndex, modelIndex, roles);
+        return;
+    }
+
+    QVector<int>& dirty = m_clients[row].dirtyRoles;
+    for (int role : roles) {
+        if (!dirty.contains(role))
+            dirty.append(role);
+    }
+    if (!m_flushTimer->isActive())
+        m_flushTimer->start();
+}
+
+void ClientModel::flushChanges()
+{
+    m_flushTimer->stop();
+    int first = -1;
+    int last = -1;
+    QVector<int> roles;
+    for (int i = 0; i < m_clients.size(); ++i) {
+        QVector<int>& dirty = m_clients[i].dirtyRoles;
+        if (dirty.isEmpty())
+            continue;
+        if (first < 0)
+            first = i;
+        last = i;
+        for (int role : qAsConst(dirty)) {
+            if (!roles.contains(role))
+                roles.append(role);
+        }
+        dirty.clear();
+    }
+    if (first >= 0)
+        emit dataChanged(index(first, 0), index(last, 0), roles);
 }
 
 int ClientModel::rowCount(const QModelIndex& parent) const
@@ -38,6 +159,38 @@ QVariant ClientModel::data(const QModelIndex& index, int role) const
         return e.configuredFps;
     case MeasuredFpsRole:
         return e.measuredFps;
+    case DroppedFramesRole:
+        return e.droppedFrames;
+    case QualityRole:
+        return e.quality;
+    case ThroughputKbpsRole:
+        return e.throughputKbps;
+    case QueueDelayMsRole:
+        return e.queueDelayMs;
+    case ThumbnailIdRole:
+        return e.thumbnailId;
+    case CodecRole:
+        return e.codec;
+    case LatencyRole:
+        return e.latency;
+    case LatencyP50MsRole:
+        return e.latencyP50Ms;
+    case LatencyP99MsRole:
+        return e.latencyP99Ms;
+    case RttMsRole:
+        return e.rttMs;
+    case ClockOffsetMsRole:
+        return e.clockOffsetMs;
+    case BytesPerSecondRole:
+        return m_traffic.bytesPerSecond.at(row);
+    case AvgFrameBytesRole:
+        return m_traffic.avgFrameBytes.at(row);
+    case DecodeMsRole:
+        return m_traffic.decodeMs.at(row);
+    case JitterMsRole:
+        return m_traffic.publishedJitterMs.at(row);
+    case QueueDepthRole:
+        return m_traffic.queueDepth.at(row);
     default: return QVariant();
     }
 }
@@ -50,6 +203,22 @@ QHash<int, QByteArray> ClientModel::roleNames() const
     roles[AliasRole] = "alias";
     roles[ConfiguredFpsRole] = "configuredFps";
     roles[MeasuredFpsRole] = "measuredFps";
+    roles[DroppedFramesRole] = "droppedFrames";
+    roles[QualityRole] = "quality";
+    roles[ThroughputKbpsRole] = "throughputKbps";
+    roles[QueueDelayMsRole] = "queueDelayMs";
+    roles[ThumbnailIdRole] = "thumbnailId";
+    roles[CodecRole] = "codec";
+    roles[LatencyRole] = "latency";
+    roles[LatencyP50MsRole] = "latencyP50Ms";
+    roles[LatencyP99MsRole] = "latencyP99Ms";
+    roles[RttMsRole] = "rttMs";
+    roles[ClockOffsetMsRole] = "clockOffsetMs";
+    roles[BytesPerSecondRole] = "bytesPerSecond";
+    roles[AvgFrameBytesRole] = "avgFrameBytes";
+    roles[DecodeMsRole] = "decodeMs";
+    roles[JitterMsRole] = "jitterMs";
+    roles[QueueDepthRole] = "queueDepth";
     return roles;
 }
 
@@ -59,7 +228,9 @@ void ClientModel::addClient(const QString& id, const QString& status)
         return;
     beginInsertRows(QModelIndex(), m_clients.size(), m_clients.size());
     ClientEntry e; e.id = id; e.status = status;
+    m_rows.insert(id, m_clients.size());
     m_clients.append(e);
+    m_traffic.append();
     endInsertRows();
 
     emit countChanged(m_clients.size());
@@ -72,23 +243,37 @@ void ClientModel::removeClient(const QString& id)
         return;
     beginRemoveRows(QModelIndex(), idx, idx);
     m_clients.removeAt(idx);
+    m_traffic.removeAt(idx);
+    m_rows.remove(id);
+    for (int i = idx; i < m_clients.size(); ++i)
+        m_rows[m_clients.at(i).id] = i;
     endRemoveRows();
 }
 
+bool ClientModel::renameClient(const QString& from, const QString& to)
+{
+    const int idx = indexOfClient(from);
+    if (idx == -1 || to.isEmpty() || indexOfClient(to) != -1)
+        return false;
+    m_rows.remove(from);
+    m_rows.insert(to, idx);
+    m_clients[idx].id = to;
+    notifyChanged(idx, { IdRole });
+    return true;
+}
+
 void ClientModel::clear()
 {
     beginResetModel();
     m_clients.clear();
+    m_traffic.clear();
+    m_rows.clear();
     endResetModel();
 }
 
 int ClientModel::indexOfClient(const QString& id) const
 {
-    for (int i = 0; i < m_clients.size(); ++i) {
-        if (m_clients.at(i).id == id)
-            return i;
-    }
-    return -1;
+    return m_rows.value(id, -1);
 }
 
 void ClientModel::setClientStatus(const QString& id, const QString& status)
@@ -99,8 +284,7 @@ void ClientModel::setClientStatus(const QString& id, const QString& status)
     if (m_clients[idx].status == status)
         return;
     m_clients[idx].status = status;
-    QModelIndex modelIndex = index(idx, 0);
-    emit dataChanged(modelIndex, modelIndex, { StatusRole });
+    notifyChanged(idx, { StatusRole });
 }
 
 void ClientModel::setClientAlias(const QString& id, const QString& alias)
@@ -111,8 +295,7 @@ void ClientModel::setClientAlias(const QString& id, const QString& alias)
     if (m_clients[idx].alias == alias)
         return;
     m_clients[idx].alias = alias;
-    QModelIndex modelIndex = index(idx, 0);
-    emit dataChanged(modelIndex, modelIndex, { AliasRole });
+    notifyChanged(idx, { AliasRole });
 }
 
 void ClientModel::setClientConfiguredFps(const QString& id, int fps)
@@ -121,30 +304,26 @@ void ClientModel::setClientConfiguredFps(const QString& id, int fps)
     if (idx == -1) return;
     if (m_clients[idx].configuredFps == fps) return;
     m_clients[idx].configuredFps = fps;
-    QModelIndex modelIndex = index(idx, 0);
-    emit dataChanged(modelIndex, modelIndex, { ConfiguredFpsRole });
+    notifyChanged(idx, { ConfiguredFpsRole });
 }
 
-void ClientModel::setClientMeasuredFps(const QString& id, int fps)
+void ClientModel::setClientMeasuredFps(const QString& id, double fps)
 {
     int idx = indexOfClient(id);
     if (idx == -1) return;
     if (m_clients[idx].measuredFps == fps) return;
     m_clients[idx].measuredFps = fps;
-    QModelIndex modelIndex = index(idx, 0);
-    emit dataChanged(modelIndex, modelIndex, { MeasuredFpsRole });
+    notifyChanged(idx, { MeasuredFpsRole });
 }
 
-void ClientModel::recordFrameReceived(const QString& id, qint64 timestampMs)
+void ClientModel::recordFrameReceived(const QString& id, qint64 timestampMs, qint64 bytes)
 {
     int idx = indexOfClient(id);
     if (idx == -1) return;
 
     ClientEntry &e = m_clients[idx];
-    if (timestampMs == 0) {
-        // missing timestamp, use current time
-        timestampMs = QDateTime::currentMSecsSinceEpoch();
-    }
+    const qint64 nowUs = timestampMs > 0 ? timestampMs * 1000 : monotonicUs();
+    timestampMs = nowUs / 1000;
 
     // Initialize window start if needed
     if (e.windowStartMs == 0) {
@@ -155,20 +334,208 @@ void ClientModel::recordFrameReceived(const QString& id, qint64 timestampMs)
     // Count this frame in current window
     e.framesInWindow++;
     e.lastFrameTsMs = timestampMs;
+    m_traffic.windowBytes[idx] += qMax<qint64>(0, bytes);
+    qint64& lastArrival = m_traffic.lastArrivalMs[idx];
+    if (lastArrival > 0) {
+        const qint64 gap = timestampMs - lastArrival;
+        qint64& lastGap = m_traffic.lastGapMs[idx];
+        if (lastGap >= 0)
+            m_traffic.jitterMs[idx] += (std::abs(double(gap - lastGap)) - m_traffic.jitterMs[idx]) / 16.0;
+        lastGap = gap;
+    }
+    lastArrival = timestampMs;
+
+    // The rate every frame, constant time; published every kRatePublishUs from the first frame
+    m_traffic.rate[idx].add(nowUs, bytes);
+    QVector<int> changed;
+    qint64& publishedUs = m_traffic.ratePublishedUs[idx];
+    if (publishedUs == 0)
+        publishedUs = nowUs;
+    else if (nowUs - publishedUs >= kRatePublishUs)
+        changed = publishRate(idx, nowUs);
 
     qint64 elapsed = timestampMs - e.windowStartMs;
     if (elapsed >= 1000) {
-        // compute frames per second over the window
-        int measured = int(std::round((double(e.framesInWindow) * 1000.0) / double(elapsed)));
-        e.measuredFps = measured;
+        changed << publishTrafficStats(idx, e.framesInWindow);
 
         // reset window
         e.framesInWindow = 0;
         e.windowStartMs = timestampMs;
+    }
+    if (!changed.isEmpty())
+        notifyChanged(idx, changed);
+}
 
-        QModelIndex modelIndex = index(idx, 0);
-        emit dataChanged(modelIndex, modelIndex, { MeasuredFpsRole });
+QVector<int> ClientModel::publishRate(int row, qint64 nowUs)
+{
+    ClientTrafficStats& t = m_traffic;
+    ClientEntry& e = m_clients[row];
+    QVector<int> changed;
+    const double fps = std::round(t.rate.at(row).fps(nowUs) * 10.0) / 10.0;
+    const int bytesPerSecond = int(t.rate.at(row).bytesPerSecond(nowUs));
+    if (e.measuredFps != fps) { e.measuredFps = fps; changed << MeasuredFpsRole; }
+    if (t.bytesPerSecond.at(row) != bytesPerSecond) { t.bytesPerSecond[row] = bytesPerSecond; changed << BytesPerSecondRole; }
+    t.ratePublishedUs[row] = nowUs;
+    return changed;
+}
+
+QVector<int> ClientModel::publishTrafficStats(int row, int frames)
+{
+    ClientTrafficStats& t = m_traffic;
+    QVector<int> changed;
+    const int avgFrameBytes = frames > 0 ? int(t.windowBytes.at(row) / frames) : -1;
+    // decodes of the window; -1 while the client's frames are not decoded
+    const int decodes = t.windowDecodes.at(row);
+    const double decodeMs = decodes > 0 ? std::round(double(t.windowDecodeUs.at(row)) / decodes / 100.0) / 10.0 : -1.0;
+    const double jitterMs = t.lastGapMs.at(row) >= 0 ? std::round(t.jitterMs.at(row) * 10.0) / 10.0 : -1.0;
+    if (t.avgFrameBytes.at(row) != avgFrameBytes) { t.avgFrameBytes[row] = avgFrameBytes; changed << AvgFrameBytesRole; }
+    if (t.decodeMs.at(row) != decodeMs) { t.decodeMs[row] = decodeMs; changed << DecodeMsRole; }
+    if (t.publishedJitterMs.at(row) != jitterMs) { t.publishedJitterMs[row] = jitterMs; changed << JitterMsRole; }
+    t.windowBytes[row] = 0;
+    t.windowDecodeUs[row] = 0;
+    t.windowDecodes[row] = 0;
+    return changed;
+}
+
+void ClientModel::sampleHistory()
+{
+    if (m_clients.isEmpty())
+        return;
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    const qint64 nowUs = monotonicUs();
+    for (int row = 0; row < m_clients.size(); ++row) {
+        // Streams that stopped sending have no frame to publish their decaying rate
+        if (m_traffic.ratePublishedUs.at(row) > 0 && nowUs - m_traffic.ratePublishedUs.at(row) >= kRatePublishUs) {
+            const QVector<int> changed = publishRate(row, nowUs);
+            if (!changed.isEmpty())
+                notifyChanged(row, changed);
+        }
+        const ClientEntry& e = m_clients.at(row);
+        StatsPoint point;
+        point.timeMs = now;
+        point.fps = float(e.measuredFps);
+        point.bytesPerSecond = float(qMax(0, m_traffic.bytesPerSecond.at(row)));
+        point.latencyMs = float(e.latencyP50Ms);
+        point.drops = float(qMax(0, e.droppedFrames - m_traffic.historyDrops.at(row)));
+        m_traffic.historyDrops[row] = e.droppedFrames;
+        m_traffic.history.at(row)->add(point);
     }
+    emit historyUpdated();
+}
+
+QVariantMap ClientModel::historyAt(int index, int resolutionSeconds, int maxPoints) const
+{
+    QVariantMap result;
+    if (index < 0 || index >= m_clients.size())
+        return result;
+    const StatsHistory& history = *m_traffic.history.at(index);
+    const StatsHistory::Resolution resolution = StatsHistory::resolutionFor(resolutionSeconds);
+    const int count = int(history.size(resolution));
+    const int points = maxPoints > 0 ? qMin(maxPoints, count) : count;
+    QVariantList timeMs, fps, bytesPerSecond, latencyMs, drops;
+    timeMs.reserve(points);
+    fps.reserve(points);
+    bytesPerSecond.reserve(points);
+    latencyMs.reserve(points);
+    drops.reserve(points);
+    history.forEach(resolution, 0, std::size_t(qMax(0, maxPoints)), [&](const StatsPoint& point) {
+        timeMs.append(double(point.timeMs));
+        fps.append(point.fps);
+        bytesPerSecond.append(point.bytesPerSecond);
+        latencyMs.append(point.latencyMs);
+        drops.append(point.drops);
+    });
+    result["periodMs"] = double(StatsHistory::periodMs(resolution));
+    result["timeMs"] = timeMs;
+    result["fps"] = fps;
+    result["bytesPerSecond"] = bytesPerSecond;
+    result["latencyMs"] = latencyMs;
+    result["drops"] = drops;
+    return result;
+}
+
+void ClientModel::recordFrameDecoded(const QString& id, qint64 decodeUs)
+{
+    int idx = indexOfClient(id);
+    if (idx == -1) return;
+    m_traffic.windowDecodeUs[idx] += qMax<qint64>(0, decodeUs);
+    m_traffic.windowDecodes[idx]++;
+}
+
+void ClientModel::setClientQueueDepth(const QString& id, int queuedFrames)
+{
+    int idx = indexOfClient(id);
+    if (idx == -1 || m_traffic.queueDepth.at(idx) == queuedFrames) return;
+    m_traffic.queueDepth[idx] = queuedFrames;
+    notifyChanged(idx, { QueueDepthRole });
+}
+
+void ClientModel::recordFramesDropped(const QString& id, int count)
+{
+    if (count <= 0) return;
+    int idx = indexOfClient(id);
+    if (idx == -1) return;
+    m_clients[idx].droppedFrames += count;
+    notifyChanged(idx, { DroppedFramesRole });
+}
+
+void ClientModel::setClientRateStats(const QString& id, int quality, int throughputKbps, int queueDelayMs)
+{
+    int idx = indexOfClient(id);
+    if (idx == -1) return;
+    ClientEntry &e = m_clients[idx];
+    QVector<int> changed;
+    if (e.quality != quality) { e.quality = quality; changed << QualityRole; }
+    if (e.throughputKbps != throughputKbps) { e.throughputKbps = throughputKbps; changed << ThroughputKbpsRole; }
+    if (e.queueDelayMs != queueDelayMs) { e.queueDelayMs = queueDelayMs; changed << QueueDelayMsRole; }
+    if (changed.isEmpty()) return;
+    notifyChanged(idx, changed);
+}
+
+void ClientModel::recordThumbnail(const QString& id)
+{
+    int idx = indexOfClient(id);
+    if (idx == -1) return;
+    m_clients[idx].thumbnailId++;
+    notifyChanged(idx, { ThumbnailIdRole });
+}
+
+void ClientModel::setClientCodec(const QString& id, const QString& codec)
+{
+    int idx = indexOfClient(id);
+    if (idx == -1 || m_clients[idx].codec == codec) return;
+    m_clients[idx].codec = codec;
+    notifyChanged(idx, { CodecRole });
+}
+
+void ClientModel::setClientLatency(const QString& id, const QVariantMap& latency)
+{
+    int idx = indexOfClient(id);
+    if (idx == -1) return;
+    ClientEntry &e = m_clients[idx];
+    if (e.latency == latency) return;
+    e.latency = latency;
+
+    QVector<int> changed;
+    changed << LatencyRole;
+    const QVariantMap endToEnd = latency.value(QStringLiteral("endToEnd")).toMap();
+    const double p50 = endToEnd.value(QStringLiteral("p50"), -1.0).toDouble();
+    const double p99 = endToEnd.value(QStringLiteral("p99"), -1.0).toDouble();
+    if (e.latencyP50Ms != p50) { e.latencyP50Ms = p50; changed << LatencyP50MsRole; }
+    if (e.latencyP99Ms != p99) { e.latencyP99Ms = p99; changed << LatencyP99MsRole; }
+    notifyChanged(idx, changed);
+}
+
+void ClientModel::setClientClock(const QString& id, double rttMs, double clockOffsetMs)
+{
+    int idx = indexOfClient(id);
+    if (idx == -1) return;
+    ClientEntry &e = m_clients[idx];
+    QVector<int> changed;
+    if (e.rttMs != rttMs) { e.rttMs = rttMs; changed << RttMsRole; }
+    if (e.clockOffsetMs != clockOffsetMs) { e.clockOffsetMs = clockOffsetMs; changed << ClockOffsetMsRole; }
+    if (changed.isEmpty()) return;
+    notifyChanged(idx, changed);
 }
 
 QString ClientModel::clientIdAt(int index) const
@@ -197,9 +564,37 @@ int ClientModel::configuredFpsAt(int index) const
     return m_clients.at(index).configuredFps;
 }
 
-int ClientModel::measuredFpsAt(int index) const
+double ClientModel::measuredFpsAt(int index) const
 {
     if (index < 0 || index >= m_clients.size())
-        return 0;
+        return 0.0;
     return m_clients.at(index).measuredFps;
 }
+
+int ClientModel::droppedFramesAt(int index) const
+{
+    if (index < 0 || index >= m_clients.size())
+        return 0;
+    return m_clients.at(index).droppedFrames;
+}
+
+int ClientModel::qualityAt(int index) const
+{
+    if (index < 0 || index >= m_clients.size())
+        return 0;
+    return m_clients.at(index).quality;
+}
+
+int ClientModel::avgFrameBytesAt(int index) const
+{
+    if (index < 0 || index >= m_clients.size())
+        return -1;
+    return m_traffic.avgFrameBytes.at(index);
+}
+
+double ClientModel::decodeMsAt(int index) const
+{
+    if (index < 0 || index >= m_clients.size())
+        return -1.0;
+    return m_traffic.decodeMs.at(index);
+}
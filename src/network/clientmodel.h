@@ -2,7 +2,12 @@
 #define CLIENTMODEL_H
 
 #include <QAbstractListModel>
+#include <QHash>
 #include <QVector>
+#include <QVariantMap>
+#include <memory>
+#include "rateestimator.h"
+#include "statshistory.h"
 
 struct ClientEntry {
     QString id;
@@ -10,14 +15,74 @@ struct ClientEntry {
     QString alias;
 
     int configuredFps = 0;   // FPS requested by server for this client
-    int measuredFps = 0;     // Measured FPS (updated once per accumulation window)
-    qint64 lastFrameTsMs = 0; // timestamp of last frame (ms)
+    double measuredFps = 0.0; // Measured FPS, to 0.1 (sliding window, published every 250 ms)
+    qint64 lastFrameTsMs = 0; // arrival of the last frame (ms, monotonic)
 
-    // Windowed accumulation for simple FPS measurement
+    int droppedFrames = 0;   // frames replaced before decode (latest-wins mailbox)
+
+    // Rate controller view of the uplink (0 / -1 until measured)
+    int quality = 0;         // JPEG quality currently requested from the client
+    int throughputKbps = 0;  // received payload rate
+    int queueDelayMs = -1;   // estimated queueing delay on the path
+
+    int thumbnailId = 0;     // bumped for every thumbnail received (preview grid refresh)
+
+    QString codec = QStringLiteral("MJPEG"); // negotiated stream encoding
+
+    // Latency per pipeline stage ({stage: {p50, p99, samples}}, ms) and the
+    // end-to-end percentiles from it (-1 until a frame was displayed)
+    QVariantMap latency;
+    double latencyP50Ms = -1.0;
+    double latencyP99Ms = -1.0;
+
+    // PING/PONG round trip and client clock minus server clock (ms, -1 / 0 until measured)
+    double rttMs = -1.0;
+    double clockOffsetMs = 0.0;
+
+    // Window of the frame size, decode and jitter statistics
     int framesInWindow = 0;
     qint64 windowStartMs = 0; // start timestamp of counting window (ms)
+
+    QVector<int> dirtyRoles; // changed since the last coalesced dataChanged
 };
 
+// Rolling traffic and decode statistics of the clients, one array per field
+// indexed by row (in step with ClientModel's rows). Frames and decodes only
+// add to the window fields; the published fields are computed when the 1 s
+// window closes and sent with the coalesced update. Frame rate and bytes/s
+// come from a sliding-window estimator per client instead, published more
+// often than the window closes.
+struct ClientTrafficStats {
+    // Sliding-window fps and bytes/s, and when they were last published (us, monotonic)
+    QVector<RateEstimator> rate;
+    QVector<qint64> ratePublishedUs;
+
+    // Current window
+    QVector<qint64> windowBytes;
+    QVector<qint64> windowDecodeUs;
+    QVector<int> windowDecodes;
+    QVector<qint64> lastArrivalMs;  // 0 before the first frame
+    QVector<qint64> lastGapMs;      // -1 before the second frame
+    QVector<double> jitterMs;       // smoothed |gap - previous gap|, gain 1/16 (RFC 3550)
+
+    // Published (-1 until measured)
+    QVector<int> bytesPerSecond;
+    QVector<int> avgFrameBytes;
+    QVector<double> decodeMs;
+    QVector<double> publishedJitterMs;
+    QVector<int> queueDepth;        // frames in the client's send queue (client report)
+
+    // Trend history, sampled once a second off the frame path
+    QVector<std::shared_ptr<StatsHistory>> history;
+    QVector<int> historyDrops;      // droppedFrames at the last sample
+
+    void append();
+    void removeAt(int row);
+    void clear();
+};
+
+class QTimer;
+
 class ClientModel : public QAbstractListModel
 {
     Q_OBJECT
@@ -27,7 +92,23 @@ public:
         StatusRole,
         AliasRole,
         ConfiguredFpsRole,
-        MeasuredFpsRole
+        MeasuredFpsRole,
+        DroppedFramesRole,
+        QualityRole,
+        ThroughputKbpsRole,
+        QueueDelayMsRole,
+        ThumbnailIdRole,
+        CodecRole,
+        LatencyRole,
+        LatencyP50MsRole,
+        LatencyP99MsRole,
+        RttMsRole,
+        ClockOffsetMsRole,
+        BytesPerSecondRole,
+        AvgFrameBytesRole,
+        DecodeMsRole,
+        JitterMsRole,
+        QueueDepthRole
     };
 
     Q_PROPERTY(int count READ count NOTIFY countChanged)
@@ -38,9 +119,21 @@ public:
     QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
     QHash<int, QByteArray> roleNames() const override;
 
+    // 0 (default): dataChanged per update. Otherwise role changes are collected
+    // and sent as one dataChanged over the changed rows at most every `ms`,
+    // so the per-frame statistics don't re-evaluate QML bindings per frame.
+    int updateIntervalMs() const;
+    void setUpdateIntervalMs(int ms);
+
+    // The clock frame arrivals are measured on (steady, ms)
+    static qint64 monotonicMs();
+
 public slots:
     void addClient(const QString& id, const QString& status = QString());
     void removeClient(const QString& id);
+    // Session resumption: the row (alias, configured fps, statistics) moves to
+    // the new session id in place; false when `from` is unknown or `to` taken
+    bool renameClient(const QString& from, const QString& to);
     void clear();
     void setClientStatus(const QString& id, const QString& status);
     void setClientAlias(const QString& id, const QString& alias);
@@ -49,19 +142,56 @@ public slots:
     Q_INVOKABLE QString clientIdAt(int index) const; 
     Q_INVOKABLE QString aliasAt(int index) const;
     Q_INVOKABLE int configuredFpsAt(int index) const;
-    Q_INVOKABLE int measuredFpsAt(int index) const;
+    Q_INVOKABLE double measuredFpsAt(int index) const;
+    Q_INVOKABLE int droppedFramesAt(int index) const;
+    Q_INVOKABLE int qualityAt(int index) const;
+    // Traffic statistics of the last window (-1 until measured)
+    Q_INVOKABLE int avgFrameBytesAt(int index) const;
+    Q_INVOKABLE double decodeMsAt(int index) const;
+    // Trend of a client for charts: {periodMs, timeMs, fps, bytesPerSecond,
+    // latencyMs, drops}, each a list oldest first, at the resolution nearest
+    // `resolutionSeconds` from below (1, 10, 60); the newest `maxPoints` (0: all)
+    Q_INVOKABLE QVariantMap historyAt(int index, int resolutionSeconds = 1, int maxPoints = 0) const;
     Q_INVOKABLE int count() const { return m_clients.size(); }
 
 public slots:
+    // Send the collected role changes now
+    void flushChanges();
+
     void setClientConfiguredFps(const QString& id, int fps);
-    void setClientMeasuredFps(const QString& id, int fps);
-    void recordFrameReceived(const QString& id, qint64 timestampMs = 0);
+    void setClientMeasuredFps(const QString& id, double fps);
+    // A frame (or UNCHANGED notice) arrived; timestampMs is on the model's
+    // monotonic clock (monotonicMs()), 0 for now
+    void recordFrameReceived(const QString& id, qint64 timestampMs = 0, qint64 bytes = 0);
+    void recordFrameDecoded(const QString& id, qint64 decodeUs);
+    void setClientQueueDepth(const QString& id, int queuedFrames);
+    void recordFramesDropped(const QString& id, int count);
+    void setClientRateStats(const QString& id, int quality, int throughputKbps, int queueDelayMs);
+    void recordThumbnail(const QString& id);
+    void setClientCodec(const QString& id, const QString& codec);
+    void setClientLatency(const QString& id, const QVariantMap& latency);
+    void setClientClock(const QString& id, double rttMs, double clockOffsetMs);
 
 signals:
     void countChanged(int newCount);
+    // A second's sample was added to every client's history
+    void historyUpdated();
 
 private:
+    void notifyChanged(int row, const QVector<int>& roles);
+    // Computes the published traffic stats of a closing window; returns the changed roles
+    QVector<int> publishTrafficStats(int row, int frames);
+    // Publishes the estimated fps and bytes/s at nowUs; returns the changed roles
+    QVector<int> publishRate(int row, qint64 nowUs);
+    void sampleHistory();
+
     QVector<ClientEntry> m_clients;
+    ClientTrafficStats m_traffic;
+    // id -> row, so per-frame lookups don't scan every client; rebuilt from the
+    // removed row onwards when a client leaves
+    QHash<QString, int> m_rows;
+    QTimer* m_flushTimer = nullptr;
+    QTimer* m_historyTimer = nullptr;
 };
 
 #endif // CLIENTMODEL_H
@@ -1,16 +1,16 @@
 #include "clientsession.h"
 #include <QWebSocket>
+#include <QSocketNotifier>
+#include <QRandomGenerator>
+#include <QUdpSocket>
+#include <QNetworkDatagram>
+#include <QTimer>
 #include <QUuid>
 #include <QDebug>
-#include <QImage>
-#include <QBuffer>
-
-#include "control.pb.h"
-
-using imagesocket::control::ControlMessage;
+#include "frametrace.h"
 
 ClientSession::ClientSession(QWebSocket* socket, QObject* parent)
-    : QObject(parent), m_socket(socket), m_id(QUuid::createUuid().toString())
+    : QObject(parent), m_socket(socket), m_id(QUuid::createUuid().toString()), m_parser(m_id)
 {
     if (m_socket) {
         m_socket->setParent(this);
@@ -18,11 +18,20 @@ ClientSession::ClientSession(QWebSocket* socket, QObject* parent)
         connect(m_socket, &QWebSocket::disconnected, this, &ClientSession::onSocketDisconnected);
         connect(m_socket, QOverload<QAbstractSocket::SocketError>::of(&QWebSocket::error), 
                 this, &ClientSession::onSocketError);
+        // Qt answers pings itself; our own pings are answered with pongs
+        connect(m_socket, &QWebSocket::pong, this, [this]() { m_keepalive.onReceived(); });
     }
 }
 
 ClientSession::~ClientSession()
 {
+    delete m_shmNotifier; // before the doorbell's descriptor is closed
+    if (m_udpSocket) {
+        const UdpAssemblyStats& stats = m_udpAssembler.stats();
+        qInfo() << "ClientSession" << m_id << "UDP frames:" << stats.frames << "delivered," << stats.recovered
+                << "recovered from parity," << stats.late + stats.expired << "lost," << stats.malformed
+                << "malformed datagrams";
+    }
     if (m_socket) {
         m_socket->deleteLater();
         m_socket = nullptr;
@@ -39,56 +48,213 @@ QWebSocket* ClientSession::socket() const
     return m_socket;
 }
 
-void ClientSession::sendControlMessage(const QByteArray& serialized)
+void ClientSession::sendControlMessage(const QByteArray& serialized, MessagePrefix prefix)
 {
     if (!m_socket)
         return;
 
     QByteArray out;
-    out.append(char(0x01)); // control prefix
+    out.reserve(serialized.size() + 1);
+    out.append(static_cast<char>(prefix)); // control (or control batch) prefix
     out.append(serialized);
+    if (m_relaying) {
+        m_relay.pushControl(out); // ahead of waiting frames, behind the one on the wire
+        writeRelayed();
+        return;
+    }
     m_socket->sendBinaryMessage(out);
 }
 
+void ClientSession::close(const QString& reason)
+{
+    if (m_socket)
+        m_socket->close(QWebSocketProtocol::CloseCodePolicyViolated, reason);
+}
+
+void ClientSession::attachSharedMemory(const QString& ringName)
+{
+    if (m_shmRing.isOpen())
+        return;
+    const std::string name = ringName.toStdString();
+    // The doorbell first: the client may ring it as soon as the ring is mapped
+    if (!m_shmDoorbell.listen(name) || !m_shmRing.open(name)) {
+        qWarning() << "ClientSession" << m_id << "shared memory ring" << ringName << "unusable:"
+                   << QString::fromStdString(m_shmDoorbell.isOpen() ? m_shmRing.errorString() : m_shmDoorbell.errorString());
+        m_shmDoorbell.close();
+        return;
+    }
+    m_shmNotifier = new QSocketNotifier(m_shmDoorbell.fd(), QSocketNotifier::Read, this);
+    connect(m_shmNotifier, &QSocketNotifier::activated, this, &ClientSession::readSharedMemory);
+    qInfo() << "ClientSession" << m_id << "reads frames from shared memory" << ringName;
+    readSharedMemory();
+}
+
+void ClientSession::openUdpChannel()
+{
+    if (m_udpSocket || !m_socket)
+        return;
+    m_udpSocket = new QUdpSocket(this);
+    if (!m_udpSocket->bind(QHostAddress::Any, 0)) {
+        qWarning() << "ClientSession" << m_id << "UDP channel unusable:" << m_udpSocket->errorString();
+        delete m_udpSocket;
+        m_udpSocket = nullptr;
+        return;
+    }
+    // The key keeps stray or stale datagrams (an earlier connection's) out
+    m_udpKey = QRandomGenerator::global()->generate();
+    m_udpClock.start();
+    connect(m_udpSocket, &QUdpSocket::readyRead, this, &ClientSession::readDatagrams);
+    qInfo() << "ClientSession" << m_id << "takes UDP frames on port" << m_udpSocket->localPort();
+    emit udpChannelOpened(m_id, m_udpSocket->localPort(), m_udpKey);
+}
+
+void ClientSession::startKeepalive(const KeepaliveConfig& config)
+{
+    m_keepalive.setConfig(config);
+    if (!m_keepalive.enabled() || !m_socket) {
+        delete m_keepaliveTimer;
+        m_keepaliveTimer = nullptr;
+        return;
+    }
+    if (!m_keepaliveTimer) {
+        m_keepaliveTimer = new QTimer(this);
+        connect(m_keepaliveTimer, &QTimer::timeout, this, &ClientSession::onKeepaliveTick);
+    }
+    m_keepaliveTimer->start(config.intervalMs);
+}
+
+void ClientSession::setMemoryAccount(const std::shared_ptr<MemoryBudget::Account>& account)
+{
+    m_parser.setMemoryAccount(account);
+}
+
+void ClientSession::onKeepaliveTick()
+{
+    if (!m_socket)
+        return;
+    switch (m_keepalive.tick()) {
+    case KeepaliveTracker::Ping:
+        m_socket->ping();
+        break;
+    case KeepaliveTracker::Expired:
+        qWarning() << "ClientSession" << m_id << "no answer to" << m_keepalive.missed() << "pings, dropping it";
+        m_keepaliveTimer->stop();
+        m_socket->abort(); // closing would wait for a close frame the peer never sends
+        break;
+    case KeepaliveTracker::None:
+        break;
+    }
+}
+
+void ClientSession::startRelay(int depth, OutboundDropPolicy policy)
+{
+    if (!m_socket)
+        return;
+    if (!m_relaying) {
+        m_relaying = true;
+        connect(m_socket, &QWebSocket::bytesWritten, this, &ClientSession::onBytesWritten);
+    }
+    m_relay.configure(static_cast<std::size_t>(qMax(1, depth)), policy);
+}
+
+void ClientSession::relayFrame(const QByteArray& message, RelayFrameKind kind)
+{
+    if (!m_relaying || !m_socket)
+        return;
+    if (m_relay.pushFrame(message, kind))
+        writeRelayed();
+}
+
+void ClientSession::writeRelayed()
+{
+    if (m_relay.writing() || m_relay.empty() || !m_socket)
+        return;
+    m_relay.beginWrite();
+    m_relayUnwritten = m_socket->sendBinaryMessage(m_relay.front());
+    if (m_relayUnwritten <= 0) {
+        m_relay.finishWrite(); // closing: nothing goes out anymore
+        m_relayUnwritten = 0;
+    }
+}
+
+void ClientSession::onBytesWritten(qint64 bytes)
+{
+    if (!m_relay.writing())
+        return;
+    // Counts the WebSocket frame header too: done within a few bytes of the end
+    m_relayUnwritten -= bytes;
+    if (m_relayUnwritten > 0)
+        return;
+    m_relayUnwritten = 0;
+    m_relay.finishWrite();
+    writeRelayed();
+}
+
+void ClientSession::readSharedMemory()
+{
+    m_shmDoorbell.drain();
+    // One ring's worth per turn: the thread's other sessions get their turn in between
+    for (std::uint32_t i = 0; i < m_shmRing.slotCount(); ++i) {
+        const bool read = m_shmRing.read([this](const std::uint8_t* data, std::size_t size) {
+            // The slot is reused once this returns: the frame gets its own copy
+            onBinaryMessageReceived(QByteArray(reinterpret_cast<const char*>(data), static_cast<int>(size)));
+        });
+        if (!read)
+            break;
+    }
+    if (!m_shmRing.prepareToWait())
+        QMetaObject::invokeMethod(this, [this]() { readSharedMemory(); }, Qt::QueuedConnection);
+}
+
+void ClientSession::readDatagrams()
+{
+    const QHostAddress peer = m_socket ? m_socket->peerAddress() : QHostAddress();
+    while (m_udpSocket->hasPendingDatagrams()) {
+        const QNetworkDatagram datagram = m_udpSocket->receiveDatagram();
+        const QByteArray data = datagram.data();
+        const auto* bytes = reinterpret_cast<const std::uint8_t*>(data.constData());
+        const std::size_t size = static_cast<std::size_t>(data.size());
+        if (!datagram.senderAddress().isEqual(peer, QHostAddress::TolerantConversion) || size < kUdpDatagramHeaderSize
+            || frameheader_detail::readLe(bytes + 4, 4) != m_udpKey)
+            continue;
+        m_udpAssembler.push(bytes, size, m_udpClock.nsecsElapsed() / 1000,
+                            [this](const std::uint8_t* message, std::size_t length) {
+            // Frames only: control goes over the WebSocket. The buffer is reused, so the frame gets its own copy.
+            if (length > 0 && message[0] != 0x01 && message[0] != 0x05)
+                onBinaryMessageReceived(QByteArray(reinterpret_cast<const char*>(message), static_cast<int>(length)));
+        });
+    }
+}
+
 void ClientSession::onBinaryMessageReceived(const QByteArray& message)
-{    
-    if (message.isEmpty()){
-        qWarning() << "Received empty message from client" << m_id;
-        return;}
-
-    const unsigned char prefix = static_cast<unsigned char>(message.at(0));
-    if (prefix == 0x01) {
-        // control message
-        QByteArray payload = message.mid(1);
-        ControlMessage msg;
-        if (!msg.ParseFromArray(payload.constData(), payload.size())) {
-            qWarning() << "Failed to parse ControlMessage from client" << m_id;
-            return;
-        }
-
-        qDebug() << "Received ControlMessage from client" << m_id << "type=" << msg.type();
-        // emit raw serialized form to avoid moc issues with protobuf type
-        emit controlMessageReceived(m_id, payload);
-    } else {
-        // image or other binary data
-        QByteArray payload;
-        if (prefix == 0x00)
-            payload = message.mid(1); // explicit image prefix
-        else
-            payload = message; // no prefix, assume whole payload is image
-
-        QImage img;
-        if (!img.loadFromData(reinterpret_cast<const uchar*>(payload.constData()), payload.size(), "JPEG")) {
-            qWarning() << "Failed to decode image from client" << m_id << "size" << payload.size();
-            return;
-        }
-
-        emit frameReceived(m_id, img);
+{
+    FrameTraceScope trace("socket read", "server");
+    m_keepalive.onReceived();
+    EncodedFrame frame;
+    ControlMessages control;
+    switch (m_parser.parse(message, frame, control)) {
+    case InboundParser::Control:
+        for (const ControlMessagePtr& msg : control)
+            emit controlMessageReceived(m_id, msg);
+        break;
+    case InboundParser::Frame: {
+        trace.setFrame(frame.timing().sequence);
+        FrameTraceScope dispatch("dispatch", "server", frame.timing().sequence);
+        emit encodedFrameReceived(m_id, frame);
+        break;
+    }
+    case InboundParser::Refused:
+        emit frameRefused(m_id, m_parser.lastRefusal().streamId, m_parser.lastRefusal().keyframeNeeded);
+        break;
+    case InboundParser::Invalid:
+        break;
     }
 }
 
 void ClientSession::onSocketDisconnected()
 {
+    if (m_relaying)
+        qInfo() << "ClientSession" << m_id << "viewer missed" << m_relay.droppedTotal() << "relayed frames";
     qInfo() << "ClientSession disconnected" << m_id;
     emit disconnected(m_id);
 }
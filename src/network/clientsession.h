@@ -1,12 +1,21 @@
 #ifndef CLIENTSESSION_H
 #define CLIENTSESSION_H
 
+#include <QElapsedTimer>
 #include <QObject>
 #include <QPointer>
+#include "encodedframe.h"
+#include "inboundparser.h"
+#include "keepalive.h"
+#include "outboundmessage.h"
+#include "relayqueue.h"
+#include "shmframering.h"
+#include "udpframing.h"
 
 class QWebSocket;
-
-namespace imagesocket { namespace control { class ControlMessage; } }
+class QSocketNotifier;
+class QTimer;
+class QUdpSocket;
 
 class ClientSession : public QObject
 {
@@ -18,22 +27,77 @@ public:
     QString id() const;
     QWebSocket* socket() const;
 
-    // send a serialized protobuf control message (raw bytes) to the peer
-    void sendControlMessage(const QByteArray& serialized);
+    // send a serialized protobuf control message (raw bytes) to the peer; a
+    // serialized ControlBatch with MessagePrefix::ControlBatch
+    void sendControlMessage(const QByteArray& serialized, MessagePrefix prefix = MessagePrefix::Control);
+    // Close the connection (admission control); disconnected() follows
+    void close(const QString& reason);
+    // Same-host client: also read its frames from the shared-memory ring `ringName`
+    void attachSharedMemory(const QString& ringName);
+    // Client offered UDP frames: open a port of our own for them (the system picks
+    // it) and announce it with udpChannelOpened(). Only datagrams from the
+    // WebSocket's peer address that carry the channel key count.
+    void openUdpChannel();
+    // Ping the client whenever a tick passes without hearing from it, and
+    // drop the connection after `config.maxMissed` unanswered pings in a row
+    // (disconnected() follows). A half-open connection is gone within
+    // seconds instead of when TCP gives up on it. Disabled with intervalMs 0.
+    void startKeepalive(const KeepaliveConfig& config);
+    // Charge the session's frames to `account`; refused ones are dropped and
+    // reported with frameRefused(). Call before the session starts reading.
+    void setMemoryAccount(const std::shared_ptr<MemoryBudget::Account>& account);
+
+    // Viewer session: from now on every write goes through a relay queue of
+    // `depth` frames; a new source starts over from its next keyframe
+    void startRelay(int depth, OutboundDropPolicy policy);
+    // Forward another client's frame message as received (shared, not copied)
+    void relayFrame(const QByteArray& message, RelayFrameKind kind);
 
 signals:
-    void controlMessageReceived(const QString& clientId, const QByteArray& serialized);
-    void frameReceived(const QString& clientId, const QImage& image);
+    void controlMessageReceived(const QString& clientId, const ControlMessagePtr& message);
+    // compressed (JPEG, H.264/H.265) or raw YUV payload plus receive metadata; decoding is left to the server
+    void encodedFrameReceived(const QString& clientId, const EncodedFrame& frame);
+    // A frame of `streamId` dropped on arrival, over the memory budget
+    void frameRefused(const QString& clientId, quint16 streamId, bool keyframeNeeded);
     void disconnected(const QString& clientId);
+    // Tell the client with UDP_CHANNEL
+    void udpChannelOpened(const QString& clientId, quint16 port, quint32 key);
 
 private slots:
     void onBinaryMessageReceived(const QByteArray& message);
     void onSocketDisconnected();
     void onSocketError();
+    void readSharedMemory();
+    void readDatagrams();
+    void onBytesWritten(qint64 bytes);
+    void onKeepaliveTick();
 
 private:
+    void writeRelayed();
+
     QPointer<QWebSocket> m_socket;
     QString m_id;
+    InboundParser m_parser;
+
+    KeepaliveTracker m_keepalive;
+    QTimer* m_keepaliveTimer = nullptr;
+
+    // Frames of a client on this host; the WebSocket still carries its control
+    ShmFrameRing m_shmRing;
+    ShmDoorbell m_shmDoorbell;
+    QSocketNotifier* m_shmNotifier = nullptr;
+
+    // Frames of a client on a lossy link, rebuilt from UDP datagrams
+    QUdpSocket* m_udpSocket = nullptr;
+    quint32 m_udpKey = 0;
+    UdpFrameAssembler m_udpAssembler;
+    QElapsedTimer m_udpClock;
+
+    // Viewer sessions only. QWebSocket buffers whatever it is given, so a
+    // message counts as in flight until bytesWritten() accounted for it.
+    bool m_relaying = false;
+    RelayQueue<QByteArray> m_relay;
+    qint64 m_relayUnwritten = 0;
 };
 
 #endif // CLIENTSESSION_H
@@ -0,0 +1,78 @@
+#ifndef CLOCKOFFSET_H
+#define CLOCKOFFSET_H
+
+#include <cstddef>
+#include <cstdint>
+
+// NTP-style estimate of a client's clock offset from PING/PONG exchanges.
+// Each exchange gives four timestamps (microseconds):
+//
+//   t0  PING sent      (server clock)
+//   t1  PING received  (client clock)
+//   t2  PONG sent      (client clock)
+//   t3  PONG received  (server clock)
+//
+//   rtt    = (t3 - t0) - (t2 - t1)
+//   offset = ((t1 - t0) + (t2 - t3)) / 2     (client clock - server clock)
+//
+// The offset is exact when both directions take the same time; queueing
+// makes them asymmetric, so like NTP's clock filter the estimate uses the
+// exchange with the lowest RTT among the last kWindow ones.
+//
+// Not synchronized; one instance per client.
+class ClockOffsetEstimator
+{
+public:
+    static const std::size_t kWindow = 8;
+
+    // Returns false (and ignores the exchange) for inconsistent timestamps
+    bool addExchange(std::int64_t t0, std::int64_t t1, std::int64_t t2, std::int64_t t3)
+    {
+        const std::int64_t rtt = (t3 - t0) - (t2 - t1);
+        if (t3 < t0 || t2 < t1 || rtt < 0)
+            return false;
+
+        Sample& slot = m_samples[m_next];
+        slot.rttUs = rtt;
+        slot.offsetUs = ((t1 - t0) + (t2 - t3)) / 2;
+        m_next = (m_next + 1) % kWindow;
+        if (m_count < kWindow)
+            ++m_count;
+        m_lastRttUs = rtt;
+
+        m_best = 0;
+        for (std::size_t i = 1; i < m_count; ++i) {
+            if (m_samples[i].rttUs < m_samples[m_best].rttUs)
+                m_best = i;
+        }
+        return true;
+    }
+
+    bool valid() const { return m_count > 0; }
+
+    // Client clock minus server clock; 0 until an exchange completed
+    std::int64_t offsetUs() const { return valid() ? m_samples[m_best].offsetUs : 0; }
+
+    // RTT of the exchange the offset comes from (the lowest in the window), -1 if none
+    std::int64_t minRttUs() const { return valid() ? m_samples[m_best].rttUs : -1; }
+
+    // RTT of the latest exchange, -1 if none
+    std::int64_t lastRttUs() const { return m_lastRttUs; }
+
+    // Convert a client timestamp to the server's clock
+    std::int64_t toServerTime(std::int64_t clientUs) const { return clientUs - offsetUs(); }
+
+private:
+    struct Sample {
+        std::int64_t rttUs = 0;
+        std::int64_t offsetUs = 0;
+    };
+
+    Sample m_samples[kWindow];
+    std::size_t m_count = 0;
+    std::size_t m_next = 0;
+    std::size_t m_best = 0;
+    std::int64_t m_lastRttUs = -1;
+};
+
+#endif // CLOCKOFFSET_H
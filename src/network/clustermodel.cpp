@@ -0,0 +1,130 @@
+#include "clustermodel.h"
+#include <algorithm>
+
+ClusterModel::ClusterModel(QObject* parent)
+    : QAbstractListModel(parent)
+{
+}
+
+int ClusterModel::rowCount(const QModelIndex& parent) const
+{
+    if (parent.isValid())
+        return 0;
+    return m_rows.size();
+}
+
+QVariant ClusterModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() < 0 || index.row() >= m_rows.size())
+        return QVariant();
+    const Row& row = m_rows.at(index.row());
+    switch (role) {
+    case NodeRole: return row.node;
+    case IdRole: return row.id;
+    case Qt::DisplayRole:
+    case AliasRole: return row.alias.isEmpty() ? row.id : row.alias;
+    case StatusRole: return row.status;
+    case MeasuredFpsRole: return row.measuredFps;
+    case ThroughputKbpsRole: return row.throughputKbps;
+    case LocalRole: return row.local;
+    default: return QVariant();
+    }
+}
+
+QHash<int, QByteArray> ClusterModel::roleNames() const
+{
+    QHash<int, QByteArray> roles;
+    roles[NodeRole] = "node";
+    roles[IdRole] = "clientId";
+    roles[AliasRole] = "alias";
+    roles[StatusRole] = "status";
+    roles[MeasuredFpsRole] = "measuredFps";
+    roles[ThroughputKbpsRole] = "throughputKbps";
+    roles[LocalRole] = "local";
+    return roles;
+}
+
+QStringList ClusterModel::nodes() const
+{
+    QStringList result;
+    for (const Row& row : m_rows) {
+        if (result.isEmpty() || result.last() != row.node)
+            result.append(row.node);
+    }
+    return result;
+}
+
+void ClusterModel::nodeRange(const QString& nodeId, int& first, int& size) const
+{
+    first = m_rows.size();
+    size = 0;
+    for (int i = 0; i < m_rows.size(); ++i) {
+        if (m_rows.at(i).node != nodeId)
+            continue;
+        if (size == 0)
+            first = i;
+        ++size;
+    }
+}
+
+void ClusterModel::setNodeClients(const QString& nodeId, const QVariantList& clients, bool local)
+{
+    QVector<Row> rows;
+    rows.reserve(clients.size());
+    for (const QVariant& client : clients) {
+        const QVariantMap map = client.toMap();
+        Row row;
+        row.node = nodeId;
+        row.id = map.value("id").toString();
+        row.alias = map.value("alias").toString();
+        row.status = map.value("status").toString();
+        row.measuredFps = map.value("measuredFps").toInt();
+        row.throughputKbps = map.value("throughputKbps").toInt();
+        row.local = local;
+        rows.append(row);
+    }
+
+    int first = 0;
+    int size = 0;
+    nodeRange(nodeId, first, size);
+
+    // Same cameras as before (the usual case, once a second): update in place
+    bool sameIds = size == rows.size();
+    for (int i = 0; sameIds && i < size; ++i)
+        sameIds = m_rows.at(first + i).id == rows.at(i).id;
+    if (sameIds) {
+        if (size == 0)
+            return;
+        std::copy(rows.constBegin(), rows.constEnd(), m_rows.begin() + first);
+        emit dataChanged(index(first, 0), index(first + size - 1, 0));
+        return;
+    }
+
+    if (size > 0) {
+        beginRemoveRows(QModelIndex(), first, first + size - 1);
+        m_rows.remove(first, size);
+        endRemoveRows();
+    }
+    if (!rows.isEmpty()) {
+        beginInsertRows(QModelIndex(), first, first + rows.size() - 1);
+        for (int i = 0; i < rows.size(); ++i)
+            m_rows.insert(first + i, rows.at(i));
+        endInsertRows();
+    }
+    emit countChanged(m_rows.size());
+}
+
+void ClusterModel::removeNode(const QString& nodeId)
+{
+    setNodeClients(nodeId, QVariantList());
+}
+
+void ClusterModel::clear()
+{
+    if (m_rows.isEmpty())
+        return;
+    beginResetModel();
+    m_rows.clear();
+    endResetModel();
+    emit countChanged(0);
+}
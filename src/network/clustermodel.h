@@ -0,0 +1,66 @@
+#ifndef CLUSTERMODEL_H
+#define CLUSTERMODEL_H
+
+#include <QAbstractListModel>
+#include <QString>
+#include <QStringList>
+#include <QVariantList>
+#include <QVector>
+
+// Every camera of the cluster in one list: this node's clients and those of
+// each peer, as its latest NodeReport lists them. The rows of one node stay
+// together; a node with new rows is appended. A node's rows are replaced with
+// each report, updated in place while its camera ids stay the same.
+class ClusterModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    enum Roles {
+        NodeRole = Qt::UserRole + 1,
+        IdRole,
+        AliasRole,
+        StatusRole,
+        MeasuredFpsRole,
+        ThroughputKbpsRole,
+        LocalRole
+    };
+
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
+
+    explicit ClusterModel(QObject* parent = nullptr);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    Q_INVOKABLE int count() const { return m_rows.size(); }
+    // Distinct nodes with at least one row
+    Q_INVOKABLE QStringList nodes() const;
+
+public slots:
+    // The node's clients: maps of id, alias, status, measuredFps and throughputKbps
+    void setNodeClients(const QString& nodeId, const QVariantList& clients, bool local = false);
+    void removeNode(const QString& nodeId);
+    void clear();
+
+signals:
+    void countChanged(int newCount);
+
+private:
+    struct Row {
+        QString node;
+        QString id;
+        QString alias;
+        QString status;
+        int measuredFps = 0;
+        int throughputKbps = 0;
+        bool local = false;
+    };
+
+    // First row of `nodeId` and how many it has; first is where a new node would go
+    void nodeRange(const QString& nodeId, int& first, int& size) const;
+
+    QVector<Row> m_rows;
+};
+
+#endif // CLUSTERMODEL_H
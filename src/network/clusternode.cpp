@@ -0,0 +1,215 @@
+#include "clusternode.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QHostInfo>
+#include <QNetworkDatagram>
+#include <QTimer>
+#include <QUdpSocket>
+#include <limits>
+#include "control.pb.h"
+
+namespace {
+const int kReportIntervalMs = 1000;
+// One report is one datagram: a node with more cameras than fit leaves the rest out of its list
+const int kMaxReportBytes = 60000;
+
+qint64 nowMs()
+{
+    return QDateTime::currentMSecsSinceEpoch();
+}
+} // namespace
+
+ClusterNode::ClusterNode(const QString& nodeId, ReportSource source, QObject* parent)
+    : QObject(parent), m_nodeId(nodeId), m_source(std::move(source))
+{
+}
+
+ClusterNode::~ClusterNode()
+{
+    stop();
+}
+
+QPair<QString, quint16> ClusterNode::parsePeer(const QString& peer)
+{
+    const QString trimmed = peer.trimmed();
+    const int colon = trimmed.lastIndexOf(QLatin1Char(':'));
+    if (colon <= 0)
+        return qMakePair(trimmed, quint16(0));
+    bool ok = false;
+    const uint port = trimmed.mid(colon + 1).toUInt(&ok);
+    QString host = trimmed.left(colon);
+    if (host.startsWith(QLatin1Char('[')) && host.endsWith(QLatin1Char(']')))
+        host = host.mid(1, host.size() - 2); // [v6]:port
+    return qMakePair(host, quint16(ok && port <= 65535 ? port : 0));
+}
+
+bool ClusterNode::start(quint16 port, const QStringList& peers, quint32 clusterKey)
+{
+    if (m_socket)
+        return false;
+
+    m_socket = new QUdpSocket(this);
+    if (!m_socket->bind(QHostAddress::Any, port)) {
+        qWarning() << "ClusterNode: can't bind UDP port" << port << ":" << m_socket->errorString();
+        delete m_socket;
+        m_socket = nullptr;
+        return false;
+    }
+    connect(m_socket, &QUdpSocket::readyRead, this, &ClusterNode::readDatagrams);
+
+    // Resolved once: peers are servers with fixed addresses
+    m_peers.clear();
+    for (const QString& peer : peers) {
+        const QPair<QString, quint16> endpoint = parsePeer(peer);
+        if (endpoint.first.isEmpty() || endpoint.second == 0) {
+            qWarning() << "ClusterNode: ignoring peer" << peer << "(expected host:port)";
+            continue;
+        }
+        QHostAddress address(endpoint.first);
+        if (address.isNull()) {
+            const QHostInfo info = QHostInfo::fromName(endpoint.first);
+            if (info.addresses().isEmpty()) {
+                qWarning() << "ClusterNode: can't resolve peer" << endpoint.first;
+                continue;
+            }
+            address = info.addresses().first();
+        }
+        m_peers.append(qMakePair(address, endpoint.second));
+    }
+
+    m_clusterKey = clusterKey;
+    m_reportTimer = new QTimer(this);
+    connect(m_reportTimer, &QTimer::timeout, this, [this]() {
+        sendReport();
+        expirePeers();
+    });
+    m_reportTimer->start(kReportIntervalMs);
+    sendReport();
+    qInfo() << "ClusterNode:" << m_nodeId << "on UDP port" << m_socket->localPort() << "with" << m_peers.size()
+            << "peers";
+    return true;
+}
+
+void ClusterNode::stop()
+{
+    if (!m_socket)
+        return;
+    delete m_reportTimer;
+    m_reportTimer = nullptr;
+    delete m_socket;
+    m_socket = nullptr;
+    m_peers.clear();
+    const std::vector<std::string> peers = m_placement.expire(std::numeric_limits<std::int64_t>::max());
+    for (const std::string& peer : peers)
+        emit nodeLost(QString::fromStdString(peer));
+}
+
+bool ClusterNode::isRunning() const
+{
+    return m_socket != nullptr;
+}
+
+quint16 ClusterNode::port() const
+{
+    return m_socket ? m_socket->localPort() : 0;
+}
+
+NodeLoad ClusterNode::nodeLoad(const imagesocket::control::NodeReport& report)
+{
+    NodeLoad load;
+    load.nodeId = report.node_id();
+    load.host = report.host();
+    load.port = report.port();
+    load.sessions = report.sessions();
+    load.maxSessions = report.max_sessions();
+    load.ingressBitsPerSecond = report.ingress_bits_per_second();
+    load.maxIngressBitsPerSecond = report.max_ingress_bits_per_second();
+    load.decodeMsPerSecond = report.decode_ms_per_second();
+    load.maxDecodeMsPerSecond = report.max_decode_ms_per_second();
+    load.cpuPercent = report.cpu_percent();
+    load.cpuCores = report.cpu_cores();
+    load.acceptsClients = report.accepts_clients();
+    return load;
+}
+
+bool ClusterNode::chooseNode(NodeLoad& target)
+{
+    if (!m_socket || !m_source)
+        return false;
+    NodeLoad self = nodeLoad(m_source());
+    self.nodeId = m_nodeId.toStdString();
+    return m_placement.choose(self, nowMs(), target);
+}
+
+void ClusterNode::placed(const QString& nodeId)
+{
+    m_placement.placed(nodeId.toStdString());
+}
+
+QList<NodeLoad> ClusterNode::peers() const
+{
+    QList<NodeLoad> result;
+    for (const NodeLoad& load : m_placement.peers(nowMs()))
+        result.append(load);
+    return result;
+}
+
+void ClusterNode::sendReport()
+{
+    if (!m_socket || !m_source || m_peers.isEmpty())
+        return;
+    imagesocket::control::NodeReport report = m_source();
+    report.set_node_id(m_nodeId.toStdString());
+    report.set_cluster_key(m_clusterKey);
+    while (report.ByteSizeLong() > static_cast<size_t>(kMaxReportBytes) && report.clients_size() > 0)
+        report.mutable_clients()->RemoveLast();
+
+    const std::string serialized = report.SerializeAsString();
+    const QByteArray datagram(serialized.data(), static_cast<int>(serialized.size()));
+    for (const auto& peer : qAsConst(m_peers))
+        m_socket->writeDatagram(datagram, peer.first, peer.second);
+}
+
+void ClusterNode::readDatagrams()
+{
+    while (m_socket && m_socket->hasPendingDatagrams()) {
+        const QNetworkDatagram datagram = m_socket->receiveDatagram();
+        const QByteArray data = datagram.data();
+        imagesocket::control::NodeReport report;
+        if (!report.ParseFromArray(data.constData(), data.size()) || report.node_id().empty())
+            continue;
+        if (report.cluster_key() != m_clusterKey || report.node_id() == m_nodeId.toStdString())
+            continue; // another cluster, or our own report looped back
+
+        NodeLoad load = nodeLoad(report);
+        if (load.host.empty()) {
+            // No advertised host: where it sent from (IPv4 peers arrive mapped on a dual-stack socket)
+            bool v4 = false;
+            const quint32 ipv4 = datagram.senderAddress().toIPv4Address(&v4);
+            load.host = (v4 ? QHostAddress(ipv4) : datagram.senderAddress()).toString().toStdString();
+        }
+        m_placement.update(load, nowMs());
+
+        QVariantList clients;
+        clients.reserve(report.clients_size());
+        for (const imagesocket::control::NodeClient& client : report.clients()) {
+            QVariantMap row;
+            row["id"] = QString::fromStdString(client.client_id());
+            row["alias"] = QString::fromStdString(client.alias());
+            row["status"] = QString::fromStdString(client.status());
+            row["measuredFps"] = client.measured_fps();
+            row["throughputKbps"] = client.throughput_kbps();
+            clients.append(row);
+        }
+        emit nodeReported(QString::fromStdString(report.node_id()), clients);
+    }
+}
+
+void ClusterNode::expirePeers()
+{
+    const std::vector<std::string> expired = m_placement.expire(nowMs());
+    for (const std::string& nodeId : expired) {
+        qInfo() << "ClusterNode: lost peer" << QString::fromStdString(nodeId);
+        emit nodeLost(QString::fromStdString(nodeId));
+    }
+}
@@ -0,0 +1,79 @@
+#ifndef CLUSTERNODE_H
+#define CLUSTERNODE_H
+
+#include <QHostAddress>
+#include <QList>
+#include <QObject>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <QVariantList>
+#include <functional>
+#include "clusterplacement.h"
+
+namespace imagesocket { namespace control { class NodeReport; } }
+
+class QTimer;
+class QUdpSocket;
+
+// One server of a cluster. Once a second it sends its NodeReport (load,
+// limits and clients, from the report source) as a UDP datagram to every
+// configured peer, and keeps the peers' reports for camera placement
+// (ClusterPlacement) and the cluster-wide client list. Reports with another
+// cluster key are ignored, so several clusters can share a network.
+//
+// Peers are listed on every node ("host:port", their cluster ports); a node
+// that is down simply drops out after ClusterPlacementConfig::staleAfterMs.
+// Lives on the GUI thread, like the bridge that owns it.
+class ClusterNode : public QObject
+{
+    Q_OBJECT
+public:
+    using ReportSource = std::function<imagesocket::control::NodeReport()>;
+
+    explicit ClusterNode(const QString& nodeId, ReportSource source, QObject* parent = nullptr);
+    ~ClusterNode() override; // stops
+
+    // Binds the UDP port (0 picks a free one) and starts reporting to
+    // `peers`; false when already running or the port can't be bound
+    bool start(quint16 port, const QStringList& peers, quint32 clusterKey = 0);
+    void stop();
+    bool isRunning() const;
+    quint16 port() const;
+    QString nodeId() const { return m_nodeId; }
+
+    // The node a connecting camera should be sent to, measured against this
+    // node's current report; false: it stays here
+    bool chooseNode(NodeLoad& target);
+    // A camera was redirected to `nodeId` (counts until its next report)
+    void placed(const QString& nodeId);
+    // Live peers, this node not included
+    QList<NodeLoad> peers() const;
+
+    // Load and limits of a report, as placement compares them
+    static NodeLoad nodeLoad(const imagesocket::control::NodeReport& report);
+    // "host:port" -> (host, port); port 0 when malformed
+    static QPair<QString, quint16> parsePeer(const QString& peer);
+
+signals:
+    // A peer's report arrived: its clients as maps of id, alias, status,
+    // measuredFps and throughputKbps
+    void nodeReported(const QString& nodeId, const QVariantList& clients);
+    // A peer was not heard from in time
+    void nodeLost(const QString& nodeId);
+
+private:
+    void sendReport();
+    void readDatagrams();
+    void expirePeers();
+
+    QString m_nodeId;
+    ReportSource m_source;
+    quint32 m_clusterKey = 0;
+    ClusterPlacement m_placement;
+    QList<QPair<QHostAddress, quint16>> m_peers;
+    QUdpSocket* m_socket = nullptr;
+    QTimer* m_reportTimer = nullptr;
+};
+
+#endif // CLUSTERNODE_H
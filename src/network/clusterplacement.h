@@ -0,0 +1,164 @@
+#ifndef CLUSTERPLACEMENT_H
+#define CLUSTERPLACEMENT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// Load of one server node, as it reports it to its peers (limits 0: unknown)
+struct NodeLoad {
+    std::string nodeId;
+    std::string host;  // where clients reach the node
+    int port = 0;
+    int sessions = 0;  // camera sessions
+    int maxSessions = 0;
+    double ingressBitsPerSecond = 0.0;
+    double maxIngressBitsPerSecond = 0.0;
+    double decodeMsPerSecond = 0.0;    // decode time summed over clients
+    double maxDecodeMsPerSecond = 0.0; // 1000 == one core
+    double cpuPercent = -1.0;          // of one core per 100 (-1: unknown)
+    int cpuCores = 1;
+    bool acceptsClients = true;        // false: draining, send nobody there
+};
+
+// Share of the node's busiest resource that is in use (0..1, above 1 when
+// over a limit), with `extraSessions` more cameras like the average one
+// already there. Resources without a known limit don't count.
+inline double nodeUtilization(const NodeLoad& load, int extraSessions = 0)
+{
+    const int sessions = std::max(0, load.sessions);
+    const double scale = sessions > 0 ? static_cast<double>(sessions + extraSessions) / sessions : 1.0;
+    double utilization = 0.0;
+    if (load.maxSessions > 0)
+        utilization = std::max(utilization, static_cast<double>(sessions + extraSessions) / load.maxSessions);
+    if (load.maxIngressBitsPerSecond > 0.0)
+        utilization = std::max(utilization, load.ingressBitsPerSecond * scale / load.maxIngressBitsPerSecond);
+    if (load.maxDecodeMsPerSecond > 0.0)
+        utilization = std::max(utilization, load.decodeMsPerSecond * scale / load.maxDecodeMsPerSecond);
+    if (load.cpuPercent >= 0.0)
+        utilization = std::max(utilization, load.cpuPercent * scale / (100.0 * std::max(1, load.cpuCores)));
+    return utilization;
+}
+
+struct ClusterPlacementConfig {
+    std::int64_t staleAfterMs = 5000; // a node not heard from for this long is left out
+    double margin = 0.1;              // redirect only to a node this much less utilized
+};
+
+// Where a connecting camera should go. Every node keeps the latest report of
+// each peer and, when a camera says HELLO, compares itself with them: the
+// camera is sent to the least-utilized live node if that one stays below
+// this node by at least `margin` with the camera added, otherwise it stays.
+// The margin keeps nodes of about equal load from passing cameras back and
+// forth on report noise.
+//
+// A redirect counts as one more session of its target until the target's
+// next report, so a burst of connections spreads over the peers instead of
+// all landing on the one that looked least loaded a second ago.
+//
+// Not thread-safe: owned by the GUI thread's ClusterNode.
+class ClusterPlacement
+{
+public:
+    explicit ClusterPlacement(const ClusterPlacementConfig& config = ClusterPlacementConfig()) : m_config(config) {}
+
+    void setConfig(const ClusterPlacementConfig& config) { m_config = config; }
+    const ClusterPlacementConfig& config() const { return m_config; }
+
+    // A peer's report; it replaces the previous one and its pending redirects
+    void update(const NodeLoad& load, std::int64_t nowMs)
+    {
+        Peer& peer = m_peers[load.nodeId];
+        peer.load = load;
+        peer.updatedMs = nowMs;
+        peer.pending = 0;
+    }
+
+    void remove(const std::string& nodeId) { m_peers.erase(nodeId); }
+
+    // Drops peers not heard from in time; returns their ids
+    std::vector<std::string> expire(std::int64_t nowMs)
+    {
+        std::vector<std::string> expired;
+        for (auto it = m_peers.begin(); it != m_peers.end();) {
+            if (nowMs - it->second.updatedMs > m_config.staleAfterMs) {
+                expired.push_back(it->first);
+                it = m_peers.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        return expired;
+    }
+
+    // Live peers, by node id
+    std::vector<NodeLoad> peers(std::int64_t nowMs) const
+    {
+        std::vector<NodeLoad> live;
+        for (const auto& entry : m_peers) {
+            if (nowMs - entry.second.updatedMs <= m_config.staleAfterMs)
+                live.push_back(entry.second.load);
+        }
+        return live;
+    }
+
+    // Redirects sent to `nodeId` since its last report
+    int pending(const std::string& nodeId) const
+    {
+        const auto it = m_peers.find(nodeId);
+        return it != m_peers.end() ? it->second.pending : 0;
+    }
+
+    // The node a new camera should move to; false: it stays. `self` is this
+    // node's load with the camera already counted.
+    bool choose(const NodeLoad& self, std::int64_t nowMs, NodeLoad& target) const
+    {
+        const double stay = nodeUtilization(self);
+        const Peer* best = nullptr;
+        double bestUtilization = 0.0;
+        for (const auto& entry : m_peers) {
+            const Peer& peer = entry.second;
+            if (peer.load.nodeId == self.nodeId || !peer.load.acceptsClients || peer.load.host.empty()
+                || peer.load.port <= 0 || nowMs - peer.updatedMs > m_config.staleAfterMs)
+                continue;
+            if (peer.load.maxSessions > 0 && peer.load.sessions + peer.pending >= peer.load.maxSessions)
+                continue; // would be refused
+            const double utilization = nodeUtilization(peer.load, peer.pending + 1);
+            if (!best || utilization < bestUtilization
+                || (utilization == bestUtilization && peer.load.sessions + peer.pending
+                                                          < best->load.sessions + best->pending)) {
+                best = &peer;
+                bestUtilization = utilization;
+            }
+        }
+        if (!best)
+            return false;
+        // A draining node hands off to anyone with room, otherwise only for a clear gain
+        if (self.acceptsClients && bestUtilization + m_config.margin > stay)
+            return false;
+        target = best->load;
+        return true;
+    }
+
+    // A camera was sent to `nodeId`
+    void placed(const std::string& nodeId)
+    {
+        const auto it = m_peers.find(nodeId);
+        if (it != m_peers.end())
+            ++it->second.pending;
+    }
+
+private:
+    struct Peer {
+        NodeLoad load;
+        std::int64_t updatedMs = 0;
+        int pending = 0;
+    };
+
+    ClusterPlacementConfig m_config;
+    std::map<std::string, Peer> m_peers;
+};
+
+#endif // CLUSTERPLACEMENT_H
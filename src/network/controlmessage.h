@@ -0,0 +1,123 @@
+#ifndef CONTROLMESSAGE_H
+#define CONTROLMESSAGE_H
+
+#include <QByteArray>
+#include <QMetaType>
+#include <QVarLengthArray>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <google/protobuf/arena.h>
+#include "control.pb.h"
+
+// A control message parsed once, where it is read, and handed to every
+// receiver by pointer: the session logs it, the server looks at HELLO and
+// SUBSCRIBE, the bridge acts on it, none of them parses the bytes again.
+// Shared across threads through queued signals (a registered metatype), so it
+// is immutable once parsed. Peers that negotiate control_batch send the
+// control queued at once as one ControlBatch message (prefix 0x05).
+using ControlMessagePtr = std::shared_ptr<const imagesocket::control::ControlMessage>;
+// The control messages of one WebSocket message: one, or the contents of a
+// ControlBatch (prefix 0x05) in order. Inline storage for the usual few.
+using ControlMessages = QVarLengthArray<ControlMessagePtr, 4>;
+
+namespace control_detail {
+
+// The message lives on an arena whose first block is part of the same object:
+// one allocation per parsed message, repeated fields and the string objects
+// included. Only strings longer than std::string's inline storage (15 bytes
+// with libstdc++: tokens, ring names) still get their characters from the
+// heap, and only an unusually large message (a long batch) makes the arena go
+// there too.
+template <typename Message>
+struct ArenaMessage {
+    static constexpr std::size_t kBlockSize = 512;
+
+    alignas(std::max_align_t) char block[kBlockSize];
+    google::protobuf::Arena arena;
+    Message* message;
+
+    ArenaMessage()
+        : arena(options(block))
+        , message(google::protobuf::Arena::CreateMessage<Message>(&arena))
+    {
+    }
+
+    static google::protobuf::ArenaOptions options(char* block)
+    {
+        google::protobuf::ArenaOptions options;
+        options.initial_block = block;
+        options.initial_block_size = kBlockSize;
+        return options;
+    }
+};
+
+// Tag of ControlBatch.messages (field 1, length-delimited)
+constexpr char kBatchEntryTag = 0x0A;
+
+} // namespace control_detail
+
+// Parses a serialized ControlMessage (no prefix byte); null when malformed
+inline ControlMessagePtr parseControlMessage(const char* data, int size)
+{
+    auto parsed = std::make_shared<control_detail::ArenaMessage<imagesocket::control::ControlMessage>>();
+    if (!parsed->message->ParseFromArray(data, size))
+        return nullptr;
+    return ControlMessagePtr(parsed, parsed->message);
+}
+
+// Parses a serialized ControlBatch (no prefix byte) and appends its messages,
+// in order, to `messages` (anything with push_back()). They share the batch's
+// arena, one allocation for the lot. False when malformed.
+template <typename Container>
+bool parseControlBatch(const char* data, int size, Container& messages)
+{
+    auto parsed = std::make_shared<control_detail::ArenaMessage<imagesocket::control::ControlBatch>>();
+    if (!parsed->message->ParseFromArray(data, size))
+        return false;
+    for (const imagesocket::control::ControlMessage& msg : parsed->message->messages())
+        messages.push_back(ControlMessagePtr(parsed, &msg));
+    return true;
+}
+
+// Appends one serialized ControlMessage to a serialized ControlBatch being
+// built in `batch` (QByteArray or std::string): field tag, length, bytes. A
+// queued message is batched as it is, without parsing it again.
+template <typename Bytes>
+void appendControlBatchEntry(Bytes& batch, const char* data, std::size_t size)
+{
+    char head[1 + 10]; // tag and a varint length
+    int headSize = 0;
+    head[headSize++] = control_detail::kBatchEntryTag;
+    std::size_t length = size;
+    do {
+        const unsigned char low = static_cast<unsigned char>(length & 0x7f);
+        length >>= 7;
+        head[headSize++] = static_cast<char>(length ? low | 0x80 : low);
+    } while (length);
+    batch.append(head, headSize);
+    batch.append(data, static_cast<int>(size));
+}
+
+// Appends `msg` serialized to `out`: sized once, written in place. Appending a
+// message to one already there merges them on the receiving side (scalars
+// set in the later one win), which is how a stream id is added to a message
+// without parsing it again.
+inline void appendControlMessage(QByteArray& out, const imagesocket::control::ControlMessage& msg)
+{
+    const int at = out.size();
+    out.resize(at + static_cast<int>(msg.ByteSizeLong()));
+    msg.SerializeWithCachedSizesToArray(reinterpret_cast<std::uint8_t*>(out.data() + at));
+}
+
+// `msg` serialized into one allocation (no std::string in between)
+inline QByteArray serializeControlMessage(const imagesocket::control::ControlMessage& msg)
+{
+    QByteArray out;
+    appendControlMessage(out, msg);
+    return out;
+}
+
+Q_DECLARE_METATYPE(ControlMessagePtr)
+
+#endif // CONTROLMESSAGE_H
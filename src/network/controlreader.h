@@ -0,0 +1,73 @@
+#ifndef CONTROLREADER_H
+#define CONTROLREADER_H
+
+#include <boost/beast/core/flat_buffer.hpp>
+#include <cstddef>
+#include <cstdint>
+#include "outboundmessage.h"
+
+// Inbound side of one client connection: every message is read into the same
+// buffer and a control message is parsed from it in place, into a message
+// object that is reused as well. Once the buffer and the message's fields have
+// grown to the largest message seen, reading and dispatching allocate nothing.
+//
+// Message is the protobuf ControlMessage (anything with ParseFromArray()).
+// A ControlBatch (prefix 0x05) is parsed into a batch message the caller
+// keeps, reused the same way.
+// Not synchronized: the connection's read loop owns it.
+template <typename Message>
+class ControlReader
+{
+public:
+    // Target of the next read
+    boost::beast::flat_buffer& buffer() { return m_buffer; }
+
+    // True when the buffered message carries the control prefix
+    bool isControl() const
+    {
+        const auto data = m_buffer.data();
+        return data.size() > 0
+            && *static_cast<const std::uint8_t*>(data.data()) == static_cast<std::uint8_t>(MessagePrefix::Control);
+    }
+
+    // True when the buffered message carries the control batch prefix
+    bool isBatch() const
+    {
+        const auto data = m_buffer.data();
+        return data.size() > 0
+            && *static_cast<const std::uint8_t*>(data.data()) == static_cast<std::uint8_t>(MessagePrefix::ControlBatch);
+    }
+
+    // Parses the buffered control batch into `batch`; false when malformed
+    template <typename Batch>
+    bool parseBatch(Batch& batch) const
+    {
+        if (!isBatch())
+            return false;
+        const auto data = m_buffer.data();
+        const char* bytes = static_cast<const char*>(data.data());
+        return batch.ParseFromArray(bytes + 1, static_cast<int>(data.size() - 1));
+    }
+
+    // Parses the buffered control message; null when malformed. The message
+    // stays valid until the next parse().
+    const Message* parse()
+    {
+        if (!isControl())
+            return nullptr;
+        const auto data = m_buffer.data(); // flat_buffer: one contiguous block
+        const char* bytes = static_cast<const char*>(data.data());
+        if (!m_message.ParseFromArray(bytes + 1, static_cast<int>(data.size() - 1)))
+            return nullptr;
+        return &m_message;
+    }
+
+    // Drops the buffered message, keeping the capacity for the next one
+    void consume() { m_buffer.consume(m_buffer.size()); }
+
+private:
+    boost::beast::flat_buffer m_buffer;
+    Message m_message;
+};
+
+#endif // CONTROLREADER_H
@@ -0,0 +1,185 @@
+#ifndef DECODESCHEDULER_H
+#define DECODESCHEDULER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// What a client's decoded frames are for, most urgent first
+enum class DecodePriority {
+    Active,     // the client on display
+    Preview,    // thumbnails, wall tiles, frame processors
+    Background, // anything else decoded (headless previews)
+};
+
+constexpr int kDecodePriorityCount = 3;
+
+// Which decode job a worker pool runs next, when there are more jobs than
+// workers. Jobs wait in one queue per priority class; a free worker takes
+// the most urgent class first and, within it, the job with the earliest
+// deadline. A job still waiting at its deadline is not worth decoding any
+// more (its client has sent newer frames meanwhile) and is handed back as
+// expired instead of started.
+//
+// The lower classes never hold the last `reservedWorkers` workers: however
+// many previews are queued, the active client's frame finds a worker free
+// and its decode doesn't wait behind theirs.
+//
+// Not synchronized: the owner guards it with its own lock. Times are
+// microseconds on any clock; deadline 0 means none.
+template <typename Job>
+class DecodeScheduler
+{
+public:
+    explicit DecodeScheduler(int workers = 1, int reservedWorkers = 1)
+    {
+        setWorkers(workers, reservedWorkers);
+    }
+
+    // Reserved workers are capped at workers - 1: a single worker serves every class
+    void setWorkers(int workers, int reservedWorkers = 1)
+    {
+        m_workers = std::max(1, workers);
+        m_reserved = std::max(0, std::min(reservedWorkers, m_workers - 1));
+    }
+
+    int workers() const { return m_workers; }
+    int reservedWorkers() const { return m_reserved; }
+
+    void push(Job job, DecodePriority priority, std::int64_t deadlineUs)
+    {
+        m_queues[index(priority)].push_back(Entry{std::move(job), deadlineUs, m_sequence++});
+    }
+
+    // Takes the job a worker should start at `nowUs`; false when nothing may
+    // start (no job, or no worker its class may use). Jobs past their
+    // deadline are first passed to onExpired(job, priority) and dropped; the
+    // callback may push jobs (a newer frame of the same client).
+    template <typename ExpiredFn>
+    bool next(std::int64_t nowUs, Job& job, DecodePriority& priority, ExpiredFn&& onExpired)
+    {
+        std::vector<std::pair<Job, DecodePriority>> expired;
+        while (collectExpired(nowUs, expired)) {
+            for (std::pair<Job, DecodePriority>& entry : expired)
+                onExpired(entry.first, entry.second);
+            expired.clear();
+        }
+        for (int p = 0; p < kDecodePriorityCount; ++p) {
+            std::vector<Entry>& queue = m_queues[p];
+            if (queue.empty())
+                continue;
+            if (!mayStart(p))
+                return false; // the lower classes may use even fewer workers
+            const auto earliest = std::min_element(queue.begin(), queue.end(), &Entry::before);
+            job = std::move(earliest->job);
+            queue.erase(earliest);
+            priority = static_cast<DecodePriority>(p);
+            ++m_running[p];
+            ++m_started[p];
+            return true;
+        }
+        return false;
+    }
+
+    // A job next() handed out has finished
+    void finished(DecodePriority priority)
+    {
+        int& running = m_running[index(priority)];
+        running = std::max(0, running - 1);
+    }
+
+    // Drops the queued jobs `match(job)` selects; returns how many
+    template <typename Predicate>
+    std::size_t removeIf(Predicate&& match)
+    {
+        std::size_t removed = 0;
+        for (std::vector<Entry>& queue : m_queues) {
+            const auto end = std::remove_if(queue.begin(), queue.end(),
+                                            [&](const Entry& entry) { return match(entry.job); });
+            removed += static_cast<std::size_t>(queue.end() - end);
+            queue.erase(end, queue.end());
+        }
+        return removed;
+    }
+
+    void clear()
+    {
+        for (std::vector<Entry>& queue : m_queues)
+            queue.clear();
+    }
+
+    std::size_t queued(DecodePriority priority) const { return m_queues[index(priority)].size(); }
+    int running(DecodePriority priority) const { return m_running[index(priority)]; }
+    int runningTotal() const
+    {
+        int total = 0;
+        for (int count : m_running)
+            total += count;
+        return total;
+    }
+    std::uint64_t started(DecodePriority priority) const { return m_started[index(priority)]; }
+    std::uint64_t expired(DecodePriority priority) const { return m_expired[index(priority)]; }
+
+private:
+    struct Entry {
+        Job job;
+        std::int64_t deadlineUs;
+        std::uint64_t sequence;
+
+        // Earliest deadline first, jobs without one after them; ties in push order
+        static bool before(const Entry& a, const Entry& b)
+        {
+            if ((a.deadlineUs > 0) != (b.deadlineUs > 0))
+                return a.deadlineUs > 0;
+            if (a.deadlineUs != b.deadlineUs)
+                return a.deadlineUs < b.deadlineUs;
+            return a.sequence < b.sequence;
+        }
+    };
+
+    static int index(DecodePriority priority)
+    {
+        return std::max(0, std::min(kDecodePriorityCount - 1, static_cast<int>(priority)));
+    }
+
+    bool mayStart(int priority) const
+    {
+        const int total = runningTotal();
+        if (total >= m_workers)
+            return false;
+        if (priority == index(DecodePriority::Active))
+            return true;
+        return total - m_running[index(DecodePriority::Active)] < m_workers - m_reserved;
+    }
+
+    // Moves the jobs past their deadline out of the queues; false when there were none
+    bool collectExpired(std::int64_t nowUs, std::vector<std::pair<Job, DecodePriority>>& expired)
+    {
+        for (int p = 0; p < kDecodePriorityCount; ++p) {
+            std::vector<Entry>& queue = m_queues[p];
+            auto it = queue.begin();
+            while (it != queue.end()) {
+                if (it->deadlineUs > 0 && it->deadlineUs <= nowUs) {
+                    expired.emplace_back(std::move(it->job), static_cast<DecodePriority>(p));
+                    it = queue.erase(it);
+                    ++m_expired[p];
+                } else {
+                    ++it;
+                }
+            }
+        }
+        return !expired.empty();
+    }
+
+    int m_workers = 1;
+    int m_reserved = 0;
+    std::vector<Entry> m_queues[kDecodePriorityCount];
+    int m_running[kDecodePriorityCount] = {};
+    std::uint64_t m_started[kDecodePriorityCount] = {};
+    std::uint64_t m_expired[kDecodePriorityCount] = {};
+    std::uint64_t m_sequence = 0;
+};
+
+#endif // DECODESCHEDULER_H
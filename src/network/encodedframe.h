@@ -0,0 +1,93 @@
+#ifndef ENCODEDFRAME_H
+#define ENCODEDFRAME_H
+
+#include <QByteArray>
+#include <QImage>
+#include <QMetaType>
+#include <chrono>
+#include <memory>
+#include "frameheader.h"
+
+// Pipeline timestamps of one frame (wall clock, microseconds since epoch), for
+// latency accounting. Capture and send delay come from the client's FrameHeader
+// and are on its clock.
+struct FrameTiming {
+    bool hasCapture = false;  // the client sent a FrameHeader
+    qint64 captureTimeUs = 0;
+    qint64 sendDelayUs = 0;   // capture until queued on the client
+    qint64 receivedAtUs = 0;
+    qint64 decodedAtUs = 0;   // 0 == shown without decoding (raw frames on the GPU)
+    quint32 sequence = 0;     // client's FrameHeader sequence, else the arrival counter (trace ids)
+};
+
+// Frame as received from a client, before any decoding.
+// The frame is a view into the original WebSocket message: `buffer` shares the
+// message's storage (implicit sharing, no copy) and `offset` skips the prefix
+// byte, so neither the session nor the decoder ever copies the payload.
+// Raw frames carry a RawFrameHeader (see rawframe.h) followed by YUV planes;
+// video packets a VideoPacketHeader (videopacket.h) followed by the bitstream.
+// Clients that send a FrameHeader (prefix 0x04, frameheader.h) also provide
+// their own sequence number, capture time and frame size; `offset` then
+// points past the prefix and the FrameHeader.
+struct EncodedFrame {
+    enum Format {
+        Jpeg,   // prefix 0x00 or none
+        RawYuv, // prefix 0x02
+        Video   // prefix 0x03, H.264 / H.265 (decodable only in order, from a keyframe)
+    };
+
+    QByteArray buffer;        // whole received message (shared, never detached)
+    int offset = 0;           // start of the compressed payload inside buffer
+    qint64 receivedAtMs = 0;  // server receive time (ms since epoch)
+    qint64 receivedAtUs = 0;  // same, in microseconds (latency accounting)
+    quint64 sequence = 0;     // per-session arrival counter
+    Format format = Jpeg;
+
+    bool hasHeader = false;   // `header` came from the client (prefix 0x04)
+    FrameHeader header;       // client metadata, defaults for bare prefixes
+    quint32 lostBefore = 0;   // frames missing right before this one (sequence gap)
+    // JPEG already decoded while it arrived (Beast backend, StreamingJpegDecoder),
+    // at the client's decode target; null: decode the payload as usual
+    QImage decoded;
+    // Share of the server's memory budget (MemoryBudget), released with the
+    // last copy of the frame; null: not counted. Drop it before keeping a
+    // frame for longer than it takes to pass through.
+    std::shared_ptr<const void> charge;
+
+    // Build a frame that views `message` starting at `payloadOffset`
+    static EncodedFrame fromMessage(const QByteArray& message, int payloadOffset, Format format = Jpeg)
+    {
+        EncodedFrame frame;
+        frame.buffer = message;
+        frame.offset = qBound(0, payloadOffset, message.size());
+        frame.format = format;
+        return frame;
+    }
+
+    FrameTiming timing() const
+    {
+        FrameTiming t;
+        t.hasCapture = hasHeader && header.captureTimeUs > 0;
+        t.captureTimeUs = header.captureTimeUs;
+        t.sendDelayUs = header.sendDelayUs;
+        t.receivedAtUs = receivedAtUs;
+        t.sequence = hasHeader ? header.sequence : static_cast<quint32>(sequence);
+        return t;
+    }
+
+    // Wall clock in microseconds, comparable with the clients' capture times
+    static qint64 nowUs()
+    {
+        using namespace std::chrono;
+        return duration_cast<microseconds>(system_clock::now().time_since_epoch()).count();
+    }
+
+    const char* data() const { return buffer.constData() + offset; }
+    int size() const { return buffer.size() - offset; }
+    bool isEmpty() const { return size() <= 0; }
+};
+
+Q_DECLARE_METATYPE(EncodedFrame)
+Q_DECLARE_METATYPE(FrameTiming)
+
+#endif // ENCODEDFRAME_H
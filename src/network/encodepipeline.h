@@ -0,0 +1,161 @@
+#ifndef ENCODEPIPELINE_H
+#define ENCODEPIPELINE_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Frames encoded by N worker threads and handed on in the order they were
+// submitted: each job gets a sequence number, finished outputs wait in a
+// reorder map until all earlier ones went out. One thread at a time runs the
+// emit callback (whichever worker completed the next frame), outside the lock,
+// so a client's send queue sees frames, and stamps its header sequence
+// numbers, in capture order while encoding scales with the cores.
+//
+// submit() blocks while `maxInFlight` jobs are queued or being encoded; a
+// capture stage in front (CaptureSource) then replaces frames instead of the
+// backlog growing. A job whose encode fails is skipped in the order.
+//
+// Encode callbacks run on the workers concurrently: anything stateful they
+// use has to be per thread (JpegCodec::forCurrentThread()).
+template <typename Job, typename Output>
+class EncodePipeline
+{
+public:
+    using Encode = std::function<bool(Job&, Output&)>;
+    using Emit = std::function<void(std::uint64_t, Output&)>;
+
+    EncodePipeline(int workers, Encode encode, Emit emit, std::size_t maxInFlight = 0)
+        : m_encode(std::move(encode)), m_emit(std::move(emit))
+    {
+        const int count = workers > 0 ? workers : 1;
+        m_maxInFlight = maxInFlight > 0 ? maxInFlight : static_cast<std::size_t>(count) * 2;
+        for (int i = 0; i < count; ++i)
+            m_workers.emplace_back(&EncodePipeline::work, this);
+    }
+
+    ~EncodePipeline()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_jobReady.notify_all();
+        for (std::thread& worker : m_workers)
+            worker.join();
+    }
+
+    EncodePipeline(const EncodePipeline&) = delete;
+    EncodePipeline& operator=(const EncodePipeline&) = delete;
+
+    // Queue a job; returns its sequence number
+    std::uint64_t submit(Job job)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_slotFree.wait(lock, [this]() { return inFlight() < m_maxInFlight; });
+        const std::uint64_t sequence = m_nextSubmit++;
+        m_jobs.emplace_back(sequence, std::move(job));
+        lock.unlock();
+        m_jobReady.notify_one();
+        return sequence;
+    }
+
+    // Wait until every submitted job was emitted (or skipped)
+    void flush()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_slotFree.wait(lock, [this]() { return m_nextEmit == m_nextSubmit && !m_emitting; });
+    }
+
+    int workerCount() const { return static_cast<int>(m_workers.size()); }
+
+    std::uint64_t emittedTotal() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_emitted;
+    }
+
+    std::uint64_t failedTotal() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_failed;
+    }
+
+private:
+    struct Done {
+        bool ok = false;
+        Output output;
+    };
+
+    std::size_t inFlight() const
+    {
+        return static_cast<std::size_t>(m_nextSubmit - m_nextEmit);
+    }
+
+    void work()
+    {
+        for (;;) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_jobReady.wait(lock, [this]() { return m_stopping || !m_jobs.empty(); });
+            if (m_jobs.empty())
+                return; // stopping
+            std::pair<std::uint64_t, Job> job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+            lock.unlock();
+
+            Done done;
+            done.ok = m_encode(job.second, done.output);
+
+            lock.lock();
+            m_done.emplace(job.first, std::move(done));
+            if (m_emitting)
+                continue; // the emitting worker picks it up
+            m_emitting = true;
+            auto next = m_done.find(m_nextEmit);
+            while (next != m_done.end()) {
+                Done ready = std::move(next->second);
+                m_done.erase(next);
+                const std::uint64_t sequence = m_nextEmit;
+                lock.unlock();
+                if (ready.ok)
+                    m_emit(sequence, ready.output);
+                lock.lock();
+                if (ready.ok)
+                    ++m_emitted;
+                else
+                    ++m_failed;
+                ++m_nextEmit;
+                m_slotFree.notify_all();
+                next = m_done.find(m_nextEmit);
+            }
+            m_emitting = false;
+            m_slotFree.notify_all();
+        }
+    }
+
+    Encode m_encode;
+    Emit m_emit;
+    std::size_t m_maxInFlight = 2;
+    std::vector<std::thread> m_workers;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_jobReady; // workers: job or stop
+    std::condition_variable m_slotFree; // submit() and flush(): emitted
+    std::deque<std::pair<std::uint64_t, Job>> m_jobs;
+    std::map<std::uint64_t, Done> m_done; // encoded, waiting for earlier frames
+    std::uint64_t m_nextSubmit = 0;
+    std::uint64_t m_nextEmit = 0;
+    bool m_emitting = false;
+    bool m_stopping = false;
+    std::uint64_t m_emitted = 0;
+    std::uint64_t m_failed = 0;
+};
+
+#endif // ENCODEPIPELINE_H
@@ -0,0 +1,192 @@
+#ifndef ERASURECODE_H
+#define ERASURECODE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Systematic Reed-Solomon erasure code over GF(2^8) with a Cauchy matrix:
+// k data shards are sent as they are, followed by m parity shards, and any k
+// of the k + m that arrive give back the data. Parity shard j is
+//   sum over i of data_i / (x_j + y_i)   with x_j = k + j, y_i = i
+// (addition is XOR), and every square submatrix of a Cauchy matrix is
+// invertible, so the lost data shards solve from as many received parity
+// shards. k + m <= 256; all shards of a block have the same size.
+//
+// Encoding costs m multiply-adds per data byte; decoding only runs when data
+// shards are missing, and then costs one per lost shard per received byte.
+
+namespace erasure_detail {
+
+// Multiplication tables of GF(2^8), polynomial x^8 + x^4 + x^3 + x^2 + 1 (0x11d)
+struct GfTables {
+    std::uint8_t exp[512];
+    std::uint8_t log[256];
+
+    GfTables()
+    {
+        unsigned value = 1;
+        for (int i = 0; i < 255; ++i) {
+            exp[i] = static_cast<std::uint8_t>(value);
+            log[value] = static_cast<std::uint8_t>(i);
+            value <<= 1;
+            if (value & 0x100)
+                value ^= 0x11d;
+        }
+        for (int i = 255; i < 512; ++i)
+            exp[i] = exp[i - 255];
+        log[0] = 0; // never used: 0 is handled before any lookup
+    }
+};
+
+inline const GfTables& gfTables()
+{
+    static const GfTables tables;
+    return tables;
+}
+
+inline std::uint8_t gfMul(std::uint8_t a, std::uint8_t b)
+{
+    if (a == 0 || b == 0)
+        return 0;
+    const GfTables& t = gfTables();
+    return t.exp[t.log[a] + t.log[b]];
+}
+
+inline std::uint8_t gfInv(std::uint8_t a)
+{
+    const GfTables& t = gfTables();
+    return a == 0 ? 0 : t.exp[255 - t.log[a]];
+}
+
+// dst ^= c * src over `size` bytes
+inline void gfMulAdd(std::uint8_t* dst, const std::uint8_t* src, std::uint8_t c, std::size_t size)
+{
+    if (c == 0)
+        return;
+    if (c == 1) {
+        for (std::size_t i = 0; i < size; ++i)
+            dst[i] ^= src[i];
+        return;
+    }
+    // One 256-entry row of the product table per call: a lookup per byte
+    const GfTables& t = gfTables();
+    std::uint8_t row[256];
+    row[0] = 0;
+    const int logC = t.log[c];
+    for (int v = 1; v < 256; ++v)
+        row[v] = t.exp[logC + t.log[v]];
+    for (std::size_t i = 0; i < size; ++i)
+        dst[i] ^= row[src[i]];
+}
+
+// Coefficient of data shard `i` in parity shard `j` of a block of `k` data shards
+inline std::uint8_t cauchy(int k, int j, int i)
+{
+    return gfInv(static_cast<std::uint8_t>((k + j) ^ i));
+}
+
+} // namespace erasure_detail
+
+// Fill `m` parity shards from `k` data shards of `size` bytes each
+inline bool erasureEncode(const std::uint8_t* const* data, int k, std::uint8_t* const* parity, int m, std::size_t size)
+{
+    using namespace erasure_detail;
+    if (k <= 0 || m < 0 || k + m > 256)
+        return false;
+    for (int j = 0; j < m; ++j) {
+        std::uint8_t* out = parity[j];
+        for (std::size_t b = 0; b < size; ++b)
+            out[b] = 0;
+        for (int i = 0; i < k; ++i)
+            gfMulAdd(out, data[i], cauchy(k, j, i), size);
+    }
+    return true;
+}
+
+// Rebuild the missing data shards in place. `data[i]` is writable storage for
+// every shard, holding it where `haveData[i]` is non-zero; `parity[j]` is read
+// where `haveParity[j]` is. False when fewer than k shards arrived.
+inline bool erasureRecover(std::uint8_t* const* data, const std::uint8_t* haveData, int k,
+                           const std::uint8_t* const* parity, const std::uint8_t* haveParity, int m, std::size_t size)
+{
+    using namespace erasure_detail;
+    if (k <= 0 || m < 0 || k + m > 256)
+        return false;
+    std::vector<int> lost;
+    for (int i = 0; i < k; ++i) {
+        if (!haveData[i])
+            lost.push_back(i);
+    }
+    if (lost.empty())
+        return true;
+    std::vector<int> rows;
+    for (int j = 0; j < m && rows.size() < lost.size(); ++j) {
+        if (haveParity[j])
+            rows.push_back(j);
+    }
+    const std::size_t e = lost.size();
+    if (rows.size() < e)
+        return false;
+
+    // Each used parity shard less the data shards that did arrive: what the lost ones add up to
+    std::vector<std::uint8_t> residual(e * size);
+    for (std::size_t r = 0; r < e; ++r) {
+        std::uint8_t* out = residual.data() + r * size;
+        const std::uint8_t* in = parity[rows[r]];
+        for (std::size_t b = 0; b < size; ++b)
+            out[b] = in[b];
+        for (int i = 0; i < k; ++i) {
+            if (haveData[i])
+                gfMulAdd(out, data[i], cauchy(k, rows[r], i), size);
+        }
+    }
+
+    // Invert the e x e Cauchy submatrix (Gauss-Jordan; it is never singular)
+    std::vector<std::uint8_t> a(e * e);
+    std::vector<std::uint8_t> inv(e * e, 0);
+    for (std::size_t r = 0; r < e; ++r) {
+        for (std::size_t c = 0; c < e; ++c)
+            a[r * e + c] = cauchy(k, rows[r], lost[c]);
+        inv[r * e + r] = 1;
+    }
+    for (std::size_t col = 0; col < e; ++col) {
+        std::size_t pivot = col;
+        while (pivot < e && a[pivot * e + col] == 0)
+            ++pivot;
+        if (pivot == e)
+            return false;
+        if (pivot != col) {
+            for (std::size_t c = 0; c < e; ++c) {
+                std::swap(a[pivot * e + c], a[col * e + c]);
+                std::swap(inv[pivot * e + c], inv[col * e + c]);
+            }
+        }
+        const std::uint8_t scale = gfInv(a[col * e + col]);
+        for (std::size_t c = 0; c < e; ++c) {
+            a[col * e + c] = gfMul(a[col * e + c], scale);
+            inv[col * e + c] = gfMul(inv[col * e + c], scale);
+        }
+        for (std::size_t r = 0; r < e; ++r) {
+            const std::uint8_t factor = a[r * e + col];
+            if (r == col || factor == 0)
+                continue;
+            for (std::size_t c = 0; c < e; ++c) {
+                a[r * e + c] ^= gfMul(factor, a[col * e + c]);
+                inv[r * e + c] ^= gfMul(factor, inv[col * e + c]);
+            }
+        }
+    }
+
+    for (std::size_t l = 0; l < e; ++l) {
+        std::uint8_t* out = data[lost[l]];
+        for (std::size_t b = 0; b < size; ++b)
+            out[b] = 0;
+        for (std::size_t r = 0; r < e; ++r)
+            gfMulAdd(out, residual.data() + r * size, inv[l * e + r], size);
+    }
+    return true;
+}
+
+#endif // ERASURECODE_H
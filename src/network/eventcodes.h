@@ -19,6 +19,9 @@ enum EventCode {
     ClientDisconnected = 2001,
     ClientBecameActive = 2002,
     NoClientsAvailable = 2003,
+    ConnectionRejected = 2004,         // session limit reached {address, reason}
+    ClientThrottled = 2005,            // over the ingress cap, sent SET_FPS {clientId, alias, fps}
+    ClientOverloadDisconnected = 2006, // still over the ingress cap after throttling {clientId, reason}
 
     // FPS (3000-3999)
     FpsApplied = 3000,
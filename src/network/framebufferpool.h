@@ -0,0 +1,88 @@
+#ifndef FRAMEBUFFERPOOL_H
+#define FRAMEBUFFERPOOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Recycles encoded-frame byte buffers so steady-state encoding does not allocate.
+// acquire() hands out a shared_ptr whose deleter returns the vector (with its
+// capacity intact) to the pool once the last holder, typically the client's
+// write handler, releases it. Buffers released after the pool is destroyed are
+// simply freed.
+//
+// Thread-safe: buffers may be released from any thread.
+class FrameBufferPool
+{
+public:
+    using Buffer = std::vector<std::uint8_t>;
+
+    explicit FrameBufferPool(std::size_t maxIdle = 4)
+        : m_state(std::make_shared<State>())
+    {
+        m_state->maxIdle = maxIdle;
+    }
+
+    // Empty buffer (size 0) that keeps the capacity of a previously released one
+    std::shared_ptr<Buffer> acquire()
+    {
+        Buffer* raw = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(m_state->mutex);
+            if (!m_state->idle.empty()) {
+                raw = m_state->idle.back().release();
+                m_state->idle.pop_back();
+                ++m_state->reused;
+            } else {
+                ++m_state->allocated;
+            }
+        }
+        if (!raw)
+            raw = new Buffer();
+        raw->clear();
+
+        std::weak_ptr<State> weak = m_state;
+        return std::shared_ptr<Buffer>(raw, [weak](Buffer* buffer) {
+            std::unique_ptr<Buffer> owned(buffer);
+            if (auto state = weak.lock()) {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                if (state->idle.size() < state->maxIdle)
+                    state->idle.push_back(std::move(owned));
+            }
+        });
+    }
+
+    std::size_t idleCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        return m_state->idle.size();
+    }
+
+    // Buffers created because none was idle / buffers handed out again
+    std::uint64_t allocatedCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        return m_state->allocated;
+    }
+
+    std::uint64_t reusedCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        return m_state->reused;
+    }
+
+private:
+    struct State {
+        mutable std::mutex mutex;
+        std::vector<std::unique_ptr<Buffer>> idle;
+        std::size_t maxIdle = 4;
+        std::uint64_t allocated = 0;
+        std::uint64_t reused = 0;
+    };
+
+    std::shared_ptr<State> m_state;
+};
+
+#endif // FRAMEBUFFERPOOL_H
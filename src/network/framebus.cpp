@@ -0,0 +1,191 @@
+#include "framebus.h"
+#include <QMetaObject>
+#include <QMutexLocker>
+#include <deque>
+#include <vector>
+
+struct FrameBus::Subscriber {
+    QObject* context = nullptr;
+    Handler handler;
+    Options options;
+
+    QMutex mutex; // guards everything below
+    std::deque<FramePtr> pending;   // publish order, all clients
+    QHash<QString, int> queued;     // pending frames per client
+    bool scheduled = false;         // a drain is posted to the context
+    bool active = true;             // cleared on unsubscribe / context destruction
+    quint64 dropped = 0;
+
+    bool accepts(const BusFrame& frame) const
+    {
+        return (options.kinds & frame.kind) != 0
+            && (options.clientId.isEmpty() || options.clientId == frame.clientId);
+    }
+
+    // Requires `mutex`; false when the policy refused the frame
+    bool enqueue(const FramePtr& frame)
+    {
+        int& count = queued[frame->clientId];
+        if (count >= options.depth) {
+            ++dropped;
+            if (options.policy == DropPolicy::DropNewest)
+                return false;
+            for (auto it = pending.begin(); it != pending.end(); ++it) {
+                if ((*it)->clientId == frame->clientId) {
+                    pending.erase(it);
+                    break;
+                }
+            }
+            --count;
+        }
+        pending.push_back(frame);
+        ++count;
+        return true;
+    }
+};
+
+FrameBus::FrameBus(QObject* parent)
+    : QObject(parent)
+{
+}
+
+FrameBus::~FrameBus()
+{
+    QMutexLocker lock(&m_mutex);
+    for (const std::shared_ptr<Subscriber>& subscriber : qAsConst(m_subscribers)) {
+        QMutexLocker subscriberLock(&subscriber->mutex);
+        subscriber->active = false;
+        subscriber->pending.clear();
+    }
+    m_subscribers.clear();
+}
+
+int FrameBus::subscribe(QObject* context, Handler handler, const Options& options)
+{
+    if (!context || !handler)
+        return 0;
+
+    auto subscriber = std::make_shared<Subscriber>();
+    subscriber->context = context;
+    subscriber->handler = std::move(handler);
+    subscriber->options = options;
+    subscriber->options.depth = qMax(1, options.depth);
+
+    int id = 0;
+    {
+        QMutexLocker lock(&m_mutex);
+        id = m_nextId++;
+        m_subscribers.insert(id, subscriber);
+    }
+    // Direct: runs in the destroying thread, before any further post to the context
+    connect(context, &QObject::destroyed, this, [this, id]() { unsubscribe(id); }, Qt::DirectConnection);
+    emit subscribersChanged();
+    return id;
+}
+
+void FrameBus::unsubscribe(int id)
+{
+    std::shared_ptr<Subscriber> subscriber;
+    {
+        QMutexLocker lock(&m_mutex);
+        subscriber = m_subscribers.take(id);
+    }
+    if (!subscriber)
+        return;
+    {
+        QMutexLocker lock(&subscriber->mutex);
+        subscriber->active = false;
+        subscriber->pending.clear();
+        subscriber->queued.clear();
+    }
+    emit subscribersChanged();
+}
+
+void FrameBus::publish(BusFrame frame)
+{
+    std::vector<std::shared_ptr<Subscriber>> targets;
+    FramePtr shared;
+    {
+        QMutexLocker lock(&m_mutex);
+        frame.sequence = ++m_sequence;
+        if (m_subscribers.isEmpty())
+            return;
+        shared = std::make_shared<const BusFrame>(std::move(frame));
+        for (const std::shared_ptr<Subscriber>& subscriber : qAsConst(m_subscribers)) {
+            if (subscriber->accepts(*shared))
+                targets.push_back(subscriber);
+        }
+    }
+
+    for (const std::shared_ptr<Subscriber>& subscriber : targets) {
+        QMutexLocker lock(&subscriber->mutex);
+        if (!subscriber->active || !subscriber->enqueue(shared) || subscriber->scheduled)
+            continue;
+        subscriber->scheduled = true;
+        // Posted under the lock: the context can't be destroyed in between (see subscribe())
+        QMetaObject::invokeMethod(subscriber->context, [subscriber]() { drain(subscriber); }, Qt::QueuedConnection);
+    }
+}
+
+void FrameBus::drain(const std::shared_ptr<Subscriber>& subscriber)
+{
+    // Only what was queued when the drain started: a producer that keeps up
+    // with the handler must not keep the context's event loop from running
+    std::size_t budget = 0;
+    {
+        QMutexLocker lock(&subscriber->mutex);
+        budget = subscriber->pending.size();
+    }
+
+    for (; budget > 0; --budget) {
+        FramePtr frame;
+        {
+            QMutexLocker lock(&subscriber->mutex);
+            if (!subscriber->active || subscriber->pending.empty())
+                break;
+            frame = std::move(subscriber->pending.front());
+            subscriber->pending.pop_front();
+            auto it = subscriber->queued.find(frame->clientId);
+            if (it != subscriber->queued.end() && --it.value() <= 0)
+                subscriber->queued.erase(it);
+        }
+        subscriber->handler(frame);
+    }
+
+    QMutexLocker lock(&subscriber->mutex);
+    if (subscriber->active && !subscriber->pending.empty()) {
+        QMetaObject::invokeMethod(subscriber->context, [subscriber]() { drain(subscriber); }, Qt::QueuedConnection);
+        return;
+    }
+    subscriber->scheduled = false;
+}
+
+int FrameBus::subscriberCount() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_subscribers.size();
+}
+
+bool FrameBus::hasSubscriber(int kinds, const QString& clientId) const
+{
+    QMutexLocker lock(&m_mutex);
+    for (const std::shared_ptr<Subscriber>& subscriber : qAsConst(m_subscribers)) {
+        if ((subscriber->options.kinds & kinds) != 0
+            && (subscriber->options.clientId.isEmpty() || subscriber->options.clientId == clientId))
+            return true;
+    }
+    return false;
+}
+
+quint64 FrameBus::droppedFrames(int id) const
+{
+    std::shared_ptr<Subscriber> subscriber;
+    {
+        QMutexLocker lock(&m_mutex);
+        subscriber = m_subscribers.value(id);
+    }
+    if (!subscriber)
+        return 0;
+    QMutexLocker lock(&subscriber->mutex);
+    return subscriber->dropped;
+}
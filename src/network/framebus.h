@@ -0,0 +1,90 @@
+#ifndef FRAMEBUS_H
+#define FRAMEBUS_H
+
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <functional>
+#include <memory>
+#include "encodedframe.h"
+
+// One frame as published on the FrameBus. Immutable once published; the
+// payload (QByteArray / QImage) is implicitly shared, so every subscriber
+// sees the same bytes and nobody copies them.
+struct BusFrame {
+    enum Kind {
+        Encoded = 0x1, // as received, before decoding
+        Decoded = 0x2  // RGB32 image from the decoder
+    };
+
+    Kind kind = Encoded;
+    QString clientId;
+    quint64 sequence = 0;  // bus-wide publish order
+    FrameTiming timing;    // capture time on the server's clock when known
+    EncodedFrame encoded;  // Encoded frames
+    QImage image;          // Decoded frames
+};
+
+using FramePtr = std::shared_ptr<const BusFrame>;
+
+// Publish/subscribe hand-off of frames inside the server. Each subscriber
+// (display, recorder, relay, analytics, ...) has its own bounded queue per
+// client and its own drop policy, and is called on its context object's
+// thread. A slow subscriber only drops its own frames: publish() never waits
+// for anyone.
+//
+// Thread-safe: publish and (un)subscribe from any thread.
+class FrameBus : public QObject
+{
+    Q_OBJECT
+public:
+    enum class DropPolicy {
+        DropOldest, // keep the latest frames (live display)
+        DropNewest  // keep what is queued, refuse new frames (in-order consumers)
+    };
+
+    struct Options {
+        int depth = 1;                               // frames queued per client
+        DropPolicy policy = DropPolicy::DropOldest;
+        int kinds = BusFrame::Encoded | BusFrame::Decoded;
+        QString clientId;                            // empty: every client
+    };
+
+    using Handler = std::function<void(const FramePtr&)>;
+
+    explicit FrameBus(QObject* parent = nullptr);
+    ~FrameBus() override;
+
+    // `handler` runs on `context`'s thread; the subscription ends with it.
+    // Returns the subscription id.
+    int subscribe(QObject* context, Handler handler, const Options& options = Options());
+    void unsubscribe(int id);
+
+    // Stamps the sequence number and queues the frame for every matching subscriber
+    void publish(BusFrame frame);
+
+    int subscriberCount() const;
+    // Whether a subscriber takes frames of one of `kinds` from the client
+    // (producers skip work nobody consumes, e.g. decoding)
+    bool hasSubscriber(int kinds, const QString& clientId) const;
+    // Frames a subscriber lost to its drop policy
+    quint64 droppedFrames(int id) const;
+
+signals:
+    // A subscription started or ended (emitted on the (un)subscribing thread)
+    void subscribersChanged();
+
+private:
+    struct Subscriber;
+
+    static void drain(const std::shared_ptr<Subscriber>& subscriber);
+
+    mutable QMutex m_mutex;
+    QHash<int, std::shared_ptr<Subscriber>> m_subscribers;
+    int m_nextId = 1;
+    quint64 m_sequence = 0;
+};
+
+#endif // FRAMEBUS_H
@@ -0,0 +1,307 @@
+#include "framedecoder.h"
+#include "frametrace.h"
+#include "imagepool.h"
+#include "jpegcodec.h"
+#include "rawframe.h"
+#include "threadroles.h"
+#include "videocodec.h"
+#include <QThreadPool>
+#include <QThread>
+#include <QMutexLocker>
+#include <QMetaObject>
+#include <QDebug>
+
+namespace {
+// Frames a video client may queue behind the one being decoded before packets are dropped
+const std::size_t kVideoMailboxCapacity = 8;
+} // namespace
+
+struct FrameDecoder::VideoSlot {
+    std::unique_ptr<VideoDecoder> decoder;
+};
+
+FrameDecoder::FrameDecoder(QObject* parent)
+    : QObject(parent)
+{
+    // Private pool so decode work never competes with other users of the global pool
+    m_pool = new QThreadPool(this);
+    m_pool->setMaxThreadCount(qMax(1, QThread::idealThreadCount()));
+    m_scheduler.setWorkers(m_pool->maxThreadCount());
+}
+
+FrameDecoder::~FrameDecoder()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_queues.clear();
+        m_scheduler.clear();
+    }
+    m_pool->clear();
+    m_pool->waitForDone();
+}
+
+int FrameDecoder::maxThreadCount() const
+{
+    return m_pool->maxThreadCount();
+}
+
+void FrameDecoder::setMaxThreadCount(int count)
+{
+    Notices notices;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_pool->setMaxThreadCount(qMax(1, count));
+        m_scheduler.setWorkers(m_pool->maxThreadCount());
+        dispatchLocked(notices);
+    }
+    emitNotices(notices);
+}
+
+void FrameDecoder::setPriority(const QString& clientId, DecodePriority priority)
+{
+    QMutexLocker locker(&m_mutex);
+    if (priority == DecodePriority::Background)
+        m_priorities.remove(clientId);
+    else
+        m_priorities.insert(clientId, priority);
+}
+
+DecodePriority FrameDecoder::priority(const QString& clientId) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_priorities.value(clientId, DecodePriority::Background);
+}
+
+int FrameDecoder::deadlineMs(DecodePriority priority) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_deadlinesMs[static_cast<int>(priority)];
+}
+
+void FrameDecoder::setDeadlineMs(DecodePriority priority, int ms)
+{
+    QMutexLocker locker(&m_mutex);
+    m_deadlinesMs[static_cast<int>(priority)] = qMax(0, ms);
+}
+
+int FrameDecoder::mailboxCapacity() const
+{
+    return m_mailboxCapacity;
+}
+
+void FrameDecoder::setMailboxCapacity(int capacity)
+{
+    QMutexLocker locker(&m_mutex);
+    m_mailboxCapacity = qMax(1, capacity);
+    for (auto it = m_queues.begin(); it != m_queues.end(); ++it)
+        it.value().pending.setCapacity(static_cast<std::size_t>(m_mailboxCapacity));
+}
+
+bool FrameDecoder::decodeFrame(const EncodedFrame& frame, QImage& out, const QSize& target)
+{
+    const uchar* data = reinterpret_cast<const uchar*>(frame.data());
+    if (frame.format == EncodedFrame::Jpeg && !frame.decoded.isNull()) {
+        // Decoded while it arrived, at the target of that moment: close enough for one frame after a resize
+        out = frame.decoded;
+        return true;
+    }
+    if (frame.format == EncodedFrame::Jpeg)
+        return JpegCodec::forCurrentThread().decodeScaled(data, frame.size(), target.width(), target.height(), out);
+
+    RawFrameHeader header;
+    if (!parseRawFrameHeader(data, static_cast<std::size_t>(frame.size()), header))
+        return false;
+    QImage image = ImagePool::shared().acquire(header.width, header.height);
+    if (image.isNull())
+        return false;
+    yuvToRgb32(rawFrameView(header, data), image.bits(), image.bytesPerLine());
+    out = image;
+    return true;
+}
+
+bool FrameDecoder::decodeVideo(VideoSlot& slot, const EncodedFrame& frame, QImage& out)
+{
+    const std::uint8_t* data = reinterpret_cast<const std::uint8_t*>(frame.data());
+    const std::size_t size = static_cast<std::size_t>(frame.size());
+    VideoPacketHeader header;
+    if (!parseVideoPacketHeader(data, size, header))
+        return false;
+
+    // Keyframes start a fresh stream, possibly in another codec
+    if (!slot.decoder || slot.decoder->codec() != header.codec)
+        slot.decoder = VideoDecoder::create(header.codec);
+    if (!slot.decoder)
+        return false;
+    return slot.decoder->decode(data + kVideoPacketHeaderSize, size - kVideoPacketHeaderSize, out);
+}
+
+void FrameDecoder::submit(const QString& clientId, const EncodedFrame& frame)
+{
+    Notices notices;
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_queues.find(clientId);
+        if (it == m_queues.end()) {
+            ClientQueue queue;
+            queue.pending.setCapacity(static_cast<std::size_t>(m_mailboxCapacity));
+            queue.video = std::make_shared<VideoSlot>();
+            it = m_queues.insert(clientId, queue);
+        }
+
+        ClientQueue& queue = it.value();
+        const bool video = frame.format == EncodedFrame::Video;
+        if (video && queue.pending.capacity() < kVideoMailboxCapacity)
+            queue.pending.setCapacity(kVideoMailboxCapacity);
+        const std::size_t dropped = queue.pending.push(frame);
+        if (dropped > 0)
+            notices.dropped[clientId] += static_cast<int>(dropped);
+        if (video && dropped > 0) {
+            // The packets still queued reference the dropped ones
+            queue.awaitingKeyframe = true;
+            notices.keyframeNeeded.insert(clientId);
+        }
+        if (!queue.busy) {
+            startNextLocked(clientId, queue, notices);
+            dispatchLocked(notices);
+        }
+    }
+    emitNotices(notices);
+}
+
+void FrameDecoder::removeClient(const QString& clientId)
+{
+    QMutexLocker locker(&m_mutex);
+    m_queues.remove(clientId);
+    m_scheduler.removeIf([&clientId](const Job& job) { return job.clientId == clientId; });
+}
+
+void FrameDecoder::setTargetSize(const QString& clientId, const QSize& size)
+{
+    QMutexLocker locker(&m_mutex);
+    if (size.isEmpty())
+        m_targets.remove(clientId);
+    else
+        m_targets.insert(clientId, size);
+}
+
+void FrameDecoder::startNextLocked(const QString& clientId, ClientQueue& queue, Notices& notices)
+{
+    EncodedFrame next;
+    for (;;) {
+        if (!queue.pending.take(next)) {
+            queue.busy = false;
+            return;
+        }
+        if (next.format != EncodedFrame::Video)
+            break;
+
+        // A video packet is only decodable once the decoder has seen a keyframe
+        VideoPacketHeader header;
+        if (parseVideoPacketHeader(reinterpret_cast<const std::uint8_t*>(next.data()),
+                                   static_cast<std::size_t>(next.size()), header)
+            && (header.keyframe || !queue.awaitingKeyframe)) {
+            queue.awaitingKeyframe = false;
+            break;
+        }
+        ++notices.dropped[clientId];
+        notices.keyframeNeeded.insert(clientId);
+    }
+
+    queue.busy = true;
+    const DecodePriority priority = m_priorities.value(clientId, DecodePriority::Background);
+    const qint64 deadlineMs = m_deadlinesMs[static_cast<int>(priority)];
+    // From now, not the frame's arrival: the wait behind the client's own previous decode doesn't count
+    const qint64 deadlineUs = next.format == EncodedFrame::Video || deadlineMs == 0
+        ? 0 : EncodedFrame::nowUs() + deadlineMs * 1000;
+    m_scheduler.push(Job{clientId, next, queue.video}, priority, deadlineUs);
+}
+
+void FrameDecoder::dispatchLocked(Notices& notices)
+{
+    Job job;
+    DecodePriority priority;
+    const auto expired = [this, &notices](const Job& late, DecodePriority) {
+        // Too late to be worth a worker: the client's newer frame, if any, takes its place
+        ++notices.dropped[late.clientId];
+        auto it = m_queues.find(late.clientId);
+        if (it != m_queues.end())
+            startNextLocked(late.clientId, it.value(), notices);
+    };
+    while (m_scheduler.next(EncodedFrame::nowUs(), job, priority, expired))
+        run(job, priority, m_targets.value(job.clientId));
+}
+
+void FrameDecoder::run(const Job& job, DecodePriority priority, const QSize& target)
+{
+    const QString clientId = job.clientId;
+    const EncodedFrame next = job.frame;
+    const std::shared_ptr<VideoSlot> video = job.video;
+    m_pool->start([this, clientId, next, video, target, priority]() {
+        // Decode straight from the received message, past its prefix byte,
+        // with this worker thread's codec (or the client's video decoder)
+        FrameTrace::setThreadName("decoder");
+        ThreadRoles::apply(ThreadRole::Decode);
+        FrameTraceScope trace("decode", "server", next.timing().sequence);
+        QImage img;
+        const bool ok = next.format == EncodedFrame::Video
+            ? decodeVideo(*video, next, img)
+            : decodeFrame(next, img, target);
+        if (!ok)
+            img = QImage();
+        FrameTiming timing = next.timing();
+        timing.decodedAtUs = EncodedFrame::nowUs();
+
+        // Marshal the result back to the decoder's thread
+        const int size = next.size();
+        QMetaObject::invokeMethod(this, [this, clientId, priority, img, size, ok, timing]() {
+            finishJob(clientId, priority, img, size, !ok, timing);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void FrameDecoder::finishJob(const QString& clientId, DecodePriority priority, const QImage& image,
+                             int payloadSize, bool failed, const FrameTiming& timing)
+{
+    Notices notices;
+    bool reported = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_scheduler.finished(priority);
+        auto it = m_queues.find(clientId);
+        if (it != m_queues.end()) {
+            // Otherwise the client went away while the job was running
+            reported = true;
+            ClientQueue& queue = it.value();
+            if (failed && queue.video->decoder) {
+                // The reference pictures may be damaged: resynchronize on a keyframe
+                queue.awaitingKeyframe = true;
+                notices.keyframeNeeded.insert(clientId);
+            }
+            startNextLocked(clientId, queue, notices);
+        }
+        // The worker is free for whoever is next, this client or another
+        dispatchLocked(notices);
+    }
+    emitNotices(notices);
+    if (!reported)
+        return;
+
+    if (failed) {
+        qWarning() << "Failed to decode image from client" << clientId << "size" << payloadSize;
+        emit decodeFailed(clientId, payloadSize);
+        return;
+    }
+    if (image.isNull())
+        return; // video packet that completed no picture
+
+    emit frameTimed(clientId, timing);
+    emit frameDecoded(clientId, image);
+}
+
+void FrameDecoder::emitNotices(const Notices& notices)
+{
+    for (auto it = notices.dropped.constBegin(); it != notices.dropped.constEnd(); ++it)
+        emit framesDropped(it.key(), it.value());
+    for (const QString& clientId : notices.keyframeNeeded)
+        emit keyframeNeeded(clientId);
+}
@@ -0,0 +1,131 @@
+#ifndef FRAMEDECODER_H
+#define FRAMEDECODER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QSet>
+#include <QSize>
+#include <memory>
+#include "decodescheduler.h"
+#include "encodedframe.h"
+#include "framemailbox.h"
+
+class QThreadPool;
+
+// Decodes JPEG payloads (and converts raw YUV frames to RGB32) on a bounded
+// worker pool (sized to the number of cores).
+// Frames of the same client are decoded strictly in arrival order: at most one
+// job per client is in flight and newer frames wait in a latest-wins mailbox
+// (single slot by default). Frames replaced before being decoded are dropped and
+// reported through framesDropped(). Results are delivered on the decoder's own
+// thread (normally the GUI thread); the next job only starts once the previous
+// result has been delivered, so a slow consumer causes drops, not queue growth.
+//
+// H.264/H.265 packets go through a decoder kept per client. Their pictures
+// reference earlier ones, so such clients get a deeper mailbox, and after a drop
+// or decode error packets are skipped until the next keyframe (keyframeNeeded()).
+//
+// When more clients have a frame ready than there are workers, the clients'
+// priorities (setPriority()) decide who goes next (DecodeScheduler): the
+// active client first, with a worker the others never take, then previews,
+// then the rest. A JPEG or raw frame still waiting for a worker at its
+// class's deadline is dropped in favour of the client's newer one.
+// Video packets are never late: the pictures after them reference them.
+class FrameDecoder : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FrameDecoder(QObject* parent = nullptr);
+    ~FrameDecoder() override;
+
+    // Queue a compressed frame for decoding
+    void submit(const QString& clientId, const EncodedFrame& frame);
+
+    // Drop queued work for a client (in-flight jobs finish but are not reported)
+    void removeClient(const QString& clientId);
+
+    // Area the client's frames are shown in: JPEG frames are decoded at the
+    // smallest 1/2, 1/4 or 1/8 DCT scale that still covers it. An empty size
+    // (the default) decodes at full size. Kept across removeClient().
+    void setTargetSize(const QString& clientId, const QSize& size);
+
+    // Class of the client's next frames; Background until set. Kept across removeClient().
+    void setPriority(const QString& clientId, DecodePriority priority);
+    DecodePriority priority(const QString& clientId) const;
+
+    // How long a frame of `priority` may wait for a worker; 0: no deadline.
+    // Defaults: none for Active, 250 ms Preview, 1 s Background.
+    int deadlineMs(DecodePriority priority) const;
+    void setDeadlineMs(DecodePriority priority, int ms);
+
+    // Workers; one is kept for the Active class when there are two or more
+    int maxThreadCount() const;
+    void setMaxThreadCount(int count);
+
+    // Number of frames allowed to wait per client behind the one being decoded
+    int mailboxCapacity() const;
+    void setMailboxCapacity(int capacity);
+
+    // Decode one frame on the calling thread: JPEG through its codec (scaled to
+    // `target` as for setTargetSize()) unless it came decoded already
+    // (EncodedFrame::decoded), raw YUV by CPU conversion to
+    // QImage::Format_RGB32. False for invalid payloads.
+    static bool decodeFrame(const EncodedFrame& frame, QImage& out, const QSize& target = QSize());
+
+signals:
+    // Timestamps of the frame about to be reported by frameDecoded() (emitted right before it)
+    void frameTimed(const QString& clientId, const FrameTiming& timing);
+    void frameDecoded(const QString& clientId, const QImage& image);
+    void decodeFailed(const QString& clientId, int payloadSize);
+    void framesDropped(const QString& clientId, int count);
+    // The client's video stream can't be decoded until its next keyframe
+    void keyframeNeeded(const QString& clientId);
+
+private:
+    struct VideoSlot; // per-client video decoder, only used by that client's (serialized) jobs
+
+    struct ClientQueue {
+        FrameMailbox<EncodedFrame> pending;
+        bool busy = false;  // a frame is scheduled or being decoded
+        bool awaitingKeyframe = true; // video: packets before the next keyframe are skipped
+        std::shared_ptr<VideoSlot> video;
+    };
+
+    // A client's frame waiting in the scheduler for a worker
+    struct Job {
+        QString clientId;
+        EncodedFrame frame;
+        std::shared_ptr<VideoSlot> video;
+    };
+
+    // Drops and keyframe requests collected under the lock, emitted after it
+    struct Notices {
+        QHash<QString, int> dropped;
+        QSet<QString> keyframeNeeded;
+    };
+
+    // Schedule the next frame of a client; requires m_mutex to be held. Video
+    // packets skipped while waiting for a keyframe go into `notices`.
+    void startNextLocked(const QString& clientId, ClientQueue& queue, Notices& notices);
+    // Start scheduled jobs on free workers; requires m_mutex to be held
+    void dispatchLocked(Notices& notices);
+    void run(const Job& job, DecodePriority priority, const QSize& target);
+    void finishJob(const QString& clientId, DecodePriority priority, const QImage& image, int payloadSize,
+                   bool failed, const FrameTiming& timing);
+    void emitNotices(const Notices& notices);
+    static bool decodeVideo(VideoSlot& slot, const EncodedFrame& frame, QImage& out);
+
+    QThreadPool* m_pool = nullptr;
+    mutable QMutex m_mutex; // guards m_queues, m_targets, m_priorities, m_scheduler, m_deadlinesMs
+    QHash<QString, ClientQueue> m_queues;
+    QHash<QString, QSize> m_targets;
+    QHash<QString, DecodePriority> m_priorities;
+    DecodeScheduler<Job> m_scheduler;
+    int m_deadlinesMs[kDecodePriorityCount] = {0, 250, 1000};
+    int m_mailboxCapacity = 1;
+};
+
+#endif // FRAMEDECODER_H
@@ -0,0 +1,160 @@
+#ifndef FRAMEHEADER_H
+#define FRAMEHEADER_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Per-frame metadata (wire prefix 0x04), enabled by the server with
+// FRAME_HEADER so older peers keep the bare prefixes. A fixed little-endian
+// header describes the frame, followed by the payload exactly as it would be
+// sent without it (JPEG, raw frame or video packet, each with its own header):
+//
+//   byte 0       header size (24; larger values leave room for new fields)
+//   byte 1       payload format (FramePayload, same values as the bare prefixes)
+//   byte 2       flags (bit 0: keyframe, decodable without earlier frames)
+//   byte 3       reserved, 0
+//   bytes 4-7    sequence number, +1 per frame handed to the client (wraps)
+//   bytes 8-15   capture time, microseconds since epoch on the client's clock
+//   bytes 16-17  width (0 if unknown)
+//   bytes 18-19  height (0 if unknown)
+//   bytes 20-21  stream id (0 = main stream; up to kMaxStreamsPerConnection
+//                streams share one connection, higher ids count as 0)
+//   bytes 22-23  send delay: capture until queued for sending, in 100 us units
+//
+// The server reads it without touching the payload: frame order, loss and
+// age are known before anything is decoded.
+const std::size_t kFrameHeaderSize = 24;
+const std::uint8_t kFrameHeaderKeyframe = 0x01;
+// Streams one client connection may multiplex (stream ids 0..15)
+const std::uint16_t kMaxStreamsPerConnection = 16;
+
+enum class FramePayload : std::uint8_t {
+    Jpeg = 0x00,
+    RawYuv = 0x02,
+    Video = 0x03
+};
+
+struct FrameHeader {
+    FramePayload payload = FramePayload::Jpeg;
+    bool keyframe = true;
+    std::uint32_t sequence = 0;
+    std::int64_t captureTimeUs = 0;
+    int width = 0;
+    int height = 0;
+    std::uint16_t streamId = 0;
+    std::int64_t sendDelayUs = 0; // encoding time on the client; saturates at ~6.5 s
+};
+
+namespace frameheader_detail {
+
+inline std::uint64_t readLe(const std::uint8_t* data, int bytes)
+{
+    std::uint64_t value = 0;
+    for (int i = bytes - 1; i >= 0; --i)
+        value = (value << 8) | data[i];
+    return value;
+}
+
+inline void writeLe(std::uint8_t* data, std::uint64_t value, int bytes)
+{
+    for (int i = 0; i < bytes; ++i) {
+        data[i] = static_cast<std::uint8_t>(value & 0xFF);
+        value >>= 8;
+    }
+}
+
+} // namespace frameheader_detail
+
+// Write kFrameHeaderSize bytes to `out`. Sizes outside 0-65535 are sent as 0 (unknown).
+inline void writeFrameHeader(const FrameHeader& header, std::uint8_t* out)
+{
+    using frameheader_detail::writeLe;
+    const auto dimension = [](int value) {
+        return value > 0 && value <= 0xFFFF ? static_cast<std::uint64_t>(value) : 0u;
+    };
+    out[0] = static_cast<std::uint8_t>(kFrameHeaderSize);
+    out[1] = static_cast<std::uint8_t>(header.payload);
+    out[2] = header.keyframe ? kFrameHeaderKeyframe : 0;
+    out[3] = 0;
+    writeLe(out + 4, header.sequence, 4);
+    writeLe(out + 8, static_cast<std::uint64_t>(header.captureTimeUs), 8);
+    writeLe(out + 16, dimension(header.width), 2);
+    writeLe(out + 18, dimension(header.height), 2);
+    writeLe(out + 20, header.streamId, 2);
+    const std::int64_t sendDelay = header.sendDelayUs > 0 ? (header.sendDelayUs + 50) / 100 : 0;
+    writeLe(out + 22, static_cast<std::uint64_t>(sendDelay < 0xFFFF ? sendDelay : 0xFFFF), 2);
+}
+
+// Read the header of a framed message (prefix byte excluded). `headerSize` is
+// set to the offset of the payload. Fails on truncated headers and unknown
+// payload formats.
+inline bool parseFrameHeader(const std::uint8_t* data, std::size_t size, FrameHeader& header,
+                             std::size_t& headerSize)
+{
+    using frameheader_detail::readLe;
+    if (!data || size < kFrameHeaderSize)
+        return false;
+    const std::size_t declared = data[0];
+    if (declared < kFrameHeaderSize || declared > size)
+        return false;
+    if (data[1] != static_cast<std::uint8_t>(FramePayload::Jpeg)
+        && data[1] != static_cast<std::uint8_t>(FramePayload::RawYuv)
+        && data[1] != static_cast<std::uint8_t>(FramePayload::Video))
+        return false;
+
+    header.payload = static_cast<FramePayload>(data[1]);
+    header.keyframe = (data[2] & kFrameHeaderKeyframe) != 0;
+    header.sequence = static_cast<std::uint32_t>(readLe(data + 4, 4));
+    header.captureTimeUs = static_cast<std::int64_t>(readLe(data + 8, 8));
+    header.width = static_cast<int>(readLe(data + 16, 2));
+    header.height = static_cast<int>(readLe(data + 18, 2));
+    header.streamId = static_cast<std::uint16_t>(readLe(data + 20, 2));
+    header.sendDelayUs = static_cast<std::int64_t>(readLe(data + 22, 2)) * 100;
+    headerSize = declared;
+    return true;
+}
+
+// Loss accounting from sequence numbers, one instance per connection.
+// Gaps count as lost frames (the client drops them from its send queue before
+// they reach the wire); a number at or behind the last one seen is counted as
+// reordered and does not move the window.
+class FrameSequenceTracker
+{
+public:
+    // Returns the number of frames missing right before `sequence`
+    std::uint32_t observe(std::uint32_t sequence)
+    {
+        if (!m_started) {
+            m_started = true;
+            m_last = sequence;
+            ++m_received;
+            return 0;
+        }
+        // Unsigned distance handles wrap-around; more than half the range back means "behind"
+        const std::uint32_t distance = sequence - m_last;
+        if (distance == 0 || distance > 0x80000000u) {
+            ++m_reordered;
+            return 0;
+        }
+        const std::uint32_t missing = distance - 1;
+        m_last = sequence;
+        m_lost += missing;
+        ++m_received;
+        return missing;
+    }
+
+    void reset() { *this = FrameSequenceTracker(); }
+
+    std::uint64_t received() const { return m_received; }
+    std::uint64_t lost() const { return m_lost; }
+    std::uint64_t reordered() const { return m_reordered; }
+
+private:
+    bool m_started = false;
+    std::uint32_t m_last = 0;
+    std::uint64_t m_received = 0;
+    std::uint64_t m_lost = 0;
+    std::uint64_t m_reordered = 0;
+};
+
+#endif // FRAMEHEADER_H
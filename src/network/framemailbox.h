@@ -0,0 +1,72 @@
+#ifndef FRAMEMAILBOX_H
+#define FRAMEMAILBOX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <utility>
+
+// Bounded latest-wins mailbox between a frame producer and a slower consumer.
+// With capacity 1 it is a single slot: a newer frame replaces the one still
+// waiting. When full, push() evicts the oldest entries and counts them as drops.
+//
+// Not synchronized: the owner guards it with its own lock (keeps it copyable
+// so it can live inside Qt containers).
+template <typename T>
+class FrameMailbox
+{
+public:
+    explicit FrameMailbox(std::size_t capacity = 1)
+        : m_capacity(capacity > 0 ? capacity : 1)
+    {
+    }
+
+    // Store an item; returns how many stale items were dropped to make room
+    std::size_t push(T item)
+    {
+        m_items.push_back(std::move(item));
+        return trim();
+    }
+
+    // Remove the oldest pending item; false when empty
+    bool take(T& out)
+    {
+        if (m_items.empty())
+            return false;
+        out = std::move(m_items.front());
+        m_items.pop_front();
+        return true;
+    }
+
+    // Shrinking the capacity drops the oldest pending items
+    std::size_t setCapacity(std::size_t capacity)
+    {
+        m_capacity = capacity > 0 ? capacity : 1;
+        return trim();
+    }
+
+    void clear() { m_items.clear(); }
+
+    std::size_t capacity() const { return m_capacity; }
+    std::size_t size() const { return m_items.size(); }
+    bool empty() const { return m_items.empty(); }
+    std::uint64_t droppedTotal() const { return m_droppedTotal; }
+
+private:
+    std::size_t trim()
+    {
+        std::size_t dropped = 0;
+        while (m_items.size() > m_capacity) {
+            m_items.pop_front();
+            ++dropped;
+        }
+        m_droppedTotal += dropped;
+        return dropped;
+    }
+
+    std::size_t m_capacity;
+    std::deque<T> m_items;
+    std::uint64_t m_droppedTotal = 0;
+};
+
+#endif // FRAMEMAILBOX_H
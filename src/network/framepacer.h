@@ -0,0 +1,133 @@
+#ifndef FRAMEPACER_H
+#define FRAMEPACER_H
+
+#include <cmath>
+#include <cstdint>
+
+// Capture schedule at a fixed rate: frame n is due at anchor + n / fps on a
+// monotonic clock, computed from the anchor every time rather than by adding
+// a rounded period to the previous deadline, so the rate neither drifts with
+// the time spent per frame (sleep after the work) nor with rounding.
+//
+// A frame that starts late keeps the schedule (the next ones come sooner);
+// one more than a whole period late gives up the missed slots instead of
+// catching up with a burst. A rate change takes effect from the last
+// deadline handed out.
+class FramePacer
+{
+public:
+    explicit FramePacer(double fps = 30.0)
+    {
+        setFps(fps);
+    }
+
+    // Non-positive rates fall back to 30 fps
+    void setFps(double fps)
+    {
+        const double periodUs = 1e6 / (fps > 0.0 ? fps : 30.0);
+        if (periodUs == m_periodUs)
+            return;
+        m_periodUs = periodUs;
+        if (m_anchored) {
+            m_anchorUs = m_lastDueUs;
+            m_index = 1;
+        }
+    }
+
+    // Monotonic time (us) the next frame is due; the first one is due at once
+    std::int64_t nextDueUs(std::int64_t nowUs)
+    {
+        if (!m_anchored) {
+            m_anchored = true;
+            m_anchorUs = nowUs;
+            m_index = 0;
+        }
+        std::int64_t due = dueAt(m_index);
+        if (nowUs - due > static_cast<std::int64_t>(m_periodUs)) {
+            const auto late = static_cast<std::uint64_t>((nowUs - due) / m_periodUs);
+            m_skipped += late;
+            m_index += late;
+            due = dueAt(m_index);
+        }
+        ++m_index;
+        m_lastDueUs = due;
+        return due;
+    }
+
+    // Start over at the next call (after a pause)
+    void reset() { m_anchored = false; }
+
+    double fps() const { return 1e6 / m_periodUs; }
+    // Slots given up because frames came more than a period late
+    std::uint64_t skippedSlots() const { return m_skipped; }
+
+private:
+    std::int64_t dueAt(std::uint64_t index) const
+    {
+        return m_anchorUs + static_cast<std::int64_t>(std::llround(static_cast<double>(index) * m_periodUs));
+    }
+
+    double m_periodUs = 0.0;
+    bool m_anchored = false;
+    std::int64_t m_anchorUs = 0;
+    std::uint64_t m_index = 0;
+    std::int64_t m_lastDueUs = 0;
+    std::uint64_t m_skipped = 0;
+};
+
+// Which frames of a source running at `sourceFps` to keep for `fps`: a frame
+// is kept when it is the nearest to the next output slot (within half a
+// source period), so 30 -> 5 fps keeps every sixth frame without drifting
+// and 30 -> 12 alternates gaps of two and three frames. Dropped frames can
+// be skipped before anything is decoded or encoded. With the source no
+// faster than the target every frame is kept.
+class FrameDecimator
+{
+public:
+    FrameDecimator(double fps = 30.0, double sourceFps = 30.0)
+    {
+        setRates(fps, sourceFps);
+    }
+
+    // Non-positive rates keep every frame
+    void setRates(double fps, double sourceFps)
+    {
+        if (fps == m_fps && sourceFps == m_sourceFps)
+            return;
+        m_fps = fps;
+        m_sourceFps = sourceFps;
+        m_all = fps <= 0.0 || sourceFps <= 0.0 || sourceFps <= fps;
+        m_periodUs = m_all ? 0.0 : 1e6 / fps;
+        m_toleranceUs = m_all ? 0.0 : 0.5e6 / sourceFps;
+        m_started = false;
+    }
+
+    // Whether the source frame at `timeUs` (monotonic or stream time) is kept
+    bool keep(std::int64_t timeUs)
+    {
+        if (m_all)
+            return true;
+        const double time = static_cast<double>(timeUs);
+        if (m_started && time + m_toleranceUs < m_nextUs)
+            return false;
+        // Slots missed by a gap in the source are not made up for
+        m_nextUs = m_started && time - m_nextUs < m_periodUs ? m_nextUs + m_periodUs : time + m_periodUs;
+        m_started = true;
+        return true;
+    }
+
+    void reset() { m_started = false; }
+
+    bool keepsAll() const { return m_all; }
+
+private:
+    double m_fps = 0.0;
+    double m_sourceFps = 0.0;
+    bool m_all = true;
+    double m_periodUs = 0.0;
+    double m_toleranceUs = 0.0;
+    bool m_started = false;
+    double m_nextUs = 0.0;
+};
+
+#endif // FRAMEPACER_H
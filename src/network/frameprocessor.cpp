@@ -0,0 +1,396 @@
+#include "frameprocessor.h"
+#include "framemailbox.h"
+#include "latencyhistogram.h"
+#include "threadroles.h"
+#include <QMutexLocker>
+#include <QThreadPool>
+#include <QTimer>
+#include <QVariantMap>
+
+namespace {
+// Histogram counts are halved every this many completions, so the
+// percentiles follow the processor's current behaviour
+const quint64 kDecayEvery = 256;
+const qint64 kFpsWindowUs = 1000000;
+
+double roundedMs(double ms)
+{
+    return ms < 0.0 ? ms : qRound(ms * 10.0) / 10.0;
+}
+
+qint64 originUs(const BusFrame& frame)
+{
+    return frame.timing.hasCapture ? frame.timing.captureTimeUs : frame.timing.receivedAtUs;
+}
+} // namespace
+
+struct ProcessingStage::Slot {
+    std::shared_ptr<FrameProcessor> processor;
+    Options options;
+    std::unique_ptr<QThreadPool> pool;
+    int subscription = 0;
+
+    QMutex mutex; // guards everything below
+    bool attached = true;
+    int inFlight = 0;
+    FrameMailbox<FramePtr> pending;
+    Stats stats;
+    LatencyHistogram processTime;
+    LatencyHistogram latency;
+    qint64 windowStartUs = 0;
+    int framesInWindow = 0;
+    quint64 sinceDecay = 0;
+
+    // Batching mode
+    bool batching = false;
+    std::vector<FramePtr> collecting;  // next batch, arrival order
+    quint64 generation = 0;            // bumped when a batch is dispatched
+    bool deadlinePassed = false;       // the collected batch is due as soon as a thread is free
+    std::vector<std::vector<std::uint8_t>> spareTensors;
+};
+
+ProcessingStage::ProcessingStage(FrameBus* bus, QObject* parent)
+    : QObject(parent), m_bus(bus)
+{
+}
+
+ProcessingStage::~ProcessingStage()
+{
+    QHash<QString, std::shared_ptr<Slot>> detached;
+    {
+        QMutexLocker lock(&m_mutex);
+        detached.swap(m_slots);
+    }
+    for (const std::shared_ptr<Slot>& slot : qAsConst(detached)) {
+        if (m_bus)
+            m_bus->unsubscribe(slot->subscription);
+        detach(*slot);
+    }
+}
+
+bool ProcessingStage::addProcessor(std::shared_ptr<FrameProcessor> processor, const Options& options)
+{
+    if (!processor || !m_bus)
+        return false;
+    const QString name = processor->name();
+
+    auto slot = std::make_shared<Slot>();
+    slot->processor = std::move(processor);
+    slot->options = options;
+    slot->options.threads = qMax(1, options.threads);
+    slot->options.queueDepth = qMax(0, options.queueDepth);
+    slot->batching = options.batchSize > 0;
+    if (slot->batching) {
+        // Only decoded images can be packed into a tensor
+        slot->options.kinds = BusFrame::Decoded;
+        slot->options.batchDeadlineMs = qMax(0, options.batchDeadlineMs);
+        slot->collecting.reserve(static_cast<std::size_t>(options.batchSize) + 1);
+    }
+    slot->pending.setCapacity(static_cast<std::size_t>(qMax(1, slot->options.queueDepth)));
+    slot->pool.reset(new QThreadPool);
+    slot->pool->setMaxThreadCount(slot->options.threads);
+    slot->stats.name = name;
+    {
+        QMutexLocker lock(&m_mutex);
+        if (m_slots.contains(name))
+            return false;
+        m_slots.insert(name, slot);
+    }
+
+    FrameBus::Options busOptions;
+    busOptions.kinds = slot->options.kinds;
+    busOptions.clientId = slot->options.clientId;
+    // Frames go straight to offer(), which never blocks: one waiting per client is enough
+    busOptions.depth = 1;
+    slot->subscription = m_bus->subscribe(this,
+                                          [this, slot](const FramePtr& frame) {
+                                              if (slot->batching)
+                                                  offerToBatch(slot, frame);
+                                              else
+                                                  offer(slot, frame);
+                                          },
+                                          busOptions);
+    return true;
+}
+
+void ProcessingStage::removeProcessor(const QString& name)
+{
+    std::shared_ptr<Slot> slot;
+    {
+        QMutexLocker lock(&m_mutex);
+        slot = m_slots.take(name);
+    }
+    if (!slot)
+        return;
+    if (m_bus)
+        m_bus->unsubscribe(slot->subscription);
+    detach(*slot);
+}
+
+void ProcessingStage::detach(Slot& slot)
+{
+    {
+        QMutexLocker lock(&slot.mutex);
+        slot.attached = false;
+        slot.pending.clear();
+        slot.collecting.clear();
+    }
+    slot.pool->waitForDone();
+}
+
+QStringList ProcessingStage::processorNames() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_slots.keys();
+}
+
+void ProcessingStage::offer(const std::shared_ptr<Slot>& slot, const FramePtr& frame)
+{
+    {
+        QMutexLocker lock(&slot->mutex);
+        if (!slot->attached)
+            return;
+        if (slot->inFlight >= slot->options.threads) {
+            if (slot->options.queueDepth == 0)
+                ++slot->stats.skipped;
+            else
+                slot->stats.skipped += slot->pending.push(frame);
+            return;
+        }
+        ++slot->inFlight;
+    }
+    slot->pool->start([slot, frame]() { run(slot, frame); });
+}
+
+void ProcessingStage::run(const std::shared_ptr<Slot>& slot, FramePtr frame)
+{
+    ThreadRoles::apply(ThreadRole::Processing);
+    // Keeps the thread while frames are queued for this processor
+    while (frame) {
+        const qint64 startUs = EncodedFrame::nowUs();
+        const bool ok = slot->processor->process(*frame);
+        const qint64 endUs = EncodedFrame::nowUs();
+
+        const std::vector<qint64> origins(1, originUs(*frame));
+        frame.reset();
+
+        QMutexLocker lock(&slot->mutex);
+        recordLocked(*slot, origins, ok, startUs, endUs);
+        if (!slot->attached || !slot->pending.take(frame)) {
+            --slot->inFlight;
+            return;
+        }
+    }
+}
+
+void ProcessingStage::recordLocked(Slot& slot, const std::vector<qint64>& originsUs, bool ok, qint64 startUs,
+                                   qint64 endUs)
+{
+    Stats& stats = slot.stats;
+    const int count = static_cast<int>(originsUs.size());
+    if (ok)
+        stats.processed += count;
+    else
+        stats.failed += count;
+    slot.processTime.record((endUs - startUs) / 1000.0);
+    for (qint64 origin : originsUs) {
+        if (origin > 0 && endUs >= origin)
+            slot.latency.record((endUs - origin) / 1000.0);
+    }
+    slot.sinceDecay += count;
+    if (slot.sinceDecay >= kDecayEvery) {
+        slot.sinceDecay = 0;
+        slot.processTime.decay();
+        slot.latency.decay();
+    }
+
+    slot.framesInWindow += count;
+    if (slot.windowStartUs == 0)
+        slot.windowStartUs = endUs;
+    if (endUs - slot.windowStartUs >= kFpsWindowUs) {
+        stats.fps = qRound(slot.framesInWindow * 1e6 / double(endUs - slot.windowStartUs));
+        slot.framesInWindow = 0;
+        slot.windowStartUs = endUs;
+    }
+}
+
+void ProcessingStage::offerToBatch(const std::shared_ptr<Slot>& slot, const FramePtr& frame)
+{
+    QMutexLocker lock(&slot->mutex);
+    if (!slot->attached)
+        return;
+    slot->collecting.push_back(frame);
+    const std::size_t batchSize = static_cast<std::size_t>(slot->options.batchSize);
+    if (slot->collecting.size() > batchSize) {
+        // Every thread is busy: keep the newest frames
+        slot->collecting.erase(slot->collecting.begin());
+        ++slot->stats.skipped;
+    }
+
+    const bool threadFree = slot->inFlight < slot->options.threads;
+    if (slot->collecting.size() >= batchSize && threadFree) {
+        dispatchBatchLocked(slot);
+        return;
+    }
+    if (slot->collecting.size() == 1 && !slot->deadlinePassed) {
+        // The deadline counts from the batch's first frame
+        const quint64 generation = slot->generation;
+        QTimer::singleShot(slot->options.batchDeadlineMs, this,
+                           [this, slot, generation]() { batchDeadline(slot, generation); });
+    }
+}
+
+void ProcessingStage::batchDeadline(const std::shared_ptr<Slot>& slot, quint64 generation)
+{
+    QMutexLocker lock(&slot->mutex);
+    if (!slot->attached || slot->generation != generation || slot->collecting.empty())
+        return;
+    if (slot->inFlight < slot->options.threads)
+        dispatchBatchLocked(slot);
+    else
+        slot->deadlinePassed = true; // the next thread to finish takes it
+}
+
+void ProcessingStage::dispatchBatchLocked(const std::shared_ptr<Slot>& slot)
+{
+    std::vector<FramePtr> frames;
+    frames.reserve(slot->collecting.capacity());
+    frames.swap(slot->collecting);
+    ++slot->generation;
+    slot->deadlinePassed = false;
+    ++slot->inFlight;
+    slot->pool->start([slot, frames]() mutable { runBatch(slot, std::move(frames)); });
+}
+
+void ProcessingStage::runBatch(const std::shared_ptr<Slot>& slot, std::vector<FramePtr> frames)
+{
+    ThreadRoles::apply(ThreadRole::Processing);
+    // Keeps the thread while full or overdue batches are waiting
+    while (!frames.empty()) {
+        const qint64 startUs = EncodedFrame::nowUs();
+        const bool ok = packAndProcess(*slot, frames);
+        const qint64 endUs = EncodedFrame::nowUs();
+
+        std::vector<qint64> origins;
+        origins.reserve(frames.size());
+        for (const FramePtr& frame : frames)
+            origins.push_back(originUs(*frame));
+        frames.clear();
+
+        QMutexLocker lock(&slot->mutex);
+        ++slot->stats.batches;
+        recordLocked(*slot, origins, ok, startUs, endUs);
+        const bool due = slot->collecting.size() >= static_cast<std::size_t>(slot->options.batchSize)
+            || (slot->deadlinePassed && !slot->collecting.empty());
+        if (!slot->attached || !due) {
+            --slot->inFlight;
+            return;
+        }
+        frames.swap(slot->collecting);
+        ++slot->generation;
+        slot->deadlinePassed = false;
+    }
+}
+
+bool ProcessingStage::packAndProcess(Slot& slot, const std::vector<FramePtr>& frames)
+{
+    int width = slot.options.batchWidth;
+    int height = slot.options.batchHeight;
+    if (width <= 0 || height <= 0) {
+        width = frames.front()->image.width();
+        height = frames.front()->image.height();
+    }
+    if (width <= 0 || height <= 0)
+        return false;
+
+    FrameBatch batch;
+    batch.geometry = BatchGeometry::make(width, height, slot.options.batchLayout, FrameBatch::kAlignment);
+    batch.frames = frames;
+
+    // Tensors are recycled: a steady batch size and resolution stops allocating
+    std::vector<std::uint8_t> tensor;
+    {
+        QMutexLocker lock(&slot.mutex);
+        if (!slot.spareTensors.empty()) {
+            tensor.swap(slot.spareTensors.back());
+            slot.spareTensors.pop_back();
+        }
+    }
+    const std::size_t bytes = batch.geometry.bytesFor(batch.count());
+    tensor.resize(bytes + FrameBatch::kAlignment);
+    std::uint8_t* data = tensor.data();
+    data += (FrameBatch::kAlignment - reinterpret_cast<std::uintptr_t>(data) % FrameBatch::kAlignment)
+        % FrameBatch::kAlignment;
+    batch.data = data;
+
+    bool ok = true;
+    for (int i = 0; i < batch.count() && ok; ++i) {
+        QImage image = frames[static_cast<std::size_t>(i)]->image;
+        if (image.isNull()) {
+            ok = false;
+            break;
+        }
+        if (image.format() != QImage::Format_RGB32 && image.format() != QImage::Format_ARGB32)
+            image = image.convertToFormat(QImage::Format_RGB32);
+        if (image.width() != width || image.height() != height)
+            image = image.scaled(width, height, Qt::IgnoreAspectRatio, Qt::FastTransformation);
+        packRgb32(image.constBits(), static_cast<std::size_t>(image.bytesPerLine()), batch.geometry,
+                  data + batch.geometry.imageStride * static_cast<std::size_t>(i));
+    }
+    if (ok)
+        ok = slot.processor->processBatch(batch);
+
+    QMutexLocker lock(&slot.mutex);
+    if (slot.spareTensors.size() < static_cast<std::size_t>(slot.options.threads))
+        slot.spareTensors.push_back(std::move(tensor));
+    return ok;
+}
+
+QList<ProcessingStage::Stats> ProcessingStage::stats() const
+{
+    QList<std::shared_ptr<Slot>> attached;
+    {
+        QMutexLocker lock(&m_mutex);
+        attached = m_slots.values();
+    }
+
+    QList<Stats> result;
+    for (const std::shared_ptr<Slot>& slot : qAsConst(attached)) {
+        QMutexLocker lock(&slot->mutex);
+        Stats stats = slot->stats;
+        stats.processP50Ms = slot->processTime.percentile(50);
+        stats.processP99Ms = slot->processTime.percentile(99);
+        stats.latencyP50Ms = slot->latency.percentile(50);
+        stats.latencyP99Ms = slot->latency.percentile(99);
+        // An idle processor has no current rate
+        if (slot->windowStartUs > 0 && EncodedFrame::nowUs() - slot->windowStartUs > 2 * kFpsWindowUs)
+            stats.fps = 0;
+        result.append(stats);
+    }
+    if (m_bus) {
+        for (int i = 0; i < result.size(); ++i)
+            result[i].skipped += m_bus->droppedFrames(attached.at(i)->subscription);
+    }
+    return result;
+}
+
+QVariantList ProcessingStage::statsList() const
+{
+    QVariantList list;
+    const QList<Stats> all = stats();
+    for (const Stats& stats : all) {
+        QVariantMap entry;
+        entry["name"] = stats.name;
+        entry["processed"] = static_cast<qulonglong>(stats.processed);
+        entry["batches"] = static_cast<qulonglong>(stats.batches);
+        entry["skipped"] = static_cast<qulonglong>(stats.skipped);
+        entry["failed"] = static_cast<qulonglong>(stats.failed);
+        entry["fps"] = stats.fps;
+        entry["processP50Ms"] = roundedMs(stats.processP50Ms);
+        entry["processP99Ms"] = roundedMs(stats.processP99Ms);
+        entry["latencyP50Ms"] = roundedMs(stats.latencyP50Ms);
+        entry["latencyP99Ms"] = roundedMs(stats.latencyP99Ms);
+        list.append(entry);
+    }
+    return list;
+}
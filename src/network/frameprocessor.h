@@ -0,0 +1,134 @@
+#ifndef FRAMEPROCESSOR_H
+#define FRAMEPROCESSOR_H
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QStringList>
+#include <QVariantList>
+#include <memory>
+#include <vector>
+#include "batchlayout.h"
+#include "framebus.h"
+
+// Decoded frames packed into one tensor for a batching processor. Image i,
+// from frames[i], starts at image(i); every frame is scaled to the batch size.
+// Only valid during processBatch().
+struct FrameBatch {
+    static const std::size_t kAlignment = 64; // data, rows, planes and images
+
+    BatchGeometry geometry;
+    const std::uint8_t* data = nullptr;
+    std::vector<FramePtr> frames;
+
+    int count() const { return static_cast<int>(frames.size()); }
+    const std::uint8_t* image(int index) const { return data + geometry.imageStride * static_cast<std::size_t>(index); }
+};
+
+// Downstream analysis plugged onto the frame bus (digit reading, motion
+// detection, ...). process() runs on the stage's worker threads, never on
+// the thread that ingests or displays frames.
+class FrameProcessor
+{
+public:
+    virtual ~FrameProcessor() = default;
+
+    // Unique within a ProcessingStage; used in its statistics
+    virtual QString name() const = 0;
+
+    // Called concurrently when the processor is given more than one thread.
+    // Return false when the frame could not be processed.
+    virtual bool process(const BusFrame& frame) = 0;
+
+    // Batching mode (Options::batchSize > 0): frames of any client, up to the
+    // batch size, in one call. Processors that don't batch keep this default.
+    virtual bool processBatch(const FrameBatch& batch)
+    {
+        Q_UNUSED(batch);
+        return false;
+    }
+};
+
+// Runs FrameProcessors on the frames of a FrameBus. Each processor gets its
+// own thread pool and a bounded queue: a frame arriving while all its threads
+// are busy waits in the queue (latest wins) or, with queueDepth 0, is skipped
+// at once. The bus side never blocks, so a slow processor only skips frames.
+//
+// Per processor it reports throughput and latency: how long process() takes
+// and the time from capture (or receipt) until it finished.
+//
+// In batching mode decoded frames are collected across clients until
+// batchSize are there or batchDeadlineMs passed since the first one, then
+// packed (batchlayout.h) and given to processBatch(). A larger batch or
+// deadline buys accelerator throughput with latency. While the threads are
+// busy the collected batch keeps the newest frames.
+class ProcessingStage : public QObject
+{
+    Q_OBJECT
+public:
+    struct Options {
+        int threads = 1;                 // concurrent process() calls
+        int queueDepth = 0;              // frames waiting while busy, 0 == skip when busy
+        int kinds = BusFrame::Decoded;   // BusFrame::Kind mask
+        QString clientId;                // empty: every client
+
+        int batchSize = 0;               // > 0: batching mode, frames per processBatch()
+        int batchDeadlineMs = 10;        // longest wait for a batch to fill
+        BatchLayout batchLayout = BatchLayout::NHWC;
+        int batchWidth = 0;              // 0: size of the batch's first frame
+        int batchHeight = 0;
+    };
+
+    struct Stats {
+        QString name;
+        quint64 processed = 0;           // frames, also in batching mode
+        quint64 batches = 0;
+        quint64 skipped = 0;             // queue overflow or all threads busy
+        quint64 failed = 0;              // process() returned false
+        int fps = 0;                     // completions over the last second
+        double processP50Ms = -1.0;
+        double processP99Ms = -1.0;
+        double latencyP50Ms = -1.0;      // capture (or receipt) until processed
+        double latencyP99Ms = -1.0;
+    };
+
+    explicit ProcessingStage(FrameBus* bus, QObject* parent = nullptr);
+    ~ProcessingStage() override; // waits for running process() calls
+
+    // False without a processor or when one with the same name is attached
+    bool addProcessor(std::shared_ptr<FrameProcessor> processor, const Options& options = Options());
+    // Detaches it and waits for its running calls
+    void removeProcessor(const QString& name);
+    QStringList processorNames() const;
+
+    QList<Stats> stats() const;
+    // Same as maps, for QML and diagnostics
+    QVariantList statsList() const;
+
+private:
+    struct Slot;
+
+    void offer(const std::shared_ptr<Slot>& slot, const FramePtr& frame);
+    static void run(const std::shared_ptr<Slot>& slot, FramePtr frame);
+    static void detach(Slot& slot);
+
+    // Batching mode
+    void offerToBatch(const std::shared_ptr<Slot>& slot, const FramePtr& frame);
+    void batchDeadline(const std::shared_ptr<Slot>& slot, quint64 generation);
+    static void dispatchBatchLocked(const std::shared_ptr<Slot>& slot);
+    static void runBatch(const std::shared_ptr<Slot>& slot, std::vector<FramePtr> frames);
+    static bool packAndProcess(Slot& slot, const std::vector<FramePtr>& frames);
+
+    // Statistics of one process() / processBatch() call; requires the slot's mutex
+    static void recordLocked(Slot& slot, const std::vector<qint64>& originsUs, bool ok, qint64 startUs,
+                             qint64 endUs);
+
+    QPointer<FrameBus> m_bus;
+    mutable QMutex m_mutex; // guards m_slots
+    QHash<QString, std::shared_ptr<Slot>> m_slots;
+};
+
+#endif // FRAMEPROCESSOR_H
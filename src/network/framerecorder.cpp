@@ -0,0 +1,537 @@
+#include "framerecorder.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QMetaObject>
+#include <QMutexLocker>
+#include <QUrl>
+#include <limits>
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#endif
+
+namespace {
+const char kSegmentSuffix[] = ".seg";
+const char kIndexSuffix[] = ".idx";
+// Smallest accepted segment: a few frames of any sensible size
+const qint64 kMinSegmentBytes = 256 * 1024;
+// Pre-roll rings of clients not heard from this long are freed
+const qint64 kIdlePrerollUs = 5ll * 60 * 1000 * 1000;
+
+FramePayload payloadOf(EncodedFrame::Format format)
+{
+    switch (format) {
+    case EncodedFrame::RawYuv:
+        return FramePayload::RawYuv;
+    case EncodedFrame::Video:
+        return FramePayload::Video;
+    case EncodedFrame::Jpeg:
+        break;
+    }
+    return FramePayload::Jpeg;
+}
+
+qint64 timestampOf(const BusFrame& frame)
+{
+    return frame.timing.hasCapture ? frame.timing.captureTimeUs : frame.timing.receivedAtUs;
+}
+
+RecordHeader recordOf(const BusFrame& frame)
+{
+    const EncodedFrame& encoded = frame.encoded;
+    RecordHeader record;
+    record.payloadSize = static_cast<std::uint32_t>(encoded.size());
+    record.timestampUs = timestampOf(frame);
+    record.sequence = encoded.hasHeader ? encoded.header.sequence : static_cast<std::uint32_t>(encoded.sequence);
+    record.payload = payloadOf(encoded.format);
+    record.keyframe = encoded.header.keyframe;
+    record.width = encoded.header.width;
+    record.height = encoded.header.height;
+    return record;
+}
+
+// Zero padded, so name order is time order
+QString segmentBaseName(qint64 timestampUs)
+{
+    return QString("%1").arg(timestampUs, 16, 10, QChar('0'));
+}
+
+bool preallocate(QFile& file, qint64 bytes)
+{
+#ifdef Q_OS_LINUX
+    // Reserves the blocks: a full disk fails here, not as SIGBUS in the mapping
+    if (::posix_fallocate(file.handle(), 0, bytes) == 0)
+        return true;
+#endif
+    return file.resize(bytes);
+}
+} // namespace
+
+struct FrameRecorder::Segment {
+    QFile file;
+    QFile index;
+    uchar* data = nullptr;
+    std::size_t capacity = 0;
+    SegmentHeader header;
+    qint64 nextIndexUs = 0;
+};
+
+FrameRecorder::FrameRecorder(FrameBus* bus, QObject* parent)
+    : QObject(parent), m_bus(bus)
+{
+    m_thread.setObjectName("FrameRecorder");
+}
+
+FrameRecorder::~FrameRecorder()
+{
+    stop();
+}
+
+bool FrameRecorder::start(const Options& options)
+{
+    if (m_writer || !m_bus || options.directory.isEmpty() || !QDir().mkpath(options.directory))
+        return false;
+
+    m_options = options;
+    m_options.segmentBytes = qMax(kMinSegmentBytes, options.segmentBytes);
+    m_options.segmentDurationMs = qMax(0, options.segmentDurationMs);
+    m_options.indexIntervalMs = qMax(1, options.indexIntervalMs);
+    m_options.queueDepth = qMax(1, options.queueDepth);
+    {
+        QMutexLocker lock(&m_statsMutex);
+        m_stats = Stats();
+    }
+
+    m_writer = new QObject;
+    m_writer->moveToThread(&m_thread);
+    m_thread.start();
+
+    FrameBus::Options busOptions;
+    busOptions.kinds = BusFrame::Encoded;
+    busOptions.clientId = m_options.clientId;
+    busOptions.depth = m_options.queueDepth;
+    // Keep what is queued: a recording with a gap beats one that skips around
+    busOptions.policy = FrameBus::DropPolicy::DropNewest;
+    m_subscription = m_bus->subscribe(m_writer, [this](const FramePtr& frame) { write(frame); }, busOptions);
+    return true;
+}
+
+void FrameRecorder::stop()
+{
+    if (!m_writer)
+        return;
+    if (m_bus) {
+        const quint64 dropped = m_bus->droppedFrames(m_subscription);
+        m_bus->unsubscribe(m_subscription);
+        QMutexLocker lock(&m_statsMutex);
+        m_stats.dropped += dropped;
+    }
+    m_subscription = 0;
+
+    // Runs after the frame being written, if any
+    QMetaObject::invokeMethod(m_writer, [this]() { closeAll(); }, Qt::BlockingQueuedConnection);
+    m_thread.quit();
+    m_thread.wait();
+    delete m_writer;
+    m_writer = nullptr;
+}
+
+bool FrameRecorder::isRecording() const
+{
+    return m_writer != nullptr;
+}
+
+FrameRecorder::Stats FrameRecorder::stats() const
+{
+    Stats stats;
+    {
+        QMutexLocker lock(&m_statsMutex);
+        stats = m_stats;
+    }
+    if (m_writer && m_bus)
+        stats.dropped += m_bus->droppedFrames(m_subscription);
+    return stats;
+}
+
+QVariantMap FrameRecorder::statsMap() const
+{
+    const Stats current = stats();
+    QVariantMap map;
+    map["recording"] = isRecording();
+    map["directory"] = m_options.directory;
+    map["frames"] = static_cast<qulonglong>(current.frames);
+    map["bytes"] = static_cast<qulonglong>(current.bytes);
+    map["dropped"] = static_cast<qulonglong>(current.dropped);
+    map["segments"] = static_cast<qulonglong>(current.segments);
+    return map;
+}
+
+void FrameRecorder::write(const FramePtr& frame)
+{
+    const EncodedFrame& encoded = frame->encoded;
+    if (encoded.isEmpty())
+        return;
+
+    const std::size_t payloadSize = static_cast<std::size_t>(encoded.size());
+    const std::size_t span = recordSpan(payloadSize);
+    const qint64 timestampUs = timestampOf(*frame);
+    Segment* segment = writableSegment(*frame, span, timestampUs);
+    if (!segment) {
+        QMutexLocker lock(&m_statsMutex);
+        ++m_stats.dropped;
+        return;
+    }
+
+    const RecordHeader record = recordOf(*frame);
+
+    const std::uint64_t offset = segment->header.used;
+    writeRecord(record, encoded.data(), segment->data + offset);
+
+    SegmentHeader& header = segment->header;
+    if (header.records == 0)
+        header.firstTimestampUs = timestampUs;
+    header.lastTimestampUs = timestampUs;
+    header.used += span;
+    ++header.records;
+    // After the record: a reader never sees a used size covering a partial one
+    writeSegmentHeader(header, segment->data);
+
+    if (timestampUs >= segment->nextIndexUs) {
+        IndexEntry entry;
+        entry.timestampUs = timestampUs;
+        entry.offset = offset;
+        std::uint8_t bytes[kIndexEntrySize];
+        writeIndexEntry(entry, bytes);
+        segment->index.write(reinterpret_cast<const char*>(bytes), sizeof(bytes));
+        segment->index.flush();
+        segment->nextIndexUs = timestampUs + qint64(m_options.indexIntervalMs) * 1000;
+    }
+
+    QMutexLocker lock(&m_statsMutex);
+    ++m_stats.frames;
+    m_stats.bytes += payloadSize;
+}
+
+FrameRecorder::Segment* FrameRecorder::writableSegment(const BusFrame& frame, std::size_t span, qint64 timestampUs)
+{
+    std::shared_ptr<Segment>& segment = m_segments[frame.clientId];
+    if (!segment)
+        segment = std::make_shared<Segment>();
+
+    if (segment->data) {
+        const bool full = segment->header.used + span > segment->capacity;
+        const bool expired = m_options.segmentDurationMs > 0 && segment->header.records > 0
+            && timestampUs - segment->header.firstTimestampUs >= qint64(m_options.segmentDurationMs) * 1000;
+        if (full || expired)
+            closeSegment(*segment);
+    }
+    if (!segment->data && !openSegment(*segment, frame.clientId, timestampUs, span))
+        return nullptr;
+    return segment.get();
+}
+
+bool FrameRecorder::openSegment(Segment& segment, const QString& clientId, qint64 timestampUs, std::size_t span)
+{
+    const QDir directory(clientDirectory(m_options.directory, clientId));
+    if (!directory.mkpath("."))
+        return false;
+
+    // Names are unique even when rotations follow each other within a microsecond
+    qint64 name = timestampUs;
+    while (directory.exists(segmentBaseName(name) + kSegmentSuffix))
+        ++name;
+    const QString base = directory.filePath(segmentBaseName(name));
+
+    const qint64 capacity = qMax(m_options.segmentBytes, static_cast<qint64>(kSegmentHeaderSize + span));
+    segment.file.setFileName(base + kSegmentSuffix);
+    segment.index.setFileName(base + kIndexSuffix);
+    if (!segment.file.open(QIODevice::ReadWrite) || !preallocate(segment.file, capacity)
+        || !segment.index.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        segment.file.close();
+        segment.index.close();
+        segment.file.remove();
+        segment.index.remove();
+        return false;
+    }
+    segment.data = segment.file.map(0, capacity);
+    if (!segment.data) {
+        segment.file.close();
+        segment.index.close();
+        segment.file.remove();
+        segment.index.remove();
+        return false;
+    }
+
+    segment.capacity = static_cast<std::size_t>(capacity);
+    segment.header = SegmentHeader();
+    segment.nextIndexUs = std::numeric_limits<qint64>::min();
+    writeSegmentHeader(segment.header, segment.data);
+
+    QMutexLocker lock(&m_statsMutex);
+    ++m_stats.segments;
+    return true;
+}
+
+void FrameRecorder::closeSegment(Segment& segment)
+{
+    if (!segment.data)
+        return;
+    writeSegmentHeader(segment.header, segment.data);
+    segment.file.unmap(segment.data);
+    segment.data = nullptr;
+    // Give back the preallocated space the segment didn't use
+    segment.file.resize(static_cast<qint64>(segment.header.used));
+    segment.file.close();
+    segment.index.close();
+}
+
+void FrameRecorder::closeAll()
+{
+    for (const std::shared_ptr<Segment>& segment : qAsConst(m_segments))
+        closeSegment(*segment);
+    m_segments.clear();
+}
+
+QString FrameRecorder::clientDirectory(const QString& directory, const QString& clientId)
+{
+    return QDir(directory).filePath(QString::fromLatin1(QUrl::toPercentEncoding(clientId)));
+}
+
+QStringList FrameRecorder::segments(const QString& directory, const QString& clientId)
+{
+    const QDir dir(clientDirectory(directory, clientId));
+    QStringList paths;
+    const QStringList names = dir.entryList({QString("*") + kSegmentSuffix}, QDir::Files, QDir::Name);
+    for (const QString& name : names)
+        paths.append(dir.filePath(name));
+    return paths;
+}
+
+QString FrameRecorder::segmentFor(const QString& directory, const QString& clientId, qint64 timestampUs)
+{
+    const QStringList all = segments(directory, clientId);
+    // Last segment starting at or before the timestamp (names are first timestamps)...
+    int candidate = 0;
+    for (int i = 0; i < all.size(); ++i) {
+        if (QFileInfo(all.at(i)).completeBaseName().toLongLong() <= timestampUs)
+            candidate = i;
+    }
+    // ...unless the frame is already past its end
+    for (int i = candidate; i < all.size(); ++i) {
+        RecordingReader reader;
+        if (reader.open(all.at(i)) && reader.frameCount() > 0 && reader.lastTimestampUs() >= timestampUs)
+            return all.at(i);
+    }
+    return QString();
+}
+
+PrerollBuffer::PrerollBuffer(FrameBus* bus, QObject* parent)
+    : QObject(parent), m_bus(bus)
+{
+    m_thread.setObjectName("PrerollBuffer");
+}
+
+PrerollBuffer::~PrerollBuffer()
+{
+    stop();
+}
+
+bool PrerollBuffer::start(const Options& options)
+{
+    if (m_worker || !m_bus)
+        return false;
+
+    m_options = options;
+    m_options.windowMs = qMax(0, options.windowMs);
+    m_options.bytesPerClient = qMax(kMinSegmentBytes, options.bytesPerClient);
+    m_options.queueDepth = qMax(1, options.queueDepth);
+
+    m_worker = new QObject;
+    m_worker->moveToThread(&m_thread);
+    m_thread.start();
+
+    FrameBus::Options busOptions;
+    busOptions.kinds = BusFrame::Encoded;
+    busOptions.depth = m_options.queueDepth;
+    // In order, like the recorder: a clip with a gap beats one that skips around
+    busOptions.policy = FrameBus::DropPolicy::DropNewest;
+    m_subscription = m_bus->subscribe(m_worker, [this](const FramePtr& frame) { push(frame); }, busOptions);
+    return true;
+}
+
+void PrerollBuffer::stop()
+{
+    if (!m_worker)
+        return;
+    if (m_bus)
+        m_bus->unsubscribe(m_subscription);
+    m_subscription = 0;
+
+    QMetaObject::invokeMethod(m_worker, [this]() { m_rings.clear(); }, Qt::BlockingQueuedConnection);
+    m_thread.quit();
+    m_thread.wait();
+    delete m_worker;
+    m_worker = nullptr;
+}
+
+bool PrerollBuffer::isRunning() const
+{
+    return m_worker != nullptr;
+}
+
+QString PrerollBuffer::exportClip(const QString& clientId, const QString& directory, int preRollMs)
+{
+    if (!m_worker || directory.isEmpty())
+        return QString();
+    QString path;
+    QMetaObject::invokeMethod(m_worker, [&]() { path = writeClip(clientId, directory, preRollMs); },
+                              Qt::BlockingQueuedConnection);
+    return path;
+}
+
+QVariantMap PrerollBuffer::statsMap() const
+{
+    QVariantMap map;
+    if (m_worker)
+        QMetaObject::invokeMethod(m_worker, [&]() { map = ringStats(); }, Qt::BlockingQueuedConnection);
+    map["running"] = isRunning();
+    map["windowMs"] = m_options.windowMs;
+    map["bytesPerClient"] = m_options.bytesPerClient;
+    return map;
+}
+
+void PrerollBuffer::push(const FramePtr& frame)
+{
+    const EncodedFrame& encoded = frame->encoded;
+    if (encoded.isEmpty())
+        return;
+
+    std::shared_ptr<Ring>& ring = m_rings[frame->clientId];
+    if (!ring) {
+        ring = std::make_shared<Ring>();
+        ring->ring.configure(static_cast<std::size_t>(m_options.bytesPerClient), qint64(m_options.windowMs) * 1000);
+        // A new client: free the slabs of those gone for a while
+        for (auto it = m_rings.begin(); it != m_rings.end();) {
+            if (it.value() && frame->timing.receivedAtUs - it.value()->lastArrivalUs > kIdlePrerollUs)
+                it = m_rings.erase(it);
+            else
+                ++it;
+        }
+    }
+    ring->ring.push(recordOf(*frame), encoded.data());
+    ring->lastArrivalUs = frame->timing.receivedAtUs;
+}
+
+QString PrerollBuffer::writeClip(const QString& clientId, const QString& directory, int preRollMs)
+{
+    const std::shared_ptr<Ring> ring = m_rings.value(clientId);
+    if (!ring || ring->ring.frameCount() == 0)
+        return QString();
+
+    const qint64 fromUs = preRollMs > 0 ? ring->ring.newestTimestampUs() - qint64(preRollMs) * 1000
+                                        : std::numeric_limits<qint64>::min();
+    std::vector<std::uint8_t> segment;
+    std::vector<std::uint8_t> index;
+    if (ring->ring.exportSegment(fromUs, qint64(FrameRecorder::Options().indexIntervalMs) * 1000, segment, index) == 0)
+        return QString();
+
+    SegmentHeader header;
+    parseSegmentHeader(segment.data(), segment.size(), header);
+    const QDir clientDir(FrameRecorder::clientDirectory(directory, clientId));
+    if (!clientDir.mkpath("."))
+        return QString();
+    qint64 name = header.firstTimestampUs;
+    while (clientDir.exists(segmentBaseName(name) + kSegmentSuffix))
+        ++name;
+    const QString base = clientDir.filePath(segmentBaseName(name));
+
+    QFile segmentFile(base + kSegmentSuffix);
+    QFile indexFile(base + kIndexSuffix);
+    const qint64 segmentBytes = static_cast<qint64>(segment.size());
+    const qint64 indexBytes = static_cast<qint64>(index.size());
+    if (!segmentFile.open(QIODevice::WriteOnly) || !indexFile.open(QIODevice::WriteOnly)
+        || segmentFile.write(reinterpret_cast<const char*>(segment.data()), segmentBytes) != segmentBytes
+        || indexFile.write(reinterpret_cast<const char*>(index.data()), indexBytes) != indexBytes) {
+        segmentFile.remove();
+        indexFile.remove();
+        return QString();
+    }
+    return segmentFile.fileName();
+}
+
+QVariantMap PrerollBuffer::ringStats() const
+{
+    quint64 frames = 0;
+    quint64 bytes = 0;
+    quint64 evicted = 0;
+    for (const std::shared_ptr<Ring>& ring : m_rings) {
+        frames += ring->ring.frameCount();
+        bytes += ring->ring.bytesUsed();
+        evicted += ring->ring.evicted();
+    }
+    QVariantMap map;
+    map["clients"] = m_rings.size();
+    map["frames"] = frames;
+    map["bytes"] = bytes;
+    map["evicted"] = evicted;
+    return map;
+}
+
+RecordingReader::~RecordingReader()
+{
+    close();
+}
+
+bool RecordingReader::open(const QString& segmentPath)
+{
+    close();
+    m_segment.setFileName(segmentPath);
+    if (!m_segment.open(QIODevice::ReadOnly))
+        return false;
+    const qint64 size = m_segment.size();
+    m_data = size > 0 ? m_segment.map(0, size) : nullptr;
+    if (!m_data || !parseSegmentHeader(m_data, static_cast<std::size_t>(size), m_header)) {
+        close();
+        return false;
+    }
+
+    // Without its index a segment is still readable, seeking walks from the start
+    QFile index(segmentPath.left(segmentPath.size() - int(sizeof(kSegmentSuffix) - 1)) + kIndexSuffix);
+    if (index.open(QIODevice::ReadOnly)) {
+        m_index = index.readAll();
+        m_index.truncate(m_index.size() - m_index.size() % int(kIndexEntrySize));
+    }
+    m_position = kSegmentHeaderSize;
+    return true;
+}
+
+void RecordingReader::close()
+{
+    if (m_data)
+        m_segment.unmap(const_cast<uchar*>(m_data));
+    m_data = nullptr;
+    m_segment.close();
+    m_index.clear();
+    m_header = SegmentHeader();
+    m_position = kSegmentHeaderSize;
+}
+
+bool RecordingReader::seek(qint64 timestampUs)
+{
+    if (!m_data)
+        return false;
+    const std::uint64_t start = seekIndex(reinterpret_cast<const std::uint8_t*>(m_index.constData()),
+                                          static_cast<std::size_t>(m_index.size()) / kIndexEntrySize, timestampUs);
+    m_position = findRecord(m_data, static_cast<std::size_t>(m_header.used), static_cast<std::size_t>(start),
+                            timestampUs);
+    return m_position < m_header.used;
+}
+
+bool RecordingReader::next(Frame& frame)
+{
+    std::size_t payload = 0;
+    if (!m_data || !parseRecord(m_data, static_cast<std::size_t>(m_header.used), m_position, frame.header, payload))
+        return false;
+    frame.payload = QByteArray(reinterpret_cast<const char*>(m_data + payload), int(frame.header.payloadSize));
+    m_position += recordSpan(frame.header.payloadSize);
+    return true;
+}
@@ -0,0 +1,182 @@
+#ifndef FRAMERECORDER_H
+#define FRAMERECORDER_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+#include <QVariantMap>
+#include <memory>
+#include "framebus.h"
+#include "prerollring.h"
+#include "recordingsegment.h"
+
+// Continuous recording of the received streams, without re-encoding: the
+// Encoded frames of the FrameBus are appended as they arrived to per-client
+// segment files (format in recordingsegment.h) under
+//   <directory>/<client id, percent-encoded>/<first timestamp>.seg / .idx
+// Segments are preallocated and written through a memory map, so appending a
+// frame is a copy into the page cache. A segment is closed (and truncated to
+// what it holds) when the next frame doesn't fit or its stream time exceeds
+// segmentDurationMs.
+//
+// The recorder writes on its own thread. It is just another bus subscriber:
+// when the disk falls behind, its queue fills and the newest frames are
+// dropped (and counted), the receive path never waits.
+class FrameRecorder : public QObject
+{
+    Q_OBJECT
+public:
+    struct Options {
+        QString directory;
+        qint64 segmentBytes = 64ll * 1024 * 1024; // preallocated per segment
+        int segmentDurationMs = 60000;            // stream time per segment, 0 == size only
+        int indexIntervalMs = 1000;               // stream time between index entries
+        int queueDepth = 64;                      // frames waiting per client
+        QString clientId;                         // empty: every client
+    };
+
+    struct Stats {
+        quint64 frames = 0;
+        quint64 bytes = 0;      // payload bytes recorded
+        quint64 dropped = 0;    // queue full or write failure
+        quint64 segments = 0;   // segments opened
+    };
+
+    explicit FrameRecorder(FrameBus* bus, QObject* parent = nullptr);
+    ~FrameRecorder() override; // stops, closing the open segments
+
+    // False when already recording or the directory can't be created
+    bool start(const Options& options);
+    // Closes every segment after the frame being written; queued ones are dropped
+    void stop();
+    bool isRecording() const;
+    Stats stats() const;
+    QVariantMap statsMap() const;
+
+    // Directory of one client's recording
+    static QString clientDirectory(const QString& directory, const QString& clientId);
+    // Segment files of a client, oldest first
+    static QStringList segments(const QString& directory, const QString& clientId);
+    // Segment holding the first frame at or after `timestampUs`; empty if none
+    static QString segmentFor(const QString& directory, const QString& clientId, qint64 timestampUs);
+
+private:
+    struct Segment;
+
+    // Writer thread
+    void write(const FramePtr& frame);
+    Segment* writableSegment(const BusFrame& frame, std::size_t span, qint64 timestampUs);
+    bool openSegment(Segment& segment, const QString& clientId, qint64 timestampUs, std::size_t span);
+    static void closeSegment(Segment& segment);
+    void closeAll();
+
+    QPointer<FrameBus> m_bus;
+    QThread m_thread;
+    QObject* m_writer = nullptr; // lives on m_thread; the subscription's context
+    int m_subscription = 0;
+    Options m_options;
+    QHash<QString, std::shared_ptr<Segment>> m_segments; // writer thread only
+
+    mutable QMutex m_statsMutex;
+    Stats m_stats;
+};
+
+// Pre-roll for event clips, without continuous recording: the last seconds
+// of every client's Encoded frames stay in memory, compressed, each client in
+// a fixed slab (PrerollRing). When an operator or a processor flags an event,
+// exportClip() writes what the client's ring holds as a recorder segment, in
+// the FrameRecorder layout, so RecordingReader and replay read it as is.
+//
+// The rings are filled on their own thread; a client's ring outlives its
+// connection, so the seconds before a camera dropped can still be exported.
+class PrerollBuffer : public QObject
+{
+    Q_OBJECT
+public:
+    struct Options {
+        int windowMs = 10000;                    // stream time kept per client, 0 == as much as fits
+        qint64 bytesPerClient = 16ll * 1024 * 1024; // slab per client, allocated on its first frame
+        int queueDepth = 64;                     // frames waiting per client
+    };
+
+    explicit PrerollBuffer(FrameBus* bus, QObject* parent = nullptr);
+    ~PrerollBuffer() override;
+
+    // False when already running
+    bool start(const Options& options);
+    // Frees every ring
+    void stop();
+    bool isRunning() const;
+    Options options() const { return m_options; }
+
+    // Writes the client's last `preRollMs` of stream time (0: all it holds),
+    // from a keyframe, as <directory>/<client>/<first timestamp>.seg / .idx.
+    // Returns the segment path, empty if there is nothing to write or it
+    // fails. Blocks until written; not from a bus handler of this buffer.
+    QString exportClip(const QString& clientId, const QString& directory, int preRollMs = 0);
+
+    // running, windowMs, bytesPerClient, clients, frames and bytes held, evicted
+    QVariantMap statsMap() const;
+
+private:
+    struct Ring {
+        PrerollRing ring;
+        qint64 lastArrivalUs = 0;
+    };
+
+    // Ring thread
+    void push(const FramePtr& frame);
+    QString writeClip(const QString& clientId, const QString& directory, int preRollMs);
+    QVariantMap ringStats() const;
+
+    QPointer<FrameBus> m_bus;
+    QThread m_thread;
+    QObject* m_worker = nullptr; // lives on m_thread; the subscription's context
+    int m_subscription = 0;
+    Options m_options;
+    QHash<QString, std::shared_ptr<Ring>> m_rings; // ring thread only
+};
+
+// Sequential and timestamp access to one recorded segment (read-only map).
+// A segment still being written can be read as far as it was when opened.
+class RecordingReader
+{
+public:
+    struct Frame {
+        RecordHeader header;
+        QByteArray payload; // as received: JPEG, raw frame or video packet
+    };
+
+    RecordingReader() = default;
+    ~RecordingReader();
+    RecordingReader(const RecordingReader&) = delete;
+    RecordingReader& operator=(const RecordingReader&) = delete;
+
+    bool open(const QString& segmentPath);
+    void close();
+    bool isOpen() const { return m_data != nullptr; }
+
+    qint64 firstTimestampUs() const { return m_header.firstTimestampUs; }
+    qint64 lastTimestampUs() const { return m_header.lastTimestampUs; }
+    int frameCount() const { return static_cast<int>(m_header.records); }
+
+    // Positions on the first frame at or after `timestampUs`; false if there is none
+    bool seek(qint64 timestampUs);
+    // Frame at the position, then moves past it; false at the end
+    bool next(Frame& frame);
+
+private:
+    QFile m_segment;
+    QByteArray m_index;
+    const uchar* m_data = nullptr;
+    SegmentHeader m_header;
+    std::size_t m_position = kSegmentHeaderSize;
+};
+
+#endif // FRAMERECORDER_H
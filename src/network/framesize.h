@@ -0,0 +1,124 @@
+#ifndef FRAMESIZE_H
+#define FRAMESIZE_H
+
+#include <algorithm>
+
+struct FrameSize {
+    int width = 0;
+    int height = 0;
+};
+
+// Largest size that fits `maxWidth` x `maxHeight` with the source aspect ratio.
+// Never upscales; a bound of 0 leaves that dimension unconstrained. Results are
+// rounded down to even sizes (4:2:0 JPEG chroma) but never below 2 pixels.
+inline FrameSize fitFrameSize(int width, int height, int maxWidth, int maxHeight)
+{
+    FrameSize size;
+    size.width = width;
+    size.height = height;
+    if (width <= 0 || height <= 0)
+        return size;
+
+    const bool boundW = maxWidth > 0 && width > maxWidth;
+    const bool boundH = maxHeight > 0 && height > maxHeight;
+    if (!boundW && !boundH)
+        return size;
+
+    // Scale by the tighter bound, in integer math to stay deterministic
+    const long long w = width, h = height;
+    if (boundW && (!boundH || w * maxHeight >= h * maxWidth)) {
+        size.width = maxWidth;
+        size.height = static_cast<int>(h * maxWidth / w);
+    } else {
+        size.height = maxHeight;
+        size.width = static_cast<int>(w * maxHeight / h);
+    }
+    size.width = std::max(2, size.width & ~1);
+    size.height = std::max(2, size.height & ~1);
+    return size;
+}
+
+// Region of interest in fractions (0-1) of the source frame, from SET_ROI.
+// A zero width or height is the whole frame.
+struct FrameRegion {
+    double x = 0.0;
+    double y = 0.0;
+    double width = 0.0;
+    double height = 0.0;
+
+    bool isFull() const
+    {
+        return width <= 0.0 || height <= 0.0 || (x <= 0.0 && y <= 0.0 && width >= 1.0 && height >= 1.0);
+    }
+};
+
+struct FrameRect {
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+};
+
+// Pixels of a `width` x `height` frame to crop `region` to: clamped to the
+// frame and, like fitFrameSize(), on even coordinates and sizes (4:2:0 chroma)
+// of at least 2 pixels. The whole frame for a full region.
+inline FrameRect cropRect(int width, int height, const FrameRegion& region)
+{
+    FrameRect rect;
+    rect.width = width;
+    rect.height = height;
+    if (width <= 0 || height <= 0 || region.isFull())
+        return rect;
+
+    const auto edge = [](double fraction, int size) {
+        return static_cast<int>(std::max(0.0, std::min(1.0, fraction)) * size);
+    };
+    int x0 = edge(region.x, width) & ~1;
+    int y0 = edge(region.y, height) & ~1;
+    int x1 = edge(region.x + region.width, width);
+    int y1 = edge(region.y + region.height, height);
+    // Rounded outwards to even, then kept at least 2 pixels inside the frame
+    x1 = std::min(width & ~1, (x1 + 1) & ~1);
+    y1 = std::min(height & ~1, (y1 + 1) & ~1);
+    x0 = std::max(0, std::min(x0, x1 - 2));
+    y0 = std::max(0, std::min(y0, y1 - 2));
+    rect.x = x0;
+    rect.y = y0;
+    rect.width = std::max(2, x1 - x0);
+    rect.height = std::max(2, y1 - y0);
+    return rect;
+}
+
+// Frame size bound for an on-screen area of `width` x `height` pixels: rounded
+// up to a multiple of `step`, so the stream is never smaller than what shows
+// and a window being resized doesn't ask for a new size every few pixels.
+// 0 x 0 (full resolution) for an empty area.
+inline FrameSize displayFrameBound(int width, int height, int step = 64)
+{
+    FrameSize bound;
+    if (width <= 0 || height <= 0)
+        return bound;
+    step = std::max(2, step);
+    bound.width = (width + step - 1) / step * step;
+    bound.height = (height + step - 1) / step * step;
+    return bound;
+}
+
+// DCT scaling denominator (1, 2, 4 or 8) for decoding a `width` x `height` JPEG
+// that is shown within `targetWidth` x `targetHeight`: the largest one whose
+// scaled size (rounded up, as libjpeg does) still covers the picture once fit
+// to the target, so the scaled decode is never smaller than what shows.
+// 1 (full size) for an empty target.
+inline int jpegScaleDenominator(int width, int height, int targetWidth, int targetHeight)
+{
+    if (width <= 0 || height <= 0 || targetWidth <= 0 || targetHeight <= 0)
+        return 1;
+    int denominator = 8;
+    // The fit is bound by whichever side fills its target: covering that one is enough
+    while (denominator > 1 && (width + denominator - 1) / denominator < targetWidth
+           && (height + denominator - 1) / denominator < targetHeight)
+        denominator /= 2;
+    return denominator;
+}
+
+#endif // FRAMESIZE_H
@@ -0,0 +1,297 @@
+#ifndef FRAMETRACE_H
+#define FRAMETRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Frame-lifecycle tracing, dumped in the Chrome trace event format (JSON,
+// opens in chrome://tracing and ui.perfetto.dev). Off by default: a disabled
+// trace point is one relaxed load and a branch.
+//
+// Each thread records into its own ring of kRingEvents events, created on its
+// first event; when the ring is full the newest events overwrite the oldest
+// (a dump then holds the newest kRingEvents - 1).
+// Recording never locks or allocates: the thread fills a slot and publishes
+// it by bumping the ring's head. A dump copies every ring from another thread
+// and drops the slots that were overwritten meanwhile, so it never stops the
+// pipeline either. Rings outlive their threads (events of finished threads
+// stay in the dump); the registry's mutex is only taken to add a ring, name a
+// thread and dump.
+//
+// Timestamps are wall clock microseconds, like the FrameHeader capture times,
+// so client and server traces of one host can be loaded side by side. Events
+// carry the frame's sequence number when known (the client's FrameHeader
+// sequence on both ends).
+class FrameTrace
+{
+public:
+    static const std::size_t kRingEvents = 16384; // per thread
+    static const std::int64_t kNoFrame = -1;
+
+    static bool isEnabled() { return enabledFlag().load(std::memory_order_relaxed); }
+    static void setEnabled(bool enabled) { enabledFlag().store(enabled, std::memory_order_relaxed); }
+
+    // Enables tracing when IMAGESOCKET_TRACE is set to anything but "" or "0"
+    static bool enableFromEnvironment()
+    {
+        const char* value = std::getenv("IMAGESOCKET_TRACE");
+        if (value && *value && std::string(value) != "0")
+            setEnabled(true);
+        return isEnabled();
+    }
+
+    static std::int64_t nowUs()
+    {
+        using namespace std::chrono;
+        return duration_cast<microseconds>(system_clock::now().time_since_epoch()).count();
+    }
+
+    // `name` and `category` must be string literals (only the pointers are kept)
+    static void complete(const char* name, const char* category, std::int64_t startUs, std::int64_t durationUs,
+                         std::int64_t frame = kNoFrame)
+    {
+        if (isEnabled())
+            record(name, category, startUs, durationUs < 0 ? 0 : durationUs, frame);
+    }
+
+    static void instant(const char* name, const char* category, std::int64_t frame = kNoFrame)
+    {
+        if (isEnabled())
+            record(name, category, nowUs(), kInstant, frame);
+    }
+
+    // Label of the calling thread in the dump. Only while tracing (a thread
+    // gets no ring before that); cheap to repeat from pooled jobs, the lock is
+    // only taken when the name changes.
+    static void setThreadName(const char* name)
+    {
+        if (!isEnabled())
+            return;
+        Ring& ring = threadRing();
+        if (ring.name == name) // only this thread writes it
+            return;
+        std::lock_guard<std::mutex> lock(registry().mutex);
+        ring.name = name;
+    }
+
+    // Everything the rings hold, as a Chrome trace JSON object
+    static std::string chromeJson(int pid = 1, const std::string& processName = std::string())
+    {
+        std::string out;
+        out.reserve(4096);
+        out += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        bool first = true;
+        const auto separate = [&out, &first]() {
+            if (!first)
+                out += ",\n";
+            first = false;
+        };
+        const std::string pidText = std::to_string(pid);
+        if (!processName.empty()) {
+            separate();
+            out += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" + pidText + ",\"tid\":0,\"args\":{\"name\":\""
+                + escape(processName) + "\"}}";
+        }
+
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        std::vector<Copy> events;
+        for (const std::unique_ptr<Ring>& ring : reg.rings) {
+            const std::string tidText = std::to_string(ring->tid);
+            separate();
+            out += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" + pidText + ",\"tid\":" + tidText
+                + ",\"args\":{\"name\":\""
+                + escape(ring->name.empty() ? "thread " + tidText : ring->name) + "\"}}";
+
+            events.clear();
+            const std::uint64_t valid = copyRing(*ring, events);
+            for (const Copy& event : events) {
+                if (event.index < valid || !event.name)
+                    continue;
+                separate();
+                out += "{\"name\":\"";
+                out += escape(event.name);
+                out += "\",\"cat\":\"";
+                out += escape(event.category ? event.category : "");
+                out += event.durationUs == kInstant ? "\",\"ph\":\"i\",\"s\":\"t\"" : "\",\"ph\":\"X\"";
+                out += ",\"ts\":" + std::to_string(event.startUs);
+                if (event.durationUs != kInstant)
+                    out += ",\"dur\":" + std::to_string(event.durationUs);
+                out += ",\"pid\":" + pidText + ",\"tid\":" + tidText;
+                if (event.frame != kNoFrame)
+                    out += ",\"args\":{\"frame\":" + std::to_string(event.frame) + "}";
+                out += '}';
+            }
+        }
+        out += "]}\n";
+        return out;
+    }
+
+    static bool writeChromeJson(const std::string& path, int pid = 1, const std::string& processName = std::string())
+    {
+        const std::string json = chromeJson(pid, processName);
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+        if (!file)
+            return false;
+        const bool ok = std::fwrite(json.data(), 1, json.size(), file) == json.size();
+        return std::fclose(file) == 0 && ok;
+    }
+
+    // JSON string escaping: quote, backslash and control characters
+    static std::string escape(const std::string& value)
+    {
+        std::string out;
+        out.reserve(value.size());
+        for (char c : value) {
+            if (c == '"' || c == '\\') {
+                out += '\\';
+                out += c;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                char buffer[8];
+                std::snprintf(buffer, sizeof(buffer), "\\u%04x", static_cast<unsigned>(c));
+                out += buffer;
+            } else {
+                out += c;
+            }
+        }
+        return out;
+    }
+
+private:
+    static const std::int64_t kInstant = -1; // duration of instant events
+
+    // Fields are atomics so a dump may read a slot while its thread rewrites it
+    struct Event {
+        std::atomic<const char*> name;
+        std::atomic<const char*> category;
+        std::atomic<std::int64_t> startUs;
+        std::atomic<std::int64_t> durationUs;
+        std::atomic<std::int64_t> frame;
+    };
+
+    struct Ring {
+        explicit Ring(int id) : events(new Event[kRingEvents]), tid(id) {}
+        std::unique_ptr<Event[]> events;
+        std::atomic<std::uint64_t> head{0}; // events ever recorded; written by the owning thread only
+        int tid;
+        std::string name; // written by the owning thread under the registry's mutex
+    };
+
+    struct Registry {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<Ring>> rings;
+    };
+
+    struct Copy {
+        std::uint64_t index;
+        const char* name;
+        const char* category;
+        std::int64_t startUs;
+        std::int64_t durationUs;
+        std::int64_t frame;
+    };
+
+    static std::atomic<bool>& enabledFlag()
+    {
+        static std::atomic<bool> enabled{false};
+        return enabled;
+    }
+
+    // Never destroyed: threads may still record while the process exits
+    static Registry& registry()
+    {
+        static Registry* instance = new Registry;
+        return *instance;
+    }
+
+    static Ring& threadRing()
+    {
+        thread_local Ring* ring = nullptr;
+        if (!ring) {
+            Registry& reg = registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            reg.rings.emplace_back(new Ring(static_cast<int>(reg.rings.size()) + 1));
+            ring = reg.rings.back().get();
+        }
+        return *ring;
+    }
+
+    static void record(const char* name, const char* category, std::int64_t startUs, std::int64_t durationUs,
+                       std::int64_t frame)
+    {
+        Ring& ring = threadRing();
+        const std::uint64_t index = ring.head.load(std::memory_order_relaxed);
+        // Orders the previous head store before this slot's stores: a dump that
+        // sees any of them also sees that head and discards the slot's old event
+        std::atomic_thread_fence(std::memory_order_release);
+        Event& event = ring.events[index % kRingEvents];
+        event.name.store(name, std::memory_order_relaxed);
+        event.category.store(category, std::memory_order_relaxed);
+        event.startUs.store(startUs, std::memory_order_relaxed);
+        event.durationUs.store(durationUs, std::memory_order_relaxed);
+        event.frame.store(frame, std::memory_order_relaxed);
+        ring.head.store(index + 1, std::memory_order_release);
+    }
+
+    // Copies the published events of `ring`; returns the first index still
+    // intact afterwards (older ones may have been overwritten while copying)
+    static std::uint64_t copyRing(const Ring& ring, std::vector<Copy>& out)
+    {
+        const std::uint64_t head = ring.head.load(std::memory_order_acquire);
+        const std::uint64_t first = head > kRingEvents ? head - kRingEvents : 0;
+        out.reserve(static_cast<std::size_t>(head - first));
+        for (std::uint64_t index = first; index < head; ++index) {
+            const Event& event = ring.events[index % kRingEvents];
+            Copy copy;
+            copy.index = index;
+            copy.name = event.name.load(std::memory_order_relaxed);
+            copy.category = event.category.load(std::memory_order_relaxed);
+            copy.startUs = event.startUs.load(std::memory_order_relaxed);
+            copy.durationUs = event.durationUs.load(std::memory_order_relaxed);
+            copy.frame = event.frame.load(std::memory_order_relaxed);
+            out.push_back(copy);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        // The slot of index `after` may be half written, holding index `after - kRingEvents`
+        const std::uint64_t after = ring.head.load(std::memory_order_relaxed);
+        return after + 1 > kRingEvents ? after + 1 - kRingEvents : 0;
+    }
+};
+
+// Complete event around a scope. The clock is only read when tracing is on;
+// setFrame() names the frame once it is known (e.g. after parsing).
+class FrameTraceScope
+{
+public:
+    FrameTraceScope(const char* name, const char* category, std::int64_t frame = FrameTrace::kNoFrame)
+        : m_name(name), m_category(category), m_frame(frame),
+          m_startUs(FrameTrace::isEnabled() ? FrameTrace::nowUs() : -1)
+    {
+    }
+
+    ~FrameTraceScope()
+    {
+        if (m_startUs >= 0)
+            FrameTrace::complete(m_name, m_category, m_startUs, FrameTrace::nowUs() - m_startUs, m_frame);
+    }
+
+    FrameTraceScope(const FrameTraceScope&) = delete;
+    FrameTraceScope& operator=(const FrameTraceScope&) = delete;
+
+    void setFrame(std::int64_t frame) { m_frame = frame; }
+
+private:
+    const char* m_name;
+    const char* m_category;
+    std::int64_t m_frame;
+    std::int64_t m_startUs;
+};
+
+#endif // FRAMETRACE_H
@@ -0,0 +1,151 @@
+#ifndef IMAGEPOOL_H
+#define IMAGEPOOL_H
+
+#include <QImage>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Pixel storage for decoded QImage::Format_RGB32 frames, recycled per
+// resolution. acquire() returns an image over pooled memory; Qt calls the
+// image's cleanup hook when its last copy goes away (bridge cache, image
+// provider, VideoSurface, MosaicView), which hands the buffer back. Decoding a
+// stream therefore stops allocating once a few frames are in circulation.
+// Buffers released after the pool is destroyed are simply freed.
+//
+// Thread-safe: decoder threads acquire, the GUI and render threads release.
+class ImagePool
+{
+public:
+    explicit ImagePool(std::size_t maxIdle = 6)
+        : m_state(std::make_shared<State>())
+    {
+        m_state->maxIdle = maxIdle;
+    }
+
+    // Pool shared by every decoder (JPEG backends, raw YUV, video)
+    static ImagePool& shared()
+    {
+        static ImagePool pool;
+        return pool;
+    }
+
+    // Writable RGB32 image, contents undefined; null for invalid sizes
+    QImage acquire(int width, int height)
+    {
+        if (width <= 0 || height <= 0
+            || static_cast<std::int64_t>(width) * height > std::numeric_limits<int>::max() / 4)
+            return QImage();
+
+        std::unique_ptr<Lease> lease(new Lease);
+        lease->state = m_state;
+        lease->width = width;
+        lease->height = height;
+        {
+            std::lock_guard<std::mutex> lock(m_state->mutex);
+            // Newest first: after a resolution change the old size ages out
+            for (auto it = m_state->idle.end(); it != m_state->idle.begin();) {
+                --it;
+                if (it->width == width && it->height == height) {
+                    lease->pixels = std::move(it->pixels);
+                    m_state->idle.erase(it);
+                    ++m_state->reused;
+                    break;
+                }
+            }
+            if (!lease->pixels)
+                ++m_state->allocated;
+        }
+        if (!lease->pixels)
+            lease->pixels.reset(new uchar[static_cast<std::size_t>(width) * height * 4]);
+
+        uchar* pixels = lease->pixels.get();
+        return QImage(pixels, width, height, width * 4, QImage::Format_RGB32, &ImagePool::release,
+                      lease.release());
+    }
+
+    std::size_t idleCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        return m_state->idle.size();
+    }
+
+    // Memory of the idle buffers
+    std::size_t idleBytes() const
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        std::size_t bytes = 0;
+        for (const Idle& idle : m_state->idle)
+            bytes += static_cast<std::size_t>(idle.width) * idle.height * 4;
+        return bytes;
+    }
+
+    // Free the idle buffers (memory pressure); images in use come back as usual
+    void trim()
+    {
+        std::vector<Idle> freed;
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        freed.swap(m_state->idle);
+    }
+
+    // Buffers created because none of the size was idle / buffers handed out again
+    std::uint64_t allocatedCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        return m_state->allocated;
+    }
+
+    std::uint64_t reusedCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        return m_state->reused;
+    }
+
+private:
+    struct Idle {
+        int width = 0;
+        int height = 0;
+        std::unique_ptr<uchar[]> pixels;
+    };
+
+    struct State {
+        mutable std::mutex mutex;
+        std::vector<Idle> idle; // oldest first
+        std::size_t maxIdle = 6;
+        std::uint64_t allocated = 0;
+        std::uint64_t reused = 0;
+    };
+
+    struct Lease {
+        std::weak_ptr<State> state;
+        int width = 0;
+        int height = 0;
+        std::unique_ptr<uchar[]> pixels;
+    };
+
+    // QImageCleanupFunction: the last copy of an acquired image was destroyed
+    static void release(void* info)
+    {
+        std::unique_ptr<Lease> lease(static_cast<Lease*>(info));
+        std::shared_ptr<State> state = lease->state.lock();
+        if (!state)
+            return;
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (state->maxIdle == 0)
+            return;
+        if (state->idle.size() >= state->maxIdle)
+            state->idle.erase(state->idle.begin());
+        Idle idle;
+        idle.width = lease->width;
+        idle.height = lease->height;
+        idle.pixels = std::move(lease->pixels);
+        state->idle.push_back(std::move(idle));
+    }
+
+    std::shared_ptr<State> m_state;
+};
+
+#endif // IMAGEPOOL_H
@@ -2,12 +2,112 @@
 #include <QDebug>
 #include <QDateTime>
 #include <QSettings>
+#include <QThread>
+#include <QTimer>
+#include <QCoreApplication>
+#include <QStringList>
+#include <QUuid>
+#include <QtMath>
+#include <limits>
 
 #include "imageserverbridge.h"
 #include "websocketserver.h"
 #include "clientmodel.h"
+#include "framedecoder.h"
+#include "videocodec.h"
+#include "sharddirectory.h"
+#include "clusternode.h"
+#include "clustermodel.h"
+#include "framebus.h"
+#include "frameprocessor.h"
+#include "framerecorder.h"
+#include "frametrace.h"
+#include "metricsserver.h"
+#include "browserviewer.h"
+#include "imagepool.h"
+#include "streammetrics.h"
+#include "mosaiclayout.h"
 #include "control.pb.h"
 
+namespace {
+// Thumbnail substream (SET_RESOLUTION bound and default SUBSCRIBE rate)
+const int kThumbnailWidth = 320;
+const int kThumbnailHeight = 180;
+const int kThumbnailFps = 2;
+// A lost keyframe is re-requested, but no more often than this
+const qint64 kKeyframeRequestIntervalMs = 500;
+// Latency percentiles are published once a second; every 5th pass halves the
+// histograms, so samples fade out with a half-life of about 5 s
+const int kLatencyPublishIntervalMs = 1000;
+const int kLatencyDecayTicks = 5;
+// Clock probes; the offset estimate keeps the best of the last 8 (~16 s)
+const int kPingIntervalMs = 2000;
+// A HELLO client that drops off keeps its row, active status and last frame
+// this long, waiting for it to reconnect with its session token
+const qint64 kResumeGraceMs = 30000;
+const int kParkCheckIntervalMs = 1000;
+
+// UI refresh, independent of the frame rate: per-client statistics reach QML
+// at 8 Hz, the frame id (image provider reloads) at most once per display frame
+const int kModelUpdateIntervalMs = 125;
+const int kFrameNotifyIntervalMs = 16;
+// Paced frames are released at the VideoSurface's refreshes; without one for
+// this long (no surface, window hidden) a timer releases them instead
+const qint64 kPacingRefreshTimeoutUs = 200000;
+
+// Pixel memory of a decoded image (shared copies counted once per holder)
+qint64 imageBytes(const QImage& image)
+{
+    return static_cast<qint64>(image.bytesPerLine()) * image.height();
+}
+
+double toMb(qint64 bytes)
+{
+    return qRound(static_cast<double>(bytes) / (1024 * 1024) * 10.0) / 10.0;
+}
+
+// {"p50": ms, "p99": ms, "samples": n} per stage that has samples
+QVariantMap latencyMap(const LatencyBreakdown& breakdown)
+{
+    QVariantMap map;
+    for (int i = 0; i < kLatencyStageCount; ++i) {
+        const LatencyStage stage = static_cast<LatencyStage>(i);
+        const LatencyHistogram& histogram = breakdown[stage];
+        if (histogram.count() == 0)
+            continue;
+        QVariantMap entry;
+        entry["p50"] = qRound(histogram.percentile(50) * 10.0) / 10.0;
+        entry["p99"] = qRound(histogram.percentile(99) * 10.0) / 10.0;
+        entry["samples"] = static_cast<qulonglong>(histogram.count());
+        map[QString::fromLatin1(latencyStageKey(stage))] = entry;
+    }
+    return map;
+}
+
+// Same percentiles for the metrics endpoint, per stage that has samples
+std::vector<LatencyQuantiles> latencyQuantiles(const LatencyBreakdown& breakdown)
+{
+    std::vector<LatencyQuantiles> quantiles;
+    for (int i = 0; i < kLatencyStageCount; ++i) {
+        const LatencyStage stage = static_cast<LatencyStage>(i);
+        const LatencyHistogram& histogram = breakdown[stage];
+        if (histogram.count() == 0)
+            continue;
+        LatencyQuantiles entry;
+        entry.stage = latencyStageKey(stage);
+        entry.p50Us = static_cast<std::int64_t>(histogram.percentile(50) * 1000.0);
+        entry.p99Us = static_cast<std::int64_t>(histogram.percentile(99) * 1000.0);
+        quantiles.push_back(entry);
+    }
+    return quantiles;
+}
+
+double usToMs(qint64 us)
+{
+    return static_cast<double>(us) / 1000.0;
+}
+} // namespace
+
 ImageServerBridge::ImageServerBridge(QObject* parent)
     : QObject(parent)
 {
@@ -15,25 +115,140 @@ ImageServerBridge::ImageServerBridge(QObject* parent)
     m_settings = new QSettings("ImageSocket", "Server", this);
     m_configuredFps = m_settings->value("fps", m_configuredFps).toInt();
     emit configuredFpsChanged(m_configuredFps);
+    m_adaptiveRate = m_settings->value("adaptiveRate", m_adaptiveRate).toBool();
+    m_inactiveClientFps = m_settings->value("inactiveFps", m_inactiveClientFps).toInt();
+    m_thumbnailMode = m_settings->value("thumbnails", m_thumbnailMode).toBool();
+    m_mosaicMode = m_settings->value("mosaic", m_mosaicMode).toBool();
+    m_videoCodec = m_settings->value("codec", m_videoCodec).toInt();
+    m_resolutionFollowsDisplay = m_settings->value("fitToDisplay", m_resolutionFollowsDisplay).toBool();
+    m_jitterMode = static_cast<JitterMode>(qBound(0, m_settings->value("jitterBuffer", 0).toInt(),
+                                                  static_cast<int>(JitterMode::Smooth)));
 
     m_server = new WebSocketServer(this);
+    m_server->setIoThreadCount(m_settings->value("ioThreads", m_server->ioThreadCount()).toInt());
+    if (m_settings->value("serverBackend").toString() == QLatin1String("beast"))
+        m_server->setBackend(WebSocketServer::Backend::Beast);
+    m_server->setReusePort(m_settings->value("reusePort", false).toBool());
+    m_server->setUdpFrames(m_settings->value("udpFrames", false).toBool());
+    m_server->setTls(m_settings->value("tlsCert").toString(), m_settings->value("tlsKey").toString());
+    setKeepalive(m_settings->value("keepaliveMs", KeepaliveConfig().intervalMs).toInt(),
+                 m_settings->value("keepaliveMisses", KeepaliveConfig().maxMissed).toInt());
     m_clientModel = new ClientModel(this);
+    m_clientModel->setUpdateIntervalMs(kModelUpdateIntervalMs);
+    m_clusterModel = new ClusterModel(this);
+    m_frameBus = new FrameBus(this);
+    m_processing = new ProcessingStage(m_frameBus, this);
+    m_recorder = new FrameRecorder(m_frameBus, this);
+    m_preroll = new PrerollBuffer(m_frameBus, this);
+    applyPreroll(m_settings->value("prerollSeconds", 0).toInt(), m_settings->value("prerollMb", 16.0).toDouble());
+    m_streamMetrics = std::make_shared<StreamMetrics>();
+    m_snapshots = std::make_shared<SnapshotCache>();
+    connect(m_frameBus, &FrameBus::subscribersChanged, this, &ImageServerBridge::onBusSubscribersChanged);
 
     // connect server signals
     connect(m_server, &WebSocketServer::clientConnected, this, &ImageServerBridge::onClientConnected);
     connect(m_server, &WebSocketServer::clientDisconnected, this, &ImageServerBridge::onSessionDisconnected);
     connect(m_server, &WebSocketServer::controlMessageReceived, this, &ImageServerBridge::onControlMessageReceived);
+    connect(m_server, &WebSocketServer::encodedFrameReceived, this, &ImageServerBridge::onEncodedFrameReceived);
     connect(m_server, &WebSocketServer::frameReceived, this, &ImageServerBridge::onFrameReceived);
+    connect(m_server, &WebSocketServer::framesDropped, this, &ImageServerBridge::onFramesDropped);
+    connect(m_server, &WebSocketServer::keyframeNeeded, this, &ImageServerBridge::onKeyframeNeeded);
+    connect(m_server, &WebSocketServer::frameTimed, this, &ImageServerBridge::onFrameTimed);
+    connect(m_server, &WebSocketServer::clientThrottled, this, &ImageServerBridge::onClientThrottled);
+    connect(m_server, &WebSocketServer::viewerSubscribed, this, &ImageServerBridge::onViewerSubscribed);
+    connect(m_server, &WebSocketServer::viewerDisconnected, this, &ImageServerBridge::onViewerDisconnected);
+    // A watched client keeps streaming at the configured rate, shown or not
+    connect(m_server, &WebSocketServer::watchedChanged, this, &ImageServerBridge::applySubscription);
 
     // Forward server-level errors to UI via eventOccurred
     connect(m_server, &WebSocketServer::serverError, this, &ImageServerBridge::onServerError);
+
+    m_rateTimer = new QTimer(this);
+    m_rateTimer->setInterval(RateControllerConfig().intervalMs);
+    connect(m_rateTimer, &QTimer::timeout, this, &ImageServerBridge::evaluateRateControl);
+    if (m_adaptiveRate)
+        m_rateTimer->start();
+
+    // Costs per frame change with the scene and the rate controller: re-split once per interval
+    m_budgetTimer = new QTimer(this);
+    m_budgetTimer->setInterval(RateControllerConfig().intervalMs);
+    connect(m_budgetTimer, &QTimer::timeout, this, &ImageServerBridge::rebalanceIngress);
+    applyIngressBudget(m_settings->value("ingressMbps", 0.0).toDouble(),
+                       m_settings->value("ingressDecodeMs", 0.0).toDouble());
+    // Scene activity is judged over the same interval as the rate
+    m_activityTimer = new QTimer(this);
+    m_activityTimer->setInterval(RateControllerConfig().intervalMs);
+    connect(m_activityTimer, &QTimer::timeout, this, &ImageServerBridge::evaluateSceneActivity);
+    applyMotionAdaptiveFps(m_settings->value("motionIdleFps", 0).toInt());
+    applyAdmissionLimits(m_settings->value("maxSessions", 0).toInt(),
+                         m_settings->value("maxMessageMb", 64.0).toDouble(),
+                         m_settings->value("clientMaxMbps", 0.0).toDouble());
+    applyAcceptRate(m_settings->value("acceptRate", 0.0).toDouble(), m_settings->value("acceptBurst", 0).toInt());
+    m_memoryTimer = new QTimer(this);
+    m_memoryTimer->setInterval(RateControllerConfig().intervalMs);
+    connect(m_memoryTimer, &QTimer::timeout, this, &ImageServerBridge::evaluateMemory);
+    applyMemoryBudget(m_settings->value("memoryMb", 0.0).toDouble(),
+                      m_settings->value("clientMemoryMb", 0.0).toDouble());
+
+    m_latencyTimer = new QTimer(this);
+    m_latencyTimer->setInterval(kLatencyPublishIntervalMs);
+    connect(m_latencyTimer, &QTimer::timeout, this, &ImageServerBridge::publishLatency);
+    m_latencyTimer->start();
+
+    m_parkTimer = new QTimer(this);
+    m_parkTimer->setInterval(kParkCheckIntervalMs);
+    connect(m_parkTimer, &QTimer::timeout, this, &ImageServerBridge::expireParkedSessions);
+
+    m_pingTimer = new QTimer(this);
+    m_pingTimer->setInterval(kPingIntervalMs);
+    connect(m_pingTimer, &QTimer::timeout, this, &ImageServerBridge::sendPings);
+    m_pingTimer->start();
+
+    m_frameNotifyTimer = new QTimer(this);
+    m_frameNotifyTimer->setSingleShot(true);
+    m_frameNotifyTimer->setInterval(kFrameNotifyIntervalMs);
+    connect(m_frameNotifyTimer, &QTimer::timeout, this, &ImageServerBridge::notifyFrameId);
+
+    m_pacingTimer = new QTimer(this);
+    m_pacingTimer->setSingleShot(true);
+    m_pacingTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_pacingTimer, &QTimer::timeout, this, [this]() {
+        showPacedFrame(EncodedFrame::nowUs());
+        schedulePacing();
+    });
 }
 
 // --- State getters and helpers ---
 ImageServerBridge::ServerState ImageServerBridge::serverState() const { return m_serverState; }
 ImageServerBridge::ConnectionState ImageServerBridge::connectionState() const { return m_connectionState; }
 QString ImageServerBridge::statusMessage() const { return m_statusMessage; }
-QImage ImageServerBridge::lastFrame() const { return m_lastFrame; }
+
+QImage ImageServerBridge::lastFrame() const
+{
+    if (m_lastFrame.isNull() && !m_lastRawFrame.isEmpty()) {
+        if (m_lastRawImage.isNull() && !FrameDecoder::decodeFrame(m_lastRawFrame, m_lastRawImage))
+            m_lastRawImage = QImage();
+        return m_lastRawImage;
+    }
+    return m_lastFrame;
+}
+
+void ImageServerBridge::noteRequestedFrameSize(const QSize& size)
+{
+    if (!size.isValid() || size.isEmpty())
+        return; // no sourceSize: the item scales whatever it gets
+    // Image providers may be asked from the scene graph's loader thread
+    QMetaObject::invokeMethod(this, [this, size]() {
+        const QSize grown = m_requestedFrameSize.expandedTo(size);
+        if (grown == m_requestedFrameSize)
+            return;
+        m_requestedFrameSize = grown;
+        if (!m_activeClientId.isEmpty())
+            applyFrameBound(m_activeClientId);
+    });
+}
+
+QImage ImageServerBridge::thumbnail(const QString& clientId) const { return m_thumbnails.value(clientId); }
 int ImageServerBridge::frameId() const { return m_frameId; }
 int ImageServerBridge::currentFps() const { return m_currentFps; }
 
@@ -67,6 +282,7 @@ void ImageServerBridge::setStatusMessage(const QString& msg)
 
 ImageServerBridge::~ImageServerBridge()
 {
+    stopCluster();
     stop();
 }
 
@@ -80,6 +296,187 @@ QObject* ImageServerBridge::clientModel() const
     return m_clientModel;
 }
 
+QObject* ImageServerBridge::clusterModel() const
+{
+    return m_clusterModel;
+}
+
+FrameBus* ImageServerBridge::frameBus() const
+{
+    return m_frameBus;
+}
+
+ProcessingStage* ImageServerBridge::processingStage() const
+{
+    return m_processing;
+}
+
+QVariantList ImageServerBridge::processorStats() const
+{
+    return m_processing->statsList();
+}
+
+FrameRecorder* ImageServerBridge::recorder() const
+{
+    return m_recorder;
+}
+
+bool ImageServerBridge::startRecording(const QString& directory)
+{
+    FrameRecorder::Options options;
+    options.directory = directory;
+    return m_recorder->start(options);
+}
+
+void ImageServerBridge::stopRecording()
+{
+    m_recorder->stop();
+}
+
+QVariantMap ImageServerBridge::recordingStats() const
+{
+    return m_recorder->statsMap();
+}
+
+PrerollBuffer* ImageServerBridge::preroll() const
+{
+    return m_preroll;
+}
+
+bool ImageServerBridge::setPreroll(int seconds, double mbPerClient)
+{
+    const bool started = applyPreroll(seconds, mbPerClient);
+
+    // A window the buffer refused is not kept for the next start
+    if (started && m_settings) {
+        m_settings->setValue("prerollSeconds", qMax(0, seconds));
+        if (mbPerClient > 0.0)
+            m_settings->setValue("prerollMb", mbPerClient);
+        m_settings->sync();
+    }
+    return started;
+}
+
+bool ImageServerBridge::applyPreroll(int seconds, double mbPerClient)
+{
+    m_preroll->stop();
+    bool started = true;
+    if (seconds > 0) {
+        PrerollBuffer::Options options;
+        options.windowMs = seconds * 1000;
+        if (mbPerClient > 0.0)
+            options.bytesPerClient = static_cast<qint64>(mbPerClient * 1024 * 1024);
+        started = m_preroll->start(options);
+    }
+    return started;
+}
+
+QString ImageServerBridge::captureEventClip(const QString& clientId, const QString& directory, int seconds)
+{
+    const QString path = m_preroll->exportClip(clientId, directory, qMax(0, seconds) * 1000);
+    if (path.isEmpty())
+        qWarning() << "No event clip for" << clientId << "(pre-roll off or empty)";
+    else
+        qInfo() << "Event clip of" << clientId << "written to" << path;
+    return path;
+}
+
+QVariantMap ImageServerBridge::prerollStats() const
+{
+    return m_preroll->statsMap();
+}
+
+QVariantMap ImageServerBridge::jitterStats() const
+{
+    QVariantMap stats;
+    stats["mode"] = static_cast<int>(m_jitterMode);
+    const auto it = m_jitterBuffers.constFind(m_activeClientId);
+    if (it == m_jitterBuffers.constEnd())
+        return stats;
+    stats["targetDelayMs"] = qRound(usToMs(it->targetDelayUs()) * 10.0) / 10.0;
+    stats["held"] = static_cast<int>(it->size());
+    stats["shown"] = static_cast<qulonglong>(it->shown());
+    stats["skipped"] = static_cast<qulonglong>(it->skipped());
+    stats["late"] = static_cast<qulonglong>(it->late());
+    return stats;
+}
+
+QVariantMap ImageServerBridge::serverStats()
+{
+    double fps = 0.0;
+    qulonglong dropped = 0;
+    for (int i = 0; i < m_clientModel->count(); ++i) {
+        fps += m_clientModel->measuredFpsAt(i);
+        dropped += static_cast<qulonglong>(qMax(0, m_clientModel->droppedFramesAt(i)));
+    }
+    LatencyHistogram network;
+    LatencyHistogram decode;
+    for (const LatencyBreakdown& breakdown : qAsConst(m_latency)) {
+        network.merge(breakdown[LatencyStage::Network]);
+        decode.merge(breakdown[LatencyStage::Decode]);
+    }
+    const auto rounded = [](double value) { return value < 0.0 ? value : qRound(value * 10.0) / 10.0; };
+
+    QVariantMap stats;
+    stats["clients"] = m_clientModel->count();
+    stats["fps"] = rounded(fps);
+    stats["dropped"] = dropped;
+    stats["networkP50Ms"] = rounded(network.percentile(50));
+    stats["networkP99Ms"] = rounded(network.percentile(99));
+    stats["decodeP50Ms"] = rounded(decode.percentile(50));
+    stats["decodeP99Ms"] = rounded(decode.percentile(99));
+    stats["cpuPercent"] = rounded(m_cpu.sample());
+    return stats;
+}
+
+StreamMetrics* ImageServerBridge::streamMetrics() const
+{
+    return m_streamMetrics.get();
+}
+
+bool ImageServerBridge::startMetrics(quint16 port)
+{
+    if (!m_metricsServer)
+        m_metricsServer = new MetricsServer(m_streamMetrics, this);
+    return m_metricsServer->start(port);
+}
+
+void ImageServerBridge::stopMetrics()
+{
+    if (m_metricsServer)
+        m_metricsServer->stop();
+}
+
+quint16 ImageServerBridge::metricsPort() const
+{
+    return m_metricsServer ? m_metricsServer->port() : 0;
+}
+
+bool ImageServerBridge::startBrowserViewer(quint16 port)
+{
+    if (!m_browserViewer)
+        m_browserViewer = new BrowserViewer(m_frameBus, m_streamMetrics, m_snapshots, this);
+    return m_browserViewer->start(port);
+}
+
+void ImageServerBridge::stopBrowserViewer()
+{
+    if (m_browserViewer)
+        m_browserViewer->stop();
+    m_snapshots->clear();
+}
+
+quint16 ImageServerBridge::browserViewerPort() const
+{
+    return m_browserViewer ? m_browserViewer->port() : 0;
+}
+
+StreamCounters* ImageServerBridge::streamCountersFor(const QString& clientId) const
+{
+    auto it = m_streamCounters.constFind(clientId);
+    return it != m_streamCounters.constEnd() ? it.value().get() : nullptr;
+}
+
 bool ImageServerBridge::start()
 {
     setServerState(ServerState::Starting);
@@ -95,6 +492,9 @@ bool ImageServerBridge::start()
         return false;
     }
 
+    if (m_server->reusePort())
+        m_shards.reset(new ShardDirectory(serverPort()));
+
     QVariantMap details;
     details["port"] = serverPort();
     setServerState(ServerState::Running);
@@ -113,6 +513,197 @@ void ImageServerBridge::setPort(quint16 port)
     m_port = port;
 }
 
+void ImageServerBridge::setReusePort(bool enabled)
+{
+    m_server->setReusePort(enabled);
+}
+
+bool ImageServerBridge::reusePort() const
+{
+    return m_server && m_server->reusePort();
+}
+
+void ImageServerBridge::setUdpFrames(bool enabled)
+{
+    m_server->setUdpFrames(enabled);
+}
+
+bool ImageServerBridge::udpFrames() const
+{
+    return m_server && m_server->udpFrames();
+}
+
+void ImageServerBridge::setTls(const QString& certFile, const QString& keyFile)
+{
+    m_server->setTls(certFile, keyFile);
+}
+
+bool ImageServerBridge::tlsEnabled() const
+{
+    return m_server && m_server->tlsEnabled();
+}
+
+void ImageServerBridge::setKeepalive(int intervalMs, int maxMissed)
+{
+    KeepaliveConfig config;
+    config.intervalMs = qMax(0, intervalMs);
+    config.maxMissed = qMax(0, maxMissed);
+    m_server->setKeepalive(config);
+}
+
+QVariantMap ImageServerBridge::locateClient(const QString& clientIdOrAlias) const
+{
+    QVariantMap result;
+    ShardDirectory::Entry entry;
+    if (m_shards) {
+        if (!m_shards->find(clientIdOrAlias, entry))
+            return result;
+    } else {
+        // Not sharded: only this process' clients
+        int idx = m_clientModel->indexOfClient(clientIdOrAlias);
+        if (idx < 0) {
+            for (int i = 0; i < m_clientModel->rowCount() && idx < 0; ++i) {
+                if (m_clientModel->aliasAt(i) == clientIdOrAlias)
+                    idx = i;
+            }
+        }
+        if (idx < 0)
+            return result;
+        entry.pid = QCoreApplication::applicationPid();
+        entry.clientId = m_clientModel->clientIdAt(idx);
+        entry.alias = m_clientModel->aliasAt(idx);
+    }
+    result["pid"] = entry.pid;
+    result["clientId"] = entry.clientId;
+    result["alias"] = entry.alias;
+    result["address"] = entry.address;
+    result["local"] = entry.pid == QCoreApplication::applicationPid();
+    return result;
+}
+
+bool ImageServerBridge::startCluster(const QString& nodeId, quint16 port, const QStringList& peers,
+                                     const QString& advertiseHost, quint32 clusterKey)
+{
+    if (m_cluster || nodeId.isEmpty())
+        return false;
+    m_clusterHost = advertiseHost;
+    m_cluster = new ClusterNode(nodeId, [this]() { return buildNodeReport(); }, this);
+    connect(m_cluster, &ClusterNode::nodeReported, m_clusterModel,
+            [this](const QString& node, const QVariantList& clients) { m_clusterModel->setNodeClients(node, clients); });
+    connect(m_cluster, &ClusterNode::nodeLost, m_clusterModel, &ClusterModel::removeNode);
+    if (!m_cluster->start(port, peers, clusterKey)) {
+        delete m_cluster;
+        m_cluster = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void ImageServerBridge::stopCluster()
+{
+    if (!m_cluster)
+        return;
+    delete m_cluster;
+    m_cluster = nullptr;
+    m_clusterModel->clear();
+}
+
+quint16 ImageServerBridge::clusterPort() const
+{
+    return m_cluster ? m_cluster->port() : 0;
+}
+
+QVariantList ImageServerBridge::clusterNodes() const
+{
+    QVariantList nodes;
+    if (!m_cluster)
+        return nodes;
+    for (const NodeLoad& load : m_cluster->peers()) {
+        QVariantMap node;
+        node["nodeId"] = QString::fromStdString(load.nodeId);
+        node["host"] = QString::fromStdString(load.host);
+        node["port"] = load.port;
+        node["sessions"] = load.sessions;
+        node["utilization"] = qRound(nodeUtilization(load) * 100.0) / 100.0;
+        node["acceptsClients"] = load.acceptsClients;
+        nodes.append(node);
+    }
+    return nodes;
+}
+
+imagesocket::control::NodeReport ImageServerBridge::buildNodeReport()
+{
+    imagesocket::control::NodeReport report;
+    report.set_host(m_clusterHost.toStdString());
+    report.set_port(serverPort());
+    report.set_cpu_percent(m_clusterCpu.sample());
+    report.set_cpu_cores(qMax(1, QThread::idealThreadCount()));
+
+    const WebSocketServer::AdmissionLimits limits = m_server->admissionLimits();
+    const IngressBudgetConfig& budget = m_ingressBudget.config();
+    report.set_max_sessions(limits.maxSessions);
+    report.set_max_ingress_bits_per_second(budget.maxBitsPerSecond);
+    report.set_max_decode_ms_per_second(budget.maxDecodeMsPerSecond);
+    report.set_accepts_clients(m_serverState == Running
+                               && (limits.maxSessions == 0 || m_server->sessionCount() < limits.maxSessions));
+
+    // Cameras are the model's rows (viewers have none); their load from the last statistics window
+    double bitsPerSecond = 0.0;
+    double decodeMsPerSecond = 0.0;
+    QVariantList local;
+    for (int i = 0; i < m_clientModel->count(); ++i) {
+        const QModelIndex row = m_clientModel->index(i, 0);
+        const double fps = m_clientModel->measuredFpsAt(i);
+        bitsPerSecond += qMax(0, m_clientModel->data(row, ClientModel::BytesPerSecondRole).toInt()) * 8.0;
+        decodeMsPerSecond += qMax(0.0, m_clientModel->decodeMsAt(i)) * fps;
+
+        imagesocket::control::NodeClient* client = report.add_clients();
+        client->set_client_id(m_clientModel->clientIdAt(i).toStdString());
+        client->set_alias(m_clientModel->aliasAt(i).toStdString());
+        client->set_status(m_clientModel->data(row, ClientModel::StatusRole).toString().toStdString());
+        client->set_measured_fps(qRound(fps));
+        client->set_throughput_kbps(m_clientModel->data(row, ClientModel::ThroughputKbpsRole).toInt());
+
+        QVariantMap entry;
+        entry["id"] = m_clientModel->clientIdAt(i);
+        entry["alias"] = m_clientModel->aliasAt(i);
+        entry["status"] = m_clientModel->data(row, ClientModel::StatusRole);
+        entry["measuredFps"] = fps;
+        entry["throughputKbps"] = m_clientModel->data(row, ClientModel::ThroughputKbpsRole);
+        local.append(entry);
+    }
+    report.set_sessions(m_clientModel->count());
+    report.set_ingress_bits_per_second(bitsPerSecond);
+    report.set_decode_ms_per_second(decodeMsPerSecond);
+
+    // This node's rows of the cluster view follow its own reports
+    if (m_cluster)
+        m_clusterModel->setNodeClients(m_cluster->nodeId(), local, true);
+    return report;
+}
+
+bool ImageServerBridge::redirectToPeer(const QString& clientId, const QString& token)
+{
+    // A client coming back to its parked session stays with it
+    if (!m_cluster || m_parkedSessions.contains(token))
+        return false;
+    NodeLoad target;
+    if (!m_cluster->chooseNode(target))
+        return false;
+
+    imagesocket::control::ControlMessage msg;
+    msg.set_type(imagesocket::control::REDIRECT);
+    msg.set_redirect_host(target.host);
+    msg.set_redirect_port(target.port);
+    if (!m_server->sendControlToClient(clientId, msg))
+        return false;
+    const QString node = QString::fromStdString(target.nodeId);
+    m_cluster->placed(node);
+    qInfo() << "Redirecting" << clientId << "to node" << node << QString::fromStdString(target.host) << target.port;
+    m_server->disconnectClient(clientId, QStringLiteral("redirected"));
+    return true;
+}
+
 
 
 void ImageServerBridge::stop()
@@ -121,6 +712,11 @@ void ImageServerBridge::stop()
         setServerState(ServerState::Stopping);
         setStatusMessage(QStringLiteral("Stopping"));
         m_server->stop();
+        // Nobody reconnects to a stopped server
+        const QList<QString> tokens = m_parkedSessions.keys();
+        for (const QString& token : tokens)
+            forgetClient(m_parkedSessions.take(token).clientId);
+        m_shards.reset();
         emit eventOccurred(imagesocket::ServerStopped, QVariantMap());
         setServerState(ServerState::Idle);
         setStatusMessage(QStringLiteral("Stopped"));
@@ -139,12 +735,26 @@ void ImageServerBridge::setActiveClient(const QString& clientId)
 
     QString previousClient = m_activeClientId;
     m_activeClientId = clientId;
+    // Only the active client is paced
+    const auto paced = m_jitterBuffers.find(previousClient);
+    if (paced != m_jitterBuffers.end())
+        paced->clear();
+
+    // Only the active client streams at full rate and is decoded for display
+    applySubscription(previousClient);
+    applySubscription(m_activeClientId);
 
     // Update model to reflect active status
     m_clientModel->setClientStatus(m_activeClientId, QStringLiteral("Active"));
 
     setFps(m_configuredFps);
 
+    // The new active client takes the largest share of the budget
+    rebalanceIngress();
+
+    m_activeClientLatency = latencyMap(m_latency.value(m_activeClientId));
+    emit activeClientLatencyChanged();
+
     // Emit event for UI
     QVariantMap details;
     details["clientId"] = clientId;
@@ -177,20 +787,12 @@ void ImageServerBridge::setFps(int fps)
         return;
     }
 
+    // Within the ingress budget the client may get less than configured
+    const int sentFps = budgetedFps(m_activeClientId, fps);
     imagesocket::control::ControlMessage msg;
     msg.set_type(imagesocket::control::SET_FPS);
-    msg.set_fps(fps);
-
-    std::string out;
-    if (!msg.SerializeToString(&out)) {
-        QVariantMap details;
-        details["fps"] = fps;
-        emit eventOccurred(imagesocket::FpsSendError, details);
-        return;
-    }
-
-    QByteArray ba(out.data(), (int)out.size());
-    if (!m_server->sendControlToClient(m_activeClientId, ba)) {
+    msg.set_fps(sentFps);
+    if (!m_server->sendControlToClient(m_activeClientId, msg)) {
         QVariantMap details;
         details["fps"] = fps;
         details["client"] = m_activeClientId;
@@ -204,7 +806,7 @@ void ImageServerBridge::setFps(int fps)
     details["client"] = m_activeClientId;
 
     // Update current FPS and notify QML
-    m_currentFps = fps;
+    m_currentFps = sentFps;
     emit currentFpsChanged(m_currentFps);
 
     // Store configured FPS in client model
@@ -212,6 +814,9 @@ void ImageServerBridge::setFps(int fps)
         m_clientModel->setClientConfiguredFps(m_activeClientId, fps);
     }
 
+    // The user's FPS is the ceiling the rate controller may lower the stream from
+    applyFpsCeiling(m_activeClientId, fps);
+
     emit eventOccurred(imagesocket::FpsApplied, details);
 }
 
@@ -219,6 +824,42 @@ int ImageServerBridge::configuredFps() const {
     return m_configuredFps;
 }
 
+bool ImageServerBridge::adaptiveRate() const {
+    return m_adaptiveRate;
+}
+
+void ImageServerBridge::setAdaptiveRate(bool enabled) {
+    if (m_adaptiveRate == enabled) return;
+    m_adaptiveRate = enabled;
+
+    if (m_settings) {
+        m_settings->setValue("adaptiveRate", m_adaptiveRate);
+        m_settings->sync();
+    }
+
+    if (m_adaptiveRate) {
+        m_rateTimer->start();
+    } else {
+        m_rateTimer->stop();
+        // Hand the clients back their configured settings
+        for (auto it = m_rateControllers.begin(); it != m_rateControllers.end(); ++it) {
+            const QString clientId = it.key();
+            it.value() = RateController();
+            sendCommand(clientId, imagesocket::control::SET_QUALITY, it.value().quality());
+            int idx = m_clientModel->indexOfClient(clientId);
+            int fps = m_inactiveClientFps;
+            if (clientId == m_activeClientId)
+                fps = m_clientModel->configuredFpsAt(idx);
+            else if (m_thumbnailMode && fps <= 0)
+                fps = kThumbnailFps;
+            if (fps > 0 && !m_pausedClients.contains(clientId))
+                sendCommand(clientId, imagesocket::control::SET_FPS, applyFpsCeiling(clientId, fps));
+        }
+    }
+
+    emit adaptiveRateChanged(m_adaptiveRate);
+}
+
 void ImageServerBridge::setConfiguredFps(int fps) {
     if (m_configuredFps == fps) return;
     m_configuredFps = fps;
@@ -237,93 +878,697 @@ void ImageServerBridge::setConfiguredFps(int fps) {
     }
 }
 
-void ImageServerBridge::onClientConnected(const QString& clientId, const QHostAddress& address)
-{
-    Q_UNUSED(address);
-    m_clientModel->addClient(clientId, QStringLiteral("Connected"));
+int ImageServerBridge::inactiveClientFps() const {
+    return m_inactiveClientFps;
+}
 
-    // Update connection state
-    if (m_clientModel->rowCount() > 0) {
-        setConnectionState(ConnectionState::ClientsConnected);
-        setStatusMessage(QStringLiteral("Clients connected"));
+void ImageServerBridge::setInactiveClientFps(int fps) {
+    fps = qMax(0, fps);
+    if (m_inactiveClientFps == fps) return;
+    m_inactiveClientFps = fps;
+
+    if (m_settings) {
+        m_settings->setValue("inactiveFps", m_inactiveClientFps);
+        m_settings->sync();
     }
 
-    // If there's no active client yet, make this client active
-    if (m_activeClientId.isEmpty()) {
-        setActiveClient(clientId);
+    // Re-subscribe every non-active client at the new rate
+    for (int i = 0; i < m_clientModel->rowCount(); ++i) {
+        const QString clientId = m_clientModel->clientIdAt(i);
+        if (clientId != m_activeClientId)
+            applySubscription(clientId);
     }
 
-    // Prefer server-wide configured FPS if present; otherwise, reapply per-client configured FPS
-    int idx = m_clientModel->indexOfClient(clientId);
-    if (m_configuredFps > 0 && m_activeClientId == clientId) {
-        setFps(m_configuredFps);
-    } else if (idx >= 0) {
-        int configured = m_clientModel->configuredFpsAt(idx);
-        if (configured > 0 && m_activeClientId == clientId) {
-            setFps(configured);
-        }
+    emit inactiveClientFpsChanged(m_inactiveClientFps);
+}
+
+bool ImageServerBridge::thumbnailMode() const {
+    return m_thumbnailMode;
+}
+
+void ImageServerBridge::setThumbnailMode(bool enabled) {
+    if (m_thumbnailMode == enabled) return;
+    m_thumbnailMode = enabled;
+
+    if (m_settings) {
+        m_settings->setValue("thumbnails", m_thumbnailMode);
+        m_settings->sync();
+    }
+
+    for (int i = 0; i < m_clientModel->rowCount(); ++i) {
+        const QString clientId = m_clientModel->clientIdAt(i);
+        if (clientId != m_activeClientId)
+            applySubscription(clientId);
     }
+    if (!m_thumbnailMode)
+        m_thumbnails.clear();
+
+    emit thumbnailModeChanged(m_thumbnailMode);
 }
 
-void ImageServerBridge::onControlMessageReceived(const QString& clientId, const QByteArray& serialized)
-{
-    imagesocket::control::ControlMessage msg;
-    if (!msg.ParseFromArray(serialized.constData(), serialized.size())) {
-        return;
+bool ImageServerBridge::mosaicMode() const {
+    return m_mosaicMode;
+}
+
+void ImageServerBridge::setMosaicMode(bool enabled) {
+    if (m_mosaicMode == enabled) return;
+    m_mosaicMode = enabled;
+
+    if (m_settings) {
+        m_settings->setValue("mosaic", m_mosaicMode);
+        m_settings->sync();
     }
 
-    // If client replied with an alias message, store it in the model
-    if (msg.type() == imagesocket::control::ALIAS) {
-        const std::string& r = msg.alias();
-        if (!r.empty()) {
-            QString lastAlias = m_clientModel->aliasAt(m_clientModel->indexOfClient(clientId));
-            QString alias = QString::fromStdString(r);
-
-            if(alias != lastAlias)
-            {
-                m_clientModel->setClientAlias(clientId, alias);
-                qInfo() << "Set alias for" << clientId << "->" << alias;  
-                
-                if(clientId == m_activeClientId) {
-                    emit activeClientAliasChanged(alias);
-                }
-            }
-            
-            // Emit connection event once alias is available
-            QVariantMap details;
-            details["clientId"] = clientId;
-            details["alias"] = alias;
-            emit eventOccurred(imagesocket::ClientConnected, details);
-            
-            // Also emit higher-level signal with alias for toast/UI
-            emit clientConnectedWithAlias(clientId, alias);        
-        }
+    for (int i = 0; i < m_clientModel->rowCount(); ++i) {
+        const QString clientId = m_clientModel->clientIdAt(i);
+        if (clientId != m_activeClientId)
+            applySubscription(clientId);
     }
+    refreshFrameBounds(); // the active client goes from the whole surface to one tile and back
+
+    emit mosaicModeChanged(m_mosaicMode);
 }
 
-void ImageServerBridge::onSessionDisconnected(const QString& clientId)
+bool ImageServerBridge::displayEnabled() const {
+    return m_displayEnabled;
+}
+
+void ImageServerBridge::setDisplayEnabled(bool enabled) {
+    if (m_displayEnabled == enabled) return;
+    m_displayEnabled = enabled;
+
+    if (!m_displayEnabled) {
+        m_lastFrame = QImage();
+        m_lastRawFrame = EncodedFrame();
+        m_lastRawImage = QImage();
+        m_thumbnails.clear();
+        for (JitterBuffer<PacedFrame>& buffer : m_jitterBuffers)
+            buffer.clear();
+    }
+    for (int i = 0; i < m_clientModel->rowCount(); ++i)
+        applySubscription(m_clientModel->clientIdAt(i));
+}
+
+void ImageServerBridge::onBusSubscribersChanged()
 {
-    // Obtain alias before removing
-    int idx = m_clientModel->indexOfClient(clientId);
-    QString alias;
-    if (idx >= 0) alias = m_clientModel->aliasAt(idx);
+    // A recording or processor may now need every pixel, or no longer
+    // (headless: decoding at all; with a display: its priority)
+    refreshFrameBounds();
+    for (int i = 0; i < m_clientModel->rowCount(); ++i)
+        updateDecodeInterest(m_clientModel->clientIdAt(i));
+}
 
-    // Remove client from model
-    m_clientModel->removeClient(clientId);
+int ImageServerBridge::videoCodec() const {
+    return m_videoCodec;
+}
 
-    // Emit disconnection event with alias if available
-    QVariantMap details;
-    details["clientId"] = clientId;
-    details["alias"] = alias.isEmpty() ? clientId : alias;
-    emit eventOccurred(imagesocket::ClientDisconnected, details);
+bool ImageServerBridge::resolutionFollowsDisplay() const {
+    return m_resolutionFollowsDisplay;
+}
 
-    // Also emit higher-level signal for UI/Toast
-    emit clientDisconnectedWithAlias(clientId, details["alias"].toString());
+void ImageServerBridge::setResolutionFollowsDisplay(bool enabled) {
+    if (m_resolutionFollowsDisplay == enabled) return;
+    m_resolutionFollowsDisplay = enabled;
 
-    // If no clients left, clear active and notify UI
-    if (m_clientModel->rowCount() == 0) {
-        m_activeClientId.clear();
-        setConnectionState(ConnectionState::NoClients);
+    if (m_settings) {
+        m_settings->setValue("fitToDisplay", m_resolutionFollowsDisplay);
+        m_settings->sync();
+    }
+
+    refreshFrameBounds();
+    emit resolutionFollowsDisplayChanged(m_resolutionFollowsDisplay);
+}
+
+int ImageServerBridge::jitterMode() const {
+    return static_cast<int>(m_jitterMode);
+}
+
+void ImageServerBridge::setJitterMode(int mode) {
+    if (mode < 0 || mode > static_cast<int>(JitterMode::Smooth) || mode == jitterMode()) return;
+    m_jitterMode = static_cast<JitterMode>(mode);
+
+    if (m_settings) {
+        m_settings->setValue("jitterBuffer", mode);
+        m_settings->sync();
+    }
+
+    if (m_jitterMode == JitterMode::Off) {
+        // Nothing waits any more: the newest held frame goes up now
+        showPacedFrame(std::numeric_limits<qint64>::max());
+        m_jitterBuffers.clear();
+        m_pacingTimer->stop();
+    } else {
+        for (JitterBuffer<PacedFrame>& buffer : m_jitterBuffers)
+            buffer.setMode(m_jitterMode);
+    }
+    emit jitterModeChanged(mode);
+}
+
+void ImageServerBridge::setDisplayViewport(int width, int height)
+{
+    if (m_viewport.width == width && m_viewport.height == height)
+        return;
+    m_viewport.width = qMax(0, width);
+    m_viewport.height = qMax(0, height);
+    // Bounds are rounded up: most resize steps send nothing (decode targets follow every step)
+    refreshFrameBounds();
+}
+
+void ImageServerBridge::setClientRegion(const QString& clientId, qreal x, qreal y, qreal width, qreal height)
+{
+    if (m_clientModel->indexOfClient(clientId) < 0)
+        return;
+    FrameRegion region;
+    region.x = qBound(0.0, x, 1.0);
+    region.y = qBound(0.0, y, 1.0);
+    region.width = qBound(0.0, width, 1.0 - region.x);
+    region.height = qBound(0.0, height, 1.0 - region.y);
+    if (region.isFull())
+        region = FrameRegion();
+
+    const FrameRegion previous = m_clientRegions.value(clientId);
+    if (previous.x == region.x && previous.y == region.y && previous.width == region.width
+        && previous.height == region.height)
+        return;
+    if (region.isFull())
+        m_clientRegions.remove(clientId);
+    else
+        m_clientRegions.insert(clientId, region);
+    sendRegion(clientId, region);
+    emit clientRegionChanged(clientId);
+}
+
+QVariantMap ImageServerBridge::clientRegion(const QString& clientId) const
+{
+    const FrameRegion region = m_clientRegions.value(clientId);
+    QVariantMap result;
+    result["x"] = region.isFull() ? 0.0 : region.x;
+    result["y"] = region.isFull() ? 0.0 : region.y;
+    result["width"] = region.isFull() ? 1.0 : region.width;
+    result["height"] = region.isFull() ? 1.0 : region.height;
+    return result;
+}
+
+bool ImageServerBridge::videoCodecSupported(int codec) const {
+    const VideoCodec value = static_cast<VideoCodec>(codec);
+    return value == VideoCodec::Mjpeg || VideoDecoder::available(value);
+}
+
+void ImageServerBridge::setVideoCodec(int codec) {
+    if (m_videoCodec == codec || !videoCodecSupported(codec)) return;
+    m_videoCodec = codec;
+
+    if (m_settings) {
+        m_settings->setValue("codec", m_videoCodec);
+        m_settings->sync();
+    }
+
+    for (auto it = m_clientCodecs.constBegin(); it != m_clientCodecs.constEnd(); ++it)
+        negotiateCodec(it.key());
+
+    emit videoCodecChanged(m_videoCodec);
+}
+
+int ImageServerBridge::selectCodec(const QString& clientId) const
+{
+    if (m_clientCodecs.value(clientId).contains(m_videoCodec) && videoCodecSupported(m_videoCodec))
+        return m_videoCodec;
+    return static_cast<int>(VideoCodec::Mjpeg);
+}
+
+void ImageServerBridge::negotiateCodec(const QString& clientId)
+{
+    const int codec = selectCodec(clientId);
+    auto it = m_negotiatedCodecs.find(clientId);
+    if (it != m_negotiatedCodecs.end() && it.value() == codec)
+        return;
+
+    imagesocket::control::ControlMessage msg;
+    msg.set_type(imagesocket::control::SET_CODEC);
+    msg.set_codec(static_cast<imagesocket::control::VideoCodec>(codec));
+    if (!m_server->sendControlToClient(clientId, msg))
+        return;
+
+    m_negotiatedCodecs[clientId] = codec;
+    m_clientModel->setClientCodec(clientId, QString::fromLatin1(videoCodecName(static_cast<VideoCodec>(codec))));
+}
+
+void ImageServerBridge::onKeyframeNeeded(const QString& clientId)
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    auto it = m_keyframeRequestMs.find(clientId);
+    if (it != m_keyframeRequestMs.end() && now - it.value() < kKeyframeRequestIntervalMs)
+        return;
+    if (sendCommand(clientId, imagesocket::control::REQUEST_KEYFRAME))
+        m_keyframeRequestMs[clientId] = now;
+}
+
+void ImageServerBridge::applySubscription(const QString& clientId)
+{
+    if (clientId.isEmpty() || m_clientModel->indexOfClient(clientId) < 0)
+        return;
+
+    if (clientId == m_activeClientId) {
+        // Full (or display) resolution before frames flow again
+        m_downscaledClients.remove(clientId);
+        applyFrameBound(clientId);
+        if (m_pausedClients.remove(clientId))
+            sendCommand(clientId, imagesocket::control::RESUME);
+        updateDecodeInterest(clientId);
+        return;
+    }
+
+    if (m_mosaicMode || !m_displayEnabled || m_server->isWatched(clientId)) {
+        // Every wall tile (headless: every bus consumer, or viewer) gets the full stream at the configured rate
+        m_downscaledClients.remove(clientId);
+        applyFrameBound(clientId);
+        if (m_pausedClients.remove(clientId))
+            sendCommand(clientId, imagesocket::control::RESUME);
+        if (m_configuredFps > 0)
+            sendCommand(clientId, imagesocket::control::SET_FPS, applyFpsCeiling(clientId, m_configuredFps));
+        m_clientModel->setClientStatus(clientId, QStringLiteral("Connected"));
+        updateDecodeInterest(clientId);
+        return;
+    }
+
+    if (m_thumbnailMode) {
+        const int fps = m_inactiveClientFps > 0 ? m_inactiveClientFps : kThumbnailFps;
+        m_pausedClients.remove(clientId);
+        m_downscaledClients.insert(clientId);
+        applyFrameBound(clientId);
+        sendCommand(clientId, imagesocket::control::SUBSCRIBE, applyFpsCeiling(clientId, fps));
+        m_clientModel->setClientStatus(clientId, QStringLiteral("Preview"));
+        updateDecodeInterest(clientId);
+        return;
+    }
+
+    // Leaving thumbnail mode: previews go back to the full frame size
+    m_downscaledClients.remove(clientId);
+    applyFrameBound(clientId);
+    m_thumbnails.remove(clientId);
+    updateDecodeInterest(clientId);
+
+    if (m_inactiveClientFps > 0) {
+        // Preview subscription: the rate controller may lower it but never raise it
+        m_pausedClients.remove(clientId);
+        sendCommand(clientId, imagesocket::control::SUBSCRIBE, applyFpsCeiling(clientId, m_inactiveClientFps));
+        m_clientModel->setClientStatus(clientId, QStringLiteral("Preview"));
+    } else {
+        m_pausedClients.insert(clientId);
+        sendCommand(clientId, imagesocket::control::PAUSE);
+        m_clientModel->setClientStatus(clientId, QStringLiteral("Paused"));
+    }
+}
+
+void ImageServerBridge::onClientConnected(const QString& clientId, const QHostAddress& address)
+{
+    m_clientModel->addClient(clientId, QStringLiteral("Connected"));
+    m_streamCounters.insert(clientId, m_streamMetrics->addClient(clientId.toStdString()));
+    if (m_shards)
+        m_shards->setClient(clientId, QString(), address.toString());
+    sendPing(clientId); // first offset estimate before frames arrive
+
+    // Another stream of an open connection: named after it, HELLO and CONFIG were the connection's
+    const QString connection = WebSocketServer::connectionOf(clientId);
+    if (connection != clientId) {
+        const QString alias = m_clientModel->aliasAt(m_clientModel->indexOfClient(connection));
+        if (!alias.isEmpty())
+            applyClientAlias(clientId, alias + QLatin1Char('/') + QString::number(WebSocketServer::streamOf(clientId)));
+    }
+
+    // Clients start streaming on connect; stop this one if another is already shown
+    if (!m_activeClientId.isEmpty())
+        applySubscription(clientId);
+
+    // Update connection state
+    if (m_clientModel->rowCount() > 0) {
+        setConnectionState(ConnectionState::ClientsConnected);
+        setStatusMessage(QStringLiteral("Clients connected"));
+    }
+
+    // If there's no active client yet, make this client active
+    if (m_activeClientId.isEmpty()) {
+        setActiveClient(clientId);
+    }
+
+    // Prefer server-wide configured FPS if present; otherwise, reapply per-client configured FPS
+    int idx = m_clientModel->indexOfClient(clientId);
+    if (m_configuredFps > 0 && m_activeClientId == clientId) {
+        setFps(m_configuredFps);
+    } else if (idx >= 0) {
+        int configured = m_clientModel->configuredFpsAt(idx);
+        if (configured > 0 && m_activeClientId == clientId) {
+            setFps(configured);
+        }
+    }
+
+    // The newcomer's cost is unknown until its first window: it is limited from the next pass
+    rebalanceIngress();
+    if (m_mosaicMode)
+        refreshFrameBounds(); // one more tile: the others shrink
+    attachViewers();
+}
+
+void ImageServerBridge::onControlMessageReceived(const QString& clientId, const ControlMessagePtr& message)
+{
+    if (!message)
+        return;
+    const imagesocket::control::ControlMessage& msg = *message;
+
+    // If client replied with an alias message, store it in the model
+    if (msg.type() == imagesocket::control::ALIAS) {
+        if (!msg.alias().empty() && !m_helloClients.contains(clientId))
+            applyClientAlias(clientId, QString::fromStdString(msg.alias()));
+    } else if (msg.type() == imagesocket::control::HELLO) {
+        if (m_clientModel->indexOfClient(clientId) < 0)
+            return;
+        // Cluster mode: a new camera may be sent to a less loaded node instead of CONFIG
+        if (msg.accepts_redirect() && msg.role() == imagesocket::control::CAMERA
+            && redirectToPeer(clientId, QString::fromStdString(msg.session_token())))
+            return;
+        m_helloClients.insert(clientId);
+        QSet<int> codecs;
+        for (int i = 0; i < msg.codecs_size(); ++i)
+            codecs.insert(msg.codecs(i));
+        m_clientCodecs[clientId] = codecs;
+        if (msg.fps() > 0) {
+            // Never ask for more than the client can capture
+            m_clientMaxFps[clientId] = msg.fps();
+            const int ceiling = rateControllerFor(clientId).maxFps();
+            if (ceiling > msg.fps()) {
+                const int fps = applyFpsCeiling(clientId, m_requestedFps.value(clientId, ceiling));
+                if (clientId == m_activeClientId) {
+                    m_currentFps = fps;
+                    emit currentFpsChanged(m_currentFps);
+                }
+            }
+        }
+        qInfo() << "HELLO from" << clientId << "codecs" << codecs.size() << "max fps" << msg.fps()
+                << "max size" << msg.max_width() << "x" << msg.max_height() << "streams" << msg.stream_count()
+                << "simulcast layers" << msg.simulcast_layers();
+        const QString alias = QString::fromStdString(msg.alias());
+        const bool resumed = resumeSession(clientId, QString::fromStdString(msg.session_token()), alias);
+        sendConfig(clientId);
+        if (m_server->simulcastLayers(clientId) > 0)
+            applyFrameBound(clientId); // the layer shown follows the display from the start
+        // A resumed client never left as far as the UI is concerned: no connect event
+        if (!alias.isEmpty())
+            applyClientAlias(clientId, alias, !resumed);
+    } else if (msg.type() == imagesocket::control::STATS) {
+        rateControllerFor(clientId).onReport(QDateTime::currentMSecsSinceEpoch(),
+                                             msg.timestamp_ms(), msg.queued_frames());
+        if (StreamCounters* counters = streamCountersFor(clientId))
+            counters->recordClientQueue(msg.queued_frames(), static_cast<std::uint64_t>(qMax(0, msg.dropped_frames())));
+        m_clientModel->setClientQueueDepth(clientId, msg.queued_frames());
+    } else if (msg.type() == imagesocket::control::UNCHANGED) {
+        // A frame of a static scene the client left out: the stream is live and
+        // keeps its measured rate, the last frame stays what is shown
+        // Of a simulcast client only the layer on display counts, for the client's own row
+        if (m_server->simulcastLayers(clientId) > 0
+            && static_cast<int>(msg.stream_id()) != m_server->simulcastLayer(clientId))
+            return;
+        const QString streamClient = msg.stream_id() > 0 && m_server->simulcastLayers(clientId) == 0
+            ? WebSocketServer::streamClientId(clientId, static_cast<quint16>(msg.stream_id())) : clientId;
+        if (m_clientModel->indexOfClient(streamClient) < 0)
+            return;
+        m_clientModel->recordFrameReceived(streamClient);
+        if (StreamCounters* counters = streamCountersFor(streamClient))
+            counters->recordUnchanged();
+        if (m_idleFps > 0)
+            m_sceneActivity[streamClient].onUnchanged();
+    } else if (msg.type() == imagesocket::control::CODECS) {
+        if (m_helloClients.contains(clientId))
+            return; // negotiated by CONFIG already
+        QSet<int> codecs;
+        for (int i = 0; i < msg.codecs_size(); ++i)
+            codecs.insert(msg.codecs(i));
+        m_clientCodecs[clientId] = codecs;
+        negotiateCodec(clientId);
+    } else if (msg.type() == imagesocket::control::PONG) {
+        ClockOffsetEstimator& clock = m_clockOffsets[clientId];
+        if (!clock.addExchange(msg.echo_timestamp_us(), msg.receive_timestamp_us(), msg.timestamp_us(),
+                               EncodedFrame::nowUs()))
+            return;
+        rateControllerFor(clientId).onRoundTrip(QDateTime::currentMSecsSinceEpoch(), clock.lastRttUs() / 1000);
+        m_clientModel->setClientClock(clientId, qRound(usToMs(clock.lastRttUs()) * 10.0) / 10.0,
+                                      qRound(usToMs(clock.offsetUs()) * 10.0) / 10.0);
+    }
+}
+
+void ImageServerBridge::applyClientAlias(const QString& clientId, const QString& alias, bool announce)
+{
+    const QString lastAlias = m_clientModel->aliasAt(m_clientModel->indexOfClient(clientId));
+    if (alias != lastAlias) {
+        m_clientModel->setClientAlias(clientId, alias);
+        m_streamMetrics->setAlias(clientId.toStdString(), alias.toStdString());
+        if (m_shards)
+            m_shards->setAlias(clientId, alias);
+        qInfo() << "Set alias for" << clientId << "->" << alias;
+
+        if (clientId == m_activeClientId) {
+            emit activeClientAliasChanged(alias);
+        }
+        for (const QString& stream : m_server->substreams(clientId))
+            applyClientAlias(stream, alias + QLatin1Char('/') + QString::number(WebSocketServer::streamOf(stream)), false);
+    }
+    attachViewers(); // a viewer may be waiting for this alias
+    if (!announce)
+        return;
+
+    // Emit connection event once alias is available
+    QVariantMap details;
+    details["clientId"] = clientId;
+    details["alias"] = alias;
+    emit eventOccurred(imagesocket::ClientConnected, details);
+
+    // Also emit higher-level signal with alias for toast/UI
+    emit clientConnectedWithAlias(clientId, alias);
+}
+
+bool ImageServerBridge::sendConfig(const QString& clientId)
+{
+    // Restates what the connect-time SET_FPS / PAUSE / SUBSCRIBE / SET_RESOLUTION
+    // said, and adds the codec and frame header without another round trip
+    const RateController& controller = rateControllerFor(clientId);
+    const int codec = selectCodec(clientId);
+    const bool paused = m_pausedClients.contains(clientId);
+
+    imagesocket::control::ControlMessage config;
+    config.set_type(imagesocket::control::CONFIG);
+    config.set_fps(controller.maxFps());
+    if (m_adaptiveRate)
+        config.set_quality(controller.quality()); // otherwise the client keeps its own
+    config.set_codec(static_cast<imagesocket::control::VideoCodec>(codec));
+    config.set_paused(paused);
+    const FrameSize bound = frameBound(clientId);
+    if (bound.width > 0 || bound.height > 0) {
+        config.set_max_width(bound.width);
+        config.set_max_height(bound.height);
+    }
+    const FrameRegion region = m_clientRegions.value(clientId);
+    if (!region.isFull()) {
+        config.set_roi_x(static_cast<float>(region.x));
+        config.set_roi_y(static_cast<float>(region.y));
+        config.set_roi_width(static_cast<float>(region.width));
+        config.set_roi_height(static_cast<float>(region.height));
+    }
+    config.set_frame_header(true);
+    config.set_control_batch(true); // the client may batch its control too
+    config.set_session_token(m_sessionTokens.value(clientId).toStdString());
+
+    if (!m_server->sendControlToClient(clientId, config))
+        return false;
+
+    m_negotiatedCodecs[clientId] = codec;
+    m_clientModel->setClientCodec(clientId, QString::fromLatin1(videoCodecName(static_cast<VideoCodec>(codec))));
+    if (bound.width > 0 || bound.height > 0)
+        m_frameBounds[clientId] = bound;
+    else
+        m_frameBounds.remove(clientId);
+    return true;
+}
+
+bool ImageServerBridge::resumeSession(const QString& clientId, const QString& token, const QString& alias)
+{
+    // The parked session with this token; without one, the only parked session with this alias
+    QString key = m_parkedSessions.contains(token) ? token : QString();
+    if (key.isEmpty() && token.isEmpty() && !alias.isEmpty()) {
+        for (auto it = m_parkedSessions.constBegin(); it != m_parkedSessions.constEnd(); ++it) {
+            if (m_clientModel->aliasAt(m_clientModel->indexOfClient(it.value().clientId)) != alias)
+                continue;
+            if (!key.isEmpty()) {
+                key.clear(); // ambiguous: a fresh session
+                break;
+            }
+            key = it.key();
+        }
+    }
+    if (!key.isEmpty()) {
+        const ParkedSession parked = m_parkedSessions.take(key);
+        m_sessionTokens.insert(clientId, key);
+        takeOverSession(parked.clientId, clientId, parked.pinned);
+        qInfo() << "Session" << parked.clientId << "resumed as" << clientId;
+        return true;
+    }
+
+    // The token's session is still open (its connection died unnoticed): this one replaces it
+    const QString holder = token.isEmpty() ? QString() : m_sessionTokens.key(token);
+    if (!holder.isEmpty() && holder != clientId) {
+        m_sessionTokens.remove(holder);
+        m_sessionTokens.insert(clientId, token);
+        m_supersededSessions.insert(holder);
+        takeOverSession(holder, clientId, m_pinnedClients.contains(holder));
+        m_server->disconnectClient(holder, QStringLiteral("session resumed on a new connection"));
+        qInfo() << "Session" << holder << "replaced by" << clientId;
+        return true;
+    }
+
+    // New session: a client-chosen stable id, or one issued here
+    m_sessionTokens.insert(clientId, token.isEmpty() ? QUuid::createUuid().toString() : token);
+    return false;
+}
+
+void ImageServerBridge::takeOverSession(const QString& previousId, const QString& clientId, bool pinned)
+{
+    // The connect-time row of the new session gives way to the old one
+    m_clientModel->removeClient(clientId);
+    if (!m_clientModel->renameClient(previousId, clientId))
+        m_clientModel->addClient(clientId, QStringLiteral("Connected"));
+    m_pinnedClients.remove(previousId);
+    if (pinned)
+        m_pinnedClients.insert(clientId);
+    if (m_clientRegions.contains(previousId))
+        m_clientRegions.insert(clientId, m_clientRegions.take(previousId));
+
+    const int idx = m_clientModel->indexOfClient(clientId);
+    const int configured = m_configuredFps > 0 ? m_configuredFps : m_clientModel->configuredFpsAt(idx);
+    if (m_activeClientId == previousId) {
+        // Still shown (its last frame stayed up): streams again at once
+        m_activeClientId = clientId;
+        m_clientModel->setClientStatus(clientId, QStringLiteral("Active"));
+        applySubscription(clientId);
+        if (configured > 0)
+            setFps(configured);
+        emit activeClientChanged(clientId);
+    } else {
+        m_clientModel->setClientStatus(clientId, QStringLiteral("Connected"));
+        if (m_activeClientId.isEmpty())
+            setActiveClient(clientId);
+        else
+            applySubscription(clientId);
+    }
+    rebalanceIngress();
+}
+
+void ImageServerBridge::expireParkedSessions()
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QStringList expired;
+    for (auto it = m_parkedSessions.constBegin(); it != m_parkedSessions.constEnd(); ++it) {
+        if (it.value().expiresAtMs <= now)
+            expired.append(it.key());
+    }
+    for (const QString& token : qAsConst(expired)) {
+        const QString clientId = m_parkedSessions.take(token).clientId;
+        qInfo() << "Session" << clientId << "not resumed, removing it";
+        forgetClient(clientId);
+    }
+    if (m_parkedSessions.isEmpty())
+        m_parkTimer->stop();
+}
+
+void ImageServerBridge::onSessionDisconnected(const QString& clientId)
+{
+    // Its row went to the session that resumed it
+    if (m_supersededSessions.remove(clientId)) {
+        releaseSessionState(clientId);
+        rebalanceIngress();
+        return;
+    }
+
+    // A HELLO client with a token may come back: keep its row, active status
+    // and displayed frame for the grace period instead of announcing it gone
+    const QString token = m_sessionTokens.take(clientId);
+    if (!token.isEmpty() && m_serverState == Running && m_clientModel->indexOfClient(clientId) >= 0) {
+        ParkedSession parked;
+        parked.clientId = clientId;
+        parked.pinned = m_pinnedClients.contains(clientId);
+        parked.expiresAtMs = QDateTime::currentMSecsSinceEpoch() + kResumeGraceMs;
+        m_parkedSessions.insert(token, parked);
+        releaseSessionState(clientId);
+        m_clientModel->setClientStatus(clientId, QStringLiteral("Reconnecting"));
+        if (!m_parkTimer->isActive())
+            m_parkTimer->start();
+        qInfo() << "Session" << clientId << "parked for resumption";
+        rebalanceIngress();
+        return;
+    }
+
+    releaseSessionState(clientId);
+    forgetClient(clientId);
+}
+
+void ImageServerBridge::releaseSessionState(const QString& clientId)
+{
+    m_dropReports.remove(clientId);
+    m_rateControllers.remove(clientId);
+    m_requestedFps.remove(clientId);
+    m_grantedFps.remove(clientId);
+    m_sceneActivity.remove(clientId);
+    m_frameBounds.remove(clientId);
+    m_pinnedClients.remove(clientId);
+    m_pausedClients.remove(clientId);
+    m_downscaledClients.remove(clientId);
+    m_thumbnails.remove(clientId);
+    m_rawClients.remove(clientId);
+    m_clientCodecs.remove(clientId);
+    m_negotiatedCodecs.remove(clientId);
+    m_keyframeRequestMs.remove(clientId);
+    m_helloClients.remove(clientId);
+    m_clientMaxFps.remove(clientId);
+    m_latency.remove(clientId);
+    m_decodedTiming.remove(clientId);
+    m_clockOffsets.remove(clientId);
+    m_jitterBuffers.remove(clientId);
+    m_streamCounters.remove(clientId);
+    m_streamMetrics->removeClient(clientId.toStdString());
+    m_snapshots->remove(clientId);
+    if (m_shards)
+        m_shards->removeClient(clientId);
+    if (m_shownClientId == clientId)
+        m_shownClientId.clear();
+}
+
+void ImageServerBridge::forgetClient(const QString& clientId)
+{
+    // Obtain alias before removing
+    int idx = m_clientModel->indexOfClient(clientId);
+    QString alias;
+    if (idx >= 0) alias = m_clientModel->aliasAt(idx);
+
+    // Remove client from model
+    m_clientModel->removeClient(clientId);
+    m_clientRegions.remove(clientId);
+    m_server->setDecodeTarget(clientId, QSize());
+
+    // Its share of the budget goes to the others
+    rebalanceIngress();
+    if (m_mosaicMode)
+        refreshFrameBounds(); // the remaining tiles grow
+
+    // Emit disconnection event with alias if available
+    QVariantMap details;
+    details["clientId"] = clientId;
+    details["alias"] = alias.isEmpty() ? clientId : alias;
+    emit eventOccurred(imagesocket::ClientDisconnected, details);
+
+    // Also emit higher-level signal for UI/Toast
+    emit clientDisconnectedWithAlias(clientId, details["alias"].toString());
+
+    // If no clients left, clear active and notify UI
+    if (m_clientModel->rowCount() == 0) {
+        m_activeClientId.clear();
+        setConnectionState(ConnectionState::NoClients);
         setStatusMessage(QStringLiteral("No clients available"));
         emit eventOccurred(imagesocket::NoClientsAvailable, QVariantMap());
         emit connectionLost();
@@ -344,41 +1589,938 @@ void ImageServerBridge::onSessionDisconnected(const QString& clientId)
     }
 }
 
-void ImageServerBridge::onFrameReceived(const QString& clientId, const QImage& frame)
+void ImageServerBridge::onViewerSubscribed(const QString& viewerId, const QString& source)
+{
+    // Its connect-time row goes quietly: a viewer never was a client
+    if (m_clientModel->indexOfClient(viewerId) >= 0) {
+        releaseSessionState(viewerId);
+        m_clientModel->removeClient(viewerId);
+        if (m_activeClientId == viewerId) {
+            m_activeClientId.clear();
+            if (m_clientModel->rowCount() > 0)
+                setActiveClient(m_clientModel->clientIdAt(0));
+            else
+                emit activeClientChanged(QString());
+        }
+        if (m_clientModel->rowCount() == 0) {
+            setConnectionState(ConnectionState::NoClients);
+            setStatusMessage(QStringLiteral("No clients available"));
+        }
+        rebalanceIngress();
+    }
+
+    m_viewerSources.insert(viewerId, source);
+    if (!attachViewer(viewerId, source)) {
+        m_server->setRelaySource(viewerId, QString()); // waits for the new source, not on the old one
+        if (!source.isEmpty())
+            qInfo() << "Viewer" << viewerId << "waits for" << source;
+    }
+}
+
+void ImageServerBridge::onViewerDisconnected(const QString& viewerId)
+{
+    m_viewerSources.remove(viewerId);
+}
+
+void ImageServerBridge::attachViewers()
+{
+    for (auto it = m_viewerSources.constBegin(); it != m_viewerSources.constEnd(); ++it) {
+        if (m_server->relaySource(it.key()).isEmpty())
+            attachViewer(it.key(), it.value());
+    }
+}
+
+bool ImageServerBridge::attachViewer(const QString& viewerId, const QString& source)
 {
-    // Always record frame reception for measurement per-client
-    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (source.isEmpty())
+        return false;
+    // By id, else by alias; a parked row of the same alias is not connected and is skipped
+    QStringList candidates;
+    if (m_clientModel->indexOfClient(source) >= 0)
+        candidates.append(source);
+    for (int i = 0; i < m_clientModel->rowCount(); ++i) {
+        if (m_clientModel->aliasAt(i) == source)
+            candidates.append(m_clientModel->clientIdAt(i));
+    }
+    for (const QString& clientId : qAsConst(candidates)) {
+        if (!m_server->setRelaySource(viewerId, clientId))
+            continue;
+        // A video viewer starts at a keyframe: don't make it wait for the next GOP
+        // (tiled JPEG has none, it only sends every tile when asked)
+        if (usesVideoPackets(static_cast<VideoCodec>(m_negotiatedCodecs.value(clientId, 0))))
+            onKeyframeNeeded(clientId);
+        return true;
+    }
+    return false;
+}
+
+void ImageServerBridge::onEncodedFrameReceived(const QString& clientId, const EncodedFrame& frame)
+{
+    FrameTraceScope trace("bridge", "server", frame.timing().sequence);
+    // Always record frame reception for measurement per-client (no decode needed)
     if (m_clientModel) {
-        m_clientModel->recordFrameReceived(clientId, now);
+        m_clientModel->recordFrameReceived(clientId, 0, frame.size());
+    }
+    rateControllerFor(clientId).onFrame(frame.receivedAtMs, static_cast<std::size_t>(frame.size()));
+    if (m_idleFps > 0 && frame.format != EncodedFrame::RawYuv) {
+        // Sizes only: raw frames are all alike and say nothing about the scene
+        const bool video = frame.format == EncodedFrame::Video;
+        VideoPacketHeader packet;
+        const bool keyframe = video && parseVideoPacketHeader(reinterpret_cast<const std::uint8_t*>(frame.data()),
+                                                              static_cast<std::size_t>(frame.size()), packet)
+            && packet.keyframe;
+        m_sceneActivity[clientId].onFrame(static_cast<std::size_t>(frame.size()), video, keyframe);
+    }
+    if (StreamCounters* counters = streamCountersFor(clientId))
+        counters->recordFrame(static_cast<std::uint64_t>(frame.size()));
+
+    // Client-side stages, known from the frame header before anything is decoded.
+    // Capture times are on the client's clock, corrected by the PING/PONG offset
+    // (until the first PONG the network stage includes the clock difference).
+    const FrameTiming timing = toServerClock(clientId, frame.timing());
+    BusFrame published;
+    published.kind = BusFrame::Encoded;
+    published.clientId = clientId;
+    published.timing = timing;
+    published.encoded = frame;
+    m_frameBus->publish(std::move(published));
+    // Only while someone can ask for it over HTTP
+    if (m_browserViewer && m_browserViewer->isRunning())
+        m_snapshots->store(clientId, frame);
+    if (timing.hasCapture) {
+        LatencyBreakdown& latency = m_latency[clientId];
+        latency[LatencyStage::CaptureToSend].record(usToMs(timing.sendDelayUs));
+        latency[LatencyStage::Network].record(usToMs(timing.receivedAtUs - timing.captureTimeUs - timing.sendDelayUs));
+    }
+
+    if (!m_displayEnabled) {
+        // Nothing is shown: the state follows the received frames
+        setConnectionState(ConnectionState::ReceivingFrames);
+        setStatusMessage(QStringLiteral("Receiving frames"));
+        return;
+    }
+
+    // The active client's raw frames skip the decoder unless something else needs RGB pixels
+    const bool raw = frame.format == EncodedFrame::RawYuv;
+    if (raw != m_rawClients.contains(clientId)) {
+        if (raw)
+            m_rawClients.insert(clientId);
+        else
+            m_rawClients.remove(clientId);
+        updateDecodeInterest(clientId);
+    }
+    if (!raw || clientId != m_activeClientId || m_server->isDecodeEnabled(clientId))
+        return;
+
+    PacedFrame shown;
+    shown.raw = frame;
+    shown.raw.charge.reset(); // shown until the next one: counted with the decoded images
+    shown.timing = timing;
+    presentActiveFrame(clientId, std::move(shown));
+}
+
+int ImageServerBridge::budgetedFps(const QString& clientId, int fps) const
+{
+    fps = motionFps(clientId, fps);
+    if (fps <= 0 || !m_ingressBudget.enabled())
+        return fps;
+    const auto granted = m_grantedFps.constFind(clientId);
+    return granted != m_grantedFps.constEnd() ? qMin(fps, granted.value()) : fps;
+}
+
+int ImageServerBridge::applyFpsCeiling(const QString& clientId, int fps)
+{
+    const int captureLimit = m_clientMaxFps.value(clientId, 0);
+    if (captureLimit > 0 && fps > captureLimit)
+        fps = captureLimit;
+    m_requestedFps[clientId] = fps;
+    const int ceiling = budgetedFps(clientId, fps);
+    rateControllerFor(clientId).setMaxFps(ceiling);
+    return ceiling;
+}
+
+void ImageServerBridge::setIngressBudget(double mbitPerSecond, double decodeMsPerSecond)
+{
+    applyIngressBudget(mbitPerSecond, decodeMsPerSecond);
+
+    if (m_settings) {
+        m_settings->setValue("ingressMbps", qMax(0.0, mbitPerSecond));
+        m_settings->setValue("ingressDecodeMs", qMax(0.0, decodeMsPerSecond));
+        m_settings->sync();
+    }
+}
+
+void ImageServerBridge::applyIngressBudget(double mbitPerSecond, double decodeMsPerSecond)
+{
+    IngressBudgetConfig config = m_ingressBudget.config();
+    config.maxBitsPerSecond = qMax(0.0, mbitPerSecond) * 1e6;
+    config.maxDecodeMsPerSecond = qMax(0.0, decodeMsPerSecond);
+    m_ingressBudget.setConfig(config);
+
+    if (m_ingressBudget.enabled()) {
+        m_budgetTimer->start();
+        rebalanceIngress();
+        return;
+    }
+
+    // Budget lifted: every client back to its requested ceiling
+    m_budgetTimer->stop();
+    for (auto it = m_grantedFps.constBegin(); it != m_grantedFps.constEnd(); ++it) {
+        const QString& clientId = it.key();
+        RateController& controller = rateControllerFor(clientId);
+        controller.setQualityCeiling(0);
+        const int requested = motionFps(clientId, m_requestedFps.value(clientId, 0));
+        if (requested <= 0 || m_pausedClients.contains(clientId) || controller.maxFps() == requested)
+            continue;
+        controller.setMaxFps(requested);
+        if (sendCommand(clientId, imagesocket::control::SET_FPS, requested) && clientId == m_activeClientId) {
+            m_currentFps = requested;
+            emit currentFpsChanged(m_currentFps);
+        }
+    }
+    m_grantedFps.clear();
+}
+
+QVariantMap ImageServerBridge::ingressBudget() const
+{
+    const IngressBudgetConfig& config = m_ingressBudget.config();
+    QVariantMap budget;
+    budget["mbitPerSecond"] = config.maxBitsPerSecond / 1e6;
+    budget["decodeMsPerSecond"] = config.maxDecodeMsPerSecond;
+    QVariantMap granted;
+    for (auto it = m_grantedFps.constBegin(); it != m_grantedFps.constEnd(); ++it) {
+        const int idx = m_clientModel->indexOfClient(it.key());
+        granted[idx >= 0 ? m_clientModel->aliasAt(idx) : it.key()] = it.value();
+    }
+    budget["grantedFps"] = granted;
+    return budget;
+}
+
+void ImageServerBridge::setAdmissionLimits(int maxSessions, double maxMessageMb, double clientMaxMbps)
+{
+    applyAdmissionLimits(maxSessions, maxMessageMb, clientMaxMbps);
+
+    if (m_settings) {
+        const WebSocketServer::AdmissionLimits limits = m_server->admissionLimits();
+        m_settings->setValue("maxSessions", limits.maxSessions);
+        m_settings->setValue("maxMessageMb", static_cast<double>(limits.maxMessageBytes) / (1024 * 1024));
+        m_settings->setValue("clientMaxMbps", qMax(0.0, clientMaxMbps));
+        m_settings->sync();
+    }
+}
+
+void ImageServerBridge::applyAdmissionLimits(int maxSessions, double maxMessageMb, double clientMaxMbps)
+{
+    WebSocketServer::AdmissionLimits limits = m_server->admissionLimits();
+    limits.maxSessions = qMax(0, maxSessions);
+    if (maxMessageMb > 0.0) {
+        limits.maxMessageBytes = static_cast<qint64>(maxMessageMb * 1024 * 1024);
+        limits.maxFrameBytes = limits.maxMessageBytes;
+    }
+    limits.ingress.maxBytesPerSecond = static_cast<std::int64_t>(qMax(0.0, clientMaxMbps) * 1e6 / 8.0);
+    m_server->setAdmissionLimits(limits);
+}
+
+void ImageServerBridge::setAcceptRate(double perSecond, int burst)
+{
+    applyAcceptRate(perSecond, burst);
+
+    if (m_settings) {
+        m_settings->setValue("acceptRate", qMax(0.0, perSecond));
+        m_settings->setValue("acceptBurst", qMax(0, burst));
+        m_settings->sync();
+    }
+}
+
+void ImageServerBridge::applyAcceptRate(double perSecond, int burst)
+{
+    WebSocketServer::AdmissionLimits limits = m_server->admissionLimits();
+    limits.acceptRate = qMax(0.0, perSecond);
+    limits.acceptBurst = qMax(0, burst);
+    m_server->setAdmissionLimits(limits);
+}
+
+QVariantMap ImageServerBridge::admissionLimits() const
+{
+    const WebSocketServer::AdmissionLimits limits = m_server->admissionLimits();
+    QVariantMap result;
+    result["maxSessions"] = limits.maxSessions;
+    result["maxMessageMb"] = static_cast<double>(limits.maxMessageBytes) / (1024 * 1024);
+    result["clientMaxMbps"] = static_cast<double>(limits.ingress.maxBytesPerSecond) * 8.0 / 1e6;
+    result["acceptRate"] = limits.acceptRate;
+    result["acceptBurst"] = limits.acceptBurst;
+    result["sessions"] = m_server->sessionCount();
+    return result;
+}
+
+void ImageServerBridge::setMemoryBudget(double totalMb, double perClientMb)
+{
+    applyMemoryBudget(totalMb, perClientMb);
+
+    if (m_settings) {
+        m_settings->setValue("memoryMb", qMax(0.0, totalMb));
+        m_settings->setValue("clientMemoryMb", qMax(0.0, perClientMb));
+        m_settings->sync();
+    }
+}
+
+void ImageServerBridge::applyMemoryBudget(double totalMb, double perClientMb)
+{
+    const std::shared_ptr<MemoryBudget> budget = m_server->memoryBudget();
+    MemoryBudgetConfig config = budget->config();
+    config.totalBytes = static_cast<std::int64_t>(qMax(0.0, totalMb) * 1024 * 1024);
+    config.perClientBytes = static_cast<std::int64_t>(qMax(0.0, perClientMb) * 1024 * 1024);
+    budget->setConfig(config);
+
+    // Only the total depends on what the bridge holds
+    if (config.totalBytes > 0) {
+        m_memoryTimer->start();
+        evaluateMemory();
+    } else {
+        m_memoryTimer->stop();
+        budget->setExternalBytes(0);
+        m_memoryPressure = false;
+    }
+}
+
+QVariantMap ImageServerBridge::memoryUsage() const
+{
+    const std::shared_ptr<MemoryBudget> budget = m_server->memoryBudget();
+    const MemoryBudgetConfig config = budget->config();
+    const MemoryUsage usage = budget->usage();
+    QVariantMap result;
+    result["totalMb"] = toMb(config.totalBytes);
+    result["perClientMb"] = toMb(config.perClientBytes);
+    result["receivedMb"] = toMb(usage.receivedBytes);
+    result["decodedMb"] = toMb(usage.externalBytes);
+    result["refused"] = static_cast<qulonglong>(usage.refused);
+    result["underPressure"] = usage.underPressure;
+    QVariantList clients;
+    for (const MemoryUsage::Account& account : usage.accounts) {
+        const QString clientId = QString::fromStdString(account.name);
+        const int idx = m_clientModel->indexOfClient(clientId);
+        QVariantMap entry;
+        entry["client"] = idx >= 0 ? m_clientModel->aliasAt(idx) : clientId;
+        entry["mb"] = toMb(account.bytes);
+        entry["refused"] = static_cast<qulonglong>(account.refused);
+        clients.append(entry);
+    }
+    result["clients"] = clients;
+    return result;
+}
+
+void ImageServerBridge::evaluateMemory()
+{
+    const std::shared_ptr<MemoryBudget> budget = m_server->memoryBudget();
+    qint64 held = imageBytes(m_lastFrame) + imageBytes(m_lastRawImage) + m_lastRawFrame.buffer.size()
+        + m_snapshots->bytes() + static_cast<qint64>(ImagePool::shared().idleBytes());
+    for (const QImage& thumbnail : qAsConst(m_thumbnails))
+        held += imageBytes(thumbnail);
+    budget->setExternalBytes(held);
+
+    const bool pressure = budget->underPressure();
+    if (pressure != m_memoryPressure) {
+        m_memoryPressure = pressure;
+        const MemoryUsage usage = budget->usage();
+        if (pressure)
+            qWarning() << "Memory budget under pressure:" << toMb(usage.receivedBytes) << "MB received in flight,"
+                       << toMb(usage.externalBytes) << "MB decoded and cached; evicting caches";
+        else
+            qInfo() << "Memory budget pressure over";
+    }
+    if (!pressure)
+        return;
+
+    // Everything here is rebuilt from the next frames: thumbnails at the
+    // thumbnail rate (the grid keeps showing what it loaded), snapshots from
+    // the next JPEG, the raw frame's RGB copy on request. The active client's
+    // frame stays on screen.
+    m_thumbnails.clear();
+    m_snapshots->clear();
+    m_lastRawImage = QImage();
+    ImagePool::shared().trim();
+    budget->setExternalBytes(imageBytes(m_lastFrame) + m_lastRawFrame.buffer.size());
+}
+
+void ImageServerBridge::onClientThrottled(const QString& clientId, int fps)
+{
+    // The server already sent SET_FPS; keep the rate controller from recovering past it
+    RateController& controller = rateControllerFor(clientId);
+    if (controller.maxFps() <= 0 || fps < controller.maxFps())
+        controller.setMaxFps(fps);
+    if (clientId == m_activeClientId) {
+        m_currentFps = fps;
+        emit currentFpsChanged(m_currentFps);
+    }
+
+    const int idx = m_clientModel->indexOfClient(clientId);
+    QVariantMap details;
+    details["clientId"] = clientId;
+    details["alias"] = idx >= 0 ? m_clientModel->aliasAt(idx) : clientId;
+    details["fps"] = fps;
+    emit eventOccurred(imagesocket::ClientThrottled, details);
+}
+
+void ImageServerBridge::setClientPinned(const QString& clientId, bool pinned)
+{
+    if (m_pinnedClients.contains(clientId) == pinned || m_clientModel->indexOfClient(clientId) < 0)
+        return;
+    if (pinned)
+        m_pinnedClients.insert(clientId);
+    else
+        m_pinnedClients.remove(clientId);
+    rebalanceIngress();
+}
+
+bool ImageServerBridge::clientPinned(const QString& clientId) const
+{
+    return m_pinnedClients.contains(clientId);
+}
+
+void ImageServerBridge::rebalanceIngress()
+{
+    if (!m_ingressBudget.enabled())
+        return;
+
+    std::vector<IngressDemand> demands;
+    for (int i = 0; i < m_clientModel->rowCount(); ++i) {
+        const QString clientId = m_clientModel->clientIdAt(i);
+        const int requested = m_requestedFps.value(clientId, 0);
+        if (requested <= 0 || m_pausedClients.contains(clientId))
+            continue;
+        IngressDemand demand;
+        demand.clientId = clientId.toStdString();
+        if (clientId == m_activeClientId)
+            demand.priority = IngressPriority::Active;
+        else if (m_pinnedClients.contains(clientId))
+            demand.priority = IngressPriority::Pinned;
+        demand.maxFps = motionFps(clientId, requested);
+        demand.bytesPerFrame = m_clientModel->avgFrameBytesAt(i);
+        demand.decodeMsPerFrame = m_clientModel->decodeMsAt(i);
+        demand.quality = rateControllerFor(clientId).quality();
+        demands.push_back(demand);
+    }
+
+    // Only what changed goes out: the rate controller keeps adapting below each grant
+    for (const IngressGrant& grant : m_ingressBudget.allocate(demands)) {
+        const QString clientId = QString::fromStdString(grant.clientId);
+        m_grantedFps[clientId] = grant.fps;
+        RateController& controller = rateControllerFor(clientId);
+        if (controller.maxFps() != grant.fps) {
+            controller.setMaxFps(grant.fps);
+            if (sendCommand(clientId, imagesocket::control::SET_FPS, grant.fps) && clientId == m_activeClientId) {
+                m_currentFps = grant.fps;
+                emit currentFpsChanged(m_currentFps);
+            }
+        }
+        const int quality = controller.quality();
+        controller.setQualityCeiling(grant.maxQuality);
+        if (controller.quality() != quality)
+            sendCommand(clientId, imagesocket::control::SET_QUALITY, controller.quality());
+    }
+}
+
+void ImageServerBridge::setMotionAdaptiveFps(int idleFps)
+{
+    idleFps = qMax(0, idleFps);
+    if (idleFps == m_idleFps)
+        return;
+    applyMotionAdaptiveFps(idleFps);
+
+    if (m_settings) {
+        m_settings->setValue("motionIdleFps", idleFps);
+        m_settings->sync();
+    }
+}
+
+void ImageServerBridge::applyMotionAdaptiveFps(int idleFps)
+{
+    idleFps = qMax(0, idleFps);
+    if (idleFps == m_idleFps)
+        return;
+
+    // Idle clients move to the new rate, or back to their ceiling when it is off
+    QStringList idleClients;
+    for (auto it = m_sceneActivity.constBegin(); it != m_sceneActivity.constEnd(); ++it) {
+        if (it.value().idle())
+            idleClients.append(it.key());
+    }
+    m_idleFps = idleFps;
+    if (m_idleFps > 0) {
+        m_activityTimer->start();
+    } else {
+        m_activityTimer->stop();
+        m_sceneActivity.clear();
+    }
+    if (idleClients.isEmpty())
+        return;
+    rebalanceIngress();
+    for (const QString& clientId : idleClients)
+        reapplyFpsCeiling(clientId);
+}
+
+QVariantMap ImageServerBridge::motionAdaptiveFps() const
+{
+    QVariantMap result;
+    result["idleFps"] = m_idleFps;
+    QStringList idle;
+    for (auto it = m_sceneActivity.constBegin(); it != m_sceneActivity.constEnd(); ++it) {
+        if (!it.value().idle())
+            continue;
+        const int idx = m_clientModel->indexOfClient(it.key());
+        idle.append(idx >= 0 ? m_clientModel->aliasAt(idx) : it.key());
+    }
+    result["idleClients"] = idle;
+    return result;
+}
+
+void ImageServerBridge::evaluateSceneActivity()
+{
+    QStringList changed;
+    for (auto it = m_sceneActivity.begin(); it != m_sceneActivity.end(); ++it) {
+        if (!m_pausedClients.contains(it.key()) && it.value().evaluate())
+            changed.append(it.key());
+    }
+    if (changed.isEmpty())
+        return;
+    // Idle clients ask the budget for the idle rate only, leaving the rest to the others
+    rebalanceIngress();
+    for (const QString& clientId : changed)
+        reapplyFpsCeiling(clientId);
+}
+
+int ImageServerBridge::motionFps(const QString& clientId, int fps) const
+{
+    if (m_idleFps <= 0)
+        return fps;
+    const auto scene = m_sceneActivity.constFind(clientId);
+    if (scene == m_sceneActivity.constEnd() || !scene.value().idle())
+        return fps;
+    return fps > 0 ? qMin(fps, m_idleFps) : m_idleFps;
+}
+
+void ImageServerBridge::reapplyFpsCeiling(const QString& clientId)
+{
+    if (m_pausedClients.contains(clientId))
+        return; // RESUME / SUBSCRIBE applies it
+    const int fps = budgetedFps(clientId, m_requestedFps.value(clientId, 0));
+    RateController& controller = rateControllerFor(clientId);
+    if (controller.maxFps() == fps)
+        return; // already sent by rebalanceIngress()
+    controller.setMaxFps(fps);
+    // 0 (no fps configured) hands the client back its own rate
+    if (sendCommand(clientId, imagesocket::control::SET_FPS, fps) && clientId == m_activeClientId) {
+        m_currentFps = fps;
+        emit currentFpsChanged(m_currentFps);
+    }
+}
+
+RateController& ImageServerBridge::rateControllerFor(const QString& clientId)
+{
+    auto it = m_rateControllers.find(clientId);
+    if (it == m_rateControllers.end()) {
+        it = m_rateControllers.insert(clientId, RateController());
+        int idx = m_clientModel ? m_clientModel->indexOfClient(clientId) : -1;
+        it.value().setMaxFps(idx >= 0 ? m_clientModel->configuredFpsAt(idx) : 0);
     }
+    return it.value();
+}
+
+bool ImageServerBridge::sendResolution(const QString& clientId, int maxWidth, int maxHeight)
+{
+    imagesocket::control::ControlMessage msg;
+    msg.set_type(imagesocket::control::SET_RESOLUTION);
+    msg.set_max_width(maxWidth);
+    msg.set_max_height(maxHeight);
+    return m_server->sendControlToClient(clientId, msg);
+}
+
+bool ImageServerBridge::sendRegion(const QString& clientId, const FrameRegion& region)
+{
+    imagesocket::control::ControlMessage msg;
+    msg.set_type(imagesocket::control::SET_ROI);
+    if (!region.isFull()) {
+        msg.set_roi_x(static_cast<float>(region.x));
+        msg.set_roi_y(static_cast<float>(region.y));
+        msg.set_roi_width(static_cast<float>(region.width));
+        msg.set_roi_height(static_cast<float>(region.height));
+    }
+    return m_server->sendControlToClient(clientId, msg);
+}
+
+FrameSize ImageServerBridge::frameBound(const QString& clientId) const
+{
+    FrameSize bound;
+    // Simulcast clients send every size at once: the server picks a layer instead
+    if (m_server->simulcastLayers(clientId) > 0)
+        return bound;
+    if (m_downscaledClients.contains(clientId)) {
+        bound.width = kThumbnailWidth;
+        bound.height = kThumbnailHeight;
+        return bound;
+    }
+    if (!m_resolutionFollowsDisplay || !m_displayEnabled || m_viewport.width <= 0 || m_viewport.height <= 0)
+        return bound;
+    // Frames that also go elsewhere keep every pixel
+    if (m_server->isWatched(clientId) || m_frameBus->hasSubscriber(BusFrame::Encoded | BusFrame::Decoded, clientId))
+        return bound;
+    if (m_mosaicMode) {
+        // Same grid as the MosaicView (default spacing left out: a few pixels more)
+        const int count = qMax(1, m_clientModel->rowCount());
+        const int columns = mosaicColumns(count, m_viewport.width, m_viewport.height);
+        const MosaicRect cell = mosaicCell(0, count, columns, m_viewport.width, m_viewport.height);
+        return displayFrameBound(static_cast<int>(cell.width), static_cast<int>(cell.height));
+    }
+    if (clientId != m_activeClientId)
+        return bound;
+    return displayFrameBound(m_viewport.width, m_viewport.height);
+}
+
+QSize ImageServerBridge::decodeTarget(const QString& clientId) const
+{
+    // Headless, or frames that go to a processor: every pixel
+    if (!m_displayEnabled || m_frameBus->hasSubscriber(BusFrame::Decoded, clientId))
+        return QSize();
+    if (m_downscaledClients.contains(clientId))
+        return QSize(kThumbnailWidth, kThumbnailHeight);
+    if (m_viewport.width <= 0 || m_viewport.height <= 0)
+        return QSize();
+    if (m_mosaicMode) {
+        const int count = qMax(1, m_clientModel->rowCount());
+        const int columns = mosaicColumns(count, m_viewport.width, m_viewport.height);
+        const MosaicRect cell = mosaicCell(0, count, columns, m_viewport.width, m_viewport.height);
+        return QSize(qCeil(cell.width), qCeil(cell.height));
+    }
+    if (clientId != m_activeClientId)
+        return QSize();
+    return QSize(m_viewport.width, m_viewport.height).expandedTo(m_requestedFrameSize);
+}
+
+void ImageServerBridge::applyFrameBound(const QString& clientId)
+{
+    m_server->setDecodeTarget(clientId, decodeTarget(clientId));
+    if (m_server->simulcastLayers(clientId) > 0) {
+        // Recordings and processors take the full layer
+        const bool full = m_frameBus->hasSubscriber(BusFrame::Encoded | BusFrame::Decoded, clientId);
+        m_server->setSimulcastTarget(clientId, full ? QSize() : decodeTarget(clientId));
+    }
+
+    const FrameSize bound = frameBound(clientId);
+    const FrameSize sent = m_frameBounds.value(clientId);
+    if (bound.width == sent.width && bound.height == sent.height)
+        return;
+    if (!sendResolution(clientId, bound.width, bound.height))
+        return;
+    if (bound.width > 0 || bound.height > 0)
+        m_frameBounds[clientId] = bound;
+    else
+        m_frameBounds.remove(clientId);
+}
+
+void ImageServerBridge::refreshFrameBounds()
+{
+    for (int i = 0; i < m_clientModel->rowCount(); ++i)
+        applyFrameBound(m_clientModel->clientIdAt(i));
+}
+
+bool ImageServerBridge::sendCommand(const QString& clientId, int type, int value)
+{
+    imagesocket::control::ControlMessage msg;
+    msg.set_type(static_cast<imagesocket::control::CommandType>(type));
+    if (type == imagesocket::control::SET_QUALITY)
+        msg.set_quality(value);
+    else if (value > 0)
+        msg.set_fps(value);
+    return m_server->sendControlToClient(clientId, msg);
+}
+
+void ImageServerBridge::evaluateRateControl()
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (auto it = m_rateControllers.begin(); it != m_rateControllers.end(); ++it) {
+        const QString& clientId = it.key();
+        if (m_pausedClients.contains(clientId))
+            continue; // nothing to measure, nothing to adjust
+        RateController& controller = it.value();
+        const RateDecision decision = controller.evaluate(now);
+
+        // Adjustments don't touch the configured FPS: that stays the ceiling to recover to
+        if (decision.qualityChanged)
+            sendCommand(clientId, imagesocket::control::SET_QUALITY, decision.quality);
+        if (decision.fpsChanged && sendCommand(clientId, imagesocket::control::SET_FPS, decision.fps)
+            && clientId == m_activeClientId) {
+            m_currentFps = decision.fps;
+            emit currentFpsChanged(m_currentFps);
+        }
+
+        m_clientModel->setClientRateStats(clientId, controller.quality(),
+                                          static_cast<int>(controller.throughputBps() * 8.0 / 1000.0),
+                                          controller.queueDelayMs());
+    }
+}
+
+bool ImageServerBridge::needsPixels(const QString& clientId) const
+{
+    if (clientId.isEmpty())
+        return false;
+    if (!m_displayEnabled)
+        return m_mosaicMode || m_frameBus->hasSubscriber(BusFrame::Decoded, clientId);
+    return (clientId == m_activeClientId && !m_rawClients.contains(clientId)) || m_mosaicMode
+        || (m_thumbnailMode && m_downscaledClients.contains(clientId));
+}
+
+DecodePriority ImageServerBridge::decodePriority(const QString& clientId) const
+{
+    if (m_displayEnabled && clientId == m_activeClientId)
+        return DecodePriority::Active;
+    // Wall tiles and thumbnails on screen, and frames a processor waits for
+    if ((m_displayEnabled && (m_mosaicMode || m_downscaledClients.contains(clientId)))
+        || m_frameBus->hasSubscriber(BusFrame::Decoded, clientId))
+        return DecodePriority::Preview;
+    return DecodePriority::Background;
+}
+
+void ImageServerBridge::updateDecodeInterest(const QString& clientId)
+{
+    if (!m_server || clientId.isEmpty())
+        return;
+    m_server->setDecodePriority(clientId, decodePriority(clientId));
+    m_server->setDecodeEnabled(clientId, needsPixels(clientId));
+}
+
+void ImageServerBridge::onFrameTimed(const QString& clientId, const FrameTiming& timing)
+{
+    m_latency[clientId][LatencyStage::Decode].record(usToMs(timing.decodedAtUs - timing.receivedAtUs));
+    if (StreamCounters* counters = streamCountersFor(clientId))
+        counters->recordDecode(timing.decodedAtUs - timing.receivedAtUs);
+    m_clientModel->recordFrameDecoded(clientId, timing.decodedAtUs - timing.receivedAtUs);
+    m_decodedTiming[clientId] = toServerClock(clientId, timing);
+}
+
+FrameTiming ImageServerBridge::toServerClock(const QString& clientId, const FrameTiming& timing) const
+{
+    FrameTiming corrected = timing;
+    // Every stream of a connection shares its clock
+    const auto it = m_clockOffsets.constFind(WebSocketServer::connectionOf(clientId));
+    if (corrected.hasCapture && it != m_clockOffsets.constEnd())
+        corrected.captureTimeUs = it.value().toServerTime(corrected.captureTimeUs);
+    return corrected;
+}
+
+bool ImageServerBridge::sendPing(const QString& clientId)
+{
+    if (WebSocketServer::streamOf(clientId) != 0)
+        return false; // measured on the connection's main stream
+    imagesocket::control::ControlMessage msg;
+    msg.set_type(imagesocket::control::PING);
+    msg.set_timestamp_us(EncodedFrame::nowUs());
+    return m_server->sendControlToClient(clientId, msg);
+}
+
+void ImageServerBridge::sendPings()
+{
+    for (int i = 0; i < m_clientModel->rowCount(); ++i)
+        sendPing(m_clientModel->clientIdAt(i));
+}
+
+void ImageServerBridge::setShownTiming(const QString& clientId, const FrameTiming& timing)
+{
+    // A frame replaced before the scene graph picked it up was never on screen
+    m_shownClientId = clientId;
+    m_shownTiming = timing;
+}
+
+void ImageServerBridge::recordFramePresented(qint64 presentedAtUs)
+{
+    if (m_shownClientId.isEmpty())
+        return;
+    LatencyBreakdown& latency = m_latency[m_shownClientId];
+    const qint64 readyAtUs = m_shownTiming.decodedAtUs > 0 ? m_shownTiming.decodedAtUs : m_shownTiming.receivedAtUs;
+    latency[LatencyStage::Display].record(usToMs(presentedAtUs - readyAtUs));
+    if (m_shownTiming.hasCapture)
+        latency[LatencyStage::EndToEnd].record(usToMs(presentedAtUs - m_shownTiming.captureTimeUs));
+    m_shownClientId.clear();
+}
+
+void ImageServerBridge::publishLatency()
+{
+    const bool decay = ++m_latencyTicks % kLatencyDecayTicks == 0;
+    for (auto it = m_latency.begin(); it != m_latency.end(); ++it) {
+        const QVariantMap map = latencyMap(it.value());
+        m_clientModel->setClientLatency(it.key(), map);
+        m_streamMetrics->setLatency(it.key().toStdString(), latencyQuantiles(it.value()));
+        if (it.key() == m_activeClientId && map != m_activeClientLatency) {
+            m_activeClientLatency = map;
+            emit activeClientLatencyChanged();
+        }
+        if (decay)
+            it.value().decay();
+    }
+}
+
+QVariantMap ImageServerBridge::activeClientLatency() const
+{
+    return m_activeClientLatency;
+}
+
+void ImageServerBridge::onFrameReceived(const QString& clientId, const QImage& frame)
+{
+    emit clientFrameReady(clientId, frame);
+    const FrameTiming timing = m_decodedTiming.take(clientId);
+    FrameTraceScope trace("bridge decoded", "server", timing.sequence);
+
+    BusFrame published;
+    published.kind = BusFrame::Decoded;
+    published.clientId = clientId;
+    published.timing = timing;
+    published.image = frame;
+    m_frameBus->publish(std::move(published));
+    if (!m_displayEnabled)
+        return; // decoded for the bus only
 
     // If the client is the active one, update receiving state and cache frame for display
     if (clientId != m_activeClientId){
-        return; // ignore frames from non-active clients for display
+        // Non-active clients only feed the preview grid
+        if (m_thumbnailMode && m_downscaledClients.contains(clientId)) {
+            // Bound memory even if a client ignores SET_RESOLUTION
+            m_thumbnails[clientId] = (frame.width() > kThumbnailWidth || frame.height() > kThumbnailHeight)
+                ? frame.scaled(kThumbnailWidth, kThumbnailHeight, Qt::KeepAspectRatio, Qt::FastTransformation)
+                : frame;
+            m_clientModel->recordThumbnail(clientId);
+        }
+        return;
+    }
+
+    PacedFrame shown;
+    shown.image = frame;
+    shown.timing = timing;
+    presentActiveFrame(clientId, std::move(shown));
+}
+
+void ImageServerBridge::presentActiveFrame(const QString& clientId, PacedFrame frame)
+{
+    // Frames without a capture time can't be paced
+    if (m_jitterMode == JitterMode::Off || !frame.timing.hasCapture) {
+        displayFrame(clientId, frame);
+        return;
     }
+    auto buffer = m_jitterBuffers.find(clientId);
+    if (buffer == m_jitterBuffers.end())
+        buffer = m_jitterBuffers.insert(clientId, JitterBuffer<PacedFrame>(m_jitterMode));
+    const qint64 captureUs = frame.timing.captureTimeUs;
+    if (!buffer->push(std::move(frame), captureUs, EncodedFrame::nowUs()))
+        return; // older than the frame on screen
+    emit pacedFramePending();
+    schedulePacing();
+}
+
+void ImageServerBridge::displayFrame(const QString& clientId, const PacedFrame& frame)
+{
+    // Cache last frame for the image provider
+    m_lastFrame = frame.image;
+    m_lastRawFrame = frame.raw;
+    m_lastRawImage = QImage();
+    setShownTiming(clientId, frame.timing);
+    showActiveFrame(clientId);
 
+    // Notify QML/UI listeners
+    if (frame.raw.isEmpty())
+        emit newFrameReady(frame.image);
+    else
+        emit newRawFrameReady(frame.raw);
+}
+
+bool ImageServerBridge::presentPacedFrame(qint64 displayAtUs)
+{
+    m_lastRefreshUs = EncodedFrame::nowUs();
+    m_pacingTimer->stop();
+    return showPacedFrame(displayAtUs);
+}
+
+bool ImageServerBridge::showPacedFrame(qint64 displayAtUs)
+{
+    const auto buffer = m_jitterBuffers.find(m_activeClientId);
+    if (buffer == m_jitterBuffers.end())
+        return false;
+    PacedFrame frame;
+    const bool due = buffer->take(displayAtUs, frame);
+    const bool held = !buffer->empty();
+    if (due)
+        displayFrame(m_activeClientId, frame);
+    return held;
+}
+
+void ImageServerBridge::schedulePacing()
+{
+    const qint64 nowUs = EncodedFrame::nowUs();
+    if (nowUs - m_lastRefreshUs < kPacingRefreshTimeoutUs)
+        return; // the VideoSurface's refreshes release them
+    const auto buffer = m_jitterBuffers.constFind(m_activeClientId);
+    if (buffer == m_jitterBuffers.constEnd() || buffer->empty()) {
+        m_pacingTimer->stop();
+        return;
+    }
+    // Rounded up: woken early, the frame would not be due yet
+    const qint64 waitUs = qBound<qint64>(0, buffer->nextDueUs() - nowUs, kPacingRefreshTimeoutUs);
+    m_pacingTimer->start(static_cast<int>((waitUs + 999) / 1000));
+}
+
+void ImageServerBridge::showActiveFrame(const QString& clientId)
+{
     // Update connection state to receiving frames
     setConnectionState(ConnectionState::ReceivingFrames);
     setStatusMessage(QStringLiteral("Receiving frames"));
 
-    // Cache last frame for the image provider
-    m_lastFrame = frame;
     m_frameId++;
-    emit frameIdChanged(m_frameId);
+    if (!m_frameNotifyTimer->isActive())
+        notifyFrameId(); // first frame after a pause goes out at once
 
     // Update active client measured FPS from the model
     int idx = m_clientModel ? m_clientModel->indexOfClient(clientId) : -1;
     if (idx >= 0) {
-        int measured = m_clientModel->measuredFpsAt(idx);
+        const double measured = m_clientModel->measuredFpsAt(idx);
         if (measured != m_activeClientMeasuredFps) {
             m_activeClientMeasuredFps = measured;
             emit activeClientMeasuredFpsChanged(m_activeClientMeasuredFps);
         }
     }
+}
 
-    // Notify QML/UI listeners
-    emit newFrameReady(frame);
-} 
+void ImageServerBridge::notifyFrameId()
+{
+    if (m_notifiedFrameId == m_frameId)
+        return;
+    m_notifiedFrameId = m_frameId;
+    emit frameIdChanged(m_frameId);
+    m_frameNotifyTimer->start(); // later frames in the interval are folded into one
+}
+
+void ImageServerBridge::onFramesDropped(const QString& clientId, int count)
+{
+    if (m_clientModel) {
+        m_clientModel->recordFramesDropped(clientId, count);
+    }
+    if (StreamCounters* counters = streamCountersFor(clientId))
+        counters->recordDropped(static_cast<std::uint64_t>(qMax(0, count)));
+
+    DropReport& report = m_dropReports[clientId];
+    report.pending += count;
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (report.lastReportMs != 0 && now - report.lastReportMs < m_dropReportIntervalMs)
+        return;
+
+    QVariantMap details;
+    details["clientId"] = clientId;
+    int idx = m_clientModel ? m_clientModel->indexOfClient(clientId) : -1;
+    details["alias"] = idx >= 0 ? m_clientModel->aliasAt(idx) : clientId;
+    details["dropped"] = report.pending;
+    details["totalDropped"] = idx >= 0 ? m_clientModel->droppedFramesAt(idx) : report.pending;
+    emit eventOccurred(imagesocket::FrameDropped, details);
+
+    report.lastReportMs = now;
+    report.pending = 0;
+}
 
 void ImageServerBridge::onServerError(imagesocket::EventCode code, const QVariantMap &details)
 {
@@ -387,19 +2529,18 @@ void ImageServerBridge::onServerError(imagesocket::EventCode code, const QVarian
     emit eventOccurred(code, details);
 }
 
-int ImageServerBridge::activeClientMeasuredFps() const
+double ImageServerBridge::activeClientMeasuredFps() const
 {
     return m_activeClientMeasuredFps;
 }
 
 void ImageServerBridge::recordFrameReceived(const QString& clientId)
 {
-    qint64 now = QDateTime::currentMSecsSinceEpoch();
     if (m_clientModel) {
-        m_clientModel->recordFrameReceived(clientId, now);
+        m_clientModel->recordFrameReceived(clientId);
         int idx = m_clientModel->indexOfClient(clientId);
         if (idx >= 0) {
-            int measured = m_clientModel->measuredFpsAt(idx);
+            const double measured = m_clientModel->measuredFpsAt(idx);
             if (measured != m_activeClientMeasuredFps && clientId == m_activeClientId) {
                 m_activeClientMeasuredFps = measured;
                 emit activeClientMeasuredFpsChanged(m_activeClientMeasuredFps);
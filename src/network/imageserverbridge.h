@@ -6,23 +6,61 @@
 #include <QByteArray>
 #include <QVariantMap>
 #include <QImage>
+#include <QHash>
+#include <QSet>
+#include <memory>
 
+#include "controlmessage.h"
+#include "decodescheduler.h"
 #include "eventcodes.h"
+#include "encodedframe.h"
+#include "ratecontroller.h"
+#include "ingressbudget.h"
+#include "sceneactivity.h"
+#include "framesize.h"
+#include "latencyhistogram.h"
+#include "clockoffset.h"
+#include "processcpu.h"
+#include "jitterbuffer.h"
 
 class WebSocketServer;
 class ClientModel;
 class QSettings;
+class ShardDirectory;
+class ClusterNode;
+class ClusterModel;
+class FrameBus;
+class ProcessingStage;
+class FrameRecorder;
+class PrerollBuffer;
+class MetricsServer;
+class BrowserViewer;
+class SnapshotCache;
+class StreamMetrics;
+struct StreamCounters;
+class QTimer;
 
 class ImageServerBridge : public QObject
 {
     Q_OBJECT
     Q_PROPERTY(QObject* clientModel READ clientModel CONSTANT)
+    Q_PROPERTY(QObject* clusterModel READ clusterModel CONSTANT)
     Q_PROPERTY(int frameId READ frameId NOTIFY frameIdChanged)
     Q_PROPERTY(QString activeClient READ activeClient NOTIFY activeClientChanged)
     Q_PROPERTY(QString activeClientAlias READ activeClientAlias NOTIFY activeClientAliasChanged)
     Q_PROPERTY(int currentFps READ currentFps NOTIFY currentFpsChanged)
-    Q_PROPERTY(int activeClientMeasuredFps READ activeClientMeasuredFps NOTIFY activeClientMeasuredFpsChanged)
+    Q_PROPERTY(double activeClientMeasuredFps READ activeClientMeasuredFps NOTIFY activeClientMeasuredFpsChanged)
     Q_PROPERTY(int configuredFps READ configuredFps WRITE setConfiguredFps NOTIFY configuredFpsChanged)
+    Q_PROPERTY(bool adaptiveRate READ adaptiveRate WRITE setAdaptiveRate NOTIFY adaptiveRateChanged)
+    Q_PROPERTY(int inactiveClientFps READ inactiveClientFps WRITE setInactiveClientFps NOTIFY inactiveClientFpsChanged)
+    Q_PROPERTY(bool thumbnailMode READ thumbnailMode WRITE setThumbnailMode NOTIFY thumbnailModeChanged)
+    Q_PROPERTY(bool mosaicMode READ mosaicMode WRITE setMosaicMode NOTIFY mosaicModeChanged)
+    Q_PROPERTY(int videoCodec READ videoCodec WRITE setVideoCodec NOTIFY videoCodecChanged)
+    Q_PROPERTY(bool resolutionFollowsDisplay READ resolutionFollowsDisplay WRITE setResolutionFollowsDisplay NOTIFY resolutionFollowsDisplayChanged)
+    // Display pacing of the active client: 0 off, 1 low latency, 2 smooth (JitterMode)
+    Q_PROPERTY(int jitterMode READ jitterMode WRITE setJitterMode NOTIFY jitterModeChanged)
+    // Active client's latency per stage, same map as ClientModel's "latency" role
+    Q_PROPERTY(QVariantMap activeClientLatency READ activeClientLatency NOTIFY activeClientLatencyChanged)
     Q_PROPERTY(ServerState serverState READ serverState NOTIFY serverStateChanged)
     Q_PROPERTY(ConnectionState connectionState READ connectionState NOTIFY connectionStateChanged)
     Q_PROPERTY(QString statusMessage READ statusMessage NOTIFY statusMessageChanged)
@@ -47,10 +85,61 @@ public:
     explicit ImageServerBridge(QObject* parent = nullptr);
     ~ImageServerBridge() override;
     
-    int activeClientMeasuredFps() const;
+    double activeClientMeasuredFps() const;
     int configuredFps() const;
+    bool adaptiveRate() const;
+    int inactiveClientFps() const;
+    bool thumbnailMode() const;
+    bool mosaicMode() const;
+    int videoCodec() const;
+    bool resolutionFollowsDisplay() const;
+    int jitterMode() const;
+    QVariantMap activeClientLatency() const;
+    bool displayEnabled() const;
 
     QObject* clientModel() const;
+    // Cameras of every cluster node, this one's included (ClusterModel); empty outside cluster mode
+    QObject* clusterModel() const;
+    // Every received (Encoded) and decoded (Decoded) frame of every client
+    FrameBus* frameBus() const;
+    // Frame processors (analytics) fed from the bus on their own threads
+    ProcessingStage* processingStage() const;
+    // Per-processor throughput, skips and latency (ProcessingStage::statsList())
+    Q_INVOKABLE QVariantList processorStats() const;
+    // Records every client's received stream under `directory` (FrameRecorder)
+    FrameRecorder* recorder() const;
+    Q_INVOKABLE bool startRecording(const QString& directory);
+    Q_INVOKABLE void stopRecording();
+    Q_INVOKABLE QVariantMap recordingStats() const;
+    // Event clips (PrerollBuffer): keep each client's last `seconds` of
+    // received frames in memory, in a fixed slab of `mbPerClient` MB;
+    // seconds 0 turns it off and frees the slabs
+    PrerollBuffer* preroll() const;
+    Q_INVOKABLE bool setPreroll(int seconds, double mbPerClient);
+    // Writes the client's pre-roll (the last `seconds`, 0: all of it) as a
+    // recorder segment under `directory`; returns its path, empty if none.
+    // Callable from processor threads.
+    Q_INVOKABLE QString captureEventClip(const QString& clientId, const QString& directory, int seconds = 0);
+    // running, windowMs, bytesPerClient, clients, frames, bytes, evicted
+    Q_INVOKABLE QVariantMap prerollStats() const;
+    // Active client's display pacing: mode, targetDelayMs, held, shown, skipped, late
+    Q_INVOKABLE QVariantMap jitterStats() const;
+    // Whole-server load figures for capacity runs: clients, summed fps and
+    // drops, network/decode latency over every client, process CPU (percent
+    // of one core since the previous call)
+    Q_INVOKABLE QVariantMap serverStats();
+    // Per-client frames, bytes, drops, decode times, client queues and latency
+    // percentiles, counted with atomics on the receive path
+    StreamMetrics* streamMetrics() const;
+    // Prometheus endpoint (GET /metrics) on its own thread; port 0 picks a free one
+    Q_INVOKABLE bool startMetrics(quint16 port);
+    Q_INVOKABLE void stopMetrics();
+    Q_INVOKABLE quint16 metricsPort() const;
+    // Browser monitoring (GET / page, MJPEG /stream per client) on its own
+    // thread; JPEG frames pass through as received. Port 0 picks a free one.
+    Q_INVOKABLE bool startBrowserViewer(quint16 port);
+    Q_INVOKABLE void stopBrowserViewer();
+    Q_INVOKABLE quint16 browserViewerPort() const;
     QString activeClient() const;
     QString activeClientAlias() const;
 
@@ -64,24 +153,146 @@ public:
     Q_INVOKABLE void setFps(int fps);
     Q_INVOKABLE quint16 serverPort() const;
     Q_INVOKABLE void setPort(quint16 port);
+    // Share the port with other server instances (SO_REUSEPORT) and publish
+    // this instance's clients to the shard directory; next start()
+    Q_INVOKABLE void setReusePort(bool enabled);
+    Q_INVOKABLE bool reusePort() const;
+    // Let clients on lossy links send their frames over UDP with FEC; next start()
+    Q_INVOKABLE void setUdpFrames(bool enabled);
+    Q_INVOKABLE bool udpFrames() const;
+    // Serve WSS with this PEM certificate chain and key (empty: plain WebSocket);
+    // with the Beast backend the kernel encrypts where it can (kTLS). Next start().
+    Q_INVOKABLE void setTls(const QString& certFile, const QString& keyFile);
+    Q_INVOKABLE bool tlsEnabled() const;
+    // Ping quiet clients every `intervalMs` and drop those that leave
+    // `maxMissed` pings in a row unanswered (0 ms: off); new connections
+    Q_INVOKABLE void setKeepalive(int intervalMs, int maxMissed);
+    // Which instance on this port holds a client (by id or alias): pid, clientId,
+    // alias, address and local (this process); empty when no instance has it
+    Q_INVOKABLE QVariantMap locateClient(const QString& clientIdOrAlias) const;
+    // Cluster mode: report this node's load to `peers` ("host:port" of their
+    // cluster ports) over UDP every second and send each connecting camera
+    // that accepts it to the least-loaded node (REDIRECT in answer to HELLO).
+    // `advertiseHost` is where clients reach this node (empty: the address
+    // peers see the reports come from); only nodes with the same `clusterKey`
+    // take each other's reports. Port 0 picks a free one.
+    Q_INVOKABLE bool startCluster(const QString& nodeId, quint16 port, const QStringList& peers,
+                                  const QString& advertiseHost = QString(), quint32 clusterKey = 0);
+    Q_INVOKABLE void stopCluster();
+    Q_INVOKABLE quint16 clusterPort() const;
+    // Live peers: nodeId, host, port, sessions, utilization (0-1) and acceptsClients
+    Q_INVOKABLE QVariantList clusterNodes() const;
     Q_INVOKABLE void recordFrameReceived(const QString& clientId);
     Q_INVOKABLE void setConfiguredFps(int fps);
+    // Let the server adjust each client's JPEG quality / FPS to the measured uplink
+    Q_INVOKABLE void setAdaptiveRate(bool enabled);
+    // Rate for clients that are not active: 0 pauses them, >0 keeps a low-rate preview subscription
+    Q_INVOKABLE void setInactiveClientFps(int fps);
+    // Server-wide ingress budget (0 disables a limit): received Mbit/s and decode
+    // ms per second, split over the streaming clients by priority (IngressBudget)
+    Q_INVOKABLE void setIngressBudget(double mbitPerSecond, double decodeMsPerSecond);
+    // mbitPerSecond, decodeMsPerSecond and the granted fps per client alias
+    Q_INVOKABLE QVariantMap ingressBudget() const;
+    // Motion-adaptive frame rate (0 disables): a client whose scene stays still
+    // (SceneActivity: frame sizes, UNCHANGED heartbeats) is lowered to
+    // `idleFps` with SET_FPS and gets its ceiling back as soon as it moves
+    Q_INVOKABLE void setMotionAdaptiveFps(int idleFps);
+    // idleFps and the aliases of the clients currently idle
+    Q_INVOKABLE QVariantMap motionAdaptiveFps() const;
+    // Pinned clients rank between the active client and the others in the budget
+    Q_INVOKABLE void setClientPinned(const QString& clientId, bool pinned);
+    Q_INVOKABLE bool clientPinned(const QString& clientId) const;
+    // Admission control (0 disables a limit): concurrent sessions, largest
+    // message in MB, and a per-client Mbit/s cap enforced with SET_FPS and,
+    // when a client keeps exceeding it, a disconnect
+    Q_INVOKABLE void setAdmissionLimits(int maxSessions, double maxMessageMb, double clientMaxMbps);
+    // Reconnect-storm pacing: at most `perSecond` new connections per second
+    // (`burst` at once, 0: one second's worth); the others are sent
+    // RETRY_AFTER with a slot of their own. 0 turns it off.
+    Q_INVOKABLE void setAcceptRate(double perSecond, int burst = 0);
+    // maxSessions, maxMessageMb, clientMaxMbps, acceptRate, acceptBurst and the current session count
+    Q_INVOKABLE QVariantMap admissionLimits() const;
+    // Memory budget in MB (0 disables a limit): everything held for the
+    // clients (received frames in flight, decoded images, thumbnails,
+    // snapshots), and received frames one connection may have in flight.
+    // Frames over it are dropped on arrival; near it thumbnails, snapshots and
+    // idle image buffers are evicted (MemoryBudget)
+    Q_INVOKABLE void setMemoryBudget(double totalMb, double perClientMb);
+    // totalMb, perClientMb, receivedMb, decodedMb, refused, underPressure and
+    // the MB in flight per client alias, largest holders first
+    Q_INVOKABLE QVariantMap memoryUsage() const;
+    // Dual-rate mode: non-active clients send small, low-fps thumbnails for the preview grid
+    Q_INVOKABLE void setThumbnailMode(bool enabled);
+    // Video wall: every client streams at full rate and is decoded for the MosaicView
+    Q_INVOKABLE void setMosaicMode(bool enabled);
+    // Preferred stream codec (VideoCodec: 0 MJPEG, 1 H.264, 2 H.265), used with
+    // clients that can encode it; the others stay on MJPEG
+    Q_INVOKABLE void setVideoCodec(int codec);
+    Q_INVOKABLE bool videoCodecSupported(int codec) const;
+    // Display-sized streams: displayed clients are bounded (SET_RESOLUTION) to
+    // the pixels they take on screen, the video surface's size or one wall
+    // tile. Clients whose frames also go elsewhere (recording, viewers,
+    // processors) keep full resolution.
+    Q_INVOKABLE void setResolutionFollowsDisplay(bool enabled);
+    // Size of the video surface in device pixels, from QML
+    Q_INVOKABLE void setDisplayViewport(int width, int height);
+    // Region of interest of a client in fractions (0-1) of its frame (SET_ROI);
+    // width or height 0 is the whole frame again
+    Q_INVOKABLE void setClientRegion(const QString& clientId, qreal x, qreal y, qreal width, qreal height);
+    // x, y, width and height of the client's region (0, 0, 1, 1 without one)
+    Q_INVOKABLE QVariantMap clientRegion(const QString& clientId) const;
+    // Headless servers (false): no view shows frames. Every client streams at
+    // the configured rate and frames are decoded only for Decoded subscribers
+    // of the frame bus (processors) or in mosaic mode; nothing is cached for display
+    Q_INVOKABLE void setDisplayEnabled(bool enabled);
+    // Hold the active client's frames in a jitter buffer and show them at the
+    // pace they were captured (JitterBuffer), instead of as soon as decoded.
+    // Off shows the newest held frame at once.
+    Q_INVOKABLE void setJitterMode(int mode);
+
+    // Called by the VideoSurface when the last shown frame reached the scene graph
+    // (wall clock, microseconds): closes its display and end-to-end latency samples
+    void recordFramePresented(qint64 presentedAtUs);
+    // Called by the VideoSurface once per display refresh while frames are
+    // paced: shows the active client's frame due at the refresh at
+    // `displayAtUs` (wall clock, microseconds). True while frames are held.
+    bool presentPacedFrame(qint64 displayAtUs);
 
     // Helper to emit events to QML along with optional details
     void emitEvent(imagesocket::EventCode code, const QVariantMap &details = QVariantMap());
 
     QImage lastFrame() const;
+    // Size the image provider was asked for (QML sourceSize); the active
+    // client's frames are decoded at least this large. Thread-safe.
+    void noteRequestedFrameSize(const QSize& size);
+    // Latest thumbnail of a non-active client (null when none)
+    QImage thumbnail(const QString& clientId) const;
     int frameId() const;
     int currentFps() const;
 
 signals:
     void currentFpsChanged(int fps);
     void configuredFpsChanged(int fps);
+    void adaptiveRateChanged(bool enabled);
+    void inactiveClientFpsChanged(int fps);
+    void thumbnailModeChanged(bool enabled);
+    void mosaicModeChanged(bool enabled);
+    void videoCodecChanged(int codec);
+    void resolutionFollowsDisplayChanged(bool enabled);
+    void jitterModeChanged(int mode);
+    void clientRegionChanged(const QString& clientId);
+    void activeClientLatencyChanged();
 
 signals:
     void activeClientChanged(const QString& clientId);
     void activeClientAliasChanged(const QString& alias);
     void newFrameReady(const QImage& frame);
+    // Raw YUV frame of the active client, not converted on the CPU (VideoSurface draws the planes)
+    void newRawFrameReady(const EncodedFrame& frame);
+    // A frame of the active client is held for pacing: keep the display refreshing
+    void pacedFramePending();
+    // Every decoded frame, from any client (MosaicView input)
+    void clientFrameReady(const QString& clientId, const QImage& frame);
     void frameIdChanged(int newId);
     void connectionLost();
 
@@ -100,26 +311,152 @@ signals:
 
 private slots:
     void onClientConnected(const QString& clientId, const QHostAddress& address);
-    void onControlMessageReceived(const QString& clientId, const QByteArray& serialized);
+    void onControlMessageReceived(const QString& clientId, const ControlMessagePtr& message);
     void onSessionDisconnected(const QString& clientId);
+    void onEncodedFrameReceived(const QString& clientId, const EncodedFrame& frame);
     void onFrameReceived(const QString& clientId, const QImage& frame);
+    void onFramesDropped(const QString& clientId, int count);
+    void onKeyframeNeeded(const QString& clientId);
+    void onFrameTimed(const QString& clientId, const FrameTiming& timing);
+    void onClientThrottled(const QString& clientId, int fps);
+    // Viewer sessions: the source each asked for, held until it connects
+    void onViewerSubscribed(const QString& viewerId, const QString& source);
+    void onViewerDisconnected(const QString& viewerId);
 
     // Handle server errors from WebSocketServer and forward to UI
     void onServerError(imagesocket::EventCode code, const QVariantMap &details);
 
+    // Periodic rate control pass over all clients
+    void evaluateRateControl();
+    // Split the ingress budget again and send the changed SET_FPS / SET_QUALITY
+    void rebalanceIngress();
+    // Close each client's activity interval and move the ones that turned idle or active
+    void evaluateSceneActivity();
+    // Report the decoded and cached bytes to the memory budget; evict under pressure
+    void evaluateMemory();
+
+    // Publish the latency percentiles to the model and fade the histograms
+    void publishLatency();
+    // Clock probe to every client (answered with PONG)
+    void sendPings();
+    // Throttled frameIdChanged: at most one per kFrameNotifyIntervalMs
+    void notifyFrameId();
+    // Headless: decode a client only while a bus subscriber wants its pixels
+    void onBusSubscribersChanged();
+    // Parked sessions whose grace period ran out are removed for good
+    void expireParkedSessions();
+
 private:
     // State helpers
     void setServerState(ServerState state);
     void setConnectionState(ConnectionState state);
     void setStatusMessage(const QString& msg);
 
+    // Enable decoding for a client only while some consumer needs its pixels,
+    // at the priority of the most urgent one
+    void updateDecodeInterest(const QString& clientId);
+    bool needsPixels(const QString& clientId) const;
+    DecodePriority decodePriority(const QString& clientId) const;
+
+    // Resume the active client; pause (or subscribe at the preview rate) the others
+    void applySubscription(const QString& clientId);
+
+    // Bookkeeping for a new frame of the active client (state, frame id, measured FPS)
+    void showActiveFrame(const QString& clientId);
+
+    // Rate control helpers
+    RateController& rateControllerFor(const QString& clientId);
+    // A client's fps ceiling: remembers `fps` as requested, sets the rate
+    // controller to it within the budget's grant (and the idle rate of a
+    // still scene) and returns what to send
+    int applyFpsCeiling(const QString& clientId, int fps);
+    int budgetedFps(const QString& clientId, int fps) const;
+    // `fps` lowered to the idle rate while the client's scene is still (0: unset, idle rate)
+    int motionFps(const QString& clientId, int fps) const;
+    // Send a client its ceiling again after the idle state or the budget moved it
+    void reapplyFpsCeiling(const QString& clientId);
+
+    // Stored settings are applied at startup through these, without writing
+    // them back; the public setters persist what the user changes
+    bool applyPreroll(int seconds, double mbPerClient);
+    void applyIngressBudget(double mbitPerSecond, double decodeMsPerSecond);
+    void applyMotionAdaptiveFps(int idleFps);
+    void applyAdmissionLimits(int maxSessions, double maxMessageMb, double clientMaxMbps);
+    void applyAcceptRate(double perSecond, int burst);
+    void applyMemoryBudget(double totalMb, double perClientMb);
+    bool sendCommand(const QString& clientId, int type, int value = 0);
+    bool sendResolution(const QString& clientId, int maxWidth, int maxHeight);
+    bool sendRegion(const QString& clientId, const FrameRegion& region);
+    // The frame size bound a client should have now: thumbnail, display-sized or none (0 x 0)
+    FrameSize frameBound(const QString& clientId) const;
+    // Area the client's decoded frames are shown in (empty: full size wanted)
+    QSize decodeTarget(const QString& clientId) const;
+    // Send SET_RESOLUTION when the bound differs from the one the client has,
+    // and hand the decoder the client's decode target
+    void applyFrameBound(const QString& clientId);
+    void refreshFrameBounds();
+
+    // Pick the stream codec for a client from its CODECS list and the preference
+    int selectCodec(const QString& clientId) const;
+    void negotiateCodec(const QString& clientId);
+    // Alias from ALIAS or HELLO: model, metrics, shard directory and (announce) the connect event
+    void applyClientAlias(const QString& clientId, const QString& alias, bool announce = true);
+    // Answer to HELLO: the client's whole current configuration in one CONFIG
+    bool sendConfig(const QString& clientId);
+    // Cluster mode, on HELLO of a camera that accepts REDIRECT: send it to a
+    // less loaded node and close the connection; false when it stays
+    bool redirectToPeer(const QString& clientId, const QString& token);
+    // This node's load, limits and clients for its peers
+    imagesocket::control::NodeReport buildNodeReport();
+
+    // Session resumption on HELLO: true when the client took over a parked (or
+    // still open) session with its token, or by its alias when it has none.
+    // Either way the client ends up with a token to send back next time.
+    bool resumeSession(const QString& clientId, const QString& token, const QString& alias);
+    // Move the previous session's row, configured fps, pin and active status to clientId
+    void takeOverSession(const QString& previousId, const QString& clientId, bool pinned);
+    // Per-connection state of a session that ended; the model row is left alone
+    void releaseSessionState(const QString& clientId);
+    // Remove a client's row and announce it gone (active client promotion included)
+    void forgetClient(const QString& clientId);
+    // Point every viewer without a source at the client it asked for, if connected now
+    void attachViewers();
+    // Relay `source` (client id or alias) to a viewer; false while no such client is connected
+    bool attachViewer(const QString& viewerId, const QString& source);
+
+    // Mark a frame of the active client as shown, awaiting recordFramePresented()
+    void setShownTiming(const QString& clientId, const FrameTiming& timing);
+    // A decoded or raw frame of the active client: shown now, or held for pacing
+    struct PacedFrame {
+        QImage image;
+        EncodedFrame raw; // or the raw frame (only one of the two is set)
+        FrameTiming timing;
+    };
+    void presentActiveFrame(const QString& clientId, PacedFrame frame);
+    void displayFrame(const QString& clientId, const PacedFrame& frame);
+    // Shows the active client's frame due at `displayAtUs`; true while frames are held
+    bool showPacedFrame(qint64 displayAtUs);
+    // Without display refreshes lately, a timer releases the held frames
+    void schedulePacing();
+    bool sendPing(const QString& clientId);
+    // Capture time moved to the server's clock once the client's offset is known
+    FrameTiming toServerClock(const QString& clientId, const FrameTiming& timing) const;
+    // Null before the client connected or after it left
+    StreamCounters* streamCountersFor(const QString& clientId) const;
+
     WebSocketServer* m_server = nullptr;
     ClientModel* m_clientModel = nullptr;
+    FrameBus* m_frameBus = nullptr;
+    ProcessingStage* m_processing = nullptr;
+    FrameRecorder* m_recorder = nullptr;
+    PrerollBuffer* m_preroll = nullptr;
     QString m_activeClientId;
 
     // Cache of last frame for the QML image provider
     QImage m_lastFrame;
     int m_frameId = 0;
+    int m_notifiedFrameId = 0;
+    QTimer* m_frameNotifyTimer = nullptr;
     int m_port = 0;
 
     // New state members
@@ -137,10 +474,132 @@ private:
     QSettings* m_settings = nullptr;
 
     // Measured FPS for the active client
-    int m_activeClientMeasuredFps = 0;
+    double m_activeClientMeasuredFps = 0.0;
+
+    // FrameDropped events are rate-limited per client to avoid flooding the UI
+    struct DropReport { qint64 lastReportMs = 0; int pending = 0; };
+    QHash<QString, DropReport> m_dropReports;
+    int m_dropReportIntervalMs = 5000;
+
+    // Closed-loop quality/FPS control per client, fed by frame arrivals and STATS reports
+    QHash<QString, RateController> m_rateControllers;
+    QTimer* m_rateTimer = nullptr;
+    bool m_adaptiveRate = true;
+
+    // Ingress budget: each client's requested ceiling and the budget's grant
+    IngressBudget m_ingressBudget;
+    QTimer* m_budgetTimer = nullptr;
+
+    // Memory budget (the server's): images and caches measured once per interval
+    QTimer* m_memoryTimer = nullptr;
+    bool m_memoryPressure = false;
+    QSet<QString> m_pinnedClients;
+    QHash<QString, int> m_requestedFps;
+    QHash<QString, int> m_grantedFps;
+
+    // Motion-adaptive frame rate: each client's scene activity and the idle rate (0 == off)
+    QHash<QString, SceneActivity> m_sceneActivity;
+    int m_idleFps = 0;
+    QTimer* m_activityTimer = nullptr;
+
+    // Clients told to stop streaming, and the rate for non-active clients (0 == paused)
+    QSet<QString> m_pausedClients;
+    int m_inactiveClientFps = 0;
+
+    // Thumbnail substream: clients told to downscale, and their latest frame
+    bool m_thumbnailMode = false;
+    QSet<QString> m_downscaledClients;
+    QHash<QString, QImage> m_thumbnails;
+
+    bool m_mosaicMode = false;
+    bool m_displayEnabled = true;
+
+    // Display-sized streams: the video surface in device pixels, the bound
+    // each client was last sent (absent == full resolution) and the regions
+    // of interest (kept while a session is parked)
+    bool m_resolutionFollowsDisplay = false;
+    FrameSize m_viewport;
+    QHash<QString, FrameSize> m_frameBounds;
+    QHash<QString, FrameRegion> m_clientRegions;
+    QSize m_requestedFrameSize; // largest valid requestedSize seen by the image provider
+
+    // Clients sending raw YUV: the active one is drawn from its planes without decoding,
+    // and its latest frame is only converted when the image provider asks for it
+    // (once: reloads of the same frame get the same image)
+    QSet<QString> m_rawClients;
+    EncodedFrame m_lastRawFrame;
+    mutable QImage m_lastRawImage;
+
+    // Inter-frame codec negotiation: preference, what each client can encode,
+    // what it was told to use, and when it was last asked for a keyframe
+    int m_videoCodec = 0;
+    QHash<QString, QSet<int>> m_clientCodecs;
+    QHash<QString, int> m_negotiatedCodecs;
+    QHash<QString, qint64> m_keyframeRequestMs;
+    // Clients that opened with HELLO (their ALIAS / CODECS repeat it) and the
+    // frame rate each said it can capture at most
+    QSet<QString> m_helloClients;
+    QHash<QString, int> m_clientMaxFps;
+
+    // Session resumption: each HELLO client's token (sent in CONFIG), the
+    // sessions that dropped off and may come back with theirs (token -> parked),
+    // and open sessions a reconnect has already taken over
+    struct ParkedSession {
+        QString clientId; // the row stays in the model under this id
+        bool pinned = false;
+        qint64 expiresAtMs = 0;
+    };
+    QHash<QString, QString> m_sessionTokens;
+    QHash<QString, ParkedSession> m_parkedSessions;
+    QSet<QString> m_supersededSessions;
+    QTimer* m_parkTimer = nullptr;
+
+    // Latency histograms per client; the decode timing of each client's latest
+    // frame until it is shown, and the shown frame until it is presented
+    QHash<QString, LatencyBreakdown> m_latency;
+    QHash<QString, FrameTiming> m_decodedTiming;
+    QString m_shownClientId;
+    FrameTiming m_shownTiming;
+    QVariantMap m_activeClientLatency;
+
+    // Display pacing: each client's buffer keeps its delay statistics while
+    // another client is shown (held frames are dropped). Frames are released
+    // at the VideoSurface's refreshes, or by the timer when none came lately.
+    JitterMode m_jitterMode = JitterMode::Off;
+    QHash<QString, JitterBuffer<PacedFrame>> m_jitterBuffers;
+    QTimer* m_pacingTimer = nullptr;
+    qint64 m_lastRefreshUs = 0;
+    QTimer* m_latencyTimer = nullptr;
+    int m_latencyTicks = 0;
+    ProcessCpuMeter m_cpu;
+
+    // Scrape-side registry and each client's counters (looked up once per frame)
+    std::shared_ptr<StreamMetrics> m_streamMetrics;
+    QHash<QString, std::shared_ptr<StreamCounters>> m_streamCounters;
+    MetricsServer* m_metricsServer = nullptr;
+    BrowserViewer* m_browserViewer = nullptr;
+    // Each client's latest JPEG for the viewer's /snapshot route
+    std::shared_ptr<SnapshotCache> m_snapshots;
+
+    // PING/PONG clock offset and round trip per client
+    QHash<QString, ClockOffsetEstimator> m_clockOffsets;
+    QTimer* m_pingTimer = nullptr;
+
+    // Viewer sessions and the client id or alias each asked to watch (empty: none)
+    QHash<QString, QString> m_viewerSources;
+
+    // Clients of every instance sharing the port; only while started with reuse-port
+    std::unique_ptr<ShardDirectory> m_shards;
+
+    // Cluster mode: load reports and placement (only while started), the
+    // address clients are sent to for this node, and every node's cameras
+    ClusterNode* m_cluster = nullptr;
+    QString m_clusterHost;
+    ClusterModel* m_clusterModel = nullptr;
+    ProcessCpuMeter m_clusterCpu; // sampled per report, apart from serverStats()
 
 signals:
-    void activeClientMeasuredFpsChanged(int fps);
+    void activeClientMeasuredFpsChanged(double fps);
 };
 
 #endif // IMAGESERVERBRIDGE_H
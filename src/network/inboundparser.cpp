@@ -0,0 +1,115 @@
+#include "inboundparser.h"
+#include <QDebug>
+#include "videopacket.h"
+
+InboundParser::InboundParser(const QString& clientId)
+    : m_clientId(clientId)
+{
+}
+
+void InboundParser::setMemoryAccount(const std::shared_ptr<MemoryBudget::Account>& account)
+{
+    m_memory = account;
+    m_awaitingKeyframe.clear();
+}
+
+InboundParser::Result InboundParser::parse(const QByteArray& message, EncodedFrame& frame, ControlMessages& control,
+                                           qint64 decodedBytes)
+{
+    if (message.isEmpty()) {
+        qWarning() << "Received empty message from client" << m_clientId;
+        return Invalid;
+    }
+
+    const unsigned char prefix = static_cast<unsigned char>(message.at(0));
+    if (prefix == 0x01) {
+        // control message: parsed once, in place right after the prefix byte;
+        // receivers share the parsed message instead of parsing the bytes again
+        ControlMessagePtr msg = parseControlMessage(message.constData() + 1, message.size() - 1);
+        if (!msg) {
+            qWarning() << "Failed to parse ControlMessage from client" << m_clientId;
+            return Invalid;
+        }
+
+        qDebug() << "Received ControlMessage from client" << m_clientId << "type=" << msg->type();
+        control.append(std::move(msg));
+        return Control;
+    }
+
+    if (prefix == 0x05) {
+        // several control messages in one, handled as if they came one by one
+        if (!parseControlBatch(message.constData() + 1, message.size() - 1, control) || control.isEmpty()) {
+            qWarning() << "Failed to parse ControlBatch from client" << m_clientId;
+            control.clear();
+            return Invalid;
+        }
+        qDebug() << "Received ControlBatch from client" << m_clientId << "messages=" << control.size();
+        return Control;
+    }
+
+    if (prefix == 0x04) {
+        // framed message: read the FrameHeader, the payload after it is left untouched
+        const std::uint8_t* data = reinterpret_cast<const std::uint8_t*>(message.constData()) + 1;
+        FrameHeader header;
+        std::size_t headerSize = 0;
+        if (!parseFrameHeader(data, static_cast<std::size_t>(message.size() - 1), header, headerSize)) {
+            qWarning() << "Invalid frame header from client" << m_clientId;
+            return Invalid;
+        }
+
+        EncodedFrame::Format format = EncodedFrame::Jpeg;
+        if (header.payload == FramePayload::RawYuv)
+            format = EncodedFrame::RawYuv;
+        else if (header.payload == FramePayload::Video)
+            format = EncodedFrame::Video;
+        frame = EncodedFrame::fromMessage(message, 1 + static_cast<int>(headerSize), format);
+        frame.hasHeader = true;
+        frame.header = header;
+        frame.lostBefore = m_sequenceTracker.observe(header.sequence);
+    } else {
+        // image or other binary data: the frame views the message in place.
+        // 0x00 is the explicit image prefix; no prefix means the whole message is the image.
+        // 0x02 is a raw YUV frame and 0x03 a video packet: their headers are
+        // validated where they are drawn or decoded. Only clients that predate
+        // FRAME_HEADER send these bare prefixes.
+        if (prefix == 0x02)
+            frame = EncodedFrame::fromMessage(message, 1, EncodedFrame::RawYuv);
+        else if (prefix == 0x03)
+            frame = EncodedFrame::fromMessage(message, 1, EncodedFrame::Video);
+        else
+            frame = EncodedFrame::fromMessage(message, prefix == 0x00 ? 1 : 0);
+    }
+
+    frame.receivedAtUs = EncodedFrame::nowUs();
+    frame.receivedAtMs = frame.receivedAtUs / 1000;
+    frame.sequence = ++m_frameSequence;
+    if (m_memory && !admit(frame, decodedBytes))
+        return Refused;
+    return Frame;
+}
+
+bool InboundParser::admit(EncodedFrame& frame, qint64 decodedBytes)
+{
+    m_refusal = Refusal();
+    m_refusal.streamId = frame.hasHeader ? frame.header.streamId : 0;
+    const bool video = frame.format == EncodedFrame::Video;
+    if (video && m_awaitingKeyframe.contains(m_refusal.streamId)) {
+        VideoPacketHeader packet;
+        if (!parseVideoPacketHeader(reinterpret_cast<const std::uint8_t*>(frame.data()),
+                                    static_cast<std::size_t>(frame.size()), packet)
+            || !packet.keyframe)
+            return false; // undecodable without the packet refused before it
+    }
+
+    frame.charge = m_memory->charge(frame.buffer.size() + decodedBytes);
+    if (frame.charge) {
+        if (video)
+            m_awaitingKeyframe.remove(m_refusal.streamId);
+        return true;
+    }
+    if (video && !m_awaitingKeyframe.contains(m_refusal.streamId)) {
+        m_awaitingKeyframe.insert(m_refusal.streamId);
+        m_refusal.keyframeNeeded = true;
+    }
+    return false;
+}
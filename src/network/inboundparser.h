@@ -0,0 +1,55 @@
+#ifndef INBOUNDPARSER_H
+#define INBOUNDPARSER_H
+
+#include <QByteArray>
+#include <QSet>
+#include <QString>
+#include <memory>
+#include "controlmessage.h"
+#include "encodedframe.h"
+#include "memorybudget.h"
+
+// Classifies one binary WebSocket message from a client by its prefix byte
+// and turns frames into EncodedFrames (viewing the message in place) with
+// their receive metadata. Keeps the per-connection frame counter and header
+// sequence tracking, so each session needs its own instance. Shared by the
+// Qt and Beast server backends; not synchronized.
+class InboundParser
+{
+public:
+    enum Result {
+        Invalid, // logged and dropped
+        Control, // `control` holds the parsed ControlMessage(s), several for a ControlBatch
+        Frame,   // `frame` holds the payload
+        Refused  // a frame over the memory budget, dropped (lastRefusal())
+    };
+
+    // Which stream lost a frame to the memory budget
+    struct Refusal {
+        quint16 streamId = 0;
+        bool keyframeNeeded = false; // a video stream just lost a frame: ask for a keyframe
+    };
+
+    explicit InboundParser(const QString& clientId = QString());
+
+    // Charge every frame to `account` (EncodedFrame::charge). Once a video
+    // frame of a stream is refused, its later packets are refused too up to
+    // the next keyframe: they could not be decoded without it.
+    void setMemoryAccount(const std::shared_ptr<MemoryBudget::Account>& account);
+
+    // `decodedBytes`: an image decoded while the message arrived, held with the frame
+    Result parse(const QByteArray& message, EncodedFrame& frame, ControlMessages& control, qint64 decodedBytes = 0);
+    const Refusal& lastRefusal() const { return m_refusal; }
+
+private:
+    bool admit(EncodedFrame& frame, qint64 decodedBytes);
+
+    QString m_clientId; // for log messages
+    quint64 m_frameSequence = 0;
+    FrameSequenceTracker m_sequenceTracker;
+    std::shared_ptr<MemoryBudget::Account> m_memory;
+    QSet<quint16> m_awaitingKeyframe; // video streams that lost a frame to the budget
+    Refusal m_refusal;
+};
+
+#endif // INBOUNDPARSER_H
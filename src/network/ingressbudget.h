@@ -0,0 +1,170 @@
+#ifndef INGRESSBUDGET_H
+#define INGRESSBUDGET_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Server-wide ingress limits (0 disables a limit)
+struct IngressBudgetConfig {
+    double maxBitsPerSecond = 0.0;     // received payload
+    double maxDecodeMsPerSecond = 0.0; // decode time summed over clients (1000 == one core)
+    int activeWeight = 4;
+    int pinnedWeight = 2;
+    int backgroundWeight = 1;
+    int minFps = 1;          // every streaming client keeps at least this rate
+    int minQuality = 30;     // floor of the quality cap
+};
+
+enum class IngressPriority {
+    Background = 0,
+    Pinned,
+    Active
+};
+
+// What a client would stream without the budget, and what a frame of it costs
+struct IngressDemand {
+    std::string clientId;
+    IngressPriority priority = IngressPriority::Background;
+    int maxFps = 0;                // the client's ceiling (configured, preview or thumbnail rate)
+    double bytesPerFrame = -1.0;   // measured; <= 0 while unknown
+    double decodeMsPerFrame = -1.0; // measured; <= 0 while unknown or not decoded
+    int quality = 0;               // current JPEG quality
+};
+
+struct IngressGrant {
+    std::string clientId;
+    int fps = 0;        // at most the demand's maxFps
+    int maxQuality = 0; // 0: no cap; otherwise even minFps does not fit the client's share
+};
+
+// Splits the server's ingress budget (bandwidth and decode time per second)
+// over the streaming clients: weighted max-min fair shares, weights by
+// priority (active > pinned > background). A client that needs less than its
+// share leaves the rest to the others. Each client's frame rate is what its
+// shares of both resources pay for at its measured cost per frame, capped by
+// its own ceiling; when its bandwidth share does not cover even minFps, a
+// quality cap scaled to the shortfall is returned as well.
+//
+// Costs that are not measured yet do not limit a client (the next allocation
+// uses them). The minFps floor can exceed the budget with very many clients.
+//
+// Pure computation; the caller sends the resulting SET_FPS / SET_QUALITY.
+class IngressBudget
+{
+public:
+    explicit IngressBudget(const IngressBudgetConfig& config = IngressBudgetConfig()) : m_config(config) {}
+
+    void setConfig(const IngressBudgetConfig& config) { m_config = config; }
+    const IngressBudgetConfig& config() const { return m_config; }
+    bool enabled() const { return m_config.maxBitsPerSecond > 0.0 || m_config.maxDecodeMsPerSecond > 0.0; }
+
+    // One grant per demand, same order
+    std::vector<IngressGrant> allocate(const std::vector<IngressDemand>& demands) const
+    {
+        const std::size_t n = demands.size();
+        std::vector<double> weights(n);
+        std::vector<double> bitsPerFrame(n);
+        std::vector<double> decodePerFrame(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            weights[i] = weightOf(demands[i].priority);
+            bitsPerFrame[i] = demands[i].bytesPerFrame > 0.0 ? demands[i].bytesPerFrame * 8.0 : 0.0;
+            decodePerFrame[i] = demands[i].decodeMsPerFrame > 0.0 ? demands[i].decodeMsPerFrame : 0.0;
+        }
+        const std::vector<double> bits = shares(demands, m_config.maxBitsPerSecond, bitsPerFrame, weights);
+        const std::vector<double> decode = shares(demands, m_config.maxDecodeMsPerSecond, decodePerFrame, weights);
+
+        std::vector<IngressGrant> grants(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            const IngressDemand& demand = demands[i];
+            IngressGrant& grant = grants[i];
+            grant.clientId = demand.clientId;
+            const int ceiling = std::max(0, demand.maxFps);
+            double fps = ceiling;
+            if (m_config.maxBitsPerSecond > 0.0 && bitsPerFrame[i] > 0.0)
+                fps = std::min(fps, bits[i] / bitsPerFrame[i]);
+            if (m_config.maxDecodeMsPerSecond > 0.0 && decodePerFrame[i] > 0.0)
+                fps = std::min(fps, decode[i] / decodePerFrame[i]);
+            const int floorFps = std::min(std::max(1, m_config.minFps), ceiling);
+            grant.fps = std::max(floorFps, static_cast<int>(std::floor(fps + 1e-9)));
+
+            // Not even minFps fits the bandwidth share: smaller frames instead
+            const double floorBits = floorFps * bitsPerFrame[i];
+            if (m_config.maxBitsPerSecond > 0.0 && floorBits > 0.0 && bits[i] < floorBits && demand.quality > 0) {
+                const int scaled = static_cast<int>(demand.quality * bits[i] / floorBits);
+                grant.maxQuality = std::max(m_config.minQuality, std::min(demand.quality, scaled));
+            }
+        }
+        return grants;
+    }
+
+private:
+    double weightOf(IngressPriority priority) const
+    {
+        switch (priority) {
+        case IngressPriority::Active:
+            return std::max(1, m_config.activeWeight);
+        case IngressPriority::Pinned:
+            return std::max(1, m_config.pinnedWeight);
+        case IngressPriority::Background:
+            break;
+        }
+        return std::max(1, m_config.backgroundWeight);
+    }
+
+    // Weighted water-filling of `capacity` over what each client would use at
+    // its ceiling; clients of unknown cost take nothing
+    static std::vector<double> shares(const std::vector<IngressDemand>& demands, double capacity,
+                                      const std::vector<double>& costPerFrame, const std::vector<double>& weights)
+    {
+        const std::size_t n = demands.size();
+        std::vector<double> share(n, 0.0);
+        if (capacity <= 0.0)
+            return share;
+        std::vector<double> need(n);
+        std::vector<bool> open(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            need[i] = std::max(0, demands[i].maxFps) * costPerFrame[i];
+            open[i] = need[i] > 0.0;
+        }
+        double remaining = capacity;
+        for (;;) {
+            double weightSum = 0.0;
+            for (std::size_t i = 0; i < n; ++i) {
+                if (open[i])
+                    weightSum += weights[i];
+            }
+            if (weightSum <= 0.0)
+                break;
+            // Satisfy everyone whose whole need fits their fair part, then split again
+            bool satisfied = false;
+            for (std::size_t i = 0; i < n; ++i) {
+                if (open[i] && need[i] <= remaining * weights[i] / weightSum) {
+                    share[i] = need[i];
+                    open[i] = false;
+                    satisfied = true;
+                }
+            }
+            if (satisfied) {
+                remaining = capacity;
+                for (std::size_t i = 0; i < n; ++i) {
+                    if (!open[i])
+                        remaining -= share[i];
+                }
+                continue;
+            }
+            for (std::size_t i = 0; i < n; ++i) {
+                if (open[i])
+                    share[i] = remaining * weights[i] / weightSum;
+            }
+            break;
+        }
+        return share;
+    }
+
+    IngressBudgetConfig m_config;
+};
+
+#endif // INGRESSBUDGET_H
@@ -0,0 +1,93 @@
+#ifndef INGRESSLIMITER_H
+#define INGRESSLIMITER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+// Per-client ingress cap (admission control)
+struct IngressLimiterConfig {
+    std::int64_t maxBytesPerSecond = 0; // 0 disables the cap
+    int intervalMs = 1000;              // evaluation period
+    int graceIntervals = 5;             // over-limit intervals in a row before disconnecting
+    int minFps = 1;                     // throttle floor
+};
+
+// What to do with a client after an evaluation
+struct IngressAction {
+    enum Kind {
+        None,
+        Throttle,  // send SET_FPS with `fps`
+        Disconnect // persistently over the cap
+    };
+    Kind kind = None;
+    int fps = 0;
+};
+
+// Watches one client's received bytes against the cap. An interval over the
+// cap asks for a SET_FPS scaled to fit (the frame rate that would have stayed
+// under it at the measured frame size); a client still over the cap after
+// graceIntervals throttles in a row is to be disconnected. An interval within
+// the cap resets the count, the throttle stays until the server raises it.
+//
+// Not synchronized; time is passed in (ms) so the limiter is deterministic.
+class IngressLimiter
+{
+public:
+    explicit IngressLimiter(const IngressLimiterConfig& config = IngressLimiterConfig()) : m_config(config) {}
+
+    void onFrame(std::size_t bytes)
+    {
+        m_intervalBytes += static_cast<std::int64_t>(bytes);
+        ++m_intervalFrames;
+    }
+
+    IngressAction evaluate(std::int64_t nowMs)
+    {
+        IngressAction action;
+        if (m_lastEvalMs == 0) {
+            m_lastEvalMs = nowMs; // first call starts the measurement interval
+            reset();
+            return action;
+        }
+        const std::int64_t elapsed = nowMs - m_lastEvalMs;
+        if (elapsed < m_config.intervalMs)
+            return action;
+
+        const std::int64_t bytesPerSecond = m_intervalBytes * 1000 / elapsed;
+        const double fps = m_intervalFrames * 1000.0 / static_cast<double>(elapsed);
+        m_lastEvalMs = nowMs;
+        reset();
+        if (m_config.maxBytesPerSecond <= 0 || bytesPerSecond <= m_config.maxBytesPerSecond) {
+            m_overIntervals = 0;
+            return action;
+        }
+
+        if (++m_overIntervals > m_config.graceIntervals) {
+            action.kind = IngressAction::Disconnect;
+            return action;
+        }
+        action.kind = IngressAction::Throttle;
+        const double fitting = fps * static_cast<double>(m_config.maxBytesPerSecond) / static_cast<double>(bytesPerSecond);
+        action.fps = std::max(std::max(1, m_config.minFps), static_cast<int>(fitting));
+        return action;
+    }
+
+    // Over-limit intervals in a row so far
+    int overIntervals() const { return m_overIntervals; }
+
+private:
+    void reset()
+    {
+        m_intervalBytes = 0;
+        m_intervalFrames = 0;
+    }
+
+    IngressLimiterConfig m_config;
+    std::int64_t m_lastEvalMs = 0;
+    std::int64_t m_intervalBytes = 0;
+    int m_intervalFrames = 0;
+    int m_overIntervals = 0;
+};
+
+#endif // INGRESSLIMITER_H
@@ -0,0 +1,184 @@
+#ifndef JITTERBUFFER_H
+#define JITTERBUFFER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+// How the display trades latency for smooth motion
+enum class JitterMode {
+    Off,        // show each frame when it is decoded
+    LowLatency, // absorb typical jitter (90th percentile over ~2 s)
+    Smooth,     // absorb nearly all of it (99th percentile over ~10 s, plus a frame)
+};
+
+// Holds a stream's decoded frames for a short, adaptive delay and releases
+// them at the pace they were captured, so network and decode jitter don't
+// turn into uneven motion. Frame i is due at its capture time plus the
+// target delay; at each display refresh the newest frame due by then is
+// shown and older ones are skipped.
+//
+// The target delay is a percentile of the recent transit times (arrival
+// minus capture), so a constant clock offset error only shifts it. It goes
+// up at once when frames start arriving later, and down by at most
+// `kDecreaseStepUs` per frame shown, which speeds motion up unnoticeably
+// instead of skipping. A transit that jumps by more than `kResyncUs`
+// (client restarted, clock offset re-estimated) starts the statistics over.
+// A frame arriving after it was due is shown at the next refresh, unless a
+// newer one was shown already.
+//
+// Not synchronized; times are microseconds on the clock the capture times
+// were converted to.
+template <typename Frame>
+class JitterBuffer
+{
+public:
+    static const std::int64_t kDecreaseStepUs = 1000;
+    static const std::int64_t kResyncUs = 1000000;
+
+    explicit JitterBuffer(JitterMode mode = JitterMode::LowLatency, std::size_t capacity = 8)
+        : m_capacity(std::max<std::size_t>(1, capacity))
+    {
+        setMode(mode);
+    }
+
+    JitterMode mode() const { return m_mode; }
+    // Keeps the held frames and the statistics; the new percentile applies from the next frame
+    void setMode(JitterMode mode)
+    {
+        m_mode = mode;
+        m_window = mode == JitterMode::Smooth ? 300 : 64;
+        while (m_transits.size() > m_window)
+            m_transits.pop_front();
+    }
+
+    // A frame captured at `captureUs` arrived at `arrivalUs`. False when it
+    // was dropped: older than a frame already shown.
+    bool push(Frame frame, std::int64_t captureUs, std::int64_t arrivalUs)
+    {
+        if (m_shownAny && captureUs <= m_lastShownCaptureUs && m_lastShownCaptureUs - captureUs < kResyncUs) {
+            ++m_late;
+            return false;
+        }
+        const std::int64_t transit = arrivalUs - captureUs;
+        if (!m_transits.empty() && std::abs(transit - m_targetUs) > kResyncUs)
+            restart();
+        addTransit(transit);
+        if (m_lastCaptureUs >= 0 && captureUs > m_lastCaptureUs)
+            m_intervalUs = m_intervalUs > 0 ? (7 * m_intervalUs + (captureUs - m_lastCaptureUs)) / 8
+                                            : captureUs - m_lastCaptureUs;
+        m_lastCaptureUs = captureUs;
+        if (captureUs + m_targetUs < arrivalUs)
+            ++m_late;
+
+        // In capture order; newer frames are the common case
+        auto it = m_frames.end();
+        while (it != m_frames.begin() && std::prev(it)->captureUs > captureUs)
+            --it;
+        m_frames.insert(it, Held{std::move(frame), captureUs});
+        while (m_frames.size() > m_capacity) {
+            m_frames.pop_front();
+            ++m_skipped;
+        }
+        return true;
+    }
+
+    // The frame to show at the refresh at `displayUs`: the newest one due by
+    // then; the ones due before it are skipped. False when none is due.
+    bool take(std::int64_t displayUs, Frame& out)
+    {
+        std::size_t due = 0;
+        while (due < m_frames.size() && m_frames[due].captureUs + m_targetUs <= displayUs)
+            ++due;
+        if (due == 0)
+            return false;
+        m_skipped += due - 1;
+        out = std::move(m_frames[due - 1].frame);
+        m_lastShownCaptureUs = m_frames[due - 1].captureUs;
+        m_shownAny = true;
+        m_frames.erase(m_frames.begin(), m_frames.begin() + static_cast<std::ptrdiff_t>(due));
+        ++m_shown;
+
+        // Ease down towards a lower target
+        const std::int64_t wanted = wantedTargetUs();
+        if (wanted < m_targetUs)
+            m_targetUs = std::max(wanted, m_targetUs - kDecreaseStepUs);
+        return true;
+    }
+
+    // When the oldest held frame is due; -1 when empty
+    std::int64_t nextDueUs() const { return m_frames.empty() ? -1 : m_frames.front().captureUs + m_targetUs; }
+
+    std::size_t size() const { return m_frames.size(); }
+    bool empty() const { return m_frames.empty(); }
+    std::int64_t targetDelayUs() const { return m_targetUs; }
+
+    // Drops the held frames (e.g. the stream is no longer shown); the statistics stay
+    void clear() { m_frames.clear(); }
+    // Drops everything, as for a new stream
+    void restart()
+    {
+        m_frames.clear();
+        m_transits.clear();
+        m_targetUs = 0;
+        m_intervalUs = 0;
+        m_lastCaptureUs = -1;
+        m_shownAny = false;
+    }
+
+    std::uint64_t shown() const { return m_shown; }
+    std::uint64_t skipped() const { return m_skipped; } // replaced by a newer due frame, or overflow
+    std::uint64_t late() const { return m_late; }       // arrived after they were due
+
+private:
+    struct Held {
+        Frame frame;
+        std::int64_t captureUs;
+    };
+
+    void addTransit(std::int64_t transit)
+    {
+        m_transits.push_back(transit);
+        while (m_transits.size() > m_window)
+            m_transits.pop_front();
+        // Later arrivals raise the delay at once
+        m_targetUs = std::max(m_targetUs, wantedTargetUs());
+        if (m_transits.size() == 1)
+            m_targetUs = transit;
+    }
+
+    std::int64_t wantedTargetUs() const
+    {
+        if (m_transits.empty())
+            return 0;
+        std::vector<std::int64_t> sorted(m_transits.begin(), m_transits.end());
+        const double quantile = m_mode == JitterMode::Smooth ? 0.99 : 0.90;
+        const std::size_t rank = std::min(sorted.size() - 1, static_cast<std::size_t>(quantile * double(sorted.size())));
+        std::nth_element(sorted.begin(), sorted.begin() + static_cast<std::ptrdiff_t>(rank), sorted.end());
+        std::int64_t target = sorted[rank];
+        if (m_mode == JitterMode::Smooth)
+            target += m_intervalUs; // a frame of slack: a late frame still lands before its refresh
+        return target;
+    }
+
+    JitterMode m_mode = JitterMode::LowLatency;
+    std::size_t m_capacity;
+    std::size_t m_window = 64;
+    std::deque<Held> m_frames;
+    std::deque<std::int64_t> m_transits;
+    std::int64_t m_targetUs = 0;
+    std::int64_t m_intervalUs = 0;     // smoothed capture interval
+    std::int64_t m_lastCaptureUs = -1;
+    std::int64_t m_lastShownCaptureUs = 0;
+    bool m_shownAny = false;
+    std::uint64_t m_shown = 0;
+    std::uint64_t m_skipped = 0;
+    std::uint64_t m_late = 0;
+};
+
+#endif // JITTERBUFFER_H
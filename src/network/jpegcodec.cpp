@@ -0,0 +1,330 @@
+#include "jpegcodec.h"
+#include <QBuffer>
+#include <QDebug>
+#include <QImageReader>
+#include <QtGlobal>
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+#ifdef IMAGESOCKET_HAVE_TURBOJPEG
+#include <turbojpeg.h>
+#endif
+
+#ifdef IMAGESOCKET_HAVE_V4L2
+#include "v4l2m2mdecoder.h"
+#include "v4l2m2mencoder.h"
+#include "yuvconvert.h"
+#endif
+#include "framesize.h"
+#include "imagepool.h"
+#include "jpegheader.h"
+
+namespace {
+
+// OpenCV to encode, Qt's image plugins to decode
+class GenericJpegCodec : public JpegCodec
+{
+public:
+    const char* name() const override { return "generic"; }
+
+    bool encodeBgr(const unsigned char* pixels, int width, int height, int stride,
+                   int quality, std::vector<unsigned char>& out) override
+    {
+        // Wrap the caller's pixels without copying them
+        const cv::Mat view(height, width, CV_8UC3, const_cast<unsigned char*>(pixels),
+                           static_cast<std::size_t>(stride));
+        const std::vector<int> params = {cv::IMWRITE_JPEG_QUALITY, quality};
+        try {
+            return cv::imencode(".jpg", view, out, params);
+        } catch (const cv::Exception& ex) {
+            qWarning() << "JPEG encode failed:" << ex.what();
+            out.clear();
+            return false;
+        }
+    }
+
+    bool decode(const unsigned char* data, int size, QImage& out) override
+    {
+        return decodeScaled(data, size, 0, 0, out);
+    }
+
+    bool decodeScaled(const unsigned char* data, int size, int targetWidth, int targetHeight,
+                      QImage& out) override
+    {
+        QByteArray bytes = QByteArray::fromRawData(reinterpret_cast<const char*>(data), size);
+        QBuffer buffer(&bytes);
+        buffer.open(QIODevice::ReadOnly);
+        QImageReader reader(&buffer, "JPEG");
+
+        // Qt's JPEG plugin hands a scaled size to libjpeg's DCT scaling; asking for
+        // exactly the scaled size leaves it no smoothing pass on top. It decodes
+        // into the given image when size and format match (colour JPEGs are RGB32),
+        // so the pixels land in pooled storage
+        const QSize full = reader.size();
+        const int denominator = jpegScaleDenominator(full.width(), full.height(), targetWidth, targetHeight);
+        const QSize scaled((full.width() + denominator - 1) / denominator,
+                           (full.height() + denominator - 1) / denominator);
+        if (denominator > 1)
+            reader.setScaledSize(scaled);
+        QImage image = ImagePool::shared().acquire(scaled.width(), scaled.height());
+        if (!reader.read(&image))
+            return false;
+        if (image.format() != QImage::Format_RGB32)
+            image = image.convertToFormat(QImage::Format_RGB32);
+        out = image;
+        return true;
+    }
+};
+
+#ifdef IMAGESOCKET_HAVE_TURBOJPEG
+
+// QImage::Format_RGB32 is 0xffRRGGBB in native byte order
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+const int kRgb32PixelFormat = TJPF_BGRX;
+#else
+const int kRgb32PixelFormat = TJPF_XRGB;
+#endif
+
+class TurboJpegCodec : public JpegCodec
+{
+public:
+    TurboJpegCodec()
+        : m_compressor(tjInitCompress()), m_decompressor(tjInitDecompress())
+    {
+    }
+
+    ~TurboJpegCodec() override
+    {
+        if (m_scratch)
+            tjFree(m_scratch);
+        if (m_compressor)
+            tjDestroy(m_compressor);
+        if (m_decompressor)
+            tjDestroy(m_decompressor);
+    }
+
+    bool valid() const { return m_compressor && m_decompressor; }
+
+    const char* name() const override { return "turbojpeg"; }
+
+    bool encodeBgr(const unsigned char* pixels, int width, int height, int stride,
+                   int quality, std::vector<unsigned char>& out) override
+    {
+        // Worst-case sized scratch, grown only when the resolution goes up
+        const unsigned long needed = tjBufSize(width, height, TJSAMP_420);
+        if (needed > m_scratchSize) {
+            if (m_scratch)
+                tjFree(m_scratch);
+            m_scratch = tjAlloc(static_cast<int>(needed));
+            m_scratchSize = m_scratch ? needed : 0;
+            if (!m_scratch)
+                return false;
+        }
+
+        unsigned char* dst = m_scratch;
+        unsigned long jpegSize = m_scratchSize;
+        if (tjCompress2(m_compressor, pixels, width, stride, height, TJPF_BGR, &dst, &jpegSize,
+                        TJSAMP_420, quality, TJFLAG_NOREALLOC | TJFLAG_FASTDCT) != 0) {
+            qWarning() << "TurboJPEG encode failed:" << tjGetErrorStr2(m_compressor);
+            out.clear();
+            return false;
+        }
+
+        out.assign(m_scratch, m_scratch + jpegSize); // reuses out's capacity
+        return true;
+    }
+
+    bool decode(const unsigned char* data, int size, QImage& out) override
+    {
+        return decodeScaled(data, size, 0, 0, out);
+    }
+
+    bool decodeScaled(const unsigned char* data, int size, int targetWidth, int targetHeight,
+                      QImage& out) override
+    {
+        int width = 0, height = 0, subsamp = 0, colorspace = 0;
+        if (tjDecompressHeader3(m_decompressor, data, static_cast<unsigned long>(size),
+                                &width, &height, &subsamp, &colorspace) != 0)
+            return false;
+
+        // tjDecompress2() picks the DCT scaling factor from the output size
+        const tjscalingfactor factor = {1, jpegScaleDenominator(width, height, targetWidth, targetHeight)};
+        width = TJSCALED(width, factor);
+        height = TJSCALED(height, factor);
+        QImage image = ImagePool::shared().acquire(width, height);
+        if (image.isNull())
+            return false;
+
+        // Decode straight into the image's pixel storage
+        if (tjDecompress2(m_decompressor, data, static_cast<unsigned long>(size), image.bits(),
+                          width, image.bytesPerLine(), height, kRgb32PixelFormat, TJFLAG_FASTDCT) != 0
+            && tjGetErrorCode(m_decompressor) != TJERR_WARNING) {
+            qWarning() << "TurboJPEG decode failed:" << tjGetErrorStr2(m_decompressor);
+            return false;
+        }
+
+        out = image;
+        return true;
+    }
+
+private:
+    tjhandle m_compressor = nullptr;
+    tjhandle m_decompressor = nullptr;
+    unsigned char* m_scratch = nullptr;
+    unsigned long m_scratchSize = 0;
+};
+
+#endif // IMAGESOCKET_HAVE_TURBOJPEG
+
+#ifdef IMAGESOCKET_HAVE_V4L2
+
+// Hardware decode and encode on V4L2 M2M devices (either may be missing), software
+// for the other direction and for any frame a device rejects (progressive,
+// grayscale, errors). After repeated failures a device is released and that
+// direction behaves like the software fallback.
+class V4l2JpegCodec : public JpegCodec
+{
+public:
+    V4l2JpegCodec(std::unique_ptr<V4l2M2mDecoder> decoder, std::unique_ptr<V4l2M2mEncoder> encoder,
+                  std::unique_ptr<JpegCodec> software)
+        : m_decoder(std::move(decoder)), m_encoder(std::move(encoder)), m_software(std::move(software))
+    {
+    }
+
+    const char* name() const override { return m_decoder || m_encoder ? "v4l2-m2m" : m_software->name(); }
+
+    bool encodeBgr(const unsigned char* pixels, int width, int height, int stride,
+                   int quality, std::vector<unsigned char>& out) override
+    {
+        if (m_encoder) {
+            if (m_encoder->encodeBgr(pixels, width, height, stride, quality, 0, false, out)) {
+                m_encodeFailures = 0;
+                return true;
+            }
+            if (++m_encodeFailures >= kMaxConsecutiveFailures) {
+                qWarning() << "V4L2 encoder" << QString::fromStdString(m_encoder->devicePath())
+                           << "keeps failing, switching to" << m_software->name();
+                m_encoder.reset();
+            }
+        }
+        return m_software->encodeBgr(pixels, width, height, stride, quality, out);
+    }
+
+    bool decode(const unsigned char* data, int size, QImage& out) override
+    {
+        if (m_decoder) {
+            YuvFrameView frame;
+            if (m_decoder->decode(data, static_cast<std::size_t>(size), frame)) {
+                m_failures = 0;
+                QImage image = ImagePool::shared().acquire(frame.width, frame.height);
+                if (!image.isNull()) {
+                    yuvToRgb32(frame, image.bits(), image.bytesPerLine());
+                    out = image;
+                    return true;
+                }
+            } else if (++m_failures >= kMaxConsecutiveFailures) {
+                qWarning() << "V4L2 decoder" << QString::fromStdString(m_decoder->devicePath())
+                           << "keeps failing, switching to" << m_software->name();
+                m_decoder.reset();
+            }
+        }
+        return m_software->decode(data, size, out);
+    }
+
+    bool decodeScaled(const unsigned char* data, int size, int targetWidth, int targetHeight,
+                      QImage& out) override
+    {
+        // The device only decodes at full size; a scaled software decode costs a
+        // fraction of a full one and leaves the device to the full-size streams
+        JpegHeaderInfo header;
+        if (parseJpegHeader(data, static_cast<std::size_t>(size), header)
+            && jpegScaleDenominator(header.width, header.height, targetWidth, targetHeight) > 1)
+            return m_software->decodeScaled(data, size, targetWidth, targetHeight, out);
+        return decode(data, size, out);
+    }
+
+private:
+    static const int kMaxConsecutiveFailures = 8;
+
+    std::unique_ptr<V4l2M2mDecoder> m_decoder;
+    std::unique_ptr<V4l2M2mEncoder> m_encoder;
+    std::unique_ptr<JpegCodec> m_software;
+    int m_failures = 0;
+    int m_encodeFailures = 0;
+};
+
+#endif // IMAGESOCKET_HAVE_V4L2
+
+} // namespace
+
+bool JpegCodec::decodeScaled(const unsigned char* data, int size, int targetWidth, int targetHeight, QImage& out)
+{
+    Q_UNUSED(targetWidth);
+    Q_UNUSED(targetHeight);
+    return decode(data, size, out);
+}
+
+JpegCodec& JpegCodec::forCurrentThread()
+{
+    thread_local std::unique_ptr<JpegCodec> codec = create();
+    return *codec;
+}
+
+std::unique_ptr<JpegCodec> JpegCodec::create()
+{
+    const QByteArray backend = qgetenv("IMAGESOCKET_JPEG_BACKEND");
+    std::unique_ptr<JpegCodec> software = createSoftware();
+
+#ifdef IMAGESOCKET_HAVE_V4L2
+    // Hardware decode and encode whenever a device is present, unless a software
+    // backend is requested. Decoders and encoders are usually separate nodes
+    if (backend.isEmpty() || backend == "v4l2") {
+        std::unique_ptr<V4l2M2mDecoder> decoder = V4l2M2mDecoder::open(qgetenv("IMAGESOCKET_V4L2_DEVICE").toStdString());
+        std::unique_ptr<V4l2M2mEncoder> encoder = V4l2M2mEncoder::open(
+            V4l2M2mEncoder::Format::Jpeg, qgetenv("IMAGESOCKET_V4L2_ENCODER").toStdString());
+        if (decoder || encoder)
+            return std::unique_ptr<JpegCodec>(new V4l2JpegCodec(std::move(decoder), std::move(encoder), std::move(software)));
+        if (backend == "v4l2")
+            qWarning() << "No V4L2 M2M JPEG device found, using" << software->name();
+    }
+#else
+    Q_UNUSED(backend);
+#endif
+    return software;
+}
+
+std::unique_ptr<JpegCodec> JpegCodec::createSoftware()
+{
+#ifdef IMAGESOCKET_HAVE_TURBOJPEG
+    if (qgetenv("IMAGESOCKET_JPEG_BACKEND") != "generic") {
+        std::unique_ptr<TurboJpegCodec> codec(new TurboJpegCodec());
+        if (codec->valid())
+            return std::unique_ptr<JpegCodec>(codec.release());
+        qWarning() << "TurboJPEG initialization failed, using the generic JPEG codec";
+    }
+#endif
+    return createGeneric();
+}
+
+std::unique_ptr<JpegCodec> JpegCodec::createGeneric()
+{
+    return std::unique_ptr<JpegCodec>(new GenericJpegCodec());
+}
+
+bool JpegCodec::turboJpegAvailable()
+{
+#ifdef IMAGESOCKET_HAVE_TURBOJPEG
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool JpegCodec::v4l2Available()
+{
+#ifdef IMAGESOCKET_HAVE_V4L2
+    return true;
+#else
+    return false;
+#endif
+}
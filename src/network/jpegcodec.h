@@ -0,0 +1,52 @@
+#ifndef JPEGCODEC_H
+#define JPEGCODEC_H
+
+#include <QImage>
+#include <memory>
+#include <vector>
+
+// Pluggable JPEG encode/decode backend.
+// With IMAGESOCKET_HAVE_TURBOJPEG the TurboJPEG API is used (SIMD on NEON/x86);
+// otherwise the generic OpenCV/Qt codecs are used. With IMAGESOCKET_HAVE_V4L2,
+// decoding and encoding go to V4L2 M2M hardware codecs when present, falling
+// back to software per frame. Instances are not thread-safe:
+// use forCurrentThread(), which keeps one codec (and its handles) per thread.
+class JpegCodec
+{
+public:
+    virtual ~JpegCodec() = default;
+
+    virtual const char* name() const = 0;
+
+    // Encode packed 8-bit BGR pixels (OpenCV layout) into `out`.
+    // `out` is resized to the JPEG size; its capacity is reused across calls.
+    virtual bool encodeBgr(const unsigned char* pixels, int width, int height, int stride,
+                           int quality, std::vector<unsigned char>& out) = 0;
+
+    // Decode a JPEG into a QImage::Format_RGB32 image (uploaded to the GPU without
+    // conversion). Pixel storage comes from ImagePool::shared() and returns to it
+    // once every consumer has released the image.
+    virtual bool decode(const unsigned char* data, int size, QImage& out) = 0;
+
+    // Like decode(), at 1/2, 1/4 or 1/8 of the size when the picture is shown
+    // within `targetWidth` x `targetHeight` (jpegScaleDenominator()): the IDCT
+    // produces the smaller picture directly, nothing is scaled afterwards.
+    // An empty target decodes at full size.
+    virtual bool decodeScaled(const unsigned char* data, int size, int targetWidth, int targetHeight,
+                              QImage& out);
+
+    // Codec owned by the calling thread (created on first use)
+    static JpegCodec& forCurrentThread();
+
+    // Best available backend. IMAGESOCKET_JPEG_BACKEND selects one explicitly
+    // (v4l2, turbojpeg, generic); IMAGESOCKET_V4L2_DEVICE pins the decoder's
+    // device node, IMAGESOCKET_V4L2_ENCODER the encoder's.
+    static std::unique_ptr<JpegCodec> create();
+    // Best software backend (TurboJPEG or generic)
+    static std::unique_ptr<JpegCodec> createSoftware();
+    static std::unique_ptr<JpegCodec> createGeneric();
+    static bool turboJpegAvailable();
+    static bool v4l2Available();
+};
+
+#endif // JPEGCODEC_H
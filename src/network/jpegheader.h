@@ -0,0 +1,61 @@
+#ifndef JPEGHEADER_H
+#define JPEGHEADER_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Frame parameters read from a JPEG's SOF segment, without decoding it
+struct JpegHeaderInfo {
+    int width = 0;
+    int height = 0;
+    int components = 0;
+    bool progressive = false;
+};
+
+// Walk the marker segments up to the first SOFn. Returns false for data that
+// is not a JPEG or is truncated before the frame header.
+inline bool parseJpegHeader(const std::uint8_t* data, std::size_t size, JpegHeaderInfo& info)
+{
+    if (!data || size < 4 || data[0] != 0xFF || data[1] != 0xD8)
+        return false;
+
+    std::size_t pos = 2;
+    while (pos + 4 <= size) {
+        if (data[pos] != 0xFF)
+            return false;
+        const std::uint8_t marker = data[pos + 1];
+        if (marker == 0xFF) {
+            ++pos; // fill byte
+            continue;
+        }
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) {
+            pos += 2; // standalone markers carry no length
+            continue;
+        }
+        if (marker == 0xD9 || marker == 0xDA)
+            return false; // EOI / SOS before any frame header
+
+        const std::size_t length = (static_cast<std::size_t>(data[pos + 2]) << 8) | data[pos + 3];
+        if (length < 2 || pos + 2 + length > size)
+            return false;
+
+        // SOF0..SOF15, except DHT (C4), JPG (C8) and DAC (CC)
+        const bool isSof = marker >= 0xC0 && marker <= 0xCF
+            && marker != 0xC4 && marker != 0xC8 && marker != 0xCC;
+        if (isSof) {
+            if (length < 8)
+                return false;
+            const std::uint8_t* sof = data + pos + 4;
+            info.height = (sof[1] << 8) | sof[2];
+            info.width = (sof[3] << 8) | sof[4];
+            info.components = sof[5];
+            info.progressive = marker == 0xC2 || marker == 0xC6 || marker == 0xCA || marker == 0xCE;
+            return info.width > 0 && info.height > 0;
+        }
+
+        pos += 2 + length;
+    }
+    return false;
+}
+
+#endif // JPEGHEADER_H
@@ -0,0 +1,80 @@
+#ifndef KEEPALIVE_H
+#define KEEPALIVE_H
+
+#include <algorithm>
+#include <cstdint>
+
+// Dead-peer detection on an open connection (WebSocket ping / pong)
+struct KeepaliveConfig {
+    int intervalMs = 2000; // tick period: a ping after a tick without traffic; 0 disables it
+    int maxMissed = 2;     // pings left unanswered before the peer counts as gone
+};
+
+// A half-open TCP connection (peer powered off, cable pulled, NAT entry
+// expired) reports nothing until the kernel gives up on it, minutes later.
+// Pinged at every quiet tick, a peer that stays silent for maxMissed pings
+// in a row is gone: between (maxMissed + 1) and (maxMissed + 2) intervals
+// after it was last heard from. Anything received counts as an answer, so a
+// busy connection is never pinged and a pong stuck behind a large frame
+// doesn't count as missed.
+inline std::int64_t keepaliveTimeoutMs(const KeepaliveConfig& config)
+{
+    return config.intervalMs > 0
+        ? static_cast<std::int64_t>(config.intervalMs) * (std::max(0, config.maxMissed) + 1) : 0;
+}
+
+// One connection's side of it, ticked every intervalMs. Receiving only sets a
+// flag (no clock read per message). Not synchronized.
+class KeepaliveTracker
+{
+public:
+    enum Action {
+        None,
+        Ping,   // send a ping
+        Expired // no answer to maxMissed pings: close the connection
+    };
+
+    explicit KeepaliveTracker(const KeepaliveConfig& config = KeepaliveConfig()) : m_config(config) {}
+
+    void setConfig(const KeepaliveConfig& config)
+    {
+        m_config = config;
+        reset();
+    }
+    const KeepaliveConfig& config() const { return m_config; }
+    bool enabled() const { return m_config.intervalMs > 0; }
+
+    // Any message or pong from the peer
+    void onReceived() { m_heard = true; }
+
+    Action tick()
+    {
+        if (!enabled())
+            return None;
+        if (m_heard) {
+            m_heard = false;
+            m_missed = 0;
+            return None;
+        }
+        if (m_missed >= std::max(0, m_config.maxMissed))
+            return Expired;
+        ++m_missed;
+        return Ping;
+    }
+
+    // Pings sent since the peer was last heard from
+    int missed() const { return m_missed; }
+
+    void reset()
+    {
+        m_heard = false;
+        m_missed = 0;
+    }
+
+private:
+    KeepaliveConfig m_config;
+    bool m_heard = false;
+    int m_missed = 0;
+};
+
+#endif // KEEPALIVE_H
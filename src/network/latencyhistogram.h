@@ -0,0 +1,126 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// Lower edge of the first histogram bucket
+const double kLatencyMinMs = 0.1;
+
+// Fixed-size latency histogram with logarithmic buckets (8 per octave, about
+// 9% wide) from 0.1 ms to ~26 s, so p50/p99 come out of a handful of
+// integer counters instead of a sample buffer. Recording is O(1) and never
+// allocates. decay() halves every count: calling it periodically turns the
+// histogram into a fading window that follows the current pipeline state.
+class LatencyHistogram
+{
+public:
+    static const int kBucketsPerOctave = 8;
+    static const int kBucketCount = 8 * 18 + 1; // bucket 0 holds everything below kLatencyMinMs
+
+    void record(double ms)
+    {
+        ++m_counts[bucketFor(ms)];
+        ++m_total;
+    }
+
+    // Upper edge of the bucket holding the p-th percentile (0 < p <= 100),
+    // -1 when empty
+    double percentile(double p) const
+    {
+        if (m_total == 0)
+            return -1.0;
+        const double clamped = p < 0.0 ? 0.0 : (p > 100.0 ? 100.0 : p);
+        std::uint64_t rank = static_cast<std::uint64_t>(std::ceil(clamped / 100.0 * static_cast<double>(m_total)));
+        if (rank == 0)
+            rank = 1;
+        std::uint64_t seen = 0;
+        for (int i = 0; i < kBucketCount; ++i) {
+            seen += m_counts[i];
+            if (seen >= rank)
+                return upperEdge(i);
+        }
+        return upperEdge(kBucketCount - 1);
+    }
+
+    std::uint64_t count() const { return m_total; }
+
+    void decay()
+    {
+        m_total = 0;
+        for (int i = 0; i < kBucketCount; ++i) {
+            m_counts[i] /= 2;
+            m_total += m_counts[i];
+        }
+    }
+
+    void clear() { *this = LatencyHistogram(); }
+
+    // Adds the samples of `other` (server-wide figures from per-client histograms)
+    void merge(const LatencyHistogram& other)
+    {
+        for (int i = 0; i < kBucketCount; ++i)
+            m_counts[i] += other.m_counts[i];
+        m_total += other.m_total;
+    }
+
+    static int bucketFor(double ms)
+    {
+        if (!(ms >= kLatencyMinMs)) // also catches NaN
+            return 0;
+        const int bucket = 1 + static_cast<int>(std::floor(std::log2(ms / kLatencyMinMs) * kBucketsPerOctave));
+        return bucket < kBucketCount ? bucket : kBucketCount - 1;
+    }
+
+    static double upperEdge(int bucket)
+    {
+        return kLatencyMinMs * std::exp2(static_cast<double>(bucket) / kBucketsPerOctave);
+    }
+
+private:
+    std::uint32_t m_counts[kBucketCount] = {};
+    std::uint64_t m_total = 0;
+};
+
+// Pipeline stages of one frame, from the client's capture to the server's screen
+enum class LatencyStage {
+    CaptureToSend, // capture until handed to the client's send queue (encoding)
+    Network,       // send queue until received: client queueing plus the wire
+    Decode,        // received until decoded: decoder queueing plus decoding
+    Display,       // decoded until its texture is uploaded by the scene graph
+    EndToEnd,      // capture until displayed
+    Count
+};
+
+const int kLatencyStageCount = static_cast<int>(LatencyStage::Count);
+
+// Stable identifiers used as keys in the QML latency maps
+inline const char* latencyStageKey(LatencyStage stage)
+{
+    switch (stage) {
+    case LatencyStage::CaptureToSend: return "captureToSend";
+    case LatencyStage::Network: return "network";
+    case LatencyStage::Decode: return "decode";
+    case LatencyStage::Display: return "display";
+    case LatencyStage::EndToEnd:
+    case LatencyStage::Count: break;
+    }
+    return "endToEnd";
+}
+
+// One histogram per stage for a client
+struct LatencyBreakdown {
+    LatencyHistogram stages[kLatencyStageCount];
+
+    LatencyHistogram& operator[](LatencyStage stage) { return stages[static_cast<int>(stage)]; }
+    const LatencyHistogram& operator[](LatencyStage stage) const { return stages[static_cast<int>(stage)]; }
+
+    void decay()
+    {
+        for (LatencyHistogram& histogram : stages)
+            histogram.decay();
+    }
+};
+
+#endif // LATENCYHISTOGRAM_H
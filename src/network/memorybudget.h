@@ -0,0 +1,195 @@
+#ifndef MEMORYBUDGET_H
+#define MEMORYBUDGET_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Server-wide memory limits (0 disables a limit)
+struct MemoryBudgetConfig {
+    std::int64_t totalBytes = 0;     // received frames in flight plus what the owner reports (decoded images, caches)
+    std::int64_t perClientBytes = 0; // received frames one connection has in flight
+    int pressurePercent = 85;        // of totalBytes: above it the owner evicts what it can rebuild
+};
+
+// Snapshot of what is held, for reports
+struct MemoryUsage {
+    std::int64_t receivedBytes = 0; // charged: received frames not released yet
+    std::int64_t externalBytes = 0; // reported by the owner
+    std::uint64_t refused = 0;      // frames refused since start
+    bool underPressure = false;
+    struct Account {
+        std::string name;
+        std::int64_t bytes = 0;
+        std::uint64_t refused = 0;
+    };
+    std::vector<Account> accounts; // connections with frames in flight or refusals, largest first
+};
+
+// Bounds what the server buffers for its clients. Every received frame is
+// charged to its connection's account before anyone sees it, and the charge
+// travels with the frame (EncodedFrame::charge) through queued signals,
+// decoder queues and the recorder: it is released when the last copy goes
+// away, wherever that is. A frame that does not fit is refused and dropped
+// at once, so a camera that sends faster than the server drains cannot pile
+// up frames behind it.
+//
+// A connection with nothing in flight always gets its frame: a client is
+// never starved by the others or by a cap smaller than one of its frames,
+// and the worst case stays one frame per session (bounded by the admission
+// limits). Beyond that, a frame must fit both the connection's cap and the
+// total, which also counts the bytes the owner reports with
+// setExternalBytes() (decoded images, thumbnails, snapshot caches). The owner
+// polls underPressure() and evicts what it can rebuild.
+//
+// Thread-safe: sessions charge on their I/O threads, any thread releases.
+// Checks and charges are not one atomic step, so concurrent frames may
+// overshoot a limit by one frame each.
+class MemoryBudget
+{
+    struct State;
+
+public:
+    using Charge = std::shared_ptr<const void>;
+
+    // One connection's share
+    class Account : public std::enable_shared_from_this<Account>
+    {
+    public:
+        // Held until the returned charge is released; null: refused
+        Charge charge(std::int64_t bytes)
+        {
+            bytes = std::max<std::int64_t>(0, bytes);
+            const std::int64_t held = m_bytes.load(std::memory_order_relaxed);
+            if (held > 0) {
+                const std::int64_t perClient = m_state->perClientBytes.load(std::memory_order_relaxed);
+                const std::int64_t total = m_state->totalBytes.load(std::memory_order_relaxed);
+                if ((perClient > 0 && held + bytes > perClient)
+                    || (total > 0 && m_state->heldBytes() + bytes > total)) {
+                    m_refused.fetch_add(1, std::memory_order_relaxed);
+                    m_state->refused.fetch_add(1, std::memory_order_relaxed);
+                    return Charge();
+                }
+            }
+            m_bytes.fetch_add(bytes, std::memory_order_relaxed);
+            m_state->charged.fetch_add(bytes, std::memory_order_relaxed);
+            return Charge(this, Release{shared_from_this(), bytes});
+        }
+
+        const std::string& name() const { return m_name; }
+        std::int64_t bytes() const { return m_bytes.load(std::memory_order_relaxed); }
+        std::uint64_t refused() const { return m_refused.load(std::memory_order_relaxed); }
+
+        Account(const std::shared_ptr<State>& state, const std::string& name) : m_state(state), m_name(name) {}
+
+    private:
+        struct Release {
+            std::shared_ptr<Account> account;
+            std::int64_t bytes;
+            void operator()(const void*) const
+            {
+                account->m_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+                account->m_state->charged.fetch_sub(bytes, std::memory_order_relaxed);
+            }
+        };
+
+        std::shared_ptr<State> m_state;
+        std::string m_name;
+        std::atomic<std::int64_t> m_bytes{0};
+        std::atomic<std::uint64_t> m_refused{0};
+    };
+
+    explicit MemoryBudget(const MemoryBudgetConfig& config = MemoryBudgetConfig()) : m_state(std::make_shared<State>())
+    {
+        setConfig(config);
+    }
+
+    void setConfig(const MemoryBudgetConfig& config)
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        m_state->config = config;
+        m_state->totalBytes.store(std::max<std::int64_t>(0, config.totalBytes), std::memory_order_relaxed);
+        m_state->perClientBytes.store(std::max<std::int64_t>(0, config.perClientBytes), std::memory_order_relaxed);
+    }
+
+    MemoryBudgetConfig config() const
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        return m_state->config;
+    }
+
+    // `name` is for reports (the connection id)
+    std::shared_ptr<Account> openAccount(const std::string& name)
+    {
+        std::shared_ptr<Account> account = std::make_shared<Account>(m_state, name);
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        auto& accounts = m_state->accounts;
+        accounts.erase(std::remove_if(accounts.begin(), accounts.end(),
+                                      [](const std::weak_ptr<Account>& a) { return a.expired(); }),
+                       accounts.end());
+        accounts.push_back(account);
+        return account;
+    }
+
+    // What the owner holds outside the accounts, measured by it
+    void setExternalBytes(std::int64_t bytes)
+    {
+        m_state->external.store(std::max<std::int64_t>(0, bytes), std::memory_order_relaxed);
+    }
+
+    std::int64_t chargedBytes() const { return m_state->charged.load(std::memory_order_relaxed); }
+    std::int64_t heldBytes() const { return m_state->heldBytes(); }
+
+    bool underPressure() const
+    {
+        const std::int64_t total = m_state->totalBytes.load(std::memory_order_relaxed);
+        if (total <= 0)
+            return false;
+        const int percent = std::min(100, std::max(1, config().pressurePercent));
+        return m_state->heldBytes() * 100 >= total * percent;
+    }
+
+    MemoryUsage usage() const
+    {
+        MemoryUsage usage;
+        usage.receivedBytes = m_state->charged.load(std::memory_order_relaxed);
+        usage.externalBytes = m_state->external.load(std::memory_order_relaxed);
+        usage.refused = m_state->refused.load(std::memory_order_relaxed);
+        usage.underPressure = underPressure();
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        for (const std::weak_ptr<Account>& weak : m_state->accounts) {
+            const std::shared_ptr<Account> account = weak.lock();
+            if (!account || (account->bytes() <= 0 && account->refused() == 0))
+                continue;
+            usage.accounts.push_back(MemoryUsage::Account{account->name(), account->bytes(), account->refused()});
+        }
+        std::sort(usage.accounts.begin(), usage.accounts.end(),
+                  [](const MemoryUsage::Account& a, const MemoryUsage::Account& b) { return a.bytes > b.bytes; });
+        return usage;
+    }
+
+private:
+    struct State {
+        mutable std::mutex mutex; // config and the account list
+        MemoryBudgetConfig config;
+        std::vector<std::weak_ptr<Account>> accounts;
+        std::atomic<std::int64_t> totalBytes{0};
+        std::atomic<std::int64_t> perClientBytes{0};
+        std::atomic<std::int64_t> charged{0};
+        std::atomic<std::int64_t> external{0};
+        std::atomic<std::uint64_t> refused{0};
+
+        std::int64_t heldBytes() const
+        {
+            return charged.load(std::memory_order_relaxed) + external.load(std::memory_order_relaxed);
+        }
+    };
+
+    std::shared_ptr<State> m_state;
+};
+
+#endif // MEMORYBUDGET_H
@@ -0,0 +1,132 @@
+#include "metricsserver.h"
+#include <QDebug>
+#include <QMetaObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+
+namespace {
+// Scrapes are a request line and a few headers; anything bigger is not one
+const int kMaxRequestBytes = 8 * 1024;
+const char kContentType[] = "text/plain; version=0.0.4; charset=utf-8";
+
+QByteArray httpResponse(const char* status, const char* contentType, const QByteArray& body)
+{
+    QByteArray response;
+    response.reserve(body.size() + 128);
+    response += "HTTP/1.1 ";
+    response += status;
+    response += "\r\nContent-Type: ";
+    response += contentType;
+    response += "\r\nContent-Length: ";
+    response += QByteArray::number(body.size());
+    response += "\r\nConnection: close\r\n\r\n";
+    response += body;
+    return response;
+}
+} // namespace
+
+MetricsServer::MetricsServer(std::shared_ptr<const StreamMetrics> metrics, QObject* parent)
+    : QObject(parent), m_metrics(std::move(metrics))
+{
+    m_thread.setObjectName("MetricsServer");
+}
+
+MetricsServer::~MetricsServer()
+{
+    stop();
+}
+
+bool MetricsServer::start(quint16 port, const QHostAddress& address)
+{
+    if (m_listener || !m_metrics)
+        return false;
+
+    m_listener = new QTcpServer;
+    m_listener->moveToThread(&m_thread);
+    m_thread.start();
+
+    bool listening = false;
+    QMetaObject::invokeMethod(m_listener, [this, port, address, &listening]() {
+        listening = m_listener->listen(address, port);
+        if (!listening)
+            return;
+        m_port = m_listener->serverPort();
+        QObject::connect(m_listener, &QTcpServer::newConnection, m_listener, [this]() { onNewConnection(); });
+    }, Qt::BlockingQueuedConnection);
+
+    if (!listening) {
+        qWarning() << "MetricsServer: can't listen on port" << port << ":" << m_listener->errorString();
+        stop();
+        return false;
+    }
+    qInfo() << "MetricsServer: serving /metrics on port" << m_port;
+    return true;
+}
+
+void MetricsServer::stop()
+{
+    if (!m_listener)
+        return;
+    // Open connections are children of the listener and go with it
+    QMetaObject::invokeMethod(m_listener, [this]() { m_listener->close(); }, Qt::BlockingQueuedConnection);
+    m_thread.quit();
+    m_thread.wait();
+    delete m_listener;
+    m_listener = nullptr;
+    m_port = 0;
+}
+
+bool MetricsServer::isRunning() const
+{
+    return m_listener != nullptr;
+}
+
+quint16 MetricsServer::port() const
+{
+    return m_port;
+}
+
+QByteArray MetricsServer::respond(const QByteArray& request, const StreamMetrics& metrics)
+{
+    const int lineEnd = request.indexOf("\r\n");
+    const QList<QByteArray> requestLine = request.left(lineEnd < 0 ? request.size() : lineEnd).split(' ');
+    if (requestLine.size() < 2 || !requestLine.at(1).startsWith('/'))
+        return httpResponse("400 Bad Request", "text/plain", "bad request\n");
+
+    QByteArray path = requestLine.at(1);
+    const int query = path.indexOf('?');
+    if (query >= 0)
+        path.truncate(query);
+    if (path != "/metrics")
+        return httpResponse("404 Not Found", "text/plain", "not found, try /metrics\n");
+    if (requestLine.at(0) != "GET" && requestLine.at(0) != "HEAD")
+        return httpResponse("405 Method Not Allowed", "text/plain", "GET only\n");
+
+    const std::string text = metrics.render();
+    QByteArray response = httpResponse("200 OK", kContentType, QByteArray(text.data(), static_cast<int>(text.size())));
+    if (requestLine.at(0) == "HEAD")
+        response.truncate(response.indexOf("\r\n\r\n") + 4);
+    return response;
+}
+
+void MetricsServer::onNewConnection()
+{
+    // Listener thread
+    while (QTcpSocket* socket = m_listener->nextPendingConnection()) {
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        connect(socket, &QTcpSocket::readyRead, socket, [this, socket]() {
+            if (socket->property("answered").toBool())
+                return;
+            const QByteArray pending = socket->peek(kMaxRequestBytes + 1);
+            const bool complete = pending.contains("\r\n\r\n");
+            if (!complete && pending.size() <= kMaxRequestBytes)
+                return; // wait for the rest of the headers
+            socket->setProperty("answered", true);
+            const QByteArray response = complete
+                ? respond(pending, *m_metrics)
+                : httpResponse("431 Request Header Fields Too Large", "text/plain", "request too large\n");
+            socket->write(response);
+            socket->disconnectFromHost();
+        });
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef METRICSSERVER_H
+#define METRICSSERVER_H
+
+#include <QByteArray>
+#include <QHostAddress>
+#include <QObject>
+#include <QThread>
+#include <memory>
+#include "streammetrics.h"
+
+class QTcpServer;
+
+// Minimal HTTP endpoint for Prometheus scrapes: GET /metrics answers with
+// StreamMetrics::render(), anything else with 404; one request per
+// connection. It listens and renders on its own thread, so a scrape (or a
+// slow scraper) costs the receive path nothing but the counters' atomics.
+class MetricsServer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MetricsServer(std::shared_ptr<const StreamMetrics> metrics, QObject* parent = nullptr);
+    ~MetricsServer() override; // stops
+
+    // Port 0 picks a free one (see port()); false when already running or
+    // the port can't be bound
+    bool start(quint16 port, const QHostAddress& address = QHostAddress::Any);
+    void stop();
+    bool isRunning() const;
+    quint16 port() const;
+
+    // Response to one raw HTTP request (status line, headers and body)
+    static QByteArray respond(const QByteArray& request, const StreamMetrics& metrics);
+
+private:
+    void onNewConnection();
+
+    std::shared_ptr<const StreamMetrics> m_metrics;
+    QThread m_thread;
+    QTcpServer* m_listener = nullptr; // lives on m_thread
+    quint16 m_port = 0;
+};
+
+#endif // METRICSSERVER_H
@@ -0,0 +1,189 @@
+#include "mosaicitem.h"
+#include "frametrace.h"
+#include "imageserverbridge.h"
+#include "mosaiclayout.h"
+#include <QQuickWindow>
+#include <QSGSimpleTextureNode>
+
+MosaicItem::MosaicItem(QQuickItem* parent)
+    : QQuickItem(parent)
+{
+    setFlag(ItemHasContents, true);
+}
+
+QObject* MosaicItem::bridge() const
+{
+    return m_bridge;
+}
+
+void MosaicItem::setBridge(QObject* bridge)
+{
+    ImageServerBridge* typed = qobject_cast<ImageServerBridge*>(bridge);
+    if (m_bridge == typed)
+        return;
+
+    if (m_bridge)
+        disconnect(m_bridge, nullptr, this, nullptr);
+    m_bridge = typed;
+
+    // Tiles of the previous bridge go away with their nodes
+    for (const Tile& tile : m_tiles) {
+        if (tile.node)
+            m_retired.append(tile.node);
+    }
+    m_tiles.clear();
+    m_layoutDirty = true;
+
+    if (m_bridge) {
+        connect(m_bridge, &ImageServerBridge::clientFrameReady, this, &MosaicItem::onClientFrame);
+        connect(m_bridge, &ImageServerBridge::clientDisconnectedWithAlias, this,
+                [this](const QString& clientId, const QString&) { onClientGone(clientId); });
+    }
+
+    emit bridgeChanged();
+    emit tileCountChanged();
+    update();
+}
+
+void MosaicItem::setColumns(int columns)
+{
+    columns = qMax(0, columns);
+    if (m_columns == columns)
+        return;
+    m_columns = columns;
+    m_layoutDirty = true;
+    emit columnsChanged();
+    update();
+}
+
+void MosaicItem::setSpacing(qreal spacing)
+{
+    if (qFuzzyCompare(m_spacing, spacing))
+        return;
+    m_spacing = spacing;
+    m_layoutDirty = true;
+    emit spacingChanged();
+    update();
+}
+
+int MosaicItem::indexOf(const QString& clientId) const
+{
+    for (int i = 0; i < m_tiles.size(); ++i) {
+        if (m_tiles.at(i).clientId == clientId)
+            return i;
+    }
+    return -1;
+}
+
+void MosaicItem::onClientFrame(const QString& clientId, const QImage& frame)
+{
+    if (frame.isNull())
+        return;
+
+    int idx = indexOf(clientId);
+    if (idx < 0) {
+        Tile tile;
+        tile.clientId = clientId;
+        m_tiles.append(tile);
+        idx = m_tiles.size() - 1;
+        m_layoutDirty = true;
+        emit tileCountChanged();
+    }
+
+    Tile& tile = m_tiles[idx];
+    if (tile.size != frame.size())
+        m_layoutDirty = true;
+    tile.size = frame.size();
+    tile.pending = frame; // shares the decoder's pixels; a newer frame simply replaces it
+    update();
+}
+
+void MosaicItem::onClientGone(const QString& clientId)
+{
+    const int idx = indexOf(clientId);
+    if (idx < 0)
+        return;
+    if (m_tiles.at(idx).node)
+        m_retired.append(m_tiles.at(idx).node);
+    m_tiles.removeAt(idx);
+    m_layoutDirty = true;
+    emit tileCountChanged();
+    update();
+}
+
+void MosaicItem::geometryChanged(const QRectF& newGeometry, const QRectF& oldGeometry)
+{
+    QQuickItem::geometryChanged(newGeometry, oldGeometry);
+    if (newGeometry.size() != oldGeometry.size()) {
+        m_layoutDirty = true;
+        update();
+    }
+}
+
+void MosaicItem::releaseResources()
+{
+    // The scene graph is going away (window change): nodes are destroyed with it
+    for (Tile& tile : m_tiles)
+        tile.node = nullptr;
+    m_retired.clear();
+    m_layoutDirty = true;
+}
+
+// Runs on the render thread while the GUI thread is blocked, so the tile list can
+// be read and updated here without locking.
+QSGNode* MosaicItem::updatePaintNode(QSGNode* oldNode, UpdatePaintNodeData* data)
+{
+    Q_UNUSED(data);
+    FrameTrace::setThreadName("render");
+    FrameTraceScope trace("render mosaic", "server");
+
+    QSGNode* root = oldNode;
+    if (!root) {
+        root = new QSGNode();
+        // A fresh root means no node of ours survived
+        for (Tile& tile : m_tiles)
+            tile.node = nullptr;
+        m_retired.clear();
+        m_layoutDirty = true;
+    }
+
+    for (QSGSimpleTextureNode* node : m_retired) {
+        root->removeChildNode(node);
+        delete node;
+    }
+    m_retired.clear();
+
+    for (Tile& tile : m_tiles) {
+        if (tile.pending.isNull())
+            continue;
+        // Straight upload of the decoded RGB32 frame; scaling happens in the shader
+        QSGTexture* texture = window()->createTextureFromImage(tile.pending, QQuickWindow::TextureIsOpaque);
+        tile.pending = QImage(); // let the decoder recycle the pixels
+        if (!texture)
+            continue;
+        if (!tile.node) {
+            tile.node = new QSGSimpleTextureNode();
+            tile.node->setOwnsTexture(true);
+            tile.node->setFiltering(QSGTexture::Linear);
+            root->appendChildNode(tile.node);
+            m_layoutDirty = true;
+        }
+        tile.node->setTexture(texture); // deletes the previous texture (owned)
+    }
+
+    if (m_layoutDirty) {
+        const int count = m_tiles.size();
+        const int columns = m_columns > 0 ? m_columns : mosaicColumns(count, width(), height());
+        for (int i = 0; i < count; ++i) {
+            Tile& tile = m_tiles[i];
+            if (!tile.node)
+                continue;
+            const MosaicRect cell = mosaicCell(i, count, columns, width(), height(), m_spacing);
+            const MosaicRect rect = fitInCell(cell, tile.size.width(), tile.size.height());
+            tile.node->setRect(QRectF(rect.x, rect.y, rect.width, rect.height));
+        }
+        m_layoutDirty = false;
+    }
+
+    return root;
+}
@@ -0,0 +1,75 @@
+#ifndef MOSAICITEM_H
+#define MOSAICITEM_H
+
+#include <QImage>
+#include <QPointer>
+#include <QQuickItem>
+#include <QVector>
+
+class ImageServerBridge;
+class QSGSimpleTextureNode;
+
+// Multi-client video wall drawn in one scene-graph subtree.
+// Each client's latest decoded frame is uploaded as-is to its own texture on the
+// render thread; the GPU scales and letterboxes it into a grid cell. Nothing is
+// scaled or composited on the CPU, and frames received between two renders
+// replace each other without being uploaded.
+//
+// QML: MosaicView { bridge: imageSocket } (see ImageServerBridge::mosaicMode)
+class MosaicItem : public QQuickItem
+{
+    Q_OBJECT
+    Q_PROPERTY(QObject* bridge READ bridge WRITE setBridge NOTIFY bridgeChanged)
+    Q_PROPERTY(int columns READ columns WRITE setColumns NOTIFY columnsChanged)
+    Q_PROPERTY(qreal spacing READ spacing WRITE setSpacing NOTIFY spacingChanged)
+    Q_PROPERTY(int tileCount READ tileCount NOTIFY tileCountChanged)
+
+public:
+    explicit MosaicItem(QQuickItem* parent = nullptr);
+
+    QObject* bridge() const;
+    void setBridge(QObject* bridge);
+
+    // Fixed column count; 0 picks the layout with the largest tiles
+    int columns() const { return m_columns; }
+    void setColumns(int columns);
+
+    qreal spacing() const { return m_spacing; }
+    void setSpacing(qreal spacing);
+
+    int tileCount() const { return m_tiles.size(); }
+
+signals:
+    void bridgeChanged();
+    void columnsChanged();
+    void spacingChanged();
+    void tileCountChanged();
+
+protected:
+    QSGNode* updatePaintNode(QSGNode* oldNode, UpdatePaintNodeData* data) override;
+    void geometryChanged(const QRectF& newGeometry, const QRectF& oldGeometry) override;
+    void releaseResources() override;
+
+private slots:
+    void onClientFrame(const QString& clientId, const QImage& frame);
+    void onClientGone(const QString& clientId);
+
+private:
+    struct Tile {
+        QString clientId;
+        QImage pending;                       // frame waiting for upload (released once uploaded)
+        QSize size;                           // size of the latest frame
+        QSGSimpleTextureNode* node = nullptr; // owned by the scene graph (render thread)
+    };
+
+    int indexOf(const QString& clientId) const;
+
+    QPointer<ImageServerBridge> m_bridge;
+    QVector<Tile> m_tiles;
+    QVector<QSGSimpleTextureNode*> m_retired; // nodes of removed tiles, deleted on the next sync
+    bool m_layoutDirty = true;
+    int m_columns = 0;
+    qreal m_spacing = 4.0;
+};
+
+#endif // MOSAICITEM_H
@@ -0,0 +1,66 @@
+#ifndef MOSAICLAYOUT_H
+#define MOSAICLAYOUT_H
+
+#include <algorithm>
+
+// Rectangle in item coordinates
+struct MosaicRect {
+    double x = 0.0;
+    double y = 0.0;
+    double width = 0.0;
+    double height = 0.0;
+};
+
+// Column count that gives `count` tiles of aspect `tileAspect` (w/h) the largest
+// size inside a `width` x `height` area
+inline int mosaicColumns(int count, double width, double height, double tileAspect = 16.0 / 9.0)
+{
+    if (count <= 1 || width <= 0.0 || height <= 0.0)
+        return 1;
+
+    int best = 1;
+    double bestTileWidth = -1.0;
+    for (int columns = 1; columns <= count; ++columns) {
+        const int rows = (count + columns - 1) / columns;
+        const double tileWidth = std::min(width / columns, (height / rows) * tileAspect);
+        if (tileWidth > bestTileWidth) {
+            bestTileWidth = tileWidth;
+            best = columns;
+        }
+    }
+    return best;
+}
+
+// Cell `index` of a `columns`-wide grid of `count` cells filling the area, with
+// `spacing` between cells
+inline MosaicRect mosaicCell(int index, int count, int columns, double width, double height, double spacing = 0.0)
+{
+    columns = std::max(1, columns);
+    const int rows = std::max(1, (count + columns - 1) / columns);
+    const double cellWidth = std::max(0.0, (width - spacing * (columns - 1)) / columns);
+    const double cellHeight = std::max(0.0, (height - spacing * (rows - 1)) / rows);
+
+    MosaicRect cell;
+    cell.x = (index % columns) * (cellWidth + spacing);
+    cell.y = (index / columns) * (cellHeight + spacing);
+    cell.width = cellWidth;
+    cell.height = cellHeight;
+    return cell;
+}
+
+// Largest rectangle with the image's aspect ratio centered in `cell` (letterboxed)
+inline MosaicRect fitInCell(const MosaicRect& cell, int imageWidth, int imageHeight)
+{
+    if (imageWidth <= 0 || imageHeight <= 0 || cell.width <= 0.0 || cell.height <= 0.0)
+        return MosaicRect{cell.x, cell.y, 0.0, 0.0};
+
+    const double scale = std::min(cell.width / imageWidth, cell.height / imageHeight);
+    MosaicRect fitted;
+    fitted.width = imageWidth * scale;
+    fitted.height = imageHeight * scale;
+    fitted.x = cell.x + (cell.width - fitted.width) / 2.0;
+    fitted.y = cell.y + (cell.height - fitted.height) / 2.0;
+    return fitted;
+}
+
+#endif // MOSAICLAYOUT_H
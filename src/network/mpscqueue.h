@@ -0,0 +1,101 @@
+#ifndef MPSCQUEUE_H
+#define MPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+// Unbounded multi-producer, single-consumer queue (Vyukov's linked queue with
+// a stub node). push() is wait-free: one allocation, an exchange and a store, from
+// any thread. take() belongs to one consumer thread and never waits either.
+//
+// An item whose push() has not returned yet may be invisible to take() even
+// though later pushes are not. A consumer woken by the producers after their
+// push() returns still finds every item: the push that was cut short sends
+// its own wake-up.
+template <typename T>
+class MpscQueue
+{
+public:
+    MpscQueue() : m_head(&m_stub), m_tail(&m_stub) {}
+
+    ~MpscQueue()
+    {
+        T discarded;
+        while (take(discarded)) {
+        }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    // Any thread
+    void push(T value) { link(new Node(std::move(value))); }
+
+    // Consumer thread: the oldest visible item; false when there is none
+    bool take(T& out)
+    {
+        Node* tail = m_tail;
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (tail == &m_stub) {
+            if (!next)
+                return false;
+            // Skip the stub; it is pushed back once the last node is reached
+            m_tail = next;
+            tail = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next) {
+            m_tail = next;
+            out = std::move(tail->value);
+            delete tail;
+            return true;
+        }
+        if (tail != m_head.load(std::memory_order_acquire))
+            return false; // a push is linking its node
+        // `tail` is the last node: re-append the stub so it can be unlinked
+        m_stub.next.store(nullptr, std::memory_order_relaxed);
+        link(&m_stub);
+        next = tail->next.load(std::memory_order_acquire);
+        if (!next)
+            return false; // another push came in between
+        m_tail = next;
+        out = std::move(tail->value);
+        delete tail;
+        return true;
+    }
+
+    // Consumer thread: hands up to `max` items to `sink`, oldest first;
+    // returns how many
+    template <typename Sink>
+    std::size_t drain(Sink&& sink, std::size_t max = static_cast<std::size_t>(-1))
+    {
+        std::size_t count = 0;
+        T value;
+        while (count < max && take(value)) {
+            sink(std::move(value));
+            ++count;
+        }
+        return count;
+    }
+
+private:
+    struct Node {
+        Node() = default;
+        explicit Node(T&& item) : value(std::move(item)) {}
+        std::atomic<Node*> next{nullptr};
+        T value;
+    };
+
+    void link(Node* node)
+    {
+        Node* previous = m_head.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+    }
+
+    Node m_stub;
+    std::atomic<Node*> m_head; // last pushed node, written by producers
+    Node* m_tail;              // next node to take, consumer only
+};
+
+#endif // MPSCQUEUE_H
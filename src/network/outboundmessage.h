@@ -0,0 +1,81 @@
+#ifndef OUTBOUNDMESSAGE_H
+#define OUTBOUNDMESSAGE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "frameheader.h"
+
+// Caller-owned frame bytes that can be handed to the client without copying
+using SharedFrameBuffer = std::shared_ptr<const std::vector<std::uint8_t>>;
+
+// Wire prefix identifying the message type (sent as its own buffer)
+enum class MessagePrefix : std::uint8_t {
+    Image = 0x00,
+    Control = 0x01,
+    RawFrame = 0x02,    // uncompressed YUV, see rawframe.h
+    Video = 0x03,       // H.264 / H.265 packet, see videopacket.h
+    Framed = 0x04,      // FrameHeader then one of the payloads above, see frameheader.h
+    ControlBatch = 0x05 // several control messages in one (ControlBatch), see controlmessage.h
+};
+
+// One queued WebSocket message: a prefix byte plus a view of the payload.
+// `owner` keeps the payload storage alive until the write completes; the
+// payload is never copied into a prefixed buffer, the two are written as a
+// scatter/gather sequence instead. A frame may also carry a FrameHeader: it
+// is written between the two (the wire prefix is then 0x04) and `prefix`
+// keeps naming the payload.
+struct OutboundMessage {
+    std::shared_ptr<const void> owner;
+    const std::uint8_t* data = nullptr;
+    std::size_t size = 0;
+    MessagePrefix prefix = MessagePrefix::Image;
+    std::array<std::uint8_t, kFrameHeaderSize> header{};
+    std::size_t headerSize = 0; // 0 == no FrameHeader
+
+    void setFrameHeader(const FrameHeader& frameHeader)
+    {
+        writeFrameHeader(frameHeader, header.data());
+        headerSize = kFrameHeaderSize;
+    }
+
+    // Take ownership of a buffer (moved, no copy)
+    static OutboundMessage fromVector(std::vector<std::uint8_t>&& bytes, MessagePrefix prefix)
+    {
+        return fromShared(std::make_shared<const std::vector<std::uint8_t>>(std::move(bytes)), prefix);
+    }
+
+    // Share a buffer with the caller; it must not be modified until released
+    static OutboundMessage fromShared(SharedFrameBuffer bytes, MessagePrefix prefix)
+    {
+        OutboundMessage msg;
+        if (bytes) {
+            msg.data = bytes->data();
+            msg.size = bytes->size();
+        }
+        msg.owner = std::move(bytes);
+        msg.prefix = prefix;
+        return msg;
+    }
+
+    // Any other owning type (QByteArray, std::string...) holding contiguous bytes
+    template <typename Owner>
+    static OutboundMessage fromOwner(std::shared_ptr<Owner> owner, const void* data,
+                                     std::size_t size, MessagePrefix prefix)
+    {
+        OutboundMessage msg;
+        msg.owner = std::move(owner);
+        msg.data = static_cast<const std::uint8_t*>(data);
+        msg.size = size;
+        msg.prefix = prefix;
+        return msg;
+    }
+
+    // Bytes on the wire, prefix and frame header included
+    std::size_t wireSize() const { return size + headerSize + 1; }
+};
+
+#endif // OUTBOUNDMESSAGE_H
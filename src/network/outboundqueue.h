@@ -0,0 +1,183 @@
+#ifndef OUTBOUNDQUEUE_H
+#define OUTBOUNDQUEUE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <utility>
+
+// What to do with frames once the outbound queue holds `depth` of them
+enum class OutboundDropPolicy {
+    DropOldest,                   // evict the oldest queued frame (freshest frames win)
+    DropNewest,                   // reject the incoming frame
+    DropNewestWhileControlPending // drop-oldest normally, reject new frames while a control message waits
+};
+
+// Outcome of handing a message to the client's send path
+enum class SendStatus {
+    Queued,       // accepted; written as soon as the previous write completes
+    Dropped,      // rejected by the drop policy (link saturated)
+    NotConnected, // no open connection
+    Paused        // the server paused this client; frames are not sent
+};
+
+// Snapshot returned by WebSocketImageClient::sendFrame / sendQueueState
+struct SendResult {
+    SendStatus status = SendStatus::NotConnected;
+    std::size_t queuedFrames = 0; // frames waiting or in flight after this call
+    std::size_t depth = 0;        // configured frame capacity
+    std::size_t evicted = 0;      // older frames dropped to make room by this call
+
+    bool accepted() const { return status == SendStatus::Queued; }
+    bool connected() const { return status != SendStatus::NotConnected; }
+    bool paused() const { return status == SendStatus::Paused; }
+    // True when the next frame would not fit: callers can skip encoding it
+    bool saturated() const { return queuedFrames >= depth; }
+};
+
+// Serialized outbound message queue for a single WebSocket stream.
+// Beast allows one outstanding async_write per stream, so the owner takes
+// front(), marks it in flight with beginWrite(), and calls finishWrite() from
+// the completion handler before starting the next one. Control messages
+// waiting together at the front can go out as one write (a ControlBatch):
+// beginWrite(leadingControl()) puts all of them in flight.
+//
+// Control messages are never dropped and jump ahead of queued frames (but not
+// of the message in flight). Only frames count against the depth, including a
+// frame in flight, so depth 2 means "one on the wire plus the latest waiting".
+//
+// Not synchronized: the owner guards it with its own lock.
+template <typename Buffer>
+class OutboundQueue
+{
+public:
+    explicit OutboundQueue(std::size_t depth = 2,
+                           OutboundDropPolicy policy = OutboundDropPolicy::DropOldest)
+        : m_depth(depth > 0 ? depth : 1), m_policy(policy)
+    {
+    }
+
+    // Queue a frame according to the drop policy; `evicted` receives the number
+    // of older frames dropped to make room. Returns false if the frame was rejected.
+    bool pushFrame(Buffer data, std::size_t* evicted = nullptr)
+    {
+        std::size_t dropped = 0;
+        if (m_frames >= m_depth) {
+            const bool rejectNew = m_policy == OutboundDropPolicy::DropNewest
+                || (m_policy == OutboundDropPolicy::DropNewestWhileControlPending && controlPending());
+            if (rejectNew || !evictOldestFrame()) {
+                ++m_droppedTotal;
+                if (evicted) *evicted = 0;
+                return false;
+            }
+            dropped = 1;
+        }
+
+        m_items.push_back(Item{std::move(data), false});
+        ++m_frames;
+        m_droppedTotal += dropped;
+        if (evicted) *evicted = dropped;
+        return true;
+    }
+
+    // Queue a control message ahead of all waiting frames
+    void pushControl(Buffer data)
+    {
+        auto it = m_items.begin() + static_cast<std::ptrdiff_t>(m_inFlight); // never preempt what is being written
+        while (it != m_items.end() && it->control)
+            ++it; // keep control messages in FIFO order
+        m_items.insert(it, Item{std::move(data), true});
+    }
+
+    // Next message to write; only valid when !empty()
+    const Buffer& front() const { return m_items.front().data; }
+    bool frontIsControl() const { return m_items.front().control; }
+    // Message `index` from the front; only valid when index < size()
+    const Buffer& at(std::size_t index) const { return m_items[index].data; }
+
+    // Control messages at the front, up to `max`: what one write can batch
+    std::size_t leadingControl(std::size_t max) const
+    {
+        std::size_t count = 0;
+        while (count < max && count < m_items.size() && m_items[count].control)
+            ++count;
+        return count;
+    }
+
+    // The `count` messages at the front go out in one write (several only for leading control)
+    void beginWrite(std::size_t count = 1) { m_inFlight = count < m_items.size() ? count : m_items.size(); }
+
+    // Completion of the write started by beginWrite(): releases its messages
+    void finishWrite()
+    {
+        for (; m_inFlight > 0 && !m_items.empty(); --m_inFlight) {
+            if (!m_items.front().control)
+                --m_frames;
+            m_items.pop_front();
+        }
+        m_inFlight = 0;
+    }
+
+    // Drop every frame not yet on the wire (control messages stay); returns how many
+    std::size_t dropWaitingFrames()
+    {
+        std::size_t dropped = 0;
+        while (evictOldestFrame())
+            ++dropped;
+        m_droppedTotal += dropped;
+        return dropped;
+    }
+
+    void clear()
+    {
+        m_items.clear();
+        m_frames = 0;
+        m_inFlight = 0;
+    }
+
+    void setDepth(std::size_t depth) { m_depth = depth > 0 ? depth : 1; }
+    void setPolicy(OutboundDropPolicy policy) { m_policy = policy; }
+
+    std::size_t depth() const { return m_depth; }
+    OutboundDropPolicy policy() const { return m_policy; }
+    std::size_t frameCount() const { return m_frames; }
+    std::size_t size() const { return m_items.size(); }
+    bool empty() const { return m_items.empty(); }
+    bool writing() const { return m_inFlight > 0; }
+    bool saturated() const { return m_frames >= m_depth; }
+    std::uint64_t droppedTotal() const { return m_droppedTotal; }
+
+    // A control message is queued but not yet on the wire
+    bool controlPending() const
+    {
+        return m_items.size() > m_inFlight && m_items[m_inFlight].control;
+    }
+
+private:
+    struct Item {
+        Buffer data;
+        bool control;
+    };
+
+    bool evictOldestFrame()
+    {
+        // The in-flight buffers must stay alive until their handler runs
+        for (auto it = m_items.begin() + static_cast<std::ptrdiff_t>(m_inFlight); it != m_items.end(); ++it) {
+            if (!it->control) {
+                m_items.erase(it);
+                --m_frames;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::size_t m_depth;
+    OutboundDropPolicy m_policy;
+    std::deque<Item> m_items;
+    std::size_t m_frames = 0;
+    std::size_t m_inFlight = 0; // messages of the write in progress, at the front
+    std::uint64_t m_droppedTotal = 0;
+};
+
+#endif // OUTBOUNDQUEUE_H
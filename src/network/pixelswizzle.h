@@ -0,0 +1,80 @@
+#ifndef PIXELSWIZZLE_H
+#define PIXELSWIZZLE_H
+
+#include <cstdint>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define PIXELSWIZZLE_SSSE3 1
+#include <tmmintrin.h>
+#elif defined(__ARM_NEON) && (!defined(__BYTE_ORDER__) || __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define PIXELSWIZZLE_NEON 1
+#include <arm_neon.h>
+#endif
+
+// Packed 8-bit BGR (OpenCV's layout) to 32-bit 0xffRRGGBB pixels
+// (QImage::Format_RGB32), which the scene graph uploads as is: for sources
+// that only deliver BGR (VideoCapture), this one pass replaces both a
+// BGR->RGB conversion and the RGB888->RGBA conversion Qt would do on upload.
+// Little-endian RGB32 is B, G, R, 0xff in memory, so the pass only inserts
+// the alpha byte: 16 pixels per NEON step, 4 per SSSE3 shuffle (chosen at
+// run time), plain C++ elsewhere and for the last pixels of each row.
+
+namespace swizzle_detail {
+
+inline void bgrToRgb32Row(const std::uint8_t* src, std::uint32_t* dst, int from, int width)
+{
+    for (int x = from; x < width; ++x) {
+        const std::uint8_t* pixel = src + x * 3;
+        dst[x] = 0xFF000000u | (std::uint32_t(pixel[2]) << 16) | (std::uint32_t(pixel[1]) << 8) | pixel[0];
+    }
+}
+
+#ifdef PIXELSWIZZLE_SSSE3
+__attribute__((target("ssse3"))) inline int bgrToRgb32RowSsse3(const std::uint8_t* src, std::uint32_t* dst, int width)
+{
+    const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+    int x = 0;
+    // Each load takes 16 bytes for 4 pixels (12 bytes): stop while 6 are left
+    for (; x + 6 <= width; x += 4) {
+        const __m128i bgr = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * 3));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm_or_si128(_mm_shuffle_epi8(bgr, shuffle), alpha));
+    }
+    return x;
+}
+
+inline bool haveSsse3()
+{
+    static const bool supported = __builtin_cpu_supports("ssse3");
+    return supported;
+}
+#endif
+
+} // namespace swizzle_detail
+
+// `width` x `height` pixels; `dst` rows hold at least width * 4 bytes
+inline void bgrToRgb32(const std::uint8_t* src, int srcStride, std::uint8_t* dst, int dstStride, int width, int height)
+{
+    for (int row = 0; row < height; ++row) {
+        const std::uint8_t* in = src + static_cast<std::intptr_t>(row) * srcStride;
+        std::uint32_t* out = reinterpret_cast<std::uint32_t*>(dst + static_cast<std::intptr_t>(row) * dstStride);
+        int done = 0;
+#if defined(PIXELSWIZZLE_SSSE3)
+        if (swizzle_detail::haveSsse3())
+            done = swizzle_detail::bgrToRgb32RowSsse3(in, out, width);
+#elif defined(PIXELSWIZZLE_NEON)
+        for (; done + 16 <= width; done += 16) {
+            const uint8x16x3_t bgr = vld3q_u8(in + done * 3);
+            uint8x16x4_t bgra;
+            bgra.val[0] = bgr.val[0];
+            bgra.val[1] = bgr.val[1];
+            bgra.val[2] = bgr.val[2];
+            bgra.val[3] = vdupq_n_u8(0xFF);
+            vst4q_u8(reinterpret_cast<std::uint8_t*>(out + done), bgra);
+        }
+#endif
+        swizzle_detail::bgrToRgb32Row(in, out, done, width);
+    }
+}
+
+#endif // PIXELSWIZZLE_H
@@ -0,0 +1,186 @@
+#ifndef PREROLLRING_H
+#define PREROLLRING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+#include "recordingsegment.h"
+
+// The last seconds of one client's stream, compressed, for event clips: when
+// something happens the clip starts before it. Frames are kept as received,
+// already laid out as recorder records (recordingsegment.h), in one slab
+// allocated up front, so a camera costs a fixed amount of memory whatever its
+// bitrate and exporting is a copy of the records into a segment file.
+//
+// The slab is used as a ring: a record that doesn't fit before the slab's end
+// starts over at its beginning, and the oldest records make room for the
+// newest. Records older than the window go even when there is room. Exports
+// start at a keyframe, so a video clip is decodable from its first frame.
+//
+// Not thread-safe.
+class PrerollRing
+{
+public:
+    PrerollRing() = default;
+    PrerollRing(std::size_t capacityBytes, std::int64_t windowUs) { configure(capacityBytes, windowUs); }
+
+    // Empties the ring; capacity 0 frees the slab. windowUs 0: as much as fits.
+    void configure(std::size_t capacityBytes, std::int64_t windowUs)
+    {
+        m_capacity = capacityBytes & ~(kRecordAlignment - 1);
+        m_slab.reset(m_capacity > 0 ? new std::uint8_t[m_capacity] : nullptr);
+        m_windowUs = windowUs > 0 ? windowUs : 0;
+        clear();
+    }
+
+    void clear()
+    {
+        m_records.clear();
+        m_head = 0;
+        m_bytes = 0;
+    }
+
+    std::size_t capacity() const { return m_capacity; }
+    std::int64_t windowUs() const { return m_windowUs; }
+    std::size_t frameCount() const { return m_records.size(); }
+    // Record bytes held, headers and padding included
+    std::size_t bytesUsed() const { return m_bytes; }
+    std::int64_t oldestTimestampUs() const { return m_records.empty() ? 0 : m_records.front().timestampUs; }
+    std::int64_t newestTimestampUs() const { return m_records.empty() ? 0 : m_records.back().timestampUs; }
+    // Frames pushed out by newer ones or by the window
+    std::uint64_t evicted() const { return m_evicted; }
+    // Frames larger than the whole slab, never kept
+    std::uint64_t rejected() const { return m_rejected; }
+
+    // Keeps the frame, dropping the oldest ones as needed
+    bool push(const RecordHeader& header, const void* payload)
+    {
+        const std::size_t span = recordSpan(header.payloadSize);
+        if (span > m_capacity) {
+            ++m_rejected;
+            return false;
+        }
+        while (!m_records.empty() && m_windowUs > 0 && header.timestampUs - m_records.front().timestampUs > m_windowUs)
+            evictOldest();
+        std::size_t offset = 0;
+        while (!place(span, offset))
+            evictOldest();
+        writeRecord(header, payload, m_slab.get() + offset);
+        m_head = offset + span;
+        m_bytes += span;
+        m_records.push_back(Entry{offset, span, header.timestampUs, header.keyframe});
+        return true;
+    }
+
+    // Calls visit(record, span) for the records of a clip, oldest first: from
+    // the first keyframe at or after `fromUs` (its timestamp, not the ring's
+    // order, decides) to the newest frame. Returns how many were visited.
+    template <typename Visitor>
+    std::size_t forEachFrom(std::int64_t fromUs, Visitor&& visit) const
+    {
+        std::size_t visited = 0;
+        bool started = false;
+        for (const Entry& entry : m_records) {
+            if (!started && (entry.timestampUs < fromUs || !entry.keyframe))
+                continue;
+            started = true;
+            visit(static_cast<const std::uint8_t*>(m_slab.get() + entry.offset), entry.span);
+            ++visited;
+        }
+        return visited;
+    }
+
+    // The clip from `fromUs` (see forEachFrom()) as a complete recorder
+    // segment and its index, one entry per `indexIntervalUs` of stream time.
+    // Returns the frame count; 0 leaves both empty.
+    std::size_t exportSegment(std::int64_t fromUs, std::int64_t indexIntervalUs, std::vector<std::uint8_t>& segment,
+                              std::vector<std::uint8_t>& index) const
+    {
+        segment.clear();
+        index.clear();
+        SegmentHeader header;
+        std::int64_t nextIndexUs = 0;
+        segment.resize(kSegmentHeaderSize);
+        forEachFrom(fromUs, [&](const std::uint8_t* record, std::size_t span) {
+            const std::int64_t timestampUs = static_cast<std::int64_t>(frameheader_detail::readLe(record + 8, 8));
+            if (header.records == 0 || timestampUs >= nextIndexUs) {
+                IndexEntry entry;
+                entry.timestampUs = timestampUs;
+                entry.offset = segment.size();
+                index.resize(index.size() + kIndexEntrySize);
+                writeIndexEntry(entry, index.data() + index.size() - kIndexEntrySize);
+                nextIndexUs = timestampUs + (indexIntervalUs > 0 ? indexIntervalUs : 1);
+            }
+            segment.insert(segment.end(), record, record + span);
+            if (header.records == 0)
+                header.firstTimestampUs = timestampUs;
+            header.lastTimestampUs = timestampUs;
+            ++header.records;
+        });
+        if (header.records == 0) {
+            segment.clear();
+            return 0;
+        }
+        header.used = segment.size();
+        writeSegmentHeader(header, segment.data());
+        return header.records;
+    }
+
+private:
+    struct Entry {
+        std::size_t offset;
+        std::size_t span;
+        std::int64_t timestampUs;
+        bool keyframe;
+    };
+
+    // Where `span` bytes go without touching a kept record
+    bool place(std::size_t span, std::size_t& offset)
+    {
+        if (m_records.empty()) {
+            offset = 0;
+            return true;
+        }
+        const std::size_t tail = m_records.front().offset;
+        if (m_head > tail) {
+            // Records lie between tail and head: room after head, else at the start
+            if (m_capacity - m_head >= span) {
+                offset = m_head;
+                return true;
+            }
+            if (tail >= span) {
+                offset = 0;
+                return true;
+            }
+            return false;
+        }
+        // Wrapped: room between head and the oldest record
+        if (tail - m_head >= span) {
+            offset = m_head;
+            return true;
+        }
+        return false;
+    }
+
+    void evictOldest()
+    {
+        m_bytes -= m_records.front().span;
+        m_records.pop_front();
+        ++m_evicted;
+        if (m_records.empty())
+            m_head = 0;
+    }
+
+    std::unique_ptr<std::uint8_t[]> m_slab;
+    std::size_t m_capacity = 0;
+    std::int64_t m_windowUs = 0;
+    std::deque<Entry> m_records;
+    std::size_t m_head = 0;
+    std::size_t m_bytes = 0;
+    std::uint64_t m_evicted = 0;
+    std::uint64_t m_rejected = 0;
+};
+
+#endif // PREROLLRING_H
@@ -0,0 +1,55 @@
+#ifndef PROCESSCPU_H
+#define PROCESSCPU_H
+
+#include <chrono>
+#include <cstdint>
+#ifdef __unix__
+#include <sys/resource.h>
+#endif
+
+// CPU used by this process (all threads, user + system) between two
+// sample() calls, in percent of one core: 250 means two and a half cores
+// were busy. -1 where the platform doesn't report it.
+class ProcessCpuMeter
+{
+public:
+    ProcessCpuMeter() { m_lastCpuUs = cpuTimeUs(); m_lastWallUs = wallTimeUs(); }
+
+    double sample()
+    {
+        const std::int64_t cpu = cpuTimeUs();
+        const std::int64_t wall = wallTimeUs();
+        if (cpu < 0)
+            return -1.0;
+        const std::int64_t elapsed = wall - m_lastWallUs;
+        const double percent = elapsed > 0 ? 100.0 * static_cast<double>(cpu - m_lastCpuUs) / elapsed : 0.0;
+        m_lastCpuUs = cpu;
+        m_lastWallUs = wall;
+        return percent;
+    }
+
+    static std::int64_t cpuTimeUs()
+    {
+#ifdef __unix__
+        rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0)
+            return -1;
+        const auto us = [](const timeval& t) { return static_cast<std::int64_t>(t.tv_sec) * 1000000 + t.tv_usec; };
+        return us(usage.ru_utime) + us(usage.ru_stime);
+#else
+        return -1;
+#endif
+    }
+
+private:
+    static std::int64_t wallTimeUs()
+    {
+        using namespace std::chrono;
+        return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+    }
+
+    std::int64_t m_lastCpuUs = 0;
+    std::int64_t m_lastWallUs = 0;
+};
+
+#endif // PROCESSCPU_H
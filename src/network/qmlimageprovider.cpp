@@ -1,6 +1,8 @@
 #include "qmlimageprovider.h"
+#include "frametrace.h"
 #include "imageserverbridge.h"
 #include <QImage>
+#include <QUrl>
 
 QmlImageProvider::QmlImageProvider(ImageServerBridge* bridge)
     : QQuickImageProvider(QQuickImageProvider::Image), m_bridge(bridge)
@@ -10,14 +12,37 @@ QmlImageProvider::QmlImageProvider(ImageServerBridge* bridge)
 QImage QmlImageProvider::requestImage(const QString &id, QSize *size, const QSize &requestedSize)
 {
     Q_UNUSED(id);
-    Q_UNUSED(requestedSize);
+    FrameTraceScope trace("provider request", "server");
 
     if (!m_bridge)
         return QImage();
+    // Frames are decoded no smaller than what the Image asks for
+    m_bridge->noteRequestedFrameSize(requestedSize);
 
     QImage frame = m_bridge->lastFrame();
     if (size && !frame.isNull()) {
         *size = frame.size();
     }
-    return frame;
+    return m_scaled.scaled(frame, requestedSize);
+}
+
+ThumbnailImageProvider::ThumbnailImageProvider(ImageServerBridge* bridge)
+    : QQuickImageProvider(QQuickImageProvider::Image), m_bridge(bridge)
+{
+}
+
+QImage ThumbnailImageProvider::requestImage(const QString &id, QSize *size, const QSize &requestedSize)
+{
+    Q_UNUSED(requestedSize);
+
+    if (!m_bridge)
+        return QImage();
+
+    // The trailing counter only busts QML's cache; the client id comes before it
+    const QString clientId = QUrl::fromPercentEncoding(id.section('/', 0, -2).toUtf8());
+    QImage thumbnail = m_bridge->thumbnail(clientId);
+    if (size && !thumbnail.isNull()) {
+        *size = thumbnail.size();
+    }
+    return thumbnail;
 }
@@ -2,6 +2,7 @@
 #define QMLIMAGEPROVIDER_H
 
 #include <QQuickImageProvider>
+#include "scaledimagecache.h"
 
 class ImageServerBridge;
 
@@ -12,6 +13,19 @@ public:
 
     QImage requestImage(const QString &id, QSize *size, const QSize &requestedSize) override;
 
+private:
+    ImageServerBridge* m_bridge;
+    ScaledImageCache m_scaled; // the frame at the Image's sourceSize
+};
+
+// Serves the latest thumbnail of each client: image://thumbnails/<clientId>/<thumbnailId>
+class ThumbnailImageProvider : public QQuickImageProvider
+{
+public:
+    explicit ThumbnailImageProvider(ImageServerBridge* bridge);
+
+    QImage requestImage(const QString &id, QSize *size, const QSize &requestedSize) override;
+
 private:
     ImageServerBridge* m_bridge;
 };
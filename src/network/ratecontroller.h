@@ -0,0 +1,227 @@
+#ifndef RATECONTROLLER_H
+#define RATECONTROLLER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+
+// Tuning for RateController (defaults suit MJPEG over Wi-Fi)
+struct RateControllerConfig {
+    int minQuality = 30;
+    int maxQuality = 90;
+    int initialQuality = 75;
+    int minFps = 5;
+    int targetDelayMs = 80;    // queueing delay the controller keeps the stream under
+    int intervalMs = 1000;     // evaluation period
+    int baseDelayWindowMs = 10000; // how long the uncongested (base) delay is remembered
+    int clearIntervalsBeforeIncrease = 3;
+};
+
+// Adjustments to push to the client after an evaluation
+struct RateDecision {
+    bool qualityChanged = false;
+    bool fpsChanged = false;
+    int quality = 0;
+    int fps = 0;
+
+    bool changed() const { return qualityChanged || fpsChanged; }
+};
+
+// Closed-loop MJPEG rate control for one client, LEDBAT style.
+//
+// The client reports its send timestamp and outbound queue depth periodically.
+// One-way delay = arrival - send time: the clock offset is unknown but constant,
+// so its minimum over a window is the base (empty-queue) delay and anything
+// above it is queueing. Round trips measured with PING/PONG are filtered the
+// same way and the larger of the two estimates is used: a PONG waits behind
+// the frames already in the client's socket, which the one-way delay of the
+// periodic reports can miss between two reports. Congestion lowers the JPEG quality first and, at the
+// floor, the frame rate; a sustained clear path raises the frame rate back to
+// the configured ceiling first and then the quality.
+//
+// Not synchronized; time is passed in (ms) so the controller is deterministic.
+class RateController
+{
+public:
+    explicit RateController(const RateControllerConfig& config = RateControllerConfig())
+        : m_config(config), m_quality(clampQuality(config.initialQuality))
+    {
+    }
+
+    // Frame-rate ceiling (the user's configured fps); 0 disables fps control
+    void setMaxFps(int fps)
+    {
+        m_maxFps = std::max(0, fps);
+        m_fps = m_maxFps;
+    }
+
+    // Quality ceiling below the configured maximum (the ingress budget); 0 lifts it
+    void setQualityCeiling(int quality)
+    {
+        m_qualityCeiling = std::max(0, quality);
+        m_quality = clampQuality(m_quality);
+    }
+
+    void onFrame(std::int64_t nowMs, std::size_t bytes)
+    {
+        (void)nowMs;
+        m_intervalBytes += bytes;
+        ++m_intervalFrames;
+    }
+
+    // Periodic client report: its send time (client clock) and outbound queue depth
+    void onReport(std::int64_t nowMs, std::int64_t senderTimestampMs, int clientQueuedFrames)
+    {
+        const std::int64_t owd = nowMs - senderTimestampMs;
+        m_intervalMinDelay = std::min(m_intervalMinDelay, owd);
+        m_clientQueued = std::max(0, clientQueuedFrames);
+        m_haveReport = true;
+    }
+
+    // Round trip of a PING/PONG exchange
+    void onRoundTrip(std::int64_t nowMs, std::int64_t rttMs)
+    {
+        (void)nowMs;
+        m_intervalMinRtt = std::min(m_intervalMinRtt, std::max<std::int64_t>(0, rttMs));
+        m_lastRttMs = static_cast<int>(std::max<std::int64_t>(0, rttMs));
+    }
+
+    // Re-evaluate once per interval; returns the adjustments to send (if any)
+    RateDecision evaluate(std::int64_t nowMs)
+    {
+        RateDecision decision;
+        decision.quality = m_quality;
+        decision.fps = m_fps;
+
+        if (m_lastEvalMs == 0) {
+            // First call starts the measurement interval
+            m_lastEvalMs = nowMs;
+            m_intervalBytes = 0;
+            m_intervalFrames = 0;
+            return decision;
+        }
+        const std::int64_t elapsed = nowMs - m_lastEvalMs;
+        if (elapsed < m_config.intervalMs)
+            return decision;
+
+        m_throughputBps = static_cast<double>(m_intervalBytes) * 1000.0 / static_cast<double>(elapsed);
+        m_measuredFps = static_cast<int>(m_intervalFrames * 1000 / elapsed);
+        updateQueueDelay(nowMs);
+
+        const bool haveDelay = m_queueDelayMs >= 0;
+        const bool queueFull = m_haveReport && m_clientQueued >= 2;
+        const bool congested = queueFull || (haveDelay && m_queueDelayMs > 2 * m_config.targetDelayMs);
+        const bool loaded = haveDelay && m_queueDelayMs > m_config.targetDelayMs;
+        const bool clear = !queueFull && (!haveDelay || m_queueDelayMs < m_config.targetDelayMs / 2);
+
+        const int oldQuality = m_quality;
+        const int oldFps = m_fps;
+
+        if (congested) {
+            m_clearIntervals = 0;
+            if (m_quality > m_config.minQuality)
+                m_quality = clampQuality(m_quality - 10);
+            else if (m_maxFps > 0)
+                m_fps = std::max(std::min(m_config.minFps, m_maxFps), m_fps * 3 / 4);
+        } else if (loaded) {
+            m_clearIntervals = 0;
+            m_quality = clampQuality(m_quality - 5);
+        } else if (clear) {
+            if (++m_clearIntervals >= m_config.clearIntervalsBeforeIncrease) {
+                if (m_maxFps > 0 && m_fps < m_maxFps)
+                    m_fps = std::min(m_maxFps, m_fps + std::max(1, m_maxFps / 10));
+                else
+                    m_quality = clampQuality(m_quality + 3);
+            }
+        }
+
+        decision.quality = m_quality;
+        decision.fps = m_fps;
+        decision.qualityChanged = m_quality != oldQuality;
+        decision.fpsChanged = m_fps != oldFps;
+
+        m_lastEvalMs = nowMs;
+        m_intervalBytes = 0;
+        m_intervalFrames = 0;
+        m_haveReport = false;
+        return decision;
+    }
+
+    int quality() const { return m_quality; }
+    int fps() const { return m_fps; }
+    int maxFps() const { return m_maxFps; }
+    double throughputBps() const { return m_throughputBps; }
+    int measuredFps() const { return m_measuredFps; }
+    // Estimated queueing delay in ms, -1 until the client has reported
+    int queueDelayMs() const { return m_queueDelayMs; }
+    // Latest PING/PONG round trip in ms, -1 until one completed
+    int rttMs() const { return m_lastRttMs; }
+
+private:
+    struct DelaySlot {
+        std::int64_t atMs;
+        std::int64_t minDelay;
+    };
+
+    int clampQuality(int quality) const
+    {
+        const int ceiling = m_qualityCeiling > 0 ? std::min(m_config.maxQuality, m_qualityCeiling) : m_config.maxQuality;
+        return std::max(m_config.minQuality, std::min(ceiling, quality));
+    }
+
+    // Delay of the latest interval above the window's minimum, -1 without samples
+    int delayAboveBase(std::int64_t nowMs, std::deque<DelaySlot>& slots, std::int64_t& intervalMin,
+                       std::int64_t& current) const
+    {
+        const std::int64_t none = std::numeric_limits<std::int64_t>::max();
+        if (intervalMin != none) {
+            slots.push_back(DelaySlot{nowMs, intervalMin});
+            current = intervalMin;
+        }
+        while (!slots.empty() && nowMs - slots.front().atMs > m_config.baseDelayWindowMs)
+            slots.pop_front();
+        intervalMin = none;
+
+        if (slots.empty())
+            return -1;
+        std::int64_t base = none;
+        for (const DelaySlot& slot : slots)
+            base = std::min(base, slot.minDelay);
+        return static_cast<int>(std::max<std::int64_t>(0, current - base));
+    }
+
+    void updateQueueDelay(std::int64_t nowMs)
+    {
+        const int oneWay = delayAboveBase(nowMs, m_slots, m_intervalMinDelay, m_currentDelay);
+        const int roundTrip = delayAboveBase(nowMs, m_rttSlots, m_intervalMinRtt, m_currentRtt);
+        m_queueDelayMs = std::max(oneWay, roundTrip);
+    }
+
+    RateControllerConfig m_config;
+    int m_qualityCeiling = 0;
+    int m_quality;
+    int m_maxFps = 0;
+    int m_fps = 0;
+
+    std::int64_t m_lastEvalMs = 0;
+    std::size_t m_intervalBytes = 0;
+    int m_intervalFrames = 0;
+    std::int64_t m_intervalMinDelay = std::numeric_limits<std::int64_t>::max();
+    std::int64_t m_currentDelay = 0;
+    std::deque<DelaySlot> m_slots;
+    std::int64_t m_intervalMinRtt = std::numeric_limits<std::int64_t>::max();
+    std::int64_t m_currentRtt = 0;
+    std::deque<DelaySlot> m_rttSlots;
+    int m_lastRttMs = -1;
+    int m_clientQueued = 0;
+    bool m_haveReport = false;
+    int m_clearIntervals = 0;
+
+    double m_throughputBps = 0.0;
+    int m_measuredFps = 0;
+    int m_queueDelayMs = -1;
+};
+
+#endif // RATECONTROLLER_H
@@ -0,0 +1,134 @@
+#ifndef RATEESTIMATOR_H
+#define RATEESTIMATOR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Frame rate and bitrate of one stream over a sliding window, for the model's
+// measured fps and bytes/s. Arrivals go into a ring allocated up front, each
+// with the running byte total, so adding a frame is a slot write and dropping
+// the ones that left the window is amortized constant.
+//
+// The rate is measured between the first and the last arrival in the window:
+// (n - 1) intervals over their span, exact for a steady stream, fractional,
+// and caught up with a new rate within one window. A stream that stops decays
+// with the silence once it exceeds one mean interval. Slow streams keep their
+// last few arrivals beyond the window (up to `maxSpanUs`), so a 1 fps camera
+// still measures 1 fps; a stream faster than the ring holds is measured over
+// the arrivals the ring has.
+//
+// Not thread-safe; times are microseconds on any monotonic clock.
+class RateEstimator
+{
+public:
+    // Arrivals kept beyond the window, so slow streams still have intervals
+    static constexpr std::size_t minArrivals() { return 3; }
+
+    explicit RateEstimator(std::int64_t windowUs = 500000, std::size_t capacity = 128,
+                           std::int64_t maxSpanUs = 10000000)
+        : m_windowUs(std::max<std::int64_t>(1, windowUs)),
+          m_maxSpanUs(std::max(m_windowUs, maxSpanUs)),
+          m_ring(std::max(minArrivals(), capacity))
+    {
+    }
+
+    std::int64_t windowUs() const { return m_windowUs; }
+    std::size_t capacity() const { return m_ring.size(); }
+
+    void clear()
+    {
+        m_head = 0;
+        m_count = 0;
+        m_totalBytes = 0;
+    }
+
+    // A frame of `bytes` arriving at `nowUs`; earlier than the last one counts as then
+    void add(std::int64_t nowUs, std::int64_t bytes)
+    {
+        if (m_count > 0)
+            nowUs = std::max(nowUs, at(m_count - 1).timeUs);
+        m_totalBytes += std::max<std::int64_t>(0, bytes);
+        m_ring[m_head] = Arrival{nowUs, m_totalBytes};
+        m_head = (m_head + 1) % m_ring.size();
+        m_count = std::min(m_count + 1, m_ring.size());
+        const std::size_t expired = firstInWindow(nowUs);
+        m_count -= expired;
+    }
+
+    // Arrivals the rates at `nowUs` are measured over
+    std::size_t arrivals(std::int64_t nowUs) const { return m_count - firstInWindow(nowUs); }
+
+    // Frames per second at `nowUs`; 0 before two arrivals
+    double fps(std::int64_t nowUs) const
+    {
+        Measure measure = measureAt(nowUs);
+        return measure.elapsedUs > 0 ? double(measure.intervals) * 1e6 / double(measure.elapsedUs) : 0.0;
+    }
+
+    // Payload bytes per second at `nowUs`, counting the frames after the first in the window
+    double bytesPerSecond(std::int64_t nowUs) const
+    {
+        Measure measure = measureAt(nowUs);
+        return measure.elapsedUs > 0 ? double(measure.bytes) * 1e6 / double(measure.elapsedUs) : 0.0;
+    }
+
+private:
+    struct Arrival {
+        std::int64_t timeUs = 0;
+        std::int64_t cumulativeBytes = 0; // bytes of every arrival up to and including this one
+    };
+
+    struct Measure {
+        std::int64_t intervals = 0;
+        std::int64_t bytes = 0;
+        std::int64_t elapsedUs = 0;
+    };
+
+    // 0 is the oldest
+    const Arrival& at(std::size_t index) const
+    {
+        return m_ring[(m_head + m_ring.size() - m_count + index) % m_ring.size()];
+    }
+
+    // How many of the oldest arrivals no longer count at `nowUs`
+    std::size_t firstInWindow(std::int64_t nowUs) const
+    {
+        std::size_t first = 0;
+        while (first < m_count) {
+            const std::int64_t age = nowUs - at(first).timeUs;
+            const bool outOfWindow = age >= m_windowUs && m_count - first > minArrivals();
+            if (!outOfWindow && age < m_maxSpanUs)
+                break;
+            ++first;
+        }
+        return first;
+    }
+
+    Measure measureAt(std::int64_t nowUs) const
+    {
+        Measure measure;
+        const std::size_t first = firstInWindow(nowUs);
+        if (m_count - first < 2)
+            return measure;
+        const Arrival& oldest = at(first);
+        const Arrival& newest = at(m_count - 1);
+        measure.intervals = static_cast<std::int64_t>(m_count - first - 1);
+        measure.bytes = newest.cumulativeBytes - oldest.cumulativeBytes;
+        const std::int64_t spanUs = std::max<std::int64_t>(1, newest.timeUs - oldest.timeUs);
+        // Silence longer than a mean interval means the stream slowed down or stopped
+        const std::int64_t silenceUs = nowUs - newest.timeUs - spanUs / measure.intervals;
+        measure.elapsedUs = spanUs + std::max<std::int64_t>(0, silenceUs);
+        return measure;
+    }
+
+    std::int64_t m_windowUs;
+    std::int64_t m_maxSpanUs;
+    std::vector<Arrival> m_ring;
+    std::size_t m_head = 0;  // next write
+    std::size_t m_count = 0;
+    std::int64_t m_totalBytes = 0;
+};
+
+#endif // RATEESTIMATOR_H
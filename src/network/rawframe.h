@@ -0,0 +1,111 @@
+#ifndef RAWFRAME_H
+#define RAWFRAME_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "yuvconvert.h"
+
+// Uncompressed 4:2:0 frames (wire prefix 0x02), for links where CPU rather
+// than bandwidth is the limit. The payload is a fixed header followed by the
+// tightly packed planes (Y, then U and V for I420 or interleaved UV for NV12):
+//
+//   byte 0     format (1 = I420, 2 = NV12)
+//   byte 1     flags (bit 0: limited "video" range, otherwise full range)
+//   bytes 2-3  width, little-endian
+//   bytes 4-5  height, little-endian
+//
+// Width and height must be even so the chroma planes are exactly half size.
+const std::size_t kRawFrameHeaderSize = 6;
+const std::uint8_t kRawFrameLimitedRange = 0x01;
+
+enum class RawFrameFormat : std::uint8_t {
+    I420 = 1,
+    NV12 = 2
+};
+
+struct RawFrameHeader {
+    RawFrameFormat format = RawFrameFormat::I420;
+    int width = 0;
+    int height = 0;
+    bool limitedRange = false;
+};
+
+// Bytes of plane data following the header
+inline std::size_t rawFramePlanesSize(int width, int height)
+{
+    if (width <= 0 || height <= 0)
+        return 0;
+    const std::size_t luma = static_cast<std::size_t>(width) * static_cast<std::size_t>(height);
+    return luma + luma / 2;
+}
+
+// Read and validate the header of a raw frame payload (prefix byte excluded).
+// Fails on unknown formats, odd or zero sizes and payloads whose size doesn't
+// match the planes the header announces.
+inline bool parseRawFrameHeader(const std::uint8_t* data, std::size_t size, RawFrameHeader& header)
+{
+    if (!data || size < kRawFrameHeaderSize)
+        return false;
+    if (data[0] != static_cast<std::uint8_t>(RawFrameFormat::I420)
+        && data[0] != static_cast<std::uint8_t>(RawFrameFormat::NV12))
+        return false;
+
+    const int width = data[2] | (data[3] << 8);
+    const int height = data[4] | (data[5] << 8);
+    if (width <= 0 || height <= 0 || (width % 2) != 0 || (height % 2) != 0)
+        return false;
+    if (size - kRawFrameHeaderSize != rawFramePlanesSize(width, height))
+        return false;
+
+    header.format = static_cast<RawFrameFormat>(data[0]);
+    header.width = width;
+    header.height = height;
+    header.limitedRange = (data[1] & kRawFrameLimitedRange) != 0;
+    return true;
+}
+
+// View the planes of a payload whose header parsed successfully
+inline YuvFrameView rawFrameView(const RawFrameHeader& header, const std::uint8_t* payload)
+{
+    YuvFrameView view;
+    view.layout = header.format == RawFrameFormat::NV12 ? YuvLayout::NV12 : YuvLayout::I420;
+    view.width = header.width;
+    view.height = header.height;
+    view.y = payload + kRawFrameHeaderSize;
+    view.yStride = header.width;
+    view.limitedRange = header.limitedRange;
+
+    const std::size_t luma = static_cast<std::size_t>(header.width) * static_cast<std::size_t>(header.height);
+    view.u = view.y + luma;
+    if (view.layout == YuvLayout::NV12) {
+        view.uvStride = header.width;
+    } else {
+        view.uvStride = header.width / 2;
+        view.v = view.u + luma / 4;
+    }
+    return view;
+}
+
+// Size `payload` for a frame (its capacity is reused) and write the header; the
+// caller fills in the planes after the first kRawFrameHeaderSize bytes.
+// Returns false when the size can't be sent (odd, zero or above 65535).
+inline bool prepareRawFrame(const RawFrameHeader& header, std::vector<std::uint8_t>& payload)
+{
+    const int width = header.width;
+    const int height = header.height;
+    if (width <= 0 || height <= 0 || width > 0xFFFF || height > 0xFFFF
+        || (width % 2) != 0 || (height % 2) != 0)
+        return false;
+
+    payload.resize(kRawFrameHeaderSize + rawFramePlanesSize(width, height));
+    payload[0] = static_cast<std::uint8_t>(header.format);
+    payload[1] = header.limitedRange ? kRawFrameLimitedRange : 0;
+    payload[2] = static_cast<std::uint8_t>(width & 0xFF);
+    payload[3] = static_cast<std::uint8_t>(width >> 8);
+    payload[4] = static_cast<std::uint8_t>(height & 0xFF);
+    payload[5] = static_cast<std::uint8_t>(height >> 8);
+    return true;
+}
+
+#endif // RAWFRAME_H
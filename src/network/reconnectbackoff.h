@@ -0,0 +1,68 @@
+#ifndef RECONNECTBACKOFF_H
+#define RECONNECTBACKOFF_H
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+
+// How long a client waits before its next reconnect attempt.
+//
+// Exponential with full jitter: attempt n waits a uniformly random time up
+// to min(maxMs, baseMs * 2^n). A fleet that lost the same server at the same
+// moment therefore comes back spread over the whole window instead of in
+// lockstep bursts (1, 2, 4 s...), and the expected wait stays half of the
+// plain exponential one.
+//
+// A server that is pacing connections (AcceptPacer) names the wait itself
+// (RETRY_AFTER). That wait is a slot of this client's own, so it is kept
+// as given, plus a little jitter, only ever later, so the client never
+// arrives before its slot.
+class ReconnectBackoff
+{
+public:
+    // Longest server-advertised wait honoured: a misbehaving server can't park the fleet
+    static constexpr std::int64_t maxRetryAfterMs() { return 5 * 60 * 1000; }
+
+    explicit ReconnectBackoff(std::int64_t baseMs = 1000, std::int64_t maxMs = 30000,
+                              std::uint32_t seed = std::random_device()())
+        : m_baseMs(std::max<std::int64_t>(1, baseMs)), m_maxMs(std::max(m_baseMs, maxMs)), m_random(seed)
+    {
+    }
+
+    std::int64_t baseMs() const { return m_baseMs; }
+    std::int64_t maxMs() const { return m_maxMs; }
+
+    // Upper bound of attempt `attempt`'s wait (0-based)
+    std::int64_t windowMs(int attempt) const
+    {
+        std::int64_t window = m_baseMs;
+        for (int i = 0; i < attempt && window < m_maxMs; ++i)
+            window *= 2;
+        return std::min(window, m_maxMs);
+    }
+
+    // Wait before attempt `attempt`; `retryAfterMs` > 0 is the server's RETRY_AFTER
+    std::int64_t delayMs(int attempt, std::int64_t retryAfterMs = 0)
+    {
+        if (retryAfterMs > 0) {
+            const std::int64_t wait = std::min(retryAfterMs, maxRetryAfterMs());
+            // Up to a tenth later (at most 1 s): clients whose slots coincide still spread
+            return wait + uniform(std::min<std::int64_t>(wait / 10, 1000));
+        }
+        return uniform(windowMs(std::max(0, attempt)));
+    }
+
+private:
+    std::int64_t uniform(std::int64_t upTo)
+    {
+        if (upTo <= 0)
+            return 0;
+        return std::uniform_int_distribution<std::int64_t>(0, upTo)(m_random);
+    }
+
+    std::int64_t m_baseMs;
+    std::int64_t m_maxMs;
+    std::mt19937 m_random;
+};
+
+#endif // RECONNECTBACKOFF_H
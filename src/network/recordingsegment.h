@@ -0,0 +1,201 @@
+#ifndef RECORDINGSEGMENT_H
+#define RECORDINGSEGMENT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "frameheader.h"
+
+// On-disk format of the stream recorder (FrameRecorder). Each client's stream
+// is a series of segment files holding the frames exactly as received (no
+// re-encoding), each with a sidecar index. All fields are little-endian.
+//
+// Segment (<start>.seg), preallocated and written through a memory map:
+//   bytes 0-7     magic "ISRSEG01"
+//   bytes 8-15    bytes used, header included (updated as records are appended)
+//   bytes 16-23   first timestamp, microseconds since epoch
+//   bytes 24-31   last timestamp
+//   bytes 32-35   record count
+//   bytes 36-63   reserved, 0
+// then records, each starting on an 8-byte boundary:
+//   bytes 0-3     magic "ISRF"
+//   bytes 4-7     payload size
+//   bytes 8-15    timestamp (capture time on the client, else receive time)
+//   bytes 16-19   client sequence number (FrameHeader), else arrival counter
+//   byte 20       payload format (FramePayload)
+//   byte 21       flags (bit 0: keyframe)
+//   bytes 22-23   reserved, 0
+//   bytes 24-25   width (0 if unknown)
+//   bytes 26-27   height (0 if unknown)
+//   bytes 28-31   reserved, 0
+//   payload, zero padded to the next record
+//
+// Index (<start>.idx): 16-byte entries {timestamp, record offset}, one per
+// index interval of stream time, in timestamp order. Seeking binary-searches
+// the index, then walks at most one interval of records.
+const std::size_t kSegmentHeaderSize = 64;
+const std::size_t kRecordHeaderSize = 32;
+const std::size_t kIndexEntrySize = 16;
+const std::size_t kRecordAlignment = 8;
+
+struct SegmentHeader {
+    std::uint64_t used = kSegmentHeaderSize;
+    std::int64_t firstTimestampUs = 0;
+    std::int64_t lastTimestampUs = 0;
+    std::uint32_t records = 0;
+};
+
+struct RecordHeader {
+    std::uint32_t payloadSize = 0;
+    std::int64_t timestampUs = 0;
+    std::uint32_t sequence = 0;
+    FramePayload payload = FramePayload::Jpeg;
+    bool keyframe = true;
+    int width = 0;
+    int height = 0;
+};
+
+struct IndexEntry {
+    std::int64_t timestampUs = 0;
+    std::uint64_t offset = 0;
+};
+
+namespace recordingsegment_detail {
+
+const char kSegmentMagic[8] = {'I', 'S', 'R', 'S', 'E', 'G', '0', '1'};
+const char kRecordMagic[4] = {'I', 'S', 'R', 'F'};
+
+} // namespace recordingsegment_detail
+
+// Bytes a record with `payloadSize` bytes of payload takes, padding included
+inline std::size_t recordSpan(std::size_t payloadSize)
+{
+    return (kRecordHeaderSize + payloadSize + kRecordAlignment - 1) & ~(kRecordAlignment - 1);
+}
+
+inline void writeSegmentHeader(const SegmentHeader& header, std::uint8_t* out)
+{
+    using frameheader_detail::writeLe;
+    std::memset(out, 0, kSegmentHeaderSize);
+    std::memcpy(out, recordingsegment_detail::kSegmentMagic, 8);
+    writeLe(out + 8, header.used, 8);
+    writeLe(out + 16, static_cast<std::uint64_t>(header.firstTimestampUs), 8);
+    writeLe(out + 24, static_cast<std::uint64_t>(header.lastTimestampUs), 8);
+    writeLe(out + 32, header.records, 4);
+}
+
+// Fails on foreign files and on a used size beyond `size` (truncated copy)
+inline bool parseSegmentHeader(const std::uint8_t* data, std::size_t size, SegmentHeader& header)
+{
+    using frameheader_detail::readLe;
+    if (!data || size < kSegmentHeaderSize || std::memcmp(data, recordingsegment_detail::kSegmentMagic, 8) != 0)
+        return false;
+    header.used = readLe(data + 8, 8);
+    header.firstTimestampUs = static_cast<std::int64_t>(readLe(data + 16, 8));
+    header.lastTimestampUs = static_cast<std::int64_t>(readLe(data + 24, 8));
+    header.records = static_cast<std::uint32_t>(readLe(data + 32, 4));
+    return header.used >= kSegmentHeaderSize && header.used <= size;
+}
+
+// Write the record header and payload at `out`, which must have
+// recordSpan(header.payloadSize) bytes; returns that span
+inline std::size_t writeRecord(const RecordHeader& header, const void* payload, std::uint8_t* out)
+{
+    using frameheader_detail::writeLe;
+    const auto dimension = [](int value) {
+        return value > 0 && value <= 0xFFFF ? static_cast<std::uint64_t>(value) : 0u;
+    };
+    const std::size_t span = recordSpan(header.payloadSize);
+    std::memcpy(out, recordingsegment_detail::kRecordMagic, 4);
+    writeLe(out + 4, header.payloadSize, 4);
+    writeLe(out + 8, static_cast<std::uint64_t>(header.timestampUs), 8);
+    writeLe(out + 16, header.sequence, 4);
+    out[20] = static_cast<std::uint8_t>(header.payload);
+    out[21] = header.keyframe ? kFrameHeaderKeyframe : 0;
+    out[22] = 0;
+    out[23] = 0;
+    writeLe(out + 24, dimension(header.width), 2);
+    writeLe(out + 26, dimension(header.height), 2);
+    writeLe(out + 28, 0, 4);
+    if (header.payloadSize > 0)
+        std::memcpy(out + kRecordHeaderSize, payload, header.payloadSize);
+    std::memset(out + kRecordHeaderSize + header.payloadSize, 0, span - kRecordHeaderSize - header.payloadSize);
+    return span;
+}
+
+// Read the record at `offset` of a segment whose first `used` bytes are valid.
+// `payload` is set to the offset of the payload. Fails past the end, on a
+// torn record (recorder killed while writing) and on bad magic.
+inline bool parseRecord(const std::uint8_t* segment, std::size_t used, std::size_t offset, RecordHeader& header,
+                        std::size_t& payload)
+{
+    using frameheader_detail::readLe;
+    if (!segment || offset < kSegmentHeaderSize || offset > used || used - offset < kRecordHeaderSize)
+        return false;
+    const std::uint8_t* data = segment + offset;
+    if (std::memcmp(data, recordingsegment_detail::kRecordMagic, 4) != 0)
+        return false;
+    header.payloadSize = static_cast<std::uint32_t>(readLe(data + 4, 4));
+    if (recordSpan(header.payloadSize) > used - offset)
+        return false;
+    header.timestampUs = static_cast<std::int64_t>(readLe(data + 8, 8));
+    header.sequence = static_cast<std::uint32_t>(readLe(data + 16, 4));
+    header.payload = static_cast<FramePayload>(data[20]);
+    header.keyframe = (data[21] & kFrameHeaderKeyframe) != 0;
+    header.width = static_cast<int>(readLe(data + 24, 2));
+    header.height = static_cast<int>(readLe(data + 26, 2));
+    payload = offset + kRecordHeaderSize;
+    return true;
+}
+
+inline void writeIndexEntry(const IndexEntry& entry, std::uint8_t* out)
+{
+    frameheader_detail::writeLe(out, static_cast<std::uint64_t>(entry.timestampUs), 8);
+    frameheader_detail::writeLe(out + 8, entry.offset, 8);
+}
+
+inline IndexEntry readIndexEntry(const std::uint8_t* data)
+{
+    IndexEntry entry;
+    entry.timestampUs = static_cast<std::int64_t>(frameheader_detail::readLe(data, 8));
+    entry.offset = frameheader_detail::readLe(data + 8, 8);
+    return entry;
+}
+
+// Offset to start walking from for the first record at or after
+// `timestampUs`: the last entry not later than it, else the first record.
+// `index` holds `count` entries.
+inline std::uint64_t seekIndex(const std::uint8_t* index, std::size_t count, std::int64_t timestampUs)
+{
+    std::uint64_t offset = kSegmentHeaderSize;
+    std::size_t low = 0;
+    std::size_t high = count;
+    while (low < high) {
+        const std::size_t middle = low + (high - low) / 2;
+        const IndexEntry entry = readIndexEntry(index + middle * kIndexEntrySize);
+        if (entry.timestampUs <= timestampUs) {
+            offset = entry.offset;
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return offset;
+}
+
+// Offset of the first record at or after `timestampUs`, walking from `start`
+// (see seekIndex()); `used` when there is none
+inline std::size_t findRecord(const std::uint8_t* segment, std::size_t used, std::size_t start,
+                              std::int64_t timestampUs)
+{
+    RecordHeader header;
+    std::size_t payload = 0;
+    for (std::size_t offset = start; parseRecord(segment, used, offset, header, payload);
+         offset += recordSpan(header.payloadSize)) {
+        if (header.timestampUs >= timestampUs)
+            return offset;
+    }
+    return used;
+}
+
+#endif // RECORDINGSEGMENT_H
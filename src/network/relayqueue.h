@@ -0,0 +1,90 @@
+#ifndef RELAYQUEUE_H
+#define RELAYQUEUE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include "outboundqueue.h"
+
+// Frames a viewer queues by default before its drop policy applies
+const std::size_t kDefaultRelayDepth = 4;
+
+// What a relayed frame means to the viewer's decoder
+enum class RelayFrameKind {
+    Independent, // JPEG or raw YUV: every frame stands on its own
+    Delta,       // H.264/H.265 packet that needs the packets before it
+    Keyframe     // H.264/H.265 packet decodable on its own
+};
+
+// Outbound queue of a viewer session: the camera's messages are forwarded as
+// received (one shared buffer for every viewer), so a slow viewer can only be
+// helped by dropping frames. Independent frames follow the viewer's own drop
+// policy. Video frames can't be dropped one by one without breaking the
+// packets that follow: once one is dropped (or on a new subscription) deltas
+// are skipped until the next keyframe, and a keyframe that finds the queue
+// full replaces every frame still waiting, which it no longer needs.
+//
+// Same write protocol as OutboundQueue; not synchronized either.
+template <typename Buffer>
+class RelayQueue
+{
+public:
+    explicit RelayQueue(std::size_t depth = kDefaultRelayDepth,
+                        OutboundDropPolicy policy = OutboundDropPolicy::DropOldest)
+        : m_queue(depth, policy)
+    {
+    }
+
+    // New subscription or policy: a video stream starts over from its next keyframe
+    void configure(std::size_t depth, OutboundDropPolicy policy)
+    {
+        m_queue.setDepth(depth);
+        m_queue.setPolicy(policy);
+        m_awaitKeyframe = true;
+    }
+
+    // Returns false if the frame was dropped
+    bool pushFrame(Buffer data, RelayFrameKind kind)
+    {
+        if (kind == RelayFrameKind::Independent)
+            return m_queue.pushFrame(std::move(data));
+
+        if (kind == RelayFrameKind::Delta && (m_awaitKeyframe || m_queue.saturated())) {
+            m_awaitKeyframe = true;
+            ++m_skipped;
+            return false;
+        }
+        if (kind == RelayFrameKind::Keyframe && m_queue.saturated())
+            m_queue.dropWaitingFrames();
+        if (m_queue.saturated()) {
+            // Only the frame in flight is left: it can't be recalled
+            m_awaitKeyframe = true;
+            ++m_skipped;
+            return false;
+        }
+        m_queue.pushFrame(std::move(data));
+        m_awaitKeyframe = false;
+        return true;
+    }
+
+    void pushControl(Buffer data) { m_queue.pushControl(std::move(data)); }
+
+    const Buffer& front() const { return m_queue.front(); }
+    void beginWrite() { m_queue.beginWrite(); }
+    void finishWrite() { m_queue.finishWrite(); }
+    void clear() { m_queue.clear(); }
+
+    bool empty() const { return m_queue.empty(); }
+    bool writing() const { return m_queue.writing(); }
+    std::size_t frameCount() const { return m_queue.frameCount(); }
+    bool awaitingKeyframe() const { return m_awaitKeyframe; }
+    // Frames this viewer never got, whatever the reason
+    std::uint64_t droppedTotal() const { return m_queue.droppedTotal() + m_skipped; }
+
+private:
+    OutboundQueue<Buffer> m_queue;
+    bool m_awaitKeyframe = true;
+    std::uint64_t m_skipped = 0;
+};
+
+#endif // RELAYQUEUE_H
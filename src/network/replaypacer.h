@@ -0,0 +1,66 @@
+#ifndef REPLAYPACER_H
+#define REPLAYPACER_H
+
+#include <cstdint>
+
+// Send schedule for replaying recorded frames: frame i is due when as much
+// wall time has passed since the first frame as stream time between their
+// timestamps, divided by `speed` (2.0 replays twice as fast, 0 sends as fast
+// as the link takes them).
+//
+// The schedule is re-anchored, rather than waited out or caught up with in a
+// burst, when the stream time jumps back (next segment of another run, a
+// looped source), jumps ahead by more than `maxGapUs` (recording paused), or
+// the sender is more than `maxLagUs` behind (server paused the client).
+class ReplayPacer
+{
+public:
+    explicit ReplayPacer(double speed = 1.0, std::int64_t maxGapUs = 2000000, std::int64_t maxLagUs = 1000000)
+        : m_speed(speed > 0.0 ? speed : 0.0), m_maxGapUs(maxGapUs), m_maxLagUs(maxLagUs)
+    {
+    }
+
+    // Monotonic time (us) at which the frame recorded at `timestampUs` is due
+    std::int64_t dueUs(std::int64_t timestampUs, std::int64_t nowUs)
+    {
+        if (m_speed <= 0.0)
+            return nowUs;
+        if (m_anchored) {
+            const std::int64_t step = timestampUs - m_lastTimestampUs;
+            const std::int64_t due = schedule(timestampUs);
+            if (step >= 0 && step <= m_maxGapUs && nowUs - due <= m_maxLagUs) {
+                m_lastTimestampUs = timestampUs;
+                return due;
+            }
+            ++m_reanchors;
+        }
+        m_anchored = true;
+        m_anchorTimestampUs = timestampUs;
+        m_anchorNowUs = nowUs;
+        m_lastTimestampUs = timestampUs;
+        return nowUs;
+    }
+
+    void reset() { m_anchored = false; }
+
+    double speed() const { return m_speed; }
+    // Times the schedule was restarted (gaps, loops, lag)
+    std::uint64_t reanchors() const { return m_reanchors; }
+
+private:
+    std::int64_t schedule(std::int64_t timestampUs) const
+    {
+        return m_anchorNowUs + static_cast<std::int64_t>((timestampUs - m_anchorTimestampUs) / m_speed);
+    }
+
+    double m_speed;
+    std::int64_t m_maxGapUs;
+    std::int64_t m_maxLagUs;
+    bool m_anchored = false;
+    std::int64_t m_anchorTimestampUs = 0;
+    std::int64_t m_anchorNowUs = 0;
+    std::int64_t m_lastTimestampUs = 0;
+    std::uint64_t m_reanchors = 0;
+};
+
+#endif // REPLAYPACER_H
@@ -0,0 +1,90 @@
+#include "replaysource.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+bool ReplaySource::open(const QString& path, int directoryFps)
+{
+    m_files.clear();
+    m_reader.close();
+    m_current = -1;
+    m_intervalUs = 1000000 / qMax(1, directoryFps);
+
+    const QFileInfo info(path);
+    if (info.isFile()) {
+        m_recording = info.suffix() == QLatin1String("seg");
+        m_files.append(info.absoluteFilePath());
+    } else if (info.isDir()) {
+        const QDir dir(info.absoluteFilePath());
+        const QStringList segments = dir.entryList({"*.seg"}, QDir::Files, QDir::Name);
+        m_recording = !segments.isEmpty();
+        const QStringList names = m_recording
+            ? segments
+            : dir.entryList({"*.jpg", "*.jpeg"}, QDir::Files, QDir::Name);
+        for (const QString& name : names)
+            m_files.append(dir.filePath(name));
+    }
+    if (m_files.isEmpty())
+        return false;
+    // A recording must hold at least one readable segment
+    if (m_recording) {
+        RecordingReader probe;
+        for (const QString& file : qAsConst(m_files)) {
+            if (probe.open(file))
+                return true;
+        }
+        m_files.clear();
+        return false;
+    }
+    return true;
+}
+
+bool ReplaySource::next(Frame& frame)
+{
+    if (!m_recording) {
+        // JPEG files: one frame each, read when sent (the page cache keeps them after the first run)
+        while (++m_current < m_files.size()) {
+            QFile file(m_files.at(m_current));
+            if (!file.open(QIODevice::ReadOnly))
+                continue;
+            frame = Frame();
+            frame.data = file.readAll();
+            if (frame.data.isEmpty())
+                continue;
+            frame.timestampUs = qint64(m_current) * m_intervalUs;
+            return true;
+        }
+        return false;
+    }
+
+    for (;;) {
+        RecordingReader::Frame record;
+        if (m_reader.isOpen() && m_reader.next(record)) {
+            frame.payload = record.header.payload;
+            frame.data = record.payload;
+            frame.timestampUs = record.header.timestampUs;
+            frame.width = record.header.width;
+            frame.height = record.header.height;
+            return true;
+        }
+        if (!openFile(m_current + 1))
+            return false;
+    }
+}
+
+void ReplaySource::rewind()
+{
+    m_reader.close();
+    m_current = -1;
+}
+
+bool ReplaySource::openFile(int index)
+{
+    // Unreadable segments (copied while being written, ...) are skipped
+    for (m_current = index; m_current < m_files.size(); ++m_current) {
+        if (m_reader.open(m_files.at(m_current)))
+            return true;
+    }
+    m_reader.close();
+    return false;
+}
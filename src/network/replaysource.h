@@ -0,0 +1,51 @@
+#ifndef REPLAYSOURCE_H
+#define REPLAYSOURCE_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include "framerecorder.h"
+
+// Pre-encoded frames for load generation and regression runs, sent as they
+// are instead of being encoded per frame. The source is one of
+//   - a recorded segment (.seg, FrameRecorder)
+//   - a client's recording directory: its segments in order
+//   - a directory of JPEG files, in name order, timestamped `directoryFps` apart
+// Frames come with their recorded timestamps, so ReplayPacer can send them at
+// the original rate or faster.
+class ReplaySource
+{
+public:
+    struct Frame {
+        FramePayload payload = FramePayload::Jpeg;
+        QByteArray data;        // JPEG, raw frame or video packet as recorded
+        qint64 timestampUs = 0; // recorded capture time
+        int width = 0;          // 0 if unknown
+        int height = 0;
+    };
+
+    ReplaySource() = default;
+    ReplaySource(const ReplaySource&) = delete;
+    ReplaySource& operator=(const ReplaySource&) = delete;
+
+    // False when `path` holds nothing replayable
+    bool open(const QString& path, int directoryFps = 30);
+    // False at the end; rewind() starts over
+    bool next(Frame& frame);
+    void rewind();
+
+    // Segment files or JPEG files found by open()
+    int fileCount() const { return m_files.size(); }
+    bool isRecording() const { return m_recording; }
+
+private:
+    bool openFile(int index);
+
+    QStringList m_files;
+    bool m_recording = false;
+    int m_current = -1;
+    RecordingReader m_reader;
+    qint64 m_intervalUs = 33333;
+};
+
+#endif // REPLAYSOURCE_H
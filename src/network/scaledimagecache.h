@@ -0,0 +1,90 @@
+#ifndef SCALEDIMAGECACHE_H
+#define SCALEDIMAGECACHE_H
+
+#include <QImage>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSize>
+#include <cstdint>
+#include <vector>
+#include "boxscale.h"
+
+// Scaled copy of the latest frame for QQuickImageProvider::requestImage():
+// QML asks again for every reload of an Image (and every Image showing the
+// frame asks on its own), so the result is kept per source frame
+// (QImage::cacheKey(), which changes with every new or modified image) and
+// requested size. A repeated request is a lookup and a shallow copy.
+//
+// Frames are fit into the requested size with their aspect ratio and only
+// ever shrunk: a larger request gets the frame itself (the item scales it on
+// the GPU). RGB32 and RGB888 frames go through boxDownscale(); other formats
+// through QImage::scaled().
+//
+// Thread-safe: providers may be called from the scene graph's loader thread.
+class ScaledImageCache
+{
+public:
+    QImage scaled(const QImage& source, const QSize& requestedSize)
+    {
+        if (source.isNull() || requestedSize.width() <= 0 || requestedSize.height() <= 0)
+            return source;
+        const QSize target = source.size().scaled(requestedSize, Qt::KeepAspectRatio).expandedTo(QSize(1, 1));
+        if (target.width() >= source.width() && target.height() >= source.height())
+            return source;
+
+        QMutexLocker lock(&m_mutex);
+        if (!m_scaled.isNull() && m_sourceKey == source.cacheKey() && m_target == target)
+            return m_scaled;
+
+        QImage result;
+        const int channels = bytesPerPixel(source.format());
+        if (channels > 0) {
+            result = QImage(target, source.format());
+            if (!result.isNull()
+                && !boxDownscale(source.constBits(), source.width(), source.height(),
+                                 static_cast<std::size_t>(source.bytesPerLine()), result.bits(), target.width(),
+                                 target.height(), static_cast<std::size_t>(result.bytesPerLine()), channels, m_sums))
+                result = QImage();
+        }
+        if (result.isNull())
+            result = source.scaled(target, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+
+        m_sourceKey = source.cacheKey();
+        m_target = target;
+        m_scaled = result;
+        return result;
+    }
+
+    void clear()
+    {
+        QMutexLocker lock(&m_mutex);
+        m_scaled = QImage();
+        m_sourceKey = 0;
+    }
+
+private:
+    // Formats the box filter averages byte by byte (every byte a full channel)
+    static int bytesPerPixel(QImage::Format format)
+    {
+        switch (format) {
+        case QImage::Format_RGB32:
+        case QImage::Format_ARGB32_Premultiplied:
+        case QImage::Format_RGBX8888:
+        case QImage::Format_RGBA8888_Premultiplied:
+            return 4;
+        case QImage::Format_RGB888:
+        case QImage::Format_BGR888:
+            return 3;
+        default:
+            return 0;
+        }
+    }
+
+    QMutex m_mutex;
+    qint64 m_sourceKey = 0;
+    QSize m_target;
+    QImage m_scaled;
+    std::vector<std::uint32_t> m_sums; // boxDownscale() scratch
+};
+
+#endif // SCALEDIMAGECACHE_H
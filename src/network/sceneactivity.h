@@ -0,0 +1,109 @@
+#ifndef SCENEACTIVITY_H
+#define SCENEACTIVITY_H
+
+#include <algorithm>
+#include <cstddef>
+
+// Tuning for SceneActivity
+struct SceneActivityConfig {
+    // Relative size change between consecutive JPEG frames that counts as motion
+    double jpegSizeChange = 0.03;
+    // Size of an inter-frame (or tiled) packet relative to the last keyframe
+    // that counts as motion: static scenes leave only small deltas
+    double deltaRatio = 0.08;
+    // Quiet evaluations in a row before the scene is idle (motion ends it at once)
+    int quietIntervalsBeforeIdle = 5;
+};
+
+// Per-client scene activity estimated on the server from what it receives
+// anyway, without decoding: the size of each frame compared with the previous
+// one (JPEG: a static scene encodes to almost the same size every time) or,
+// for video packets, with the last keyframe (a delta of a static scene is
+// nearly empty). UNCHANGED heartbeats count as frames without any change.
+// Each sample is scaled by its threshold, so activity() >= 1 means motion
+// whatever the codec. Raw frames carry no such signal and are not fed in: a
+// client without samples never turns idle.
+//
+// Idle needs several quiet intervals in a row, motion ends it at the next
+// evaluation, so a scene that just went still keeps its rate for a while and
+// a moving one gets it back within one interval (plus a frame at the idle rate).
+//
+// Not synchronized; the owner calls evaluate() once per interval.
+class SceneActivity
+{
+public:
+    explicit SceneActivity(const SceneActivityConfig& config = SceneActivityConfig())
+        : m_config(config)
+    {
+    }
+
+    // A received frame of `bytes`; `videoPacket` for prefix 0x03 (H.264 / H.265 / tiles)
+    void onFrame(std::size_t bytes, bool videoPacket, bool keyframe)
+    {
+        if (bytes == 0)
+            return;
+        if (videoPacket) {
+            m_previousBytes = 0;
+            if (keyframe) {
+                m_keyframeBytes = bytes;
+                return;
+            }
+            if (m_keyframeBytes > 0 && m_config.deltaRatio > 0.0)
+                addSample(static_cast<double>(bytes) / static_cast<double>(m_keyframeBytes) / m_config.deltaRatio);
+            return;
+        }
+        m_keyframeBytes = 0;
+        if (m_previousBytes > 0 && m_config.jpegSizeChange > 0.0) {
+            const double larger = static_cast<double>(std::max(bytes, m_previousBytes));
+            const double change = static_cast<double>(bytes > m_previousBytes ? bytes - m_previousBytes
+                                                                             : m_previousBytes - bytes);
+            addSample(change / larger / m_config.jpegSizeChange);
+        }
+        m_previousBytes = bytes;
+    }
+
+    // UNCHANGED heartbeat: the client left out a frame of a static scene
+    void onUnchanged() { addSample(0.0); }
+
+    // Close the interval; true when the idle state changed. An interval
+    // without samples (paused, raw frames) leaves everything as it is.
+    bool evaluate()
+    {
+        if (m_samples == 0)
+            return false;
+        m_activity = m_sum / static_cast<double>(m_samples);
+        m_sum = 0.0;
+        m_samples = 0;
+
+        const bool wasIdle = m_idle;
+        if (m_activity >= 1.0) {
+            m_quietIntervals = 0;
+            m_idle = false;
+        } else if (++m_quietIntervals >= std::max(1, m_config.quietIntervalsBeforeIdle)) {
+            m_idle = true;
+        }
+        return m_idle != wasIdle;
+    }
+
+    bool idle() const { return m_idle; }
+    // Mean scaled sample of the last interval with any (1.0: the motion threshold)
+    double activity() const { return m_activity; }
+
+private:
+    void addSample(double value)
+    {
+        m_sum += value;
+        ++m_samples;
+    }
+
+    SceneActivityConfig m_config;
+    std::size_t m_previousBytes = 0;
+    std::size_t m_keyframeBytes = 0;
+    double m_sum = 0.0;
+    int m_samples = 0;
+    double m_activity = 0.0;
+    int m_quietIntervals = 0;
+    bool m_idle = false;
+};
+
+#endif // SCENEACTIVITY_H
@@ -0,0 +1,167 @@
+#include "sharddirectory.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#ifdef Q_OS_UNIX
+#include <cerrno>
+#include <signal.h>
+#endif
+
+namespace {
+
+const char kSuffix[] = ".clients";
+
+bool processAlive(qint64 pid)
+{
+    if (pid == QCoreApplication::applicationPid())
+        return true;
+#ifdef Q_OS_UNIX
+    return ::kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM;
+#else
+    Q_UNUSED(pid);
+    return true; // no cheap check: entries stay until their owner removes them
+#endif
+}
+
+// Keep fields free of the separators
+QString sanitize(const QString& field)
+{
+    QString out = field;
+    out.replace(QLatin1Char('\t'), QLatin1Char(' '));
+    out.replace(QLatin1Char('\n'), QLatin1Char(' '));
+    return out;
+}
+
+} // namespace
+
+ShardDirectory::ShardDirectory(quint16 port, const QString& root)
+{
+    m_directory = portDirectory(port, root);
+    m_file = QDir(m_directory).filePath(QString::number(QCoreApplication::applicationPid()) + QLatin1String(kSuffix));
+    if (!QDir().mkpath(m_directory))
+        qWarning() << "Shard directory unavailable:" << m_directory;
+    publish();
+}
+
+ShardDirectory::~ShardDirectory()
+{
+    QFile::remove(m_file);
+}
+
+QString ShardDirectory::defaultRoot()
+{
+    QString runtime = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
+    if (runtime.isEmpty())
+        runtime = QDir::tempPath();
+    return QDir(runtime).filePath(QStringLiteral("image-socket"));
+}
+
+QString ShardDirectory::portDirectory(quint16 port, const QString& root)
+{
+    return QDir(root.isEmpty() ? defaultRoot() : root).filePath(QString::number(port));
+}
+
+QList<ShardDirectory::Entry> ShardDirectory::entriesOn(quint16 port, const QString& root)
+{
+    return readDirectory(portDirectory(port, root));
+}
+
+void ShardDirectory::setClient(const QString& clientId, const QString& alias, const QString& address)
+{
+    Entry entry;
+    entry.pid = QCoreApplication::applicationPid();
+    entry.clientId = sanitize(clientId);
+    entry.alias = sanitize(alias);
+    entry.address = sanitize(address);
+    m_clients.insert(clientId, entry);
+    publish();
+}
+
+void ShardDirectory::setAlias(const QString& clientId, const QString& alias)
+{
+    auto it = m_clients.find(clientId);
+    if (it == m_clients.end() || it->alias == sanitize(alias))
+        return;
+    it->alias = sanitize(alias);
+    publish();
+}
+
+void ShardDirectory::removeClient(const QString& clientId)
+{
+    if (m_clients.remove(clientId) > 0)
+        publish();
+}
+
+bool ShardDirectory::publish() const
+{
+    // QSaveFile renames into place: readers see the old or the new list, never half of one
+    QSaveFile file(m_file);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+        return false;
+    for (const Entry& entry : m_clients) {
+        const QString line = entry.clientId + QLatin1Char('\t') + entry.alias + QLatin1Char('\t')
+                             + entry.address + QLatin1Char('\n');
+        file.write(line.toUtf8());
+    }
+    return file.commit();
+}
+
+QList<ShardDirectory::Entry> ShardDirectory::entries() const
+{
+    return readDirectory(m_directory);
+}
+
+QList<ShardDirectory::Entry> ShardDirectory::readDirectory(const QString& directory)
+{
+    QList<Entry> result;
+    const QDir dir(directory);
+    const QStringList files = dir.entryList(QStringList() << QStringLiteral("*") + QLatin1String(kSuffix), QDir::Files);
+    for (const QString& name : files) {
+        bool ok = false;
+        const qint64 pid = name.left(name.size() - int(sizeof(kSuffix) - 1)).toLongLong(&ok);
+        if (!ok)
+            continue;
+        const QString path = dir.filePath(name);
+        if (!processAlive(pid)) {
+            QFile::remove(path); // left behind by a crashed instance
+            continue;
+        }
+
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+            continue;
+        while (!file.atEnd()) {
+            QString line = QString::fromUtf8(file.readLine());
+            if (line.endsWith(QLatin1Char('\n')))
+                line.chop(1);
+            const QStringList fields = line.split(QLatin1Char('\t')); // alias and address may be empty
+            if (fields.size() < 3 || fields.at(0).isEmpty())
+                continue;
+            Entry entry;
+            entry.pid = pid;
+            entry.clientId = fields.at(0);
+            entry.alias = fields.at(1);
+            entry.address = fields.at(2);
+            result.append(entry);
+        }
+    }
+    return result;
+}
+
+bool ShardDirectory::find(const QString& clientIdOrAlias, Entry& out) const
+{
+    if (clientIdOrAlias.isEmpty())
+        return false;
+    const QList<Entry> all = entries();
+    for (const Entry& entry : all) {
+        if (entry.clientId == clientIdOrAlias || entry.alias == clientIdOrAlias) {
+            out = entry;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,59 @@
+#ifndef SHARDDIRECTORY_H
+#define SHARDDIRECTORY_H
+
+#include <QList>
+#include <QMap>
+#include <QString>
+
+// Which server process owns which client, when several processes share one
+// port through SO_REUSEPORT and the kernel spreads the connections.
+//
+// Each process keeps one small file, <root>/<port>/<pid>.clients, with a
+// line per client (id, alias, address; tab-separated), rewritten atomically
+// whenever its clients change. Lookups read every instance's file; files of
+// processes that no longer exist are removed on the way. The default root is
+// the runtime directory (XDG_RUNTIME_DIR, a tmpfs on most systems), so the
+// directory is effectively shared memory without any locking.
+class ShardDirectory
+{
+public:
+    struct Entry {
+        qint64 pid = 0;
+        QString clientId;
+        QString alias;
+        QString address;
+    };
+
+    explicit ShardDirectory(quint16 port, const QString& root = QString());
+    ~ShardDirectory(); // removes this process' file
+
+    ShardDirectory(const ShardDirectory&) = delete;
+    ShardDirectory& operator=(const ShardDirectory&) = delete;
+
+    // This process' clients
+    void setClient(const QString& clientId, const QString& alias, const QString& address);
+    void setAlias(const QString& clientId, const QString& alias); // keeps the address
+    void removeClient(const QString& clientId);
+
+    // Clients of every live instance on the port, this one included
+    QList<Entry> entries() const;
+    // Match by client id or alias; false if no instance has it
+    bool find(const QString& clientIdOrAlias, Entry& out) const;
+
+    QString directory() const { return m_directory; }
+
+    static QString defaultRoot();
+    // Lookup without joining the directory (no file of its own), e.g. from a CLI
+    static QList<Entry> entriesOn(quint16 port, const QString& root = QString());
+
+private:
+    bool publish() const;
+    static QString portDirectory(quint16 port, const QString& root);
+    static QList<Entry> readDirectory(const QString& directory);
+
+    QString m_directory;
+    QString m_file;
+    QMap<QString, Entry> m_clients;
+};
+
+#endif // SHARDDIRECTORY_H
@@ -0,0 +1,385 @@
+#ifndef SHMFRAMERING_H
+#define SHMFRAMERING_H
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <string>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+// Same-host frame transport: a ring of fixed-size slots in POSIX shared
+// memory, written by one client (producer) and read by its server session
+// (consumer). A slot holds one message exactly as it would go over the
+// WebSocket (prefix byte, optional FrameHeader, payload), so the server
+// parses it like a received one; control messages stay on the WebSocket,
+// which also bounds the ring's lifetime.
+//
+// Segment layout (native byte order, both ends are on one host):
+//   bytes 0-7      magic "ISSHMR01"
+//   bytes 8-11     slot count
+//   bytes 12-15    slot size, its 8-byte slot header included
+//   bytes 64-71    head: messages written so far (producer)
+//   bytes 128-135  tail: messages read so far (consumer)
+//   bytes 192-195  consumer waiting for the doorbell (1) or reading (0)
+//   bytes 196-199  consumer attached (1): the producer writes frames here
+//                  instead of the WebSocket from then on
+// then the slots; message n sits in slot n % slot count:
+//   bytes 0-3      message size
+//   bytes 4-7      reserved, 0
+//   the message
+//
+// head and tail each have a cache line of their own. The producer rings the
+// doorbell (ShmDoorbell) only when the consumer went to sleep on it, so a
+// busy stream costs no system call per frame.
+const std::size_t kShmRingHeaderSize = 256;
+const std::size_t kShmSlotHeaderSize = 8;
+const std::uint32_t kShmDefaultSlots = 4;
+const std::uint32_t kShmDefaultSlotBytes = 8 * 1024 * 1024; // a 1080p raw I420 frame is ~3 MB
+const std::uint64_t kShmMaxRingBytes = 256 * 1024 * 1024;   // what a consumer agrees to map
+// Ring names (shm_open) a server accepts; the doorbell is "<name>.bell"
+const char kShmRingNamePrefix[] = "/imagesocket-";
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2,
+              "the ring's counters are shared between processes: they must be lock-free");
+
+class ShmFrameRing
+{
+public:
+    // One piece of a message written by write()
+    struct Span {
+        const void* data;
+        std::size_t size;
+    };
+
+    ShmFrameRing() = default;
+    ~ShmFrameRing() { close(); }
+    ShmFrameRing(const ShmFrameRing&) = delete;
+    ShmFrameRing& operator=(const ShmFrameRing&) = delete;
+
+    // Producer: creates (replacing a stale one of the same name) and maps the segment
+    bool create(const std::string& name, std::uint32_t slots = kShmDefaultSlots,
+                std::uint32_t slotBytes = kShmDefaultSlotBytes)
+    {
+        close();
+#ifdef __linux__
+        if (slots == 0 || slotBytes <= kShmSlotHeaderSize
+            || kShmRingHeaderSize + std::uint64_t(slots) * slotBytes > kShmMaxRingBytes)
+            return fail("invalid ring size");
+        ::shm_unlink(name.c_str());
+        const int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd < 0)
+            return fail(std::strerror(errno));
+        const std::size_t bytes = kShmRingHeaderSize + std::size_t(slots) * slotBytes;
+        // Pages are only backed once touched: small frames cost little memory
+        if (::ftruncate(fd, static_cast<off_t>(bytes)) < 0) {
+            const int error = errno;
+            ::close(fd);
+            ::shm_unlink(name.c_str());
+            return fail(std::strerror(error));
+        }
+        if (!map(fd, bytes)) {
+            ::shm_unlink(name.c_str());
+            return false;
+        }
+        m_name = name;
+        m_owner = true;
+        std::memcpy(m_base, magic(), 8);
+        std::memcpy(m_base + 8, &slots, 4);
+        std::memcpy(m_base + 12, &slotBytes, 4);
+        m_slots = slots;
+        m_slotBytes = slotBytes;
+        // Fresh segments are zero-filled: the counters and flags start at 0
+        return true;
+#else
+        (void)name;
+        (void)slots;
+        (void)slotBytes;
+        return fail("shared memory transport needs Linux");
+#endif
+    }
+
+    // Consumer: maps a segment made by create(), checking its header and size
+    bool open(const std::string& name)
+    {
+        close();
+#ifdef __linux__
+        const int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+        if (fd < 0)
+            return fail(std::strerror(errno));
+        struct stat info;
+        if (::fstat(fd, &info) < 0 || info.st_size < static_cast<off_t>(kShmRingHeaderSize)
+            || static_cast<std::uint64_t>(info.st_size) > kShmMaxRingBytes) {
+            ::close(fd);
+            return fail("not a frame ring");
+        }
+        if (!map(fd, static_cast<std::size_t>(info.st_size)))
+            return false;
+        std::uint32_t slots = 0;
+        std::uint32_t slotBytes = 0;
+        std::memcpy(&slots, m_base + 8, 4);
+        std::memcpy(&slotBytes, m_base + 12, 4);
+        if (std::memcmp(m_base, magic(), 8) != 0 || slots == 0 || slotBytes <= kShmSlotHeaderSize
+            || kShmRingHeaderSize + std::uint64_t(slots) * slotBytes != static_cast<std::uint64_t>(info.st_size)) {
+            close();
+            return fail("not a frame ring");
+        }
+        m_name = name;
+        m_slots = slots;
+        m_slotBytes = slotBytes;
+        attached().store(1);
+        return true;
+#else
+        (void)name;
+        return fail("shared memory transport needs Linux");
+#endif
+    }
+
+    // Removes the name; the segment lives on until both sides unmapped it
+    void unlink()
+    {
+#ifdef __linux__
+        if (m_owner && !m_name.empty())
+            ::shm_unlink(m_name.c_str());
+#endif
+        m_owner = false;
+    }
+
+    void close()
+    {
+        unlink();
+#ifdef __linux__
+        if (m_base)
+            ::munmap(m_base, m_bytes);
+#endif
+        m_base = nullptr;
+        m_bytes = 0;
+        m_slots = 0;
+        m_slotBytes = 0;
+        m_name.clear();
+    }
+
+    bool isOpen() const { return m_base != nullptr; }
+    const std::string& name() const { return m_name; }
+    const std::string& errorString() const { return m_error; }
+    std::uint32_t slotCount() const { return m_slots; }
+    // Largest message a slot holds
+    std::size_t maxMessageSize() const { return m_slotBytes > kShmSlotHeaderSize ? m_slotBytes - kShmSlotHeaderSize : 0; }
+    // Written but not read yet
+    std::size_t pending() const
+    {
+        return m_base ? static_cast<std::size_t>(head().load() - tail().load()) : 0;
+    }
+
+    // Producer: true once the consumer mapped the ring
+    bool consumerAttached() const { return m_base && attached().load(std::memory_order_acquire) != 0; }
+
+    // Producer: copies the parts into the next free slot as one message; false
+    // when every slot is taken or the message doesn't fit into one
+    bool write(std::initializer_list<Span> parts)
+    {
+        if (!m_base)
+            return false;
+        std::size_t size = 0;
+        for (const Span& part : parts)
+            size += part.size;
+        if (size > maxMessageSize())
+            return false;
+        const std::uint64_t written = head().load(std::memory_order_relaxed);
+        if (written - tail().load(std::memory_order_acquire) >= m_slots)
+            return false;
+
+        std::uint8_t* slot = slotAt(written);
+        const std::uint32_t size32 = static_cast<std::uint32_t>(size);
+        std::memcpy(slot, &size32, 4);
+        std::uint8_t* out = slot + kShmSlotHeaderSize;
+        for (const Span& part : parts) {
+            if (part.size > 0)
+                std::memcpy(out, part.data, part.size);
+            out += part.size;
+        }
+        // seq_cst: ordered before the waiting flag is looked at (see takeDoorbell())
+        head().store(written + 1);
+        return true;
+    }
+
+    // Producer, after write(): true when the consumer sleeps on the doorbell,
+    // which must be rung then. Clears the flag, so one ring wakes it once.
+    bool takeDoorbell() { return m_base && waiting().load() != 0 && waiting().exchange(0) != 0; }
+
+    // Consumer: hands the oldest message to sink(const std::uint8_t*, std::size_t)
+    // and frees its slot once the sink returns; false when there is none
+    template <typename Sink>
+    bool read(Sink&& sink)
+    {
+        if (!m_base)
+            return false;
+        const std::uint64_t readCount = tail().load(std::memory_order_relaxed);
+        if (head().load(std::memory_order_acquire) == readCount)
+            return false;
+        const std::uint8_t* slot = slotAt(readCount);
+        std::uint32_t size = 0;
+        std::memcpy(&size, slot, 4);
+        if (size <= maxMessageSize())
+            sink(slot + kShmSlotHeaderSize, static_cast<std::size_t>(size));
+        tail().store(readCount + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer, before waiting for the doorbell: true if it may sleep now;
+    // false when messages arrived meanwhile, then read on instead
+    bool prepareToWait()
+    {
+        if (!m_base)
+            return true;
+        waiting().store(1); // seq_cst: seen by the producer's next takeDoorbell(), or head is seen here
+        if (head().load() == tail().load(std::memory_order_relaxed))
+            return true;
+        waiting().store(0);
+        return false;
+    }
+
+private:
+    static const char* magic() { return "ISSHMR01"; }
+
+#ifdef __linux__
+    bool map(int fd, std::size_t bytes)
+    {
+        void* base = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        const int error = errno;
+        ::close(fd); // the mapping keeps the segment
+        if (base == MAP_FAILED)
+            return fail(std::strerror(error));
+        m_base = static_cast<std::uint8_t*>(base);
+        m_bytes = bytes;
+        return true;
+    }
+#endif
+
+    bool fail(const char* reason)
+    {
+        m_error = reason;
+        return false;
+    }
+
+    std::atomic<std::uint64_t>& head() const { return *reinterpret_cast<std::atomic<std::uint64_t>*>(m_base + 64); }
+    std::atomic<std::uint64_t>& tail() const { return *reinterpret_cast<std::atomic<std::uint64_t>*>(m_base + 128); }
+    std::atomic<std::uint32_t>& waiting() const { return *reinterpret_cast<std::atomic<std::uint32_t>*>(m_base + 192); }
+    std::atomic<std::uint32_t>& attached() const { return *reinterpret_cast<std::atomic<std::uint32_t>*>(m_base + 196); }
+
+    std::uint8_t* slotAt(std::uint64_t message) const
+    {
+        return m_base + kShmRingHeaderSize + static_cast<std::size_t>(message % m_slots) * m_slotBytes;
+    }
+
+    std::uint8_t* m_base = nullptr;
+    std::size_t m_bytes = 0;
+    std::uint32_t m_slots = 0;
+    std::uint32_t m_slotBytes = 0;
+    std::string m_name;
+    std::string m_error;
+    bool m_owner = false;
+};
+
+// Wakes the consumer of a ShmFrameRing: a datagram socket in the abstract
+// namespace ("<ring name>.bell", Linux), bound by the consumer, which waits
+// for it to become readable (QSocketNotifier, asio descriptor). Sends never
+// block; a full socket buffer means the consumer is already awake.
+class ShmDoorbell
+{
+public:
+    ShmDoorbell() = default;
+    ~ShmDoorbell() { close(); }
+    ShmDoorbell(const ShmDoorbell&) = delete;
+    ShmDoorbell& operator=(const ShmDoorbell&) = delete;
+
+    // Consumer
+    bool listen(const std::string& ringName) { return open(ringName, true); }
+    // Producer
+    bool connect(const std::string& ringName) { return open(ringName, false); }
+
+    void ring()
+    {
+#ifdef __linux__
+        if (m_fd >= 0) {
+            const char bell = 1;
+            (void)::send(m_fd, &bell, 1, MSG_DONTWAIT | MSG_NOSIGNAL);
+        }
+#endif
+    }
+
+    // Consumer: reads every pending ring
+    void drain()
+    {
+#ifdef __linux__
+        char bells[64];
+        while (m_fd >= 0 && ::recv(m_fd, bells, sizeof(bells), MSG_DONTWAIT) > 0) {
+        }
+#endif
+    }
+
+    int fd() const { return m_fd; }
+    bool isOpen() const { return m_fd >= 0; }
+    const std::string& errorString() const { return m_error; }
+
+    void close()
+    {
+#ifdef __linux__
+        if (m_fd >= 0)
+            ::close(m_fd);
+#endif
+        m_fd = -1;
+    }
+
+private:
+    bool open(const std::string& ringName, bool bind)
+    {
+        close();
+#ifdef __linux__
+        const std::string name = ringName + ".bell";
+        sockaddr_un address;
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (name.size() + 1 > sizeof(address.sun_path)) {
+            m_error = "doorbell name too long";
+            return false;
+        }
+        std::memcpy(address.sun_path + 1, name.data(), name.size()); // leading NUL: abstract namespace
+        const socklen_t length = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + 1 + name.size());
+
+        const int fd = ::socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            m_error = std::strerror(errno);
+            return false;
+        }
+        const sockaddr* target = reinterpret_cast<const sockaddr*>(&address);
+        if ((bind ? ::bind(fd, target, length) : ::connect(fd, target, length)) < 0) {
+            m_error = std::strerror(errno);
+            ::close(fd);
+            return false;
+        }
+        m_fd = fd;
+        return true;
+#else
+        (void)ringName;
+        (void)bind;
+        m_error = "shared memory transport needs Linux";
+        return false;
+#endif
+    }
+
+    int m_fd = -1;
+    std::string m_error;
+};
+
+#endif // SHMFRAMERING_H
@@ -0,0 +1,101 @@
+#ifndef SIMULCAST_H
+#define SIMULCAST_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Most layers a simulcast client may announce (full, 1/2, 1/4, 1/8)
+const int kMaxSimulcastLayers = 4;
+
+// One layer of a simulcast client as the server sees it: layer n is the
+// capture at 1/2^n of the size (stream id n), each at its own frame rate
+struct SimulcastLayer {
+    int width = 0;  // size of its last frame, 0 while none was seen
+    int height = 0;
+    double bitrateBps = 0.0; // last interval with frames (a paused layer keeps its figure)
+};
+
+// Per-connection layer bookkeeping: frame sizes as they arrive and a
+// bitrate per layer, closed once per interval by evaluate(). Not synchronized.
+class SimulcastMeter
+{
+public:
+    explicit SimulcastMeter(int layers = 0) { setLayerCount(layers); }
+
+    void setLayerCount(int layers)
+    {
+        const int count = layers < 0 ? 0 : (layers > kMaxSimulcastLayers ? kMaxSimulcastLayers : layers);
+        m_layers.assign(static_cast<std::size_t>(count), SimulcastLayer());
+        m_bytes.assign(static_cast<std::size_t>(count), 0);
+    }
+    int layerCount() const { return static_cast<int>(m_layers.size()); }
+
+    // A frame of `bytes` on layer `layer`; a size of 0 leaves the known one
+    void onFrame(int layer, std::size_t bytes, int width, int height)
+    {
+        if (layer < 0 || layer >= layerCount())
+            return;
+        m_bytes[static_cast<std::size_t>(layer)] += bytes;
+        if (width > 0 && height > 0) {
+            m_layers[static_cast<std::size_t>(layer)].width = width;
+            m_layers[static_cast<std::size_t>(layer)].height = height;
+        }
+    }
+
+    // Close an interval of `elapsedMs`: layers that sent anything get its bitrate
+    void evaluate(std::int64_t elapsedMs)
+    {
+        if (elapsedMs <= 0)
+            return;
+        for (std::size_t i = 0; i < m_layers.size(); ++i) {
+            if (m_bytes[i] > 0)
+                m_layers[i].bitrateBps = static_cast<double>(m_bytes[i]) * 8000.0 / static_cast<double>(elapsedMs);
+            m_bytes[i] = 0;
+        }
+    }
+
+    const std::vector<SimulcastLayer>& layers() const { return m_layers; }
+
+private:
+    std::vector<SimulcastLayer> m_layers;
+    std::vector<std::uint64_t> m_bytes;
+};
+
+// Layer for a consumer that shows frames within `targetWidth` x `targetHeight`
+// (0 x 0: full size, e.g. a recording) over a link of `maxBitrateBps` (0: no
+// limit). The smallest layer that still covers the target once fit into it
+// (as jpegScaleDenominator(): one side filling its target is enough), then
+// smaller ones while the layer's bitrate is over the link. Sizes not seen yet
+// are taken as the full layer's halved; with the full layer unknown too, only
+// the full layer counts as covering. Always a valid index for non-empty `layers`.
+inline int pickSimulcastLayer(const std::vector<SimulcastLayer>& layers, int targetWidth, int targetHeight,
+                              double maxBitrateBps)
+{
+    const int count = static_cast<int>(layers.size());
+    if (count <= 1)
+        return 0;
+
+    int pick = 0;
+    if (targetWidth > 0 && targetHeight > 0) {
+        for (int i = count - 1; i > 0; --i) {
+            int width = layers[static_cast<std::size_t>(i)].width;
+            int height = layers[static_cast<std::size_t>(i)].height;
+            if (width <= 0 || height <= 0) {
+                width = layers[0].width >> i;
+                height = layers[0].height >> i;
+            }
+            if (width > 0 && height > 0 && (width >= targetWidth || height >= targetHeight)) {
+                pick = i;
+                break;
+            }
+        }
+    }
+    if (maxBitrateBps > 0.0) {
+        while (pick < count - 1 && layers[static_cast<std::size_t>(pick)].bitrateBps > maxBitrateBps)
+            ++pick;
+    }
+    return pick;
+}
+
+#endif // SIMULCAST_H
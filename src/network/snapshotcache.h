@@ -0,0 +1,83 @@
+#ifndef SNAPSHOTCACHE_H
+#define SNAPSHOTCACHE_H
+
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QString>
+#include "encodedframe.h"
+
+// Latest JPEG frame of every client, as received, for the HTTP snapshot
+// route: storing one is a lock and an implicitly shared QByteArray
+// assignment, serving it hands out the same bytes. Each stored frame gets a
+// cache-wide version, increasing across clients and reconnects, usable as an
+// ETag. Only independent frames are kept: an H.264/H.265 packet or a raw
+// YUV frame is not an image on its own.
+//
+// Thread-safe: the receive path stores, the HTTP thread reads.
+class SnapshotCache
+{
+public:
+    struct Snapshot {
+        EncodedFrame frame; // null buffer: none yet
+        quint64 version = 0;
+    };
+
+    // Keeps `frame` if it is a JPEG; true when it was kept
+    bool store(const QString& clientId, const EncodedFrame& frame)
+    {
+        if (frame.format != EncodedFrame::Jpeg || frame.isEmpty())
+            return false;
+        QMutexLocker lock(&m_mutex);
+        Snapshot& snapshot = m_snapshots[clientId];
+        snapshot.frame = frame;
+        snapshot.frame.charge.reset(); // kept until replaced: counted by the owner (bytes())
+        snapshot.version = ++m_version;
+        return true;
+    }
+
+    bool find(const QString& clientId, Snapshot& out) const
+    {
+        QMutexLocker lock(&m_mutex);
+        auto it = m_snapshots.constFind(clientId);
+        if (it == m_snapshots.constEnd())
+            return false;
+        out = it.value();
+        return true;
+    }
+
+    void remove(const QString& clientId)
+    {
+        QMutexLocker lock(&m_mutex);
+        m_snapshots.remove(clientId);
+    }
+
+    void clear()
+    {
+        QMutexLocker lock(&m_mutex);
+        m_snapshots.clear();
+    }
+
+    int size() const
+    {
+        QMutexLocker lock(&m_mutex);
+        return m_snapshots.size();
+    }
+
+    // Received bytes the snapshots keep alive
+    qint64 bytes() const
+    {
+        QMutexLocker lock(&m_mutex);
+        qint64 total = 0;
+        for (const Snapshot& snapshot : m_snapshots)
+            total += snapshot.frame.buffer.size();
+        return total;
+    }
+
+private:
+    mutable QMutex m_mutex;
+    QHash<QString, Snapshot> m_snapshots;
+    quint64 m_version = 0;
+};
+
+#endif // SNAPSHOTCACHE_H
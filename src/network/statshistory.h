@@ -0,0 +1,164 @@
+#ifndef STATSHISTORY_H
+#define STATSHISTORY_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// One client's statistics over one interval. latencyMs -1: not measured.
+struct StatsPoint {
+    std::int64_t timeMs = 0;   // interval start
+    float fps = 0.0f;
+    float bytesPerSecond = 0.0f;
+    float latencyMs = -1.0f;
+    float drops = 0.0f;        // frames dropped per second
+};
+
+// Trend history of one client for the diagnostics charts, in fixed memory:
+// one ring per resolution (1 s, 10 s, 1 min), allocated up front. A sample a
+// second goes into the 1 s ring as is and is averaged into the coarser ones,
+// each closing its interval when a sample of the next arrives (intervals are
+// aligned to multiples of their length, so gaps leave no partial mix).
+// Adding never allocates; the defaults keep 5 minutes, 1 hour and 1 day.
+//
+// Not thread-safe.
+class StatsHistory
+{
+public:
+    enum Resolution { Seconds, TenSeconds, Minutes, ResolutionCount };
+
+    static std::int64_t periodMs(int resolution)
+    {
+        static const std::int64_t periods[ResolutionCount] = {1000, 10000, 60000};
+        return periods[std::max(0, std::min(int(ResolutionCount) - 1, resolution))];
+    }
+
+    // Resolution whose period is closest to `seconds` from below (1 s at least)
+    static Resolution resolutionFor(int seconds)
+    {
+        if (seconds >= 60)
+            return Minutes;
+        return seconds >= 10 ? TenSeconds : Seconds;
+    }
+
+    explicit StatsHistory(std::size_t secondPoints = 300, std::size_t tenSecondPoints = 360,
+                          std::size_t minutePoints = 1440)
+    {
+        m_rings[Seconds].points.resize(std::max<std::size_t>(1, secondPoints));
+        m_rings[TenSeconds].points.resize(std::max<std::size_t>(1, tenSecondPoints));
+        m_rings[Minutes].points.resize(std::max<std::size_t>(1, minutePoints));
+    }
+
+    void add(const StatsPoint& sample)
+    {
+        m_rings[Seconds].push(sample);
+        for (int resolution = TenSeconds; resolution < ResolutionCount; ++resolution) {
+            Accumulator& accumulator = m_accumulators[resolution];
+            const std::int64_t bucket = floorDiv(sample.timeMs, periodMs(resolution));
+            if (accumulator.count > 0 && bucket != accumulator.bucket) {
+                m_rings[resolution].push(accumulator.average(accumulator.bucket * periodMs(resolution)));
+                accumulator = Accumulator();
+            }
+            accumulator.bucket = bucket;
+            accumulator.add(sample);
+        }
+    }
+
+    void clear()
+    {
+        for (Ring& ring : m_rings) {
+            ring.head = 0;
+            ring.count = 0;
+        }
+        for (Accumulator& accumulator : m_accumulators)
+            accumulator = Accumulator();
+    }
+
+    std::size_t size(int resolution) const { return ring(resolution).count; }
+    std::size_t capacity(int resolution) const { return ring(resolution).points.size(); }
+
+    // Calls visit(point) for the points of `resolution` starting at or after
+    // `sinceMs`, oldest first; only the newest `maxPoints` (0: all). Returns
+    // how many were visited.
+    template <typename Visitor>
+    std::size_t forEach(int resolution, std::int64_t sinceMs, std::size_t maxPoints, Visitor&& visit) const
+    {
+        const Ring& points = ring(resolution);
+        std::size_t first = 0;
+        while (first < points.count && points.at(first).timeMs < sinceMs)
+            ++first;
+        if (maxPoints > 0 && points.count - first > maxPoints)
+            first = points.count - maxPoints;
+        for (std::size_t i = first; i < points.count; ++i)
+            visit(points.at(i));
+        return points.count - first;
+    }
+
+private:
+    struct Ring {
+        std::vector<StatsPoint> points;
+        std::size_t head = 0;  // next write
+        std::size_t count = 0;
+
+        void push(const StatsPoint& point)
+        {
+            points[head] = point;
+            head = (head + 1) % points.size();
+            count = std::min(count + 1, points.size());
+        }
+        // 0 is the oldest
+        const StatsPoint& at(std::size_t index) const
+        {
+            return points[(head + points.size() - count + index) % points.size()];
+        }
+    };
+
+    struct Accumulator {
+        std::int64_t bucket = 0;
+        int count = 0;
+        int latencyCount = 0;
+        double fps = 0.0;
+        double bytesPerSecond = 0.0;
+        double latencyMs = 0.0;
+        double drops = 0.0;
+
+        void add(const StatsPoint& point)
+        {
+            ++count;
+            fps += point.fps;
+            bytesPerSecond += point.bytesPerSecond;
+            drops += point.drops;
+            if (point.latencyMs >= 0.0f) {
+                ++latencyCount;
+                latencyMs += point.latencyMs;
+            }
+        }
+        StatsPoint average(std::int64_t timeMs) const
+        {
+            StatsPoint point;
+            point.timeMs = timeMs;
+            point.fps = static_cast<float>(fps / count);
+            point.bytesPerSecond = static_cast<float>(bytesPerSecond / count);
+            point.drops = static_cast<float>(drops / count);
+            point.latencyMs = latencyCount > 0 ? static_cast<float>(latencyMs / latencyCount) : -1.0f;
+            return point;
+        }
+    };
+
+    static std::int64_t floorDiv(std::int64_t value, std::int64_t divisor)
+    {
+        const std::int64_t quotient = value / divisor;
+        return (value % divisor != 0 && value < 0) ? quotient - 1 : quotient;
+    }
+
+    const Ring& ring(int resolution) const
+    {
+        return m_rings[std::max(0, std::min(int(ResolutionCount) - 1, resolution))];
+    }
+
+    Ring m_rings[ResolutionCount];
+    Accumulator m_accumulators[ResolutionCount]; // [Seconds] unused
+};
+
+#endif // STATSHISTORY_H
@@ -0,0 +1,293 @@
+#include "streamingjpeg.h"
+#include <algorithm>
+#include <vector>
+#include "framesize.h"
+
+#ifdef IMAGESOCKET_HAVE_LIBJPEG
+#include <csetjmp>
+#include <cstdio>
+#include <jpeglib.h>
+
+#ifndef JCS_EXTENSIONS
+#error "streaming JPEG decode needs libjpeg-turbo's libjpeg (JCS_EXT_BGRX output)"
+#endif
+
+namespace {
+
+// QImage::Format_RGB32 is 0xffRRGGBB in native byte order; libjpeg-turbo fills X with 0xff
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+const J_COLOR_SPACE kRgb32ColorSpace = JCS_EXT_XRGB;
+#else
+const J_COLOR_SPACE kRgb32ColorSpace = JCS_EXT_BGRX;
+#endif
+
+const JOCTET kFakeEoi[2] = {0xFF, JPEG_EOI};
+
+} // namespace
+
+struct StreamingJpegDecoder::Impl {
+    enum class Stage { Idle, Header, Start, Rows, Done, Failed };
+
+    struct ErrorManager {
+        jpeg_error_mgr base;
+        std::jmp_buf jump;
+    };
+
+    // Suspending source over the caller's buffer: libjpeg reads up to what was
+    // fed, and a call that runs out returns with the position of the first byte
+    // it still needs, which the next feed() starts from
+    struct Source {
+        jpeg_source_mgr base;
+        Impl* impl;
+    };
+
+    jpeg_decompress_struct cinfo;
+    ErrorManager error;
+    Source source;
+    bool created = false;
+
+    Stage stage = Stage::Idle;
+    int targetWidth = 0;
+    int targetHeight = 0;
+    Allocator allocate;
+    std::uint8_t* pixels = nullptr;
+    std::size_t stride = 0;
+    std::vector<JSAMPROW> rows;
+
+    std::size_t offset = 0;      // stream position of source.base.next_input_byte
+    std::size_t pendingSkip = 0; // skip_input_data() past what was fed
+    bool complete = false;
+
+    Impl()
+    {
+        cinfo.err = jpeg_std_error(&error.base);
+        error.base.error_exit = [](j_common_ptr info) {
+            std::longjmp(reinterpret_cast<ErrorManager*>(info->err)->jump, 1);
+        };
+        error.base.output_message = [](j_common_ptr) {}; // warnings (a truncated picture) are expected
+        if (setjmp(error.jump))
+            return;
+        jpeg_create_decompress(&cinfo);
+        created = true;
+
+        source.impl = this;
+        source.base.init_source = [](j_decompress_ptr) {};
+        source.base.fill_input_buffer = [](j_decompress_ptr info) -> boolean {
+            Impl* impl = reinterpret_cast<Source*>(info->src)->impl;
+            if (!impl->complete)
+                return FALSE; // suspend until the next feed()
+            // Ran past the end of a finished message: end the picture there
+            info->src->next_input_byte = kFakeEoi;
+            info->src->bytes_in_buffer = sizeof(kFakeEoi);
+            impl->offset = static_cast<std::size_t>(-1); // nothing of the caller's buffer is left
+            return TRUE;
+        };
+        source.base.skip_input_data = [](j_decompress_ptr info, long count) {
+            if (count <= 0)
+                return;
+            Impl* impl = reinterpret_cast<Source*>(info->src)->impl;
+            const std::size_t bytes = static_cast<std::size_t>(count);
+            if (bytes <= info->src->bytes_in_buffer) {
+                info->src->next_input_byte += bytes;
+                info->src->bytes_in_buffer -= bytes;
+                return;
+            }
+            impl->pendingSkip += bytes - info->src->bytes_in_buffer;
+            info->src->next_input_byte += info->src->bytes_in_buffer;
+            info->src->bytes_in_buffer = 0;
+        };
+        source.base.resync_to_restart = jpeg_resync_to_restart;
+        source.base.term_source = [](j_decompress_ptr) {};
+        source.base.next_input_byte = nullptr;
+        source.base.bytes_in_buffer = 0;
+        cinfo.src = &source.base;
+    }
+
+    ~Impl()
+    {
+        if (created)
+            jpeg_destroy_decompress(&cinfo);
+    }
+
+    void reset()
+    {
+        if (created && stage != Stage::Idle)
+            jpeg_abort_decompress(&cinfo);
+        stage = Stage::Idle;
+        allocate = Allocator();
+        pixels = nullptr;
+        stride = 0;
+        offset = 0;
+        pendingSkip = 0;
+        complete = false;
+    }
+
+    // One pass as far as the data goes; no C++ objects with destructors live
+    // across the setjmp() (libjpeg errors jump back here)
+    Status run()
+    {
+        if (setjmp(error.jump)) {
+            jpeg_abort_decompress(&cinfo);
+            stage = Stage::Failed;
+            return Status::Failed;
+        }
+        if (stage == Stage::Header) {
+            if (jpeg_read_header(&cinfo, TRUE) != JPEG_HEADER_OK)
+                return Status::NeedData;
+            if (cinfo.jpeg_color_space == JCS_CMYK || cinfo.jpeg_color_space == JCS_YCCK) {
+                jpeg_abort_decompress(&cinfo);
+                stage = Stage::Failed;
+                return Status::Failed;
+            }
+            cinfo.out_color_space = kRgb32ColorSpace;
+            cinfo.dct_method = JDCT_IFAST; // as TurboJpegCodec (TJFLAG_FASTDCT)
+            cinfo.scale_num = 1;
+            cinfo.scale_denom = static_cast<unsigned int>(jpegScaleDenominator(
+                static_cast<int>(cinfo.image_width), static_cast<int>(cinfo.image_height), targetWidth, targetHeight));
+            jpeg_calc_output_dimensions(&cinfo);
+            pixels = allocate ? allocate(static_cast<int>(cinfo.output_width), static_cast<int>(cinfo.output_height),
+                                         stride)
+                              : nullptr;
+            if (!pixels || stride < static_cast<std::size_t>(cinfo.output_width) * 4) {
+                jpeg_abort_decompress(&cinfo);
+                stage = Stage::Failed;
+                return Status::Failed;
+            }
+            stage = Stage::Start;
+        }
+        if (stage == Stage::Start) {
+            if (!jpeg_start_decompress(&cinfo))
+                return Status::NeedData;
+            stage = Stage::Rows;
+        }
+        while (cinfo.output_scanline < cinfo.output_height) {
+            const JDIMENSION first = cinfo.output_scanline;
+            const JDIMENSION count = std::min<JDIMENSION>(cinfo.rec_outbuf_height, cinfo.output_height - first);
+            for (JDIMENSION i = 0; i < count; ++i)
+                rows[i] = pixels + (first + i) * stride;
+            if (jpeg_read_scanlines(&cinfo, rows.data(), count) == 0)
+                return Status::NeedData;
+        }
+        // Every row is out: the rest of the stream (EOI) is not worth waiting for
+        jpeg_abort_decompress(&cinfo);
+        stage = Stage::Done;
+        return Status::Done;
+    }
+};
+
+StreamingJpegDecoder::StreamingJpegDecoder()
+    : m_impl(new Impl)
+{
+    m_impl->rows.resize(16); // rec_outbuf_height is at most 4 (2 for the usual sampling)
+}
+
+StreamingJpegDecoder::~StreamingJpegDecoder() = default;
+
+bool StreamingJpegDecoder::available()
+{
+    return true;
+}
+
+void StreamingJpegDecoder::begin(int targetWidth, int targetHeight, Allocator allocate)
+{
+    m_impl->reset();
+    if (!m_impl->created) {
+        m_impl->stage = Impl::Stage::Failed;
+        return;
+    }
+    m_impl->targetWidth = targetWidth;
+    m_impl->targetHeight = targetHeight;
+    m_impl->allocate = std::move(allocate);
+    m_impl->stage = Impl::Stage::Header;
+}
+
+StreamingJpegDecoder::Status StreamingJpegDecoder::feed(const std::uint8_t* data, std::size_t size, bool complete)
+{
+    Impl& impl = *m_impl;
+    switch (impl.stage) {
+    case Impl::Stage::Done:
+        return Status::Done;
+    case Impl::Stage::Idle:
+    case Impl::Stage::Failed:
+        return Status::Failed;
+    default:
+        break;
+    }
+    if (impl.offset == static_cast<std::size_t>(-1))
+        return Status::Failed; // already ran past the end once
+
+    const std::size_t skip = std::min(impl.pendingSkip, size > impl.offset ? size - impl.offset : 0);
+    impl.offset += skip;
+    impl.pendingSkip -= skip;
+    impl.complete = complete;
+    if (impl.offset >= size && !complete)
+        return Status::NeedData;
+
+    impl.source.base.next_input_byte = data + std::min(impl.offset, size);
+    impl.source.base.bytes_in_buffer = size > impl.offset ? size - impl.offset : 0;
+    const Status status = impl.run();
+    if (impl.offset != static_cast<std::size_t>(-1))
+        impl.offset = static_cast<std::size_t>(impl.source.base.next_input_byte - data);
+    if (status == Status::NeedData && complete) {
+        // Even the fake EOI didn't finish it
+        impl.reset();
+        impl.stage = Impl::Stage::Failed;
+        return Status::Failed;
+    }
+    return status;
+}
+
+void StreamingJpegDecoder::reset()
+{
+    m_impl->reset();
+}
+
+bool StreamingJpegDecoder::active() const
+{
+    return m_impl->stage == Impl::Stage::Header || m_impl->stage == Impl::Stage::Start
+        || m_impl->stage == Impl::Stage::Rows;
+}
+
+int StreamingJpegDecoder::rowsDone() const
+{
+    return m_impl->stage == Impl::Stage::Rows || m_impl->stage == Impl::Stage::Done
+        ? static_cast<int>(m_impl->cinfo.output_scanline) : 0;
+}
+
+#else // IMAGESOCKET_HAVE_LIBJPEG
+
+struct StreamingJpegDecoder::Impl {
+};
+
+StreamingJpegDecoder::StreamingJpegDecoder() = default;
+StreamingJpegDecoder::~StreamingJpegDecoder() = default;
+
+bool StreamingJpegDecoder::available()
+{
+    return false;
+}
+
+void StreamingJpegDecoder::begin(int, int, Allocator)
+{
+}
+
+StreamingJpegDecoder::Status StreamingJpegDecoder::feed(const std::uint8_t*, std::size_t, bool)
+{
+    return Status::Failed;
+}
+
+void StreamingJpegDecoder::reset()
+{
+}
+
+bool StreamingJpegDecoder::active() const
+{
+    return false;
+}
+
+int StreamingJpegDecoder::rowsDone() const
+{
+    return 0;
+}
+
+#endif // IMAGESOCKET_HAVE_LIBJPEG
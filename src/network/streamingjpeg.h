@@ -0,0 +1,59 @@
+#ifndef STREAMINGJPEG_H
+#define STREAMINGJPEG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+// Decodes a JPEG while its bytes are still arriving: every feed() runs the
+// decoder as far as the data goes (libjpeg's suspending data source) and the
+// next one resumes where it stopped, so by the time the last byte of a large
+// frame is in only its last rows remain. Baseline JPEGs come out row by row;
+// progressive ones only decode once complete (no gain, still correct).
+//
+// Pixels go into storage from `Allocator` once the header is in, laid out as
+// QImage::Format_RGB32 (0xffRRGGBB in native byte order), at the DCT scale
+// that covers the target (jpegScaleDenominator()).
+//
+// Needs libjpeg-turbo's libjpeg API (IMAGESOCKET_HAVE_LIBJPEG); without it
+// every feed() fails and callers decode the whole message as before.
+// Not synchronized.
+class StreamingJpegDecoder
+{
+public:
+    enum class Status {
+        NeedData, // suspended: feed more
+        Done,     // every row is in the allocated storage
+        Failed    // not decodable this way (corrupt, CMYK, storage refused)
+    };
+
+    // `width` x `height` pixels of 4 bytes: first row and bytes per row, or null to give up
+    using Allocator = std::function<std::uint8_t*(int width, int height, std::size_t& stride)>;
+
+    StreamingJpegDecoder();
+    ~StreamingJpegDecoder();
+    StreamingJpegDecoder(const StreamingJpegDecoder&) = delete;
+    StreamingJpegDecoder& operator=(const StreamingJpegDecoder&) = delete;
+
+    static bool available();
+
+    // Start a picture shown within `targetWidth` x `targetHeight` (0 x 0: full size)
+    void begin(int targetWidth, int targetHeight, Allocator allocate);
+    // The picture's bytes received so far, from its SOI marker on. `data` may
+    // move between calls (a growing buffer) but keeps what was fed; `complete`
+    // says nothing more comes (a truncated picture then ends in gray rows).
+    Status feed(const std::uint8_t* data, std::size_t size, bool complete);
+    // Drop the picture in progress
+    void reset();
+
+    bool active() const;
+    // Rows written so far (of the scaled picture)
+    int rowsDone() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+#endif // STREAMINGJPEG_H
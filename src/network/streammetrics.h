@@ -0,0 +1,291 @@
+#ifndef STREAMMETRICS_H
+#define STREAMMETRICS_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Per-client receive counters, written on the hot path and read by scrapes
+// on another thread. Every field is a relaxed atomic: recording a frame is a
+// few fetch_adds, and a scrape never waits for (or holds up) the writer.
+struct StreamCounters {
+    // Decode time histogram, upper bucket edges in microseconds (+Inf implied)
+    static const int kDecodeBucketCount = 10;
+    static const std::int64_t* decodeBucketEdgesUs()
+    {
+        static const std::int64_t edges[kDecodeBucketCount] = {1000,   2000,   5000,   10000,  20000,
+                                                               50000, 100000, 200000, 500000, 1000000};
+        return edges;
+    }
+
+    std::atomic<std::uint64_t> framesReceived{0};
+    std::atomic<std::uint64_t> bytesReceived{0};
+    std::atomic<std::uint64_t> framesDropped{0}; // server side: decoder mailbox, video waiting for a keyframe
+    std::atomic<std::uint64_t> framesDecoded{0};
+    std::atomic<std::uint64_t> framesUnchanged{0}; // UNCHANGED heartbeats: frames of a static scene not sent
+    std::atomic<std::uint64_t> decodeBuckets[kDecodeBucketCount + 1] = {}; // last: above every edge
+    std::atomic<std::uint64_t> decodeSumUs{0};
+    // Reported by the client (STATS): its send queue and what it dropped since connecting
+    std::atomic<std::int64_t> clientQueuedFrames{0};
+    std::atomic<std::uint64_t> clientDroppedFrames{0};
+
+    void recordFrame(std::uint64_t bytes)
+    {
+        framesReceived.fetch_add(1, std::memory_order_relaxed);
+        bytesReceived.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    void recordDropped(std::uint64_t count) { framesDropped.fetch_add(count, std::memory_order_relaxed); }
+
+    void recordUnchanged() { framesUnchanged.fetch_add(1, std::memory_order_relaxed); }
+
+    void recordDecode(std::int64_t us)
+    {
+        if (us < 0)
+            us = 0;
+        const std::int64_t* edges = decodeBucketEdgesUs();
+        int bucket = 0;
+        while (bucket < kDecodeBucketCount && us > edges[bucket])
+            ++bucket;
+        decodeBuckets[bucket].fetch_add(1, std::memory_order_relaxed);
+        decodeSumUs.fetch_add(static_cast<std::uint64_t>(us), std::memory_order_relaxed);
+        framesDecoded.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void recordClientQueue(std::int64_t queued, std::uint64_t dropped)
+    {
+        clientQueuedFrames.store(queued, std::memory_order_relaxed);
+        clientDroppedFrames.store(dropped, std::memory_order_relaxed);
+    }
+};
+
+// One stage's latency percentiles (LatencyBreakdown), refreshed periodically
+struct LatencyQuantiles {
+    std::string stage;
+    std::int64_t p50Us = -1;
+    std::int64_t p99Us = -1;
+};
+
+// Registry of the clients' StreamCounters, rendered in the Prometheus text
+// exposition format (version 0.0.4). The writer keeps the shared counters of
+// each client it is given and updates them without touching the registry;
+// the registry's mutex only guards the client list, aliases and latency
+// snapshots (connects, disconnects, periodic publishes, scrapes).
+// Counters of disconnected clients are folded into the server totals.
+class StreamMetrics
+{
+public:
+    // Counters of a client, created on first use
+    std::shared_ptr<StreamCounters> addClient(const std::string& clientId)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Client& client = m_clients[clientId];
+        if (!client.counters)
+            client.counters = std::make_shared<StreamCounters>();
+        return client.counters;
+    }
+
+    void setAlias(const std::string& clientId, const std::string& alias)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_clients.find(clientId);
+        if (it != m_clients.end())
+            it->second.alias = alias;
+    }
+
+    void setLatency(const std::string& clientId, std::vector<LatencyQuantiles> latency)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_clients.find(clientId);
+        if (it != m_clients.end())
+            it->second.latency = std::move(latency);
+    }
+
+    void removeClient(const std::string& clientId)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_clients.find(clientId);
+        if (it == m_clients.end())
+            return;
+        const StreamCounters& counters = *it->second.counters;
+        m_retired.frames += counters.framesReceived.load(std::memory_order_relaxed);
+        m_retired.bytes += counters.bytesReceived.load(std::memory_order_relaxed);
+        m_retired.dropped += counters.framesDropped.load(std::memory_order_relaxed);
+        m_retired.decoded += counters.framesDecoded.load(std::memory_order_relaxed);
+        m_clients.erase(it);
+    }
+
+    std::size_t clientCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_clients.size();
+    }
+
+    // Id and alias of every client, in id order
+    std::vector<std::pair<std::string, std::string>> clients() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::vector<std::pair<std::string, std::string>> list;
+        list.reserve(m_clients.size());
+        for (const auto& entry : m_clients)
+            list.emplace_back(entry.first, entry.second.alias);
+        return list;
+    }
+
+    std::string render() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::string out;
+        out.reserve(1024 + m_clients.size() * 2048);
+
+        Totals totals = m_retired;
+        for (const auto& entry : m_clients) {
+            const StreamCounters& counters = *entry.second.counters;
+            totals.frames += counters.framesReceived.load(std::memory_order_relaxed);
+            totals.bytes += counters.bytesReceived.load(std::memory_order_relaxed);
+            totals.dropped += counters.framesDropped.load(std::memory_order_relaxed);
+            totals.decoded += counters.framesDecoded.load(std::memory_order_relaxed);
+        }
+        header(out, "imagesocket_clients", "gauge", "Connected clients");
+        out += "imagesocket_clients " + std::to_string(m_clients.size()) + "\n";
+        header(out, "imagesocket_server_frames_received_total", "counter", "Frames received from every client");
+        out += "imagesocket_server_frames_received_total " + std::to_string(totals.frames) + "\n";
+        header(out, "imagesocket_server_bytes_received_total", "counter", "Payload bytes received from every client");
+        out += "imagesocket_server_bytes_received_total " + std::to_string(totals.bytes) + "\n";
+        header(out, "imagesocket_server_frames_dropped_total", "counter", "Frames dropped by the server");
+        out += "imagesocket_server_frames_dropped_total " + std::to_string(totals.dropped) + "\n";
+        header(out, "imagesocket_server_frames_decoded_total", "counter", "Frames decoded");
+        out += "imagesocket_server_frames_decoded_total " + std::to_string(totals.decoded) + "\n";
+        if (m_clients.empty())
+            return out;
+
+        perClient(out, "imagesocket_frames_received_total", "counter", "Frames received",
+                  [](const StreamCounters& c) { return std::to_string(c.framesReceived.load(std::memory_order_relaxed)); });
+        perClient(out, "imagesocket_bytes_received_total", "counter", "Payload bytes received",
+                  [](const StreamCounters& c) { return std::to_string(c.bytesReceived.load(std::memory_order_relaxed)); });
+        perClient(out, "imagesocket_frames_dropped_total", "counter", "Frames dropped by the server",
+                  [](const StreamCounters& c) { return std::to_string(c.framesDropped.load(std::memory_order_relaxed)); });
+        perClient(out, "imagesocket_frames_unchanged_total", "counter", "Frames of a static scene the client left out (UNCHANGED)",
+                  [](const StreamCounters& c) { return std::to_string(c.framesUnchanged.load(std::memory_order_relaxed)); });
+        perClient(out, "imagesocket_client_send_queue_frames", "gauge", "Frames in the client's send queue (client report)",
+                  [](const StreamCounters& c) { return std::to_string(c.clientQueuedFrames.load(std::memory_order_relaxed)); });
+        perClient(out, "imagesocket_client_frames_dropped_total", "counter", "Frames the client dropped (client report)",
+                  [](const StreamCounters& c) { return std::to_string(c.clientDroppedFrames.load(std::memory_order_relaxed)); });
+
+        header(out, "imagesocket_decode_seconds", "histogram", "Decode time per frame");
+        for (const auto& entry : m_clients) {
+            const StreamCounters& counters = *entry.second.counters;
+            const std::string labels = clientLabels(entry.first, entry.second.alias);
+            const std::int64_t* edges = StreamCounters::decodeBucketEdgesUs();
+            std::uint64_t cumulative = 0;
+            for (int i = 0; i <= StreamCounters::kDecodeBucketCount; ++i) {
+                cumulative += counters.decodeBuckets[i].load(std::memory_order_relaxed);
+                const std::string le = i < StreamCounters::kDecodeBucketCount ? seconds(edges[i]) : "+Inf";
+                out += "imagesocket_decode_seconds_bucket{" + labels + ",le=\"" + le + "\"} "
+                    + std::to_string(cumulative) + "\n";
+            }
+            out += "imagesocket_decode_seconds_sum{" + labels + "} "
+                + seconds(static_cast<std::int64_t>(counters.decodeSumUs.load(std::memory_order_relaxed))) + "\n";
+            // The buckets' total, so _count matches them even mid-update
+            out += "imagesocket_decode_seconds_count{" + labels + "} " + std::to_string(cumulative) + "\n";
+        }
+
+        header(out, "imagesocket_latency_seconds", "gauge", "Latency percentiles per pipeline stage (fading window)");
+        for (const auto& entry : m_clients) {
+            const std::string labels = clientLabels(entry.first, entry.second.alias);
+            for (const LatencyQuantiles& stage : entry.second.latency) {
+                const std::string stageLabels = labels + ",stage=\"" + escape(stage.stage) + "\"";
+                if (stage.p50Us >= 0)
+                    out += "imagesocket_latency_seconds{" + stageLabels + ",quantile=\"0.5\"} " + seconds(stage.p50Us) + "\n";
+                if (stage.p99Us >= 0)
+                    out += "imagesocket_latency_seconds{" + stageLabels + ",quantile=\"0.99\"} " + seconds(stage.p99Us) + "\n";
+            }
+        }
+        return out;
+    }
+
+    // Label value escaping of the text format: backslash, quote, newline
+    static std::string escape(const std::string& value)
+    {
+        std::string out;
+        out.reserve(value.size());
+        for (char c : value) {
+            if (c == '\\' || c == '"') {
+                out += '\\';
+                out += c;
+            } else if (c == '\n') {
+                out += "\\n";
+            } else {
+                out += c;
+            }
+        }
+        return out;
+    }
+
+    // Microseconds as decimal seconds, independent of the C locale
+    static std::string seconds(std::int64_t us)
+    {
+        const bool negative = us < 0;
+        const std::uint64_t magnitude = negative ? static_cast<std::uint64_t>(-us) : static_cast<std::uint64_t>(us);
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%s%llu.%06llu", negative ? "-" : "",
+                      static_cast<unsigned long long>(magnitude / 1000000),
+                      static_cast<unsigned long long>(magnitude % 1000000));
+        return buffer;
+    }
+
+private:
+    struct Client {
+        std::shared_ptr<StreamCounters> counters;
+        std::string alias;
+        std::vector<LatencyQuantiles> latency;
+    };
+
+    struct Totals {
+        std::uint64_t frames = 0;
+        std::uint64_t bytes = 0;
+        std::uint64_t dropped = 0;
+        std::uint64_t decoded = 0;
+    };
+
+    static void header(std::string& out, const char* name, const char* type, const char* help)
+    {
+        out += "# HELP ";
+        out += name;
+        out += ' ';
+        out += help;
+        out += "\n# TYPE ";
+        out += name;
+        out += ' ';
+        out += type;
+        out += '\n';
+    }
+
+    static std::string clientLabels(const std::string& clientId, const std::string& alias)
+    {
+        return "client=\"" + escape(clientId) + "\",alias=\"" + escape(alias) + "\"";
+    }
+
+    // Requires m_mutex
+    template <typename Value>
+    void perClient(std::string& out, const char* name, const char* type, const char* help, Value value) const
+    {
+        header(out, name, type, help);
+        for (const auto& entry : m_clients) {
+            out += name;
+            out += '{' + clientLabels(entry.first, entry.second.alias) + "} " + value(*entry.second.counters) + '\n';
+        }
+    }
+
+    mutable std::mutex m_mutex;
+    std::map<std::string, Client> m_clients; // sorted: stable scrape order
+    Totals m_retired;                        // counters of disconnected clients
+};
+
+#endif // STREAMMETRICS_H
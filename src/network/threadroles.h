@@ -0,0 +1,322 @@
+#ifndef THREADROLES_H
+#define THREADROLES_H
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// What a thread does, for CPU placement on small boards (a 4-core Raspberry
+// Pi), where socket I/O, decoding, the QML render thread and frame
+// processors otherwise take turns on every core and frame latency jitters
+enum class ThreadRole {
+    Io,           // WebSocket I/O threads (server sessions, the client's connection)
+    Decode,       // FrameDecoder workers
+    Render,       // QML scene graph render thread
+    Processing,   // frame processor workers
+    ClientEncode  // client capture encoders
+};
+
+const int kThreadRoleCount = 5;
+
+// CPU set and scheduling of one role
+struct ThreadRolePolicy {
+    enum Scheduling {
+        Inherit,   // leave it as the thread started
+        Nice,      // SCHED_OTHER at niceness `priority` (-20..19; below 0 needs CAP_SYS_NICE)
+        Fifo,      // SCHED_FIFO at `priority` (1..99, needs CAP_SYS_NICE or an rtprio limit)
+        RoundRobin // SCHED_RR at `priority`
+    };
+
+    std::vector<int> cpus; // empty: any CPU
+    Scheduling scheduling = Inherit;
+    int priority = 0;
+
+    bool configured() const { return !cpus.empty() || scheduling != Inherit; }
+};
+
+using ThreadRoleConfig = std::array<ThreadRolePolicy, kThreadRoleCount>;
+
+// Process-wide thread-role configuration. Threads take their role with
+// apply() as they start (pooled workers at the start of every job: repeating
+// it costs one relaxed load while the configuration is unchanged). Roles
+// without a policy are left alone, so an empty configuration changes nothing.
+// Configure it once at startup, before the threads it should place start.
+//
+// Spec, as given on the command line or in IMAGESOCKET_THREAD_ROLES: roles
+// separated by ';', each `role=cpus[/priority]`. Roles are io, decode,
+// render, processing and client-encode; cpus is a list of CPUs and ranges
+// ("0,2-3") or "*" for any; priority is a niceness ("-5") or "fifo:N" /
+// "rr:N" for real-time scheduling. Example for a 4-core Pi:
+//   io=3/-5;decode=0-1;processing=2/5;render=3/fifo:10
+//
+// Linux only (pthread_setaffinity_np, setpriority on the thread id); elsewhere
+// apply() does nothing.
+class ThreadRoles
+{
+public:
+    static const char* roleName(ThreadRole role)
+    {
+        static const char* const names[kThreadRoleCount] = {"io", "decode", "render", "processing", "client-encode"};
+        return names[static_cast<int>(role)];
+    }
+
+    // False (and `error` set) for a malformed spec; `config` is only written on success
+    static bool parse(const std::string& spec, ThreadRoleConfig& config, std::string* error = nullptr)
+    {
+        ThreadRoleConfig parsed;
+        std::size_t start = 0;
+        while (start <= spec.size()) {
+            std::size_t end = spec.find(';', start);
+            if (end == std::string::npos)
+                end = spec.size();
+            const std::string entry = trim(spec.substr(start, end - start));
+            start = end + 1;
+            if (entry.empty())
+                continue;
+            const std::size_t equals = entry.find('=');
+            int role = -1;
+            if (equals != std::string::npos)
+                role = roleIndex(trim(entry.substr(0, equals)));
+            if (role < 0)
+                return fail(error, "unknown thread role in \"" + entry + "\"");
+            std::string value = trim(entry.substr(equals + 1));
+            ThreadRolePolicy policy;
+            const std::size_t slash = value.find('/');
+            if (slash != std::string::npos) {
+                if (!parsePriority(trim(value.substr(slash + 1)), policy))
+                    return fail(error, "bad priority in \"" + entry + "\"");
+                value = trim(value.substr(0, slash));
+            }
+            if (!parseCpus(value, policy.cpus))
+                return fail(error, "bad CPU list in \"" + entry + "\"");
+            parsed[static_cast<std::size_t>(role)] = policy;
+        }
+        config = parsed;
+        return true;
+    }
+
+    static void configure(const ThreadRoleConfig& config)
+    {
+        State& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.config = config;
+        s.reported = 0;
+        s.generation.fetch_add(1, std::memory_order_release);
+    }
+
+    static ThreadRoleConfig config()
+    {
+        State& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        return s.config;
+    }
+
+    // Configures from IMAGESOCKET_THREAD_ROLES when set; false if it is malformed
+    static bool configureFromEnvironment(std::string* error = nullptr)
+    {
+        const char* value = std::getenv("IMAGESOCKET_THREAD_ROLES");
+        if (!value || !*value)
+            return true;
+        ThreadRoleConfig parsed;
+        if (!parse(value, parsed, error))
+            return false;
+        configure(parsed);
+        return true;
+    }
+
+    // Places the calling thread as its role says. False when the system
+    // refused (each role's first failure is reported on stderr once).
+    static bool apply(ThreadRole role)
+    {
+        State& s = state();
+        const unsigned generation = s.generation.load(std::memory_order_acquire);
+        thread_local unsigned appliedGeneration = 0;
+        thread_local int appliedRole = -1;
+        if (appliedGeneration == generation && appliedRole == static_cast<int>(role))
+            return true;
+        appliedGeneration = generation;
+        appliedRole = static_cast<int>(role);
+        if (generation == 0)
+            return true; // never configured
+
+        ThreadRolePolicy policy;
+        {
+            std::lock_guard<std::mutex> lock(s.mutex);
+            policy = s.config[static_cast<std::size_t>(role)];
+        }
+        std::string error;
+        if (applyPolicy(policy, error))
+            return true;
+        std::lock_guard<std::mutex> lock(s.mutex);
+        const unsigned bit = 1u << static_cast<int>(role);
+        if (!(s.reported & bit)) {
+            s.reported |= bit;
+            std::fprintf(stderr, "thread role %s: %s\n", roleName(role), error.c_str());
+        }
+        return false;
+    }
+
+private:
+    struct State {
+        std::mutex mutex;
+        ThreadRoleConfig config;
+        unsigned reported = 0; // roles whose failure was reported
+        std::atomic<unsigned> generation{0};
+    };
+
+    static State& state()
+    {
+        static State* instance = new State; // threads may still start jobs while the process exits
+        return *instance;
+    }
+
+    static bool fail(std::string* error, const std::string& message)
+    {
+        if (error)
+            *error = message;
+        return false;
+    }
+
+    static std::string trim(const std::string& text)
+    {
+        const std::size_t first = text.find_first_not_of(" \t");
+        if (first == std::string::npos)
+            return std::string();
+        return text.substr(first, text.find_last_not_of(" \t") - first + 1);
+    }
+
+    static int roleIndex(const std::string& name)
+    {
+        for (int i = 0; i < kThreadRoleCount; ++i) {
+            if (name == roleName(static_cast<ThreadRole>(i)))
+                return i;
+        }
+        return -1;
+    }
+
+    // Whole string as a decimal integer
+    static bool toInt(const std::string& text, int& value)
+    {
+        if (text.empty())
+            return false;
+        char* end = nullptr;
+        errno = 0;
+        const long parsed = std::strtol(text.c_str(), &end, 10);
+        if (*end != '\0' || errno != 0 || parsed < -100000 || parsed > 100000)
+            return false;
+        value = static_cast<int>(parsed);
+        return true;
+    }
+
+    static bool parseCpus(const std::string& text, std::vector<int>& cpus)
+    {
+        cpus.clear();
+        if (text == "*" || text.empty())
+            return true;
+        std::size_t start = 0;
+        while (start <= text.size()) {
+            std::size_t end = text.find(',', start);
+            if (end == std::string::npos)
+                end = text.size();
+            const std::string item = trim(text.substr(start, end - start));
+            start = end + 1;
+            const std::size_t dash = item.find('-', 1);
+            int first = 0;
+            int last = 0;
+            if (dash == std::string::npos) {
+                if (!toInt(item, first))
+                    return false;
+                last = first;
+            } else if (!toInt(trim(item.substr(0, dash)), first) || !toInt(trim(item.substr(dash + 1)), last)) {
+                return false;
+            }
+            if (first < 0 || last < first || last >= 1024)
+                return false;
+            for (int cpu = first; cpu <= last; ++cpu)
+                cpus.push_back(cpu);
+        }
+        return true;
+    }
+
+    static bool parsePriority(const std::string& text, ThreadRolePolicy& policy)
+    {
+        const std::size_t colon = text.find(':');
+        if (colon == std::string::npos) {
+            policy.scheduling = ThreadRolePolicy::Nice;
+            return toInt(text, policy.priority) && policy.priority >= -20 && policy.priority <= 19;
+        }
+        const std::string kind = text.substr(0, colon);
+        if (kind == "fifo")
+            policy.scheduling = ThreadRolePolicy::Fifo;
+        else if (kind == "rr")
+            policy.scheduling = ThreadRolePolicy::RoundRobin;
+        else
+            return false;
+        return toInt(text.substr(colon + 1), policy.priority) && policy.priority >= 1 && policy.priority <= 99;
+    }
+
+    static bool applyPolicy(const ThreadRolePolicy& policy, std::string& error)
+    {
+#ifdef __linux__
+        if (!policy.cpus.empty()) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (int cpu : policy.cpus) {
+                if (cpu < CPU_SETSIZE)
+                    CPU_SET(cpu, &set);
+            }
+            const int result = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+            if (result != 0) {
+                error = std::string("CPU affinity: ") + std::strerror(result);
+                return false;
+            }
+        }
+        switch (policy.scheduling) {
+        case ThreadRolePolicy::Inherit:
+            break;
+        case ThreadRolePolicy::Nice: {
+            // Per thread on Linux: the thread id stands for the thread, not the process
+            const id_t thread = static_cast<id_t>(::syscall(SYS_gettid));
+            if (::setpriority(PRIO_PROCESS, thread, policy.priority) != 0) {
+                error = std::string("niceness: ") + std::strerror(errno);
+                return false;
+            }
+            break;
+        }
+        case ThreadRolePolicy::Fifo:
+        case ThreadRolePolicy::RoundRobin: {
+            sched_param param;
+            std::memset(&param, 0, sizeof(param));
+            param.sched_priority = policy.priority;
+            const int result = pthread_setschedparam(
+                pthread_self(), policy.scheduling == ThreadRolePolicy::Fifo ? SCHED_FIFO : SCHED_RR, &param);
+            if (result != 0) {
+                error = std::string("real-time scheduling: ") + std::strerror(result);
+                return false;
+            }
+            break;
+        }
+        }
+        return true;
+#else
+        (void)policy;
+        (void)error;
+        return true;
+#endif
+    }
+};
+
+#endif // THREADROLES_H
@@ -0,0 +1,239 @@
+#ifndef TILEDFRAME_H
+#define TILEDFRAME_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+// Tiled JPEG mode (VideoCodec::TiledJpeg), for mostly static scenes such as
+// dashboards: the picture is cut into square tiles and only the tiles that
+// changed are sent, each as a JPEG of its own. It travels as a video packet
+// (prefix 0x03, videopacket.h), so it is negotiated, relayed and resynchronized
+// like H.264: a packet holding every tile is a keyframe, the server asks for
+// one (REQUEST_KEYFRAME) when it lost track. After the video packet header:
+//
+//   bytes 0-1  width, little-endian
+//   bytes 2-3  height, little-endian
+//   byte 4     tile size in units of 16 pixels (1-255)
+//   byte 5     reserved, 0
+//   bytes 6-7  tiles present, little-endian
+//   bitmap     one bit per tile, row-major, least significant bit first;
+//              ceil(columns * rows / 8) bytes, unused bits 0
+//   tiles      for every bit set, in order: JPEG size (uint32 LE), JPEG
+//
+// Tiles in the last column and row are cut to the picture size.
+const std::size_t kTiledFrameHeaderSize = 8;
+const int kTileSizeUnit = 16;
+
+struct TiledFrameHeader {
+    int width = 0;
+    int height = 0;
+    int tileSize = 64; // pixels, a multiple of kTileSizeUnit
+    int tilesPresent = 0;
+
+    int columns() const { return tileSize > 0 ? (width + tileSize - 1) / tileSize : 0; }
+    int rows() const { return tileSize > 0 ? (height + tileSize - 1) / tileSize : 0; }
+    int tileCount() const { return columns() * rows(); }
+    std::size_t bitmapSize() const { return (static_cast<std::size_t>(tileCount()) + 7) / 8; }
+};
+
+struct TileRect {
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+};
+
+inline TileRect tileRect(const TiledFrameHeader& header, int index)
+{
+    TileRect rect;
+    const int columns = header.columns();
+    if (columns <= 0 || index < 0 || index >= header.tileCount())
+        return rect;
+    rect.x = (index % columns) * header.tileSize;
+    rect.y = (index / columns) * header.tileSize;
+    rect.width = header.width - rect.x < header.tileSize ? header.width - rect.x : header.tileSize;
+    rect.height = header.height - rect.y < header.tileSize ? header.height - rect.y : header.tileSize;
+    return rect;
+}
+
+// Sum of absolute differences of two pixel blocks of `rowBytes` x `rows`.
+// Per-row accumulation over plain bytes: compilers vectorize it (PSADBW / UABAL).
+inline std::uint64_t blockSad(const std::uint8_t* a, std::size_t strideA, const std::uint8_t* b,
+                              std::size_t strideB, std::size_t rowBytes, int rows)
+{
+    std::uint64_t sad = 0;
+    for (int y = 0; y < rows; ++y) {
+        const std::uint8_t* rowA = a + static_cast<std::size_t>(y) * strideA;
+        const std::uint8_t* rowB = b + static_cast<std::size_t>(y) * strideB;
+        std::uint32_t rowSad = 0;
+        for (std::size_t x = 0; x < rowBytes; ++x)
+            rowSad += static_cast<std::uint32_t>(std::abs(static_cast<int>(rowA[x]) - static_cast<int>(rowB[x])));
+        sad += rowSad;
+    }
+    return sad;
+}
+
+namespace tiledframe_detail {
+
+inline std::uint32_t readLe(const std::uint8_t* data, int bytes)
+{
+    std::uint32_t value = 0;
+    for (int i = bytes - 1; i >= 0; --i)
+        value = (value << 8) | data[i];
+    return value;
+}
+
+inline void writeLe(std::uint8_t* data, std::uint32_t value, int bytes)
+{
+    for (int i = 0; i < bytes; ++i) {
+        data[i] = static_cast<std::uint8_t>(value & 0xFF);
+        value >>= 8;
+    }
+}
+
+} // namespace tiledframe_detail
+
+// Appends a tiled frame to a buffer (typically right after the video packet
+// header); tiles have to be added in increasing index order.
+class TiledFrameWriter
+{
+public:
+    // False for sizes the header can't describe
+    bool begin(const TiledFrameHeader& header, std::vector<std::uint8_t>& out)
+    {
+        using tiledframe_detail::writeLe;
+        if (header.width <= 0 || header.width > 0xFFFF || header.height <= 0 || header.height > 0xFFFF
+            || header.tileSize < kTileSizeUnit || header.tileSize % kTileSizeUnit != 0
+            || header.tileSize / kTileSizeUnit > 0xFF || header.tileCount() > 0xFFFF)
+            return false;
+        m_out = &out;
+        m_header = header;
+        m_header.tilesPresent = 0;
+        m_start = out.size();
+        m_lastIndex = -1;
+        out.resize(m_start + kTiledFrameHeaderSize + header.bitmapSize(), 0);
+        std::uint8_t* data = out.data() + m_start;
+        writeLe(data, static_cast<std::uint32_t>(header.width), 2);
+        writeLe(data + 2, static_cast<std::uint32_t>(header.height), 2);
+        data[4] = static_cast<std::uint8_t>(header.tileSize / kTileSizeUnit);
+        return true;
+    }
+
+    bool addTile(int index, const std::uint8_t* jpeg, std::size_t size)
+    {
+        using tiledframe_detail::writeLe;
+        if (!m_out || index <= m_lastIndex || index >= m_header.tileCount() || size > 0xFFFFFFFFu)
+            return false;
+        m_lastIndex = index;
+        std::vector<std::uint8_t>& out = *m_out;
+        out[m_start + kTiledFrameHeaderSize + static_cast<std::size_t>(index / 8)] |=
+            static_cast<std::uint8_t>(1u << (index % 8));
+        const std::size_t at = out.size();
+        out.resize(at + 4 + size);
+        writeLe(out.data() + at, static_cast<std::uint32_t>(size), 4);
+        if (size > 0)
+            std::copy(jpeg, jpeg + size, out.begin() + static_cast<std::ptrdiff_t>(at + 4));
+        writeLe(out.data() + m_start + 6, static_cast<std::uint32_t>(++m_header.tilesPresent), 2);
+        return true;
+    }
+
+    int tilesPresent() const { return m_header.tilesPresent; }
+    // Every tile present: the frame is a keyframe
+    bool complete() const { return m_header.tilesPresent == m_header.tileCount(); }
+
+private:
+    std::vector<std::uint8_t>* m_out = nullptr;
+    TiledFrameHeader m_header;
+    std::size_t m_start = 0;
+    int m_lastIndex = -1;
+};
+
+// Walks the tiles of a received frame without copying them
+class TiledFrameReader
+{
+public:
+    // False on a truncated or inconsistent header
+    bool open(const std::uint8_t* data, std::size_t size)
+    {
+        using tiledframe_detail::readLe;
+        m_failed = true;
+        if (!data || size < kTiledFrameHeaderSize)
+            return false;
+        m_header.width = static_cast<int>(readLe(data, 2));
+        m_header.height = static_cast<int>(readLe(data + 2, 2));
+        m_header.tileSize = data[4] * kTileSizeUnit;
+        m_header.tilesPresent = static_cast<int>(readLe(data + 6, 2));
+        if (m_header.width <= 0 || m_header.height <= 0 || m_header.tileSize <= 0)
+            return false;
+        const std::size_t bitmapSize = m_header.bitmapSize();
+        if (size - kTiledFrameHeaderSize < bitmapSize)
+            return false;
+
+        // The count has to match the bitmap, and bits past the last tile are 0
+        m_bitmap = data + kTiledFrameHeaderSize;
+        int present = 0;
+        for (std::size_t i = 0; i < bitmapSize; ++i) {
+            for (std::uint8_t bits = m_bitmap[i]; bits; bits &= static_cast<std::uint8_t>(bits - 1))
+                ++present;
+        }
+        const int total = m_header.tileCount();
+        if (present != m_header.tilesPresent || (total % 8 != 0 && (m_bitmap[bitmapSize - 1] >> (total % 8)) != 0))
+            return false;
+
+        m_data = data;
+        m_size = size;
+        m_offset = kTiledFrameHeaderSize + bitmapSize;
+        m_index = -1;
+        m_failed = false;
+        return true;
+    }
+
+    // Next tile present: its index and JPEG. False at the end (failed() tells
+    // a truncated payload from a complete one).
+    bool next(int& index, const std::uint8_t*& jpeg, std::size_t& size)
+    {
+        using tiledframe_detail::readLe;
+        if (m_failed)
+            return false;
+        const int total = m_header.tileCount();
+        do {
+            ++m_index;
+        } while (m_index < total && (m_bitmap[m_index / 8] & (1u << (m_index % 8))) == 0);
+        if (m_index >= total) {
+            m_failed = m_offset != m_size; // trailing bytes
+            return false;
+        }
+        if (m_size - m_offset < 4) {
+            m_failed = true;
+            return false;
+        }
+        const std::size_t length = readLe(m_data + m_offset, 4);
+        if (m_size - m_offset - 4 < length) {
+            m_failed = true;
+            return false;
+        }
+        index = m_index;
+        jpeg = m_data + m_offset + 4;
+        size = length;
+        m_offset += 4 + length;
+        return true;
+    }
+
+    const TiledFrameHeader& header() const { return m_header; }
+    bool complete() const { return m_header.tilesPresent == m_header.tileCount(); }
+    bool failed() const { return m_failed; }
+
+private:
+    TiledFrameHeader m_header;
+    const std::uint8_t* m_data = nullptr;
+    const std::uint8_t* m_bitmap = nullptr;
+    std::size_t m_size = 0;
+    std::size_t m_offset = 0;
+    int m_index = -1;
+    bool m_failed = true;
+};
+
+#endif // TILEDFRAME_H
@@ -0,0 +1,128 @@
+#include "tiledjpeg.h"
+#include <algorithm>
+#include <cstring>
+#include "imagepool.h"
+#include "jpegcodec.h"
+#include "tiledframe.h"
+
+TiledJpegEncoder::TiledJpegEncoder(int tileSize, double threshold)
+    : m_tileSize(std::max(1, (tileSize + kTileSizeUnit - 1) / kTileSizeUnit) * kTileSizeUnit),
+      m_threshold(std::max(0.0, threshold))
+{
+}
+
+bool TiledJpegEncoder::encode(const unsigned char* bgr, int width, int height, int stride, int quality,
+                              bool forceKeyframe, std::vector<std::uint8_t>& out)
+{
+    out.clear();
+    m_lastTiles = 0;
+    if (!bgr || width <= 0 || height <= 0 || stride < width * 3)
+        return false;
+
+    const bool keyframe = forceKeyframe || width != m_width || height != m_height || m_reference.empty();
+    const std::size_t referenceStride = static_cast<std::size_t>(width) * 3;
+    if (keyframe) {
+        m_reference.resize(referenceStride * static_cast<std::size_t>(height));
+        m_width = width;
+        m_height = height;
+    }
+
+    TiledFrameHeader header;
+    header.width = width;
+    header.height = height;
+    header.tileSize = m_tileSize;
+    m_tileCount = header.tileCount();
+
+    VideoPacketHeader packet;
+    packet.codec = VideoCodec::TiledJpeg;
+    prepareVideoPacket(packet, 0, out);
+    TiledFrameWriter writer;
+    if (!writer.begin(header, out)) {
+        out.clear();
+        return false;
+    }
+
+    JpegCodec& codec = JpegCodec::forCurrentThread();
+    for (int index = 0; index < m_tileCount; ++index) {
+        const TileRect rect = tileRect(header, index);
+        const unsigned char* source = bgr + static_cast<std::size_t>(rect.y) * static_cast<std::size_t>(stride)
+            + static_cast<std::size_t>(rect.x) * 3;
+        std::uint8_t* reference = m_reference.data() + static_cast<std::size_t>(rect.y) * referenceStride
+            + static_cast<std::size_t>(rect.x) * 3;
+        const std::size_t rowBytes = static_cast<std::size_t>(rect.width) * 3;
+        if (!keyframe) {
+            const std::uint64_t sad = blockSad(source, static_cast<std::size_t>(stride), reference, referenceStride,
+                                               rowBytes, rect.height);
+            if (static_cast<double>(sad) <= m_threshold * static_cast<double>(rowBytes * rect.height))
+                continue;
+        }
+        if (!codec.encodeBgr(source, rect.width, rect.height, stride, quality, m_jpeg)
+            || !writer.addTile(index, m_jpeg.data(), m_jpeg.size())) {
+            // Part of the reference is ahead of what the server has: start over
+            m_reference.clear();
+            out.clear();
+            return false;
+        }
+        for (int y = 0; y < rect.height; ++y)
+            std::memcpy(reference + static_cast<std::size_t>(y) * referenceStride,
+                        source + static_cast<std::size_t>(y) * static_cast<std::size_t>(stride), rowBytes);
+    }
+
+    m_lastTiles = writer.tilesPresent();
+    if (m_lastTiles == 0) {
+        out.clear();
+        return true;
+    }
+    out[1] = writer.complete() ? kVideoPacketKeyframe : 0;
+    return true;
+}
+
+bool TiledJpegDecoder::decode(const std::uint8_t* bitstream, std::size_t size, QImage& out)
+{
+    TiledFrameReader reader;
+    if (!reader.open(bitstream, size))
+        return false;
+    const TiledFrameHeader& header = reader.header();
+    const bool sameSize = !m_frame.isNull() && m_frame.width() == header.width && m_frame.height() == header.height;
+    if (reader.complete()) {
+        // Every tile is replaced: no need to keep the old pixels
+        if (!sameSize || !m_frame.isDetached())
+            m_frame = ImagePool::shared().acquire(header.width, header.height);
+    } else if (!sameSize) {
+        return false; // a delta without the keyframe it builds on
+    } else if (!m_frame.isDetached()) {
+        // The previous frame is still on its way to the screen: patch a copy
+        QImage copy = ImagePool::shared().acquire(header.width, header.height);
+        if (copy.isNull())
+            return false;
+        const int rowBytes = header.width * 4;
+        for (int y = 0; y < header.height; ++y)
+            std::memcpy(copy.scanLine(y), m_frame.constScanLine(y), static_cast<std::size_t>(rowBytes));
+        m_frame = copy;
+    }
+    if (m_frame.isNull())
+        return false;
+
+    JpegCodec& codec = JpegCodec::forCurrentThread();
+    QImage tile;
+    int index = 0;
+    const std::uint8_t* jpeg = nullptr;
+    std::size_t jpegSize = 0;
+    while (reader.next(index, jpeg, jpegSize)) {
+        const TileRect rect = tileRect(header, index);
+        if (!codec.decode(jpeg, static_cast<int>(jpegSize), tile) || tile.width() != rect.width
+            || tile.height() != rect.height || tile.format() != m_frame.format()) {
+            m_frame = QImage(); // partly patched: wait for a keyframe
+            return false;
+        }
+        for (int y = 0; y < rect.height; ++y)
+            std::memcpy(m_frame.scanLine(rect.y + y) + rect.x * 4, tile.constScanLine(y),
+                        static_cast<std::size_t>(rect.width) * 4);
+    }
+    if (reader.failed()) {
+        m_frame = QImage();
+        return false;
+    }
+    out = m_frame;
+    return true;
+}
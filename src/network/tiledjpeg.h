@@ -0,0 +1,58 @@
+#ifndef TILEDJPEG_H
+#define TILEDJPEG_H
+
+#include <QImage>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "videocodec.h"
+
+// Client side of the tiled JPEG mode (tiledframe.h): cuts packed BGR frames
+// into tiles and JPEG-encodes only those that differ from the version of the
+// tile sent last. A tile counts as changed when its mean absolute difference
+// per byte is above `threshold` (0: any difference), so camera noise on a
+// static scene doesn't resend it; a slow change adds up until it does.
+// Instances are not thread-safe (one per stream, like VideoEncoder).
+class TiledJpegEncoder
+{
+public:
+    explicit TiledJpegEncoder(int tileSize = 64, double threshold = 1.0);
+
+    // Encode into `out`: a complete video packet (header and changed tiles)
+    // ready for sendVideoPacket(). Every tile goes out (a keyframe) on the
+    // first call, after a size change or a failed encode, and with
+    // `forceKeyframe`. `out` is left empty when no tile changed.
+    bool encode(const unsigned char* bgr, int width, int height, int stride, int quality,
+                bool forceKeyframe, std::vector<std::uint8_t>& out);
+
+    int tileSize() const { return m_tileSize; }
+    // Tiles in the last packet, and in a whole frame
+    int lastTiles() const { return m_lastTiles; }
+    int tileCount() const { return m_tileCount; }
+
+private:
+    int m_tileSize;
+    double m_threshold;
+    int m_width = 0;
+    int m_height = 0;
+    int m_tileCount = 0;
+    int m_lastTiles = 0;
+    std::vector<std::uint8_t> m_reference; // packed BGR, every tile as last sent
+    std::vector<unsigned char> m_jpeg;     // one tile, capacity reused
+};
+
+// Server side: keeps the client's frame and decodes the tiles of each packet
+// into it. Patched in place while nothing else holds the previous frame,
+// otherwise the unchanged tiles are copied over to a pooled image first
+// (a memcpy, nothing is decoded again). Created by VideoDecoder::create().
+class TiledJpegDecoder : public VideoDecoder
+{
+public:
+    VideoCodec codec() const override { return VideoCodec::TiledJpeg; }
+    bool decode(const std::uint8_t* bitstream, std::size_t size, QImage& out) override;
+
+private:
+    QImage m_frame;
+};
+
+#endif // TILEDJPEG_H
@@ -0,0 +1,558 @@
+#ifndef TLSSTREAM_H
+#define TLSSTREAM_H
+
+#include <boost/asio/compose.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/ssl/error.hpp>
+#include <boost/beast/websocket/teardown.hpp>
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#include <openssl/x509v3.h>
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// TLS settings shared by the connections of one server or client: the
+// certificate, and what makes the next handshake cheap.
+//
+// OpenSSL runs on the socket itself (not on memory buffers, as asio::ssl
+// does), with SSL_OP_ENABLE_KTLS: where the kernel has the tls module and the
+// cipher allows it (AES-GCM), records are encrypted (send) and decrypted
+// (receive) in the kernel after the handshake, and the frame bytes never pass
+// through OpenSSL's buffers. Receive offload needs TLS 1.2 with OpenSSL 3.0
+// and 3.1; TLS 1.3 receive offload came with 3.2. Without offload the same
+// code does TLS in userspace.
+//
+// Reconnects resume the previous session: the server hands out TLS 1.3
+// tickets (or keeps TLS 1.2 sessions in its cache), and a client context
+// offers the last ticket it got, so a reconnect costs no certificate
+// verification or key exchange.
+class TlsContext
+{
+public:
+    ~TlsContext()
+    {
+        if (m_session)
+            SSL_SESSION_free(m_session);
+        SSL_CTX_free(m_ctx);
+    }
+
+    TlsContext(const TlsContext&) = delete;
+    TlsContext& operator=(const TlsContext&) = delete;
+
+    // Server side: PEM certificate chain and private key; null with `error` set on failure
+    static std::shared_ptr<TlsContext> server(const std::string& certFile, const std::string& keyFile,
+                                              std::string* error = nullptr)
+    {
+        std::shared_ptr<TlsContext> tls(new TlsContext(TLS_server_method(), true));
+        if (!tls->m_ctx)
+            return fail(error, "SSL_CTX_new");
+        if (SSL_CTX_use_certificate_chain_file(tls->m_ctx, certFile.c_str()) != 1)
+            return fail(error, "certificate " + certFile);
+        if (SSL_CTX_use_PrivateKey_file(tls->m_ctx, keyFile.c_str(), SSL_FILETYPE_PEM) != 1
+            || SSL_CTX_check_private_key(tls->m_ctx) != 1)
+            return fail(error, "private key " + keyFile);
+        static const unsigned char kSessionContext[] = "imagesocket";
+        SSL_CTX_set_session_id_context(tls->m_ctx, kSessionContext, sizeof(kSessionContext) - 1);
+        SSL_CTX_set_session_cache_mode(tls->m_ctx, SSL_SESS_CACHE_SERVER);
+        return tls;
+    }
+
+    // Client side: verify the server against `caFile` (PEM; empty: the
+    // system's trust store), or not at all (self-signed test setups)
+    static std::shared_ptr<TlsContext> client(const std::string& caFile, bool verifyPeer, std::string* error = nullptr)
+    {
+        std::shared_ptr<TlsContext> tls(new TlsContext(TLS_client_method(), false));
+        if (!tls->m_ctx)
+            return fail(error, "SSL_CTX_new");
+        tls->m_verifyPeer = verifyPeer;
+        if (verifyPeer) {
+            const int loaded = caFile.empty() ? SSL_CTX_set_default_verify_paths(tls->m_ctx)
+                                              : SSL_CTX_load_verify_locations(tls->m_ctx, caFile.c_str(), nullptr);
+            if (loaded != 1)
+                return fail(error, "CA certificates " + (caFile.empty() ? std::string("(system)") : caFile));
+            SSL_CTX_set_verify(tls->m_ctx, SSL_VERIFY_PEER, nullptr);
+        }
+        // Sessions are kept here (one, the latest), not in OpenSSL's cache
+        SSL_CTX_set_session_cache_mode(tls->m_ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+        SSL_CTX_set_ex_data(tls->m_ctx, contextIndex(), tls.get());
+        SSL_CTX_sess_set_new_cb(tls->m_ctx, &TlsContext::onNewSession);
+        return tls;
+    }
+
+    bool isServer() const { return m_server; }
+    bool verifiesPeer() const { return m_verifyPeer; }
+    SSL_CTX* native() const { return m_ctx; }
+
+    // Client: a new connection to `host` (name or address), offering the session to resume
+    SSL* newConnection(const std::string& host) const
+    {
+        SSL* ssl = SSL_new(m_ctx);
+        if (!ssl)
+            return nullptr;
+        if (!m_server) {
+            boost::system::error_code notAddress;
+            boost::asio::ip::make_address(host, notAddress);
+            if (!host.empty() && notAddress) {
+                SSL_set_tlsext_host_name(ssl, host.c_str()); // SNI carries names only
+                if (m_verifyPeer)
+                    SSL_set1_host(ssl, host.c_str());
+            } else if (!host.empty() && m_verifyPeer) {
+                X509_VERIFY_PARAM_set1_ip_asc(SSL_get0_param(ssl), host.c_str());
+            }
+            SSL_set_ex_data(ssl, hostIndex(), new std::string(host));
+            std::lock_guard<std::mutex> lock(m_sessionMutex);
+            if (m_session && host == m_sessionHost)
+                SSL_set_session(ssl, m_session);
+        }
+        return ssl;
+    }
+
+    // Client: drop the stored session (the next handshake is a full one)
+    void forgetSession()
+    {
+        std::lock_guard<std::mutex> lock(m_sessionMutex);
+        if (m_session)
+            SSL_SESSION_free(m_session);
+        m_session = nullptr;
+        m_sessionHost.clear();
+    }
+
+private:
+    TlsContext(const SSL_METHOD* method, bool server) : m_ctx(SSL_CTX_new(method)), m_server(server)
+    {
+        if (!m_ctx)
+            return;
+        SSL_CTX_set_min_proto_version(m_ctx, TLS1_2_VERSION);
+        SSL_CTX_set_mode(m_ctx, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+#ifdef SSL_OP_ENABLE_KTLS
+        SSL_CTX_set_options(m_ctx, SSL_OP_ENABLE_KTLS);
+#endif
+    }
+
+    static std::shared_ptr<TlsContext> fail(std::string* error, const std::string& what)
+    {
+        if (error) {
+            char reason[256] = {0};
+            ERR_error_string_n(ERR_get_error(), reason, sizeof(reason));
+            *error = what + ": " + reason;
+        }
+        ERR_clear_error();
+        return nullptr;
+    }
+
+    static int contextIndex()
+    {
+        static const int index = SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+        return index;
+    }
+
+    // The host a client connection was made for (owned by the SSL)
+    static int hostIndex()
+    {
+        static const int index = SSL_get_ex_new_index(0, nullptr, nullptr, nullptr, &TlsContext::freeHost);
+        return index;
+    }
+
+    static void freeHost(void*, void* host, CRYPTO_EX_DATA*, int, long, void*)
+    {
+        delete static_cast<std::string*>(host);
+    }
+
+    // A ticket (TLS 1.3: after the handshake, with the first reads) or TLS 1.2 session
+    static int onNewSession(SSL* ssl, SSL_SESSION* session)
+    {
+        TlsContext* tls = static_cast<TlsContext*>(SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), contextIndex()));
+        if (!tls)
+            return 0;
+        const std::string* host = static_cast<const std::string*>(SSL_get_ex_data(ssl, hostIndex()));
+        std::lock_guard<std::mutex> lock(tls->m_sessionMutex);
+        if (tls->m_session)
+            SSL_SESSION_free(tls->m_session);
+        tls->m_session = session;
+        tls->m_sessionHost = host ? *host : std::string();
+        return 1; // we keep the reference
+    }
+
+    SSL_CTX* m_ctx = nullptr;
+    bool m_server = false;
+    bool m_verifyPeer = false;
+    mutable std::mutex m_sessionMutex;
+    SSL_SESSION* m_session = nullptr;
+    std::string m_sessionHost;
+};
+
+// The stream under a Beast WebSocket: a TCP socket, plain or with TLS
+// (TlsContext). Plain streams pass every operation straight to the socket;
+// TLS streams drive OpenSSL on the non-blocking socket and wait for it with
+// async_wait whenever OpenSSL wants to read or write. Models Beast's
+// AsyncStream and SyncStream, and tears down like the socket (close_notify
+// first with TLS).
+//
+// Like the socket, one read and one write may be outstanding at a time, on
+// the stream's executor.
+class TlsStream
+{
+public:
+    using socket_type = boost::asio::ip::tcp::socket;
+    using executor_type = socket_type::executor_type;
+
+    explicit TlsStream(socket_type&& socket, std::shared_ptr<TlsContext> tls = nullptr)
+        : m_socket(std::move(socket)), m_tls(std::move(tls))
+    {
+    }
+
+    ~TlsStream()
+    {
+        if (m_ssl)
+            SSL_free(m_ssl);
+    }
+
+    TlsStream(TlsStream&& other) noexcept
+        : m_socket(std::move(other.m_socket)), m_tls(std::move(other.m_tls)), m_ssl(other.m_ssl),
+          m_serverName(std::move(other.m_serverName)), m_scratch(std::move(other.m_scratch))
+    {
+        other.m_ssl = nullptr;
+    }
+    TlsStream& operator=(TlsStream&&) = delete;
+
+    executor_type get_executor() noexcept { return m_socket.get_executor(); }
+    socket_type& socket() { return m_socket; }
+    const socket_type& socket() const { return m_socket; }
+
+    bool secure() const { return m_tls != nullptr; }
+    // Client: name to send (SNI) and to verify the certificate against
+    void setServerName(const std::string& host) { m_serverName = host; }
+
+    // After the handshake
+    bool resumed() const { return m_ssl && SSL_session_reused(m_ssl) == 1; }
+    std::string protocol() const { return m_ssl ? SSL_get_version(m_ssl) : std::string(); }
+    std::string cipher() const { return m_ssl ? SSL_get_cipher_name(m_ssl) : std::string(); }
+    // Records encrypted / decrypted by the kernel (kTLS)
+    bool kernelSend() const
+    {
+#if defined(SSL_OP_ENABLE_KTLS) && !defined(OPENSSL_NO_KTLS)
+        return m_ssl && BIO_get_ktls_send(SSL_get_wbio(m_ssl));
+#else
+        return false;
+#endif
+    }
+    bool kernelReceive() const
+    {
+#if defined(SSL_OP_ENABLE_KTLS) && !defined(OPENSSL_NO_KTLS)
+        return m_ssl && BIO_get_ktls_recv(SSL_get_rbio(m_ssl));
+#else
+        return false;
+#endif
+    }
+
+    // TLS handshake in the context's role; completes at once on plain streams.
+    // Handler: void(boost::system::error_code)
+    template <class Handler>
+    void async_handshake(Handler&& handler)
+    {
+        boost::system::error_code ec;
+        if (secure())
+            prepare(ec);
+        if (!secure() || ec) {
+            boost::asio::post(get_executor(), [handler = std::forward<Handler>(handler), ec]() mutable { handler(ec); });
+            return;
+        }
+        boost::asio::async_compose<Handler, void(boost::system::error_code)>(HandshakeOp{*this}, handler, m_socket);
+    }
+
+    template <class MutableBufferSequence, class ReadHandler>
+    void async_read_some(const MutableBufferSequence& buffers, ReadHandler&& handler)
+    {
+        if (!m_ssl) {
+            m_socket.async_read_some(buffers, std::forward<ReadHandler>(handler));
+            return;
+        }
+        boost::asio::async_compose<ReadHandler, void(boost::system::error_code, std::size_t)>(
+            TransferOp<true, MutableBufferSequence>{*this, buffers}, handler, m_socket);
+    }
+
+    template <class ConstBufferSequence, class WriteHandler>
+    void async_write_some(const ConstBufferSequence& buffers, WriteHandler&& handler)
+    {
+        if (!m_ssl) {
+            m_socket.async_write_some(buffers, std::forward<WriteHandler>(handler));
+            return;
+        }
+        boost::asio::async_compose<WriteHandler, void(boost::system::error_code, std::size_t)>(
+            TransferOp<false, ConstBufferSequence>{*this, buffers}, handler, m_socket);
+    }
+
+    template <class MutableBufferSequence>
+    std::size_t read_some(const MutableBufferSequence& buffers, boost::system::error_code& ec)
+    {
+        if (!m_ssl)
+            return m_socket.read_some(buffers, ec);
+        return transferBlocking(true, firstBuffer(buffers), ec);
+    }
+
+    template <class MutableBufferSequence>
+    std::size_t read_some(const MutableBufferSequence& buffers)
+    {
+        boost::system::error_code ec;
+        const std::size_t bytes = read_some(buffers, ec);
+        if (ec)
+            throw boost::system::system_error(ec);
+        return bytes;
+    }
+
+    template <class ConstBufferSequence>
+    std::size_t write_some(const ConstBufferSequence& buffers, boost::system::error_code& ec)
+    {
+        if (!m_ssl)
+            return m_socket.write_some(buffers, ec);
+        return transferBlocking(false, gather(buffers), ec);
+    }
+
+    template <class ConstBufferSequence>
+    std::size_t write_some(const ConstBufferSequence& buffers)
+    {
+        boost::system::error_code ec;
+        const std::size_t bytes = write_some(buffers, ec);
+        if (ec)
+            throw boost::system::system_error(ec);
+        return bytes;
+    }
+
+    // Best effort close_notify before the socket goes (non-blocking: a full
+    // send buffer skips it)
+    void notifyClose()
+    {
+        if (m_ssl && SSL_is_init_finished(m_ssl)) {
+            SSL_shutdown(m_ssl);
+            ERR_clear_error();
+        }
+    }
+
+private:
+    // Small first buffers (a WebSocket frame header) go out with the start of
+    // the next one in one record instead of a record of their own
+    static const std::size_t kGatherBytes = 16 * 1024;
+
+    struct Span {
+        void* data = nullptr;
+        std::size_t size = 0;
+    };
+
+    void prepare(boost::system::error_code& ec)
+    {
+        if (m_ssl)
+            return;
+        m_socket.non_blocking(true, ec);
+        if (ec)
+            return;
+        m_ssl = m_tls->newConnection(m_serverName);
+        if (!m_ssl || SSL_set_fd(m_ssl, static_cast<int>(m_socket.native_handle())) != 1) {
+            ec = boost::asio::error::no_memory;
+            return;
+        }
+        if (m_tls->isServer())
+            SSL_set_accept_state(m_ssl);
+        else
+            SSL_set_connect_state(m_ssl);
+    }
+
+    template <class MutableBufferSequence>
+    static Span firstBuffer(const MutableBufferSequence& buffers)
+    {
+        for (auto it = boost::asio::buffer_sequence_begin(buffers); it != boost::asio::buffer_sequence_end(buffers); ++it) {
+            const boost::asio::mutable_buffer buffer(*it);
+            if (buffer.size() > 0)
+                return Span{buffer.data(), buffer.size()};
+        }
+        return Span();
+    }
+
+    // The first non-empty buffer, or the first kGatherBytes of the sequence
+    // copied together when that buffer is smaller
+    template <class ConstBufferSequence>
+    Span gather(const ConstBufferSequence& buffers)
+    {
+        Span first;
+        std::size_t total = 0;
+        for (auto it = boost::asio::buffer_sequence_begin(buffers); it != boost::asio::buffer_sequence_end(buffers); ++it) {
+            const boost::asio::const_buffer buffer(*it);
+            if (buffer.size() == 0)
+                continue;
+            if (!first.data) {
+                first = Span{const_cast<void*>(buffer.data()), buffer.size()};
+                if (first.size >= kGatherBytes)
+                    return first;
+                m_scratch.resize(kGatherBytes);
+            }
+            const std::size_t take = std::min(buffer.size(), kGatherBytes - total);
+            std::memcpy(m_scratch.data() + total, buffer.data(), take);
+            total += take;
+            if (total == kGatherBytes)
+                break;
+        }
+        if (!first.data || total == first.size)
+            return first; // a single buffer: no copy needed
+        return Span{m_scratch.data(), total};
+    }
+
+    template <class Buffers>
+    Span span(const Buffers& buffers, std::true_type /*read*/) { return firstBuffer(buffers); }
+    template <class Buffers>
+    Span span(const Buffers& buffers, std::false_type /*write*/) { return gather(buffers); }
+
+    // One SSL_read / SSL_write. Returns the bytes moved (> 0); 0 with `wait`
+    // set to what OpenSSL waits for, or 0 with `ec` set.
+    enum class Wait { None, Read, Write };
+    std::size_t transferOnce(bool read, const Span& span, Wait& wait, boost::system::error_code& ec)
+    {
+        wait = Wait::None;
+        ERR_clear_error();
+        const int size = static_cast<int>(std::min<std::size_t>(span.size, INT_MAX));
+        const int result = read ? SSL_read(m_ssl, span.data, size) : SSL_write(m_ssl, span.data, size);
+        if (result > 0)
+            return static_cast<std::size_t>(result);
+        classify(result, wait, ec);
+        return 0;
+    }
+
+    void classify(int result, Wait& wait, boost::system::error_code& ec)
+    {
+        switch (SSL_get_error(m_ssl, result)) {
+        case SSL_ERROR_WANT_READ:
+            wait = Wait::Read;
+            return;
+        case SSL_ERROR_WANT_WRITE:
+            wait = Wait::Write;
+            return;
+        case SSL_ERROR_ZERO_RETURN:
+            ec = boost::asio::error::eof; // close_notify
+            return;
+        case SSL_ERROR_SYSCALL:
+            ec = errno != 0 ? boost::system::error_code(errno, boost::system::system_category())
+                            : boost::system::error_code(boost::asio::error::eof);
+            return;
+        default:
+            ec = boost::system::error_code(static_cast<int>(ERR_get_error()), boost::asio::error::get_ssl_category());
+            if (!ec)
+                ec = boost::asio::ssl::error::stream_truncated;
+            return;
+        }
+    }
+
+    std::size_t transferBlocking(bool read, const Span& span, boost::system::error_code& ec)
+    {
+        ec = {};
+        if (span.size == 0)
+            return 0;
+        for (;;) {
+            Wait wait = Wait::None;
+            const std::size_t bytes = transferOnce(read, span, wait, ec);
+            if (bytes > 0 || ec)
+                return bytes;
+            m_socket.wait(wait == Wait::Read ? socket_type::wait_read : socket_type::wait_write, ec);
+            if (ec)
+                return 0;
+        }
+    }
+
+    struct HandshakeOp {
+        TlsStream& stream;
+        bool started = false;
+
+        template <class Self>
+        void operator()(Self& self, boost::system::error_code ec = {})
+        {
+            const bool first = !started;
+            started = true;
+            if (!ec) {
+                ERR_clear_error();
+                const int result = SSL_do_handshake(stream.m_ssl);
+                if (result != 1) {
+                    Wait wait = Wait::None;
+                    stream.classify(result, wait, ec);
+                    if (wait != Wait::None) {
+                        stream.m_socket.async_wait(wait == Wait::Read ? socket_type::wait_read : socket_type::wait_write,
+                                                   std::move(self));
+                        return;
+                    }
+                }
+            }
+            if (first) {
+                // Never complete inside the initiating call
+                boost::asio::post(stream.get_executor(), [self = std::move(self), ec]() mutable { self.complete(ec); });
+                return;
+            }
+            self.complete(ec);
+        }
+    };
+
+    template <bool Read, class Buffers>
+    struct TransferOp {
+        TlsStream& stream;
+        Buffers buffers;
+        bool started = false;
+
+        template <class Self>
+        void operator()(Self& self, boost::system::error_code ec = {})
+        {
+            const bool first = !started;
+            started = true;
+            std::size_t bytes = 0;
+            if (!ec) {
+                const Span span = stream.span(buffers, std::integral_constant<bool, Read>());
+                Wait wait = Wait::None;
+                if (span.size > 0)
+                    bytes = stream.transferOnce(Read, span, wait, ec);
+                if (wait != Wait::None) {
+                    stream.m_socket.async_wait(wait == Wait::Read ? socket_type::wait_read : socket_type::wait_write,
+                                               std::move(self));
+                    return;
+                }
+            }
+            if (first) {
+                boost::asio::post(stream.get_executor(),
+                                  [self = std::move(self), ec, bytes]() mutable { self.complete(ec, bytes); });
+                return;
+            }
+            self.complete(ec, bytes);
+        }
+    };
+
+    socket_type m_socket;
+    std::shared_ptr<TlsContext> m_tls;
+    SSL* m_ssl = nullptr;
+    std::string m_serverName;
+    std::vector<unsigned char> m_scratch; // gathered write (at most one write at a time)
+};
+
+// Beast closes the stream this way when an operation times out or fails
+inline void beast_close_socket(TlsStream& stream)
+{
+    boost::system::error_code ec;
+    stream.socket().close(ec);
+}
+
+// Beast's WebSocket close: close_notify, then the socket's own teardown
+inline void teardown(boost::beast::role_type role, TlsStream& stream, boost::system::error_code& ec)
+{
+    stream.notifyClose();
+    boost::beast::websocket::teardown(role, stream.socket(), ec);
+}
+
+template <class TeardownHandler>
+void async_teardown(boost::beast::role_type role, TlsStream& stream, TeardownHandler&& handler)
+{
+    stream.notifyClose();
+    boost::beast::websocket::async_teardown(role, stream.socket(), std::forward<TeardownHandler>(handler));
+}
+
+#endif // TLSSTREAM_H
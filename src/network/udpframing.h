@@ -0,0 +1,458 @@
+#ifndef UDPFRAMING_H
+#define UDPFRAMING_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <vector>
+#include "erasurecode.h"
+#include "frameheader.h"
+
+// Frame transport for lossy links (Wi-Fi): frame messages go over UDP, one
+// WebSocket message each exactly as it would be sent there (prefix byte,
+// FrameHeader, payload), cut into shards with Reed-Solomon parity
+// (erasurecode.h). A frame is rebuilt from any k of its k + m shards, so
+// losses up to the parity share cost nothing; a frame that still misses
+// shards is dropped, never retransmitted: no lost packet holds up the frames
+// behind it as TCP's in-order delivery does. Control stays on the WebSocket.
+//
+// Datagram layout (little endian):
+//   bytes 0-3    magic "ISU1"
+//   bytes 4-7    channel key (UDP_CHANNEL): the connection the frame belongs to
+//   bytes 8-11   frame number, counting up on the channel
+//   bytes 12-15  message size
+//   bytes 16-17  block index
+//   byte  18     data shards in the block (k, 1-64)
+//   byte  19     parity shards in the block (m)
+//   byte  20     shard index: data 0..k-1, parity k..k+m-1
+//   byte  21     reserved, 0
+//   bytes 22-23  shard size (every shard of the frame; the last data shard is cut short)
+// then the shard. Data shard d of block b is the message from (b * 64 + d) *
+// shard size on; blocks bound the decoding work, each has its own parity.
+
+const std::size_t kUdpDatagramHeaderSize = 24;
+// Header and shard: 1176 bytes, within the 1280 bytes IPv6 guarantees once IP and UDP add theirs
+const std::size_t kUdpShardSize = 1152;
+const int kUdpBlockShards = 64;
+const std::uint32_t kUdpMagic = 0x31555349; // "ISU1"
+// Parity shards per data shard: a block survives ~8 % loss with a wide margin
+const double kUdpDefaultFecRatio = 0.2;
+
+struct UdpDatagramHeader {
+    std::uint32_t key = 0;
+    std::uint32_t frame = 0;
+    std::uint32_t messageSize = 0;
+    int block = 0;
+    int dataShards = 0;
+    int parityShards = 0;
+    int index = 0;
+    std::size_t shardSize = 0;
+};
+
+// Data shards of a message and how many of them block `block` holds
+inline std::size_t udpShardCount(std::size_t messageSize, std::size_t shardSize)
+{
+    return shardSize == 0 ? 0 : (messageSize + shardSize - 1) / shardSize;
+}
+
+inline int udpBlockDataShards(std::size_t shards, int block)
+{
+    const std::size_t first = static_cast<std::size_t>(block) * kUdpBlockShards;
+    return first >= shards ? 0 : static_cast<int>(std::min<std::size_t>(kUdpBlockShards, shards - first));
+}
+
+// Parity shards for a block of `dataShards` (at least one unless `fecRatio` is 0)
+inline int udpParityShards(int dataShards, double fecRatio)
+{
+    if (fecRatio <= 0.0 || dataShards <= 0)
+        return 0;
+    const int parity = std::max(1, static_cast<int>(std::ceil(dataShards * fecRatio)));
+    return std::min(parity, 256 - dataShards);
+}
+
+inline void writeUdpDatagramHeader(const UdpDatagramHeader& header, std::uint8_t* out)
+{
+    using frameheader_detail::writeLe;
+    writeLe(out, kUdpMagic, 4);
+    writeLe(out + 4, header.key, 4);
+    writeLe(out + 8, header.frame, 4);
+    writeLe(out + 12, header.messageSize, 4);
+    writeLe(out + 16, static_cast<std::uint64_t>(header.block), 2);
+    out[18] = static_cast<std::uint8_t>(header.dataShards);
+    out[19] = static_cast<std::uint8_t>(header.parityShards);
+    out[20] = static_cast<std::uint8_t>(header.index);
+    out[21] = 0;
+    writeLe(out + 22, header.shardSize, 2);
+}
+
+// Header of a datagram, checked against its own size and the message layout
+inline bool parseUdpDatagramHeader(const std::uint8_t* data, std::size_t size, UdpDatagramHeader& header)
+{
+    using frameheader_detail::readLe;
+    if (!data || size <= kUdpDatagramHeaderSize || readLe(data, 4) != kUdpMagic)
+        return false;
+    header.key = static_cast<std::uint32_t>(readLe(data + 4, 4));
+    header.frame = static_cast<std::uint32_t>(readLe(data + 8, 4));
+    header.messageSize = static_cast<std::uint32_t>(readLe(data + 12, 4));
+    header.block = static_cast<int>(readLe(data + 16, 2));
+    header.dataShards = data[18];
+    header.parityShards = data[19];
+    header.index = data[20];
+    header.shardSize = static_cast<std::size_t>(readLe(data + 22, 2));
+    if (header.messageSize == 0 || header.shardSize == 0 || header.dataShards == 0
+        || header.dataShards + header.parityShards > 256 || header.index >= header.dataShards + header.parityShards)
+        return false;
+    const std::size_t shards = udpShardCount(header.messageSize, header.shardSize);
+    if (udpBlockDataShards(shards, header.block) != header.dataShards)
+        return false;
+    // Parity and every data shard but the message's last are full
+    std::size_t expected = header.shardSize;
+    if (header.index < header.dataShards) {
+        const std::size_t offset = (static_cast<std::size_t>(header.block) * kUdpBlockShards + header.index) * header.shardSize;
+        expected = std::min<std::size_t>(header.shardSize, header.messageSize - offset);
+    }
+    return size - kUdpDatagramHeaderSize == expected;
+}
+
+// Client side: cuts frame messages into datagrams with their parity shards.
+// Buffers are kept between frames. Not synchronized.
+class UdpFrameSender
+{
+public:
+    struct Span {
+        const std::uint8_t* data;
+        std::size_t size;
+    };
+
+    explicit UdpFrameSender(double fecRatio = kUdpDefaultFecRatio, std::size_t shardSize = kUdpShardSize)
+        : m_fecRatio(fecRatio), m_shardSize(std::max<std::size_t>(1, std::min<std::size_t>(shardSize, 0xFFFF)))
+    {
+    }
+
+    // A new channel: frames count from 0 again
+    void setKey(std::uint32_t key)
+    {
+        m_key = key;
+        m_frame = 0;
+    }
+    std::uint32_t key() const { return m_key; }
+    void setFecRatio(double ratio) { m_fecRatio = ratio; }
+    double fecRatio() const { return m_fecRatio; }
+
+    // Datagrams of one message (`parts` in order), each handed to
+    // `send(const std::uint8_t*, std::size_t)`: every block's data shards,
+    // then its parity. Returns how many were sent (0 for an empty message).
+    template <typename Send>
+    std::size_t send(std::initializer_list<Span> parts, Send&& send)
+    {
+        std::size_t total = 0;
+        for (const Span& part : parts)
+            total += part.size;
+        if (total == 0 || total > 0xFFFFFFFFu)
+            return 0;
+
+        const std::size_t shardSize = std::min(m_shardSize, total);
+        const std::size_t shards = udpShardCount(total, shardSize);
+        // Padded to whole shards: parity covers the last one as if it were full of zeros
+        m_message.resize(shards * shardSize);
+        std::uint8_t* out = m_message.data();
+        for (const Span& part : parts) {
+            if (part.size > 0)
+                std::memcpy(out, part.data, part.size);
+            out += part.size;
+        }
+        std::fill(m_message.begin() + static_cast<std::ptrdiff_t>(total), m_message.end(), std::uint8_t(0));
+
+        UdpDatagramHeader header;
+        header.key = m_key;
+        header.frame = m_frame++;
+        header.messageSize = static_cast<std::uint32_t>(total);
+        header.shardSize = shardSize;
+        m_datagram.resize(kUdpDatagramHeaderSize + shardSize);
+
+        std::size_t sent = 0;
+        const int blocks = static_cast<int>((shards + kUdpBlockShards - 1) / kUdpBlockShards);
+        for (int block = 0; block < blocks; ++block) {
+            const int k = udpBlockDataShards(shards, block);
+            const int m = udpParityShards(k, m_fecRatio);
+            const std::size_t first = static_cast<std::size_t>(block) * kUdpBlockShards;
+            header.block = block;
+            header.dataShards = k;
+            header.parityShards = m;
+
+            m_dataPtrs.resize(static_cast<std::size_t>(k));
+            for (int i = 0; i < k; ++i) {
+                const std::size_t offset = (first + static_cast<std::size_t>(i)) * shardSize;
+                m_dataPtrs[static_cast<std::size_t>(i)] = m_message.data() + offset;
+                header.index = i;
+                const std::size_t length = std::min(shardSize, total - offset);
+                writeUdpDatagramHeader(header, m_datagram.data());
+                std::memcpy(m_datagram.data() + kUdpDatagramHeaderSize, m_message.data() + offset, length);
+                send(static_cast<const std::uint8_t*>(m_datagram.data()), kUdpDatagramHeaderSize + length);
+                ++sent;
+            }
+            if (m == 0)
+                continue;
+
+            m_parity.resize(static_cast<std::size_t>(m) * shardSize);
+            m_parityPtrs.resize(static_cast<std::size_t>(m));
+            for (int j = 0; j < m; ++j)
+                m_parityPtrs[static_cast<std::size_t>(j)] = m_parity.data() + static_cast<std::size_t>(j) * shardSize;
+            erasureEncode(m_dataPtrs.data(), k, m_parityPtrs.data(), m, shardSize);
+            for (int j = 0; j < m; ++j) {
+                header.index = k + j;
+                writeUdpDatagramHeader(header, m_datagram.data());
+                std::memcpy(m_datagram.data() + kUdpDatagramHeaderSize, m_parityPtrs[static_cast<std::size_t>(j)], shardSize);
+                send(static_cast<const std::uint8_t*>(m_datagram.data()), kUdpDatagramHeaderSize + shardSize);
+                ++sent;
+            }
+        }
+        return sent;
+    }
+
+private:
+    double m_fecRatio;
+    std::size_t m_shardSize;
+    std::uint32_t m_key = 0;
+    std::uint32_t m_frame = 0;
+    std::vector<std::uint8_t> m_message;
+    std::vector<std::uint8_t> m_datagram;
+    std::vector<std::uint8_t> m_parity;
+    std::vector<const std::uint8_t*> m_dataPtrs;
+    std::vector<std::uint8_t*> m_parityPtrs;
+};
+
+// What a UdpFrameAssembler did with the frames of its channel
+struct UdpAssemblyStats {
+    std::uint64_t frames = 0;    // delivered
+    std::uint64_t recovered = 0; // delivered with shards rebuilt from parity
+    std::uint64_t late = 0;      // incomplete when a newer frame was delivered or given up
+    std::uint64_t expired = 0;   // incomplete past the age limit (or pushed out by newer ones)
+    std::uint64_t malformed = 0; // datagrams that fit no frame layout
+};
+
+// Server side, one per channel: rebuilds frame messages from their datagrams
+// in any order and delivers each as soon as every block has k shards. Frames
+// are delivered in order only: once one is delivered or given up, older
+// incomplete ones are dropped, and a frame still incomplete `maxFrameAgeUs`
+// after its first datagram is given up, so no frame is ever waited on longer
+// than that. Not synchronized.
+class UdpFrameAssembler
+{
+public:
+    explicit UdpFrameAssembler(std::int64_t maxFrameAgeUs = 150000, std::size_t maxMessageSize = 64u << 20,
+                               std::size_t maxPendingFrames = 8)
+        : m_maxFrameAgeUs(maxFrameAgeUs), m_maxMessageSize(maxMessageSize),
+          m_maxPendingFrames(std::max<std::size_t>(1, maxPendingFrames))
+    {
+    }
+
+    // A datagram received at `nowUs`; the message of a frame it completes goes
+    // to `deliver(const std::uint8_t*, std::size_t)` before this returns.
+    // False for a datagram of no valid layout (counted as malformed).
+    template <typename Deliver>
+    bool push(const std::uint8_t* data, std::size_t size, std::int64_t nowUs, Deliver&& deliver)
+    {
+        UdpDatagramHeader header;
+        if (!parseUdpDatagramHeader(data, size, header) || header.messageSize > m_maxMessageSize) {
+            ++m_stats.malformed;
+            return false;
+        }
+        expire(nowUs);
+        if (m_hasFloor && !isNewer(header.frame, m_floor))
+            return true; // a frame already delivered or given up
+
+        Pending* pending = find(header.frame);
+        if (!pending)
+            pending = add(header, nowUs);
+        if (pending->messageSize != header.messageSize || pending->shardSize != header.shardSize) {
+            ++m_stats.malformed;
+            return false;
+        }
+
+        Block& block = pending->blocks[static_cast<std::size_t>(header.block)];
+        if (block.done)
+            return true;
+        if (block.have.empty()) {
+            block.k = header.dataShards;
+            block.m = header.parityShards;
+            block.have.assign(static_cast<std::size_t>(block.k + block.m), 0);
+            block.parity.resize(static_cast<std::size_t>(block.m) * pending->shardSize);
+        } else if (block.m != header.parityShards) {
+            ++m_stats.malformed;
+            return false;
+        }
+        if (block.have[static_cast<std::size_t>(header.index)])
+            return true; // duplicate
+
+        const std::uint8_t* shard = data + kUdpDatagramHeaderSize;
+        const std::size_t length = size - kUdpDatagramHeaderSize;
+        if (header.index < block.k) {
+            std::uint8_t* out = dataShard(*pending, header.block, header.index);
+            std::memcpy(out, shard, length);
+            std::fill(out + length, out + pending->shardSize, std::uint8_t(0)); // the padding parity saw
+        } else {
+            std::memcpy(block.parity.data() + static_cast<std::size_t>(header.index - block.k) * pending->shardSize,
+                        shard, length);
+        }
+        block.have[static_cast<std::size_t>(header.index)] = 1;
+        if (++block.received < block.k)
+            return true;
+
+        if (!completeBlock(*pending, header.block)) {
+            ++m_stats.malformed;
+            return false;
+        }
+        if (--pending->blocksLeft > 0)
+            return true;
+
+        deliver(static_cast<const std::uint8_t*>(pending->message.data()), static_cast<std::size_t>(pending->messageSize));
+        ++m_stats.frames;
+        if (pending->recovered)
+            ++m_stats.recovered;
+        advanceTo(pending->frame);
+        return true;
+    }
+
+    // Give up frames still incomplete past the age limit (push() does this too)
+    void expire(std::int64_t nowUs)
+    {
+        for (std::size_t i = 0; i < m_pending.size(); ++i) {
+            if (nowUs - m_pending[i].firstUs > m_maxFrameAgeUs) {
+                ++m_stats.expired;
+                advanceTo(m_pending[i].frame);
+                i = static_cast<std::size_t>(-1); // the list changed: start over
+            }
+        }
+    }
+
+    std::size_t pendingFrames() const { return m_pending.size(); }
+    const UdpAssemblyStats& stats() const { return m_stats; }
+
+private:
+    struct Block {
+        int k = 0;
+        int m = 0;
+        int received = 0;
+        bool done = false;
+        std::vector<std::uint8_t> have; // per shard, data then parity
+        std::vector<std::uint8_t> parity;
+    };
+    struct Pending {
+        std::uint32_t frame = 0;
+        std::uint32_t messageSize = 0;
+        std::size_t shardSize = 0;
+        std::int64_t firstUs = 0;
+        int blocksLeft = 0;
+        bool recovered = false;
+        std::vector<std::uint8_t> message; // whole shards, the last one padded
+        std::vector<Block> blocks;
+    };
+
+    // Serial number order: frame numbers wrap around
+    static bool isNewer(std::uint32_t a, std::uint32_t b) { return static_cast<std::int32_t>(a - b) > 0; }
+
+    Pending* find(std::uint32_t frame)
+    {
+        for (Pending& pending : m_pending) {
+            if (pending.frame == frame)
+                return &pending;
+        }
+        return nullptr;
+    }
+
+    Pending* add(const UdpDatagramHeader& header, std::int64_t nowUs)
+    {
+        if (m_pending.size() >= m_maxPendingFrames) {
+            // Full: the oldest frame goes (and any older than it, none)
+            std::size_t oldest = 0;
+            for (std::size_t i = 1; i < m_pending.size(); ++i) {
+                if (isNewer(m_pending[oldest].frame, m_pending[i].frame))
+                    oldest = i;
+            }
+            ++m_stats.expired;
+            advanceTo(m_pending[oldest].frame);
+        }
+        Pending pending;
+        pending.frame = header.frame;
+        pending.messageSize = header.messageSize;
+        pending.shardSize = header.shardSize;
+        pending.firstUs = nowUs;
+        const std::size_t shards = udpShardCount(header.messageSize, header.shardSize);
+        const std::size_t blocks = (shards + kUdpBlockShards - 1) / kUdpBlockShards;
+        pending.blocksLeft = static_cast<int>(blocks);
+        pending.blocks.resize(blocks);
+        // Every shard is written (received or rebuilt) before delivery: a recycled buffer needs no clearing
+        if (!m_spare.empty()) {
+            pending.message.swap(m_spare.back());
+            m_spare.pop_back();
+        }
+        pending.message.resize(shards * header.shardSize);
+        m_pending.push_back(std::move(pending));
+        return &m_pending.back();
+    }
+
+    // `frame` was delivered or given up: it and every older frame are done
+    void advanceTo(std::uint32_t frame)
+    {
+        if (!m_hasFloor || isNewer(frame, m_floor)) {
+            m_hasFloor = true;
+            m_floor = frame;
+        }
+        for (std::size_t i = 0; i < m_pending.size();) {
+            if (isNewer(m_pending[i].frame, m_floor)) {
+                ++i;
+                continue;
+            }
+            if (m_pending[i].frame != frame)
+                ++m_stats.late;
+            if (m_spare.size() < 2)
+                m_spare.push_back(std::move(m_pending[i].message));
+            m_pending.erase(m_pending.begin() + static_cast<std::ptrdiff_t>(i));
+        }
+    }
+
+    static std::uint8_t* dataShard(Pending& pending, int block, int index)
+    {
+        return pending.message.data()
+            + (static_cast<std::size_t>(block) * kUdpBlockShards + static_cast<std::size_t>(index)) * pending.shardSize;
+    }
+
+    // A block with k shards: rebuild its missing data shards, if any
+    bool completeBlock(Pending& pending, int blockIndex)
+    {
+        Block& block = pending.blocks[static_cast<std::size_t>(blockIndex)];
+        block.done = true;
+        if (std::find(block.have.begin(), block.have.begin() + block.k, std::uint8_t(0)) != block.have.begin() + block.k) {
+            m_dataPtrs.resize(static_cast<std::size_t>(block.k));
+            for (int i = 0; i < block.k; ++i)
+                m_dataPtrs[static_cast<std::size_t>(i)] = dataShard(pending, blockIndex, i);
+            m_parityPtrs.resize(static_cast<std::size_t>(block.m));
+            for (int j = 0; j < block.m; ++j)
+                m_parityPtrs[static_cast<std::size_t>(j)] = block.parity.data() + static_cast<std::size_t>(j) * pending.shardSize;
+            if (!erasureRecover(m_dataPtrs.data(), block.have.data(), block.k, m_parityPtrs.data(),
+                                block.have.data() + block.k, block.m, pending.shardSize))
+                return false;
+            pending.recovered = true;
+        }
+        std::vector<std::uint8_t>().swap(block.parity);
+        return true;
+    }
+
+    std::int64_t m_maxFrameAgeUs;
+    std::size_t m_maxMessageSize;
+    std::size_t m_maxPendingFrames;
+    std::vector<Pending> m_pending;
+    std::vector<std::vector<std::uint8_t>> m_spare; // message buffers of finished frames
+    // Frames up to m_floor were delivered or given up
+    bool m_hasFloor = false;
+    std::uint32_t m_floor = 0;
+    UdpAssemblyStats m_stats;
+    std::vector<std::uint8_t*> m_dataPtrs;
+    std::vector<const std::uint8_t*> m_parityPtrs;
+};
+
+#endif // UDPFRAMING_H
@@ -0,0 +1,389 @@
+#include "v4l2m2mdecoder.h"
+#include "jpegheader.h"
+#include <linux/videodev2.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace {
+
+const std::uint32_t kOutputType = V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE;
+const std::uint32_t kCaptureType = V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
+const unsigned kCaptureBuffers = 2;
+const int kDecodeTimeoutMs = 1000;
+const std::size_t kMinOutputSize = 512 * 1024;
+const int kMaxScannedDevices = 64;
+
+int xioctl(int fd, unsigned long request, void* arg)
+{
+    int result;
+    do {
+        result = ioctl(fd, request, arg);
+    } while (result == -1 && errno == EINTR);
+    return result;
+}
+
+// Compressed JPEG format accepted on the device's OUTPUT queue, or 0
+std::uint32_t jpegOutputFormat(int fd)
+{
+    v4l2_capability cap;
+    std::memset(&cap, 0, sizeof(cap));
+    if (xioctl(fd, VIDIOC_QUERYCAP, &cap) != 0)
+        return 0;
+    const std::uint32_t caps = (cap.capabilities & V4L2_CAP_DEVICE_CAPS) ? cap.device_caps : cap.capabilities;
+    if (!(caps & V4L2_CAP_VIDEO_M2M_MPLANE) || !(caps & V4L2_CAP_STREAMING))
+        return 0;
+
+    v4l2_fmtdesc desc;
+    std::memset(&desc, 0, sizeof(desc));
+    desc.type = kOutputType;
+    for (desc.index = 0; xioctl(fd, VIDIOC_ENUM_FMT, &desc) == 0; ++desc.index) {
+        if (desc.pixelformat == V4L2_PIX_FMT_MJPEG || desc.pixelformat == V4L2_PIX_FMT_JPEG)
+            return desc.pixelformat;
+    }
+    return 0;
+}
+
+} // namespace
+
+V4l2M2mDecoder::V4l2M2mDecoder(int fd, std::string path, std::uint32_t codedFormat)
+    : m_fd(fd), m_path(std::move(path)), m_codedFormat(codedFormat)
+{
+}
+
+V4l2M2mDecoder::~V4l2M2mDecoder()
+{
+    teardown();
+    if (m_fd >= 0)
+        ::close(m_fd);
+}
+
+std::unique_ptr<V4l2M2mDecoder> V4l2M2mDecoder::open(const std::string& devicePath)
+{
+    std::vector<std::string> candidates;
+    if (!devicePath.empty()) {
+        candidates.push_back(devicePath);
+    } else {
+        for (int i = 0; i < kMaxScannedDevices; ++i)
+            candidates.push_back("/dev/video" + std::to_string(i));
+    }
+
+    for (const std::string& path : candidates) {
+        const int fd = ::open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0)
+            continue;
+
+        const std::uint32_t format = jpegOutputFormat(fd);
+        if (format == 0) {
+            ::close(fd);
+            continue;
+        }
+
+        // Resolution changes are signalled as events (POLLPRI)
+        v4l2_event_subscription sub;
+        std::memset(&sub, 0, sizeof(sub));
+        sub.type = V4L2_EVENT_SOURCE_CHANGE;
+        xioctl(fd, VIDIOC_SUBSCRIBE_EVENT, &sub);
+
+        return std::unique_ptr<V4l2M2mDecoder>(new V4l2M2mDecoder(fd, path, format));
+    }
+    return nullptr;
+}
+
+bool V4l2M2mDecoder::decode(const std::uint8_t* data, std::size_t size, YuvFrameView& frame)
+{
+    JpegHeaderInfo header;
+    if (!parseJpegHeader(data, size, header) || header.progressive || header.components != 3)
+        return false;
+
+    if (!m_streaming || header.width != m_width || header.height != m_height || size > m_outputCapacity) {
+        if (!configure(header.width, header.height, size))
+            return false;
+    }
+
+    // The previous frame's view is released now: hand its buffer back to the driver
+    if (m_heldCapture >= 0) {
+        queueCapture(static_cast<unsigned>(m_heldCapture));
+        m_heldCapture = -1;
+    }
+
+    std::memcpy(m_output[0].data, data, size);
+
+    v4l2_plane plane;
+    std::memset(&plane, 0, sizeof(plane));
+    plane.bytesused = static_cast<std::uint32_t>(size);
+    v4l2_buffer buf;
+    std::memset(&buf, 0, sizeof(buf));
+    buf.type = kOutputType;
+    buf.memory = V4L2_MEMORY_MMAP;
+    buf.index = 0;
+    buf.m.planes = &plane;
+    buf.length = 1;
+    if (xioctl(m_fd, VIDIOC_QBUF, &buf) != 0) {
+        teardown();
+        return false;
+    }
+
+    for (;;) {
+        pollfd pfd;
+        pfd.fd = m_fd;
+        pfd.events = POLLIN | POLLPRI;
+        pfd.revents = 0;
+        const int ready = ::poll(&pfd, 1, kDecodeTimeoutMs);
+        if (ready <= 0 || (pfd.revents & (POLLERR | POLLNVAL))) {
+            teardown(); // timed out or device error: start from scratch next time
+            return false;
+        }
+
+        if (pfd.revents & POLLPRI) {
+            if (!handleSourceChange()) {
+                teardown();
+                return false;
+            }
+            continue;
+        }
+
+        v4l2_plane capturePlane;
+        std::memset(&capturePlane, 0, sizeof(capturePlane));
+        v4l2_buffer captured;
+        std::memset(&captured, 0, sizeof(captured));
+        captured.type = kCaptureType;
+        captured.memory = V4L2_MEMORY_MMAP;
+        captured.m.planes = &capturePlane;
+        captured.length = 1;
+        if (xioctl(m_fd, VIDIOC_DQBUF, &captured) != 0) {
+            if (errno == EAGAIN)
+                continue;
+            teardown();
+            return false;
+        }
+
+        reclaimOutput();
+
+        if ((captured.flags & V4L2_BUF_FLAG_ERROR) || capturePlane.bytesused == 0) {
+            queueCapture(captured.index);
+            return false;
+        }
+
+        m_heldCapture = static_cast<int>(captured.index);
+        const std::uint8_t* base = static_cast<const std::uint8_t*>(m_capture[captured.index].data);
+        const std::size_t lumaSize = static_cast<std::size_t>(m_captureStride) * m_captureHeight;
+
+        frame.width = m_width;
+        frame.height = m_height;
+        frame.y = base;
+        frame.yStride = m_captureStride;
+        frame.u = base + lumaSize;
+        if (m_capturePixelFormat == V4L2_PIX_FMT_NV12) {
+            frame.layout = YuvLayout::NV12;
+            frame.uvStride = m_captureStride;
+            frame.v = nullptr;
+        } else {
+            frame.layout = YuvLayout::I420;
+            frame.uvStride = m_captureStride / 2;
+            frame.v = frame.u + static_cast<std::size_t>(frame.uvStride) * (m_captureHeight / 2);
+        }
+        return true;
+    }
+}
+
+bool V4l2M2mDecoder::configure(int width, int height, std::size_t frameSize)
+{
+    teardown();
+
+    v4l2_format output;
+    std::memset(&output, 0, sizeof(output));
+    output.type = kOutputType;
+    output.fmt.pix_mp.pixelformat = m_codedFormat;
+    output.fmt.pix_mp.width = static_cast<std::uint32_t>(width);
+    output.fmt.pix_mp.height = static_cast<std::uint32_t>(height);
+    output.fmt.pix_mp.num_planes = 1;
+    // Headroom so slightly larger frames at the same resolution don't force a reconfigure
+    output.fmt.pix_mp.plane_fmt[0].sizeimage = static_cast<std::uint32_t>(std::max(frameSize * 2, kMinOutputSize));
+    if (xioctl(m_fd, VIDIOC_S_FMT, &output) != 0)
+        return false;
+    m_outputCapacity = output.fmt.pix_mp.plane_fmt[0].sizeimage;
+
+    m_width = width;
+    m_height = height;
+
+    v4l2_format capture;
+    std::memset(&capture, 0, sizeof(capture));
+    capture.type = kCaptureType;
+    capture.fmt.pix_mp.pixelformat = V4L2_PIX_FMT_YUV420;
+    capture.fmt.pix_mp.width = static_cast<std::uint32_t>(width);
+    capture.fmt.pix_mp.height = static_cast<std::uint32_t>(height);
+    capture.fmt.pix_mp.num_planes = 1;
+    if (xioctl(m_fd, VIDIOC_S_FMT, &capture) != 0)
+        return false;
+
+    if (!mapBuffers(kOutputType, 1, m_output) || m_output[0].length < frameSize) {
+        teardown();
+        return false;
+    }
+
+    int type = static_cast<int>(kOutputType);
+    if (xioctl(m_fd, VIDIOC_STREAMON, &type) != 0 || !setupCapture()) {
+        teardown();
+        return false;
+    }
+
+    m_streaming = true;
+    return true;
+}
+
+bool V4l2M2mDecoder::setupCapture()
+{
+    // The driver may have adjusted the format (alignment, or after a source change)
+    v4l2_format capture;
+    std::memset(&capture, 0, sizeof(capture));
+    capture.type = kCaptureType;
+    if (xioctl(m_fd, VIDIOC_G_FMT, &capture) != 0)
+        return false;
+
+    const std::uint32_t pixfmt = capture.fmt.pix_mp.pixelformat;
+    if ((pixfmt != V4L2_PIX_FMT_YUV420 && pixfmt != V4L2_PIX_FMT_NV12) || capture.fmt.pix_mp.num_planes != 1)
+        return false;
+
+    m_capturePixelFormat = pixfmt;
+    m_captureStride = static_cast<int>(capture.fmt.pix_mp.plane_fmt[0].bytesperline);
+    m_captureHeight = static_cast<int>(capture.fmt.pix_mp.height);
+    if (m_captureStride < m_width || m_captureHeight < m_height)
+        return false;
+
+    if (!mapBuffers(kCaptureType, kCaptureBuffers, m_capture))
+        return false;
+    for (unsigned i = 0; i < m_capture.size(); ++i) {
+        if (!queueCapture(i))
+            return false;
+    }
+
+    int type = static_cast<int>(kCaptureType);
+    return xioctl(m_fd, VIDIOC_STREAMON, &type) == 0;
+}
+
+void V4l2M2mDecoder::teardownCapture()
+{
+    int type = static_cast<int>(kCaptureType);
+    xioctl(m_fd, VIDIOC_STREAMOFF, &type);
+    unmapBuffers(kCaptureType, m_capture);
+    m_heldCapture = -1;
+}
+
+void V4l2M2mDecoder::teardown()
+{
+    if (m_fd < 0)
+        return;
+
+    teardownCapture();
+    int type = static_cast<int>(kOutputType);
+    xioctl(m_fd, VIDIOC_STREAMOFF, &type);
+    unmapBuffers(kOutputType, m_output);
+
+    m_streaming = false;
+    m_width = 0;
+    m_height = 0;
+    m_outputCapacity = 0;
+}
+
+bool V4l2M2mDecoder::mapBuffers(std::uint32_t type, unsigned count, std::vector<MappedBuffer>& buffers)
+{
+    v4l2_requestbuffers request;
+    std::memset(&request, 0, sizeof(request));
+    request.count = count;
+    request.type = type;
+    request.memory = V4L2_MEMORY_MMAP;
+    if (xioctl(m_fd, VIDIOC_REQBUFS, &request) != 0 || request.count == 0)
+        return false;
+
+    for (unsigned i = 0; i < request.count; ++i) {
+        v4l2_plane planes[VIDEO_MAX_PLANES];
+        std::memset(planes, 0, sizeof(planes));
+        v4l2_buffer buf;
+        std::memset(&buf, 0, sizeof(buf));
+        buf.type = type;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = i;
+        buf.m.planes = planes;
+        buf.length = VIDEO_MAX_PLANES;
+        if (xioctl(m_fd, VIDIOC_QUERYBUF, &buf) != 0)
+            return false;
+
+        MappedBuffer mapped;
+        mapped.length = planes[0].length;
+        mapped.data = ::mmap(nullptr, mapped.length, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, planes[0].m.mem_offset);
+        if (mapped.data == MAP_FAILED)
+            return false;
+        buffers.push_back(mapped);
+    }
+    return true;
+}
+
+void V4l2M2mDecoder::unmapBuffers(std::uint32_t type, std::vector<MappedBuffer>& buffers)
+{
+    for (const MappedBuffer& mapped : buffers)
+        ::munmap(mapped.data, mapped.length);
+    buffers.clear();
+
+    // Release the driver-side allocation as well
+    v4l2_requestbuffers request;
+    std::memset(&request, 0, sizeof(request));
+    request.count = 0;
+    request.type = type;
+    request.memory = V4L2_MEMORY_MMAP;
+    xioctl(m_fd, VIDIOC_REQBUFS, &request);
+}
+
+bool V4l2M2mDecoder::queueCapture(unsigned index)
+{
+    v4l2_plane plane;
+    std::memset(&plane, 0, sizeof(plane));
+    v4l2_buffer buf;
+    std::memset(&buf, 0, sizeof(buf));
+    buf.type = kCaptureType;
+    buf.memory = V4L2_MEMORY_MMAP;
+    buf.index = index;
+    buf.m.planes = &plane;
+    buf.length = 1;
+    return xioctl(m_fd, VIDIOC_QBUF, &buf) == 0;
+}
+
+bool V4l2M2mDecoder::reclaimOutput()
+{
+    // The bitstream buffer is normally consumed by the time the picture is ready
+    pollfd pfd;
+    pfd.fd = m_fd;
+    pfd.events = POLLOUT;
+    pfd.revents = 0;
+    if (::poll(&pfd, 1, kDecodeTimeoutMs) <= 0)
+        return false;
+
+    v4l2_plane plane;
+    std::memset(&plane, 0, sizeof(plane));
+    v4l2_buffer buf;
+    std::memset(&buf, 0, sizeof(buf));
+    buf.type = kOutputType;
+    buf.memory = V4L2_MEMORY_MMAP;
+    buf.m.planes = &plane;
+    buf.length = 1;
+    return xioctl(m_fd, VIDIOC_DQBUF, &buf) == 0;
+}
+
+bool V4l2M2mDecoder::handleSourceChange()
+{
+    v4l2_event event;
+    std::memset(&event, 0, sizeof(event));
+    if (xioctl(m_fd, VIDIOC_DQEVENT, &event) != 0)
+        return false;
+    if (event.type != V4L2_EVENT_SOURCE_CHANGE)
+        return true;
+
+    // Reallocate the capture queue for the format the driver detected
+    teardownCapture();
+    return setupCapture();
+}
@@ -0,0 +1,71 @@
+#ifndef V4L2M2MDECODER_H
+#define V4L2M2MDECODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "yuvconvert.h"
+
+// JPEG decoder on a V4L2 memory-to-memory codec device (e.g. the Raspberry Pi's
+// bcm2835-codec at /dev/video10). Uses the multi-planar API with MMAP buffers:
+// the JPEG goes into the OUTPUT queue, the picture comes back on the CAPTURE
+// queue as I420 or NV12. Baseline JPEG only; callers fall back to software for
+// anything else.
+//
+// One instance owns one device context and is not thread-safe.
+class V4l2M2mDecoder
+{
+public:
+    ~V4l2M2mDecoder();
+
+    V4l2M2mDecoder(const V4l2M2mDecoder&) = delete;
+    V4l2M2mDecoder& operator=(const V4l2M2mDecoder&) = delete;
+
+    // Open `devicePath`, or the first /dev/video* M2M device that accepts JPEG
+    // when empty. Returns nullptr when no usable device exists.
+    static std::unique_ptr<V4l2M2mDecoder> open(const std::string& devicePath = std::string());
+
+    // Decode one frame. On success `frame` views the driver's capture buffer and
+    // stays valid until the next decode() call.
+    bool decode(const std::uint8_t* data, std::size_t size, YuvFrameView& frame);
+
+    const std::string& devicePath() const { return m_path; }
+
+private:
+    struct MappedBuffer {
+        void* data = nullptr;
+        std::size_t length = 0;
+    };
+
+    V4l2M2mDecoder(int fd, std::string path, std::uint32_t codedFormat);
+
+    bool configure(int width, int height, std::size_t frameSize);
+    bool setupCapture();
+    void teardownCapture();
+    void teardown();
+    bool mapBuffers(std::uint32_t type, unsigned count, std::vector<MappedBuffer>& buffers);
+    void unmapBuffers(std::uint32_t type, std::vector<MappedBuffer>& buffers);
+    bool queueCapture(unsigned index);
+    bool reclaimOutput();
+    bool handleSourceChange();
+
+    int m_fd = -1;
+    std::string m_path;
+    std::uint32_t m_codedFormat = 0;
+
+    int m_width = 0;
+    int m_height = 0;
+    bool m_streaming = false;
+    std::size_t m_outputCapacity = 0;
+
+    std::vector<MappedBuffer> m_output;
+    std::vector<MappedBuffer> m_capture;
+    std::uint32_t m_capturePixelFormat = 0;
+    int m_captureStride = 0;
+    int m_captureHeight = 0;
+    int m_heldCapture = -1; // capture buffer viewed by the last frame
+};
+
+#endif // V4L2M2MDECODER_H
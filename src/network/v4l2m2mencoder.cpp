@@ -0,0 +1,555 @@
+#include "v4l2m2mencoder.h"
+#include <linux/videodev2.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+
+namespace {
+
+const std::uint32_t kOutputType = V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE;
+const std::uint32_t kCaptureType = V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
+const unsigned kOutputBuffers = 2;
+const unsigned kCaptureBuffers = 2;
+const int kEncodeTimeoutMs = 1000;
+const std::size_t kMinCaptureSize = 512 * 1024;
+const int kMaxScannedDevices = 64;
+
+int xioctl(int fd, unsigned long request, void* arg)
+{
+    int result;
+    do {
+        result = ioctl(fd, request, arg);
+    } while (result == -1 && errno == EINTR);
+    return result;
+}
+
+// Controls are best effort: drivers differ in which ones they implement
+void setControl(int fd, std::uint32_t id, std::int32_t value)
+{
+    v4l2_control control;
+    std::memset(&control, 0, sizeof(control));
+    control.id = id;
+    control.value = value;
+    xioctl(fd, VIDIOC_S_CTRL, &control);
+}
+
+bool isVideo(V4l2M2mEncoder::Format format)
+{
+    return format != V4l2M2mEncoder::Format::Jpeg;
+}
+
+// JPEG-style quality (1-100) to a bitrate of 0.02 to 0.16 bits per pixel:
+// 720p at 30 fps and quality 75 is about 3.5 Mbit/s
+std::int32_t bitrateForQuality(int width, int height, int fps, int quality)
+{
+    quality = std::max(1, std::min(100, quality));
+    const double bitsPerPixel = 0.02 + 0.14 * quality / 100.0;
+    return static_cast<std::int32_t>(std::min(double(INT_MAX), double(width) * height * fps * bitsPerPixel));
+}
+
+bool hasCapability(int fd)
+{
+    v4l2_capability cap;
+    std::memset(&cap, 0, sizeof(cap));
+    if (xioctl(fd, VIDIOC_QUERYCAP, &cap) != 0)
+        return false;
+    const std::uint32_t caps = (cap.capabilities & V4L2_CAP_DEVICE_CAPS) ? cap.device_caps : cap.capabilities;
+    return (caps & V4L2_CAP_VIDEO_M2M_MPLANE) && (caps & V4L2_CAP_STREAMING);
+}
+
+std::vector<std::uint32_t> enumFormats(int fd, std::uint32_t type)
+{
+    std::vector<std::uint32_t> formats;
+    v4l2_fmtdesc desc;
+    std::memset(&desc, 0, sizeof(desc));
+    desc.type = type;
+    for (desc.index = 0; xioctl(fd, VIDIOC_ENUM_FMT, &desc) == 0; ++desc.index)
+        formats.push_back(desc.pixelformat);
+    return formats;
+}
+
+bool contains(const std::vector<std::uint32_t>& formats, std::uint32_t format)
+{
+    return std::find(formats.begin(), formats.end(), format) != formats.end();
+}
+
+// Compressed format for `format` on the device's CAPTURE queue, or 0
+std::uint32_t codedFormatFor(V4l2M2mEncoder::Format format, const std::vector<std::uint32_t>& formats)
+{
+    switch (format) {
+    case V4l2M2mEncoder::Format::Jpeg:
+        if (contains(formats, V4L2_PIX_FMT_JPEG))
+            return V4L2_PIX_FMT_JPEG;
+        return contains(formats, V4L2_PIX_FMT_MJPEG) ? V4L2_PIX_FMT_MJPEG : 0;
+    case V4l2M2mEncoder::Format::H264:
+        return contains(formats, V4L2_PIX_FMT_H264) ? V4L2_PIX_FMT_H264 : 0;
+    case V4l2M2mEncoder::Format::H265:
+        return contains(formats, V4L2_PIX_FMT_HEVC) ? V4L2_PIX_FMT_HEVC : 0;
+    }
+    return 0;
+}
+
+} // namespace
+
+V4l2M2mEncoder::V4l2M2mEncoder(int fd, std::string path, Format format, std::uint32_t codedFormat,
+                               std::vector<std::uint32_t> rawFormats)
+    : m_fd(fd), m_path(std::move(path)), m_format(format), m_codedFormat(codedFormat),
+      m_rawFormats(std::move(rawFormats))
+{
+}
+
+V4l2M2mEncoder::~V4l2M2mEncoder()
+{
+    teardown();
+    if (m_fd >= 0)
+        ::close(m_fd);
+}
+
+std::unique_ptr<V4l2M2mEncoder> V4l2M2mEncoder::open(Format format, const std::string& devicePath)
+{
+    std::vector<std::string> candidates;
+    if (!devicePath.empty()) {
+        candidates.push_back(devicePath);
+    } else {
+        for (int i = 0; i < kMaxScannedDevices; ++i)
+            candidates.push_back("/dev/video" + std::to_string(i));
+    }
+
+    for (const std::string& path : candidates) {
+        const int fd = ::open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0)
+            continue;
+
+        const std::uint32_t coded = hasCapability(fd) ? codedFormatFor(format, enumFormats(fd, kCaptureType)) : 0;
+        std::vector<std::uint32_t> raw;
+        if (coded != 0) {
+            for (std::uint32_t pixfmt : enumFormats(fd, kOutputType)) {
+                if (pixfmt == V4L2_PIX_FMT_YUV420 || pixfmt == V4L2_PIX_FMT_NV12 || pixfmt == V4L2_PIX_FMT_BGR24)
+                    raw.push_back(pixfmt);
+            }
+        }
+        if (raw.empty()) {
+            ::close(fd);
+            continue;
+        }
+
+        return std::unique_ptr<V4l2M2mEncoder>(new V4l2M2mEncoder(fd, path, format, coded, std::move(raw)));
+    }
+    return nullptr;
+}
+
+bool V4l2M2mEncoder::encodeBgr(const std::uint8_t* pixels, int width, int height, int stride, int quality,
+                               int fps, bool forceKeyframe, std::vector<std::uint8_t>& out, std::size_t offset)
+{
+    Input input;
+    input.bgr = pixels;
+    input.bgrStride = stride;
+    input.width = width;
+    input.height = height;
+    return encodeInput(input, quality, fps, forceKeyframe, out, offset);
+}
+
+bool V4l2M2mEncoder::encode(const YuvFrameView& picture, int quality, int fps, bool forceKeyframe,
+                            std::vector<std::uint8_t>& out, std::size_t offset)
+{
+    Input input;
+    input.yuv = picture;
+    input.width = picture.width;
+    input.height = picture.height;
+    input.limitedRange = picture.limitedRange;
+    return encodeInput(input, quality, fps, forceKeyframe, out, offset);
+}
+
+bool V4l2M2mEncoder::encodeInput(const Input& input, int quality, int fps, bool forceKeyframe,
+                                 std::vector<std::uint8_t>& out, std::size_t offset)
+{
+    if (input.width <= 0 || input.height <= 0)
+        return false;
+    fps = isVideo(m_format) ? (fps > 0 ? fps : 30) : 0;
+
+    const std::uint32_t rawFormat = rawFormatFor(input);
+    if (rawFormat == 0)
+        return false;
+
+    if (!m_streaming || input.width != m_width || input.height != m_height || rawFormat != m_rawFormat
+        || fps != m_fps || input.limitedRange != m_limitedRange) {
+        if (!configure(input, rawFormat, fps, quality))
+            return false;
+    } else if (quality != m_quality) {
+        applyQuality(quality);
+    }
+    if (forceKeyframe && isVideo(m_format))
+        setControl(m_fd, V4L2_CID_MPEG_VIDEO_FORCE_KEY_FRAME, 1);
+
+    const int index = acquireOutput();
+    if (index < 0) {
+        teardown();
+        return false;
+    }
+    MappedBuffer& output = m_output[static_cast<std::size_t>(index)];
+    fillOutput(input, static_cast<std::uint8_t*>(output.data));
+
+    v4l2_plane plane;
+    std::memset(&plane, 0, sizeof(plane));
+    plane.bytesused = static_cast<std::uint32_t>(m_outputSize);
+    plane.length = static_cast<std::uint32_t>(output.length);
+    v4l2_buffer buf;
+    std::memset(&buf, 0, sizeof(buf));
+    buf.type = kOutputType;
+    buf.memory = V4L2_MEMORY_MMAP;
+    buf.index = static_cast<std::uint32_t>(index);
+    buf.m.planes = &plane;
+    buf.length = 1;
+    if (xioctl(m_fd, VIDIOC_QBUF, &buf) != 0) {
+        teardown();
+        return false;
+    }
+    output.queued = true;
+
+    for (;;) {
+        pollfd pfd;
+        pfd.fd = m_fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        const int ready = ::poll(&pfd, 1, kEncodeTimeoutMs);
+        if (ready <= 0 || (pfd.revents & (POLLERR | POLLNVAL))) {
+            teardown(); // timed out or device error: start from scratch next time
+            return false;
+        }
+
+        v4l2_plane capturePlane;
+        std::memset(&capturePlane, 0, sizeof(capturePlane));
+        v4l2_buffer captured;
+        std::memset(&captured, 0, sizeof(captured));
+        captured.type = kCaptureType;
+        captured.memory = V4L2_MEMORY_MMAP;
+        captured.m.planes = &capturePlane;
+        captured.length = 1;
+        if (xioctl(m_fd, VIDIOC_DQBUF, &captured) != 0) {
+            if (errno == EAGAIN)
+                continue;
+            teardown();
+            return false;
+        }
+
+        dequeueOutput(0); // usually consumed by now; otherwise reclaimed before the next frame
+
+        const std::uint32_t dataOffset = std::min(capturePlane.data_offset, capturePlane.bytesused);
+        const std::size_t size = capturePlane.bytesused - dataOffset;
+        if ((captured.flags & V4L2_BUF_FLAG_ERROR) || size == 0) {
+            queueCapture(captured.index);
+            return false;
+        }
+
+        const std::uint8_t* bitstream = static_cast<const std::uint8_t*>(m_capture[captured.index].data) + dataOffset;
+        out.resize(offset + size);
+        std::memcpy(out.data() + offset, bitstream, size);
+        m_keyframe = !isVideo(m_format) || (captured.flags & V4L2_BUF_FLAG_KEYFRAME) != 0;
+        queueCapture(captured.index);
+        return true;
+    }
+}
+
+std::uint32_t V4l2M2mEncoder::rawFormatFor(const Input& input) const
+{
+    // BGR goes in as is when the device converts it, otherwise it is converted on the
+    // way into the buffer; YUV prefers its own layout. Both 4:2:0 layouts are copied
+    // or re-interleaved; BGR24 can't take a YUV picture.
+    if (input.bgr && contains(m_rawFormats, V4L2_PIX_FMT_BGR24))
+        return V4L2_PIX_FMT_BGR24;
+    const std::uint32_t own = input.bgr || input.yuv.layout == YuvLayout::I420 ? V4L2_PIX_FMT_YUV420 : V4L2_PIX_FMT_NV12;
+    if (contains(m_rawFormats, own))
+        return own;
+    const std::uint32_t other = own == V4L2_PIX_FMT_YUV420 ? V4L2_PIX_FMT_NV12 : V4L2_PIX_FMT_YUV420;
+    return contains(m_rawFormats, other) ? other : 0;
+}
+
+bool V4l2M2mEncoder::configure(const Input& input, std::uint32_t rawFormat, int fps, int quality)
+{
+    teardown();
+
+    // The coded side first: the driver derives the raw side's constraints from it
+    v4l2_format capture;
+    std::memset(&capture, 0, sizeof(capture));
+    capture.type = kCaptureType;
+    capture.fmt.pix_mp.pixelformat = m_codedFormat;
+    capture.fmt.pix_mp.width = static_cast<std::uint32_t>(input.width);
+    capture.fmt.pix_mp.height = static_cast<std::uint32_t>(input.height);
+    capture.fmt.pix_mp.num_planes = 1;
+    const std::size_t pictureSize = static_cast<std::size_t>(input.width) * input.height * 3 / 2;
+    capture.fmt.pix_mp.plane_fmt[0].sizeimage = static_cast<std::uint32_t>(std::max(pictureSize, kMinCaptureSize));
+    if (xioctl(m_fd, VIDIOC_S_FMT, &capture) != 0)
+        return false;
+
+    v4l2_format output;
+    std::memset(&output, 0, sizeof(output));
+    output.type = kOutputType;
+    output.fmt.pix_mp.pixelformat = rawFormat;
+    output.fmt.pix_mp.width = static_cast<std::uint32_t>(input.width);
+    output.fmt.pix_mp.height = static_cast<std::uint32_t>(input.height);
+    output.fmt.pix_mp.num_planes = 1;
+    output.fmt.pix_mp.colorspace = input.limitedRange ? V4L2_COLORSPACE_SMPTE170M : V4L2_COLORSPACE_JPEG;
+    output.fmt.pix_mp.ycbcr_enc = V4L2_YCBCR_ENC_601;
+    output.fmt.pix_mp.quantization = input.limitedRange ? V4L2_QUANTIZATION_LIM_RANGE : V4L2_QUANTIZATION_FULL_RANGE;
+    if (xioctl(m_fd, VIDIOC_S_FMT, &output) != 0)
+        return false;
+
+    // The driver may have aligned the stride and the rows per plane
+    const v4l2_pix_format_mplane& raw = output.fmt.pix_mp;
+    const int bytesPerPixel = rawFormat == V4L2_PIX_FMT_BGR24 ? 3 : 1;
+    if (raw.pixelformat != rawFormat || raw.num_planes != 1 || int(raw.width) != input.width
+        || int(raw.height) < input.height || int(raw.plane_fmt[0].bytesperline) < input.width * bytesPerPixel)
+        return false;
+    m_outputStride = static_cast<int>(raw.plane_fmt[0].bytesperline);
+    m_outputSize = raw.plane_fmt[0].sizeimage;
+    m_outputHeight = static_cast<int>(raw.height);
+    if (rawFormat != V4L2_PIX_FMT_BGR24) {
+        // Chroma follows the luma plane's aligned height, which sizeimage reveals
+        // (drivers size 4:2:0 buffers as stride * aligned height * 3 / 2)
+        const int alignedHeight = static_cast<int>(m_outputSize * 2 / 3 / static_cast<std::size_t>(m_outputStride));
+        m_outputHeight = std::max(m_outputHeight, alignedHeight & ~1);
+    }
+    const std::size_t planeBytes = static_cast<std::size_t>(m_outputStride) * m_outputHeight;
+    if (m_outputSize < (rawFormat == V4L2_PIX_FMT_BGR24 ? planeBytes : planeBytes * 3 / 2))
+        return false;
+
+    m_width = input.width;
+    m_height = input.height;
+    m_rawFormat = rawFormat;
+    m_fps = fps;
+    m_limitedRange = input.limitedRange;
+
+    if (isVideo(m_format)) {
+        v4l2_streamparm parm;
+        std::memset(&parm, 0, sizeof(parm));
+        parm.type = kOutputType;
+        parm.parm.output.timeperframe.numerator = 1;
+        parm.parm.output.timeperframe.denominator = static_cast<std::uint32_t>(fps);
+        xioctl(m_fd, VIDIOC_S_PARM, &parm);
+
+        // Low latency and self-contained keyframes, as the libavcodec encoder is set
+        // up: no B-frames, periodic keyframes, parameter sets with every keyframe and
+        // in the same buffer as the picture (one packet per frame)
+        setControl(m_fd, V4L2_CID_MPEG_VIDEO_B_FRAMES, 0);
+        setControl(m_fd, V4L2_CID_MPEG_VIDEO_GOP_SIZE, fps * 2);
+        if (m_format == Format::H264)
+            setControl(m_fd, V4L2_CID_MPEG_VIDEO_H264_I_PERIOD, fps * 2);
+        setControl(m_fd, V4L2_CID_MPEG_VIDEO_REPEAT_SEQ_HEADER, 1);
+        setControl(m_fd, V4L2_CID_MPEG_VIDEO_HEADER_MODE, V4L2_MPEG_VIDEO_HEADER_MODE_JOINED_WITH_1ST_FRAME);
+    }
+    applyQuality(quality);
+
+    if (!mapBuffers(kOutputType, kOutputBuffers, m_output) || m_output[0].length < m_outputSize
+        || !mapBuffers(kCaptureType, kCaptureBuffers, m_capture)) {
+        teardown();
+        return false;
+    }
+    for (unsigned i = 0; i < m_capture.size(); ++i) {
+        if (!queueCapture(i)) {
+            teardown();
+            return false;
+        }
+    }
+
+    int outputType = static_cast<int>(kOutputType);
+    int captureType = static_cast<int>(kCaptureType);
+    if (xioctl(m_fd, VIDIOC_STREAMON, &outputType) != 0 || xioctl(m_fd, VIDIOC_STREAMON, &captureType) != 0) {
+        teardown();
+        return false;
+    }
+
+    m_streaming = true;
+    return true;
+}
+
+void V4l2M2mEncoder::applyQuality(int quality)
+{
+    quality = std::max(1, std::min(100, quality));
+    if (isVideo(m_format))
+        setControl(m_fd, V4L2_CID_MPEG_VIDEO_BITRATE, bitrateForQuality(m_width, m_height, m_fps, quality));
+    else
+        setControl(m_fd, V4L2_CID_JPEG_COMPRESSION_QUALITY, quality);
+    m_quality = quality;
+}
+
+void V4l2M2mEncoder::teardown()
+{
+    if (m_fd < 0)
+        return;
+
+    int type = static_cast<int>(kCaptureType);
+    xioctl(m_fd, VIDIOC_STREAMOFF, &type);
+    unmapBuffers(kCaptureType, m_capture);
+    type = static_cast<int>(kOutputType);
+    xioctl(m_fd, VIDIOC_STREAMOFF, &type);
+    unmapBuffers(kOutputType, m_output);
+
+    m_streaming = false;
+    m_width = 0;
+    m_height = 0;
+    m_fps = 0;
+    m_rawFormat = 0;
+    m_outputSize = 0;
+}
+
+bool V4l2M2mEncoder::mapBuffers(std::uint32_t type, unsigned count, std::vector<MappedBuffer>& buffers)
+{
+    v4l2_requestbuffers request;
+    std::memset(&request, 0, sizeof(request));
+    request.count = count;
+    request.type = type;
+    request.memory = V4L2_MEMORY_MMAP;
+    if (xioctl(m_fd, VIDIOC_REQBUFS, &request) != 0 || request.count == 0)
+        return false;
+
+    for (unsigned i = 0; i < request.count; ++i) {
+        v4l2_plane planes[VIDEO_MAX_PLANES];
+        std::memset(planes, 0, sizeof(planes));
+        v4l2_buffer buf;
+        std::memset(&buf, 0, sizeof(buf));
+        buf.type = type;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = i;
+        buf.m.planes = planes;
+        buf.length = VIDEO_MAX_PLANES;
+        if (xioctl(m_fd, VIDIOC_QUERYBUF, &buf) != 0)
+            return false;
+
+        MappedBuffer mapped;
+        mapped.length = planes[0].length;
+        mapped.data = ::mmap(nullptr, mapped.length, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, planes[0].m.mem_offset);
+        if (mapped.data == MAP_FAILED)
+            return false;
+        buffers.push_back(mapped);
+    }
+    return true;
+}
+
+void V4l2M2mEncoder::unmapBuffers(std::uint32_t type, std::vector<MappedBuffer>& buffers)
+{
+    for (const MappedBuffer& mapped : buffers)
+        ::munmap(mapped.data, mapped.length);
+    buffers.clear();
+
+    // Release the driver-side allocation as well
+    v4l2_requestbuffers request;
+    std::memset(&request, 0, sizeof(request));
+    request.count = 0;
+    request.type = type;
+    request.memory = V4L2_MEMORY_MMAP;
+    xioctl(m_fd, VIDIOC_REQBUFS, &request);
+}
+
+bool V4l2M2mEncoder::queueCapture(unsigned index)
+{
+    v4l2_plane plane;
+    std::memset(&plane, 0, sizeof(plane));
+    plane.length = static_cast<std::uint32_t>(m_capture[index].length);
+    v4l2_buffer buf;
+    std::memset(&buf, 0, sizeof(buf));
+    buf.type = kCaptureType;
+    buf.memory = V4L2_MEMORY_MMAP;
+    buf.index = index;
+    buf.m.planes = &plane;
+    buf.length = 1;
+    return xioctl(m_fd, VIDIOC_QBUF, &buf) == 0;
+}
+
+int V4l2M2mEncoder::acquireOutput()
+{
+    // A video encoder may hold on to a picture for a while (as a reference)
+    for (;;) {
+        for (std::size_t i = 0; i < m_output.size(); ++i) {
+            if (!m_output[i].queued)
+                return static_cast<int>(i);
+        }
+        if (!dequeueOutput(kEncodeTimeoutMs))
+            return -1;
+    }
+}
+
+bool V4l2M2mEncoder::dequeueOutput(int timeoutMs)
+{
+    if (timeoutMs > 0) {
+        pollfd pfd;
+        pfd.fd = m_fd;
+        pfd.events = POLLOUT;
+        pfd.revents = 0;
+        if (::poll(&pfd, 1, timeoutMs) <= 0)
+            return false;
+    }
+
+    v4l2_plane plane;
+    std::memset(&plane, 0, sizeof(plane));
+    v4l2_buffer buf;
+    std::memset(&buf, 0, sizeof(buf));
+    buf.type = kOutputType;
+    buf.memory = V4L2_MEMORY_MMAP;
+    buf.m.planes = &plane;
+    buf.length = 1;
+    if (xioctl(m_fd, VIDIOC_DQBUF, &buf) != 0 || buf.index >= m_output.size())
+        return false;
+    m_output[buf.index].queued = false;
+    return true;
+}
+
+void V4l2M2mEncoder::fillOutput(const Input& input, std::uint8_t* dst) const
+{
+    if (m_rawFormat == V4L2_PIX_FMT_BGR24) {
+        for (int row = 0; row < input.height; ++row)
+            std::memcpy(dst + row * m_outputStride, input.bgr + row * input.bgrStride,
+                        static_cast<std::size_t>(input.width) * 3);
+        return;
+    }
+
+    YuvPlanes planes;
+    planes.y = dst;
+    planes.yStride = m_outputStride;
+    planes.u = dst + static_cast<std::size_t>(m_outputStride) * m_outputHeight;
+    if (m_rawFormat == V4L2_PIX_FMT_NV12) {
+        planes.layout = YuvLayout::NV12;
+        planes.uvStride = m_outputStride;
+    } else {
+        planes.uvStride = m_outputStride / 2;
+        planes.v = planes.u + static_cast<std::size_t>(planes.uvStride) * (m_outputHeight / 2);
+    }
+
+    if (input.bgr) {
+        bgrToYuv420(input.bgr, input.width, input.height, input.bgrStride, planes);
+        return;
+    }
+
+    const YuvFrameView& src = input.yuv;
+    for (int row = 0; row < input.height; ++row)
+        std::memcpy(planes.y + row * planes.yStride, src.y + row * src.yStride, static_cast<std::size_t>(input.width));
+
+    const int chromaWidth = (input.width + 1) / 2;
+    for (int row = 0; row < (input.height + 1) / 2; ++row) {
+        const std::uint8_t* srcU = src.u + row * src.uvStride;
+        std::uint8_t* dstU = planes.u + row * planes.uvStride;
+        if (src.layout == planes.layout) {
+            const std::size_t bytes = static_cast<std::size_t>(chromaWidth) * (src.layout == YuvLayout::NV12 ? 2 : 1);
+            std::memcpy(dstU, srcU, bytes);
+            if (src.layout == YuvLayout::I420)
+                std::memcpy(planes.v + row * planes.uvStride, src.v + row * src.uvStride, bytes);
+        } else if (src.layout == YuvLayout::I420) {
+            const std::uint8_t* srcV = src.v + row * src.uvStride;
+            for (int col = 0; col < chromaWidth; ++col) {
+                dstU[2 * col] = srcU[col];
+                dstU[2 * col + 1] = srcV[col];
+            }
+        } else {
+            std::uint8_t* dstV = planes.v + row * planes.uvStride;
+            for (int col = 0; col < chromaWidth; ++col) {
+                dstU[col] = srcU[2 * col];
+                dstV[col] = srcU[2 * col + 1];
+            }
+        }
+    }
+}
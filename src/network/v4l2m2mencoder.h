@@ -0,0 +1,104 @@
+#ifndef V4L2M2MENCODER_H
+#define V4L2M2MENCODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "yuvconvert.h"
+
+// Encoder on a V4L2 memory-to-memory codec device (e.g. the Raspberry Pi's
+// bcm2835-codec: /dev/video11 for H.264, /dev/video31 for JPEG). Uses the
+// multi-planar API with MMAP buffers: the picture is written straight into the
+// device's OUTPUT buffer, BGR frames converted on the way in (or copied as is
+// when the device takes BGR24), and the bitstream comes back on the CAPTURE
+// queue. Single-plane I420, NV12 and BGR24 inputs only; callers fall back to
+// software for anything the device refuses.
+//
+// One instance owns one device context and is not thread-safe.
+class V4l2M2mEncoder
+{
+public:
+    enum class Format { Jpeg, H264, H265 };
+
+    ~V4l2M2mEncoder();
+
+    V4l2M2mEncoder(const V4l2M2mEncoder&) = delete;
+    V4l2M2mEncoder& operator=(const V4l2M2mEncoder&) = delete;
+
+    // Open `devicePath`, or the first /dev/video* M2M device that encodes
+    // `format` when empty. Returns nullptr when no usable device exists.
+    static std::unique_ptr<V4l2M2mEncoder> open(Format format, const std::string& devicePath = std::string());
+
+    // Encode one frame into `out` from `offset` on (out is resized to fit).
+    // `quality` is 1-100 as for JPEG: the JPEG quality, or a bitrate for the
+    // video formats. `fps` and `forceKeyframe` only matter to video; a new
+    // size, input format or fps reconfigures the device (a keyframe follows).
+    bool encodeBgr(const std::uint8_t* pixels, int width, int height, int stride, int quality,
+                   int fps, bool forceKeyframe, std::vector<std::uint8_t>& out, std::size_t offset = 0);
+    bool encode(const YuvFrameView& picture, int quality, int fps, bool forceKeyframe,
+                std::vector<std::uint8_t>& out, std::size_t offset = 0);
+
+    // Whether the last encoded frame is a keyframe (always for JPEG)
+    bool keyframe() const { return m_keyframe; }
+
+    Format format() const { return m_format; }
+    const std::string& devicePath() const { return m_path; }
+
+private:
+    struct MappedBuffer {
+        void* data = nullptr;
+        std::size_t length = 0;
+        bool queued = false;
+    };
+
+    struct Input {
+        const std::uint8_t* bgr = nullptr; // BGR frame, or null for `yuv`
+        int bgrStride = 0;
+        YuvFrameView yuv;
+        int width = 0;
+        int height = 0;
+        bool limitedRange = false;
+    };
+
+    V4l2M2mEncoder(int fd, std::string path, Format format, std::uint32_t codedFormat,
+                   std::vector<std::uint32_t> rawFormats);
+
+    bool encodeInput(const Input& input, int quality, int fps, bool forceKeyframe,
+                     std::vector<std::uint8_t>& out, std::size_t offset);
+    std::uint32_t rawFormatFor(const Input& input) const;
+    bool configure(const Input& input, std::uint32_t rawFormat, int fps, int quality);
+    void applyQuality(int quality);
+    void teardown();
+    bool mapBuffers(std::uint32_t type, unsigned count, std::vector<MappedBuffer>& buffers);
+    void unmapBuffers(std::uint32_t type, std::vector<MappedBuffer>& buffers);
+    bool queueCapture(unsigned index);
+    int acquireOutput();
+    bool dequeueOutput(int timeoutMs);
+    void fillOutput(const Input& input, std::uint8_t* dst) const;
+
+    int m_fd = -1;
+    std::string m_path;
+    Format m_format;
+    std::uint32_t m_codedFormat = 0;
+    std::vector<std::uint32_t> m_rawFormats; // accepted on the OUTPUT queue, in the device's order
+
+    int m_width = 0;
+    int m_height = 0;
+    int m_fps = 0;
+    int m_quality = 0;
+    bool m_limitedRange = false;
+    bool m_streaming = false;
+    bool m_keyframe = false;
+
+    std::uint32_t m_rawFormat = 0;
+    int m_outputStride = 0;
+    int m_outputHeight = 0; // rows per plane, aligned by the driver
+    std::size_t m_outputSize = 0;
+
+    std::vector<MappedBuffer> m_output;
+    std::vector<MappedBuffer> m_capture;
+};
+
+#endif // V4L2M2MENCODER_H
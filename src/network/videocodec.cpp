@@ -0,0 +1,449 @@
+#include "videocodec.h"
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+#include "tiledjpeg.h"
+
+#ifdef IMAGESOCKET_HAVE_FFMPEG
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/opt.h>
+}
+#include "imagepool.h"
+#endif
+
+#ifdef IMAGESOCKET_HAVE_V4L2
+#include "v4l2m2mencoder.h"
+#endif
+
+const char* videoCodecName(VideoCodec codec)
+{
+    switch (codec) {
+    case VideoCodec::H264: return "H.264";
+    case VideoCodec::H265: return "H.265";
+    case VideoCodec::TiledJpeg: return "Tiles";
+    case VideoCodec::Mjpeg: break;
+    }
+    return "MJPEG";
+}
+
+#ifdef IMAGESOCKET_HAVE_FFMPEG
+
+namespace {
+
+AVCodecID codecId(VideoCodec codec)
+{
+    return codec == VideoCodec::H265 ? AV_CODEC_ID_HEVC : AV_CODEC_ID_H264;
+}
+
+// Prefer the x264/x265 software encoders (they honor the low-latency options
+// below), otherwise whatever encoder FFmpeg has for the codec
+const AVCodec* findEncoder(VideoCodec codec)
+{
+    const AVCodec* encoder = avcodec_find_encoder_by_name(codec == VideoCodec::H265 ? "libx265" : "libx264");
+    return encoder ? encoder : avcodec_find_encoder(codecId(codec));
+}
+
+// JPEG-style quality (1-100) to a constant rate factor: 90 -> 21, 75 -> 24, 30 -> 35
+int crfForQuality(int quality)
+{
+    quality = std::max(1, std::min(100, quality));
+    return 18 + (100 - quality) / 4;
+}
+
+class FfmpegVideoEncoder : public VideoEncoder
+{
+public:
+    FfmpegVideoEncoder(VideoCodec codec, const AVCodec* encoder)
+        : m_codec(codec), m_encoder(encoder), m_frame(av_frame_alloc()), m_packet(av_packet_alloc())
+    {
+    }
+
+    ~FfmpegVideoEncoder() override
+    {
+        avcodec_free_context(&m_context);
+        av_frame_free(&m_frame);
+        av_packet_free(&m_packet);
+    }
+
+    bool valid() const { return m_frame && m_packet; }
+
+    VideoCodec codec() const override { return m_codec; }
+    const char* name() const override { return m_encoder->name; }
+
+    bool encode(const YuvFrameView& picture, int fps, int quality, bool forceKeyframe,
+                std::vector<std::uint8_t>& out) override
+    {
+        out.clear();
+        if (picture.layout != YuvLayout::I420 || picture.width <= 0 || picture.height <= 0)
+            return false;
+        fps = fps > 0 ? fps : 30;
+
+        if (!m_context || picture.width != m_width || picture.height != m_height || fps != m_fps
+            || picture.limitedRange != m_limitedRange) {
+            if (!open(picture, fps, quality))
+                return false;
+            forceKeyframe = true;
+        } else if (quality != m_quality) {
+            // libx264 reconfigures its rate factor between pictures; other encoders keep theirs
+            av_opt_set_int(m_context->priv_data, "crf", crfForQuality(quality), 0);
+            m_quality = quality;
+        }
+
+        // Encode straight from the caller's planes (libavcodec copies them if it must keep them)
+        m_frame->format = AV_PIX_FMT_YUV420P;
+        m_frame->width = picture.width;
+        m_frame->height = picture.height;
+        m_frame->data[0] = const_cast<std::uint8_t*>(picture.y);
+        m_frame->data[1] = const_cast<std::uint8_t*>(picture.u);
+        m_frame->data[2] = const_cast<std::uint8_t*>(picture.v);
+        m_frame->linesize[0] = picture.yStride;
+        m_frame->linesize[1] = picture.uvStride;
+        m_frame->linesize[2] = picture.uvStride;
+        m_frame->pts = m_pts++;
+        m_frame->pict_type = forceKeyframe ? AV_PICTURE_TYPE_I : AV_PICTURE_TYPE_NONE;
+
+        if (avcodec_send_frame(m_context, m_frame) < 0) {
+            qWarning() << "Video encode failed with" << name();
+            return false;
+        }
+
+        while (avcodec_receive_packet(m_context, m_packet) == 0) {
+            const std::size_t offset = out.empty() ? kVideoPacketHeaderSize : out.size();
+            VideoPacketHeader header;
+            header.codec = m_codec;
+            header.keyframe = (m_packet->flags & AV_PKT_FLAG_KEY) != 0;
+            if (out.empty())
+                prepareVideoPacket(header, static_cast<std::size_t>(m_packet->size), out);
+            else
+                out.resize(out.size() + static_cast<std::size_t>(m_packet->size));
+            std::memcpy(out.data() + offset, m_packet->data, static_cast<std::size_t>(m_packet->size));
+            av_packet_unref(m_packet);
+        }
+        return true;
+    }
+
+private:
+    bool open(const YuvFrameView& picture, int fps, int quality)
+    {
+        avcodec_free_context(&m_context);
+        m_context = avcodec_alloc_context3(m_encoder);
+        if (!m_context)
+            return false;
+
+        m_context->width = picture.width;
+        m_context->height = picture.height;
+        m_context->pix_fmt = AV_PIX_FMT_YUV420P;
+        m_context->color_range = picture.limitedRange ? AVCOL_RANGE_MPEG : AVCOL_RANGE_JPEG;
+        m_context->time_base = AVRational{1, fps};
+        m_context->framerate = AVRational{fps, 1};
+        m_context->gop_size = fps * 2; // periodic keyframes bound the damage of any lost packet
+        m_context->max_b_frames = 0;   // B-frames would delay every picture
+        m_context->thread_type = FF_THREAD_SLICE;
+
+        AVDictionary* options = nullptr;
+        av_dict_set(&options, "preset", "veryfast", 0);
+        av_dict_set(&options, "tune", "zerolatency", 0);
+        av_dict_set(&options, "forced-idr", "1", 0); // forced keyframes are IDR: decodable on their own
+        av_dict_set_int(&options, "crf", crfForQuality(quality), 0);
+        const int result = avcodec_open2(m_context, m_encoder, &options);
+        av_dict_free(&options);
+        if (result < 0) {
+            qWarning() << "Failed to open video encoder" << name();
+            avcodec_free_context(&m_context);
+            return false;
+        }
+
+        m_width = picture.width;
+        m_height = picture.height;
+        m_fps = fps;
+        m_quality = quality;
+        m_limitedRange = picture.limitedRange;
+        m_pts = 0;
+        return true;
+    }
+
+    VideoCodec m_codec;
+    const AVCodec* m_encoder;
+    AVCodecContext* m_context = nullptr;
+    AVFrame* m_frame;
+    AVPacket* m_packet;
+    int m_width = 0;
+    int m_height = 0;
+    int m_fps = 0;
+    int m_quality = 0;
+    bool m_limitedRange = false;
+    std::int64_t m_pts = 0;
+};
+
+class FfmpegVideoDecoder : public VideoDecoder
+{
+public:
+    explicit FfmpegVideoDecoder(VideoCodec codec)
+        : m_codec(codec), m_frame(av_frame_alloc()), m_packet(av_packet_alloc())
+    {
+        const AVCodec* decoder = avcodec_find_decoder(codecId(codec));
+        if (!decoder || !m_frame || !m_packet)
+            return;
+        m_context = avcodec_alloc_context3(decoder);
+        if (!m_context)
+            return;
+        m_context->flags |= AV_CODEC_FLAG_LOW_DELAY; // output each picture as soon as it is complete
+        m_context->thread_type = FF_THREAD_SLICE;    // frame threading would add a frame of latency per thread
+        if (avcodec_open2(m_context, decoder, nullptr) < 0)
+            avcodec_free_context(&m_context);
+    }
+
+    ~FfmpegVideoDecoder() override
+    {
+        avcodec_free_context(&m_context);
+        av_frame_free(&m_frame);
+        av_packet_free(&m_packet);
+    }
+
+    bool valid() const { return m_context != nullptr; }
+
+    VideoCodec codec() const override { return m_codec; }
+
+    bool decode(const std::uint8_t* bitstream, std::size_t size, QImage& out) override
+    {
+        // Non-refcounted packet: the decoder copies what it keeps, so the
+        // received message is only read
+        m_packet->data = const_cast<std::uint8_t*>(bitstream);
+        m_packet->size = static_cast<int>(size);
+        const int sent = avcodec_send_packet(m_context, m_packet);
+        m_packet->data = nullptr;
+        m_packet->size = 0;
+        if (sent < 0)
+            return false;
+
+        bool ok = true;
+        while (avcodec_receive_frame(m_context, m_frame) == 0) {
+            ok = toImage(out);
+            av_frame_unref(m_frame);
+        }
+        return ok;
+    }
+
+private:
+    bool toImage(QImage& out)
+    {
+        YuvFrameView view;
+        view.width = m_frame->width;
+        view.height = m_frame->height;
+        view.y = m_frame->data[0];
+        view.u = m_frame->data[1];
+        view.yStride = m_frame->linesize[0];
+        view.uvStride = m_frame->linesize[1];
+        switch (m_frame->format) {
+        case AV_PIX_FMT_YUVJ420P:
+            view.layout = YuvLayout::I420;
+            view.v = m_frame->data[2];
+            break;
+        case AV_PIX_FMT_YUV420P:
+            view.layout = YuvLayout::I420;
+            view.v = m_frame->data[2];
+            view.limitedRange = m_frame->color_range != AVCOL_RANGE_JPEG;
+            break;
+        case AV_PIX_FMT_NV12:
+            view.layout = YuvLayout::NV12;
+            view.limitedRange = m_frame->color_range != AVCOL_RANGE_JPEG;
+            break;
+        default:
+            qWarning() << "Unsupported decoded pixel format" << m_frame->format;
+            return false;
+        }
+
+        QImage image = ImagePool::shared().acquire(view.width, view.height);
+        if (image.isNull())
+            return false;
+        yuvToRgb32(view, image.bits(), image.bytesPerLine());
+        out = image;
+        return true;
+    }
+
+    VideoCodec m_codec;
+    AVCodecContext* m_context = nullptr;
+    AVFrame* m_frame;
+    AVPacket* m_packet;
+};
+
+std::unique_ptr<VideoEncoder> createSoftwareEncoder(VideoCodec codec)
+{
+    if (!isInterFrameCodec(codec))
+        return nullptr;
+    const AVCodec* encoder = findEncoder(codec);
+    if (!encoder)
+        return nullptr;
+    std::unique_ptr<FfmpegVideoEncoder> instance(new FfmpegVideoEncoder(codec, encoder));
+    if (!instance->valid())
+        return nullptr;
+    return std::unique_ptr<VideoEncoder>(instance.release());
+}
+
+bool softwareEncoderAvailable(VideoCodec codec)
+{
+    return isInterFrameCodec(codec) && findEncoder(codec) != nullptr;
+}
+
+} // namespace
+
+std::unique_ptr<VideoDecoder> VideoDecoder::create(VideoCodec codec)
+{
+    if (codec == VideoCodec::TiledJpeg)
+        return std::unique_ptr<VideoDecoder>(new TiledJpegDecoder);
+    if (!isInterFrameCodec(codec))
+        return nullptr;
+    std::unique_ptr<FfmpegVideoDecoder> instance(new FfmpegVideoDecoder(codec));
+    if (!instance->valid()) {
+        qWarning() << "No" << videoCodecName(codec) << "decoder available";
+        return nullptr;
+    }
+    return std::unique_ptr<VideoDecoder>(instance.release());
+}
+
+bool VideoDecoder::available(VideoCodec codec)
+{
+    return codec == VideoCodec::TiledJpeg
+        || (isInterFrameCodec(codec) && avcodec_find_decoder(codecId(codec)) != nullptr);
+}
+
+#else // !IMAGESOCKET_HAVE_FFMPEG
+
+namespace {
+
+std::unique_ptr<VideoEncoder> createSoftwareEncoder(VideoCodec codec)
+{
+    Q_UNUSED(codec);
+    return nullptr;
+}
+
+bool softwareEncoderAvailable(VideoCodec codec)
+{
+    Q_UNUSED(codec);
+    return false;
+}
+
+} // namespace
+
+std::unique_ptr<VideoDecoder> VideoDecoder::create(VideoCodec codec)
+{
+    if (codec == VideoCodec::TiledJpeg)
+        return std::unique_ptr<VideoDecoder>(new TiledJpegDecoder);
+    return nullptr;
+}
+
+bool VideoDecoder::available(VideoCodec codec)
+{
+    return codec == VideoCodec::TiledJpeg;
+}
+
+#endif // IMAGESOCKET_HAVE_FFMPEG
+
+#ifdef IMAGESOCKET_HAVE_V4L2
+
+namespace {
+
+V4l2M2mEncoder::Format v4l2Format(VideoCodec codec)
+{
+    return codec == VideoCodec::H265 ? V4l2M2mEncoder::Format::H265 : V4l2M2mEncoder::Format::H264;
+}
+
+// Hardware encoding on a V4L2 M2M device, software (when built in) for any
+// frame the device fails on. Switching encoders starts with a keyframe, since
+// the decoder's references came from the other one; after repeated failures
+// the device is released and the stream stays in software.
+class V4l2VideoEncoder : public VideoEncoder
+{
+public:
+    V4l2VideoEncoder(VideoCodec codec, std::unique_ptr<V4l2M2mEncoder> device)
+        : m_codec(codec), m_device(std::move(device))
+    {
+    }
+
+    VideoCodec codec() const override { return m_codec; }
+    const char* name() const override
+    {
+        return m_device || !m_software ? "v4l2-m2m" : m_software->name();
+    }
+
+    bool encode(const YuvFrameView& picture, int fps, int quality, bool forceKeyframe,
+                std::vector<std::uint8_t>& out) override
+    {
+        out.clear();
+        if (m_device) {
+            // The bitstream goes in after the packet header, which is filled in afterwards
+            if (m_device->encode(picture, quality, fps, forceKeyframe || m_last != Last::Device, out,
+                                 kVideoPacketHeaderSize)) {
+                m_failures = 0;
+                m_last = Last::Device;
+                VideoPacketHeader header;
+                header.codec = m_codec;
+                header.keyframe = m_device->keyframe();
+                prepareVideoPacket(header, out.size() - kVideoPacketHeaderSize, out);
+                return true;
+            }
+            out.clear();
+            if (++m_failures >= kMaxConsecutiveFailures) {
+                qWarning() << "V4L2 encoder" << QString::fromStdString(m_device->devicePath())
+                           << "keeps failing, encoding in software";
+                m_device.reset();
+            }
+        }
+
+        if (!m_software)
+            m_software = createSoftwareEncoder(m_codec);
+        if (!m_software || !m_software->encode(picture, fps, quality, forceKeyframe || m_last != Last::Software, out))
+            return false;
+        m_last = Last::Software;
+        return true;
+    }
+
+private:
+    static const int kMaxConsecutiveFailures = 8;
+
+    enum class Last { None, Device, Software }; // encoder of the previous packet
+
+    VideoCodec m_codec;
+    std::unique_ptr<V4l2M2mEncoder> m_device;
+    std::unique_ptr<VideoEncoder> m_software;
+    int m_failures = 0;
+    Last m_last = Last::None;
+};
+
+// Hardware unless IMAGESOCKET_VIDEO_BACKEND=software; IMAGESOCKET_V4L2_VIDEO_ENCODER pins the node
+std::unique_ptr<V4l2M2mEncoder> openV4l2Encoder(VideoCodec codec)
+{
+    if (!isInterFrameCodec(codec) || qgetenv("IMAGESOCKET_VIDEO_BACKEND") == "software")
+        return nullptr;
+    return V4l2M2mEncoder::open(v4l2Format(codec), qgetenv("IMAGESOCKET_V4L2_VIDEO_ENCODER").toStdString());
+}
+
+} // namespace
+
+std::unique_ptr<VideoEncoder> VideoEncoder::create(VideoCodec codec)
+{
+    std::unique_ptr<V4l2M2mEncoder> device = openV4l2Encoder(codec);
+    if (device)
+        return std::unique_ptr<VideoEncoder>(new V4l2VideoEncoder(codec, std::move(device)));
+    return createSoftwareEncoder(codec);
+}
+
+bool VideoEncoder::available(VideoCodec codec)
+{
+    return softwareEncoderAvailable(codec) || openV4l2Encoder(codec) != nullptr;
+}
+
+#else // !IMAGESOCKET_HAVE_V4L2
+
+std::unique_ptr<VideoEncoder> VideoEncoder::create(VideoCodec codec)
+{
+    return createSoftwareEncoder(codec);
+}
+
+bool VideoEncoder::available(VideoCodec codec)
+{
+    return softwareEncoderAvailable(codec);
+}
+
+#endif // IMAGESOCKET_HAVE_V4L2
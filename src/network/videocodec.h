@@ -0,0 +1,60 @@
+#ifndef VIDEOCODEC_H
+#define VIDEOCODEC_H
+
+#include <QImage>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "videopacket.h"
+#include "yuvconvert.h"
+
+// Inter-frame (H.264 / H.265) encoding for the client's video mode.
+// With IMAGESOCKET_HAVE_V4L2, a V4L2 M2M hardware encoder is used when one is
+// present (IMAGESOCKET_VIDEO_BACKEND=software skips it), falling back to
+// software per frame. With IMAGESOCKET_HAVE_FFMPEG, libavcodec is the software
+// encoder (libx264 / libx265 when built in); both are set up for zero latency:
+// no B-frames, one packet per picture. Without either create() returns null
+// and the client stays on MJPEG. Instances are not thread-safe.
+class VideoEncoder
+{
+public:
+    virtual ~VideoEncoder() = default;
+
+    virtual VideoCodec codec() const = 0;
+    virtual const char* name() const = 0;
+
+    // Encode an I420 picture into `out`: a complete video packet (header and
+    // bitstream) ready for sendVideoPacket(). `quality` (1-100, as for JPEG)
+    // maps to a constant rate factor; a new size or fps restarts the stream
+    // with a keyframe. `out` may be empty if the encoder produced nothing.
+    virtual bool encode(const YuvFrameView& picture, int fps, int quality, bool forceKeyframe,
+                        std::vector<std::uint8_t>& out) = 0;
+
+    static std::unique_ptr<VideoEncoder> create(VideoCodec codec);
+    static bool available(VideoCodec codec);
+};
+
+// Server-side decoder for one client's stream (it keeps reference pictures,
+// so each session needs its own). Same backend rules as VideoEncoder, except
+// for TiledJpeg (tiledjpeg.h), which is always available.
+class VideoDecoder
+{
+public:
+    virtual ~VideoDecoder() = default;
+
+    virtual VideoCodec codec() const = 0;
+
+    // Decode one packet's bitstream into a QImage::Format_RGB32 image. Returns
+    // false on a decode error (the caller should wait for the next keyframe);
+    // `out` is left null when the packet completed no picture.
+    virtual bool decode(const std::uint8_t* bitstream, std::size_t size, QImage& out) = 0;
+
+    static std::unique_ptr<VideoDecoder> create(VideoCodec codec);
+    static bool available(VideoCodec codec);
+};
+
+// Display name for UI and logs ("MJPEG", "H.264", "H.265", "Tiles")
+const char* videoCodecName(VideoCodec codec);
+
+#endif // VIDEOCODEC_H
@@ -0,0 +1,67 @@
+#ifndef VIDEOPACKET_H
+#define VIDEOPACKET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Inter-frame video mode (wire prefix 0x03), negotiated with CODECS / SET_CODEC.
+// Each message carries one encoded picture (an Annex B access unit, or the
+// changed tiles of a tiled JPEG frame, see tiledframe.h) behind a 2-byte header:
+//
+//   byte 0  codec (VideoCodec)
+//   byte 1  flags (bit 0: keyframe, decodable without earlier packets)
+//
+// Values match imagesocket.control.VideoCodec.
+enum class VideoCodec : std::uint8_t {
+    Mjpeg = 0, // independent JPEG frames (prefix 0x00), the default
+    H264 = 1,
+    H265 = 2,
+    TiledJpeg = 3 // changed JPEG tiles (tiledframe.h), no video codec library needed
+};
+
+const std::size_t kVideoPacketHeaderSize = 2;
+const std::uint8_t kVideoPacketKeyframe = 0x01;
+
+struct VideoPacketHeader {
+    VideoCodec codec = VideoCodec::H264;
+    bool keyframe = false;
+};
+
+inline bool isInterFrameCodec(VideoCodec codec)
+{
+    return codec == VideoCodec::H264 || codec == VideoCodec::H265;
+}
+
+// Codecs sent as video packets: decodable only in order, from a keyframe
+inline bool usesVideoPackets(VideoCodec codec)
+{
+    return isInterFrameCodec(codec) || codec == VideoCodec::TiledJpeg;
+}
+
+// Read the header of a video packet payload (prefix byte excluded); false for
+// unknown codecs and packets without any picture data
+inline bool parseVideoPacketHeader(const std::uint8_t* data, std::size_t size, VideoPacketHeader& header)
+{
+    if (!data || size <= kVideoPacketHeaderSize)
+        return false;
+    const VideoCodec codec = static_cast<VideoCodec>(data[0]);
+    if (!usesVideoPackets(codec))
+        return false;
+    header.codec = codec;
+    header.keyframe = (data[1] & kVideoPacketKeyframe) != 0;
+    return true;
+}
+
+// Size `packet` for `bitstreamSize` bytes of picture data (its capacity is
+// reused) and write the header; the caller copies the bitstream after the
+// first kVideoPacketHeaderSize bytes.
+inline void prepareVideoPacket(const VideoPacketHeader& header, std::size_t bitstreamSize,
+                               std::vector<std::uint8_t>& packet)
+{
+    packet.resize(kVideoPacketHeaderSize + bitstreamSize);
+    packet[0] = static_cast<std::uint8_t>(header.codec);
+    packet[1] = header.keyframe ? kVideoPacketKeyframe : 0;
+}
+
+#endif // VIDEOPACKET_H
@@ -0,0 +1,539 @@
+#include "videosurfaceitem.h"
+#include "imageserverbridge.h"
+#include "framedecoder.h"
+#include "frametrace.h"
+#include "mosaiclayout.h"
+#include "rawframe.h"
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <QOpenGLShaderProgram>
+#include <QQuickWindow>
+#include <QScreen>
+#include <QSGGeometryNode>
+#include <QSGMaterial>
+#include <QSGSimpleTextureNode>
+#include <QSGTexture>
+
+#ifndef GL_BGRA
+#define GL_BGRA 0x80E1
+#endif
+
+namespace {
+
+// GL texture holding QImage::Format_RGB32 frames, refilled in place while the
+// size stays the same. RGB32 is B,G,R,X in memory on little-endian hosts, which
+// GL_BGRA uploads without swizzling on the CPU.
+class FrameTexture : public QSGTexture
+{
+public:
+    // Null when the current context can't take BGRA uploads (caller falls back)
+    static FrameTexture* create()
+    {
+        QOpenGLContext* context = QOpenGLContext::currentContext();
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+        if (!context)
+            return nullptr;
+        GLint internalFormat = GL_RGBA;
+        if (context->isOpenGLES()) {
+            if (!context->hasExtension(QByteArrayLiteral("GL_EXT_texture_format_BGRA8888")))
+                return nullptr;
+            internalFormat = GL_BGRA; // the ES extension wants matching formats
+        }
+        return new FrameTexture(context->functions(), internalFormat);
+#else
+        Q_UNUSED(context);
+        return nullptr;
+#endif
+    }
+
+    ~FrameTexture() override
+    {
+        if (m_id && QOpenGLContext::currentContext())
+            m_gl->glDeleteTextures(1, &m_id);
+    }
+
+    int textureId() const override { return static_cast<int>(m_id); }
+    QSize textureSize() const override { return m_size; }
+    bool hasAlphaChannel() const override { return false; }
+    bool hasMipmaps() const override { return false; }
+
+    void bind() override
+    {
+        m_gl->glBindTexture(GL_TEXTURE_2D, m_id);
+        updateBindOptions();
+    }
+
+    // Upload a tightly packed RGB32 frame; false if this texture can't take it
+    bool upload(const QImage& frame)
+    {
+        if (frame.format() != QImage::Format_RGB32 || frame.bytesPerLine() != frame.width() * 4)
+            return false;
+
+        if (!m_id)
+            m_gl->glGenTextures(1, &m_id);
+        m_gl->glBindTexture(GL_TEXTURE_2D, m_id);
+        m_gl->glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        if (frame.size() != m_size) {
+            m_gl->glTexImage2D(GL_TEXTURE_2D, 0, m_internalFormat, frame.width(), frame.height(), 0,
+                               GL_BGRA, GL_UNSIGNED_BYTE, frame.constBits());
+            m_size = frame.size();
+            updateBindOptions(true);
+        } else {
+            m_gl->glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, frame.width(), frame.height(),
+                                  GL_BGRA, GL_UNSIGNED_BYTE, frame.constBits());
+        }
+        return true;
+    }
+
+private:
+    FrameTexture(QOpenGLFunctions* gl, GLint internalFormat)
+        : m_gl(gl), m_internalFormat(internalFormat)
+    {
+    }
+
+    QOpenGLFunctions* m_gl;
+    GLint m_internalFormat;
+    GLuint m_id = 0;
+    QSize m_size;
+};
+
+// Keeps track of whether the node's texture is one we can refill
+class VideoNode : public QSGSimpleTextureNode
+{
+public:
+    VideoNode()
+    {
+        setOwnsTexture(true);
+        setFiltering(QSGTexture::Linear);
+    }
+
+    // Show `frame`, reusing the current texture when possible
+    void setFrame(QQuickWindow* window, const QImage& frame)
+    {
+        if (m_frameTexture && m_frameTexture->textureSize() == frame.size() && m_frameTexture->upload(frame)) {
+            markDirty(QSGNode::DirtyMaterial);
+            return;
+        }
+
+        FrameTexture* reusable = FrameTexture::create();
+        if (reusable && reusable->upload(frame)) {
+            m_frameTexture = reusable;
+            setTexture(reusable); // deletes the previous texture (owned)
+            return;
+        }
+        delete reusable;
+
+        m_frameTexture = nullptr;
+        QSGTexture* texture = window->createTextureFromImage(frame, QQuickWindow::TextureIsOpaque);
+        if (texture)
+            setTexture(texture);
+    }
+
+private:
+    FrameTexture* m_frameTexture = nullptr; // non-owning alias of texture() when reusable
+};
+
+// BT.601, full or limited range (as yuvToRgb32), from one luminance texture per plane;
+// NV12's interleaved chroma is a luminance-alpha texture (U in r, V in a)
+class YuvMaterialShader : public QSGMaterialShader
+{
+public:
+    char const* const* attributeNames() const override
+    {
+        static const char* const names[] = {"vertex", "texCoordIn", nullptr};
+        return names;
+    }
+
+    void updateState(const RenderState& state, QSGMaterial* newMaterial, QSGMaterial* oldMaterial) override;
+
+protected:
+    const char* vertexShader() const override
+    {
+        return "attribute highp vec4 vertex;\n"
+               "attribute highp vec2 texCoordIn;\n"
+               "uniform highp mat4 qt_Matrix;\n"
+               "varying highp vec2 texCoord;\n"
+               "void main() {\n"
+               "    texCoord = texCoordIn;\n"
+               "    gl_Position = qt_Matrix * vertex;\n"
+               "}\n";
+    }
+
+    const char* fragmentShader() const override
+    {
+        return "uniform sampler2D yPlane;\n"
+               "uniform sampler2D uPlane;\n"
+               "uniform sampler2D vPlane;\n"
+               "uniform lowp float qt_Opacity;\n"
+               "uniform lowp float interleaved;\n"
+               "uniform lowp float limitedRange;\n"
+               "varying highp vec2 texCoord;\n"
+               "void main() {\n"
+               "    mediump float y = texture2D(yPlane, texCoord).r;\n"
+               "    mediump vec4 chroma = texture2D(uPlane, texCoord);\n"
+               "    mediump vec2 uv = mix(vec2(chroma.r, texture2D(vPlane, texCoord).r), chroma.ra, interleaved)\n"
+               "                      - vec2(128.0 / 255.0);\n"
+               "    y = mix(y, (y - 16.0 / 255.0) * (255.0 / 219.0), limitedRange);\n"
+               "    uv = mix(uv, uv * (255.0 / 224.0), limitedRange);\n"
+               "    mediump vec3 rgb = vec3(y + 1.402 * uv.y,\n"
+               "                            y - 0.344136 * uv.x - 0.714136 * uv.y,\n"
+               "                            y + 1.772 * uv.x);\n"
+               "    gl_FragColor = vec4(clamp(rgb, 0.0, 1.0), 1.0) * qt_Opacity;\n"
+               "}\n";
+    }
+
+    void initialize() override
+    {
+        m_matrix = program()->uniformLocation("qt_Matrix");
+        m_opacity = program()->uniformLocation("qt_Opacity");
+        m_interleaved = program()->uniformLocation("interleaved");
+        m_limitedRange = program()->uniformLocation("limitedRange");
+        m_planes[0] = program()->uniformLocation("yPlane");
+        m_planes[1] = program()->uniformLocation("uPlane");
+        m_planes[2] = program()->uniformLocation("vPlane");
+    }
+
+private:
+    int m_matrix = -1;
+    int m_opacity = -1;
+    int m_interleaved = -1;
+    int m_limitedRange = -1;
+    int m_planes[3] = {-1, -1, -1};
+};
+
+// Owns the three plane textures; refilled in place while the frame size and
+// layout stay the same
+class YuvMaterial : public QSGMaterial
+{
+public:
+    YuvMaterial() { setFlag(Blending, true); }
+
+    ~YuvMaterial() override
+    {
+        QOpenGLContext* context = QOpenGLContext::currentContext();
+        if (m_textures[0] && context)
+            context->functions()->glDeleteTextures(3, m_textures);
+    }
+
+    QSGMaterialType* type() const override
+    {
+        static QSGMaterialType type;
+        return &type;
+    }
+
+    QSGMaterialShader* createShader() const override { return new YuvMaterialShader(); }
+
+    int compare(const QSGMaterial* other) const override
+    {
+        const GLuint mine = m_textures[0];
+        const GLuint theirs = static_cast<const YuvMaterial*>(other)->m_textures[0];
+        return mine == theirs ? 0 : (mine < theirs ? -1 : 1);
+    }
+
+    bool interleaved() const { return m_layout == YuvLayout::NV12; }
+    bool limitedRange() const { return m_limitedRange; }
+
+    void upload(QOpenGLFunctions* gl, const YuvFrameView& frame)
+    {
+        if (!m_textures[0])
+            gl->glGenTextures(3, m_textures);
+
+        const bool resized = frame.width != m_width || frame.height != m_height || frame.layout != m_layout;
+        m_width = frame.width;
+        m_height = frame.height;
+        m_layout = frame.layout;
+        m_limitedRange = frame.limitedRange;
+
+        const int chromaWidth = frame.width / 2;
+        const int chromaHeight = frame.height / 2;
+        gl->glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // chroma rows may be odd-sized
+        uploadPlane(gl, 0, GL_LUMINANCE, frame.width, frame.height, frame.y, resized);
+        if (frame.layout == YuvLayout::NV12) {
+            uploadPlane(gl, 1, GL_LUMINANCE_ALPHA, chromaWidth, chromaHeight, frame.u, resized);
+        } else {
+            uploadPlane(gl, 1, GL_LUMINANCE, chromaWidth, chromaHeight, frame.u, resized);
+            uploadPlane(gl, 2, GL_LUMINANCE, chromaWidth, chromaHeight, frame.v, resized);
+        }
+        gl->glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    }
+
+    // Bind the planes to units 0..2, leaving unit 0 active as the renderer expects
+    void bind(QOpenGLFunctions* gl) const
+    {
+        for (int unit = 2; unit >= 0; --unit) {
+            gl->glActiveTexture(GL_TEXTURE0 + unit);
+            // NV12 has no third plane; any valid texture will do for the unused sampler
+            gl->glBindTexture(GL_TEXTURE_2D, unit == 2 && interleaved() ? m_textures[1] : m_textures[unit]);
+        }
+    }
+
+private:
+    void uploadPlane(QOpenGLFunctions* gl, int index, GLenum format, int width, int height,
+                     const std::uint8_t* pixels, bool resized)
+    {
+        gl->glBindTexture(GL_TEXTURE_2D, m_textures[index]);
+        if (resized) {
+            gl->glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(format), width, height, 0,
+                             format, GL_UNSIGNED_BYTE, pixels);
+            // NPOT-safe parameters for GLES 2
+            gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        } else {
+            gl->glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, GL_UNSIGNED_BYTE, pixels);
+        }
+    }
+
+    GLuint m_textures[3] = {0, 0, 0};
+    int m_width = 0;
+    int m_height = 0;
+    YuvLayout m_layout = YuvLayout::I420;
+    bool m_limitedRange = false;
+};
+
+void YuvMaterialShader::updateState(const RenderState& state, QSGMaterial* newMaterial, QSGMaterial* oldMaterial)
+{
+    Q_UNUSED(oldMaterial);
+    if (state.isMatrixDirty())
+        program()->setUniformValue(m_matrix, state.combinedMatrix());
+    if (state.isOpacityDirty())
+        program()->setUniformValue(m_opacity, state.opacity());
+
+    const YuvMaterial* material = static_cast<const YuvMaterial*>(newMaterial);
+    for (int unit = 0; unit < 3; ++unit)
+        program()->setUniformValue(m_planes[unit], unit);
+    program()->setUniformValue(m_interleaved, material->interleaved() ? 1.0f : 0.0f);
+    program()->setUniformValue(m_limitedRange, material->limitedRange() ? 1.0f : 0.0f);
+    material->bind(state.context()->functions());
+}
+
+// Textured quad drawn with YuvMaterial
+class YuvVideoNode : public QSGGeometryNode
+{
+public:
+    YuvVideoNode()
+        : m_geometry(QSGGeometry::defaultAttributes_TexturedPoint2D(), 4)
+    {
+        setGeometry(&m_geometry);
+        setMaterial(&m_material);
+    }
+
+    // Needs a current GL context (the render thread's, in updatePaintNode())
+    static bool supported() { return QOpenGLContext::currentContext() != nullptr; }
+
+    void setFrame(const YuvFrameView& frame)
+    {
+        m_material.upload(QOpenGLContext::currentContext()->functions(), frame);
+        markDirty(QSGNode::DirtyMaterial);
+    }
+
+    void setRect(const QRectF& rect)
+    {
+        QSGGeometry::updateTexturedRectGeometry(&m_geometry, rect, QRectF(0.0, 0.0, 1.0, 1.0));
+        markDirty(QSGNode::DirtyGeometry);
+    }
+
+private:
+    QSGGeometry m_geometry;
+    YuvMaterial m_material;
+};
+
+} // namespace
+
+VideoSurfaceItem::VideoSurfaceItem(QQuickItem* parent)
+    : QQuickItem(parent)
+{
+    setFlag(ItemHasContents, true);
+    connect(this, &QQuickItem::windowChanged, this, &VideoSurfaceItem::attachWindow);
+}
+
+QObject* VideoSurfaceItem::bridge() const
+{
+    return m_bridge;
+}
+
+void VideoSurfaceItem::setBridge(QObject* bridge)
+{
+    ImageServerBridge* typed = qobject_cast<ImageServerBridge*>(bridge);
+    if (m_bridge == typed)
+        return;
+
+    if (m_bridge)
+        disconnect(m_bridge, nullptr, this, nullptr);
+    m_bridge = typed;
+    if (m_bridge) {
+        connect(m_bridge, &ImageServerBridge::newFrameReady, this, &VideoSurfaceItem::presentFrame);
+        connect(m_bridge, &ImageServerBridge::newRawFrameReady, this, &VideoSurfaceItem::presentRawFrame);
+        connect(m_bridge, &ImageServerBridge::connectionLost, this, &VideoSurfaceItem::clear);
+        connect(m_bridge, &ImageServerBridge::pacedFramePending, this, &VideoSurfaceItem::requestRefresh);
+    }
+    emit bridgeChanged();
+}
+
+void VideoSurfaceItem::presentFrame(const QImage& frame)
+{
+    if (frame.isNull())
+        return;
+
+    queueFrame(frame.size());
+    m_pending = frame; // implicit sharing: no pixel copy
+}
+
+void VideoSurfaceItem::presentRawFrame(const EncodedFrame& frame)
+{
+    // Only the header is read here; the planes stay in the received message
+    RawFrameHeader header;
+    if (frame.format != EncodedFrame::RawYuv
+        || !parseRawFrameHeader(reinterpret_cast<const std::uint8_t*>(frame.data()),
+                                static_cast<std::size_t>(frame.size()), header))
+        return;
+
+    queueFrame(QSize(header.width, header.height));
+    m_pendingRaw = frame;
+}
+
+void VideoSurfaceItem::queueFrame(const QSize& size)
+{
+    if (!m_pending.isNull() || !m_pendingRaw.isEmpty()) {
+        ++m_coalescedFrames;
+        emit statsChanged();
+    }
+    m_pending = QImage();
+    m_pendingRaw = EncodedFrame();
+    m_clearPending = false;
+
+    if (size != m_frameSize) {
+        m_frameSize = size;
+        m_geometryDirty = true;
+        emit frameSizeChanged();
+    }
+    if (!m_hasFrame) {
+        m_hasFrame = true;
+        emit hasFrameChanged();
+    }
+    update(); // coalesced by the scene graph to the next frame
+}
+
+void VideoSurfaceItem::clear()
+{
+    m_pending = QImage();
+    m_pendingRaw = EncodedFrame();
+    m_clearPending = true;
+    if (m_hasFrame) {
+        m_hasFrame = false;
+        emit hasFrameChanged();
+    }
+    update();
+}
+
+void VideoSurfaceItem::attachWindow(QQuickWindow* window)
+{
+    if (m_window)
+        disconnect(m_window, &QQuickWindow::frameSwapped, this, nullptr);
+    m_window = window;
+    if (!m_window)
+        return;
+    // Emitted on the render thread right after the swap; only the time is taken there
+    connect(m_window, &QQuickWindow::frameSwapped, this, [this]() {
+        const qint64 swappedAtUs = EncodedFrame::nowUs();
+        QMetaObject::invokeMethod(this, [this, swappedAtUs]() { paceFrames(swappedAtUs); }, Qt::QueuedConnection);
+    }, Qt::DirectConnection);
+}
+
+void VideoSurfaceItem::paceFrames(qint64 swappedAtUs)
+{
+    if (!m_bridge || !m_window)
+        return;
+    const qreal refreshRate = m_window->screen() ? m_window->screen()->refreshRate() : 0.0;
+    const qint64 refreshUs = refreshRate > 1.0 ? static_cast<qint64>(1e6 / refreshRate) : 16667;
+    // A frame handed over now is drawn at the next refresh
+    if (m_bridge->presentPacedFrame(swappedAtUs + refreshUs))
+        m_window->update(); // keep refreshing while frames wait
+}
+
+void VideoSurfaceItem::requestRefresh()
+{
+    // An idle window doesn't swap: one refresh restarts the pacing
+    if (m_window)
+        m_window->update();
+}
+
+void VideoSurfaceItem::geometryChanged(const QRectF& newGeometry, const QRectF& oldGeometry)
+{
+    QQuickItem::geometryChanged(newGeometry, oldGeometry);
+    if (newGeometry.size() != oldGeometry.size()) {
+        m_geometryDirty = true;
+        update();
+    }
+}
+
+// Render thread, GUI thread blocked: members can be read without locking
+QSGNode* VideoSurfaceItem::updatePaintNode(QSGNode* oldNode, UpdatePaintNodeData* data)
+{
+    Q_UNUSED(data);
+    FrameTrace::setThreadName("render");
+    FrameTraceScope trace("render", "server");
+
+    if (m_clearPending) {
+        m_clearPending = false;
+        delete oldNode;
+        return nullptr;
+    }
+
+    // Without GL the planes can't be drawn directly: convert them here instead
+    if (!m_pendingRaw.isEmpty() && !YuvVideoNode::supported()) {
+        FrameDecoder::decodeFrame(m_pendingRaw, m_pending);
+        m_pendingRaw = EncodedFrame();
+    }
+
+    QSGNode* node = oldNode;
+    const bool hasRaw = !m_pendingRaw.isEmpty();
+    if (hasRaw || !m_pending.isNull()) {
+        if (node && m_rawNode != hasRaw) {
+            delete node;
+            node = nullptr;
+        }
+        if (!node) {
+            node = hasRaw ? static_cast<QSGNode*>(new YuvVideoNode()) : new VideoNode();
+            m_rawNode = hasRaw;
+            m_geometryDirty = true;
+        }
+
+        if (hasRaw) {
+            RawFrameHeader header;
+            const std::uint8_t* payload = reinterpret_cast<const std::uint8_t*>(m_pendingRaw.data());
+            parseRawFrameHeader(payload, static_cast<std::size_t>(m_pendingRaw.size()), header);
+            static_cast<YuvVideoNode*>(node)->setFrame(rawFrameView(header, payload));
+            trace.setFrame(m_pendingRaw.timing().sequence);
+            m_pendingRaw = EncodedFrame(); // release the received message
+        } else {
+            static_cast<VideoNode*>(node)->setFrame(window(), m_pending);
+            m_pending = QImage(); // let the decoder recycle the pixels
+        }
+
+        // The GUI thread is blocked while the scene graph syncs, so m_bridge is
+        // safe to read here; the report itself is handled on the GUI thread
+        if (ImageServerBridge* bridge = m_bridge.data()) {
+            const qint64 presentedAtUs = EncodedFrame::nowUs();
+            QMetaObject::invokeMethod(bridge, [bridge, presentedAtUs]() {
+                bridge->recordFramePresented(presentedAtUs);
+            }, Qt::QueuedConnection);
+        }
+    }
+    if (!node)
+        return nullptr;
+
+    if (m_geometryDirty) {
+        // Aspect fit, scaled by the GPU
+        const MosaicRect fit = fitInCell(MosaicRect{0.0, 0.0, width(), height()},
+                                         m_frameSize.width(), m_frameSize.height());
+        const QRectF rect(fit.x, fit.y, fit.width, fit.height);
+        if (m_rawNode)
+            static_cast<YuvVideoNode*>(node)->setRect(rect);
+        else
+            static_cast<VideoNode*>(node)->setRect(rect);
+        m_geometryDirty = false;
+    }
+    return node;
+}
@@ -0,0 +1,79 @@
+#ifndef VIDEOSURFACEITEM_H
+#define VIDEOSURFACEITEM_H
+
+#include <QImage>
+#include <QPointer>
+#include <QQuickItem>
+#include "encodedframe.h"
+
+class ImageServerBridge;
+class QQuickWindow;
+
+// Video surface for the active client, fed straight from the bridge.
+// Frames are handed over by reference (no image provider, no URL reload); the
+// render thread uploads the latest one in updatePaintNode(), so any number of
+// frames arriving within one vsync costs a single upload. When the frame size is
+// unchanged the same GL texture is refilled in place (glTexSubImage2D) instead of
+// being reallocated; other scene-graph backends fall back to a fresh texture.
+// Raw YUV frames are uploaded plane by plane and converted to RGB in a fragment
+// shader; without OpenGL they are converted on the CPU.
+// With the bridge's jitter buffer on, each buffer swap asks the bridge for the
+// frame due at the next refresh, so paced frames change on vsync.
+//
+// QML: VideoSurface { bridge: imageSocket }
+class VideoSurfaceItem : public QQuickItem
+{
+    Q_OBJECT
+    Q_PROPERTY(QObject* bridge READ bridge WRITE setBridge NOTIFY bridgeChanged)
+    Q_PROPERTY(bool hasFrame READ hasFrame NOTIFY hasFrameChanged)
+    Q_PROPERTY(QSize frameSize READ frameSize NOTIFY frameSizeChanged)
+    Q_PROPERTY(int coalescedFrames READ coalescedFrames NOTIFY statsChanged)
+
+public:
+    explicit VideoSurfaceItem(QQuickItem* parent = nullptr);
+
+    QObject* bridge() const;
+    void setBridge(QObject* bridge);
+
+    bool hasFrame() const { return m_hasFrame; }
+    QSize frameSize() const { return m_frameSize; }
+    // Frames replaced before they were drawn (more than one frame per vsync)
+    int coalescedFrames() const { return m_coalescedFrames; }
+
+    // Show `frame` on the next render; a frame not yet drawn is replaced
+    Q_INVOKABLE void presentFrame(const QImage& frame);
+    // Same for a raw YUV frame; invalid payloads are ignored
+    void presentRawFrame(const EncodedFrame& frame);
+    Q_INVOKABLE void clear();
+
+signals:
+    void bridgeChanged();
+    void hasFrameChanged();
+    void frameSizeChanged();
+    void statsChanged();
+
+protected:
+    QSGNode* updatePaintNode(QSGNode* oldNode, UpdatePaintNodeData* data) override;
+    void geometryChanged(const QRectF& newGeometry, const QRectF& oldGeometry) override;
+
+private:
+    // Common bookkeeping when a new frame of `size` replaces the pending one
+    void queueFrame(const QSize& size);
+    void attachWindow(QQuickWindow* window);
+    // After the buffer swap at `swappedAtUs`: the bridge's paced frame for the next refresh
+    void paceFrames(qint64 swappedAtUs);
+    void requestRefresh();
+
+    QPointer<ImageServerBridge> m_bridge;
+    QPointer<QQuickWindow> m_window;
+    QImage m_pending;         // latest frame, released once uploaded
+    EncodedFrame m_pendingRaw; // or the latest raw frame (only one of the two is set)
+    bool m_rawNode = false;   // render thread: the current node draws YUV planes
+    bool m_clearPending = false;
+    bool m_geometryDirty = true;
+    bool m_hasFrame = false;
+    QSize m_frameSize;
+    int m_coalescedFrames = 0;
+};
+
+#endif // VIDEOSURFACEITEM_H
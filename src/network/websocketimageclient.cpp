@@ -8,10 +8,24 @@
 #include <future>
 #include <QDebug>
 #include <memory>
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <iostream>
 #include <QTimer>
 #include <QMetaObject>
 #include "control.pb.h"
+#include "controlmessage.h"
+#include "controlreader.h"
+#include "frametrace.h"
+#include "jpegheader.h"
+#include "keepalive.h"
+#include "rawframe.h"
+#include "reconnectbackoff.h"
+#include "shmframering.h"
+#include "threadroles.h"
+#include "tlsstream.h"
+#include "udpframing.h"
 
 namespace asio = boost::asio;
 namespace beast = boost::beast;
@@ -19,20 +33,433 @@ namespace websocket = beast::websocket;
 using tcp = asio::ip::tcp;
 using imagesocket::control::ControlMessage;
 
+namespace {
+// Prefix bytes live in static storage so a write can reference them by address
+const std::uint8_t kImagePrefix = static_cast<std::uint8_t>(MessagePrefix::Image);
+const std::uint8_t kControlPrefix = static_cast<std::uint8_t>(MessagePrefix::Control);
+const std::uint8_t kRawFramePrefix = static_cast<std::uint8_t>(MessagePrefix::RawFrame);
+const std::uint8_t kVideoPrefix = static_cast<std::uint8_t>(MessagePrefix::Video);
+const std::uint8_t kFramedPrefix = static_cast<std::uint8_t>(MessagePrefix::Framed);
+const std::uint8_t kControlBatchPrefix = static_cast<std::uint8_t>(MessagePrefix::ControlBatch);
+// Most control messages one ControlBatch carries
+const std::size_t kMaxControlBatch = 32;
+
+// How often the sender reports its queue to the server's rate controller
+const std::int64_t kStatsIntervalMs = 500;
+// Longest wait for CONFIG after HELLO before streaming unconfigured
+const std::int64_t kConfigWaitMs = 1000;
+
+std::int64_t wallClockMs()
+{
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+// Failover times, immune to clock steps
+std::int64_t steadyClockMs()
+{
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+std::int64_t wallClockUs()
+{
+    using namespace std::chrono;
+    return duration_cast<microseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+// The roi_* fields of SET_ROI and CONFIG
+FrameRegion regionOf(const ControlMessage &msg)
+{
+    FrameRegion region;
+    region.x = msg.roi_x();
+    region.y = msg.roi_y();
+    region.width = msg.roi_width();
+    region.height = msg.roi_height();
+    return region;
+}
+
+// `message` must stay alive until the write completes: the header is stored inline
+std::array<asio::const_buffer, 3> wireBuffers(const OutboundMessage &message)
+{
+    const std::uint8_t *prefix = &kImagePrefix;
+    if (message.headerSize > 0)
+        prefix = &kFramedPrefix;
+    else if (message.prefix == MessagePrefix::Control)
+        prefix = &kControlPrefix;
+    else if (message.prefix == MessagePrefix::ControlBatch)
+        prefix = &kControlBatchPrefix;
+    else if (message.prefix == MessagePrefix::RawFrame)
+        prefix = &kRawFramePrefix;
+    else if (message.prefix == MessagePrefix::Video)
+        prefix = &kVideoPrefix;
+    return {{ asio::buffer(prefix, 1), asio::buffer(message.header.data(), message.headerSize),
+              asio::buffer(message.data, message.size) }};
+}
+
+// Sequence number of a queued frame for the trace; none without a FrameHeader
+std::int64_t traceFrame(const OutboundMessage &message)
+{
+    FrameHeader header;
+    std::size_t headerSize = 0;
+    if (message.headerSize == 0 || !parseFrameHeader(message.header.data(), message.headerSize, header, headerSize))
+        return FrameTrace::kNoFrame;
+    return header.sequence;
+}
+
+OutboundMessage shareByteArray(const QByteArray &bytes, MessagePrefix prefix)
+{
+    // Copying a QByteArray only bumps its reference count
+    auto owner = std::make_shared<const QByteArray>(bytes);
+    return OutboundMessage::fromOwner(owner, owner->constData(), static_cast<std::size_t>(owner->size()), prefix);
+}
+
+// The first `count` queued control messages as one ControlBatch message;
+// each is copied in as it was serialized, behind its field tag and length
+OutboundMessage controlBatchOf(const OutboundQueue<OutboundMessage> &queue, std::size_t count)
+{
+    std::size_t size = 0;
+    for (std::size_t i = 0; i < count; ++i)
+        size += queue.at(i).size + 6;
+    auto batch = std::make_shared<std::string>();
+    batch->reserve(size);
+    for (std::size_t i = 0; i < count; ++i) {
+        const OutboundMessage &message = queue.at(i);
+        appendControlBatchEntry(*batch, reinterpret_cast<const char *>(message.data), message.size);
+    }
+    return OutboundMessage::fromOwner(batch, batch->data(), batch->size(), MessagePrefix::ControlBatch);
+}
+
+using Strand = asio::strand<asio::io_context::executor_type>;
+
+struct ConnectTarget {
+    std::string host;
+    std::string port;
+};
+
+// Resolves the servers and races TCP connects over their addresses (happy
+// eyeballs, RFC 8305 in short). Candidates go in server order, each server's
+// address families alternating, led by the resolver's first choice; the next
+// candidate starts attemptDelayMs after the previous one or as soon as it
+// fails; the first socket to connect wins and the others are closed. A
+// standby server is thus tried right away when the primary refuses, and after
+// the primary's head start when it doesn't answer. Resolving and the race each
+// have their own deadline (servers resolved by then are raced). Runs on
+// `strand`, the handler too; it is called exactly once.
+class HappyEyeballsConnector : public std::enable_shared_from_this<HappyEyeballsConnector>
+{
+public:
+    // `target` indexes the servers passed in
+    using Handler = std::function<void(beast::error_code, tcp::socket, std::size_t target)>;
+
+    HappyEyeballsConnector(const Strand &strand, const ConnectTimeouts &timeouts,
+                           std::vector<ConnectTarget> targets, Handler handler)
+        : m_strand(strand), m_timeouts(timeouts), m_targets(std::move(targets)),
+          m_handler(std::move(handler)), m_deadline(strand), m_stagger(strand) {}
+
+    void start()
+    {
+        auto self = shared_from_this();
+        armDeadline(m_timeouts.resolveMs);
+        m_resolved.resize(m_targets.size());
+        for (std::size_t i = 0; i < m_targets.size(); ++i) {
+            m_resolvers.emplace_back(new tcp::resolver(m_strand));
+            m_resolvers.back()->async_resolve(m_targets[i].host, m_targets[i].port,
+                [self, i](beast::error_code ec, const tcp::resolver::results_type &results) {
+                    self->onResolved(i, ec, results);
+                });
+        }
+        if (m_targets.empty())
+            finish(asio::error::host_not_found, 0);
+    }
+
+private:
+    struct Candidate {
+        tcp::endpoint endpoint;
+        std::size_t target;
+    };
+
+    void armDeadline(int ms)
+    {
+        auto self = shared_from_this();
+        m_deadline.expires_after(std::chrono::milliseconds(std::max(1, ms)));
+        m_deadline.async_wait([self](beast::error_code ec) {
+            if (ec)
+                return;
+            if (self->m_racing)
+                self->finish(asio::error::timed_out, 0);
+            else
+                self->startRace(asio::error::timed_out); // with the servers resolved so far
+        });
+    }
+
+    void onResolved(std::size_t target, beast::error_code ec, const tcp::resolver::results_type &results)
+    {
+        if (m_done || m_racing)
+            return;
+        if (ec) {
+            m_lastError = ec;
+        } else {
+            std::vector<tcp::endpoint> leading;
+            std::vector<tcp::endpoint> other;
+            for (const auto &entry : results) {
+                const tcp::endpoint endpoint = entry.endpoint();
+                if (leading.empty() || endpoint.protocol() == leading.front().protocol())
+                    leading.push_back(endpoint);
+                else
+                    other.push_back(endpoint);
+            }
+            for (std::size_t i = 0; i < std::max(leading.size(), other.size()); ++i) {
+                if (i < leading.size())
+                    m_resolved[target].push_back(leading[i]);
+                if (i < other.size())
+                    m_resolved[target].push_back(other[i]);
+            }
+        }
+        if (++m_answered == m_targets.size())
+            startRace(m_lastError);
+    }
+
+    void startRace(beast::error_code resolveError)
+    {
+        m_racing = true;
+        for (const auto &resolver : m_resolvers)
+            resolver->cancel();
+        for (std::size_t target = 0; target < m_resolved.size(); ++target) {
+            for (const tcp::endpoint &endpoint : m_resolved[target])
+                m_candidates.push_back(Candidate{endpoint, target});
+        }
+        if (m_candidates.empty()) {
+            finish(resolveError ? resolveError : beast::error_code(asio::error::host_not_found), 0);
+            return;
+        }
+        armDeadline(m_timeouts.connectMs);
+        launchNext();
+    }
+
+    void launchNext()
+    {
+        if (m_done || m_sockets.size() >= m_candidates.size())
+            return;
+        const std::size_t index = m_sockets.size();
+        m_sockets.emplace_back(new tcp::socket(m_strand));
+        auto self = shared_from_this();
+        m_sockets.back()->async_connect(m_candidates[index].endpoint, [self, index](beast::error_code ec) {
+            self->onConnected(index, ec);
+        });
+        if (m_sockets.size() < m_candidates.size()) {
+            // Rearming cancels the previous wait
+            m_stagger.expires_after(std::chrono::milliseconds(std::max(0, m_timeouts.attemptDelayMs)));
+            m_stagger.async_wait([self](beast::error_code ec) {
+                if (!ec)
+                    self->launchNext();
+            });
+        }
+    }
+
+    void onConnected(std::size_t index, beast::error_code ec)
+    {
+        if (m_done)
+            return;
+        if (!ec) {
+            finish(ec, index, true);
+            return;
+        }
+        if (++m_failed == m_candidates.size())
+            finish(ec, 0);
+        else
+            launchNext(); // a refused address doesn't wait out its head start
+    }
+
+    void finish(beast::error_code ec, std::size_t winner, bool connected = false)
+    {
+        if (m_done)
+            return;
+        m_done = true;
+        m_deadline.cancel();
+        m_stagger.cancel();
+        for (const auto &resolver : m_resolvers)
+            resolver->cancel();
+        tcp::socket socket(m_strand);
+        for (std::size_t i = 0; i < m_sockets.size(); ++i) {
+            beast::error_code ignored;
+            if (connected && i == winner)
+                socket = std::move(*m_sockets[i]);
+            else
+                m_sockets[i]->close(ignored);
+        }
+        m_handler(ec, std::move(socket), connected ? m_candidates[winner].target : 0);
+    }
+
+    Strand m_strand;
+    ConnectTimeouts m_timeouts;
+    std::vector<ConnectTarget> m_targets;
+    Handler m_handler;
+    asio::steady_timer m_deadline;
+    asio::steady_timer m_stagger;
+    std::vector<std::unique_ptr<tcp::resolver>> m_resolvers;
+    std::vector<std::vector<tcp::endpoint>> m_resolved; // per target, families interleaved
+    std::size_t m_answered = 0;
+    beast::error_code m_lastError;
+    bool m_racing = false;
+    std::vector<Candidate> m_candidates;
+    std::vector<std::unique_ptr<tcp::socket>> m_sockets; // one per started attempt, candidate order
+    std::size_t m_failed = 0;
+    bool m_done = false;
+};
+} // namespace
+
 struct WebSocketImageClient::Impl {
     Impl() = default;
     ~Impl() = default;
 
     std::unique_ptr<asio::io_context> ioc;
     std::unique_ptr<std::thread> ioThread;
-    std::shared_ptr<websocket::stream<tcp::socket>> ws;
+    std::shared_ptr<websocket::stream<TlsStream>> ws;
     std::atomic<bool> running{false};
     std::atomic<bool> reconnecting{false};
     std::mutex mtx;
     std::condition_variable cv;
 
-    // Configured FPS persisted from server SET_FPS messages (0 == unset)
-    std::atomic<int> configuredFps{0};
+    // ConnectionState; Connecting from connectAsync() until the handshake ends
+    std::atomic<int> state{static_cast<int>(ConnectionState::Disconnected)};
+    // Bumped by every attempt: a stale IO thread's final cleanup leaves a newer one alone
+    std::atomic<unsigned> generation{0};
+    // Timeouts and the callbacks of the attempt in progress; guarded by connectMtx
+    std::mutex connectMtx;
+    ConnectTimeouts timeouts;
+    KeepaliveConfig keepalive;
+    std::vector<ServerEndpoint> standbys;
+    // setTls(); kept across connections, so reconnects resume the session
+    std::shared_ptr<TlsContext> tls;
+    std::vector<std::function<void(bool)>> connectWaiters;
+    // Index of the connected server (0 == primary)
+    std::atomic<int> currentServer{0};
+    // Cluster node a REDIRECT pointed at (port 0 == none; guarded by connectMtx),
+    // whether the current connection went there, and whether the next
+    // reconnect follows a REDIRECT (no backoff)
+    ServerEndpoint redirect;
+    std::atomic<bool> onRedirect{false};
+    std::atomic<bool> redirectPending{false};
+    // RETRY_AFTER: the wait the server gave the next reconnect (0 == none)
+    std::atomic<std::int64_t> retryAfterMs{0};
+    // Reconnect delays; only the reconnect loop (one at a time) uses it
+    ReconnectBackoff backoff;
+    // Steady-clock time the last connection was lost (0 == not lost), and how long it took to get one back
+    std::atomic<std::int64_t> lostAtMs{0};
+    std::atomic<std::int64_t> lastFailoverMs{-1};
+
+    // What the server asked of one stream (commands carry its stream_id)
+    struct StreamControl {
+        // Configured FPS persisted from server SET_FPS messages (0 == unset)
+        std::atomic<int> configuredFps{0};
+        // JPEG quality from server SET_QUALITY messages (0 == unset)
+        std::atomic<int> configuredQuality{0};
+        // Frame size bound from server SET_RESOLUTION (0 == none); per connection like pause
+        std::atomic<int> maxWidth{0};
+        std::atomic<int> maxHeight{0};
+        // Region of interest from server SET_ROI (full == none); per connection, guarded by roiMtx
+        FrameRegion roi;
+        // Set by server PAUSE/UNSUBSCRIBE, cleared by RESUME/SUBSCRIBE and on every new connection
+        std::atomic<bool> paused{false};
+        // Set by REQUEST_KEYFRAME or a locally dropped video packet, cleared by takeKeyframeRequest()
+        std::atomic<bool> keyframeRequested{false};
+    };
+    std::array<StreamControl, kMaxStreamsPerConnection> streams;
+    mutable std::mutex roiMtx;
+    // Ids past the last stream count as the main stream, as on the server
+    StreamControl &stream(std::uint32_t streamId)
+    {
+        return streams[streamId < streams.size() ? streamId : 0];
+    }
+
+    // Codec from server SET_CODEC (VideoCodec, Mjpeg until negotiated); per connection
+    std::atomic<int> negotiatedCodec{0};
+    // Set by server FRAME_HEADER, cleared on every new connection
+    std::atomic<bool> frameHeaders{false};
+    // The server takes ControlBatch (CONFIG control_batch); cleared on every new connection
+    std::atomic<bool> controlBatch{false};
+    // Until CONFIG answers HELLO frames are held back; wall-clock deadline, 0 == not waiting
+    std::atomic<std::int64_t> configWaitUntilMs{0};
+    std::atomic<bool> configured{false};
+    // Session token from CONFIG (or setSessionToken()); survives reconnects
+    mutable std::mutex tokenMtx;
+    std::string sessionToken;
+    // FrameHeader sequence number of the next frame; restarts with each connection
+    std::atomic<std::uint32_t> nextSequence{0};
+    // Wall-clock time of the last STATS report
+    std::atomic<std::int64_t> lastStatsMs{0};
+
+    // Outbound messages; guarded by sendMtx, drained one write at a time on the strand
+    mutable std::mutex sendMtx;
+    OutboundQueue<OutboundMessage> outbound;
+    // Copy of the message being written (strand only): the write references its inline header
+    OutboundMessage inFlight;
+    // Read buffer and parsed control message, reused by every read (strand only)
+    ControlReader<ControlMessage> reader;
+    imagesocket::control::ControlBatch batch;
+
+    // Same-host transport (guarded by sendMtx): frames go into this ring once
+    // the server mapped it, the WebSocket keeps carrying control
+    ShmFrameRing shmRing;
+    ShmDoorbell shmDoorbell;
+    std::uint64_t shmDropped = 0;
+
+    // Ring write of a frame the ring takes: false (dropped) when it is full.
+    // Larger frames than a slot keep going over the WebSocket.
+    bool sharedMemoryTakes(const OutboundMessage &message) const
+    {
+        return shmRing.consumerAttached() && message.wireSize() <= shmRing.maxMessageSize();
+    }
+
+    bool writeShared(const OutboundMessage &message)
+    {
+        shmRing.unlink(); // mapped on both ends: the name is no longer needed
+        const std::uint8_t prefix = static_cast<std::uint8_t>(
+            message.headerSize > 0 ? MessagePrefix::Framed : message.prefix);
+        if (!shmRing.write({{&prefix, 1}, {message.header.data(), message.headerSize},
+                            {message.data, message.size}})) {
+            ++shmDropped;
+            return false;
+        }
+        if (shmRing.takeDoorbell()) {
+            if (!shmDoorbell.isOpen())
+                shmDoorbell.connect(shmRing.name());
+            shmDoorbell.ring();
+        }
+        return true;
+    }
+
+    // Lossy-link transport (guarded by sendMtx): frames go out as datagrams
+    // once the server opened a UDP channel, the WebSocket keeps carrying control
+    std::unique_ptr<asio::ip::udp::socket> udpSocket;
+    UdpFrameSender udpSender;
+    std::uint64_t udpDropped = 0;
+
+    bool udpTakes() const
+    {
+        return udpSocket && udpSocket->is_open();
+    }
+
+    // Every datagram or none: the socket is non-blocking, and a frame that
+    // lost datagrams here is as good as lost (the server gives it up)
+    bool writeUdp(const OutboundMessage &message)
+    {
+        const std::uint8_t prefix = static_cast<std::uint8_t>(
+            message.headerSize > 0 ? MessagePrefix::Framed : message.prefix);
+        bool failed = false;
+        udpSender.send({{&prefix, 1}, {message.header.data(), message.headerSize}, {message.data, message.size}},
+                       [this, &failed](const std::uint8_t *data, std::size_t size) {
+            if (failed)
+                return;
+            beast::error_code ec;
+            udpSocket->send(asio::buffer(data, size), 0, ec);
+            failed = static_cast<bool>(ec);
+        });
+        if (failed)
+            ++udpDropped;
+        return !failed;
+    }
 };
 
 WebSocketImageClient::WebSocketImageClient(const QString &host, quint16 port, QObject* parent)
@@ -47,108 +474,550 @@ WebSocketImageClient::~WebSocketImageClient()
     delete m_impl;
 }
 
-bool WebSocketImageClient::connectToServer()
+void WebSocketImageClient::connectAsync(std::function<void(bool)> done)
 {
-    if (m_impl->running.load())
-        return true;
+    ConnectionState state;
+    unsigned generation = 0;
+    ConnectTimeouts timeouts;
+    KeepaliveConfig keepalive;
+    std::vector<ConnectTarget> targets;
+    bool redirected = false;
+    std::shared_ptr<TlsContext> tls;
+    {
+        std::lock_guard<std::mutex> lock(m_impl->connectMtx);
+        state = static_cast<ConnectionState>(m_impl->state.load());
+        if (state != ConnectionState::Connected && done)
+            m_impl->connectWaiters.push_back(std::move(done));
+        if (state == ConnectionState::Disconnected) {
+            m_impl->state.store(static_cast<int>(ConnectionState::Connecting));
+            generation = ++m_impl->generation;
+            timeouts = m_impl->timeouts;
+            keepalive = m_impl->keepalive;
+            tls = m_impl->tls;
+            // A cluster node the server sent us to leads, the configured servers stay behind it
+            redirected = m_impl->redirect.port != 0;
+            if (redirected)
+                targets.push_back(ConnectTarget{m_impl->redirect.host.toStdString(), std::to_string(m_impl->redirect.port)});
+            targets.push_back(ConnectTarget{m_host.toStdString(), std::to_string(m_port)});
+            for (const ServerEndpoint &standby : m_impl->standbys)
+                targets.push_back(ConnectTarget{standby.host.toStdString(), std::to_string(standby.port)});
+        }
+    }
+    if (state == ConnectionState::Connected) {
+        if (done) done(true);
+        return;
+    }
+    if (state == ConnectionState::Connecting)
+        return; // the attempt in progress answers
 
     // Cleanup previous connection
-    cleanupConnection();
+    teardownConnection();
 
     m_impl->running.store(true);
     m_impl->ioc.reset(new asio::io_context());
+    {
+        // Drop anything left over from a previous connection
+        std::lock_guard<std::mutex> sendLock(m_impl->sendMtx);
+        m_impl->outbound.clear();
+    }
+    for (Impl::StreamControl &stream : m_impl->streams) {
+        stream.paused.store(false);
+        stream.maxWidth.store(0);
+        stream.maxHeight.store(0);
+        stream.keyframeRequested.store(false);
+    }
+    {
+        std::lock_guard<std::mutex> roiLock(m_impl->roiMtx);
+        for (Impl::StreamControl &stream : m_impl->streams)
+            stream.roi = FrameRegion();
+    }
+    m_impl->negotiatedCodec.store(static_cast<int>(VideoCodec::Mjpeg));
+    m_impl->frameHeaders.store(false);
+    m_impl->controlBatch.store(false);
+    m_impl->configured.store(false);
+    m_impl->configWaitUntilMs.store(0);
+    m_impl->nextSequence.store(0);
 
-    try {
-        tcp::resolver resolver(*m_impl->ioc);
-        auto const results = resolver.resolve(m_host.toStdString(), std::to_string(m_port));
-
-        tcp::socket socket(*m_impl->ioc);
-        asio::connect(socket, results);
-
-        // Keep io_context alive while async ops are pending
-        auto workGuard = asio::make_work_guard(*m_impl->ioc);
-        auto guardPtr = std::make_shared<decltype(workGuard)>(std::move(workGuard));
-
-        m_impl->ws = std::make_shared<websocket::stream<tcp::socket>>(std::move(socket));
-        
-        // Configure WebSocket options for large frames
-        m_impl->ws->binary(true);
-        m_impl->ws->auto_fragment(true);
-        m_impl->ws->write_buffer_bytes(256 * 1024); // 256KB write buffer
-
-        // Start io_context in background thread FIRST
-        qInfo() << "Starting IO thread (id will be set after thread runs)";
-        m_impl->ioThread.reset(new std::thread([this, guardPtr]() {
-            Q_UNUSED(guardPtr); // Keep work guard alive during run()
-            qInfo() << "IO thread started";
-            try {
-                m_impl->ioc->run();
-            } catch (const std::exception &ex) {
-                qWarning() << "IO thread exception:" << ex.what();
-            }
-            qInfo() << "IO thread exiting";
+    // Keep io_context alive while async ops are pending
+    auto workGuard = asio::make_work_guard(*m_impl->ioc);
+    auto guardPtr = std::make_shared<decltype(workGuard)>(std::move(workGuard));
+
+    qInfo() << "Starting IO thread (id will be set after thread runs)";
+    m_impl->ioThread.reset(new std::thread([this, guardPtr, generation]() {
+        Q_UNUSED(guardPtr); // Keep work guard alive during run()
+        qInfo() << "IO thread started";
+        FrameTrace::setThreadName("client io");
+        ThreadRoles::apply(ThreadRole::Io);
+        try {
+            m_impl->ioc->run();
+        } catch (const std::exception &ex) {
+            qWarning() << "IO thread exception:" << ex.what();
+        }
+        qInfo() << "IO thread exiting";
 
-            // When the io_context run loop exits, request final cleanup from a non-IO thread.
-            // Use a short detached helper thread to call cleanupConnection() so final reset happens
-            // outside the io thread context. This avoids running cleanup from the IO thread.
-            std::thread([this]() {
-                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        // When the io_context run loop exits, request final cleanup from a non-IO thread.
+        // Use a short detached helper thread to call cleanupConnection() so final reset happens
+        // outside the io thread context. This avoids running cleanup from the IO thread.
+        std::thread([this, generation]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            if (m_impl->generation.load() == generation)
                 cleanupConnection();
-            }).detach();
-        }));
-
-        // Async handshake
-        std::promise<void> hsPromise;
-        auto hsFuture = hsPromise.get_future();
-
-        m_impl->ws->async_handshake(m_host.toStdString() + ":" + std::to_string(m_port), "/",
-            [&hsPromise](beast::error_code ec) {
-                if (ec) {
-                    std::cerr << "WebSocket handshake error: " << ec.message() << std::endl;
-                    try {
-                        throw beast::system_error(ec);
-                    } catch(...) {
-                        hsPromise.set_exception(std::current_exception());
-                    }
-                } else {
-                    std::cout << "WebSocket handshake succeeded" << std::endl;
-                    hsPromise.set_value();
-                }
+        }).detach();
+    }));
+
+    // Resolve, connect and handshake without blocking anyone: all stream
+    // operations and their handlers run on one strand
+    const Strand strand = asio::make_strand(*m_impl->ioc);
+    auto connector = std::make_shared<HappyEyeballsConnector>(strand, timeouts, targets,
+        [this, strand, timeouts, keepalive, targets, redirected, tls](beast::error_code ec, tcp::socket socket, std::size_t target) {
+            if (ec) {
+                qWarning() << "Connecting to" << QString::fromStdString(targets.front().host)
+                           << (targets.size() > 1 ? "and its standbys" : "") << "failed:"
+                           << QString::fromStdString(ec.message());
+                finishConnect(false);
+                return;
             }
-        );
+            const ConnectTarget &server = targets[target];
+            auto ws = std::make_shared<websocket::stream<TlsStream>>(std::move(socket), tls);
+            ws->next_layer().setServerName(server.host);
 
-        // Wait for handshake to complete (timeout support)
-        auto status = hsFuture.wait_for(std::chrono::seconds(5));
-        if (status == std::future_status::timeout) {
-            qWarning() << "WebSocket handshake timeout";
-            cleanupConnection();
-            return false;
+            // Configure WebSocket options for large frames
+            ws->binary(true);
+            ws->auto_fragment(true);
+            ws->write_buffer_bytes(256 * 1024); // 256KB write buffer
+
+            // Closing the socket aborts a handshake (TLS, then WebSocket) that takes too long
+            auto deadline = std::make_shared<asio::steady_timer>(strand);
+            deadline->expires_after(std::chrono::milliseconds(std::max(1, timeouts.handshakeMs)));
+            deadline->async_wait([ws](beast::error_code timerEc) {
+                if (timerEc)
+                    return; // handshake done first
+                beast::error_code ignored;
+                ws->next_layer().socket().close(ignored);
+            });
+            // Completes right away without TLS
+            ws->next_layer().async_handshake([this, ws, deadline, server, target, keepalive, redirected](beast::error_code tlsEc) {
+                if (tlsEc) {
+                    deadline->cancel();
+                    qWarning() << "TLS handshake failed:" << QString::fromStdString(tlsEc.message());
+                    finishConnect(false);
+                    return;
+                }
+                const TlsStream &stream = ws->next_layer();
+                if (stream.secure()) {
+                    qInfo() << "TLS" << QString::fromStdString(stream.protocol()) << QString::fromStdString(stream.cipher())
+                            << (stream.resumed() ? "(resumed)" : "") << "kTLS send" << stream.kernelSend()
+                            << "receive" << stream.kernelReceive();
+                }
+                ws->async_handshake(server.host + ":" + server.port, "/",
+                                    [this, ws, deadline, target, keepalive, redirected](beast::error_code hsEc) {
+                    deadline->cancel();
+                    if (hsEc) {
+                        qWarning() << "WebSocket handshake failed:" << QString::fromStdString(hsEc.message());
+                        finishConnect(false);
+                        return;
+                    }
+                    // Beast pings after half the timeout without traffic and fails
+                    // the read once all of it passed: a dead server is noticed
+                    // within seconds and the reconnect (or failover) starts
+                    if (const std::int64_t idleMs = keepaliveTimeoutMs(keepalive)) {
+                        auto timeout = websocket::stream_base::timeout::suggested(beast::role_type::client);
+                        timeout.idle_timeout = std::chrono::milliseconds(idleMs);
+                        timeout.keep_alive_pings = true;
+                        ws->set_option(timeout);
+                    }
+                    m_impl->ws = ws;
+                    // The redirect target counts as the primary; reaching another server ends the redirect
+                    const bool onRedirect = redirected && target == 0;
+                    m_impl->onRedirect.store(onRedirect);
+                    if (redirected && !onRedirect) {
+                        std::lock_guard<std::mutex> lock(m_impl->connectMtx);
+                        m_impl->redirect = ServerEndpoint();
+                    }
+                    m_impl->currentServer.store(static_cast<int>(redirected && target > 0 ? target - 1 : target));
+                    finishConnect(true);
+                });
+            });
+        });
+    asio::post(strand, [connector]() { connector->start(); });
+}
+
+bool WebSocketImageClient::connectToServer()
+{
+    auto result = std::make_shared<std::promise<bool>>();
+    std::future<bool> connected = result->get_future();
+    connectAsync([result](bool ok) { result->set_value(ok); });
+
+    // The attempt ends at its own deadlines; this only guards against a stuck IO thread
+    const ConnectTimeouts timeouts = connectTimeouts();
+    const auto limit = std::chrono::milliseconds(timeouts.resolveMs + timeouts.connectMs + timeouts.handshakeMs + 1000);
+    if (connected.wait_for(limit) == std::future_status::timeout) {
+        qWarning() << "WebSocketImageClient: connect timeout";
+        return false;
+    }
+    return connected.get();
+}
+
+void WebSocketImageClient::finishConnect(bool connected)
+{
+    if (!connected) {
+        cleanupConnection(); // on the IO thread: the reconnect loop takes over
+        return;
+    }
+    std::cout << "WebSocket handshake succeeded" << std::endl;
+    const int server = m_impl->currentServer.load();
+    qInfo() << "Connected to WebSocket server" << server;
+    m_impl->state.store(static_cast<int>(ConnectionState::Connected));
+    const std::int64_t lostAt = m_impl->lostAtMs.exchange(0);
+    if (lostAt > 0) {
+        const std::int64_t failoverMs = steadyClockMs() - lostAt;
+        m_impl->lastFailoverMs.store(failoverMs);
+        qInfo() << "Reconnected to server" << server << "after" << failoverMs << "ms";
+        if (m_onFailover) {
+            try { m_onFailover(server, failoverMs); } catch(...) {}
         }
+    }
+    // Ahead of anything the connect callback sends
+    sendHello();
+    if (m_onConnected) m_onConnected();
 
-        try {
-            hsFuture.get();
-        } catch (const std::exception& ex) {
-            qWarning() << "WebSocket handshake failed:" << ex.what();
-            cleanupConnection();
+    // Start async read loop for control messages
+    doAsyncRead();
+    sendSupportedCodecs(); // for servers that predate HELLO
+    notifyConnectWaiters(true);
+}
+
+void WebSocketImageClient::notifyConnectWaiters(bool connected)
+{
+    std::vector<std::function<void(bool)>> waiters;
+    {
+        std::lock_guard<std::mutex> lock(m_impl->connectMtx);
+        waiters.swap(m_impl->connectWaiters);
+    }
+    for (const auto &waiter : waiters) {
+        try { waiter(connected); } catch(...) {}
+    }
+}
+
+void WebSocketImageClient::setStandbyServers(const std::vector<ServerEndpoint> &servers)
+{
+    std::lock_guard<std::mutex> lock(m_impl->connectMtx);
+    m_impl->standbys = servers;
+}
+
+std::vector<ServerEndpoint> WebSocketImageClient::standbyServers() const
+{
+    std::lock_guard<std::mutex> lock(m_impl->connectMtx);
+    return m_impl->standbys;
+}
+
+int WebSocketImageClient::currentServer() const
+{
+    return m_impl->currentServer.load();
+}
+
+ServerEndpoint WebSocketImageClient::redirectedServer() const
+{
+    std::lock_guard<std::mutex> lock(m_impl->connectMtx);
+    return m_impl->redirect;
+}
+
+std::int64_t WebSocketImageClient::lastFailoverMs() const
+{
+    return m_impl->lastFailoverMs.load();
+}
+
+ConnectionState WebSocketImageClient::connectionState() const
+{
+    return static_cast<ConnectionState>(m_impl->state.load());
+}
+
+void WebSocketImageClient::setConnectTimeouts(const ConnectTimeouts &timeouts)
+{
+    std::lock_guard<std::mutex> lock(m_impl->connectMtx);
+    m_impl->timeouts = timeouts;
+}
+
+ConnectTimeouts WebSocketImageClient::connectTimeouts() const
+{
+    std::lock_guard<std::mutex> lock(m_impl->connectMtx);
+    return m_impl->timeouts;
+}
+
+void WebSocketImageClient::setKeepalive(const KeepaliveConfig &keepalive)
+{
+    std::lock_guard<std::mutex> lock(m_impl->connectMtx);
+    m_impl->keepalive = keepalive;
+}
+
+KeepaliveConfig WebSocketImageClient::keepalive() const
+{
+    std::lock_guard<std::mutex> lock(m_impl->connectMtx);
+    return m_impl->keepalive;
+}
+
+VideoCodec WebSocketImageClient::negotiatedCodec() const {
+    return m_impl ? static_cast<VideoCodec>(m_impl->negotiatedCodec.load()) : VideoCodec::Mjpeg;
+}
+
+bool WebSocketImageClient::takeKeyframeRequest(std::uint16_t streamId) {
+    return m_impl && m_impl->stream(streamId).keyframeRequested.exchange(false);
+}
+
+void WebSocketImageClient::sendSupportedCodecs()
+{
+    if (m_supportedCodecs.empty())
+        return; // older servers and MJPEG-only clients skip negotiation entirely
+
+    ControlMessage msg;
+    msg.set_type(imagesocket::control::CODECS);
+    for (VideoCodec codec : m_supportedCodecs)
+        msg.add_codecs(static_cast<imagesocket::control::VideoCodec>(codec));
+    sendControlMessage(msg);
+}
+
+std::string WebSocketImageClient::offerSharedMemory()
+{
+    std::lock_guard<std::mutex> lock(m_impl->sendMtx);
+    m_impl->shmRing.close();
+    m_impl->shmDoorbell.close();
+#ifdef __linux__
+    if (!m_sharedMemory || !m_impl->ws)
+        return std::string();
+
+    // Only a server on this host can map the ring
+    beast::error_code remoteError;
+    beast::error_code localError;
+    const tcp::socket &socket = m_impl->ws->next_layer().socket();
+    const asio::ip::address remote = socket.remote_endpoint(remoteError).address();
+    const asio::ip::address local = socket.local_endpoint(localError).address();
+    if (remoteError || localError || !(remote.is_loopback() || remote == local))
+        return std::string();
+
+    static std::atomic<int> rings{0};
+    const std::string name = kShmRingNamePrefix + std::to_string(::getpid()) + "-" + std::to_string(rings.fetch_add(1));
+    if (!m_impl->shmRing.create(name)) {
+        qWarning() << "Shared memory transport unavailable:" << QString::fromStdString(m_impl->shmRing.errorString());
+        return std::string();
+    }
+    return name;
+#else
+    return std::string();
+#endif
+}
+
+bool WebSocketImageClient::isSharedMemoryActive() const
+{
+    std::lock_guard<std::mutex> lock(m_impl->sendMtx);
+    return m_impl->shmRing.consumerAttached();
+}
+
+void WebSocketImageClient::openUdpChannel(int port, std::uint32_t key)
+{
+    std::lock_guard<std::mutex> lock(m_impl->sendMtx);
+    if (!m_udpTransport || !m_impl->ws || !m_impl->ioc || port <= 0 || port > 0xFFFF)
+        return;
+    beast::error_code ec;
+    const asio::ip::address remote = m_impl->ws->next_layer().socket().remote_endpoint(ec).address();
+    if (ec)
+        return;
+    auto socket = std::make_unique<asio::ip::udp::socket>(*m_impl->ioc);
+    const asio::ip::udp::endpoint endpoint(remote, static_cast<unsigned short>(port));
+    socket->open(endpoint.protocol(), ec);
+    if (!ec)
+        socket->connect(endpoint, ec);
+    if (!ec)
+        socket->non_blocking(true, ec);
+    if (ec) {
+        qWarning() << "UDP frame transport unavailable:" << QString::fromStdString(ec.message());
+        return;
+    }
+    // Room for a few frames' worth of datagrams between two sends (best effort)
+    socket->set_option(asio::socket_base::send_buffer_size(4 << 20), ec);
+    m_impl->udpSocket = std::move(socket);
+    m_impl->udpSender.setFecRatio(m_udpFecRatio);
+    m_impl->udpSender.setKey(key);
+    qInfo() << "Sending frames over UDP to port" << port;
+}
+
+bool WebSocketImageClient::isUdpActive() const
+{
+    std::lock_guard<std::mutex> lock(m_impl->sendMtx);
+    return m_impl->udpTakes();
+}
+
+bool WebSocketImageClient::setTls(bool enabled, const QString &caFile, bool verifyPeer)
+{
+    std::shared_ptr<TlsContext> tls;
+    if (enabled) {
+        std::string error;
+        tls = TlsContext::client(caFile.toStdString(), verifyPeer, &error);
+        if (!tls) {
+            qWarning() << "WebSocketImageClient: TLS unavailable:" << QString::fromStdString(error);
             return false;
         }
+    }
+    std::lock_guard<std::mutex> lock(m_impl->connectMtx);
+    m_impl->tls = tls;
+    return true;
+}
 
-        qInfo() << "Connected to WebSocket server";
-        if (m_onConnected) m_onConnected();
+bool WebSocketImageClient::tlsEnabled() const
+{
+    std::lock_guard<std::mutex> lock(m_impl->connectMtx);
+    return m_impl->tls != nullptr;
+}
 
-        // Start async read loop for control messages
-        doAsyncRead();
+void WebSocketImageClient::sendHello()
+{
+    ControlMessage msg;
+    msg.set_type(imagesocket::control::HELLO);
+    msg.set_alias(m_alias.toStdString());
+    for (VideoCodec codec : m_supportedCodecs)
+        msg.add_codecs(static_cast<imagesocket::control::VideoCodec>(codec));
+    msg.set_fps(std::max(0, m_maxCaptureFps));
+    msg.set_max_width(std::max(0, m_maxCaptureWidth));
+    msg.set_max_height(std::max(0, m_maxCaptureHeight));
+    msg.set_stream_count(std::max(std::max(1, m_streamCount), m_simulcastLayers));
+    if (m_simulcastLayers > 1)
+        msg.set_simulcast_layers(m_simulcastLayers);
+    msg.set_shm_ring(offerSharedMemory());
+    msg.set_udp_frames(m_udpTransport);
+    msg.set_control_batch(true);
+    // Moved at most once per connect: not again from the node a REDIRECT led to
+    msg.set_accepts_redirect(!m_impl->onRedirect.load());
+    {
+        std::lock_guard<std::mutex> lock(m_impl->tokenMtx);
+        msg.set_session_token(m_impl->sessionToken);
+    }
+    m_impl->configWaitUntilMs.store(wallClockMs() + kConfigWaitMs);
+    if (!sendControlMessage(msg))
+        m_impl->configWaitUntilMs.store(0);
+}
 
-        return true;
-    } catch (const std::exception &ex) {
-        qWarning() << "WebSocketImageClient exception:" << ex.what();
-        m_impl->running.store(false);
+void WebSocketImageClient::applyConfig(const ControlMessage &config)
+{
+    qInfo() << "Received CONFIG from server: fps" << config.fps() << "quality" << config.quality()
+            << "codec" << static_cast<int>(config.codec()) << "paused" << config.paused();
+    if (config.frame_header())
+        m_impl->frameHeaders.store(true);
+    if (config.control_batch())
+        m_impl->controlBatch.store(true);
+    if (!config.session_token().empty()) {
+        std::lock_guard<std::mutex> lock(m_impl->tokenMtx);
+        m_impl->sessionToken = config.session_token();
+    }
+    // The main stream's settings; the others get theirs once the server sees them
+    applyResolution(0, std::max(0, config.max_width()), std::max(0, config.max_height()));
+    applyRegion(0, regionOf(config));
+    applyCodec(static_cast<VideoCodec>(config.codec()));
+    if (config.quality() > 0)
+        applyQuality(0, config.quality());
+    if (config.fps() > 0)
+        applyConfiguredFps(0, config.fps());
+    setPaused(0, config.paused());
+    m_impl->configured.store(true);
+    m_impl->configWaitUntilMs.store(0); // frames flow from here
+}
+
+void WebSocketImageClient::applyResolution(std::uint32_t streamId, int maxWidth, int maxHeight)
+{
+    Impl::StreamControl &stream = m_impl->stream(streamId);
+    stream.maxWidth.store(maxWidth);
+    stream.maxHeight.store(maxHeight);
+    if (streamId == 0 && m_onResolutionChanged) {
+        try { m_onResolutionChanged(maxWidth, maxHeight); } catch(...) {}
+    }
+}
+
+void WebSocketImageClient::applyRegion(std::uint32_t streamId, const FrameRegion &region)
+{
+    std::lock_guard<std::mutex> lock(m_impl->roiMtx);
+    m_impl->stream(streamId).roi = region;
+}
+
+void WebSocketImageClient::applyCodec(VideoCodec codec)
+{
+    // A new stream always starts on a keyframe
+    for (Impl::StreamControl &stream : m_impl->streams)
+        stream.keyframeRequested.store(true);
+    if (m_impl->negotiatedCodec.exchange(static_cast<int>(codec)) != static_cast<int>(codec)
+        && m_onCodecChanged) {
+        try { m_onCodecChanged(codec); } catch(...) {}
+    }
+}
+
+bool WebSocketImageClient::holdingForConfig() const
+{
+    const std::int64_t until = m_impl->configWaitUntilMs.load();
+    if (until == 0)
         return false;
+    if (wallClockMs() < until)
+        return true;
+    if (m_impl->configWaitUntilMs.exchange(0) != 0)
+        qWarning() << "No CONFIG from the server: streaming with the local settings";
+    return false;
+}
+
+bool WebSocketImageClient::isConfigured() const {
+    return m_impl && m_impl->configured.load();
+}
+
+int WebSocketImageClient::configuredFps(std::uint16_t streamId) const {
+    return m_impl ? m_impl->stream(streamId).configuredFps.load() : 0;
+}
+
+int WebSocketImageClient::configuredQuality(std::uint16_t streamId) const {
+    return m_impl ? m_impl->stream(streamId).configuredQuality.load() : 0;
+}
+
+int WebSocketImageClient::maxFrameWidth(std::uint16_t streamId) const {
+    return m_impl ? m_impl->stream(streamId).maxWidth.load() : 0;
+}
+
+int WebSocketImageClient::maxFrameHeight(std::uint16_t streamId) const {
+    return m_impl ? m_impl->stream(streamId).maxHeight.load() : 0;
+}
+
+FrameRegion WebSocketImageClient::regionOfInterest(std::uint16_t streamId) const {
+    if (!m_impl)
+        return FrameRegion();
+    std::lock_guard<std::mutex> lock(m_impl->roiMtx);
+    return m_impl->stream(streamId).roi;
+}
+
+bool WebSocketImageClient::isPaused(std::uint16_t streamId) const {
+    return m_impl ? m_impl->stream(streamId).paused.load() : false;
+}
+
+void WebSocketImageClient::setPaused(std::uint32_t streamId, bool paused)
+{
+    if (m_impl->stream(streamId).paused.exchange(paused) == paused)
+        return;
+    qInfo() << (paused ? "Streaming paused by server" : "Streaming resumed by server") << "stream" << streamId;
+    if (streamId == 0 && m_onPausedChanged) {
+        try { m_onPausedChanged(paused); } catch(...) {}
+    }
+}
+
+void WebSocketImageClient::applyConfiguredFps(std::uint32_t streamId, int fps)
+{
+    if (m_impl) {
+        m_impl->stream(streamId).configuredFps.store(fps);
+    }
+    // invoke callback if set (note: may run on IO thread)
+    if (streamId == 0 && m_onFpsChanged) {
+        try { m_onFpsChanged(fps); } catch(...) {}
     }
 }
 
-int WebSocketImageClient::configuredFps() const {
-    return m_impl ? m_impl->configuredFps.load() : 0;
+void WebSocketImageClient::applyQuality(std::uint32_t streamId, int quality)
+{
+    quality = std::max(1, std::min(100, quality));
+    m_impl->stream(streamId).configuredQuality.store(quality);
+    if (streamId == 0 && m_onQualityChanged) {
+        try { m_onQualityChanged(quality); } catch(...) {}
+    }
 }
 
 void WebSocketImageClient::setAlias(const QString& alias)
@@ -161,66 +1030,143 @@ QString WebSocketImageClient::alias() const
     return m_alias;
 }
 
+void WebSocketImageClient::setSessionToken(const QString& token)
+{
+    std::lock_guard<std::mutex> lock(m_impl->tokenMtx);
+    m_impl->sessionToken = token.toStdString();
+}
+
+QString WebSocketImageClient::sessionToken() const
+{
+    std::lock_guard<std::mutex> lock(m_impl->tokenMtx);
+    return QString::fromStdString(m_impl->sessionToken);
+}
+
 void WebSocketImageClient::doAsyncRead()
 {
     if (!m_impl->running.load() || !m_impl->ws) return;
 
-    auto buffer = std::make_shared<beast::flat_buffer>();
-
-    m_impl->ws->async_read(*buffer,
-        [this, buffer](beast::error_code ec, std::size_t bytes_transferred) {
+    // One buffer per client, reused by every read: nothing is allocated per message
+    ControlReader<ControlMessage> &reader = m_impl->reader;
+    reader.consume();
+    m_impl->ws->async_read(reader.buffer(),
+        [this](beast::error_code ec, std::size_t bytes_transferred) {
             (void)bytes_transferred;
             if (ec) {
                 qWarning() << "WebSocket read error:" << QString::fromStdString(ec.message());
-                cleanupConnection();
+                connectionLost();
                 return;
             }
 
-            // Convert buffer to string to inspect prefix
-            std::string s = beast::buffers_to_string(buffer->data());
-            if (!s.empty()) {
-                unsigned char prefix = static_cast<unsigned char>(s[0]);
-                if (prefix == 0x01) {
-                    // Control message
-                    ControlMessage msg;
-                    if (msg.ParseFromArray(s.data() + 1, static_cast<int>(s.size() - 1))) {
-                        qInfo() << "Received ControlMessage type=" << msg.type();
-                        if (msg.type() == imagesocket::control::REQUEST_ALIAS) {
-                            // Reply with our alias (if any)
-                            ControlMessage reply;
-                            reply.set_type(imagesocket::control::ALIAS);
-                            reply.set_alias(m_alias.toStdString());
-                            std::string out;
-                            if (reply.SerializeToString(&out)) {
-                                QByteArray ba(out.data(), static_cast<int>(out.size()));
-                                sendControlMessage(ba);
-                            }
-                        } else if (msg.type() == imagesocket::control::SET_FPS) {
-                            int fps = msg.fps();
-                            qInfo() << "Received SET_FPS from server:" << fps;
-                            if (m_impl) {
-                                m_impl->configuredFps.store(fps);
-                            }
-                            // invoke callback if set (note: may run on IO thread)
-                            if (m_onFpsChanged) {
-                                try { m_onFpsChanged(fps); } catch(...) {}
-                            }
-                        }
-                    } else {
-                        qWarning() << "Failed to parse ControlMessage from server";
-                    }
+            ControlReader<ControlMessage> &reader = m_impl->reader;
+            // Non-control messages: ignore for now
+            if (reader.isControl()) {
+                // Parsed in place from the buffer into the reused message
+                const ControlMessage *parsed = reader.parse();
+                if (parsed)
+                    handleControl(*parsed);
+                else
+                    qWarning() << "Failed to parse ControlMessage from server";
+            } else if (reader.isBatch()) {
+                // Several at once (ControlBatch), handled in order; the batch is reused as well
+                if (reader.parseBatch(m_impl->batch)) {
+                    for (const ControlMessage &msg : m_impl->batch.messages())
+                        handleControl(msg);
                 } else {
-                    // Non-control message: ignore for now
+                    qWarning() << "Failed to parse ControlBatch from server";
                 }
             }
 
-            buffer->consume(buffer->size());
+            reader.consume();
             // Schedule next read
             doAsyncRead();
         }
     );
 }
 
+void WebSocketImageClient::handleControl(const ControlMessage &msg)
+{
+    if (msg.type() != imagesocket::control::PING)
+        qInfo() << "Received ControlMessage type=" << msg.type();
+    if (msg.type() == imagesocket::control::CONFIG) {
+        applyConfig(msg);
+    } else if (msg.type() == imagesocket::control::REQUEST_ALIAS) {
+        // Only servers without HELLO ask: stop waiting for CONFIG
+        m_impl->configWaitUntilMs.store(0);
+        // Reply with our alias (if any)
+        ControlMessage reply;
+        reply.set_type(imagesocket::control::ALIAS);
+        reply.set_alias(m_alias.toStdString());
+        sendControlMessage(reply);
+    } else if (msg.type() == imagesocket::control::SET_FPS) {
+        int fps = msg.fps();
+        qInfo() << "Received SET_FPS from server:" << fps << "stream" << msg.stream_id();
+        applyConfiguredFps(msg.stream_id(), fps);
+    } else if (msg.type() == imagesocket::control::PAUSE
+               || msg.type() == imagesocket::control::UNSUBSCRIBE) {
+        setPaused(msg.stream_id(), true);
+    } else if (msg.type() == imagesocket::control::RESUME) {
+        setPaused(msg.stream_id(), false);
+    } else if (msg.type() == imagesocket::control::SET_RESOLUTION) {
+        const int maxWidth = std::max(0, msg.max_width());
+        const int maxHeight = std::max(0, msg.max_height());
+        qInfo() << "Received SET_RESOLUTION from server:" << maxWidth << "x" << maxHeight;
+        applyResolution(msg.stream_id(), maxWidth, maxHeight);
+    } else if (msg.type() == imagesocket::control::SET_ROI) {
+        const FrameRegion region = regionOf(msg);
+        qInfo() << "Received SET_ROI from server:" << region.x << region.y << region.width
+                << "x" << region.height << "stream" << msg.stream_id();
+        applyRegion(msg.stream_id(), region);
+    } else if (msg.type() == imagesocket::control::UDP_CHANNEL) {
+        openUdpChannel(msg.udp_port(), msg.udp_key());
+    } else if (msg.type() == imagesocket::control::REDIRECT) {
+        if (msg.redirect_host().empty() || msg.redirect_port() <= 0 || msg.redirect_port() > 65535
+            || m_impl->onRedirect.load()) {
+            qWarning() << "Ignoring REDIRECT to" << QString::fromStdString(msg.redirect_host()) << msg.redirect_port();
+            return;
+        }
+        qInfo() << "Received REDIRECT from server:" << QString::fromStdString(msg.redirect_host()) << msg.redirect_port();
+        {
+            std::lock_guard<std::mutex> lock(m_impl->connectMtx);
+            m_impl->redirect.host = QString::fromStdString(msg.redirect_host());
+            m_impl->redirect.port = static_cast<quint16>(msg.redirect_port());
+        }
+        // Not a lost connection: the reconnect loop goes to the new node right away
+        m_impl->redirectPending.store(true);
+        cleanupConnection();
+    } else if (msg.type() == imagesocket::control::RETRY_AFTER) {
+        // The server is pacing a reconnect storm: come back at the slot it gave
+        qInfo() << "Received RETRY_AFTER from server:" << msg.retry_after_ms() << "ms";
+        m_impl->retryAfterMs.store(std::max(1, msg.retry_after_ms()));
+        cleanupConnection();
+    } else if (msg.type() == imagesocket::control::SUBSCRIBE) {
+        // Reduced-rate subscription: apply its rate before frames flow again
+        if (msg.fps() > 0)
+            applyConfiguredFps(msg.stream_id(), msg.fps());
+        setPaused(msg.stream_id(), false);
+    } else if (msg.type() == imagesocket::control::SET_CODEC) {
+        const VideoCodec codec = static_cast<VideoCodec>(msg.codec());
+        qInfo() << "Received SET_CODEC from server:" << static_cast<int>(codec);
+        applyCodec(codec);
+    } else if (msg.type() == imagesocket::control::FRAME_HEADER) {
+        m_impl->frameHeaders.store(true);
+    } else if (msg.type() == imagesocket::control::REQUEST_KEYFRAME) {
+        m_impl->stream(msg.stream_id()).keyframeRequested.store(true);
+    } else if (msg.type() == imagesocket::control::PING) {
+        // Answer right away (control jumps ahead of queued frames) so the
+        // server's clock offset estimate sees as little of our queue as possible
+        ControlMessage pong;
+        pong.set_type(imagesocket::control::PONG);
+        pong.set_echo_timestamp_us(msg.timestamp_us());
+        pong.set_receive_timestamp_us(wallClockUs());
+        pong.set_timestamp_us(wallClockUs());
+        sendControlMessage(pong);
+    } else if (msg.type() == imagesocket::control::SET_QUALITY) {
+        qInfo() << "Received SET_QUALITY from server:" << msg.quality() << "stream" << msg.stream_id();
+        applyQuality(msg.stream_id(), msg.quality());
+    }
+}
+
 void WebSocketImageClient::disconnectFromServer()
 {
     std::cout << "WebSocketImageClient::disconnectFromServer called" << std::endl;
@@ -228,6 +1174,29 @@ void WebSocketImageClient::disconnectFromServer()
 }
 
 void WebSocketImageClient::cleanupConnection()
+{
+    const unsigned generation = m_impl->generation.load();
+    teardownConnection();
+
+    // After the IO thread is joined, so a handshake completing meanwhile can't
+    // undo this; an attempt started since (by the reconnect loop) keeps its own
+    std::vector<std::function<void(bool)>> waiters;
+    {
+        std::lock_guard<std::mutex> lock(m_impl->connectMtx);
+        if (m_impl->generation.load() == generation) {
+            m_impl->state.store(static_cast<int>(ConnectionState::Disconnected));
+            waiters.swap(m_impl->connectWaiters);
+        }
+    }
+    for (const auto &waiter : waiters) {
+        try { waiter(false); } catch(...) {}
+    }
+
+    // Start an automatic reconnect loop
+    startReconnectLoop();
+}
+
+void WebSocketImageClient::teardownConnection()
 {
     // Ensure mutual exclusion for cleanup
     std::lock_guard<std::mutex> lock(m_impl->mtx);
@@ -235,6 +1204,16 @@ void WebSocketImageClient::cleanupConnection()
     // Mark not running first to prevent new sends
     m_impl->running.store(false);
 
+    {
+        // Queued messages belong to the connection being torn down.
+        // In-flight write handlers keep their own reference to the buffer.
+        std::lock_guard<std::mutex> sendLock(m_impl->sendMtx);
+        m_impl->outbound.clear();
+        m_impl->shmRing.close();
+        m_impl->shmDoorbell.close();
+        m_impl->udpSocket.reset();
+    }
+
     // Close websocket if open
     try {
         if (m_impl->ws) {
@@ -272,33 +1251,13 @@ void WebSocketImageClient::cleanupConnection()
         m_impl->ws.reset();
         m_impl->ioc.reset();
     } else {
-        // Notify disconnected and start reconnect loop, but leave final resets until outside thread
+        // Notify disconnected, but leave final resets until outside thread
         if (m_onDisconnected) {
             QMetaObject::invokeMethod(this, [this]() {
                 if (m_onDisconnected) m_onDisconnected();
             }, Qt::QueuedConnection);
         }
 
-        // Start an automatic reconnect loop (single instance)
-        bool expected = false;
-        if (!m_impl->reconnecting.load() && m_impl->reconnecting.compare_exchange_strong(expected, true)) {
-            std::thread([this]() {
-                int attempt = 0;
-                while (!m_impl->running.load()) {
-                    int waitSeconds = std::min(30, 1 << std::min(attempt, 6));
-                    qInfo() << "Reconnect: attempt" << attempt << "waiting" << waitSeconds << "s";
-                    std::this_thread::sleep_for(std::chrono::seconds(waitSeconds));
-                    if (connectToServer()) {
-                        qInfo() << "Reconnect succeeded";
-                        m_impl->reconnecting.store(false);
-                        return;
-                    }
-                    attempt++;
-                }
-                m_impl->reconnecting.store(false);
-            }).detach();
-        }
-
         // Defer remainder of cleanup; another call to cleanupConnection() from non-IO thread will handle it
         return;
     }
@@ -309,91 +1268,350 @@ void WebSocketImageClient::cleanupConnection()
             if (m_onDisconnected) m_onDisconnected();
         }, Qt::QueuedConnection);
     }
+}
 
-    // Start an automatic reconnect loop (single instance)
+void WebSocketImageClient::startReconnectLoop()
+{
+    // Single instance
     bool expected = false;
-    if (!m_impl->reconnecting.load() && m_impl->reconnecting.compare_exchange_strong(expected, true)) {
-        std::thread([this]() {
-            int attempt = 0;
-            while (!m_impl->running.load()) {
-                int waitSeconds = std::min(30, 1 << std::min(attempt, 6));
-                qInfo() << "Reconnect: attempt" << attempt << "waiting" << waitSeconds << "s";
-                std::this_thread::sleep_for(std::chrono::seconds(waitSeconds));
-                if (connectToServer()) {
-                    qInfo() << "Reconnect succeeded";
-                    m_impl->reconnecting.store(false);
-                    return;
-                }
-                attempt++;
+    if (m_impl->reconnecting.load() || !m_impl->reconnecting.compare_exchange_strong(expected, true))
+        return;
+    std::thread([this]() {
+        int attempt = 0;
+        while (!m_impl->running.load()) {
+            // Jittered, so a fleet that lost its server together doesn't come
+            // back together. A standby is likely up: fail over within a
+            // quarter of the first window, back off from the second attempt.
+            const bool standbys = !standbyServers().empty();
+            const std::int64_t retryAfterMs = m_impl->retryAfterMs.exchange(0);
+            std::int64_t waitMs = 0;
+            if (m_impl->redirectPending.exchange(false))
+                waitMs = 0;
+            else if (retryAfterMs > 0)
+                waitMs = m_impl->backoff.delayMs(attempt, retryAfterMs);
+            else if (standbys)
+                waitMs = attempt == 0 ? m_impl->backoff.delayMs(0) / 4 : m_impl->backoff.delayMs(attempt - 1);
+            else
+                waitMs = m_impl->backoff.delayMs(attempt);
+            qInfo() << "Reconnect: attempt" << attempt << "waiting" << waitMs << "ms";
+            std::this_thread::sleep_for(std::chrono::milliseconds(waitMs));
+            if (connectToServer()) {
+                qInfo() << "Reconnect succeeded";
+                m_impl->reconnecting.store(false);
+                // Sent away again (RETRY_AFTER, REDIRECT) before this loop let go
+                if (!m_impl->running.load())
+                    startReconnectLoop();
+                return;
             }
-            m_impl->reconnecting.store(false);
-        }).detach();
-    }
+            attempt++;
+        }
+        m_impl->reconnecting.store(false);
+    }).detach();
 }
 
-bool WebSocketImageClient::sendFrame(const QByteArray &jpegData)
+void WebSocketImageClient::connectionLost()
 {
-    if (!m_impl->running.load() || !m_impl->ws || !m_impl->ws->is_open()) {
-        std::cerr << "sendFrame: not connected" << std::endl;
-        m_impl->running.store(false);
-        return false;}
+    // Not when the connection is being closed on purpose
+    if (m_impl->running.load())
+        m_impl->lostAtMs.store(steadyClockMs());
+    cleanupConnection();
+}
 
-    try {
-        auto payload = std::make_shared<std::vector<unsigned char>>(
-            reinterpret_cast<const unsigned char*>(jpegData.constData()),
-            reinterpret_cast<const unsigned char*>(jpegData.constData()) + jpegData.size()
-        );
-
-        m_impl->ws->binary(true);
-        // If we fail to queue a write, the write callback will call cleanupConnection()
-        m_impl->ws->async_write(asio::buffer(*payload),
-            [this, payload](beast::error_code ec, std::size_t bytes_transferred) {
-                Q_UNUSED(bytes_transferred);
-                if (ec) {
-                    qWarning() << "WebSocket async_write error:" << QString::fromStdString(ec.message());
-                    cleanupConnection();
-                }
-            }
-        );
+SendResult WebSocketImageClient::sendFrame(const QByteArray &jpegData, const FrameInfo &info)
+{
+    const SendResult result = enqueue(shareByteArray(jpegData, MessagePrefix::Image), &info);
+    if (result.connected())
+        maybeSendStats();
+    return result;
+}
 
-        return true;
-    } catch (const std::exception &ex) {
-        qWarning() << "sendFrame exception:" << ex.what();
-        return false;
+SendResult WebSocketImageClient::sendFrame(std::vector<std::uint8_t> &&jpegData, const FrameInfo &info)
+{
+    const SendResult result = enqueue(OutboundMessage::fromVector(std::move(jpegData), MessagePrefix::Image), &info);
+    if (result.connected())
+        maybeSendStats();
+    return result;
+}
+
+SendResult WebSocketImageClient::sendFrame(SharedFrameBuffer jpegData, const FrameInfo &info)
+{
+    const SendResult result = enqueue(OutboundMessage::fromShared(std::move(jpegData), MessagePrefix::Image), &info);
+    if (result.connected())
+        maybeSendStats();
+    return result;
+}
+
+SendResult WebSocketImageClient::sendRawFrame(std::vector<std::uint8_t> &&rawFrame, const FrameInfo &info)
+{
+    const SendResult result = enqueue(OutboundMessage::fromVector(std::move(rawFrame), MessagePrefix::RawFrame), &info);
+    if (result.connected())
+        maybeSendStats();
+    return result;
+}
+
+SendResult WebSocketImageClient::sendRawFrame(SharedFrameBuffer rawFrame, const FrameInfo &info)
+{
+    const SendResult result = enqueue(OutboundMessage::fromShared(std::move(rawFrame), MessagePrefix::RawFrame), &info);
+    if (result.connected())
+        maybeSendStats();
+    return result;
+}
+
+SendResult WebSocketImageClient::sendVideoPacket(std::vector<std::uint8_t> &&packet, const FrameInfo &info)
+{
+    return sendVideoPacket(std::make_shared<const std::vector<std::uint8_t>>(std::move(packet)), info);
+}
+
+SendResult WebSocketImageClient::sendVideoPacket(SharedFrameBuffer packet, const FrameInfo &info)
+{
+    const SendResult result = enqueue(OutboundMessage::fromShared(std::move(packet), MessagePrefix::Video), &info);
+    if (result.connected()) {
+        // Later packets reference the lost one: the decoder can only resync on a keyframe
+        if (result.status == SendStatus::Dropped || result.evicted > 0)
+            m_impl->stream(info.streamId).keyframeRequested.store(true);
+        maybeSendStats();
     }
+    return result;
+}
+
+SendResult WebSocketImageClient::sendUnchanged(const FrameInfo &info)
+{
+    SendResult state = sendQueueState(info.streamId);
+    if (state.status != SendStatus::Queued)
+        return state;
+    ControlMessage unchanged;
+    unchanged.set_type(imagesocket::control::UNCHANGED);
+    unchanged.set_stream_id(info.streamId);
+    unchanged.set_timestamp_ms(info.captureTimeUs > 0 ? info.captureTimeUs / 1000 : wallClockMs());
+    if (!sendControlMessage(unchanged))
+        state.status = SendStatus::NotConnected;
+    else
+        maybeSendStats();
+    return state;
 }
 
 bool WebSocketImageClient::sendControlMessage(const QByteArray &serialized)
 {
-    if (!m_impl->running.load() || !m_impl->ws || !m_impl->ws->is_open()) {
+    return enqueue(shareByteArray(serialized, MessagePrefix::Control)).accepted();
+}
+
+bool WebSocketImageClient::sendControlMessage(std::string &&serialized)
+{
+    auto owner = std::make_shared<const std::string>(std::move(serialized));
+    return enqueue(OutboundMessage::fromOwner(owner, owner->data(), owner->size(),
+                                              MessagePrefix::Control)).accepted();
+}
+
+bool WebSocketImageClient::sendControlMessage(const ControlMessage &msg)
+{
+    // Serialized straight into the queued buffer: a short message (PONG,
+    // UNCHANGED, STATS) fits the string object itself, so this is the only
+    // allocation on the way to the socket
+    auto owner = std::make_shared<std::string>(msg.ByteSizeLong(), '\0');
+    msg.SerializeWithCachedSizesToArray(reinterpret_cast<std::uint8_t *>(&(*owner)[0]));
+    return enqueue(OutboundMessage::fromOwner(owner, owner->data(), owner->size(),
+                                              MessagePrefix::Control)).accepted();
+}
+
+void WebSocketImageClient::maybeSendStats()
+{
+    // Rate-limited from the frame path; the report jumps ahead of queued frames,
+    // so its timestamp measures the network path rather than our own backlog
+    const std::int64_t now = wallClockMs();
+    std::int64_t last = m_impl->lastStatsMs.load();
+    if (now - last < kStatsIntervalMs || !m_impl->lastStatsMs.compare_exchange_strong(last, now))
+        return;
+
+    ControlMessage stats;
+    stats.set_type(imagesocket::control::STATS);
+    stats.set_timestamp_ms(now);
+    {
+        std::lock_guard<std::mutex> lock(m_impl->sendMtx);
+        stats.set_queued_frames(static_cast<std::int32_t>(m_impl->outbound.frameCount()));
+        stats.set_dropped_frames(static_cast<std::int32_t>(m_impl->outbound.droppedTotal() + m_impl->shmDropped
+                                                           + m_impl->udpDropped));
+    }
+    sendControlMessage(stats);
+}
+
+SendResult WebSocketImageClient::sendQueueState(std::uint16_t streamId) const
+{
+    SendResult state;
+    if (m_impl->state.load() == static_cast<int>(ConnectionState::Connected) && m_impl->running.load())
+        state.status = m_impl->stream(streamId).paused.load() || holdingForConfig() ? SendStatus::Paused : SendStatus::Queued;
+
+    std::lock_guard<std::mutex> lock(m_impl->sendMtx);
+    state.queuedFrames = m_impl->outbound.frameCount();
+    state.depth = m_impl->outbound.depth();
+    return state;
+}
+
+void WebSocketImageClient::setSendQueueDepth(std::size_t depth)
+{
+    std::lock_guard<std::mutex> lock(m_impl->sendMtx);
+    m_impl->outbound.setDepth(depth);
+}
+
+std::size_t WebSocketImageClient::sendQueueDepth() const
+{
+    std::lock_guard<std::mutex> lock(m_impl->sendMtx);
+    return m_impl->outbound.depth();
+}
+
+void WebSocketImageClient::setSendDropPolicy(OutboundDropPolicy policy)
+{
+    std::lock_guard<std::mutex> lock(m_impl->sendMtx);
+    m_impl->outbound.setPolicy(policy);
+}
+
+OutboundDropPolicy WebSocketImageClient::sendDropPolicy() const
+{
+    std::lock_guard<std::mutex> lock(m_impl->sendMtx);
+    return m_impl->outbound.policy();
+}
+
+std::uint32_t WebSocketImageClient::stampFrameHeader(OutboundMessage &message, const FrameInfo &info)
+{
+    FrameHeader header;
+    header.sequence = m_impl->nextSequence.fetch_add(1);
+    const std::int64_t now = wallClockUs();
+    header.captureTimeUs = info.captureTimeUs > 0 ? info.captureTimeUs : now;
+    header.sendDelayUs = now - header.captureTimeUs;
+    header.width = info.width;
+    header.height = info.height;
+    header.streamId = info.streamId;
+
+    // Size and keyframe flag come from the payload's own header when the caller left them out
+    if (message.prefix == MessagePrefix::RawFrame) {
+        header.payload = FramePayload::RawYuv;
+        RawFrameHeader raw;
+        if (header.width <= 0 && parseRawFrameHeader(message.data, message.size, raw)) {
+            header.width = raw.width;
+            header.height = raw.height;
+        }
+    } else if (message.prefix == MessagePrefix::Video) {
+        header.payload = FramePayload::Video;
+        VideoPacketHeader packet;
+        header.keyframe = parseVideoPacketHeader(message.data, message.size, packet) && packet.keyframe;
+    } else {
+        header.payload = FramePayload::Jpeg;
+        JpegHeaderInfo jpeg;
+        if (header.width <= 0 && parseJpegHeader(message.data, message.size, jpeg)) {
+            header.width = jpeg.width;
+            header.height = jpeg.height;
+        }
+    }
+    message.setFrameHeader(header);
+    return header.sequence;
+}
+
+SendResult WebSocketImageClient::enqueue(OutboundMessage message, const FrameInfo *info)
+{
+    const bool control = message.prefix == MessagePrefix::Control;
+    FrameTraceScope trace(control ? "queue control" : "queue", "client");
+    SendResult result;
+    // Frames offered while (re)connecting are dropped quietly, the capture loop keeps going
+    if (m_impl->state.load() != static_cast<int>(ConnectionState::Connected))
+        return result;
+    auto ws = m_impl->ws;
+    if (!m_impl->running.load() || !ws || !ws->is_open()) {
+        if (!control)
+            std::cerr << "sendFrame: not connected" << std::endl;
         m_impl->running.store(false);
-        return false;
+        return result;
+    }
+    if (!control && (m_impl->stream(info ? info->streamId : 0).paused.load() || holdingForConfig())) {
+        std::lock_guard<std::mutex> lock(m_impl->sendMtx);
+        result.status = SendStatus::Paused;
+        result.queuedFrames = m_impl->outbound.frameCount();
+        result.depth = m_impl->outbound.depth();
+        return result;
     }
 
-    try {
-        // Prepend control prefix 0x01
-        QByteArray withPrefix;
-        withPrefix.append(char(0x01));
-        withPrefix.append(serialized);
-
-        auto payload = std::make_shared<std::vector<unsigned char>>(
-            reinterpret_cast<const unsigned char*>(withPrefix.constData()),
-            reinterpret_cast<const unsigned char*>(withPrefix.constData()) + withPrefix.size()
-        );
-
-        m_impl->ws->binary(true);
-        m_impl->ws->async_write(asio::buffer(*payload),
-            [this, payload](beast::error_code ec, std::size_t bytes_transferred) {
-                Q_UNUSED(bytes_transferred);
-                if (ec) {
-                    qWarning() << "WebSocket control async_write error:" << QString::fromStdString(ec.message());
-                    cleanupConnection();
-                }
-            }
-        );
-        return true;
-    } catch (const std::exception &ex) {
-        qWarning() << "sendControlMessage exception:" << ex.what();
-        return false;
+    // Numbered after the pause check: a gap on the server means the frame was dropped, not skipped
+    if (!control && m_impl->frameHeaders.load())
+        trace.setFrame(stampFrameHeader(message, info ? *info : FrameInfo()));
+
+    bool startWrite = false;
+    {
+        std::lock_guard<std::mutex> lock(m_impl->sendMtx);
+        bool accepted = true;
+        bool queued = true;
+        if (control) {
+            m_impl->outbound.pushControl(std::move(message));
+        } else if (m_impl->sharedMemoryTakes(message)) {
+            // Same host: straight into the server's ring, no socket on the way
+            accepted = m_impl->writeShared(message);
+            queued = false;
+        } else if (m_impl->udpTakes()) {
+            // Lossy link: no stream order for a lost packet to hold up
+            accepted = m_impl->writeUdp(message);
+            queued = false;
+        } else {
+            accepted = m_impl->outbound.pushFrame(std::move(message), &result.evicted);
+        }
+
+        result.status = accepted ? SendStatus::Queued : SendStatus::Dropped;
+        result.queuedFrames = m_impl->outbound.frameCount() + m_impl->shmRing.pending();
+        result.depth = m_impl->outbound.depth();
+        startWrite = accepted && queued && !m_impl->outbound.writing();
     }
+
+    // Only the strand may initiate writes; doWrite() is a no-op if one is already running
+    if (startWrite)
+        asio::post(ws->get_executor(), [this]() { doWrite(); });
+
+    return result;
+}
+
+void WebSocketImageClient::doWrite()
+{
+    auto ws = m_impl->ws;
+    if (!m_impl->running.load() || !ws)
+        return;
+
+    OutboundMessage &message = m_impl->inFlight;
+    {
+        std::lock_guard<std::mutex> lock(m_impl->sendMtx);
+        if (m_impl->outbound.writing() || m_impl->outbound.empty())
+            return;
+        // Control that piled up while the last write was out (a PONG, STATS,
+        // UNCHANGED heartbeats) leaves as one message when the server takes batches
+        const std::size_t batched = m_impl->controlBatch.load()
+            ? m_impl->outbound.leadingControl(kMaxControlBatch) : 0;
+        if (batched > 1) {
+            message = controlBatchOf(m_impl->outbound, batched);
+            m_impl->outbound.beginWrite(batched);
+        } else {
+            message = m_impl->outbound.front();
+            m_impl->outbound.beginWrite();
+        }
+    }
+
+    ws->binary(true);
+    // Prefix, frame header and payload go out as one message from separate buffers (no prefixed copy).
+    // The handler holds the payload owner: it must outlive the write even if the queue is cleared.
+    auto owner = message.owner;
+    const std::int64_t traceStartUs = FrameTrace::isEnabled() ? FrameTrace::nowUs() : -1;
+    const std::int64_t traceId = traceStartUs >= 0 ? traceFrame(message) : FrameTrace::kNoFrame;
+    ws->async_write(wireBuffers(message),
+        [this, owner, traceStartUs, traceId](beast::error_code ec, std::size_t bytes_transferred) {
+            Q_UNUSED(bytes_transferred);
+            if (traceStartUs >= 0)
+                FrameTrace::complete("write", "client", traceStartUs, FrameTrace::nowUs() - traceStartUs, traceId);
+            {
+                std::lock_guard<std::mutex> lock(m_impl->sendMtx);
+                m_impl->outbound.finishWrite();
+            }
+            m_impl->inFlight = OutboundMessage(); // hand the payload back to its pool now
+
+            if (ec) {
+                qWarning() << "WebSocket async_write error:" << QString::fromStdString(ec.message());
+                connectionLost();
+                return;
+            }
+
+            doWrite();
+        }
+    );
 }
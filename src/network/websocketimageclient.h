@@ -4,6 +4,43 @@
 #include <QObject>
 #include <QString>
 #include <functional>
+#include <string>
+#include <vector>
+#include "outboundmessage.h"
+#include "outboundqueue.h"
+#include "framesize.h"
+#include "keepalive.h"
+#include "videopacket.h"
+
+// Optional per-frame metadata, sent in the FrameHeader once the server asks
+// for one (FRAME_HEADER); zero fields are filled in by the client
+namespace imagesocket { namespace control { class ControlMessage; } }
+
+struct FrameInfo {
+    std::int64_t captureTimeUs = 0; // 0 == time of the send call (wall clock)
+    int width = 0;                  // 0 == read from the JPEG or raw frame header
+    int height = 0;
+    std::uint16_t streamId = 0;
+};
+
+// Limits of one connection attempt (ms)
+struct ConnectTimeouts {
+    int resolveMs = 2000;
+    int connectMs = 3000;     // TCP, all addresses together
+    int handshakeMs = 5000;   // WebSocket upgrade
+    int attemptDelayMs = 250; // head start of one address before the next is tried too
+};
+
+struct ServerEndpoint {
+    QString host;
+    quint16 port = 0;
+};
+
+enum class ConnectionState {
+    Disconnected,
+    Connecting,
+    Connected
+};
 
 class WebSocketImageClient : public QObject
 {
@@ -12,42 +49,258 @@ public:
     explicit WebSocketImageClient(const QString &host = QStringLiteral("127.0.0.1"), quint16 port = 5000, QObject* parent = nullptr);
     ~WebSocketImageClient() override;
 
-    // Connect synchronously (returns true if connected)
+    // Resolve, connect and handshake on the IO thread; returns at once. `done`
+    // learns whether the connection came up (IO thread); a call during an
+    // attempt joins it. A host with several addresses is raced happy-eyeballs
+    // style: families alternate, the next address starts attemptDelayMs after
+    // the previous one or as soon as it fails, and the first to connect wins.
+    // A lost connection is re-established the same way in the background
+    // (a random wait up to 1 s..30 s, or the server's RETRY_AFTER); frames
+    // sent meanwhile return SendStatus::NotConnected.
+    void connectAsync(std::function<void(bool)> done = nullptr);
+    // Blocking connectAsync() (returns true if connected)
     bool connectToServer();
     void disconnectFromServer();
+    ConnectionState connectionState() const;
+
+    // Used from the next attempt on
+    void setConnectTimeouts(const ConnectTimeouts &timeouts);
+    ConnectTimeouts connectTimeouts() const;
+    // Dead-server detection on an open connection: WebSocket pings when it
+    // goes quiet, and a server silent for keepaliveTimeoutMs() counts as lost
+    // (reconnect, failover). Used from the next connection on.
+    void setKeepalive(const KeepaliveConfig &keepalive);
+    KeepaliveConfig keepalive() const;
 
-    // Send a JPEG-encoded frame binary. Returns true on success (queued or sent).
-    bool sendFrame(const QByteArray &jpegData);
+    // Queue a JPEG-encoded frame for sending. Writes are serialized on the IO strand;
+    // the result reports whether the frame was accepted and how full the queue is.
+    // None of the overloads copy the payload: the QByteArray is shared (implicit sharing),
+    // the vector is moved in, and a SharedFrameBuffer is held until its write completes.
+    // `info` describes the frame in its FrameHeader (ignored when the server didn't ask for one).
+    SendResult sendFrame(const QByteArray &jpegData, const FrameInfo &info = FrameInfo());
+    SendResult sendFrame(std::vector<std::uint8_t> &&jpegData, const FrameInfo &info = FrameInfo());
+    SendResult sendFrame(SharedFrameBuffer jpegData, const FrameInfo &info = FrameInfo());
 
-    // Send a serialized Protobuf control message
+    // Queue a raw YUV frame: a header and planes laid out by prepareRawFrame()
+    // (rawframe.h). Same queueing and ownership rules as sendFrame().
+    SendResult sendRawFrame(std::vector<std::uint8_t> &&rawFrame, const FrameInfo &info = FrameInfo());
+    SendResult sendRawFrame(SharedFrameBuffer rawFrame, const FrameInfo &info = FrameInfo());
+
+    // Queue a video packet built by prepareVideoPacket() (VideoEncoder or
+    // TiledJpegEncoder output). If the queue drops or evicts one, the next picture must be a
+    // keyframe: takeKeyframeRequest() reports it like a server request.
+    SendResult sendVideoPacket(std::vector<std::uint8_t> &&packet, const FrameInfo &info = FrameInfo());
+    SendResult sendVideoPacket(SharedFrameBuffer packet, const FrameInfo &info = FrameInfo());
+
+    // Heartbeat in place of a frame of a static scene (ChangeDetector): the
+    // server keeps the stream live without a payload to decode. `info` gives
+    // the stream and capture time. Paused streams send nothing, as with frames.
+    SendResult sendUnchanged(const FrameInfo &info = FrameInfo());
+
+    // Send a serialized Protobuf control message (never dropped, queued ahead of frames)
     bool sendControlMessage(const QByteArray &serialized);
+    bool sendControlMessage(std::string &&serialized);
+    // Or the message itself, serialized once into the queued buffer
+    bool sendControlMessage(const imagesocket::control::ControlMessage &msg);
+
+    // Current outbound queue state; saturated() means the next frame would be dropped or evict one
+    SendResult sendQueueState(std::uint16_t streamId = 0) const;
+
+    // Same-host transport: when the server runs on this host, frames go through
+    // a shared-memory ring (shmframering.h) instead of the socket, offered in
+    // HELLO on every connection and used once the server mapped it. Frames
+    // larger than a ring slot, and control, stay on the WebSocket. On by default.
+    void setSharedMemoryTransport(bool enabled) { m_sharedMemory = enabled; }
+    bool isSharedMemoryActive() const;
+
+    // Lossy-link transport (Wi-Fi): offered in HELLO, and once the server
+    // opens a channel (UDP_CHANNEL) frames go out as UDP datagrams with
+    // `fecRatio` parity per data shard (udpframing.h), so a lost packet costs
+    // at most its frame instead of stalling the ones behind it. A frame the
+    // socket can't take right away is dropped. Control, and frames to a
+    // server that doesn't open a channel, stay on the WebSocket. Off by default.
+    void setUdpTransport(bool enabled, double fecRatio = 0.2)
+    {
+        m_udpTransport = enabled;
+        m_udpFecRatio = fecRatio;
+    }
+    bool isUdpActive() const;
+
+    // Connect with TLS (wss://, a server started with a certificate). The
+    // server's certificate is checked against `caFile` (PEM; empty: the
+    // system's trust store) and the host name or address connected to, unless
+    // `verifyPeer` is off. Reconnects resume the TLS session (no full
+    // handshake), and records are encrypted by the kernel where it supports
+    // it (kTLS). Next connection; false if the CA file doesn't load.
+    bool setTls(bool enabled, const QString &caFile = QString(), bool verifyPeer = true);
+    bool tlsEnabled() const;
+
+    // Outbound queue configuration (frames, including the one being written)
+    void setSendQueueDepth(std::size_t depth);
+    std::size_t sendQueueDepth() const;
+    void setSendDropPolicy(OutboundDropPolicy policy);
+    OutboundDropPolicy sendDropPolicy() const;
 
     // Setters for endpoint
     void setHost(const QString &host) { m_host = host; }
     void setPort(quint16 port) { m_port = port; }
 
-    // Optional callbacks
+    // Servers to fail over to, in order; host/port above stays the primary.
+    // Every connect races them all, the primary first (see connectAsync()):
+    // a standby is tried at once when the primary refuses and after its head
+    // start when it doesn't answer. With standbys the first reconnect after a
+    // lost connection waits at most a quarter second.
+    void setStandbyServers(const std::vector<ServerEndpoint> &servers);
+    std::vector<ServerEndpoint> standbyServers() const;
+
+    // Server of the current (or last) connection: 0 == primary, i == standby i - 1
+    int currentServer() const;
+
+    // Cluster node a REDIRECT (answer to HELLO) sent this client to, port 0
+    // when none. Connects try it ahead of the primary, which it counts as,
+    // until a connection goes elsewhere; HELLO on it refuses further redirects.
+    ServerEndpoint redirectedServer() const;
+
+    // Time from the last lost connection to the next one being up (ms, -1 == none yet)
+    std::int64_t lastFailoverMs() const;
+
+    // Optional callback after such a reconnect: server index and failover time (IO thread)
+    void setOnFailover(std::function<void(int, std::int64_t)> cb) { m_onFailover = std::move(cb); }
+
+    // Optional callbacks (connected: IO thread, after HELLO is queued)
     void setOnConnected(std::function<void()> cb) { m_onConnected = std::move(cb); }
     void setOnDisconnected(std::function<void()> cb) { m_onDisconnected = std::move(cb); }
 
+    // Server commands carry the stream they apply to (ControlMessage.stream_id):
+    // the getters below take a FrameInfo::streamId, the callbacks only report
+    // the main stream (0). Other streams are polled through the getters.
+
     // Get the last configured FPS sent by the server (0 == unset)
-    int configuredFps() const;
+    int configuredFps(std::uint16_t streamId = 0) const;
 
     // Optional callback when configured FPS changes (may be called from IO thread)
     void setOnFpsChanged(std::function<void(int)> cb) { m_onFpsChanged = std::move(cb); }
 
+    // Get the last JPEG quality sent by the server's rate controller (0 == unset)
+    int configuredQuality(std::uint16_t streamId = 0) const;
+
+    // Optional callback when the configured quality changes (may be called from IO thread)
+    void setOnQualityChanged(std::function<void(int)> cb) { m_onQualityChanged = std::move(cb); }
+
+    // Frame size bound from server SET_RESOLUTION (0 == full resolution); frames
+    // should be scaled to fit (see fitFrameSize()) before encoding
+    int maxFrameWidth(std::uint16_t streamId = 0) const;
+    int maxFrameHeight(std::uint16_t streamId = 0) const;
+
+    // Region of interest from server SET_ROI (isFull() == the whole frame);
+    // frames should be cropped to it (see cropRect()) before they are scaled
+    FrameRegion regionOfInterest(std::uint16_t streamId = 0) const;
+
+    // Optional callback when the frame size bound changes (may be called from IO thread)
+    void setOnResolutionChanged(std::function<void(int, int)> cb) { m_onResolutionChanged = std::move(cb); }
+
+    // True while the server has paused this client (PAUSE / UNSUBSCRIBE); frames
+    // are rejected with SendStatus::Paused, so callers can stop capture and encode
+    bool isPaused(std::uint16_t streamId = 0) const;
+
+    // Optional callback when the pause state changes (may be called from IO thread)
+    void setOnPausedChanged(std::function<void(bool)> cb) { m_onPausedChanged = std::move(cb); }
+
+    // Codecs besides MJPEG this client can encode, announced (CODECS) on every
+    // connection; the server answers with SET_CODEC. Empty == MJPEG only.
+    void setSupportedCodecs(const std::vector<VideoCodec>& codecs) { m_supportedCodecs = codecs; }
+
+    // Announced in HELLO on every connection (0 == not limited): the server
+    // never asks for more than maxFps, and learns the capture size and how
+    // many streams (FrameInfo::streamId) this client sends
+    void setCaptureLimits(int maxFps, int maxWidth, int maxHeight)
+    {
+        m_maxCaptureFps = maxFps;
+        m_maxCaptureWidth = maxWidth;
+        m_maxCaptureHeight = maxHeight;
+    }
+    void setStreamCount(int streams) { m_streamCount = streams; }
+    // Simulcast (announced in HELLO, 0 == off): streams 0..layers-1 are the
+    // same capture at 1/2^stream of the size. The server shows and relays the
+    // layer each consumer needs and pauses the ones nobody takes (PAUSE /
+    // RESUME with their stream id); stream 0 is only paused with the client.
+    void setSimulcastLayers(int layers) { m_simulcastLayers = layers; }
+
+    // True once the server answered HELLO with CONFIG on this connection. Until
+    // then (at most a second, or until an older server shows itself by asking
+    // for the alias) frames are rejected with SendStatus::Paused, so the first
+    // one sent already has the server's fps, quality, codec and size.
+    bool isConfigured() const;
+
+    // Codec the server negotiated for this connection (Mjpeg until SET_CODEC)
+    VideoCodec negotiatedCodec() const;
+
+    // Optional callback when the negotiated codec changes (may be called from IO thread)
+    void setOnCodecChanged(std::function<void(VideoCodec)> cb) { m_onCodecChanged = std::move(cb); }
+
+    // True once after the server asked for a keyframe (REQUEST_KEYFRAME) or a
+    // video packet was dropped locally; the next encoded picture should be one
+    bool takeKeyframeRequest(std::uint16_t streamId = 0);
+
     // Alias (optional): used to present a human-friendly name in the server UI
     void setAlias(const QString& alias);
     QString alias() const;
 
+    // Session token sent in HELLO: after a reconnect the server hands this
+    // client its previous session back (configured fps, active status, row in
+    // the UI). Issued by the server in CONFIG and kept across connections;
+    // set one up front to use a stable id that also survives restarts.
+    void setSessionToken(const QString& token);
+    QString sessionToken() const;
+
 private:
     void doAsyncRead();
+    // One server command, alone or out of a ControlBatch (IO strand)
+    void handleControl(const imagesocket::control::ControlMessage &msg);
+    void doWrite();
+    SendResult enqueue(OutboundMessage message, const FrameInfo *info = nullptr);
+    // Returns the frame's sequence number
+    std::uint32_t stampFrameHeader(OutboundMessage &message, const FrameInfo &info);
+    void maybeSendStats();
+    void setPaused(std::uint32_t streamId, bool paused);
+    void applyConfiguredFps(std::uint32_t streamId, int fps);
+    void applyQuality(std::uint32_t streamId, int quality);
+    void sendSupportedCodecs();
+    void sendHello();
+    // Creates this connection's ring when the server is local; its name for HELLO, or empty
+    std::string offerSharedMemory();
+    // UDP_CHANNEL: frames go to `port` on the server's address from now on
+    void openUdpChannel(int port, std::uint32_t key);
+    // Frames wait for CONFIG after HELLO, up to its deadline
+    bool holdingForConfig() const;
+    // End of a connection attempt: streaming starts, or the attempt is torn down
+    void finishConnect(bool connected);
+    void notifyConnectWaiters(bool connected);
+    // Read or write failed: the failover clock starts
+    void connectionLost();
+    void startReconnectLoop();
+    void applyConfig(const imagesocket::control::ControlMessage &config);
+    void applyResolution(std::uint32_t streamId, int maxWidth, int maxHeight);
+    void applyRegion(std::uint32_t streamId, const FrameRegion &region);
+    void applyCodec(VideoCodec codec);
+    // Tears down, wakes connect waiters and starts the reconnect loop;
+    // teardownConnection() only tears down
     void cleanupConnection();
+    void teardownConnection();
 
 private:
     QString m_host;
     quint16 m_port;
     QString m_alias;
+    std::vector<VideoCodec> m_supportedCodecs;
+    int m_maxCaptureFps = 0;
+    int m_maxCaptureWidth = 0;
+    int m_maxCaptureHeight = 0;
+    int m_streamCount = 1;
+    int m_simulcastLayers = 0;
+    bool m_sharedMemory = true;
+    bool m_udpTransport = false;
+    double m_udpFecRatio = 0.2;
 
     // Pimpl to hide Boost.Beast implementation details
     struct Impl;
@@ -56,6 +309,11 @@ private:
     std::function<void()> m_onConnected;
     std::function<void()> m_onDisconnected;
     std::function<void(int)> m_onFpsChanged;
+    std::function<void(int)> m_onQualityChanged;
+    std::function<void(bool)> m_onPausedChanged;
+    std::function<void(int, int)> m_onResolutionChanged;
+    std::function<void(VideoCodec)> m_onCodecChanged;
+    std::function<void(int, std::int64_t)> m_onFailover;
 };
 
 #endif // WEBSOCKETIMAGECLIENT_H
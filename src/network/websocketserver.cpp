@@ -1,41 +1,254 @@
 #include "websocketserver.h"
 #include "clientsession.h"
+#include "beastserver.h"
+#include "framedecoder.h"
+#include "shmframering.h"
+#include "threadroles.h"
+#include "tlsstream.h"
+#include "videopacket.h"
 #include "control.pb.h"
 #include <QWebSocketServer>
 #include <QWebSocket>
+#include <QFile>
+#ifndef QT_NO_SSL
+#include <QSslCertificate>
+#include <QSslConfiguration>
+#include <QSslKey>
+#endif
+#include <QNetworkInterface>
 #include <QUuid>
 #include <QDebug>
 #include <QTimer>
+#include <QThread>
+#include <QDateTime>
+#include <QStringList>
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+#ifdef Q_OS_UNIX
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace {
+// How long a new client may take to send HELLO before it is greeted the legacy
+// way; HELLO clients send it right after the upgrade
+const int kHelloWaitMs = 250;
+
+// Paced-away connections are logged once per this many
+const quint64 kPacedLogEvery = 100;
+
+qint64 monotonicMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+QByteArray retryAfterMessage(qint64 waitMs)
+{
+    imagesocket::control::ControlMessage msg;
+    msg.set_type(imagesocket::control::RETRY_AFTER);
+    msg.set_retry_after_ms(static_cast<qint32>(std::min<qint64>(waitMs, std::numeric_limits<qint32>::max())));
+    return serializeControlMessage(msg);
+}
+
+// Simulcast layer bitrates are measured (and the layers picked again) this often
+const int kSimulcastIntervalMs = 1000;
+
+// Sessions are mostly waiting on the network: a few threads carry many
+// clients, and the decoder pool keeps the remaining cores
+int defaultIoThreadCount()
+{
+    return std::max(1, std::min(4, QThread::idealThreadCount() / 2));
+}
+
+// QTcpServer can't set SO_REUSEPORT: open the listening socket here and hand
+// it over. Returns -1 (and the reason) on failure.
+qintptr openReusePortListener(quint16 port, QString& error)
+{
+#if defined(Q_OS_UNIX) && defined(SO_REUSEPORT)
+    const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        error = QString::fromLocal8Bit(std::strerror(errno));
+        return -1;
+    }
+    const int on = 1;
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) < 0
+        || ::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) < 0
+        || ::bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0
+        || ::listen(fd, SOMAXCONN) < 0) {
+        error = QString::fromLocal8Bit(std::strerror(errno));
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+#else
+    Q_UNUSED(port);
+    error = QStringLiteral("SO_REUSEPORT is not supported on this platform");
+    return -1;
+#endif
+}
+// This host's own address (IPv4-mapped IPv6 included)
+bool isLocalAddress(const QHostAddress& address)
+{
+    if (address.isLoopback())
+        return true;
+    const QList<QHostAddress> own = QNetworkInterface::allAddresses();
+    return std::any_of(own.begin(), own.end(), [&address](const QHostAddress& candidate) {
+        return candidate.isEqual(address, QHostAddress::TolerantConversion);
+    });
+}
+} // namespace
 
 WebSocketServer::WebSocketServer(QObject* parent)
-    : QObject(parent)
+    : QObject(parent), m_ioThreadCount(defaultIoThreadCount())
 {
+    qRegisterMetaType<EncodedFrame>("EncodedFrame");
+    qRegisterMetaType<FrameTiming>("FrameTiming");
+    qRegisterMetaType<ControlMessagePtr>("ControlMessagePtr");
+
+    m_decoder = new FrameDecoder(this);
+    connect(m_decoder, &FrameDecoder::frameTimed, this, &WebSocketServer::frameTimed);
+    connect(m_decoder, &FrameDecoder::frameDecoded, this, &WebSocketServer::frameReceived);
+    connect(m_decoder, &FrameDecoder::framesDropped, this, &WebSocketServer::framesDropped);
+    connect(m_decoder, &FrameDecoder::keyframeNeeded, this, &WebSocketServer::keyframeNeeded);
+
+    m_memory = std::make_shared<MemoryBudget>();
+
+    m_ingressTimer = new QTimer(this);
+    connect(m_ingressTimer, &QTimer::timeout, this, &WebSocketServer::evaluateIngress);
+
+    m_simulcastTimer = new QTimer(this);
+    m_simulcastTimer->setInterval(kSimulcastIntervalMs);
+    connect(m_simulcastTimer, &QTimer::timeout, this, &WebSocketServer::evaluateSimulcast);
 }
 
 WebSocketServer::~WebSocketServer()
 {
     stop();
+
+    // Session objects are destroyed on their own threads, when those finish
+    for (ClientSession* session : qAsConst(m_sessions)) {
+        disconnect(session, nullptr, this, nullptr);
+        session->deleteLater();
+    }
+    m_sessions.clear();
+    for (QThread* thread : qAsConst(m_ioThreads)) {
+        thread->quit();
+        thread->wait();
+        delete thread;
+    }
+}
+
+int WebSocketServer::ioThreadCount() const
+{
+    return m_ioThreadCount;
+}
+
+void WebSocketServer::setIoThreadCount(int count)
+{
+    m_ioThreadCount = std::max(0, count);
+}
+
+int WebSocketServer::pickIoThread()
+{
+    if (m_ioThreads.size() < m_ioThreadCount) {
+        QThread* thread = new QThread();
+        thread->setObjectName(QStringLiteral("ws-io-%1").arg(m_ioThreads.size()));
+        // Emitted on the new thread
+        connect(thread, &QThread::started, thread, []() { ThreadRoles::apply(ThreadRole::Io); }, Qt::DirectConnection);
+        thread->start();
+        m_ioThreads.append(thread);
+        m_ioThreadLoad.append(0);
+        return m_ioThreads.size() - 1; // a new thread is the least loaded
+    }
+    if (m_ioThreads.isEmpty())
+        return -1;
+    return static_cast<int>(std::min_element(m_ioThreadLoad.begin(), m_ioThreadLoad.end()) - m_ioThreadLoad.begin());
 }
 
 bool WebSocketServer::start(quint16 port)
 {
-    if (m_server)
+    if (m_server || m_beast)
         return false; // already started
     
     quint16 actualPort = port;
     qDebug() << "Starting WebSocketServer on port" << actualPort;
 
-    m_server = new QWebSocketServer(QStringLiteral("ImageSocketServer"), QWebSocketServer::NonSecureMode, this);
+    if (m_backend == Backend::Beast) {
+        m_beast = new BeastServer(this);
+        // Emitted on the Beast I/O threads
+        connect(m_beast, &BeastServer::sessionOpened, this, &WebSocketServer::onBeastSessionOpened, Qt::QueuedConnection);
+        connect(m_beast, &BeastServer::sessionClosed, this, &WebSocketServer::onSessionDisconnected, Qt::QueuedConnection);
+        connect(m_beast, &BeastServer::controlMessageReceived, this, &WebSocketServer::onControlMessageReceived,
+                Qt::QueuedConnection);
+        connect(m_beast, &BeastServer::encodedFrameReceived, this, &WebSocketServer::onEncodedFrameReceived,
+                Qt::QueuedConnection);
+        connect(m_beast, &BeastServer::sessionRejected, this, &WebSocketServer::onConnectionRejected,
+                Qt::QueuedConnection);
+        connect(m_beast, &BeastServer::frameRefused, this, &WebSocketServer::onFrameRefused, Qt::QueuedConnection);
+        m_beast->setMemoryBudget(m_memory);
+        m_beast->setMaxSessions(m_limits.maxSessions);
+        m_beast->setMaxMessageBytes(static_cast<std::size_t>(qMax<qint64>(0, m_limits.maxMessageBytes)));
+        m_beast->setKeepalive(m_keepalive);
+        if (tlsEnabled()) {
+            std::string error;
+            const std::shared_ptr<TlsContext> tls
+                = TlsContext::server(m_tlsCert.toStdString(), m_tlsKey.toStdString(), &error);
+            if (!tls) {
+                reportStartFailure(port, QString::fromStdString(error));
+                delete m_beast;
+                m_beast = nullptr;
+                return false;
+            }
+            m_beast->setTls(tls);
+        }
+        if (!m_beast->start(port, std::max(1, m_ioThreadCount), m_reusePort)) {
+            reportStartFailure(port, m_beast->errorString());
+            delete m_beast;
+            m_beast = nullptr;
+            return false;
+        }
+        return true;
+    }
 
-    if (!m_server->listen(QHostAddress::Any, port)) {
+    QString tlsError;
+    m_server = new QWebSocketServer(QStringLiteral("ImageSocketServer"),
+                                    tlsEnabled() ? QWebSocketServer::SecureMode : QWebSocketServer::NonSecureMode, this);
+    if (tlsEnabled() && !configureQtTls(tlsError)) {
+        reportStartFailure(port, tlsError);
+        delete m_server;
+        m_server = nullptr;
+        return false;
+    }
+
+    if (m_reusePort) {
+        QString error;
+        const qintptr fd = openReusePortListener(port, error);
+        if (fd < 0 || !m_server->setSocketDescriptor(fd)) {
+            if (fd >= 0) {
+                error = m_server->errorString();
+#ifdef Q_OS_UNIX
+                ::close(static_cast<int>(fd));
+#endif
+            }
+            reportStartFailure(port, error);
+            delete m_server;
+            m_server = nullptr;
+            return false;
+        }
+    } else if (!m_server->listen(QHostAddress::Any, port)) {
         actualPort = m_server->serverPort(); // get assigned port if 0 was given
-    
-        QString err = QStringLiteral("Failed to start WebSocketServer on port %1").arg(actualPort);
-        qCritical() << err;
-        QVariantMap details;
-        details["port"] = actualPort;
-        details["reason"] = err;
-        emit serverError(imagesocket::ServerStartFailed, details);
+        reportStartFailure(actualPort, m_server->errorString());
         delete m_server;
         m_server = nullptr;
         return false;
@@ -50,8 +263,60 @@ bool WebSocketServer::start(quint16 port)
     return true;
 }
 
+bool WebSocketServer::configureQtTls(QString& error)
+{
+#ifndef QT_NO_SSL
+    const QList<QSslCertificate> chain = QSslCertificate::fromPath(m_tlsCert);
+    QFile keyFile(m_tlsKey);
+    if (chain.isEmpty()) {
+        error = QStringLiteral("can't load certificate %1").arg(m_tlsCert);
+        return false;
+    }
+    if (!keyFile.open(QIODevice::ReadOnly)) {
+        error = QStringLiteral("can't read private key %1").arg(m_tlsKey);
+        return false;
+    }
+    const QByteArray pem = keyFile.readAll();
+    QSslKey key(pem, QSsl::Ec);
+    if (key.isNull())
+        key = QSslKey(pem, QSsl::Rsa);
+    if (key.isNull()) {
+        error = QStringLiteral("can't load private key %1").arg(m_tlsKey);
+        return false;
+    }
+    QSslConfiguration config = QSslConfiguration::defaultConfiguration();
+    config.setLocalCertificateChain(chain);
+    config.setPrivateKey(key);
+    config.setPeerVerifyMode(QSslSocket::VerifyNone);
+    config.setProtocol(QSsl::TlsV1_2OrLater);
+    m_server->setSslConfiguration(config);
+    return true;
+#else
+    error = QStringLiteral("Qt was built without SSL support");
+    return false;
+#endif
+}
+
+void WebSocketServer::reportStartFailure(quint16 port, const QString& reason)
+{
+    QString err = QStringLiteral("Failed to start WebSocketServer on port %1").arg(port);
+    qCritical() << err << reason;
+    QVariantMap details;
+    details["port"] = port;
+    details["reason"] = err;
+    emit serverError(imagesocket::ServerStartFailed, details);
+}
+
 void WebSocketServer::stop()
 {
+    if (m_beast) {
+        // Drops every Beast session; their disconnects are already queued to us
+        m_beast->stop();
+        m_beast->deleteLater();
+        m_beast = nullptr;
+        qInfo() << "WebSocketServer stopped";
+        return;
+    }
     if (!m_server)
         return;
 
@@ -63,9 +328,64 @@ void WebSocketServer::stop()
 
 quint16 WebSocketServer::port() const
 {
+    if (m_beast)
+        return m_beast->port();
     return m_server ? m_server->serverPort() : 0;
 }
 
+WebSocketServer::Backend WebSocketServer::backend() const
+{
+    return m_backend;
+}
+
+void WebSocketServer::setBackend(Backend backend)
+{
+    m_backend = backend;
+}
+
+bool WebSocketServer::reusePort() const
+{
+    return m_reusePort;
+}
+
+void WebSocketServer::setReusePort(bool enabled)
+{
+    m_reusePort = enabled;
+}
+
+bool WebSocketServer::udpFrames() const
+{
+    return m_udpFrames;
+}
+
+void WebSocketServer::setUdpFrames(bool enabled)
+{
+    m_udpFrames = enabled;
+}
+
+bool WebSocketServer::tlsEnabled() const
+{
+    return !m_tlsCert.isEmpty() && !m_tlsKey.isEmpty();
+}
+
+void WebSocketServer::setTls(const QString& certFile, const QString& keyFile)
+{
+    m_tlsCert = certFile;
+    m_tlsKey = keyFile;
+}
+
+KeepaliveConfig WebSocketServer::keepalive() const
+{
+    return m_keepalive;
+}
+
+void WebSocketServer::setKeepalive(const KeepaliveConfig& config)
+{
+    m_keepalive = config;
+    if (m_beast)
+        m_beast->setKeepalive(m_keepalive);
+}
+
 void WebSocketServer::onNewConnection()
 {
     if (!m_server)
@@ -77,61 +397,781 @@ void WebSocketServer::onNewConnection()
 
     const QHostAddress addr = socket->peerAddress();
 
-    // Create session and manage its lifecycle
-    ClientSession* session = new ClientSession(socket, this);
-    m_sessions.append(QPointer<ClientSession>(session));
+    if (m_limits.maxSessions > 0 && m_sessions.size() >= m_limits.maxSessions) {
+        socket->close(QWebSocketProtocol::CloseCodePolicyViolated, QStringLiteral("server full"));
+        socket->deleteLater();
+        onConnectionRejected(addr);
+        return;
+    }
+    // Over the accept rate: no session, only when to come back
+    const qint64 retryAfterMs = paceConnection(addr);
+    if (retryAfterMs > 0) {
+        QByteArray out;
+        const QByteArray serialized = retryAfterMessage(retryAfterMs);
+        out.reserve(serialized.size() + 1);
+        out.append(static_cast<char>(MessagePrefix::Control));
+        out.append(serialized);
+        socket->sendBinaryMessage(out);
+        socket->close(QWebSocketProtocol::CloseCodePolicyViolated, QStringLiteral("retry later"));
+        socket->deleteLater();
+        return;
+    }
+    // Bounds what the socket buffers for one message
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+    socket->setMaxAllowedIncomingMessageSize(static_cast<quint64>(qMax<qint64>(0, m_limits.maxMessageBytes)));
+    socket->setMaxAllowedIncomingFrameSize(static_cast<quint64>(qMax<qint64>(0, m_limits.maxFrameBytes)));
+#endif
+
+    // Create session and manage its lifecycle. It has no parent so that it
+    // (and the socket, its child) can move to an I/O thread before the event
+    // loop touches the socket again.
+    ClientSession* session = new ClientSession(socket);
+    const QString clientId = session->id();
+    m_sessions.insert(clientId, session);
 
-    // Forward session events
+    // Forward session events (queued when the session runs on an I/O thread)
     connect(session, &ClientSession::disconnected, this, &WebSocketServer::onSessionDisconnected);
-    connect(session, &ClientSession::controlMessageReceived, this, [this](const QString& clientId, const QByteArray& serialized){
-        emit controlMessageReceived(clientId, serialized);
-    });
-    connect(session, &ClientSession::frameReceived, this, [this](const QString& clientId, const QImage& img){
-        emit frameReceived(clientId, img);
+    connect(session, &ClientSession::controlMessageReceived, this, &WebSocketServer::onControlMessageReceived);
+    connect(session, &ClientSession::encodedFrameReceived, this, &WebSocketServer::onEncodedFrameReceived);
+    connect(session, &ClientSession::udpChannelOpened, this, &WebSocketServer::onUdpChannelOpened);
+    connect(session, &ClientSession::frameRefused, this, &WebSocketServer::onFrameRefused);
+    session->setMemoryAccount(m_memory->openAccount(clientId.toStdString()));
+
+    const int ioThread = pickIoThread();
+    if (ioThread >= 0) {
+        m_sessionThread.insert(clientId, ioThread);
+        ++m_ioThreadLoad[ioThread];
+        session->moveToThread(m_ioThreads.at(ioThread));
+    }
+    // Its timer belongs to the session's thread
+    const KeepaliveConfig keepalive = m_keepalive;
+    QMetaObject::invokeMethod(session, [session, keepalive]() { session->startKeepalive(keepalive); });
+
+    qInfo() << "Accepted new WebSocket connection from" << addr.toString() << "id=" << clientId
+            << "thread=" << ioThread;
+
+    m_peerAddress.insert(clientId, addr);
+    emit clientConnected(clientId, addr);
+    awaitHello(clientId);
+}
+
+void WebSocketServer::onBeastSessionOpened(const QString& clientId, const QHostAddress& address)
+{
+    const qint64 retryAfterMs = paceConnection(address);
+    if (retryAfterMs > 0) {
+        m_pacedAway.insert(clientId);
+        if (m_beast) {
+            m_beast->sendControl(clientId, retryAfterMessage(retryAfterMs), MessagePrefix::Control);
+            m_beast->closeSession(clientId);
+        }
+        return;
+    }
+    m_beastClients.insert(clientId);
+    m_peerAddress.insert(clientId, address);
+    qInfo() << "Accepted new Beast WebSocket connection from" << address.toString() << "id=" << clientId;
+    emit clientConnected(clientId, address);
+    awaitHello(clientId);
+}
+
+void WebSocketServer::onConnectionRejected(const QHostAddress& address)
+{
+    qWarning() << "Rejected connection from" << address.toString() << ": session limit" << m_limits.maxSessions;
+    QVariantMap details;
+    details["address"] = address.toString();
+    details["reason"] = QStringLiteral("session limit (%1) reached").arg(m_limits.maxSessions);
+    emit serverError(imagesocket::ConnectionRejected, details);
+}
+
+qint64 WebSocketServer::paceConnection(const QHostAddress& address)
+{
+    const qint64 waitMs = m_acceptPacer.admit(monotonicMs());
+    if (waitMs > 0 && m_acceptPacer.deferred() % kPacedLogEvery == 1) {
+        qInfo() << "Pacing connections at" << m_acceptPacer.perSecond() << "/s:" << address.toString()
+                << "retries in" << waitMs << "ms;" << m_acceptPacer.deferred() << "paced so far";
+    }
+    return waitMs;
+}
+
+WebSocketServer::AdmissionLimits WebSocketServer::admissionLimits() const
+{
+    return m_limits;
+}
+
+void WebSocketServer::setAdmissionLimits(const AdmissionLimits& limits)
+{
+    // The pacer keeps its slots unless the pace itself changes
+    const bool repace = limits.acceptRate != m_limits.acceptRate || limits.acceptBurst != m_limits.acceptBurst;
+    m_limits = limits;
+    m_limits.maxSessions = std::max(0, limits.maxSessions);
+    if (repace)
+        m_acceptPacer.configure(m_limits.acceptRate, m_limits.acceptBurst);
+    if (m_beast) {
+        m_beast->setMaxSessions(m_limits.maxSessions);
+        m_beast->setMaxMessageBytes(static_cast<std::size_t>(qMax<qint64>(0, m_limits.maxMessageBytes)));
+    }
+
+    // Limiters start fresh with the new cap
+    m_ingress.clear();
+    if (m_limits.ingress.maxBytesPerSecond > 0) {
+        m_ingressTimer->start(std::max(100, m_limits.ingress.intervalMs));
+    } else {
+        m_ingressTimer->stop();
+    }
+}
+
+int WebSocketServer::sessionCount() const
+{
+    return m_sessions.size() + m_beastClients.size();
+}
+
+std::shared_ptr<MemoryBudget> WebSocketServer::memoryBudget() const
+{
+    return m_memory;
+}
+
+void WebSocketServer::onFrameRefused(const QString& clientId, quint16 streamId, bool keyframeNeeded)
+{
+    // Simulcast layers share the connection's row; a stream not seen yet has no row to report to
+    QString streamClient = clientId;
+    if (streamId > 0 && !m_simulcast.contains(clientId) && m_substreams.value(clientId).contains(streamId))
+        streamClient = streamClientId(clientId, streamId);
+    emit framesDropped(streamClient, 1);
+    if (keyframeNeeded)
+        emit keyframeNeeded(streamClient);
+}
+
+void WebSocketServer::disconnectClient(const QString& id, const QString& reason)
+{
+    const QString clientId = connectionOf(id);
+    flushControl(clientId); // what was sent to it goes out before the close
+    if (m_beastClients.contains(clientId)) {
+        if (m_beast)
+            m_beast->closeSession(clientId);
+        return;
+    }
+    ClientSession* session = m_sessions.value(clientId);
+    if (!session)
+        return;
+    QMetaObject::invokeMethod(session, [session, reason]() { session->close(reason); });
+}
+
+void WebSocketServer::evaluateIngress()
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QStringList overloaded;
+    for (auto it = m_ingress.begin(); it != m_ingress.end(); ++it) {
+        const IngressAction action = it.value().evaluate(now);
+        if (action.kind == IngressAction::Throttle) {
+            imagesocket::control::ControlMessage msg;
+            msg.set_type(imagesocket::control::SET_FPS);
+            msg.set_fps(action.fps);
+            // The cap is per connection: every stream on it slows down
+            const QByteArray serialized = serializeControlMessage(msg);
+            QStringList streams = substreams(it.key());
+            streams.prepend(it.key());
+            for (const QString& stream : qAsConst(streams)) {
+                if (sendControlToClient(stream, serialized))
+                    emit clientThrottled(stream, action.fps);
+            }
+        } else if (action.kind == IngressAction::Disconnect) {
+            overloaded.append(it.key());
+        }
+    }
+    for (const QString& clientId : qAsConst(overloaded)) {
+        m_ingress.remove(clientId);
+        qWarning() << "Disconnecting" << clientId << ": over the ingress cap after throttling";
+        QVariantMap details;
+        details["clientId"] = clientId;
+        details["reason"] = QStringLiteral("over %1 bytes/s").arg(m_limits.ingress.maxBytesPerSecond);
+        emit serverError(imagesocket::ClientOverloadDisconnected, details);
+        disconnectClient(clientId, QStringLiteral("ingress limit exceeded"));
+    }
+}
+
+void WebSocketServer::awaitHello(const QString& clientId)
+{
+    m_awaitingHello.insert(clientId);
+    // Clients that start paused and predate HELLO send nothing on their own
+    QTimer::singleShot(kHelloWaitMs, this, [this, clientId]() {
+        if (m_awaitingHello.remove(clientId))
+            greetClient(clientId);
     });
+}
+
+void WebSocketServer::onControlMessageReceived(const QString& clientId, const ControlMessagePtr& message)
+{
+    if (!message)
+        return;
+    const imagesocket::control::ControlMessage& msg = *message;
+    if (m_viewers.contains(clientId)) {
+        onViewerControl(clientId, msg);
+        return;
+    }
+    if (!m_awaitingHello.isEmpty() && m_awaitingHello.remove(clientId)) {
+        if (msg.type() == imagesocket::control::HELLO && msg.control_batch())
+            m_controlBatch.insert(clientId);
+        if (msg.type() != imagesocket::control::HELLO) {
+            greetClient(clientId);
+        } else if (msg.role() == imagesocket::control::VIEWER) {
+            const OutboundDropPolicy policy = msg.drop_policy() == imagesocket::control::RELAY_DROP_NEWEST
+                ? OutboundDropPolicy::DropNewest : OutboundDropPolicy::DropOldest;
+            startViewer(clientId, msg.relay_depth() > 0 ? msg.relay_depth() : static_cast<int>(kDefaultRelayDepth), policy);
+            setViewerLimits(clientId, QSize(msg.max_width(), msg.max_height()), msg.max_bitrate_kbps());
+            emit viewerSubscribed(clientId, QString::fromStdString(msg.source()));
+            return;
+        } else {
+            if (!msg.shm_ring().empty())
+                attachSharedMemory(clientId, QString::fromStdString(msg.shm_ring()));
+            if (msg.udp_frames() && m_udpFrames && !tlsEnabled()) {
+                ClientSession* session = m_sessions.value(clientId);
+                if (session)
+                    QMetaObject::invokeMethod(session, [session]() { session->openUdpChannel(); });
+            }
+            if (msg.simulcast_layers() > 1) {
+                Simulcast& simulcast = m_simulcast[clientId];
+                simulcast.meter.setLayerCount(msg.simulcast_layers());
+                qInfo() << "Client" << clientId << "sends" << simulcast.meter.layerCount() << "simulcast layers";
+                if (!m_simulcastTimer->isActive())
+                    m_simulcastTimer->start();
+                updateStreamingDecode(clientId);
+            }
+        }
+    }
+    emit controlMessageReceived(clientId, message);
+}
+
+void WebSocketServer::startViewer(const QString& clientId, int depth, OutboundDropPolicy policy)
+{
+    Viewer viewer;
+    viewer.depth = depth;
+    viewer.policy = policy;
+    m_viewers.insert(clientId, viewer);
+    // Nothing it sends is a frame: no decoding, no ingress cap
+    m_decoder->removeClient(clientId);
+    m_decodeEnabled.remove(clientId);
+    m_ingress.remove(clientId);
+    qInfo() << "Session" << clientId << "is a viewer, relay depth" << depth
+            << (policy == OutboundDropPolicy::DropNewest ? "drop newest" : "drop oldest");
+}
 
-    qInfo() << "Accepted new WebSocket connection from" << addr.toString() << "id=" << session->id();
+void WebSocketServer::onViewerControl(const QString& viewerId, const imagesocket::control::ControlMessage& msg)
+{
+    if (msg.type() == imagesocket::control::SUBSCRIBE) {
+        setViewerLimits(viewerId, QSize(msg.max_width(), msg.max_height()), msg.max_bitrate_kbps());
+        emit viewerSubscribed(viewerId, QString::fromStdString(msg.source()));
+    } else if (msg.type() == imagesocket::control::UNSUBSCRIBE) {
+        setRelaySource(viewerId, QString());
+        emit viewerSubscribed(viewerId, QString());
+    }
+}
+
+bool WebSocketServer::setRelaySource(const QString& viewerId, const QString& sourceId)
+{
+    auto viewer = m_viewers.find(viewerId);
+    if (viewer == m_viewers.end())
+        return false;
+    if (!sourceId.isEmpty()) {
+        // Only a connected client (or one of its streams) can be watched
+        const QString connection = connectionOf(sourceId);
+        const bool connected = (m_sessions.contains(connection) || m_beastClients.contains(connection))
+            && (connection == sourceId || m_substreams.value(connection).contains(streamOf(sourceId)));
+        if (!connected || m_viewers.contains(connection))
+            return false;
+    }
+    if (viewer->source == sourceId)
+        return true;
+
+    const QString previous = viewer->source;
+    viewer->source = sourceId;
+    auto targets = m_relayTargets.find(previous);
+    if (targets != m_relayTargets.end()) {
+        targets->remove(viewerId);
+        if (targets->isEmpty()) {
+            m_relayTargets.erase(targets);
+            emit watchedChanged(previous, false);
+        }
+    }
+    if (sourceId.isEmpty()) {
+        qInfo() << "Viewer" << viewerId << "stopped watching" << previous;
+        return true;
+    }
+
+    // The relay queue starts over: an H.264/H.265 source from its next keyframe
+    const int depth = viewer->depth;
+    const OutboundDropPolicy policy = viewer->policy;
+    if (m_beastClients.contains(viewerId)) {
+        if (m_beast)
+            m_beast->startRelay(viewerId, depth, policy);
+    } else if (ClientSession* session = m_sessions.value(viewerId)) {
+        QMetaObject::invokeMethod(session, [session, depth, policy]() { session->startRelay(depth, policy); });
+    }
+    QSet<QString>& watchers = m_relayTargets[sourceId];
+    watchers.insert(viewerId);
+    qInfo() << "Viewer" << viewerId << "watches" << sourceId;
+    if (watchers.size() == 1)
+        emit watchedChanged(sourceId, true);
+    if (m_simulcast.contains(sourceId))
+        updateSimulcastLayers(sourceId);
+    return true;
+}
+
+void WebSocketServer::setViewerLimits(const QString& viewerId, const QSize& display, int maxBitrateKbps)
+{
+    auto viewer = m_viewers.find(viewerId);
+    if (viewer == m_viewers.end())
+        return;
+    if (display.width() > 0 && display.height() > 0)
+        viewer->display = display;
+    if (maxBitrateKbps > 0)
+        viewer->maxBitrateBps = maxBitrateKbps * 1000.0;
+    if (m_simulcast.contains(viewer->source))
+        updateSimulcastLayers(viewer->source);
+}
+
+int WebSocketServer::simulcastLayers(const QString& clientId) const
+{
+    const auto simulcast = m_simulcast.constFind(clientId);
+    return simulcast == m_simulcast.constEnd() ? 0 : simulcast->meter.layerCount();
+}
+
+int WebSocketServer::simulcastLayer(const QString& clientId) const
+{
+    return m_simulcast.value(clientId).displayLayer;
+}
 
-    emit clientConnected(session->id(), addr);
+void WebSocketServer::setSimulcastTarget(const QString& clientId, const QSize& size)
+{
+    auto simulcast = m_simulcast.find(clientId);
+    if (simulcast == m_simulcast.end() || simulcast->target == size)
+        return;
+    simulcast->target = size;
+    updateSimulcastLayers(clientId);
+}
+
+void WebSocketServer::evaluateSimulcast()
+{
+    const QStringList clients = m_simulcast.keys();
+    for (const QString& clientId : clients) {
+        m_simulcast[clientId].meter.evaluate(m_simulcastTimer->interval());
+        updateSimulcastLayers(clientId);
+    }
+}
 
+void WebSocketServer::updateSimulcastLayers(const QString& clientId)
+{
+    auto simulcast = m_simulcast.find(clientId);
+    if (simulcast == m_simulcast.end())
+        return;
+    const std::vector<SimulcastLayer>& layers = simulcast->meter.layers();
+
+    const int displayLayer = pickSimulcastLayer(layers, simulcast->target.width(), simulcast->target.height(), 0.0);
+    if (displayLayer != simulcast->displayLayer) {
+        qInfo() << "Client" << clientId << "shown from simulcast layer" << displayLayer;
+        simulcast->displayLayer = displayLayer;
+    }
+    QSet<int> used;
+    used.insert(displayLayer);
+    for (const QString& viewerId : m_relayTargets.value(clientId)) {
+        auto viewer = m_viewers.find(viewerId);
+        if (viewer == m_viewers.end())
+            continue;
+        viewer->layer = pickSimulcastLayer(layers, viewer->display.width(), viewer->display.height(),
+                                           viewer->maxBitrateBps);
+        used.insert(viewer->layer);
+    }
+
+    // Layer 0 always flows (it carries the meter's full size); the others only when taken
+    for (int layer = 1; layer < simulcast->meter.layerCount(); ++layer) {
+        const bool paused = !used.contains(layer);
+        if (paused == simulcast->pausedLayers.contains(layer))
+            continue;
+        imagesocket::control::ControlMessage msg;
+        msg.set_type(paused ? imagesocket::control::PAUSE : imagesocket::control::RESUME);
+        msg.set_stream_id(static_cast<quint32>(layer));
+        if (!sendControlToClient(clientId, msg))
+            continue;
+        if (paused)
+            simulcast->pausedLayers.insert(layer);
+        else
+            simulcast->pausedLayers.remove(layer);
+    }
+}
+
+QString WebSocketServer::relaySource(const QString& viewerId) const
+{
+    return m_viewers.value(viewerId).source;
+}
+
+QStringList WebSocketServer::viewers() const
+{
+    return m_viewers.keys();
+}
+
+bool WebSocketServer::isWatched(const QString& clientId) const
+{
+    return m_relayTargets.contains(clientId);
+}
+
+void WebSocketServer::relayFrame(const QString& sourceId, const EncodedFrame& frame, int layer)
+{
+    const auto targets = m_relayTargets.constFind(sourceId);
+    if (targets == m_relayTargets.constEnd())
+        return;
+
+    RelayFrameKind kind = RelayFrameKind::Independent;
+    if (frame.format == EncodedFrame::Video) {
+        VideoPacketHeader header;
+        const bool keyframe = parseVideoPacketHeader(reinterpret_cast<const std::uint8_t*>(frame.data()),
+                                                     static_cast<std::size_t>(frame.size()), header)
+            && header.keyframe;
+        kind = keyframe ? RelayFrameKind::Keyframe : RelayFrameKind::Delta;
+    }
+
+    // The whole message as received: every viewer shares its buffer
+    const QByteArray message = frame.buffer;
+    for (const QString& viewerId : *targets) {
+        if (layer >= 0 && m_viewers.value(viewerId).layer != layer)
+            continue;
+        if (m_beastClients.contains(viewerId)) {
+            if (m_beast)
+                m_beast->relayFrame(viewerId, message, kind);
+        } else if (ClientSession* session = m_sessions.value(viewerId)) {
+            QMetaObject::invokeMethod(session, [session, message, kind]() { session->relayFrame(message, kind); });
+        }
+    }
+}
+
+void WebSocketServer::dropRelays(const QString& clientId)
+{
+    if (m_viewers.contains(clientId)) {
+        setRelaySource(clientId, QString());
+        m_viewers.remove(clientId);
+        return;
+    }
+    // Its viewers stay, watching nothing until they are given a source again
+    const QSet<QString> watchers = m_relayTargets.take(clientId);
+    if (watchers.isEmpty())
+        return;
+    for (const QString& viewerId : watchers) {
+        auto viewer = m_viewers.find(viewerId);
+        if (viewer != m_viewers.end())
+            viewer->source.clear();
+    }
+    qInfo() << "Source" << clientId << "gone, its" << watchers.size() << "viewers wait for a new one";
+    emit watchedChanged(clientId, false);
+}
+
+void WebSocketServer::attachSharedMemory(const QString& clientId, const QString& ringName)
+{
+    // Only a client on this host can share memory with us; the name must be one of its rings
+    const QHostAddress address = m_peerAddress.value(clientId);
+    if (!isLocalAddress(address) || !ringName.startsWith(QLatin1String(kShmRingNamePrefix))
+        || ringName.indexOf(QLatin1Char('/'), 1) >= 0) {
+        qInfo() << "Ignoring shared memory ring" << ringName << "of" << clientId << "from" << address.toString();
+        return;
+    }
+
+    if (m_beastClients.contains(clientId)) {
+        if (m_beast)
+            m_beast->attachSharedMemory(clientId, ringName);
+        return;
+    }
+    ClientSession* session = m_sessions.value(clientId);
+    if (session)
+        QMetaObject::invokeMethod(session, [session, ringName]() { session->attachSharedMemory(ringName); });
+}
+
+void WebSocketServer::onUdpChannelOpened(const QString& clientId, quint16 port, quint32 key)
+{
+    imagesocket::control::ControlMessage msg;
+    msg.set_type(imagesocket::control::UDP_CHANNEL);
+    msg.set_udp_port(port);
+    msg.set_udp_key(key);
+    sendControlToClient(clientId, msg);
+}
+
+void WebSocketServer::greetClient(const QString& clientId)
+{
     // Request alias from newly connected client
     imagesocket::control::ControlMessage req;
     req.set_type(imagesocket::control::REQUEST_ALIAS);
-    std::string out;
-    if (req.SerializeToString(&out)) {
-        QByteArray ba(out.data(), (int)out.size());
-        session->sendControlMessage(ba);
-    } else {
-        qWarning() << "Failed to serialize alias request";
+    sendControlToClient(clientId, req);
+
+    // Ask for per-frame metadata; clients that don't know the command keep the bare prefixes
+    imagesocket::control::ControlMessage framing;
+    framing.set_type(imagesocket::control::FRAME_HEADER);
+    sendControlToClient(clientId, framing);
+}
+
+void WebSocketServer::removeSubstreams(const QString& clientId)
+{
+    m_peerAddress.remove(clientId);
+    const QSet<quint16> streams = m_substreams.take(clientId);
+    for (quint16 stream : streams) {
+        const QString streamClient = streamClientId(clientId, stream);
+        dropRelays(streamClient);
+        m_decoder->removeClient(streamClient);
+        m_decodeEnabled.remove(streamClient);
+        emit clientDisconnected(streamClient);
     }
 }
 
 void WebSocketServer::onSessionDisconnected(const QString& clientId)
 {
-    // Remove session with matching id
-    for (int i = 0; i < m_sessions.size(); ++i) {
-        QPointer<ClientSession> sPtr = m_sessions.at(i);
-        ClientSession* s = sPtr.data();
-        if (s && s->id() == clientId) {
-            qInfo() << "Removing session" << clientId;
-            m_sessions.removeAt(i);
-            s->deleteLater();
+    if (m_pacedAway.remove(clientId))
+        return; // never became a session
+    // The connection's extra streams go first, then its own row
+    removeSubstreams(clientId);
+    m_controlBatch.remove(clientId);
+    m_pendingControl.remove(clientId);
+    if (m_simulcast.remove(clientId) && m_simulcast.isEmpty())
+        m_simulcastTimer->stop();
+    const bool viewer = m_viewers.contains(clientId);
+    dropRelays(clientId);
+    if (m_beastClients.remove(clientId)) {
+        qInfo() << "Removing Beast session" << clientId;
+        m_decoder->removeClient(clientId);
+        m_decodeEnabled.remove(clientId);
+        m_decodeTargets.remove(clientId);
+        m_ingress.remove(clientId);
+        m_awaitingHello.remove(clientId);
+        if (viewer)
+            emit viewerDisconnected(clientId);
+        else
             emit clientDisconnected(clientId);
-            return;
+        return;
+    }
+
+    ClientSession* session = m_sessions.take(clientId);
+    if (!session) {
+        qWarning() << "Disconnected session not found:" << clientId;
+        return;
+    }
+
+    qInfo() << "Removing session" << clientId;
+    const auto thread = m_sessionThread.find(clientId);
+    if (thread != m_sessionThread.end()) {
+        --m_ioThreadLoad[thread.value()];
+        m_sessionThread.erase(thread);
+    }
+    m_decoder->removeClient(clientId);
+    m_decodeEnabled.remove(clientId);
+    m_ingress.remove(clientId);
+    m_awaitingHello.remove(clientId);
+    session->deleteLater(); // runs on the session's thread, after events already queued there
+    if (viewer)
+        emit viewerDisconnected(clientId);
+    else
+        emit clientDisconnected(clientId);
+}
+
+bool WebSocketServer::sendControlToClient(const QString& id, const QByteArray& message)
+{
+    const QString clientId = connectionOf(id);
+    QByteArray serialized = message;
+    if (clientId != id) {
+        // Addressed to one stream of the connection: a stream_id appended to
+        // the message overrides any it carries (no parsing, a few bytes copied)
+        imagesocket::control::ControlMessage stream;
+        stream.set_stream_id(streamOf(id));
+        appendControlMessage(serialized, stream);
+    }
+
+    if (m_controlBatch.contains(clientId)) {
+        // Rate control, pings and layer switches often send several at once
+        m_pendingControl[clientId].append(serialized);
+        if (!m_controlFlushQueued) {
+            m_controlFlushQueued = true;
+            QMetaObject::invokeMethod(this, [this]() { flushControl(); }, Qt::QueuedConnection);
         }
+        return true;
+    }
+    return writeControl(clientId, serialized, MessagePrefix::Control);
+}
+
+void WebSocketServer::flushControl()
+{
+    m_controlFlushQueued = false;
+    const QHash<QString, QByteArrayList> pending = std::move(m_pendingControl);
+    m_pendingControl.clear();
+    for (auto it = pending.cbegin(); it != pending.cend(); ++it)
+        writeControlBatch(it.key(), it.value());
+}
+
+void WebSocketServer::flushControl(const QString& clientId)
+{
+    const QByteArrayList pending = m_pendingControl.take(clientId);
+    if (!pending.isEmpty())
+        writeControlBatch(clientId, pending);
+}
+
+void WebSocketServer::writeControlBatch(const QString& clientId, const QByteArrayList& messages)
+{
+    if (messages.size() == 1) {
+        writeControl(clientId, messages.first(), MessagePrefix::Control);
+        return;
     }
-    qWarning() << "Disconnected session not found:" << clientId;
+    int size = 0;
+    for (const QByteArray& message : messages)
+        size += message.size() + 6; // tag and length
+    QByteArray batch;
+    batch.reserve(size);
+    for (const QByteArray& message : messages)
+        appendControlBatchEntry(batch, message.constData(), static_cast<std::size_t>(message.size()));
+    writeControl(clientId, batch, MessagePrefix::ControlBatch);
 }
 
-bool WebSocketServer::sendControlToClient(const QString& clientId, const QByteArray& serialized)
+bool WebSocketServer::writeControl(const QString& clientId, const QByteArray& serialized, MessagePrefix prefix)
 {
-    for (int i = 0; i < m_sessions.size(); ++i) {
-        ClientSession* s = m_sessions.at(i).data();
-        if (s && s->id() == clientId) {
-            s->sendControlMessage(serialized);
+    if (m_beastClients.contains(clientId)) {
+        if (m_beast && m_beast->sendControl(clientId, serialized, prefix))
             return true;
+        qWarning() << "sendControlToClient: Beast session gone" << clientId;
+        return false;
+    }
+
+    ClientSession* session = m_sessions.value(clientId);
+    if (!session) {
+        qWarning() << "sendControlToClient: client not found" << clientId;
+        return false;
+    }
+    // Sockets may only be written from their own thread; the call is dropped
+    // if the session is deleted first
+    QMetaObject::invokeMethod(session, [session, serialized, prefix]() {
+        session->sendControlMessage(serialized, prefix);
+    });
+    return true;
+}
+bool WebSocketServer::sendControlToClient(const QString& id, const imagesocket::control::ControlMessage& message)
+{
+    return sendControlToClient(id, serializeControlMessage(message));
+}
+
+void WebSocketServer::onEncodedFrameReceived(const QString& clientId, const EncodedFrame& frame)
+{
+    if (m_viewers.contains(clientId))
+        return; // viewers only receive
+
+    // A frame before any HELLO: a legacy client that streams on connect
+    if (!m_awaitingHello.isEmpty() && m_awaitingHello.remove(clientId))
+        greetClient(clientId);
+
+    // The cap covers the whole connection, every stream and layer
+    if (m_limits.ingress.maxBytesPerSecond > 0) {
+        auto limiter = m_ingress.find(clientId);
+        if (limiter == m_ingress.end()) {
+            limiter = m_ingress.insert(clientId, IngressLimiter(m_limits.ingress));
+            limiter.value().evaluate(QDateTime::currentMSecsSinceEpoch()); // starts its first interval
         }
+        limiter.value().onFrame(static_cast<std::size_t>(frame.size()));
     }
-    qWarning() << "sendControlToClient: client not found" << clientId;
-    return false;
+
+    const quint16 streamId = frame.hasHeader ? frame.header.streamId : 0;
+    auto simulcast = m_simulcast.find(clientId);
+    if (simulcast != m_simulcast.end()) {
+        // Layers of one capture share the connection's row: each consumer gets its layer
+        simulcast->meter.onFrame(streamId, static_cast<std::size_t>(frame.size()),
+                                 frame.hasHeader ? frame.header.width : 0, frame.hasHeader ? frame.header.height : 0);
+        const bool shown = streamId == simulcast->displayLayer;
+        relayFrame(clientId, frame, streamId);
+        if (!shown)
+            return;
+        emit encodedFrameReceived(clientId, frame);
+        if (m_decodeEnabled.contains(clientId))
+            m_decoder->submit(clientId, frame);
+        return;
+    }
+
+    // Extra streams of the connection get a client id (and a row) of their own
+    QString streamClient = clientId;
+    if (streamId > 0 && streamId < kMaxStreamsPerConnection) {
+        streamClient = streamClientId(clientId, streamId);
+        QSet<quint16>& streams = m_substreams[clientId];
+        if (!streams.contains(streamId)) {
+            streams.insert(streamId);
+            qInfo() << "New stream" << streamId << "on connection" << clientId;
+            emit clientConnected(streamClient, m_peerAddress.value(clientId));
+        }
+    }
+
+    relayFrame(streamClient, frame);
+    emit encodedFrameReceived(streamClient, frame);
+
+    if (m_decodeEnabled.contains(streamClient))
+        m_decoder->submit(streamClient, frame);
+}
+
+void WebSocketServer::setDecodeEnabled(const QString& clientId, bool enabled)
+{
+    if (clientId.isEmpty())
+        return;
+
+    if (enabled) {
+        m_decodeEnabled.insert(clientId);
+    } else {
+        m_decodeEnabled.remove(clientId);
+        m_decoder->removeClient(clientId);
+    }
+    updateStreamingDecode(clientId);
+}
+
+bool WebSocketServer::isDecodeEnabled(const QString& clientId) const
+{
+    return m_decodeEnabled.contains(clientId);
+}
+
+void WebSocketServer::setDecodePriority(const QString& clientId, DecodePriority priority)
+{
+    if (clientId.isEmpty())
+        return;
+    m_decoder->setPriority(clientId, priority);
+}
+
+void WebSocketServer::setDecodeTarget(const QString& clientId, const QSize& size)
+{
+    if (clientId.isEmpty())
+        return;
+    m_decoder->setTargetSize(clientId, size);
+    if (m_beastClients.contains(clientId)) {
+        m_decodeTargets.insert(clientId, size);
+        updateStreamingDecode(clientId);
+    }
+}
+
+void WebSocketServer::updateStreamingDecode(const QString& clientId)
+{
+    if (!m_beast || !m_beastClients.contains(clientId))
+        return;
+    // A simulcast client's stream 0 is often not the layer on display
+    const bool enabled = m_decodeEnabled.contains(clientId) && !m_simulcast.contains(clientId);
+    m_beast->setStreamingDecode(clientId, enabled, m_decodeTargets.value(clientId));
+}
+
+QString WebSocketServer::streamClientId(const QString& connectionId, quint16 streamId)
+{
+    if (streamId == 0)
+        return connectionId;
+    return connectionId + QLatin1Char('/') + QString::number(streamId);
+}
+
+QString WebSocketServer::connectionOf(const QString& clientId)
+{
+    const int slash = clientId.lastIndexOf(QLatin1Char('/'));
+    return slash < 0 ? clientId : clientId.left(slash);
+}
+
+quint16 WebSocketServer::streamOf(const QString& clientId)
+{
+    const int slash = clientId.lastIndexOf(QLatin1Char('/'));
+    return slash < 0 ? 0 : static_cast<quint16>(clientId.mid(slash + 1).toUInt());
+}
+
+QStringList WebSocketServer::substreams(const QString& connectionId) const
+{
+    QList<quint16> streams = m_substreams.value(connectionId).values();
+    std::sort(streams.begin(), streams.end());
+    QStringList ids;
+    for (quint16 stream : qAsConst(streams))
+        ids.append(streamClientId(connectionId, stream));
+    return ids;
 }
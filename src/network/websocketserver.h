@@ -5,15 +5,61 @@
 #include <QHostAddress>
 #include <QImage>
 #include <QByteArray>
+#include <QByteArrayList>
+#include <QSet>
+#include <QStringList>
+#include <QHash>
+#include <QVector>
+#include "acceptpacer.h"
+#include "controlmessage.h"
+#include "decodescheduler.h"
 #include "eventcodes.h"
+#include "encodedframe.h"
+#include "ingresslimiter.h"
+#include "keepalive.h"
+#include "memorybudget.h"
+#include "outboundmessage.h"
+#include "relayqueue.h"
+#include "simulcast.h"
 
 class QWebSocketServer;
 class QWebSocket;
+class QThread;
+class QTimer;
+class FrameDecoder;
+class ClientSession;
+class BeastServer;
 
+// Accepts clients and hands every session to one of a few I/O threads
+// (least loaded first), so socket reads, WebSocket unmasking and header
+// parsing for different clients run on different cores. Session signals
+// reach this object, and through it the GUI, as queued events; commands to
+// a session are queued to its thread the same way. All public methods and
+// signals stay on the thread the server lives on.
+//
+// The Beast backend replaces QWebSocketServer/QWebSocket with Boost.Beast
+// sessions on one io_context per I/O thread (see BeastServer) behind the
+// same signals.
 class WebSocketServer : public QObject
 {
     Q_OBJECT
 public:
+    enum class Backend {
+        Qt,   // QWebSocketServer, sessions moved to worker QThreads
+        Beast // Boost.Beast/Asio, for hundreds of streams
+    };
+
+    // Admission control: what one server takes in before it refuses, throttles
+    // or drops clients instead of running out of memory or CPU
+    struct AdmissionLimits {
+        int maxSessions = 0;                          // concurrent sessions; 0: unlimited
+        qint64 maxMessageBytes = 64 * 1024 * 1024;    // larger messages close the session
+        qint64 maxFrameBytes = 64 * 1024 * 1024;      // WebSocket frame (fragment), Qt backend
+        IngressLimiterConfig ingress;                 // per-client bytes/s cap, SET_FPS throttle, disconnect
+        double acceptRate = 0.0;                      // new connections/s, others get RETRY_AFTER; 0: unpaced
+        int acceptBurst = 0;                          // connections at once after a quiet spell; 0: 1 s worth
+    };
+
     explicit WebSocketServer(QObject* parent = nullptr);
     ~WebSocketServer() override;
 
@@ -21,23 +67,250 @@ public:
     void stop();
     quint16 port() const;
 
+    // `serialized` is a ControlMessage without the prefix byte
     bool sendControlToClient(const QString& clientId, const QByteArray& serialized);
+    bool sendControlToClient(const QString& clientId, const imagesocket::control::ControlMessage& message);
+
+    // Decoding is opt-in per client: only clients whose pixels are needed get decoded
+    void setDecodeEnabled(const QString& clientId, bool enabled);
+    bool isDecodeEnabled(const QString& clientId) const;
+    // Display area of a client's decoded frames; JPEG frames decode at a DCT
+    // scale that covers it (FrameDecoder::setTargetSize). Empty: full size.
+    // On the Beast backend, large JPEG frames of decoded clients are decoded
+    // while they arrive (BeastServer::setStreamingDecode()).
+    void setDecodeTarget(const QString& clientId, const QSize& size);
+    // Who gets a decode worker first when more clients have frames than there
+    // are workers (FrameDecoder::setPriority). Background until set.
+    void setDecodePriority(const QString& clientId, DecodePriority priority);
+
+    // Threads sessions are spread over; 0 keeps them on this object's thread.
+    // Only affects threads not started yet, i.e. set it before the first client.
+    int ioThreadCount() const;
+    void setIoThreadCount(int count);
+
+    // Takes effect on the next start()
+    Backend backend() const;
+    void setBackend(Backend backend);
+
+    // Share the port with other server processes (SO_REUSEPORT, Linux/BSD):
+    // the kernel spreads new connections over every listener. Next start().
+    bool reusePort() const;
+    void setReusePort(bool enabled);
+
+    // Take frames over UDP (udpframing.h) from clients whose HELLO offers it:
+    // each such session opens a port of its own and tells the client with
+    // UDP_CHANNEL. For lossy links, where TCP stalls every frame behind a lost
+    // packet. Qt backend only; sessions accepted afterwards.
+    bool udpFrames() const;
+    void setUdpFrames(bool enabled);
+
+    // Serve WSS with the PEM certificate chain and private key; empty paths
+    // serve plain WebSocket. The Beast backend runs OpenSSL on the socket
+    // (tlsstream.h) so the kernel can take over record encryption (kTLS), and
+    // resumes returning clients' sessions; the Qt backend uses QSslSocket.
+    // No UDP channel is offered while TLS is on (its frames would bypass it).
+    // Next start(); a certificate that doesn't load fails it.
+    bool tlsEnabled() const;
+    void setTls(const QString& certFile, const QString& keyFile);
+
+    // Dead-peer detection: a connection that goes quiet is pinged, and one
+    // that stays silent through `maxMissed` pings is closed (clientDisconnected()),
+    // within seconds instead of when TCP gives up on a half-open connection.
+    // On by default; intervalMs 0 turns it off. Connections accepted afterwards.
+    KeepaliveConfig keepalive() const;
+    void setKeepalive(const KeepaliveConfig& config);
+
+    // Session and size limits apply to connections accepted afterwards, the
+    // ingress cap from its next evaluation (once per interval)
+    AdmissionLimits admissionLimits() const;
+    void setAdmissionLimits(const AdmissionLimits& limits);
+    int sessionCount() const;
+
+    // Received frames are charged to their connection's account of this budget
+    // until released (EncodedFrame::charge); frames over it are dropped on
+    // arrival and reported with framesDropped() (and keyframeNeeded() for a
+    // video stream). Configure it and report other memory through the budget
+    // itself; unlimited by default.
+    std::shared_ptr<MemoryBudget> memoryBudget() const;
+    // Close a client's connection; clientDisconnected() follows
+    void disconnectClient(const QString& clientId, const QString& reason);
+
+    // One connection can carry several streams (FrameHeader stream id). Stream
+    // 0 is the connection's own client id; every other one shows up, with its
+    // first frame, as a client of its own: "<connection id>/<stream id>". Such
+    // a client shares the connection, its write queue and I/O thread: control
+    // sent to it goes out on the connection with ControlMessage.stream_id set,
+    // disconnecting it closes the connection (and so all of its streams).
+    static QString streamClientId(const QString& connectionId, quint16 streamId);
+    static QString connectionOf(const QString& clientId);
+    static quint16 streamOf(const QString& clientId);
+    // Client ids of the extra streams seen on a connection so far
+    QStringList substreams(const QString& connectionId) const;
+
+    // Viewer sessions (HELLO role VIEWER) are connections that watch a
+    // client instead of being one: announced by clientConnected() like any
+    // connection, after their HELLO they only get the viewer signals below
+    // (no clientDisconnected(), no control or frame signals). Their source's frame messages are forwarded to
+    // them as received, one shared buffer for every viewer, through a queue
+    // per viewer (RelayQueue) with the depth and drop policy it asked for.
+    // An empty source, or one that disconnects, stops the relay.
+    bool setRelaySource(const QString& viewerId, const QString& sourceId);
+    QString relaySource(const QString& viewerId) const;
+    QStringList viewers() const;
+    bool isWatched(const QString& clientId) const;
+
+    // Simulcast clients (HELLO simulcast_layers) send one capture as layers:
+    // stream n at 1/2^n of the size, each at its own frame rate. The layers
+    // share the connection's row and nothing is re-encoded: every consumer
+    // gets the frames of one layer (pickSimulcastLayer()). The display
+    // (encodedFrameReceived(), the decoder) follows setSimulcastTarget(), and
+    // each viewer follows the display size and bitrate of its HELLO /
+    // SUBSCRIBE. Layers above 0 that nobody takes are paused.
+    // simulcastLayers() is 0 for other clients.
+    int simulcastLayers(const QString& clientId) const;
+    // Layer shown on the display for a simulcast client
+    int simulcastLayer(const QString& clientId) const;
+    // Area the client is shown in; empty: full size (recording, headless)
+    void setSimulcastTarget(const QString& clientId, const QSize& size);
 
 signals:
     void clientConnected(const QString& clientId, const QHostAddress& address);
     void clientDisconnected(const QString& clientId);
-    void controlMessageReceived(const QString& clientId, const QByteArray& serialized);
+    void controlMessageReceived(const QString& clientId, const ControlMessagePtr& message);
+    // Every compressed frame, decoded or not (cheap; used for FPS accounting)
+    void encodedFrameReceived(const QString& clientId, const EncodedFrame& frame);
+    // Decoded frames, only for clients with decoding enabled; frameTimed() precedes each one
+    void frameTimed(const QString& clientId, const FrameTiming& timing);
     void frameReceived(const QString& clientId, const QImage& image);
+    // Frames replaced in a client's mailbox before they could be decoded, or
+    // refused on arrival over the memory budget
+    void framesDropped(const QString& clientId, int count);
+    // A client's H.264/H.265 stream needs a keyframe before it can be decoded again
+    void keyframeNeeded(const QString& clientId);
+    // Over the ingress cap: the client was sent SET_FPS `fps`
+    void clientThrottled(const QString& clientId, int fps);
+    // A viewer's HELLO or SUBSCRIBE named `source` (client id or alias, as
+    // sent); empty for UNSUBSCRIBE. Connect it with setRelaySource().
+    void viewerSubscribed(const QString& viewerId, const QString& source);
+    void viewerDisconnected(const QString& viewerId);
+    // A client gained its first viewer or lost its last one
+    void watchedChanged(const QString& clientId, bool watched);
     // Emit event code + details (details may include {port, reason})
     void serverError(imagesocket::EventCode code, const QVariantMap &details);
 
 private slots:
     void onNewConnection();
     void onSessionDisconnected(const QString& clientId);
+    void onEncodedFrameReceived(const QString& clientId, const EncodedFrame& frame);
+    void onBeastSessionOpened(const QString& clientId, const QHostAddress& address);
+    void onConnectionRejected(const QHostAddress& address);
+    // 0 if a new connection may go on, otherwise how long it should wait (ms)
+    qint64 paceConnection(const QHostAddress& address);
+    void onControlMessageReceived(const QString& clientId, const ControlMessagePtr& message);
+    void onUdpChannelOpened(const QString& clientId, quint16 port, quint32 key);
+    void onFrameRefused(const QString& clientId, quint16 streamId, bool keyframeNeeded);
+    // Ingress cap pass over every client
+    void evaluateIngress();
+    // Layer bitrates of every simulcast client, then their layer picks
+    void evaluateSimulcast();
 
 private:
+    void reportStartFailure(quint16 port, const QString& reason);
+    // Certificate and key of setTls() on the Qt server (SecureMode)
+    bool configureQtTls(QString& error);
+    // A new client gets kHelloWaitMs to open with HELLO (answered with CONFIG by
+    // the bridge); anything else first, or nothing, makes it a legacy client,
+    // greeted with REQUEST_ALIAS and FRAME_HEADER
+    void awaitHello(const QString& clientId);
+    void greetClient(const QString& clientId);
+    // HELLO offered a shared-memory ring: the session reads frames from it too (same host only)
+    void attachSharedMemory(const QString& clientId, const QString& ringName);
+    // Connection closed: clientDisconnected() for each of its extra streams
+    void removeSubstreams(const QString& clientId);
+    // HELLO with role VIEWER: the session becomes a viewer
+    void startViewer(const QString& clientId, int depth, OutboundDropPolicy policy);
+    // Control from a viewer: SUBSCRIBE / UNSUBSCRIBE, the rest is ignored
+    void onViewerControl(const QString& viewerId, const imagesocket::control::ControlMessage& msg);
+    // Forward a source's frame to its viewers (of a simulcast source: those watching `layer`)
+    void relayFrame(const QString& sourceId, const EncodedFrame& frame, int layer = -1);
+    // Viewer's display size and bitrate, from its HELLO / SUBSCRIBE when given
+    void setViewerLimits(const QString& viewerId, const QSize& display, int maxBitrateKbps);
+    // Pick every consumer's layer again; pause the layers nobody takes, resume the others
+    void updateSimulcastLayers(const QString& clientId);
+    // Client gone: its viewers stop, a viewer leaves its source
+    void dropRelays(const QString& clientId);
+    // Beast session: decode its JPEG frames while they arrive when they are decoded at all
+    void updateStreamingDecode(const QString& clientId);
+    // Control for a connection that announced control_batch waits for the end
+    // of this event-loop turn, then goes out with whatever else was sent to it
+    // meanwhile: as it is when alone, else as one ControlBatch message
+    void flushControl();
+    void flushControl(const QString& clientId);
+    void writeControlBatch(const QString& clientId, const QByteArrayList& messages);
+    bool writeControl(const QString& clientId, const QByteArray& serialized, MessagePrefix prefix);
+
+    // Least loaded I/O thread (started on first use), -1 when sessions stay here
+    int pickIoThread();
+
     QWebSocketServer* m_server = nullptr;
-    QVector<QPointer<class ClientSession>> m_sessions;
+    // Sessions live on their I/O thread and are only deleted through deleteLater()
+    // after leaving this map, so the pointers are valid while listed
+    QHash<QString, ClientSession*> m_sessions;
+
+    int m_ioThreadCount = 0;
+    QVector<QThread*> m_ioThreads;
+    QVector<int> m_ioThreadLoad;          // sessions per I/O thread
+    QHash<QString, int> m_sessionThread;  // I/O thread index of each session
+
+    Backend m_backend = Backend::Qt;
+    bool m_reusePort = false;
+    bool m_udpFrames = false;
+    QString m_tlsCert;
+    QString m_tlsKey;
+    KeepaliveConfig m_keepalive;
+    BeastServer* m_beast = nullptr;
+    QSet<QString> m_beastClients;
+
+    QSet<QString> m_awaitingHello;
+
+    QSet<QString> m_controlBatch;                    // connections that take ControlBatch
+    QHash<QString, QByteArrayList> m_pendingControl; // their control of this event-loop turn
+    bool m_controlFlushQueued = false;
+
+    QHash<QString, QHostAddress> m_peerAddress;    // per connection, for its substreams
+    QHash<QString, QSet<quint16>> m_substreams;    // stream ids > 0 seen per connection
+
+    struct Viewer {
+        QString source; // empty while it watches nothing
+        int depth = static_cast<int>(kDefaultRelayDepth);
+        OutboundDropPolicy policy = OutboundDropPolicy::DropOldest;
+        QSize display;              // simulcast: what it shows (empty: full size)
+        double maxBitrateBps = 0.0; // simulcast: what its link takes (0: no limit)
+        int layer = 0;              // simulcast: layer it gets
+    };
+    QHash<QString, Viewer> m_viewers;
+    QHash<QString, QSet<QString>> m_relayTargets; // source client id -> its viewers
+
+    struct Simulcast {
+        SimulcastMeter meter;
+        QSize target;          // display area, from setSimulcastTarget()
+        int displayLayer = 0;
+        QSet<int> pausedLayers;
+    };
+    QHash<QString, Simulcast> m_simulcast; // per connection
+    QTimer* m_simulcastTimer = nullptr;
+
+    AdmissionLimits m_limits;
+    QHash<QString, IngressLimiter> m_ingress; // only while the cap is on
+    AcceptPacer m_acceptPacer;
+    QSet<QString> m_pacedAway;                // Beast connections sent RETRY_AFTER, closing
+    QTimer* m_ingressTimer = nullptr;
+    std::shared_ptr<MemoryBudget> m_memory;
+
+    // Worker pool that turns session payloads into QImages off the GUI thread
+    FrameDecoder* m_decoder = nullptr;
+    QSet<QString> m_decodeEnabled;
+    QHash<QString, QSize> m_decodeTargets; // Beast sessions, for their streaming decode
 };
 
 #endif // WEBSOCKETSERVER_H
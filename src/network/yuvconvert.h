@@ -0,0 +1,123 @@
+#ifndef YUVCONVERT_H
+#define YUVCONVERT_H
+
+#include <cstdint>
+
+// Planar 4:2:0 layouts produced by hardware decoders
+enum class YuvLayout {
+    I420, // Y plane, then U plane, then V plane
+    NV12  // Y plane, then interleaved UV plane
+};
+
+// Non-owning view of a decoded 4:2:0 picture
+struct YuvFrameView {
+    YuvLayout layout = YuvLayout::I420;
+    int width = 0;
+    int height = 0;
+    const std::uint8_t* y = nullptr;
+    const std::uint8_t* u = nullptr; // UV plane for NV12
+    const std::uint8_t* v = nullptr; // unused for NV12
+    int yStride = 0;
+    int uvStride = 0;
+    bool limitedRange = false; // BT.601 video range (Y 16-235) instead of JFIF full range
+};
+
+namespace yuv_detail {
+
+inline std::uint32_t clampByte(int value)
+{
+    return static_cast<std::uint32_t>(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+} // namespace yuv_detail
+
+// Convert to 32-bit 0xffRRGGBB pixels (QImage::Format_RGB32) using BT.601 in
+// 16.16 fixed point: full range (the JFIF colorspace) unless the frame is
+// flagged limitedRange. `dst` must hold height rows of dstStride bytes.
+inline void yuvToRgb32(const YuvFrameView& frame, std::uint8_t* dst, int dstStride)
+{
+    // Luma scale/offset and chroma coefficients (Cr->R, Cb->G, Cr->G, Cb->B)
+    const int yScale = frame.limitedRange ? 76309 : 65536;
+    const int yOffset = frame.limitedRange ? 16 : 0;
+    const int crR = frame.limitedRange ? 104597 : 91881;
+    const int cbG = frame.limitedRange ? 25675 : 22554;
+    const int crG = frame.limitedRange ? 53279 : 46802;
+    const int cbB = frame.limitedRange ? 132201 : 116130;
+
+    for (int row = 0; row < frame.height; ++row) {
+        const std::uint8_t* yRow = frame.y + row * frame.yStride;
+        const std::uint8_t* uRow = frame.u + (row / 2) * frame.uvStride;
+        const std::uint8_t* vRow = frame.layout == YuvLayout::I420 ? frame.v + (row / 2) * frame.uvStride : nullptr;
+        std::uint32_t* out = reinterpret_cast<std::uint32_t*>(dst + row * dstStride);
+
+        for (int col = 0; col < frame.width; ++col) {
+            const int y = ((yRow[col] - yOffset) * yScale + 32768) >> 16;
+            int u, v;
+            if (frame.layout == YuvLayout::I420) {
+                u = uRow[col / 2];
+                v = vRow[col / 2];
+            } else {
+                u = uRow[(col / 2) * 2];
+                v = uRow[(col / 2) * 2 + 1];
+            }
+            const int d = u - 128;
+            const int e = v - 128;
+
+            const int r = y + ((crR * e + 32768) >> 16);
+            const int g = y + ((-cbG * d - crG * e + 32768) >> 16);
+            const int b = y + ((cbB * d + 32768) >> 16);
+            out[col] = 0xFF000000u | (yuv_detail::clampByte(r) << 16)
+                | (yuv_detail::clampByte(g) << 8) | yuv_detail::clampByte(b);
+        }
+    }
+}
+
+// Writable 4:2:0 planes, laid out as in YuvFrameView
+struct YuvPlanes {
+    YuvLayout layout = YuvLayout::I420;
+    std::uint8_t* y = nullptr;
+    std::uint8_t* u = nullptr; // UV plane for NV12
+    std::uint8_t* v = nullptr; // unused for NV12
+    int yStride = 0;
+    int uvStride = 0;
+};
+
+// Convert 24-bit BGR pixels (OpenCV's layout) to full-range BT.601 (JFIF)
+// 4:2:0, the inverse of yuvToRgb32(). Chroma is taken from the mean of each
+// 2x2 block; odd widths and heights repeat the last column and row. `dst`
+// must hold height rows of luma and (height + 1) / 2 rows of chroma.
+inline void bgrToYuv420(const std::uint8_t* bgr, int width, int height, int stride, const YuvPlanes& dst)
+{
+    for (int row = 0; row < height; ++row) {
+        const std::uint8_t* in = bgr + row * stride;
+        std::uint8_t* yRow = dst.y + row * dst.yStride;
+        for (int col = 0; col < width; ++col, in += 3)
+            yRow[col] = static_cast<std::uint8_t>((7471 * in[0] + 38470 * in[1] + 19595 * in[2] + 32768) >> 16);
+    }
+
+    for (int row = 0; row < (height + 1) / 2; ++row) {
+        const std::uint8_t* top = bgr + (2 * row) * stride;
+        const std::uint8_t* bottom = 2 * row + 1 < height ? top + stride : top;
+        std::uint8_t* uRow = dst.u + row * dst.uvStride;
+        std::uint8_t* vRow = dst.layout == YuvLayout::I420 ? dst.v + row * dst.uvStride : nullptr;
+        for (int col = 0; col < (width + 1) / 2; ++col) {
+            const int left = 2 * col * 3;
+            const int right = 2 * col + 1 < width ? left + 3 : left;
+            // Sums of four pixels: the 2x2 mean is folded into the shift below
+            const int b = top[left] + top[right] + bottom[left] + bottom[right];
+            const int g = top[left + 1] + top[right + 1] + bottom[left + 1] + bottom[right + 1];
+            const int r = top[left + 2] + top[right + 2] + bottom[left + 2] + bottom[right + 2];
+            const std::uint32_t u = yuv_detail::clampByte((32768 * b - 21709 * g - 11059 * r + (512 << 16) + 131072) >> 18);
+            const std::uint32_t v = yuv_detail::clampByte((-5329 * b - 27439 * g + 32768 * r + (512 << 16) + 131072) >> 18);
+            if (vRow) {
+                uRow[col] = static_cast<std::uint8_t>(u);
+                vRow[col] = static_cast<std::uint8_t>(v);
+            } else {
+                uRow[2 * col] = static_cast<std::uint8_t>(u);
+                uRow[2 * col + 1] = static_cast<std::uint8_t>(v);
+            }
+        }
+    }
+}
+
+#endif // YUVCONVERT_H
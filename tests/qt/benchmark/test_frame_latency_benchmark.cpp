@@ -0,0 +1,148 @@
+/**
+ * @file test_frame_latency_benchmark.cpp
+ * @brief Qt benchmark - Frame-to-screen latency across client counts
+ *
+ * Sends timestamped frames (frame header + JPEG) through real WebSocket
+ * connections to an ImageServerBridge shown in a QQuickWindow, and measures
+ * per frame of the active client:
+ * - Time until frameIdChanged reaches the GUI thread
+ * - Time until the video surface rendered it (QQuickWindow::afterRendering)
+ *
+ * Runs with 1, 4 and 16 clients (the others stream at the same rate) and
+ * prints one key=value line of percentiles per run:
+ *   latency clients=4 frames=120 notify_p50_ms=1.9 notify_p95_ms=3.1 ...
+ *
+ * IMAGESOCKET_LATENCY_FRAMES overrides the frames measured per run.
+ * Without a window that renders (no OpenGL, no software backend) only the
+ * notify latency is reported.
+ */
+
+#include <QtTest/QtTest>
+#include <QtCore/QObject>
+#include <QtCore/QByteArray>
+#include <QtQuick/QQuickWindow>
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include "../fixtures/qt_test_base.h"
+#include "../fixtures/test_latency_harness.h"
+#include "network/imageserverbridge.h"
+#include "network/videosurfaceitem.h"
+
+namespace {
+
+const int kFrameWidth = 640;
+const int kFrameHeight = 480;
+const int kFramesPerRun = 120;
+const int kFps = 30;
+
+QString formatMs(double ms) {
+    return ms < 0 ? QStringLiteral("n/a") : QString::number(ms, 'f', 2);
+}
+
+}  // namespace
+
+/**
+ * @class TestFrameLatencyBenchmark
+ * @brief Frame-to-screen latency percentiles
+ */
+class TestFrameLatencyBenchmark : public QObject {
+    Q_OBJECT
+
+private:
+    /**
+     * Generate a JPEG frame with OpenCV (gradient, so it compresses like video)
+     */
+    QByteArray generateJpegFrame(int width, int height) {
+        cv::Mat image(height, width, CV_8UC3);
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                image.at<cv::Vec3b>(y, x) = cv::Vec3b(static_cast<uchar>((x * 255) / width),
+                                                      static_cast<uchar>((y * 255) / height),
+                                                      static_cast<uchar>(((x + y) * 255) / (width + height)));
+            }
+        }
+        std::vector<uchar> buffer;
+        if (!cv::imencode(".jpg", image, buffer, {cv::IMWRITE_JPEG_QUALITY, 85}) || buffer.empty()) {
+            return QByteArray();
+        }
+        return QByteArray(reinterpret_cast<const char*>(buffer.data()), static_cast<int>(buffer.size()));
+    }
+
+    int framesPerRun() const {
+        bool ok = false;
+        const int frames = qEnvironmentVariableIntValue("IMAGESOCKET_LATENCY_FRAMES", &ok);
+        return ok && frames > 0 ? frames : kFramesPerRun;
+    }
+
+private slots:
+    void initTestCase() {
+        qt_test::initializeQtTestApp();
+        qRegisterMetaType<QHostAddress>("QHostAddress");
+    }
+
+    void testFrameToScreenLatency_data() {
+        QTest::addColumn<int>("clients");
+        QTest::newRow("1 client") << 1;
+        QTest::newRow("4 clients") << 4;
+        QTest::newRow("16 clients") << 16;
+    }
+
+    /**
+     * Benchmark: latency of the active client's frames under load
+     * Verifies:
+     * - Every client connects and the first one is shown
+     * - Nearly every measured frame is announced within the timeout
+     * Reports notify and render percentiles (p50/p95/p99)
+     */
+    void testFrameToScreenLatency() {
+        QFETCH(int, clients);
+
+        const QByteArray jpeg = generateJpegFrame(kFrameWidth, kFrameHeight);
+        QVERIFY(!jpeg.isEmpty());
+
+        ImageServerBridge bridge;
+        bridge.setPort(0);
+        QVERIFY(bridge.start());
+        QVERIFY(bridge.serverPort() > 0);
+
+        QQuickWindow window;
+        window.resize(kFrameWidth, kFrameHeight);
+        VideoSurfaceItem* surface = new VideoSurfaceItem(window.contentItem());
+        surface->setSize(QSizeF(kFrameWidth, kFrameHeight));
+        surface->setBridge(&bridge);
+        window.show();
+        const bool exposed = QTest::qWaitForWindowExposed(&window, 2000);
+
+        qt_test::FrameLatencyHarness harness(&bridge, exposed ? &window : nullptr);
+        QVERIFY(harness.connectClients(QUrl(QString("ws://127.0.0.1:%1").arg(bridge.serverPort())), clients));
+
+        const int frames = framesPerRun();
+        const qt_test::LatencySamples samples =
+            harness.run(jpeg, QSize(kFrameWidth, kFrameHeight), frames, kFps);
+
+        using qt_test::LatencySamples;
+        qInfo().noquote() << QString("latency clients=%1 frames=%2 notified=%3 rendered=%4"
+                                     " notify_p50_ms=%5 notify_p95_ms=%6 notify_p99_ms=%7"
+                                     " render_p50_ms=%8 render_p95_ms=%9 render_p99_ms=%10")
+                                 .arg(clients)
+                                 .arg(samples.sent)
+                                 .arg(samples.notifyUs.size())
+                                 .arg(samples.renderUs.size())
+                                 .arg(formatMs(LatencySamples::percentileMs(samples.notifyUs, 50)))
+                                 .arg(formatMs(LatencySamples::percentileMs(samples.notifyUs, 95)))
+                                 .arg(formatMs(LatencySamples::percentileMs(samples.notifyUs, 99)))
+                                 .arg(formatMs(LatencySamples::percentileMs(samples.renderUs, 50)))
+                                 .arg(formatMs(LatencySamples::percentileMs(samples.renderUs, 95)))
+                                 .arg(formatMs(LatencySamples::percentileMs(samples.renderUs, 99)));
+
+        QCOMPARE(samples.sent, frames);
+        QVERIFY2(samples.notifyUs.size() * 10 >= samples.sent * 9, "more than 10% of the frames were never shown");
+
+        harness.disconnectClients();
+        bridge.stop();
+        qt_test::EventLoopSpinner::processEventsWithTimeout(100);
+    }
+};
+
+QTEST_MAIN(TestFrameLatencyBenchmark)
+#include "test_frame_latency_benchmark.moc"
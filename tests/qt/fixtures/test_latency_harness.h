@@ -0,0 +1,332 @@
+/**
+ * @file test_latency_harness.h
+ * @brief Frame-to-screen latency harness for Qt benchmarks
+ *
+ * Provides:
+ * - Any number of real WebSocket clients (WebSocketClientFixture) on a bridge
+ * - Timestamped frames (0x04 frame header + JPEG) sent by the active client
+ * - Per-frame latency until frameIdChanged and until the window rendered it
+ * - Background clients streaming at a fixed rate meanwhile
+ * - Percentiles over the samples
+ *
+ * Header-only, no assertions, no production logic
+ *
+ * Usage:
+ *   qt_test::FrameLatencyHarness harness(&bridge, &window);
+ *   harness.connectClients(url, 4);
+ *   qt_test::LatencySamples samples = harness.run(jpeg, QSize(640, 480), 200, 30);
+ *   double p99 = qt_test::LatencySamples::percentileMs(samples.notifyUs, 99);
+ */
+
+#ifndef TEST_LATENCY_HARNESS_H
+#define TEST_LATENCY_HARNESS_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QEventLoop>
+#include <QtCore/QObject>
+#include <QtCore/QPointer>
+#include <QtCore/QSize>
+#include <QtCore/QTimer>
+#include <QtCore/QUrl>
+#include <QtCore/QVector>
+#include <QtQuick/QQuickWindow>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include "test_websocket_client.h"
+#include "network/encodedframe.h"
+#include "network/frameheader.h"
+#include "network/imageserverbridge.h"
+
+/**
+ * @namespace qt_test
+ * @brief Common Qt test utilities
+ */
+namespace qt_test {
+
+/**
+ * @struct LatencySamples
+ * @brief Latencies of one run, in microseconds from the moment a frame was sent
+ */
+struct LatencySamples {
+    QVector<qint64> notifyUs;  ///< Until frameIdChanged reached the GUI thread
+    QVector<qint64> renderUs;  ///< Until afterRendering of the frame (empty when the window never rendered)
+    int sent = 0;              ///< Frames sent by the measured client
+
+    /**
+     * Nearest-rank percentile
+     * @param samples Latencies in microseconds
+     * @param percentile 0-100
+     * @return Milliseconds, or -1 without samples
+     */
+    static double percentileMs(QVector<qint64> samples, double percentile) {
+        if (samples.isEmpty()) {
+            return -1.0;
+        }
+        std::sort(samples.begin(), samples.end());
+        const int rank = static_cast<int>(std::ceil(percentile / 100.0 * samples.size()));
+        return samples[qBound(0, rank - 1, samples.size() - 1)] / 1000.0;
+    }
+};
+
+/**
+ * @class FrameLatencyHarness
+ * @brief Measures how long a received frame takes to reach the UI
+ *
+ * The first client connected becomes the bridge's active client and is
+ * measured in lockstep: it sends one frame, the harness waits until the
+ * bridge announced it (frameIdChanged) and, with a window, until the window
+ * rendered it, then sends the next one on the frame period. The other
+ * clients stream the same frame at that rate to load the server.
+ *
+ * Rendering is attributed to a frame when the scene graph synchronizes
+ * after the bridge published it (beforeSynchronizing, GUI thread blocked)
+ * and stamped in afterRendering. Both run on the render thread, so the
+ * state they share is atomic.
+ *
+ * Timestamps come from EncodedFrame::nowUs(), the clock the frame header
+ * carries as capture time.
+ */
+class FrameLatencyHarness {
+public:
+    /**
+     * Create harness
+     * @param bridge Started bridge the clients connect to
+     * @param window Window showing a VideoSurfaceItem bound to the bridge (nullptr: notify only)
+     */
+    explicit FrameLatencyHarness(ImageServerBridge* bridge, QQuickWindow* window = nullptr)
+        : m_bridge(bridge),
+          m_window(window) {
+        QObject::connect(m_bridge, &ImageServerBridge::frameIdChanged, &m_context, [this](int) {
+            if (m_notifiedAtUs == 0 && m_sentAtUs > 0) {
+                m_notifiedAtUs = EncodedFrame::nowUs();
+            }
+            wake();
+        });
+        if (!m_window) {
+            return;
+        }
+        QObject::connect(m_bridge, &ImageServerBridge::newFrameReady, &m_context, [this](const QImage&) {
+            m_published.store(m_sequence, std::memory_order_release);
+        });
+        QObject::connect(m_window, &QQuickWindow::beforeSynchronizing, &m_context, [this]() {
+            m_syncing.store(m_published.load(std::memory_order_acquire), std::memory_order_relaxed);
+        }, Qt::DirectConnection);
+        QObject::connect(m_window, &QQuickWindow::afterRendering, &m_context, [this]() {
+            const quint32 syncing = m_syncing.load(std::memory_order_relaxed);
+            if (syncing == 0 || syncing == m_rendered.load(std::memory_order_relaxed)) {
+                return;
+            }
+            m_renderedAtUs.store(EncodedFrame::nowUs(), std::memory_order_relaxed);
+            m_rendered.store(syncing, std::memory_order_release);
+            QMetaObject::invokeMethod(&m_context, [this]() { wake(); }, Qt::QueuedConnection);
+        }, Qt::DirectConnection);
+    }
+
+    /**
+     * Destructor disconnects all clients
+     */
+    ~FrameLatencyHarness() {
+        disconnectClients();
+    }
+
+    /**
+     * No copying
+     */
+    FrameLatencyHarness(const FrameLatencyHarness&) = delete;
+    FrameLatencyHarness& operator=(const FrameLatencyHarness&) = delete;
+
+    /**
+     * Connect clients; the first one becomes the measured (active) client
+     * @param url Server URL
+     * @param count Clients in total
+     * @param timeout_ms Maximum time for all of them
+     * @return True if all connected and the first one is active
+     */
+    bool connectClients(const QUrl& url, int count, int timeout_ms = 5000) {
+        QTimer deadline;
+        deadline.setSingleShot(true);
+        deadline.start(timeout_ms);
+        for (int i = 0; i < count; ++i) {
+            WebSocketClientFixture* client = new WebSocketClientFixture();
+            m_clients.append(client);
+            QEventLoop loop;
+            QObject::connect(client, &WebSocketClientFixture::connected, &loop, &QEventLoop::quit);
+            QObject::connect(&deadline, &QTimer::timeout, &loop, &QEventLoop::quit);
+            client->connect(url);
+            if (!client->isConnected() && deadline.isActive()) {
+                loop.exec();
+            }
+            if (!client->isConnected()) {
+                return false;
+            }
+            // The bridge makes the first client it registers active: wait
+            // for it before the others connect
+            while (i == 0 && m_bridge->activeClient().isEmpty() && deadline.isActive()) {
+                QEventLoop active;
+                QObject::connect(m_bridge, &ImageServerBridge::activeClientChanged, &active, &QEventLoop::quit);
+                QObject::connect(&deadline, &QTimer::timeout, &active, &QEventLoop::quit);
+                active.exec();
+            }
+            if (m_bridge->activeClient().isEmpty()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Disconnect and delete all clients
+     */
+    void disconnectClients() {
+        for (WebSocketClientFixture* client : m_clients) {
+            client->disconnect();
+            client->deleteLater();
+        }
+        m_clients.clear();
+    }
+
+    /**
+     * Number of clients (measured one included)
+     */
+    int clientCount() const {
+        return m_clients.size();
+    }
+
+    /**
+     * Measure `frames` frames of the active client
+     * @param jpeg Frame payload
+     * @param size Frame size, written to the header
+     * @param frames Frames to send
+     * @param fps Frame rate of every client
+     * @param frame_timeout_ms Longest wait for one frame; a frame still
+     *        missing then is left out of the samples
+     * @return Samples in microseconds
+     */
+    LatencySamples run(const QByteArray& jpeg, const QSize& size, int frames, int fps, int frame_timeout_ms = 1000) {
+        LatencySamples samples;
+        if (m_clients.isEmpty() || frames <= 0) {
+            return samples;
+        }
+        const int periodMs = 1000 / qMax(1, fps);
+        bool renders = m_window != nullptr;
+
+        // Background clients keep streaming for the whole run
+        quint32 backgroundSequence = 0;
+        QTimer background;
+        background.setInterval(periodMs);
+        QObject::connect(&background, &QTimer::timeout, &m_context, [&]() {
+            const QByteArray frame = framedJpeg(jpeg, size, ++backgroundSequence);
+            for (int i = 1; i < m_clients.size(); ++i) {
+                m_clients[i]->sendBinaryMessage(frame);
+            }
+        });
+        if (m_clients.size() > 1) {
+            background.start();
+        }
+
+        for (int i = 0; i < frames; ++i) {
+            const quint32 sequence = ++m_sequence;
+            const quint32 renderedBefore = m_rendered.load(std::memory_order_acquire);
+            m_notifiedAtUs = 0;
+            m_sentAtUs = EncodedFrame::nowUs();
+            if (!m_clients.first()->sendBinaryMessage(framedJpeg(jpeg, size, sequence))) {
+                break;
+            }
+            ++samples.sent;
+
+            const auto rendered = [&]() { return m_rendered.load(std::memory_order_acquire) == sequence; };
+            waitUntil([&]() { return m_notifiedAtUs > 0 && (!renders || rendered()); }, frame_timeout_ms);
+            if (m_notifiedAtUs > 0) {
+                samples.notifyUs.append(m_notifiedAtUs - m_sentAtUs);
+            }
+            if (renders && rendered()) {
+                samples.renderUs.append(m_renderedAtUs.load(std::memory_order_relaxed) - m_sentAtUs);
+            } else if (renders && m_rendered.load(std::memory_order_acquire) == renderedBefore && i == 0) {
+                renders = false; // the window never renders (no GL, hidden): notify only
+            }
+
+            // Hold the frame period
+            const qint64 remainingMs = periodMs - (EncodedFrame::nowUs() - m_sentAtUs) / 1000;
+            m_sentAtUs = 0;
+            if (remainingMs > 0) {
+                waitUntil([]() { return false; }, static_cast<int>(remainingMs));
+            }
+        }
+        background.stop();
+        return samples;
+    }
+
+    /**
+     * Frame as a client sends it with FRAME_HEADER: 0x04, header, JPEG
+     * @param jpeg JPEG payload
+     * @param size Frame size
+     * @param sequence Frame sequence number
+     */
+    static QByteArray framedJpeg(const QByteArray& jpeg, const QSize& size, quint32 sequence) {
+        FrameHeader header;
+        header.payload = FramePayload::Jpeg;
+        header.keyframe = true;
+        header.sequence = sequence;
+        header.captureTimeUs = EncodedFrame::nowUs();
+        header.width = size.width();
+        header.height = size.height();
+
+        QByteArray message(1 + static_cast<int>(kFrameHeaderSize) + jpeg.size(), Qt::Uninitialized);
+        message[0] = 0x04;
+        writeFrameHeader(header, reinterpret_cast<std::uint8_t*>(message.data() + 1));
+        std::copy(jpeg.constBegin(), jpeg.constEnd(), message.begin() + 1 + static_cast<int>(kFrameHeaderSize));
+        return message;
+    }
+
+private:
+    /**
+     * Run the event loop until `done` holds or `timeout_ms` elapsed
+     */
+    template <typename Predicate>
+    void waitUntil(Predicate done, int timeout_ms) {
+        if (done()) {
+            return;
+        }
+        QEventLoop loop;
+        m_loop = &loop;
+        QTimer::singleShot(timeout_ms, &loop, &QEventLoop::quit);
+        m_done = done;
+        loop.exec();
+        m_loop = nullptr;
+        m_done = nullptr;
+    }
+
+    /**
+     * Re-check the pending wait (GUI thread)
+     */
+    void wake() {
+        if (m_loop && m_done && m_done()) {
+            m_loop->quit();
+        }
+    }
+
+    QPointer<ImageServerBridge> m_bridge;
+    QPointer<QQuickWindow> m_window;
+    QObject m_context;  ///< Owns the harness' connections
+    QVector<WebSocketClientFixture*> m_clients;
+
+    QEventLoop* m_loop = nullptr;
+    std::function<bool()> m_done;
+
+    // GUI thread
+    quint32 m_sequence = 0;     ///< Last frame sent by the measured client
+    qint64 m_sentAtUs = 0;      ///< When it was sent (0: nothing pending)
+    qint64 m_notifiedAtUs = 0;  ///< When frameIdChanged followed
+
+    // Shared with the render thread
+    std::atomic<quint32> m_published{0};   ///< Frame the bridge handed to the surface
+    std::atomic<quint32> m_syncing{0};     ///< Frame the scene graph synchronized
+    std::atomic<quint32> m_rendered{0};    ///< Last frame rendered
+    std::atomic<qint64> m_renderedAtUs{0};
+};
+
+}  // namespace qt_test
+
+#endif  // TEST_LATENCY_HARNESS_H
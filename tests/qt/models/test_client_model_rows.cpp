@@ -340,6 +340,37 @@ private slots:
         QCOMPARE(model.indexOfClient("client-003"), 2);
     }
 
+    /**
+     * Test: indexOfClient stays correct when rows shift
+     * Verifies:
+     * - Clients after a removed row move up one index
+     * - The removed client is no longer found
+     * - A client added afterwards gets the last row, clear() forgets everyone
+     */
+    void testIndexOfClientAfterRemoval() {
+        ClientModel model;
+
+        model.addClient("client-001");
+        model.addClient("client-002");
+        model.addClient("client-003");
+        model.addClient("client-004");
+        model.removeClient("client-002");
+
+        QCOMPARE(model.indexOfClient("client-001"), 0);
+        QCOMPARE(model.indexOfClient("client-002"), -1);
+        QCOMPARE(model.indexOfClient("client-003"), 1);
+        QCOMPARE(model.indexOfClient("client-004"), 2);
+        QCOMPARE(model.clientIdAt(model.indexOfClient("client-004")), QString("client-004"));
+
+        model.addClient("client-002");
+        QCOMPARE(model.indexOfClient("client-002"), 3);
+
+        model.clear();
+        QCOMPARE(model.indexOfClient("client-001"), -1);
+        model.addClient("client-003");
+        QCOMPARE(model.indexOfClient("client-003"), 0);
+    }
+
     /**
      * Test: Model behaves correctly with duplicate add attempts
      * Verifies:
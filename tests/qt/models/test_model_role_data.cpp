@@ -102,7 +102,7 @@ private slots:
      * Test: MeasuredFpsRole data accessible
      * Verifies:
      * - data(index(0), MeasuredFpsRole) returns FPS value
-     * - MeasuredFps is integer >= 0
+     * - MeasuredFps is >= 0
      * - Role is accessible
      */
     void testMeasuredFpsRoleDataAccessible() {
@@ -112,7 +112,7 @@ private slots:
         
         QVariant fps_data = model.data(model.index(0, 0), ClientModel::MeasuredFpsRole);
         QVERIFY(fps_data.isValid());
-        QVERIFY(fps_data.toInt() >= 0);
+        QVERIFY(fps_data.toDouble() >= 0.0);
     }
 
     /**
@@ -212,12 +212,12 @@ private slots:
         
         QVariant fps_data = model.data(model.index(0, 0), ClientModel::MeasuredFpsRole);
         QVERIFY(fps_data.isValid());
-        int fps = fps_data.toInt();
-        QVERIFY(fps >= 0);
+        double fps = fps_data.toDouble();
+        QVERIFY(fps >= 0.0);
         
         // Verify via method
-        int fps_via_method = model.measuredFpsAt(0);
-        QVERIFY(fps_via_method >= 0);
+        double fps_via_method = model.measuredFpsAt(0);
+        QVERIFY(fps_via_method >= 0.0);
     }
 
     /**
@@ -242,6 +242,242 @@ private slots:
         QVERIFY(roles.contains(ClientModel::MeasuredFpsRole));
     }
 
+    /**
+     * Test: Rate controller stats exposed through roles
+     * Verifies:
+     * - Quality/throughput/queue delay default to unmeasured values
+     * - setClientRateStats() updates all three roles
+     * - dataChanged is only emitted when a value changes
+     */
+    void testRateStatsRoles() {
+        ClientModel model;
+        model.addClient("client-001");
+        QModelIndex idx = model.index(0, 0);
+
+        QCOMPARE(model.data(idx, ClientModel::QualityRole).toInt(), 0);
+        QCOMPARE(model.data(idx, ClientModel::ThroughputKbpsRole).toInt(), 0);
+        QCOMPARE(model.data(idx, ClientModel::QueueDelayMsRole).toInt(), -1);
+
+        QSignalSpy spy(&model, &QAbstractItemModel::dataChanged);
+        model.setClientRateStats("client-001", 65, 1200, 40);
+        QCOMPARE(spy.count(), 1);
+        QCOMPARE(model.data(idx, ClientModel::QualityRole).toInt(), 65);
+        QCOMPARE(model.qualityAt(0), 65);
+        QCOMPARE(model.data(idx, ClientModel::ThroughputKbpsRole).toInt(), 1200);
+        QCOMPARE(model.data(idx, ClientModel::QueueDelayMsRole).toInt(), 40);
+
+        model.setClientRateStats("client-001", 65, 1200, 40);
+        QCOMPARE(spy.count(), 1);
+    }
+
+    /**
+     * Test: recordThumbnail bumps ThumbnailIdRole
+     * Verifies:
+     * - thumbnailId starts at 0 (no thumbnail yet)
+     * - Each thumbnail increments it and emits dataChanged
+     */
+    void testRecordThumbnailBumpsId() {
+        ClientModel model;
+        model.addClient("client-001");
+        QModelIndex idx = model.index(0, 0);
+        QCOMPARE(model.data(idx, ClientModel::ThumbnailIdRole).toInt(), 0);
+
+        QSignalSpy spy(&model, &QAbstractItemModel::dataChanged);
+        model.recordThumbnail("client-001");
+        model.recordThumbnail("client-001");
+        QCOMPARE(spy.count(), 2);
+        QCOMPARE(model.data(idx, ClientModel::ThumbnailIdRole).toInt(), 2);
+
+        model.recordThumbnail("unknown");
+        QCOMPARE(spy.count(), 2);
+    }
+
+    /**
+     * Test: setClientCodec updates CodecRole
+     * Verifies:
+     * - Clients start on MJPEG
+     * - A change emits dataChanged once; repeating it is a no-op
+     */
+    void testSetClientCodecUpdatesRole() {
+        ClientModel model;
+        model.addClient("client-001");
+        QModelIndex idx = model.index(0, 0);
+        QCOMPARE(model.data(idx, ClientModel::CodecRole).toString(), QString("MJPEG"));
+
+        QSignalSpy spy(&model, &QAbstractItemModel::dataChanged);
+        model.setClientCodec("client-001", "H.264");
+        model.setClientCodec("client-001", "H.264");
+        QCOMPARE(spy.count(), 1);
+        QCOMPARE(model.data(idx, ClientModel::CodecRole).toString(), QString("H.264"));
+    }
+
+    /**
+     * Test: setClientLatency updates the latency roles
+     * Verifies:
+     * - End-to-end percentiles are -1 until measured
+     * - They are taken from the "endToEnd" entry of the stage map
+     * - Setting the same map again is a no-op
+     */
+    void testSetClientLatencyUpdatesRoles() {
+        ClientModel model;
+        model.addClient("client-001");
+        QModelIndex idx = model.index(0, 0);
+        QCOMPARE(model.data(idx, ClientModel::LatencyP50MsRole).toDouble(), -1.0);
+
+        QVariantMap endToEnd;
+        endToEnd["p50"] = 42.5;
+        endToEnd["p99"] = 80.0;
+        QVariantMap decode;
+        decode["p50"] = 3.0;
+        decode["p99"] = 6.0;
+        QVariantMap latency;
+        latency["endToEnd"] = endToEnd;
+        latency["decode"] = decode;
+
+        QSignalSpy spy(&model, &QAbstractItemModel::dataChanged);
+        model.setClientLatency("client-001", latency);
+        model.setClientLatency("client-001", latency);
+        QCOMPARE(spy.count(), 1);
+        QCOMPARE(model.data(idx, ClientModel::LatencyP50MsRole).toDouble(), 42.5);
+        QCOMPARE(model.data(idx, ClientModel::LatencyP99MsRole).toDouble(), 80.0);
+        QCOMPARE(model.data(idx, ClientModel::LatencyRole).toMap().value("decode").toMap().value("p99").toDouble(), 6.0);
+    }
+
+    /**
+     * Test: setClientClock updates the RTT and clock offset roles
+     * Verifies:
+     * - RTT is -1 and the offset 0 until a PING/PONG completed
+     * - Only changed roles are reported; repeating the values is a no-op
+     */
+    void testSetClientClockUpdatesRoles() {
+        ClientModel model;
+        model.addClient("client-001");
+        QModelIndex idx = model.index(0, 0);
+        QCOMPARE(model.data(idx, ClientModel::RttMsRole).toDouble(), -1.0);
+        QCOMPARE(model.data(idx, ClientModel::ClockOffsetMsRole).toDouble(), 0.0);
+
+        QSignalSpy spy(&model, &QAbstractItemModel::dataChanged);
+        model.setClientClock("client-001", 12.5, -340.0);
+        model.setClientClock("client-001", 12.5, -340.0);
+        QCOMPARE(spy.count(), 1);
+        QCOMPARE(model.data(idx, ClientModel::RttMsRole).toDouble(), 12.5);
+        QCOMPARE(model.data(idx, ClientModel::ClockOffsetMsRole).toDouble(), -340.0);
+
+        model.setClientClock("client-001", 14.0, -340.0);
+        QCOMPARE(spy.count(), 2);
+        QCOMPARE(spy.at(1).at(2).value<QVector<int>>(), QVector<int>{ClientModel::RttMsRole});
+    }
+
+    /**
+     * Test: Renaming a client keeps its row
+     * Verifies:
+     * - The row answers to the new id only, with IdRole updated
+     * - Alias and configured FPS carry over
+     * - Unknown or taken ids are refused
+     */
+    void testRenameClientKeepsRow() {
+        ClientModel model;
+        model.addClient("client-001");
+        model.addClient("client-002");
+        model.setClientAlias("client-001", "Camera");
+        model.setClientConfiguredFps("client-001", 24);
+
+        QSignalSpy spy(&model, &QAbstractItemModel::dataChanged);
+        QVERIFY(model.renameClient("client-001", "client-003"));
+        QCOMPARE(model.rowCount(), 2);
+        QCOMPARE(model.indexOfClient("client-001"), -1);
+        QCOMPARE(model.indexOfClient("client-003"), 0);
+        QCOMPARE(model.data(model.index(0, 0), ClientModel::IdRole).toString(), QString("client-003"));
+        QCOMPARE(model.aliasAt(0), QString("Camera"));
+        QCOMPARE(model.configuredFpsAt(0), 24);
+        QCOMPARE(spy.count(), 1);
+
+        QVERIFY(!model.renameClient("client-001", "client-004"));
+        QVERIFY(!model.renameClient("client-003", "client-002"));
+    }
+
+    /**
+     * Test: Rates are published every 250 ms, the other traffic statistics when the window closes
+     * Verifies:
+     * - The roles start unmeasured (-1)
+     * - Fractional fps and bytes/s come from the sliding window, only when they change
+     * - Frame size, decode time and jitter come out when the 1 s window closes
+     * - Queue depth updates on its own, only when it changes
+     */
+    void testTrafficStatsRoles() {
+        ClientModel model;
+        model.addClient("client-001");
+        QModelIndex idx = model.index(0, 0);
+        QCOMPARE(model.data(idx, ClientModel::BytesPerSecondRole).toInt(), -1);
+        QCOMPARE(model.data(idx, ClientModel::DecodeMsRole).toDouble(), -1.0);
+        QCOMPARE(model.data(idx, ClientModel::QueueDepthRole).toInt(), -1);
+
+        QSignalSpy spy(&model, &QAbstractItemModel::dataChanged);
+        // 11 frames of 1000 bytes: gaps of 100 ms, one of 120 ms
+        const qint64 start = 1000000;
+        const qint64 arrivals[] = {0, 100, 200, 300, 400, 500, 600, 700, 800, 920, 1020};
+        for (qint64 at : arrivals) {
+            model.recordFrameReceived("client-001", start + at, 1000);
+            model.recordFrameDecoded("client-001", 4000);
+        }
+        // Rates at 300 ms (10 fps), unchanged at 600, 9.5 fps at 920; the window at 1020
+        QCOMPARE(spy.count(), 3);
+        const QVector<int> rateRoles = spy.at(0).at(2).value<QVector<int>>();
+        QVERIFY(rateRoles.contains(ClientModel::MeasuredFpsRole));
+        QVERIFY(rateRoles.contains(ClientModel::BytesPerSecondRole));
+        const QVector<int> windowRoles = spy.at(2).at(2).value<QVector<int>>();
+        QVERIFY(windowRoles.contains(ClientModel::AvgFrameBytesRole));
+        QVERIFY(windowRoles.contains(ClientModel::JitterMsRole));
+        QVERIFY(!windowRoles.contains(ClientModel::MeasuredFpsRole));
+        // 4 intervals of the last 500 ms over 420 ms
+        QCOMPARE(model.data(idx, ClientModel::MeasuredFpsRole).toDouble(), 9.5);
+        QCOMPARE(model.measuredFpsAt(0), 9.5);
+        QCOMPARE(model.data(idx, ClientModel::BytesPerSecondRole).toInt(), 4 * 1000 * 1000 / 420);
+        // The frame that closes the window counts; its decode is in the next one
+        QCOMPARE(model.data(idx, ClientModel::AvgFrameBytesRole).toInt(), 1000);
+        QCOMPARE(model.data(idx, ClientModel::DecodeMsRole).toDouble(), 4.0);
+        QVERIFY(model.data(idx, ClientModel::JitterMsRole).toDouble() > 0.0);
+
+        model.setClientQueueDepth("client-001", 3);
+        model.setClientQueueDepth("client-001", 3);
+        QCOMPARE(spy.count(), 4);
+        QCOMPARE(model.data(idx, ClientModel::QueueDepthRole).toInt(), 3);
+    }
+
+    /**
+     * Test: With an update interval, changes are coalesced
+     * Verifies:
+     * - Nothing is emitted while updates are collected; data() is already current
+     * - One dataChanged covers the changed rows with the union of the roles
+     * - flushChanges() with nothing pending emits nothing
+     */
+    void testCoalescedUpdatesEmitOneRange() {
+        ClientModel model;
+        model.addClient("client-001");
+        model.addClient("client-002");
+        model.addClient("client-003");
+        model.setUpdateIntervalMs(1000);
+
+        QSignalSpy spy(&model, &QAbstractItemModel::dataChanged);
+        model.recordFramesDropped("client-001", 2);
+        model.recordFramesDropped("client-001", 1);
+        model.setClientCodec("client-002", "H264");
+        QCOMPARE(spy.count(), 0);
+        QCOMPARE(model.droppedFramesAt(0), 3);
+
+        model.flushChanges();
+        QCOMPARE(spy.count(), 1);
+        QCOMPARE(spy.at(0).at(0).toModelIndex().row(), 0);
+        QCOMPARE(spy.at(0).at(1).toModelIndex().row(), 1);
+        const QVector<int> roles = spy.at(0).at(2).value<QVector<int>>();
+        QCOMPARE(roles.size(), 2);
+        QVERIFY(roles.contains(ClientModel::DroppedFramesRole));
+        QVERIFY(roles.contains(ClientModel::CodecRole));
+
+        model.flushChanges();
+        QCOMPARE(spy.count(), 1);
+    }
+
     /**
      * Test: Role data correct for multiple clients
      * Verifies:
@@ -334,10 +570,8 @@ private slots:
         
         model.addClient("client-001");
         
-        qint64 now = QDateTime::currentMSecsSinceEpoch();
-        
-        // Record a frame
-        model.recordFrameReceived("client-001", now);
+        // Record a frame (timestamps are on the model's monotonic clock)
+        model.recordFrameReceived("client-001", ClientModel::monotonicMs());
         
         // Process events
         qt_test::EventLoopSpinner::processEventsWithTimeout(100);
@@ -346,8 +580,8 @@ private slots:
         QCOMPARE(model.rowCount(), 1);
         
         // Measured FPS should be accessible
-        int fps = model.measuredFpsAt(0);
-        QVERIFY(fps >= 0);
+        double fps = model.measuredFpsAt(0);
+        QVERIFY(fps >= 0.0);
     }
 
     /**
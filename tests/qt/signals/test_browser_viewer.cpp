@@ -0,0 +1,177 @@
+/**
+ * @file test_browser_viewer.cpp
+ * @brief Qt signal tests - Browser viewer endpoint
+ *
+ * Tests the BrowserViewer that shows the received JPEG streams in a browser:
+ * - Page, client list and status codes
+ * - /stream parts are the JPEG payloads as published on the bus, other formats skipped
+ * - /snapshot serves the latest cached JPEG with an ETag and 304 for a matching If-None-Match
+ * - The bridge serves it with startBrowserViewer()
+ */
+
+#include <QtTest/QtTest>
+#include <QtCore/QObject>
+#include <QtNetwork/QTcpSocket>
+#include <memory>
+#include "../fixtures/qt_test_base.h"
+#include "network/browserviewer.h"
+#include "network/framebus.h"
+#include "network/snapshotcache.h"
+#include "network/imageserverbridge.h"
+#include "network/streammetrics.h"
+
+/**
+ * @class TestBrowserViewer
+ * @brief Tests for the page, /clients and the MJPEG /stream
+ */
+class TestBrowserViewer : public QObject {
+    Q_OBJECT
+
+private:
+    static BusFrame busFrame(const QString& clientId, EncodedFrame::Format format, const QByteArray& payload) {
+        QByteArray message(1, char(format == EncodedFrame::RawYuv ? 0x02 : 0x00));
+        message.append(payload);
+        BusFrame frame;
+        frame.kind = BusFrame::Encoded;
+        frame.clientId = clientId;
+        frame.encoded = EncodedFrame::fromMessage(message, 1, format);
+        return frame;
+    }
+
+private slots:
+    void initTestCase() {
+        qt_test::initializeQtTestApp();
+    }
+
+    /**
+     * Test: Requests other than a stream
+     * Verifies:
+     * - / is the HTML page, /clients the ids and aliases as JSON
+     * - Unknown paths and clients are 404, other methods 405, garbage 400
+     * - A stream of a client found by alias names its id and opens a multipart response
+     */
+    void testResponses() {
+        StreamMetrics metrics;
+        metrics.addClient("c1");
+        metrics.setAlias("c1", "door");
+        SnapshotCache snapshots;
+        QString client;
+
+        QByteArray response = BrowserViewer::respond("GET / HTTP/1.1\r\n\r\n", metrics, snapshots, &client);
+        QVERIFY(response.startsWith("HTTP/1.1 200"));
+        QVERIFY(response.contains("text/html"));
+        response = BrowserViewer::respond("GET /clients HTTP/1.1\r\n\r\n", metrics, snapshots, &client);
+        QVERIFY(response.endsWith("[{\"alias\":\"door\",\"id\":\"c1\"}]"));
+        QVERIFY(client.isEmpty());
+
+        QVERIFY(BrowserViewer::respond("GET /x HTTP/1.1\r\n\r\n", metrics, snapshots, &client).startsWith("HTTP/1.1 404"));
+        QVERIFY(BrowserViewer::respond("GET /stream?client=c2 HTTP/1.1\r\n\r\n", metrics, snapshots, &client).startsWith("HTTP/1.1 404"));
+        QVERIFY(BrowserViewer::respond("POST / HTTP/1.1\r\n\r\n", metrics, snapshots, &client).startsWith("HTTP/1.1 405"));
+        QVERIFY(BrowserViewer::respond("hello\r\n\r\n", metrics, snapshots, &client).startsWith("HTTP/1.1 400"));
+        QVERIFY(client.isEmpty());
+
+        response = BrowserViewer::respond("GET /stream?client=door HTTP/1.1\r\n\r\n", metrics, snapshots, &client);
+        QVERIFY(response.contains("Content-Type: multipart/x-mixed-replace; boundary="));
+        QVERIFY(!response.contains("Content-Length"));
+        QCOMPARE(client, QString("c1"));
+    }
+
+    /**
+     * Test: Snapshots of the latest JPEG
+     * Verifies:
+     * - Only JPEG frames are cached, each store bumps the version
+     * - The body is the payload byte for byte, with ETag and X-Frame-Sequence
+     * - If-None-Match with the current ETag is 304 without a body, an older one is 200
+     * - No frame yet (or unknown client) is 404
+     */
+    void testSnapshots() {
+        StreamMetrics metrics;
+        metrics.addClient("c1");
+        metrics.setAlias("c1", "door");
+        SnapshotCache snapshots;
+        QString client;
+        const QByteArray request("GET /snapshot?client=door HTTP/1.1\r\n\r\n");
+
+        QVERIFY(BrowserViewer::respond(request, metrics, snapshots, &client).startsWith("HTTP/1.1 404"));
+        QVERIFY(!snapshots.store("c1", busFrame("c1", EncodedFrame::RawYuv, "raw-planes").encoded));
+        QVERIFY(snapshots.store("c1", busFrame("c1", EncodedFrame::Jpeg, "first").encoded));
+        EncodedFrame latest = busFrame("c1", EncodedFrame::Jpeg, "latest-jpeg").encoded;
+        latest.sequence = 42;
+        QVERIFY(snapshots.store("c1", latest));
+        QCOMPARE(snapshots.size(), 1);
+
+        QByteArray response = BrowserViewer::respond(request, metrics, snapshots, &client);
+        QVERIFY(response.startsWith("HTTP/1.1 200"));
+        QVERIFY(response.contains("Content-Type: image/jpeg\r\nContent-Length: 11\r\n"));
+        QVERIFY(response.contains("ETag: \"2\"\r\n"));
+        QVERIFY(response.contains("X-Frame-Sequence: 42\r\n"));
+        QVERIFY(response.endsWith("\r\n\r\nlatest-jpeg"));
+        QVERIFY(client.isEmpty());
+
+        response = BrowserViewer::respond("GET /snapshot?client=c1 HTTP/1.1\r\nif-none-match: \"2\"\r\n\r\n",
+                                          metrics, snapshots, &client);
+        QVERIFY(response.startsWith("HTTP/1.1 304"));
+        QVERIFY(!response.contains("latest-jpeg"));
+        response = BrowserViewer::respond("GET /snapshot?client=c1 HTTP/1.1\r\nIf-None-Match: \"1\"\r\n\r\n",
+                                          metrics, snapshots, &client);
+        QVERIFY(response.startsWith("HTTP/1.1 200"));
+
+        snapshots.remove("c1");
+        QVERIFY(BrowserViewer::respond(request, metrics, snapshots, &client).startsWith("HTTP/1.1 404"));
+    }
+
+    /**
+     * Test: A stream carries the client's JPEG payloads as published
+     * Verifies:
+     * - Each part is a boundary, image/jpeg headers and the payload byte for byte
+     * - Raw frames and other clients' frames are not sent
+     * - The connection counts as a stream until the browser leaves
+     */
+    void testStreamsJpegPayloads() {
+        FrameBus bus;
+        auto metrics = std::make_shared<StreamMetrics>();
+        metrics->addClient("c1");
+        metrics->addClient("c2");
+        BrowserViewer viewer(&bus, metrics, std::make_shared<SnapshotCache>());
+        QVERIFY(viewer.start(0, QHostAddress::LocalHost));
+
+        QTcpSocket socket;
+        socket.connectToHost(QHostAddress::LocalHost, viewer.port());
+        QVERIFY(socket.waitForConnected(2000));
+        socket.write("GET /stream?client=c1 HTTP/1.1\r\nHost: localhost\r\n\r\n");
+        QTRY_COMPARE_WITH_TIMEOUT(viewer.streamCount(), 1, 2000);
+
+        bus.publish(busFrame("c1", EncodedFrame::RawYuv, "raw-planes"));
+        bus.publish(busFrame("c2", EncodedFrame::Jpeg, "other-jpeg"));
+        bus.publish(busFrame("c1", EncodedFrame::Jpeg, "jpeg-bytes"));
+
+        QByteArray received;
+        QTRY_VERIFY_WITH_TIMEOUT((received += socket.readAll()).contains("jpeg-bytes\r\n"), 2000);
+        QVERIFY(received.startsWith("HTTP/1.1 200 OK\r\n"));
+        QVERIFY(received.contains(BrowserViewer::partHeader(10) + "jpeg-bytes\r\n"));
+        QVERIFY(!received.contains("raw-planes"));
+        QVERIFY(!received.contains("other-jpeg"));
+
+        socket.disconnectFromHost();
+        QTRY_COMPARE_WITH_TIMEOUT(viewer.streamCount(), 0, 2000);
+        viewer.stop();
+        QVERIFY(!viewer.isRunning());
+    }
+
+    /**
+     * Test: The bridge serves the viewer
+     * Verifies:
+     * - startBrowserViewer(0) picks a port, stopBrowserViewer() releases it
+     */
+    void testBridgeViewer() {
+        ImageServerBridge bridge;
+        bridge.setDisplayEnabled(false);
+        QVERIFY(bridge.startBrowserViewer(0));
+        QVERIFY(bridge.browserViewerPort() != 0);
+        bridge.stopBrowserViewer();
+        QCOMPARE(bridge.browserViewerPort(), quint16(0));
+    }
+};
+
+QTEST_MAIN(TestBrowserViewer)
+#include "test_browser_viewer.moc"
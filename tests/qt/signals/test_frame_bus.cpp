@@ -0,0 +1,258 @@
+/**
+ * @file test_frame_bus.cpp
+ * @brief Qt signal tests - Frame bus publish/subscribe delivery
+ *
+ * Tests the FrameBus that hands frames to several subscribers:
+ * - Queued delivery on the subscriber's context, shared payload
+ * - Per-subscriber depth and drop policy
+ * - Kind / client filters and subscription lifetime
+ * - Subscriber queries, used to skip decoding nobody consumes
+ */
+
+#include <QtTest/QtTest>
+#include <QtCore/QObject>
+#include <QtCore/QThread>
+#include "../fixtures/qt_test_base.h"
+#include "network/framebus.h"
+#include "network/imageserverbridge.h"
+
+/**
+ * @class TestFrameBus
+ * @brief Tests for FrameBus subscribers
+ */
+class TestFrameBus : public QObject {
+    Q_OBJECT
+
+private:
+    static BusFrame decodedFrame(const QString& clientId, const QImage& image = QImage(8, 8, QImage::Format_RGB32)) {
+        BusFrame frame;
+        frame.kind = BusFrame::Decoded;
+        frame.clientId = clientId;
+        frame.image = image;
+        return frame;
+    }
+
+private slots:
+    void initTestCase() {
+        qt_test::initializeQtTestApp();
+    }
+
+    /**
+     * Test: Every subscriber gets the same frame, later, without a pixel copy
+     * Verifies:
+     * - Nothing is delivered inside publish()
+     * - Both subscribers receive the frame once the event loop runs
+     * - They share the publisher's pixels and a sequence number is stamped
+     */
+    void testSubscribersShareOneFrame() {
+        FrameBus bus;
+        QObject display, recorder;
+        QList<FramePtr> shown, recorded;
+        bus.subscribe(&display, [&](const FramePtr& frame) { shown << frame; });
+        bus.subscribe(&recorder, [&](const FramePtr& frame) { recorded << frame; });
+
+        QImage image(16, 16, QImage::Format_RGB32);
+        image.fill(Qt::green);
+        bus.publish(decodedFrame("client-001", image));
+        QVERIFY(shown.isEmpty());
+
+        QTRY_COMPARE_WITH_TIMEOUT(shown.size(), 1, 1000);
+        QTRY_COMPARE_WITH_TIMEOUT(recorded.size(), 1, 1000);
+        QCOMPARE(shown.first().get(), recorded.first().get());
+        QCOMPARE(shown.first()->image.constBits(), image.constBits());
+        QVERIFY(shown.first()->sequence > 0);
+    }
+
+    /**
+     * Test: Depth and drop policy are per subscriber
+     * Verifies:
+     * - DropOldest with depth 1 keeps only the latest frame
+     * - DropNewest with depth 2 keeps the first two
+     * - Drops are counted for the subscriber that dropped
+     */
+    void testDropPolicies() {
+        FrameBus bus;
+        QObject live, ordered;
+        QList<quint64> liveSeq, orderedSeq;
+
+        FrameBus::Options latest;
+        latest.depth = 1;
+        const int liveId = bus.subscribe(&live, [&](const FramePtr& frame) { liveSeq << frame->sequence; }, latest);
+
+        FrameBus::Options keep;
+        keep.depth = 2;
+        keep.policy = FrameBus::DropPolicy::DropNewest;
+        const int orderedId = bus.subscribe(&ordered, [&](const FramePtr& frame) { orderedSeq << frame->sequence; }, keep);
+
+        for (int i = 0; i < 4; ++i)
+            bus.publish(decodedFrame("client-001"));
+
+        QTRY_COMPARE_WITH_TIMEOUT(orderedSeq.size(), 2, 1000);
+        QTRY_COMPARE_WITH_TIMEOUT(liveSeq.size(), 1, 1000);
+        QCOMPARE(liveSeq.first(), quint64(4));
+        QCOMPARE(orderedSeq, (QList<quint64>{1, 2}));
+        QCOMPARE(bus.droppedFrames(liveId), quint64(3));
+        QCOMPARE(bus.droppedFrames(orderedId), quint64(2));
+    }
+
+    /**
+     * Test: The depth applies per client
+     * Verifies:
+     * - A busy client does not push out another client's frame
+     */
+    void testDepthIsPerClient() {
+        FrameBus bus;
+        QObject mosaic;
+        QStringList clients;
+        bus.subscribe(&mosaic, [&](const FramePtr& frame) { clients << frame->clientId; });
+
+        bus.publish(decodedFrame("client-001"));
+        bus.publish(decodedFrame("client-002"));
+        bus.publish(decodedFrame("client-001"));
+
+        QTRY_COMPARE_WITH_TIMEOUT(clients.size(), 2, 1000);
+        QVERIFY(clients.contains("client-001"));
+        QVERIFY(clients.contains("client-002"));
+    }
+
+    /**
+     * Test: Kind and client filters
+     * Verifies:
+     * - An Encoded-only subscriber ignores decoded frames
+     * - A client filter ignores the other clients
+     */
+    void testFilters() {
+        FrameBus bus;
+        QObject relay;
+        QList<FramePtr> received;
+
+        FrameBus::Options options;
+        options.kinds = BusFrame::Encoded;
+        options.clientId = "client-002";
+        bus.subscribe(&relay, [&](const FramePtr& frame) { received << frame; }, options);
+
+        bus.publish(decodedFrame("client-002"));
+        BusFrame encoded;
+        encoded.clientId = "client-001";
+        bus.publish(encoded);
+        encoded.clientId = "client-002";
+        encoded.encoded = EncodedFrame::fromMessage(QByteArray("\x00jpeg", 5), 1);
+        bus.publish(encoded);
+
+        QTRY_COMPARE_WITH_TIMEOUT(received.size(), 1, 1000);
+        qt_test::EventLoopSpinner::processEvents();
+        QCOMPARE(received.size(), 1);
+        QCOMPARE(received.first()->kind, BusFrame::Encoded);
+        QCOMPARE(received.first()->encoded.size(), 4);
+    }
+
+    /**
+     * Test: Subscriptions end with unsubscribe() or their context
+     * Verifies:
+     * - Frames queued before unsubscribe() are not delivered
+     * - Destroying the context removes the subscriber
+     */
+    void testSubscriptionLifetime() {
+        FrameBus bus;
+        int calls = 0;
+        QObject first;
+        const int id = bus.subscribe(&first, [&](const FramePtr&) { ++calls; });
+        bus.publish(decodedFrame("client-001"));
+        bus.unsubscribe(id);
+        qt_test::EventLoopSpinner::processEvents();
+        QCOMPARE(calls, 0);
+
+        {
+            QObject second;
+            bus.subscribe(&second, [&](const FramePtr&) { ++calls; });
+            QCOMPARE(bus.subscriberCount(), 1);
+            bus.publish(decodedFrame("client-001"));
+        }
+        QCOMPARE(bus.subscriberCount(), 0);
+        qt_test::EventLoopSpinner::processEvents();
+        QCOMPARE(calls, 0);
+    }
+
+    /**
+     * Test: Producers can ask whether anyone takes a kind of frame
+     * Verifies:
+     * - hasSubscriber() honours the kind and client filters
+     * - subscribersChanged is emitted on subscribe and unsubscribe
+     */
+    void testSubscriberQuery() {
+        FrameBus bus;
+        QSignalSpy changed(&bus, &FrameBus::subscribersChanged);
+        QVERIFY(!bus.hasSubscriber(BusFrame::Decoded, "client-001"));
+
+        QObject analytics;
+        FrameBus::Options options;
+        options.kinds = BusFrame::Decoded;
+        options.clientId = "client-001";
+        const int id = bus.subscribe(&analytics, [](const FramePtr&) {}, options);
+        QCOMPARE(changed.count(), 1);
+        QVERIFY(bus.hasSubscriber(BusFrame::Decoded, "client-001"));
+        QVERIFY(!bus.hasSubscriber(BusFrame::Decoded, "client-002"));
+        QVERIFY(!bus.hasSubscriber(BusFrame::Encoded, "client-001"));
+
+        bus.unsubscribe(id);
+        QCOMPARE(changed.count(), 2);
+        QVERIFY(!bus.hasSubscriber(BusFrame::Decoded, "client-001"));
+    }
+
+    /**
+     * Test: Handlers run on the context's thread
+     * Verifies:
+     * - A subscriber living in a worker thread is called there
+     */
+    void testDeliveryOnContextThread() {
+        FrameBus bus;
+        QThread worker;
+        worker.start();
+        QObject analytics;
+        analytics.moveToThread(&worker);
+
+        QAtomicPointer<QThread> calledOn;
+        bus.subscribe(&analytics, [&](const FramePtr&) { calledOn.storeRelease(QThread::currentThread()); });
+        bus.publish(decodedFrame("client-001"));
+
+        QTRY_VERIFY_WITH_TIMEOUT(calledOn.loadAcquire() != nullptr, 1000);
+        QCOMPARE(calledOn.loadAcquire(), &worker);
+        worker.quit();
+        worker.wait();
+    }
+
+    /**
+     * Test: The bridge exposes a bus
+     * Verifies:
+     * - frameBus() is available right after construction, with no subscribers
+     */
+    void testBridgeHasFrameBus() {
+        ImageServerBridge bridge;
+        QVERIFY(bridge.frameBus() != nullptr);
+        QCOMPARE(bridge.frameBus()->subscriberCount(), 0);
+    }
+
+    /**
+     * Test: Headless bridges keep nothing for display
+     * Verifies:
+     * - Display is enabled by default and can be turned off
+     * - Attaching a Decoded subscriber while headless is accepted (decode interest re-evaluated)
+     */
+    void testBridgeWithoutDisplay() {
+        ImageServerBridge bridge;
+        QVERIFY(bridge.displayEnabled());
+        bridge.setDisplayEnabled(false);
+        QVERIFY(!bridge.displayEnabled());
+        QVERIFY(bridge.lastFrame().isNull());
+
+        QObject analytics;
+        FrameBus::Options options;
+        options.kinds = BusFrame::Decoded;
+        bridge.frameBus()->subscribe(&analytics, [](const FramePtr&) {}, options);
+        qt_test::EventLoopSpinner::processEvents();
+        QVERIFY(bridge.frameBus()->hasSubscriber(BusFrame::Decoded, "client-001"));
+    }
+};
+
+QTEST_MAIN(TestFrameBus)
+#include "test_frame_bus.moc"
@@ -0,0 +1,255 @@
+/**
+ * @file test_frame_recorder.cpp
+ * @brief Qt signal tests - Recording bus frames to segment files
+ *
+ * Tests the FrameRecorder subscriber and RecordingReader:
+ * - Frames are recorded byte for byte, per client
+ * - Size and time based segment rotation
+ * - Seeking by timestamp through the index
+ * - Replaying a recording or a JPEG directory (ReplaySource)
+ */
+
+#include <QtTest/QtTest>
+#include <QtCore/QObject>
+#include <QtCore/QTemporaryDir>
+#include "../fixtures/qt_test_base.h"
+#include "network/framerecorder.h"
+#include "network/replaysource.h"
+#include "network/imageserverbridge.h"
+
+namespace {
+
+const qint64 kStartUs = 1700000000000000;
+
+// Encoded JPEG frame with a client FrameHeader carrying `captureUs`
+BusFrame encodedFrame(const QString& clientId, const QByteArray& payload, qint64 captureUs, quint32 sequence = 0) {
+    EncodedFrame encoded = EncodedFrame::fromMessage(QByteArray(1, '\x04') + payload, 1);
+    encoded.hasHeader = true;
+    encoded.header.captureTimeUs = captureUs;
+    encoded.header.sequence = sequence;
+    encoded.receivedAtUs = captureUs + 1000;
+
+    BusFrame frame;
+    frame.kind = BusFrame::Encoded;
+    frame.clientId = clientId;
+    frame.encoded = encoded;
+    frame.timing = encoded.timing();
+    return frame;
+}
+
+QList<RecordingReader::Frame> readAll(const QString& segmentPath) {
+    QList<RecordingReader::Frame> frames;
+    RecordingReader reader;
+    if (!reader.open(segmentPath))
+        return frames;
+    RecordingReader::Frame frame;
+    while (reader.next(frame))
+        frames.append(frame);
+    return frames;
+}
+
+} // namespace
+
+/**
+ * @class TestFrameRecorder
+ * @brief Tests for the segmented frame recorder
+ */
+class TestFrameRecorder : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase() {
+        qt_test::initializeQtTestApp();
+    }
+
+    /**
+     * Test: Frames are recorded as received
+     * Verifies:
+     * - One directory per client, payload and header fields kept
+     * - Decoded frames are not recorded
+     * - stop() truncates the preallocated segment to what it holds
+     */
+    void testRecordsFramesAsReceived() {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        FrameBus bus;
+        FrameRecorder recorder(&bus);
+        FrameRecorder::Options options;
+        options.directory = dir.path();
+        QVERIFY(recorder.start(options));
+        QVERIFY(!recorder.start(options));
+
+        bus.publish(encodedFrame("cam/1", "first-jpeg", kStartUs, 7));
+        bus.publish(encodedFrame("cam/1", "second", kStartUs + 40000, 8));
+        bus.publish(encodedFrame("cam-2", "other", kStartUs));
+        BusFrame decoded;
+        decoded.kind = BusFrame::Decoded;
+        decoded.clientId = "cam/1";
+        decoded.image = QImage(4, 4, QImage::Format_RGB32);
+        bus.publish(decoded);
+        QTRY_COMPARE_WITH_TIMEOUT(recorder.stats().frames, quint64(3), 2000);
+        recorder.stop();
+        QVERIFY(!recorder.isRecording());
+
+        const QStringList segments = FrameRecorder::segments(dir.path(), "cam/1");
+        QCOMPARE(segments.size(), 1);
+        QCOMPARE(FrameRecorder::segments(dir.path(), "cam-2").size(), 1);
+
+        const QList<RecordingReader::Frame> frames = readAll(segments.first());
+        QCOMPARE(frames.size(), 2);
+        QCOMPARE(frames.at(0).payload, QByteArray("first-jpeg"));
+        QCOMPARE(frames.at(0).header.timestampUs, kStartUs);
+        QCOMPARE(frames.at(0).header.sequence, 7u);
+        QCOMPARE(frames.at(1).payload, QByteArray("second"));
+        QVERIFY(QFileInfo(segments.first()).size() < 4096);
+        QCOMPARE(recorder.stats().bytes, quint64(10 + 6 + 5));
+    }
+
+    /**
+     * Test: Segments rotate on size and on stream time
+     * Verifies:
+     * - A frame that doesn't fit opens the next segment
+     * - A segment older than segmentDurationMs is closed
+     * - Every frame ends up in exactly one segment
+     */
+    void testRotatesBySizeAndTime() {
+        QTemporaryDir dir;
+        FrameBus bus;
+        FrameRecorder recorder(&bus);
+        FrameRecorder::Options options;
+        options.directory = dir.path();
+        options.segmentBytes = 256 * 1024;
+        options.segmentDurationMs = 1000;
+        QVERIFY(recorder.start(options));
+
+        const QByteArray big(100 * 1024, 'x');
+        for (int i = 0; i < 3; ++i)
+            bus.publish(encodedFrame("size", big, kStartUs + i * 1000));
+        for (int i = 0; i < 4; ++i)
+            bus.publish(encodedFrame("time", "small", kStartUs + i * 600000));
+        QTRY_COMPARE_WITH_TIMEOUT(recorder.stats().frames, quint64(7), 2000);
+        recorder.stop();
+
+        const QStringList bySize = FrameRecorder::segments(dir.path(), "size");
+        QCOMPARE(bySize.size(), 2);
+        QCOMPARE(readAll(bySize.at(0)).size() + readAll(bySize.at(1)).size(), 3);
+
+        const QStringList byTime = FrameRecorder::segments(dir.path(), "time");
+        QCOMPARE(byTime.size(), 2); // 0 + 0.6 s, then 1.2 + 1.8 s
+        QCOMPARE(readAll(byTime.at(0)).size(), 2);
+        QCOMPARE(recorder.stats().segments, quint64(4));
+    }
+
+    /**
+     * Test: Seeking by timestamp
+     * Verifies:
+     * - segmentFor() picks the segment holding the time
+     * - seek() positions on the first frame at or after it
+     * - Past the end there is nothing
+     */
+    void testSeekByTimestamp() {
+        QTemporaryDir dir;
+        FrameBus bus;
+        FrameRecorder recorder(&bus);
+        FrameRecorder::Options options;
+        options.directory = dir.path();
+        options.segmentDurationMs = 1000;
+        options.indexIntervalMs = 300;
+        options.queueDepth = 32;
+        QVERIFY(recorder.start(options));
+        for (int i = 0; i < 20; ++i)
+            bus.publish(encodedFrame("cam", QByteArray::number(i), kStartUs + i * 100000, quint32(i)));
+        QTRY_COMPARE_WITH_TIMEOUT(recorder.stats().frames, quint64(20), 2000);
+        recorder.stop();
+
+        const qint64 target = kStartUs + 1250000;
+        const QString segment = FrameRecorder::segmentFor(dir.path(), "cam", target);
+        QCOMPARE(segment, FrameRecorder::segments(dir.path(), "cam").at(1));
+
+        RecordingReader reader;
+        QVERIFY(reader.open(segment));
+        QVERIFY(reader.seek(target));
+        RecordingReader::Frame frame;
+        QVERIFY(reader.next(frame));
+        QCOMPARE(frame.header.sequence, 13u);
+        QCOMPARE(frame.payload, QByteArray("13"));
+
+        QVERIFY(!reader.seek(kStartUs + 5000000));
+        QVERIFY(FrameRecorder::segmentFor(dir.path(), "cam", kStartUs + 5000000).isEmpty());
+    }
+
+    /**
+     * Test: Replay sources
+     * Verifies:
+     * - A client's recording directory replays every segment in order, with timestamps
+     * - rewind() starts over
+     * - A JPEG directory replays its files in name order, spaced by the fps
+     */
+    void testReplaySources() {
+        QTemporaryDir dir;
+        FrameBus bus;
+        FrameRecorder recorder(&bus);
+        FrameRecorder::Options options;
+        options.directory = dir.path();
+        options.segmentDurationMs = 100;
+        QVERIFY(recorder.start(options));
+        for (int i = 0; i < 4; ++i)
+            bus.publish(encodedFrame("cam", QByteArray::number(i), kStartUs + i * 100000));
+        QTRY_COMPARE_WITH_TIMEOUT(recorder.stats().frames, quint64(4), 2000);
+        recorder.stop();
+
+        ReplaySource recording;
+        QVERIFY(recording.open(FrameRecorder::clientDirectory(dir.path(), "cam")));
+        QVERIFY(recording.isRecording());
+        QCOMPARE(recording.fileCount(), 4);
+        ReplaySource::Frame frame;
+        for (int pass = 0; pass < 2; ++pass) {
+            for (int i = 0; i < 4; ++i) {
+                QVERIFY(recording.next(frame));
+                QCOMPARE(frame.data, QByteArray::number(i));
+                QCOMPARE(frame.timestampUs, kStartUs + i * 100000);
+            }
+            QVERIFY(!recording.next(frame));
+            recording.rewind();
+        }
+
+        QTemporaryDir jpegs;
+        for (const QString& name : {QString("b.jpg"), QString("a.jpg"), QString("notes.txt")}) {
+            QFile file(jpegs.filePath(name));
+            QVERIFY(file.open(QIODevice::WriteOnly));
+            file.write(name.toLatin1());
+        }
+        ReplaySource images;
+        QVERIFY(images.open(jpegs.path(), 25));
+        QVERIFY(!images.isRecording());
+        QVERIFY(images.next(frame));
+        QCOMPARE(frame.data, QByteArray("a.jpg"));
+        QVERIFY(images.next(frame));
+        QCOMPARE(frame.data, QByteArray("b.jpg"));
+        QCOMPARE(frame.timestampUs, qint64(40000));
+        QVERIFY(!images.next(frame));
+
+        QTemporaryDir empty;
+        ReplaySource nothing;
+        QVERIFY(!nothing.open(empty.path()));
+    }
+
+    /**
+     * Test: The bridge records its bus
+     * Verifies:
+     * - startRecording()/stopRecording() drive the bridge's recorder
+     * - recordingStats() reports the state
+     */
+    void testBridgeRecording() {
+        QTemporaryDir dir;
+        ImageServerBridge bridge;
+        QVERIFY(bridge.recorder() != nullptr);
+        QVERIFY(bridge.startRecording(dir.path()));
+        QCOMPARE(bridge.recordingStats().value("recording").toBool(), true);
+        bridge.stopRecording();
+        QCOMPARE(bridge.recordingStats().value("recording").toBool(), false);
+    }
+};
+
+QTEST_MAIN(TestFrameRecorder)
+#include "test_frame_recorder.moc"
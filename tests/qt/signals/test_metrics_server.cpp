@@ -0,0 +1,133 @@
+/**
+ * @file test_metrics_server.cpp
+ * @brief Qt signal tests - Prometheus metrics endpoint
+ *
+ * Tests the MetricsServer that exposes StreamMetrics over HTTP:
+ * - GET /metrics answered from its own thread with the text format
+ * - Status codes for other paths, methods and malformed requests
+ * - The bridge counts received frames per client
+ */
+
+#include <QtTest/QtTest>
+#include <QtCore/QObject>
+#include <QtNetwork/QTcpSocket>
+#include <QtWebSockets/QWebSocket>
+#include <memory>
+#include "../fixtures/qt_test_base.h"
+#include "network/imageserverbridge.h"
+#include "network/metricsserver.h"
+#include "network/streammetrics.h"
+
+/**
+ * @class TestMetricsServer
+ * @brief Tests for the /metrics endpoint
+ */
+class TestMetricsServer : public QObject {
+    Q_OBJECT
+
+private:
+    // Full response to one request, read until the server closes the connection
+    static QByteArray fetch(quint16 port, const QByteArray& request) {
+        QTcpSocket socket;
+        socket.connectToHost(QHostAddress::LocalHost, port);
+        if (!socket.waitForConnected(2000))
+            return QByteArray();
+        socket.write(request);
+        QByteArray response;
+        while (socket.state() == QAbstractSocket::ConnectedState && socket.waitForReadyRead(2000))
+            response += socket.readAll();
+        return response + socket.readAll();
+    }
+
+private slots:
+    void initTestCase() {
+        qt_test::initializeQtTestApp();
+    }
+
+    /**
+     * Test: A scrape gets the counters in the text format
+     * Verifies:
+     * - start(0) picks a port and listens
+     * - 200 with the Prometheus content type and the client's counters
+     * - stop() closes the port
+     */
+    void testServesMetrics() {
+        auto metrics = std::make_shared<StreamMetrics>();
+        metrics->addClient("c1")->recordFrame(1234);
+        MetricsServer server(metrics);
+        QVERIFY(server.start(0, QHostAddress::LocalHost));
+        QVERIFY(server.isRunning());
+        QVERIFY(server.port() != 0);
+
+        const QByteArray response = fetch(server.port(), "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n");
+        QVERIFY2(response.startsWith("HTTP/1.1 200 OK\r\n"), response.constData());
+        QVERIFY(response.contains("Content-Type: text/plain; version=0.0.4"));
+        QVERIFY(response.contains("imagesocket_bytes_received_total{client=\"c1\",alias=\"\"} 1234\n"));
+
+        const quint16 port = server.port();
+        server.stop();
+        QVERIFY(!server.isRunning());
+        QTcpSocket socket;
+        socket.connectToHost(QHostAddress::LocalHost, port);
+        QVERIFY(!socket.waitForConnected(500));
+    }
+
+    /**
+     * Test: Requests other than a metrics GET
+     * Verifies:
+     * - Unknown paths are 404, other methods 405, garbage 400
+     * - HEAD and a query string are accepted; HEAD has no body
+     */
+    void testResponses() {
+        StreamMetrics metrics;
+        QVERIFY(MetricsServer::respond("GET / HTTP/1.1\r\n\r\n", metrics).startsWith("HTTP/1.1 404"));
+        QVERIFY(MetricsServer::respond("POST /metrics HTTP/1.1\r\n\r\n", metrics).startsWith("HTTP/1.1 405"));
+        QVERIFY(MetricsServer::respond("hello\r\n\r\n", metrics).startsWith("HTTP/1.1 400"));
+        QVERIFY(MetricsServer::respond("GET /metrics?x=1 HTTP/1.1\r\n\r\n", metrics).startsWith("HTTP/1.1 200"));
+
+        const QByteArray head = MetricsServer::respond("HEAD /metrics HTTP/1.1\r\n\r\n", metrics);
+        QVERIFY(head.startsWith("HTTP/1.1 200"));
+        QVERIFY(head.endsWith("\r\n\r\n"));
+    }
+
+    /**
+     * Test: The bridge counts every received frame
+     * Verifies:
+     * - A connected client appears in the metrics
+     * - Frames and payload bytes are counted without decoding (headless bridge)
+     * - startMetrics() serves the same registry
+     */
+    void testBridgeCountsFrames() {
+        ImageServerBridge bridge;
+        bridge.setDisplayEnabled(false);
+        bridge.setPort(0);
+        QVERIFY(bridge.start());
+        QVERIFY(bridge.startMetrics(0));
+        QVERIFY(bridge.metricsPort() != 0);
+
+        auto client = std::make_unique<QWebSocket>();
+        client->open(QUrl(QString("ws://127.0.0.1:%1").arg(bridge.serverPort())));
+        QTRY_VERIFY_WITH_TIMEOUT(client->isValid(), 2000);
+        QTRY_COMPARE_WITH_TIMEOUT(bridge.streamMetrics()->clientCount(), std::size_t(1), 2000);
+
+        QByteArray frame(1, char(0x00));
+        frame.append(QByteArray(100, 'x'));
+        client->sendBinaryMessage(frame);
+        client->sendBinaryMessage(frame);
+        QTRY_VERIFY_WITH_TIMEOUT(
+            QByteArray::fromStdString(bridge.streamMetrics()->render())
+                .contains("imagesocket_server_bytes_received_total 200\n"), 2000);
+
+        const QByteArray response = fetch(bridge.metricsPort(), "GET /metrics HTTP/1.0\r\n\r\n");
+        QVERIFY(response.contains("imagesocket_server_frames_received_total 2\n"));
+
+        client->close();
+        client.reset();
+        QTRY_COMPARE_WITH_TIMEOUT(bridge.streamMetrics()->clientCount(), std::size_t(0), 2000);
+        bridge.stopMetrics();
+        bridge.stop();
+    }
+};
+
+QTEST_MAIN(TestMetricsServer)
+#include "test_metrics_server.moc"
@@ -0,0 +1,251 @@
+/**
+ * @file test_processing_stage.cpp
+ * @brief Qt signal tests - Frame processors attached to the frame bus
+ *
+ * Tests the ProcessingStage that runs FrameProcessors on bus frames:
+ * - process() runs on the processor's pool, not the publishing thread
+ * - Skip-when-busy and bounded queue semantics
+ * - Per-processor statistics
+ * - Cross-client batching with a deadline
+ */
+
+#include <QtTest/QtTest>
+#include <QtCore/QObject>
+#include <QtCore/QThread>
+#include <QtCore/QSemaphore>
+#include <QtCore/QAtomicInt>
+#include <QtCore/QMutex>
+#include <memory>
+#include "../fixtures/qt_test_base.h"
+#include "network/frameprocessor.h"
+#include "network/imageserverbridge.h"
+
+namespace {
+
+// Blocks in process() until released, so the tests control when it is busy
+class GateProcessor : public FrameProcessor {
+public:
+    explicit GateProcessor(const QString& name) : m_name(name) {}
+
+    QString name() const override { return m_name; }
+
+    bool process(const BusFrame& frame) override {
+        thread.storeRelease(QThread::currentThread());
+        entered.release();
+        gate.acquire();
+        sequences.append(frame.sequence); // serialized by the gate in these tests
+        calls.ref();
+        return !frame.clientId.isEmpty();
+    }
+
+    QString m_name;
+    QSemaphore entered;
+    QSemaphore gate;
+    QAtomicInt calls;
+    QAtomicPointer<QThread> thread;
+    QList<quint64> sequences;
+};
+
+// Records the batches it is given
+class BatchRecorder : public FrameProcessor {
+public:
+    QString name() const override { return "detector"; }
+    bool process(const BusFrame&) override { return false; }
+
+    bool processBatch(const FrameBatch& batch) override {
+        QMutexLocker lock(&mutex);
+        sizes.append(batch.count());
+        for (const FramePtr& frame : batch.frames)
+            clients.append(frame->clientId);
+        aligned = reinterpret_cast<quintptr>(batch.data) % FrameBatch::kAlignment == 0;
+        width = batch.geometry.width;
+        firstRed = batch.image(0)[0];
+        return true;
+    }
+
+    QMutex mutex;
+    QList<int> sizes;
+    QStringList clients;
+    bool aligned = false;
+    int width = 0;
+    int firstRed = -1;
+};
+
+BusFrame frameFrom(const QString& clientId) {
+    BusFrame frame;
+    frame.kind = BusFrame::Decoded;
+    frame.clientId = clientId;
+    frame.image = QImage(4, 4, QImage::Format_RGB32);
+    return frame;
+}
+
+} // namespace
+
+/**
+ * @class TestProcessingStage
+ * @brief Tests for FrameProcessor scheduling and statistics
+ */
+class TestProcessingStage : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase() {
+        qt_test::initializeQtTestApp();
+    }
+
+    /**
+     * Test: Processors run off the publishing thread
+     * Verifies:
+     * - process() is called on a pool thread
+     * - Completions are counted as processed
+     */
+    void testProcessRunsOnWorkerThread() {
+        FrameBus bus;
+        ProcessingStage stage(&bus);
+        auto processor = std::make_shared<GateProcessor>("reader");
+        processor->gate.release(10);
+        QVERIFY(stage.addProcessor(processor));
+        QVERIFY(!stage.addProcessor(std::make_shared<GateProcessor>("reader")));
+
+        bus.publish(frameFrom("client-001"));
+        QTRY_COMPARE_WITH_TIMEOUT(int(processor->calls.loadAcquire()), 1, 2000);
+        QVERIFY(processor->thread.loadAcquire() != QThread::currentThread());
+        QTRY_COMPARE_WITH_TIMEOUT(stage.stats().first().processed, quint64(1), 2000);
+    }
+
+    /**
+     * Test: A busy processor skips frames instead of queueing them
+     * Verifies:
+     * - With queueDepth 0, frames arriving during process() are skipped
+     * - The publisher is never blocked
+     */
+    void testSkipWhenBusy() {
+        FrameBus bus;
+        ProcessingStage stage(&bus);
+        auto processor = std::make_shared<GateProcessor>("slow");
+        QVERIFY(stage.addProcessor(processor));
+
+        bus.publish(frameFrom("client-001"));
+        QTRY_VERIFY_WITH_TIMEOUT(processor->entered.tryAcquire(), 2000); // delivered through the event loop
+        for (int i = 0; i < 3; ++i) {
+            bus.publish(frameFrom("client-001"));
+            qt_test::EventLoopSpinner::processEvents();
+        }
+        processor->gate.release(10);
+
+        QTRY_COMPARE_WITH_TIMEOUT(stage.stats().first().processed, quint64(1), 2000);
+        QCOMPARE(stage.stats().first().skipped, quint64(3));
+        QCOMPARE(int(processor->calls.loadAcquire()), 1);
+        stage.removeProcessor("slow");
+    }
+
+    /**
+     * Test: With a queue, the latest frames wait for the busy processor
+     * Verifies:
+     * - queueDepth 1 keeps the newest frame and skips the older ones
+     * - The queued frame is processed after the running one
+     */
+    void testBoundedQueueKeepsLatest() {
+        FrameBus bus;
+        ProcessingStage stage(&bus);
+        auto processor = std::make_shared<GateProcessor>("queued");
+        ProcessingStage::Options options;
+        options.queueDepth = 1;
+        QVERIFY(stage.addProcessor(processor, options));
+
+        bus.publish(frameFrom("client-001"));
+        QTRY_VERIFY_WITH_TIMEOUT(processor->entered.tryAcquire(), 2000); // delivered through the event loop
+        for (int i = 0; i < 3; ++i) {
+            bus.publish(frameFrom("client-001"));
+            qt_test::EventLoopSpinner::processEvents();
+        }
+        processor->gate.release(10);
+
+        QTRY_COMPARE_WITH_TIMEOUT(int(processor->calls.loadAcquire()), 2, 2000);
+        stage.removeProcessor("queued");
+        QCOMPARE(processor->sequences, (QList<quint64>{1, 4}));
+    }
+
+    /**
+     * Test: Statistics per processor
+     * Verifies:
+     * - Failed calls are counted apart from processed ones
+     * - Process time percentiles are filled; statsList() carries the name
+     * - Removing a processor drops it from the statistics
+     */
+    void testStatsPerProcessor() {
+        FrameBus bus;
+        ProcessingStage stage(&bus);
+        auto processor = std::make_shared<GateProcessor>("metrics");
+        processor->gate.release(10);
+        QVERIFY(stage.addProcessor(processor));
+
+        BusFrame anonymous = frameFrom(QString());
+        bus.publish(anonymous);
+        QTRY_COMPARE_WITH_TIMEOUT(stage.stats().first().failed, quint64(1), 2000);
+
+        const ProcessingStage::Stats stats = stage.stats().first();
+        QCOMPARE(stats.processed, quint64(0));
+        QVERIFY(stats.processP50Ms >= 0.0);
+        QCOMPARE(stage.statsList().first().toMap().value("name").toString(), QString("metrics"));
+
+        stage.removeProcessor("metrics");
+        QVERIFY(stage.stats().isEmpty());
+        QCOMPARE(bus.subscriberCount(), 0);
+    }
+
+    /**
+     * Test: Batching across clients
+     * Verifies:
+     * - Frames of different clients fill one batch of batchSize
+     * - The tensor is aligned, scaled to the requested size, and holds the pixels
+     * - A partial batch is handed over once the deadline passes
+     */
+    void testBatchesAcrossClientsWithDeadline() {
+        FrameBus bus;
+        ProcessingStage stage(&bus);
+        auto processor = std::make_shared<BatchRecorder>();
+        ProcessingStage::Options options;
+        options.batchSize = 3;
+        options.batchDeadlineMs = 50;
+        options.batchWidth = 2;
+        options.batchHeight = 2;
+        QVERIFY(stage.addProcessor(processor, options));
+
+        const QStringList clients = {"cam-a", "cam-b", "cam-c"};
+        for (const QString& client : clients) {
+            BusFrame frame = frameFrom(client);
+            frame.image.fill(qRgb(200, 10, 20));
+            bus.publish(frame);
+        }
+        QTRY_COMPARE_WITH_TIMEOUT(stage.stats().first().batches, quint64(1), 2000);
+        {
+            QMutexLocker lock(&processor->mutex);
+            QCOMPARE(processor->sizes, QList<int>({3}));
+            QCOMPARE(processor->clients, clients);
+            QVERIFY(processor->aligned);
+            QCOMPARE(processor->width, 2);
+            QCOMPARE(processor->firstRed, 200);
+        }
+
+        bus.publish(frameFrom("cam-a"));
+        QTRY_COMPARE_WITH_TIMEOUT(stage.stats().first().batches, quint64(2), 2000);
+        QMutexLocker lock(&processor->mutex);
+        QCOMPARE(processor->sizes, QList<int>({3, 1}));
+        QCOMPARE(stage.stats().first().processed, quint64(4));
+    }
+
+    /**
+     * Test: The bridge has a stage on its bus
+     * Verifies:
+     * - processingStage() exists and processorStats() starts empty
+     */
+    void testBridgeHasProcessingStage() {
+        ImageServerBridge bridge;
+        QVERIFY(bridge.processingStage() != nullptr);
+        QVERIFY(bridge.processorStats().isEmpty());
+    }
+};
+
+QTEST_MAIN(TestProcessingStage)
+#include "test_processing_stage.moc"
@@ -0,0 +1,185 @@
+/**
+ * @file test_pause_inactive.cpp
+ * @brief Qt state tests - Pausing and throttling non-active clients
+ *
+ * Tests the PAUSE / RESUME / SUBSCRIBE commands the bridge sends as the
+ * active client changes, and the client rejecting frames while paused.
+ */
+
+#include <QtTest/QtTest>
+#include <QtCore/QObject>
+#include <QtCore/QSettings>
+#include <QtTest/QSignalSpy>
+#include <QtWebSockets/QWebSocket>
+#include "../fixtures/qt_test_base.h"
+#include "network/imageserverbridge.h"
+#include "network/clientmodel.h"
+#include "network/websocketimageclient.h"
+#include "control.pb.h"
+
+namespace {
+
+// True if the spy captured a control message of the given type (and fps, when >= 0)
+bool receivedControl(const QSignalSpy& spy, imagesocket::control::CommandType type, int fps = -1)
+{
+    for (int i = 0; i < spy.count(); ++i) {
+        const QByteArray msg = spy.at(i).at(0).toByteArray();
+        if (msg.isEmpty() || static_cast<unsigned char>(msg.at(0)) != 0x01)
+            continue;
+        imagesocket::control::ControlMessage cm;
+        if (!cm.ParseFromArray(msg.constData() + 1, msg.size() - 1))
+            continue;
+        if (cm.type() == type && (fps < 0 || cm.fps() == fps))
+            return true;
+    }
+    return false;
+}
+
+bool openClient(QWebSocket& client, quint16 port)
+{
+    QEventLoop loop;
+    QObject::connect(&client, &QWebSocket::connected, &loop, &QEventLoop::quit);
+    client.open(QUrl(QString("ws://127.0.0.1:%1").arg(port)));
+    QTimer::singleShot(2000, &loop, &QEventLoop::quit);
+    loop.exec();
+    return client.state() == QAbstractSocket::ConnectedState;
+}
+
+// setInactiveClientFps() persists the rate: keep it out of the user's settings
+void removeInactiveFpsSetting()
+{
+    QSettings settings("ImageSocket", "Server");
+    settings.remove("inactiveFps");
+    settings.sync();
+}
+
+} // namespace
+
+/**
+ * @class TestPauseInactive
+ * @brief Tests for pausing and throttling the clients not on display
+ */
+class TestPauseInactive : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase() {
+        qt_test::initializeQtTestApp();
+    }
+
+    void init() {
+        removeInactiveFpsSetting();
+    }
+
+    void cleanup() {
+        removeInactiveFpsSetting();
+    }
+
+    /**
+     * Test: With inactive fps 0, clients not on display are paused
+     * Verifies:
+     * - The first client becomes active and is never paused
+     * - A second client gets PAUSE
+     * - Switching the active client resumes the new one and pauses the old one
+     */
+    void testInactiveClientsArePaused() {
+        ImageServerBridge bridge;
+        bridge.setPort(0);
+        bridge.setInactiveClientFps(0);
+        QVERIFY(bridge.start());
+        ClientModel* model = qobject_cast<ClientModel*>(bridge.clientModel());
+        QVERIFY(model);
+
+        QWebSocket first;
+        QSignalSpy firstSpy(&first, &QWebSocket::binaryMessageReceived);
+        QVERIFY(openClient(first, bridge.serverPort()));
+        QTRY_COMPARE_WITH_TIMEOUT(model->rowCount(), 1, 3000);
+
+        QWebSocket second;
+        QSignalSpy secondSpy(&second, &QWebSocket::binaryMessageReceived);
+        QVERIFY(openClient(second, bridge.serverPort()));
+        QTRY_COMPARE_WITH_TIMEOUT(model->rowCount(), 2, 3000);
+        QTRY_VERIFY_WITH_TIMEOUT(receivedControl(secondSpy, imagesocket::control::PAUSE), 3000);
+        QVERIFY(!receivedControl(firstSpy, imagesocket::control::PAUSE));
+
+        const QString secondId = model->clientIdAt(1);
+        QVERIFY(secondId != bridge.activeClient());
+        secondSpy.clear();
+        bridge.setActiveClient(secondId);
+        QTRY_VERIFY_WITH_TIMEOUT(receivedControl(secondSpy, imagesocket::control::RESUME), 3000);
+        QTRY_VERIFY_WITH_TIMEOUT(receivedControl(firstSpy, imagesocket::control::PAUSE), 3000);
+
+        first.close();
+        second.close();
+        bridge.stop();
+    }
+
+    /**
+     * Test: With an inactive fps, clients not on display are throttled instead
+     * Verifies:
+     * - A second client gets SUBSCRIBE at the inactive rate
+     * - It is not paused
+     */
+    void testInactiveClientsGetPreviewSubscription() {
+        ImageServerBridge bridge;
+        bridge.setPort(0);
+        bridge.setInactiveClientFps(2);
+        QVERIFY(bridge.start());
+        ClientModel* model = qobject_cast<ClientModel*>(bridge.clientModel());
+        QVERIFY(model);
+
+        QWebSocket first;
+        QVERIFY(openClient(first, bridge.serverPort()));
+        QTRY_COMPARE_WITH_TIMEOUT(model->rowCount(), 1, 3000);
+
+        QWebSocket second;
+        QSignalSpy secondSpy(&second, &QWebSocket::binaryMessageReceived);
+        QVERIFY(openClient(second, bridge.serverPort()));
+        QTRY_VERIFY_WITH_TIMEOUT(receivedControl(secondSpy, imagesocket::control::SUBSCRIBE, 2), 3000);
+        QVERIFY(!receivedControl(secondSpy, imagesocket::control::PAUSE));
+
+        first.close();
+        second.close();
+        bridge.stop();
+    }
+
+    /**
+     * Test: A paused client rejects frames until it is resumed
+     * Verifies:
+     * - isPaused() follows the server's PAUSE
+     * - sendFrame() returns SendStatus::Paused while paused
+     * - After RESUME frames are queued again
+     */
+    void testPausedClientRejectsFrames() {
+        ImageServerBridge bridge;
+        bridge.setPort(0);
+        bridge.setInactiveClientFps(0);
+        QVERIFY(bridge.start());
+        ClientModel* model = qobject_cast<ClientModel*>(bridge.clientModel());
+        QVERIFY(model);
+
+        QWebSocket first;
+        QVERIFY(openClient(first, bridge.serverPort()));
+        QTRY_COMPARE_WITH_TIMEOUT(model->rowCount(), 1, 3000);
+
+        WebSocketImageClient second(QStringLiteral("127.0.0.1"), bridge.serverPort());
+        second.connectAsync();
+        QTRY_COMPARE_WITH_TIMEOUT(model->rowCount(), 2, 3000);
+        // Frames are also held back until CONFIG: wait for it so Paused means PAUSE
+        QTRY_VERIFY_WITH_TIMEOUT(second.isConfigured() && second.isPaused(), 3000);
+
+        const QByteArray jpeg(64, '\0');
+        QVERIFY(second.sendFrame(jpeg).status == SendStatus::Paused);
+
+        bridge.setActiveClient(model->clientIdAt(1));
+        QTRY_VERIFY_WITH_TIMEOUT(!second.isPaused(), 3000);
+        QVERIFY(second.sendFrame(jpeg).status == SendStatus::Queued);
+
+        second.disconnectFromServer();
+        first.close();
+        bridge.stop();
+    }
+};
+
+QTEST_MAIN(TestPauseInactive)
+#include "test_pause_inactive.moc"
@@ -197,6 +197,23 @@ private slots:
         // Verify they have different client models
         QVERIFY(bridge1.clientModel() != bridge2.clientModel());
     }
+
+    /**
+     * Test: Load figures of an idle server
+     * Verifies:
+     * - serverStats() reports no clients, fps or drops
+     * - Latencies are -1 without samples; the CPU figure is available
+     */
+    void testServerStatsStartIdle() {
+        ImageServerBridge bridge;
+        const QVariantMap stats = bridge.serverStats();
+        QCOMPARE(stats.value("clients").toInt(), 0);
+        QCOMPARE(stats.value("fps").toInt(), 0);
+        QCOMPARE(stats.value("dropped").toULongLong(), 0ull);
+        QCOMPARE(stats.value("networkP99Ms").toDouble(), -1.0);
+        QCOMPARE(stats.value("decodeP99Ms").toDouble(), -1.0);
+        QVERIFY(stats.contains("cpuPercent"));
+    }
 };
 
 QTEST_MAIN(TestServerBridgeInitialState)
@@ -0,0 +1,142 @@
+/**
+ * @file test_server_sharding.cpp
+ * @brief Qt state tests - Multi-process sharding on one port
+ *
+ * Tests the ShardDirectory that records which server instance holds which
+ * client, and SO_REUSEPORT listeners sharing a port.
+ */
+
+#include <QtTest/QtTest>
+#include <QtCore/QObject>
+#include <QtCore/QTemporaryDir>
+#include <QtCore/QFile>
+#include <QtCore/QDir>
+#include "../fixtures/qt_test_base.h"
+#include "network/sharddirectory.h"
+#include "network/websocketserver.h"
+
+/**
+ * @class TestServerSharding
+ * @brief Tests for the shard directory and reuse-port listeners
+ */
+class TestServerSharding : public QObject {
+    Q_OBJECT
+
+private:
+    static void writeShardFile(const QString& directory, qint64 pid, const QByteArray& contents) {
+        QFile file(QDir(directory).filePath(QString::number(pid) + QStringLiteral(".clients")));
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(contents);
+    }
+
+private slots:
+    void initTestCase() {
+        qt_test::initializeQtTestApp();
+    }
+
+    /**
+     * Test: Published clients can be found by id and by alias
+     * Verifies:
+     * - setClient() records the address, setAlias() keeps it
+     * - find() matches either the client id or the alias
+     * - The entry carries this process' pid
+     */
+    void testFindByIdOrAlias() {
+        QTemporaryDir root;
+        QVERIFY(root.isValid());
+        ShardDirectory shards(5000, root.path());
+
+        shards.setClient(QStringLiteral("{a}"), QString(), QStringLiteral("10.0.0.7"));
+        shards.setAlias(QStringLiteral("{a}"), QStringLiteral("cam-1"));
+
+        ShardDirectory::Entry entry;
+        QVERIFY(shards.find(QStringLiteral("{a}"), entry));
+        QCOMPARE(entry.alias, QStringLiteral("cam-1"));
+        QCOMPARE(entry.address, QStringLiteral("10.0.0.7"));
+        QCOMPARE(entry.pid, QCoreApplication::applicationPid());
+
+        QVERIFY(shards.find(QStringLiteral("cam-1"), entry));
+        QCOMPARE(entry.clientId, QStringLiteral("{a}"));
+        QVERIFY(!shards.find(QStringLiteral("cam-2"), entry));
+    }
+
+    /**
+     * Test: Removed clients and destroyed directories disappear
+     * Verifies:
+     * - removeClient() drops the entry
+     * - The destructor removes this process' file
+     */
+    void testRemoveClientAndCleanup() {
+        QTemporaryDir root;
+        QVERIFY(root.isValid());
+        {
+            ShardDirectory shards(5000, root.path());
+            shards.setClient(QStringLiteral("{a}"), QStringLiteral("cam-1"), QString());
+            shards.setClient(QStringLiteral("{b}"), QStringLiteral("cam-2"), QString());
+            shards.removeClient(QStringLiteral("{a}"));
+
+            const QList<ShardDirectory::Entry> entries = shards.entries();
+            QCOMPARE(entries.size(), 1);
+            QCOMPARE(entries.first().clientId, QStringLiteral("{b}"));
+        }
+        QVERIFY(ShardDirectory::entriesOn(5000, root.path()).isEmpty());
+    }
+
+    /**
+     * Test: Other live instances are listed, dead ones are swept
+     * Verifies:
+     * - A file owned by a running process (pid 1) is read
+     * - A file of a process that no longer exists is removed
+     * - Empty alias and address fields survive the round trip
+     */
+    void testOtherInstancesAndStaleFiles() {
+#ifndef Q_OS_UNIX
+        QSKIP("Process liveness is only checked on Unix");
+#endif
+        QTemporaryDir root;
+        QVERIFY(root.isValid());
+        ShardDirectory shards(5000, root.path());
+
+        const qint64 deadPid = 2147483646; // above any pid_max
+        writeShardFile(shards.directory(), 1, "{live}\t\t\n");
+        writeShardFile(shards.directory(), deadPid, "{gone}\tcam-9\t10.0.0.9\n");
+
+        ShardDirectory::Entry entry;
+        QVERIFY(shards.find(QStringLiteral("{live}"), entry));
+        QCOMPARE(entry.pid, qint64(1));
+        QVERIFY(entry.alias.isEmpty());
+        QVERIFY(!shards.find(QStringLiteral("cam-9"), entry));
+        QVERIFY(!QFile::exists(QDir(shards.directory()).filePath(QString::number(deadPid) + QStringLiteral(".clients"))));
+    }
+
+    /**
+     * Test: Two reuse-port servers listen on the same port
+     * Verifies:
+     * - The second start() succeeds where a plain listener would fail
+     * - Both report the shared port
+     */
+    void testReusePortServersShareAPort() {
+#ifndef Q_OS_LINUX
+        QSKIP("SO_REUSEPORT load balancing is Linux-specific");
+#endif
+        WebSocketServer first;
+        first.setReusePort(true);
+        QVERIFY(first.start(0));
+        const quint16 port = first.port();
+        QVERIFY(port > 0);
+
+        WebSocketServer second;
+        second.setReusePort(true);
+        QVERIFY(second.start(port));
+        QCOMPARE(second.port(), port);
+
+        WebSocketServer plain;
+        QVERIFY(!plain.start(port));
+
+        second.stop();
+        first.stop();
+    }
+};
+
+QTEST_MAIN(TestServerSharding)
+#include "test_server_sharding.moc"
@@ -0,0 +1,124 @@
+/**
+ * @file test_websocket_lazy_decode.cpp
+ * @brief Qt WebSocket tests - Lazy (opt-in) frame decoding
+ *
+ * Tests that WebSocketServer only decodes frames for clients whose pixels are needed:
+ * - encodedFrameReceived is emitted for every frame
+ * - frameReceived is NOT emitted while decoding is disabled for a client
+ * - frameReceived is emitted once decoding is enabled
+ */
+
+#include <QtTest/QtTest>
+#include <QtCore/QObject>
+#include <QtCore/QByteArray>
+#include <QtWebSockets/QWebSocket>
+#include <QtTest/QSignalSpy>
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include "../fixtures/qt_test_base.h"
+#include "network/websocketserver.h"
+
+/**
+ * @class TestWebSocketLazyDecode
+ * @brief Tests for per-client opt-in decoding
+ */
+class TestWebSocketLazyDecode : public QObject {
+    Q_OBJECT
+
+private:
+    QByteArray generateJpegFrame(int width, int height) {
+        cv::Mat image(height, width, CV_8UC3, cv::Scalar(40, 120, 200));
+        std::vector<uchar> buffer;
+        if (!cv::imencode(".jpg", image, buffer) || buffer.empty())
+            return QByteArray();
+        return QByteArray(reinterpret_cast<const char*>(buffer.data()), static_cast<int>(buffer.size()));
+    }
+
+    QByteArray framed(const QByteArray& jpeg) {
+        QByteArray msg;
+        msg.append(char(0x00));
+        msg.append(jpeg);
+        return msg;
+    }
+
+private slots:
+    void initTestCase() {
+        qt_test::initializeQtTestApp();
+        qRegisterMetaType<QHostAddress>("QHostAddress");
+    }
+
+    /**
+     * Test: Frames are not decoded while decoding is disabled
+     * Verifies:
+     * - encodedFrameReceived carries the compressed payload and metadata
+     * - frameReceived stays silent
+     */
+    void testFramesNotDecodedByDefault() {
+        WebSocketServer server;
+        QVERIFY(server.start(0));
+
+        QSignalSpy spyConnected(&server, SIGNAL(clientConnected(QString, QHostAddress)));
+        QSignalSpy spyEncoded(&server, SIGNAL(encodedFrameReceived(QString, EncodedFrame)));
+        QSignalSpy spyDecoded(&server, SIGNAL(frameReceived(QString, QImage)));
+
+        QWebSocket client;
+        client.open(QUrl(QString("ws://127.0.0.1:%1").arg(server.port())));
+        QTRY_VERIFY_WITH_TIMEOUT(client.isValid(), 2000);
+        QTRY_VERIFY_WITH_TIMEOUT(spyConnected.count() >= 1, 2000);
+
+        const QByteArray jpeg = generateJpegFrame(160, 120);
+        QVERIFY(!jpeg.isEmpty());
+        client.sendBinaryMessage(framed(jpeg));
+
+        QTRY_VERIFY_WITH_TIMEOUT(spyEncoded.count() >= 1, 2000);
+        EncodedFrame frame = spyEncoded.takeFirst().at(1).value<EncodedFrame>();
+        QCOMPARE(frame.size(), jpeg.size());
+        QCOMPARE(frame.sequence, quint64(1));
+        QVERIFY(frame.receivedAtMs > 0);
+
+        qt_test::EventLoopSpinner::processEventsWithTimeout(300);
+        QCOMPARE(spyDecoded.count(), 0);
+
+        client.close();
+        server.stop();
+    }
+
+    /**
+     * Test: Frames are decoded once decoding is enabled for the client
+     * Verifies:
+     * - frameReceived delivers a QImage with the source dimensions
+     */
+    void testFramesDecodedWhenEnabled() {
+        WebSocketServer server;
+        QVERIFY(server.start(0));
+
+        QSignalSpy spyConnected(&server, SIGNAL(clientConnected(QString, QHostAddress)));
+        QSignalSpy spyDecoded(&server, SIGNAL(frameReceived(QString, QImage)));
+
+        QWebSocket client;
+        client.open(QUrl(QString("ws://127.0.0.1:%1").arg(server.port())));
+        QTRY_VERIFY_WITH_TIMEOUT(spyConnected.count() >= 1, 2000);
+
+        const QString clientId = spyConnected.takeFirst().at(0).toString();
+        server.setDecodeEnabled(clientId, true);
+        QVERIFY(server.isDecodeEnabled(clientId));
+
+        client.sendBinaryMessage(framed(generateJpegFrame(160, 120)));
+
+        QTRY_VERIFY_WITH_TIMEOUT(spyDecoded.count() >= 1, 2000);
+        QVariantList args = spyDecoded.takeFirst();
+        QCOMPARE(args.at(0).toString(), clientId);
+        QImage img = args.at(1).value<QImage>();
+        QCOMPARE(img.width(), 160);
+        QCOMPARE(img.height(), 120);
+
+        server.setDecodeEnabled(clientId, false);
+        QVERIFY(!server.isDecodeEnabled(clientId));
+
+        client.close();
+        server.stop();
+    }
+};
+
+QTEST_MAIN(TestWebSocketLazyDecode)
+#include "test_websocket_lazy_decode.moc"
@@ -5,7 +5,7 @@
  * Tests WebSocket message communication:
  * - Client sends binary control messages
  * - Server receives and processes messages
- * - controlMessageReceived signal emitted
+ * - controlMessageReceived signal emitted with the parsed message
  * - Message parameters preserved correctly
  */
 
@@ -47,7 +47,7 @@ private slots:
         quint16 port = server.port();
         QUrl url(QString("ws://127.0.0.1:%1").arg(port));
 
-        QSignalSpy spyMessage(&server, SIGNAL(controlMessageReceived(QString, QByteArray)));
+        QSignalSpy spyMessage(&server, &WebSocketServer::controlMessageReceived);
 
         QWebSocket client;
         client.open(url);
@@ -76,12 +76,9 @@ private slots:
 
         // Verify message was parsed
         QVariantList args = spyMessage.takeFirst();
-        QByteArray received = args.at(1).toByteArray();
-
-        imagesocket::control::ControlMessage parsed;
-        bool parseOk = parsed.ParseFromArray(received.data(), received.size());
-        QVERIFY(parseOk);
-        QCOMPARE(parsed.fps(), 30);
+        const ControlMessagePtr parsed = args.at(1).value<ControlMessagePtr>();
+        QVERIFY(parsed);
+        QCOMPARE(parsed->fps(), 30);
 
         client.close();
         server.stop();
@@ -106,7 +103,7 @@ private slots:
         quint16 port = server.port();
         QUrl url(QString("ws://127.0.0.1:%1").arg(port));
 
-        QSignalSpy spyMessage(&server, SIGNAL(controlMessageReceived(QString, QByteArray)));
+        QSignalSpy spyMessage(&server, &WebSocketServer::controlMessageReceived);
 
         QWebSocket client;
         client.open(url);
@@ -142,11 +139,9 @@ private slots:
         QList<int> receivedFps;
         for (int i = 0; i < spyMessage.count(); ++i) {
             QVariantList args = spyMessage.at(i);
-            QByteArray received = args.at(1).toByteArray();
-
-            imagesocket::control::ControlMessage parsed;
-            QVERIFY(parsed.ParseFromArray(received.data(), received.size()));
-            receivedFps.append(parsed.fps());
+            const ControlMessagePtr parsed = args.at(1).value<ControlMessagePtr>();
+            QVERIFY(parsed);
+            receivedFps.append(parsed->fps());
         }
 
         QCOMPARE(receivedFps.count(), 3);
@@ -173,7 +168,7 @@ private slots:
         quint16 port = server.port();
         QUrl url(QString("ws://127.0.0.1:%1").arg(port));
 
-        QSignalSpy spyMessage(&server, SIGNAL(controlMessageReceived(QString, QByteArray)));
+        QSignalSpy spyMessage(&server, &WebSocketServer::controlMessageReceived);
 
         QWebSocket client;
         client.open(url);
@@ -197,14 +192,12 @@ private slots:
         QTRY_VERIFY_WITH_TIMEOUT(spyMessage.count() >= 1, 2000);
 
         QVariantList args = spyMessage.takeFirst();
-        QByteArray received = args.at(1).toByteArray();
-
-        imagesocket::control::ControlMessage parsed;
-        QVERIFY(parsed.ParseFromArray(received.data(), received.size()));
+        const ControlMessagePtr parsed = args.at(1).value<ControlMessagePtr>();
+        QVERIFY(parsed);
 
-        QCOMPARE(parsed.fps(), 24);
-        QCOMPARE(parsed.type(), imagesocket::control::SET_FPS);
-        QCOMPARE(parsed.client_id(), 1);
+        QCOMPARE(parsed->fps(), 24);
+        QCOMPARE(parsed->type(), imagesocket::control::SET_FPS);
+        QCOMPARE(parsed->client_id(), 1);
 
         client.close();
         server.stop();
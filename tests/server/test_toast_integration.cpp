@@ -35,13 +35,11 @@ private slots:
         imagesocket::control::ControlMessage aliasMsg;
         aliasMsg.set_type(imagesocket::control::ALIAS);
         aliasMsg.set_alias("Toasty");
-        std::string out;
-        QVERIFY(aliasMsg.SerializeToString(&out));
-        QByteArray ba; ba.append(char(0x01)); ba.append(out.data(), (int)out.size());
+        const ControlMessagePtr parsed = std::make_shared<imagesocket::control::ControlMessage>(aliasMsg);
 
         // Invoke the control message slot to simulate alias arrival
         QMetaObject::invokeMethod(&bridge, "onControlMessageReceived", Qt::DirectConnection,
-                                  Q_ARG(QString, clientId), Q_ARG(QByteArray, ba));
+                                  Q_ARG(QString, clientId), Q_ARG(ControlMessagePtr, parsed));
 
         // Find the ToastNotification child inside QML object
         QObject* toast = obj->findChild<QObject*>("toastRect");
@@ -0,0 +1,201 @@
+/**
+ * @file test_control_reader.cpp
+ * @brief Unit tests for the client's reusable read buffer and in-place control parsing
+ *
+ * Tests validate:
+ * - Control messages are parsed straight from the read buffer
+ * - Other prefixes and malformed messages are told apart
+ * - consume() keeps the buffer's capacity
+ * - A ControlBatch is parsed into the caller's reused batch, messages in order
+ * - Once warmed up, reading and parsing allocate nothing (counted through operator new)
+ */
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include "control.pb.h"
+#include "controlreader.h"
+
+using imagesocket::control::ControlMessage;
+
+namespace {
+
+std::atomic<bool> g_counting{false};
+std::atomic<int> g_allocations{0};
+
+} // namespace
+
+// Counts every allocation of the test binary while g_counting is set
+void* operator new(std::size_t size)
+{
+    if (g_counting.load(std::memory_order_relaxed))
+        g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size))
+        return p;
+    throw std::bad_alloc();
+}
+
+// Out of line: inlined into a new-expression, GCC would flag the free() as mismatched
+[[gnu::noinline]] void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+[[gnu::noinline]] void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace {
+
+std::string wire(const ControlMessage& msg)
+{
+    std::string bytes(1, static_cast<char>(MessagePrefix::Control));
+    bytes += msg.SerializeAsString();
+    return bytes;
+}
+
+// What websocket::stream::async_read does with the buffer
+void receive(ControlReader<ControlMessage>& reader, const std::string& bytes)
+{
+    auto target = reader.buffer().prepare(bytes.size());
+    std::memcpy(target.data(), bytes.data(), bytes.size());
+    reader.buffer().commit(bytes.size());
+}
+
+ControlMessage config()
+{
+    ControlMessage msg;
+    msg.set_type(imagesocket::control::CONFIG);
+    msg.set_fps(25);
+    msg.set_quality(70);
+    msg.set_max_width(1280);
+    msg.set_max_height(720);
+    msg.set_alias("camera-entrance");
+    msg.set_session_token("3f2a9c1e-5b7d-4e8f-a012-6c4d9e7b1a23");
+    return msg;
+}
+
+ControlMessage ping(std::int64_t timestampUs)
+{
+    ControlMessage msg;
+    msg.set_type(imagesocket::control::PING);
+    msg.set_timestamp_us(timestampUs);
+    return msg;
+}
+
+} // namespace
+
+TEST(ControlReaderTest, ParsesControlInPlace) {
+    ControlReader<ControlMessage> reader;
+    receive(reader, wire(config()));
+    ASSERT_TRUE(reader.isControl());
+    const ControlMessage* msg = reader.parse();
+    ASSERT_NE(msg, nullptr);
+    EXPECT_EQ(msg->type(), imagesocket::control::CONFIG);
+    EXPECT_EQ(msg->fps(), 25);
+    EXPECT_EQ(msg->alias(), "camera-entrance");
+    EXPECT_EQ(msg->session_token(), "3f2a9c1e-5b7d-4e8f-a012-6c4d9e7b1a23");
+}
+
+TEST(ControlReaderTest, RejectsOtherPrefixesAndGarbage) {
+    ControlReader<ControlMessage> reader;
+    EXPECT_FALSE(reader.isControl()); // empty
+    EXPECT_EQ(reader.parse(), nullptr);
+
+    receive(reader, std::string("\x00\xff\xd8", 3));
+    EXPECT_FALSE(reader.isControl());
+    EXPECT_EQ(reader.parse(), nullptr);
+    reader.consume();
+
+    receive(reader, std::string("\x01\xff\xff\xff", 4));
+    EXPECT_TRUE(reader.isControl());
+    EXPECT_EQ(reader.parse(), nullptr);
+}
+
+TEST(ControlReaderTest, ReusedMessageHoldsOnlyTheLatest) {
+    ControlReader<ControlMessage> reader;
+    receive(reader, wire(config()));
+    ASSERT_NE(reader.parse(), nullptr);
+    reader.consume();
+
+    receive(reader, wire(ping(42)));
+    const ControlMessage* msg = reader.parse();
+    ASSERT_NE(msg, nullptr);
+    EXPECT_EQ(msg->type(), imagesocket::control::PING);
+    EXPECT_EQ(msg->timestamp_us(), 42);
+    EXPECT_TRUE(msg->alias().empty()); // parse() starts from a cleared message
+    EXPECT_EQ(msg->fps(), 0);
+}
+
+TEST(ControlReaderTest, ConsumeKeepsCapacity) {
+    ControlReader<ControlMessage> reader;
+    receive(reader, wire(config()));
+    const std::size_t capacity = reader.buffer().capacity();
+    reader.consume();
+    EXPECT_EQ(reader.buffer().size(), 0u);
+    EXPECT_EQ(reader.buffer().capacity(), capacity);
+}
+
+TEST(ControlReaderTest, ParsesBatchInOrder) {
+    imagesocket::control::ControlBatch batch;
+    *batch.add_messages() = ping(7);
+    *batch.add_messages() = config();
+    std::string bytes(1, static_cast<char>(MessagePrefix::ControlBatch));
+    bytes += batch.SerializeAsString();
+
+    ControlReader<ControlMessage> reader;
+    receive(reader, bytes);
+    EXPECT_FALSE(reader.isControl());
+    ASSERT_TRUE(reader.isBatch());
+    EXPECT_EQ(reader.parse(), nullptr); // not a single message
+
+    imagesocket::control::ControlBatch parsed;
+    ASSERT_TRUE(reader.parseBatch(parsed));
+    ASSERT_EQ(parsed.messages_size(), 2);
+    EXPECT_EQ(parsed.messages(0).type(), imagesocket::control::PING);
+    EXPECT_EQ(parsed.messages(0).timestamp_us(), 7);
+    EXPECT_EQ(parsed.messages(1).alias(), "camera-entrance");
+    reader.consume();
+
+    receive(reader, wire(ping(8)));
+    EXPECT_FALSE(reader.isBatch());
+    EXPECT_FALSE(reader.parseBatch(parsed));
+}
+
+TEST(ControlReaderTest, SteadyStateAllocatesNothing) {
+    const std::string configBytes = wire(config());
+    const std::string pingBytes = wire(ping(1000));
+    ControlReader<ControlMessage> reader;
+    // Warm-up: the buffer and the message's strings grow to the largest message
+    for (const std::string* bytes : {&configBytes, &pingBytes}) {
+        receive(reader, *bytes);
+        ASSERT_NE(reader.parse(), nullptr);
+        reader.consume();
+    }
+
+    // The counter sees allocations at all
+    g_allocations.store(0);
+    g_counting.store(true);
+    int* volatile probe = new int(1); // volatile: the pair can't be optimized away
+    delete probe;
+    g_counting.store(false);
+    ASSERT_EQ(g_allocations.load(), 1);
+
+    g_allocations.store(0);
+    g_counting.store(true);
+    int parsed = 0;
+    for (int i = 0; i < 1000; ++i) {
+        receive(reader, i % 2 == 0 ? pingBytes : configBytes);
+        if (reader.parse())
+            ++parsed;
+        reader.consume();
+    }
+    g_counting.store(false);
+
+    EXPECT_EQ(parsed, 1000);
+    EXPECT_EQ(g_allocations.load(), 0);
+}
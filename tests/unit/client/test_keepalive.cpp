@@ -0,0 +1,84 @@
+/**
+ * @file test_keepalive.cpp
+ * @brief Unit tests for WebSocket keepalive (dead-peer detection)
+ *
+ * Tests validate:
+ * - A connection that keeps receiving is never pinged
+ * - A silent peer is pinged once per tick, maxMissed times, then expires
+ * - Any message (or pong) in between starts the count over
+ * - Interval 0 disables it; the timeout handed to Beast matches the ticks
+ */
+
+#include <gtest/gtest.h>
+#include "keepalive.h"
+
+namespace {
+
+KeepaliveConfig config(int intervalMs, int maxMissed)
+{
+    KeepaliveConfig c;
+    c.intervalMs = intervalMs;
+    c.maxMissed = maxMissed;
+    return c;
+}
+
+} // namespace
+
+TEST(KeepaliveTest, BusyConnectionIsNeverPinged) {
+    KeepaliveTracker tracker(config(1000, 2));
+    for (int i = 0; i < 10; ++i) {
+        tracker.onReceived();
+        tracker.onReceived(); // a frame and a control message
+        EXPECT_EQ(tracker.tick(), KeepaliveTracker::None);
+    }
+    EXPECT_EQ(tracker.missed(), 0);
+}
+
+TEST(KeepaliveTest, SilentPeerExpiresAfterMissedPings) {
+    KeepaliveTracker tracker(config(1000, 2));
+    tracker.onReceived();
+    EXPECT_EQ(tracker.tick(), KeepaliveTracker::None); // heard from during the first interval
+    EXPECT_EQ(tracker.tick(), KeepaliveTracker::Ping);
+    EXPECT_EQ(tracker.tick(), KeepaliveTracker::Ping);
+    EXPECT_EQ(tracker.missed(), 2);
+    EXPECT_EQ(tracker.tick(), KeepaliveTracker::Expired);
+    EXPECT_EQ(tracker.tick(), KeepaliveTracker::Expired); // stays gone until reset
+}
+
+TEST(KeepaliveTest, AnswerStartsOver) {
+    KeepaliveTracker tracker(config(500, 2));
+    EXPECT_EQ(tracker.tick(), KeepaliveTracker::Ping);
+    EXPECT_EQ(tracker.tick(), KeepaliveTracker::Ping);
+    tracker.onReceived(); // the pong, late
+    EXPECT_EQ(tracker.tick(), KeepaliveTracker::None);
+    EXPECT_EQ(tracker.missed(), 0);
+    EXPECT_EQ(tracker.tick(), KeepaliveTracker::Ping);
+
+    tracker.reset();
+    EXPECT_EQ(tracker.missed(), 0);
+    EXPECT_EQ(tracker.tick(), KeepaliveTracker::Ping);
+}
+
+TEST(KeepaliveTest, ZeroMissedExpiresOnFirstQuietTick) {
+    KeepaliveTracker tracker(config(1000, 0));
+    tracker.onReceived();
+    EXPECT_EQ(tracker.tick(), KeepaliveTracker::None);
+    EXPECT_EQ(tracker.tick(), KeepaliveTracker::Expired);
+}
+
+TEST(KeepaliveTest, DisabledAndTimeout) {
+    KeepaliveTracker tracker(config(0, 2));
+    EXPECT_FALSE(tracker.enabled());
+    for (int i = 0; i < 5; ++i)
+        EXPECT_EQ(tracker.tick(), KeepaliveTracker::None);
+    EXPECT_EQ(keepaliveTimeoutMs(config(0, 2)), 0);
+
+    // Beast's idle timeout: silent for as long as the ticks would take at the least
+    EXPECT_EQ(keepaliveTimeoutMs(KeepaliveConfig()), 6000);
+    EXPECT_EQ(keepaliveTimeoutMs(config(500, 3)), 2000);
+
+    tracker.setConfig(config(1000, 1));
+    EXPECT_TRUE(tracker.enabled());
+    EXPECT_EQ(tracker.tick(), KeepaliveTracker::Ping);
+    EXPECT_EQ(tracker.tick(), KeepaliveTracker::Expired);
+}
@@ -0,0 +1,86 @@
+/**
+ * @file test_outbound_message.cpp
+ * @brief Unit tests for zero-copy OutboundMessage construction
+ *
+ * Tests validate:
+ * - Moved vectors keep their storage (no reallocation, no copy)
+ * - Shared buffers are referenced, not duplicated, and kept alive by the message
+ * - Arbitrary owners (std::string) are viewed in place
+ * - Wire size accounts for the separate prefix byte
+ */
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include "outboundmessage.h"
+
+TEST(OutboundMessageTest, MovedVectorKeepsStorage) {
+    std::vector<std::uint8_t> jpeg(4096, 0xAB);
+    const std::uint8_t* original = jpeg.data();
+
+    OutboundMessage msg = OutboundMessage::fromVector(std::move(jpeg), MessagePrefix::Image);
+    EXPECT_EQ(msg.data, original);
+    EXPECT_EQ(msg.size, 4096u);
+    EXPECT_EQ(msg.prefix, MessagePrefix::Image);
+}
+
+TEST(OutboundMessageTest, SharedBufferIsReferenced) {
+    auto shared = std::make_shared<const std::vector<std::uint8_t>>(128, 0x01);
+    OutboundMessage msg = OutboundMessage::fromShared(shared, MessagePrefix::Image);
+
+    EXPECT_EQ(msg.data, shared->data());
+    EXPECT_EQ(shared.use_count(), 2);
+}
+
+TEST(OutboundMessageTest, MessageKeepsPayloadAlive) {
+    OutboundMessage msg;
+    const std::uint8_t* data = nullptr;
+    {
+        auto shared = std::make_shared<const std::vector<std::uint8_t>>(64, 0x7F);
+        data = shared->data();
+        msg = OutboundMessage::fromShared(shared, MessagePrefix::Image);
+    }
+    // The caller's handle is gone; the message still owns the bytes
+    ASSERT_EQ(msg.data, data);
+    EXPECT_EQ(msg.data[63], 0x7F);
+}
+
+TEST(OutboundMessageTest, NullSharedBufferIsEmpty) {
+    OutboundMessage msg = OutboundMessage::fromShared(SharedFrameBuffer(), MessagePrefix::Image);
+    EXPECT_EQ(msg.data, nullptr);
+    EXPECT_EQ(msg.size, 0u);
+    EXPECT_EQ(msg.wireSize(), 1u);
+}
+
+TEST(OutboundMessageTest, OwnerIsViewedInPlace) {
+    auto serialized = std::make_shared<const std::string>("control-bytes");
+    OutboundMessage msg = OutboundMessage::fromOwner(serialized, serialized->data(), serialized->size(),
+                                                     MessagePrefix::Control);
+    EXPECT_EQ(reinterpret_cast<const char*>(msg.data), serialized->data());
+    EXPECT_EQ(msg.size, serialized->size());
+    EXPECT_EQ(msg.prefix, MessagePrefix::Control);
+}
+
+TEST(OutboundMessageTest, WireSizeIncludesPrefix) {
+    OutboundMessage msg = OutboundMessage::fromVector(std::vector<std::uint8_t>(10), MessagePrefix::Image);
+    EXPECT_EQ(msg.wireSize(), 11u);
+}
+
+TEST(OutboundMessageTest, FrameHeaderAddsToWireSize) {
+    OutboundMessage msg = OutboundMessage::fromVector(std::vector<std::uint8_t>(10), MessagePrefix::Image);
+    FrameHeader header;
+    header.sequence = 7;
+    msg.setFrameHeader(header);
+    EXPECT_EQ(msg.headerSize, kFrameHeaderSize);
+    EXPECT_EQ(msg.wireSize(), 11u + kFrameHeaderSize);
+    EXPECT_EQ(msg.prefix, MessagePrefix::Image); // still names the payload
+    EXPECT_EQ(msg.header[4], 7);
+}
+
+TEST(OutboundMessageTest, PrefixValuesMatchProtocol) {
+    EXPECT_EQ(static_cast<int>(MessagePrefix::Image), 0x00);
+    EXPECT_EQ(static_cast<int>(MessagePrefix::Control), 0x01);
+    EXPECT_EQ(static_cast<int>(MessagePrefix::RawFrame), 0x02);
+    EXPECT_EQ(static_cast<int>(MessagePrefix::Video), 0x03);
+    EXPECT_EQ(static_cast<int>(MessagePrefix::Framed), 0x04);
+}
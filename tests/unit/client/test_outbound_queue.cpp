@@ -0,0 +1,248 @@
+/**
+ * @file test_outbound_queue.cpp
+ * @brief Unit tests for the client's serialized outbound write queue
+ *
+ * Tests validate:
+ * - One write in flight at a time (beginWrite / finishWrite hand-off)
+ * - Depth limit counting frames, including the one in flight
+ * - Drop policies: drop-oldest, drop-newest, drop-newest while a control message is pending
+ * - Control messages are never dropped and jump ahead of waiting frames
+ * - Dropping every waiting frame at once
+ * - Control messages waiting together at the front go out as one write
+ * - SendResult saturation reporting
+ */
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include "outboundqueue.h"
+
+namespace {
+
+// Drain the queue as the IO strand would and return the written messages in order
+std::vector<std::string> drain(OutboundQueue<std::string>& queue)
+{
+    std::vector<std::string> written;
+    while (!queue.empty()) {
+        written.push_back(queue.front());
+        queue.beginWrite();
+        queue.finishWrite();
+    }
+    return written;
+}
+
+} // namespace
+
+TEST(OutboundQueueTest, StartsEmptyWithDefaultDepth) {
+    OutboundQueue<std::string> queue;
+    EXPECT_TRUE(queue.empty());
+    EXPECT_FALSE(queue.writing());
+    EXPECT_EQ(queue.depth(), 2u);
+    EXPECT_EQ(queue.policy(), OutboundDropPolicy::DropOldest);
+}
+
+TEST(OutboundQueueTest, ZeroDepthIsClampedToOne) {
+    OutboundQueue<std::string> queue(0);
+    EXPECT_EQ(queue.depth(), 1u);
+    queue.setDepth(0);
+    EXPECT_EQ(queue.depth(), 1u);
+}
+
+TEST(OutboundQueueTest, FramesAreWrittenInOrder) {
+    OutboundQueue<std::string> queue(4);
+    EXPECT_TRUE(queue.pushFrame("f1"));
+    EXPECT_TRUE(queue.pushFrame("f2"));
+    EXPECT_TRUE(queue.pushFrame("f3"));
+    EXPECT_EQ(drain(queue), (std::vector<std::string>{"f1", "f2", "f3"}));
+    EXPECT_EQ(queue.frameCount(), 0u);
+}
+
+TEST(OutboundQueueTest, DropOldestEvictsWaitingFrame) {
+    OutboundQueue<std::string> queue(2, OutboundDropPolicy::DropOldest);
+    queue.pushFrame("f1");
+    queue.pushFrame("f2");
+
+    std::size_t evicted = 0;
+    EXPECT_TRUE(queue.pushFrame("f3", &evicted));
+    EXPECT_EQ(evicted, 1u);
+    EXPECT_EQ(queue.droppedTotal(), 1u);
+    EXPECT_EQ(drain(queue), (std::vector<std::string>{"f2", "f3"}));
+}
+
+TEST(OutboundQueueTest, DropOldestNeverEvictsFrameInFlight) {
+    OutboundQueue<std::string> queue(2, OutboundDropPolicy::DropOldest);
+    queue.pushFrame("f1");
+    queue.beginWrite(); // f1 is on the wire
+    queue.pushFrame("f2");
+
+    std::size_t evicted = 0;
+    EXPECT_TRUE(queue.pushFrame("f3", &evicted));
+    EXPECT_EQ(evicted, 1u);
+    EXPECT_EQ(queue.front(), "f1");
+
+    queue.finishWrite();
+    EXPECT_EQ(drain(queue), (std::vector<std::string>{"f3"}));
+}
+
+TEST(OutboundQueueTest, DepthOneRejectsWhileWriting) {
+    OutboundQueue<std::string> queue(1, OutboundDropPolicy::DropOldest);
+    queue.pushFrame("f1");
+    queue.beginWrite();
+    EXPECT_FALSE(queue.pushFrame("f2"));
+    EXPECT_EQ(queue.droppedTotal(), 1u);
+}
+
+TEST(OutboundQueueTest, DropNewestRejectsIncomingFrame) {
+    OutboundQueue<std::string> queue(2, OutboundDropPolicy::DropNewest);
+    queue.pushFrame("f1");
+    queue.pushFrame("f2");
+    EXPECT_FALSE(queue.pushFrame("f3"));
+    EXPECT_EQ(queue.droppedTotal(), 1u);
+    EXPECT_EQ(drain(queue), (std::vector<std::string>{"f1", "f2"}));
+}
+
+TEST(OutboundQueueTest, ControlJumpsAheadOfWaitingFrames) {
+    OutboundQueue<std::string> queue(4);
+    queue.pushFrame("f1");
+    queue.beginWrite();
+    queue.pushFrame("f2");
+    queue.pushControl("c1");
+    queue.pushControl("c2");
+
+    queue.finishWrite();
+    EXPECT_EQ(drain(queue), (std::vector<std::string>{"c1", "c2", "f2"}));
+}
+
+TEST(OutboundQueueTest, ControlIsNeverDroppedAndNotCounted) {
+    OutboundQueue<std::string> queue(1, OutboundDropPolicy::DropNewest);
+    queue.pushFrame("f1");
+    for (int i = 0; i < 5; ++i)
+        queue.pushControl("c" + std::to_string(i));
+    EXPECT_EQ(queue.frameCount(), 1u);
+    EXPECT_EQ(queue.size(), 6u);
+    EXPECT_EQ(queue.droppedTotal(), 0u);
+}
+
+TEST(OutboundQueueTest, DropNewestOnlyWhileControlPending) {
+    OutboundQueue<std::string> queue(2, OutboundDropPolicy::DropNewestWhileControlPending);
+    queue.pushFrame("f1");
+    queue.pushFrame("f2");
+
+    // No control pending: behaves like drop-oldest
+    std::size_t evicted = 0;
+    EXPECT_TRUE(queue.pushFrame("f3", &evicted));
+    EXPECT_EQ(evicted, 1u);
+
+    // Control pending: the incoming frame is rejected instead
+    queue.pushControl("c1");
+    EXPECT_TRUE(queue.controlPending());
+    EXPECT_FALSE(queue.pushFrame("f4"));
+    EXPECT_EQ(drain(queue), (std::vector<std::string>{"c1", "f2", "f3"}));
+}
+
+TEST(OutboundQueueTest, ControlInFlightIsNotPending) {
+    OutboundQueue<std::string> queue(2);
+    queue.pushControl("c1");
+    EXPECT_TRUE(queue.controlPending());
+    queue.beginWrite();
+    EXPECT_FALSE(queue.controlPending());
+}
+
+TEST(OutboundQueueTest, ClearResetsWriteState) {
+    OutboundQueue<std::string> queue(2);
+    queue.pushFrame("f1");
+    queue.beginWrite();
+    queue.clear();
+    EXPECT_TRUE(queue.empty());
+    EXPECT_FALSE(queue.writing());
+    EXPECT_EQ(queue.frameCount(), 0u);
+
+    // A stale completion after clear() is ignored
+    queue.finishWrite();
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(OutboundQueueTest, DropWaitingFramesKeepsControlAndFrameInFlight) {
+    OutboundQueue<std::string> queue(3);
+    queue.pushFrame("a");
+    queue.pushFrame("b");
+    queue.pushFrame("c");
+    queue.beginWrite(); // "a" on the wire
+    queue.pushControl("ctl");
+    EXPECT_EQ(queue.dropWaitingFrames(), 2u);
+    EXPECT_EQ(queue.frameCount(), 1u);
+    EXPECT_EQ(queue.droppedTotal(), 2u);
+    queue.finishWrite();
+    EXPECT_EQ(drain(queue), (std::vector<std::string>{"ctl"}));
+}
+
+TEST(OutboundQueueTest, LeadingControlWrittenTogether) {
+    OutboundQueue<std::string> queue(2);
+    queue.pushFrame("f1");
+    queue.beginWrite(); // f1 on the wire
+    queue.pushControl("c1");
+    queue.pushControl("c2");
+    queue.pushFrame("f2");
+    queue.pushControl("c3");
+    queue.finishWrite();
+
+    // The three control messages jumped f2 and can be batched, f2 can't
+    ASSERT_EQ(queue.leadingControl(8), 3u);
+    EXPECT_EQ(queue.leadingControl(2), 2u);
+    EXPECT_EQ(queue.at(2), "c3");
+    queue.beginWrite(3);
+    EXPECT_TRUE(queue.writing());
+    EXPECT_FALSE(queue.controlPending());
+
+    // Arrivals during the batched write queue behind all of it
+    queue.pushControl("c4");
+    EXPECT_TRUE(queue.controlPending());
+    queue.pushFrame("f3");
+    EXPECT_EQ(queue.frameCount(), 2u);
+    queue.finishWrite();
+    EXPECT_FALSE(queue.writing());
+    EXPECT_EQ(queue.frameCount(), 2u);
+    EXPECT_EQ(drain(queue), (std::vector<std::string>{"c4", "f2", "f3"}));
+}
+
+TEST(OutboundQueueTest, EvictionSparesWholeBatchInFlight) {
+    OutboundQueue<std::string> queue(1);
+    queue.pushControl("c1");
+    queue.pushControl("c2");
+    queue.pushFrame("f1");
+    queue.beginWrite(queue.leadingControl(8));
+    EXPECT_EQ(queue.leadingControl(8), 2u); // counted from the front, in flight or not
+    std::size_t evicted = 0;
+    EXPECT_TRUE(queue.pushFrame("f2", &evicted)); // f1 waits, so it makes room
+    EXPECT_EQ(evicted, 1u);
+    EXPECT_EQ(queue.dropWaitingFrames(), 1u);
+    EXPECT_EQ(queue.size(), 2u); // only the batch on the wire is left
+    queue.finishWrite();
+    EXPECT_TRUE(queue.empty());
+    EXPECT_EQ(queue.frameCount(), 0u);
+}
+
+TEST(SendResultTest, SaturationFollowsDepth) {
+    SendResult result;
+    result.status = SendStatus::Queued;
+    result.depth = 2;
+    result.queuedFrames = 1;
+    EXPECT_TRUE(result.accepted());
+    EXPECT_FALSE(result.saturated());
+    result.queuedFrames = 2;
+    EXPECT_TRUE(result.saturated());
+}
+
+TEST(SendResultTest, DefaultIsNotConnected) {
+    SendResult result;
+    EXPECT_FALSE(result.connected());
+    EXPECT_FALSE(result.accepted());
+}
+
+TEST(SendResultTest, PausedIsConnectedButNotAccepted) {
+    SendResult result;
+    result.status = SendStatus::Paused;
+    EXPECT_TRUE(result.connected());
+    EXPECT_TRUE(result.paused());
+    EXPECT_FALSE(result.accepted());
+}
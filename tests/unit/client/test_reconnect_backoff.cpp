@@ -19,6 +19,9 @@
  * Attempt 4: 2^4 = 16 seconds
  * Attempt 5: 2^5 = 32 -> min(30, 32) = 30 seconds
  * Attempt 6+: 2^6 = 64 -> min(30, 64) = 30 seconds (capped)
+ *
+ * The client now waits a random time up to this bound (full jitter, see
+ * reconnectbackoff.h and pipeline/test_accept_pacing.cpp).
  */
 
 #include <gtest/gtest.h>
@@ -0,0 +1,122 @@
+/**
+ * @file test_stream_framer.cpp
+ * @brief Unit tests for the legacy raw-TCP stream framing
+ *
+ * Tests validate:
+ * - The mode is told from the first bytes of the connection
+ * - Length-prefixed frames survive any split, several per chunk
+ * - Marker frames survive markers split over chunks and sharing a chunk with image bytes
+ * - Oversized frames fail the stream
+ * - The buffer is reused, and whole payloads are handed out without a copy
+ */
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include "streamFramer.h"
+
+namespace {
+
+std::string lengthFrame(const std::string& payload)
+{
+    std::uint8_t header[kStreamFrameHeaderSize];
+    writeStreamFrameHeader(static_cast<std::uint32_t>(payload.size()), header);
+    return std::string(reinterpret_cast<const char*>(header), sizeof(header)) + payload;
+}
+
+// The old client sends the literals with their NUL
+std::string markerFrame(const std::string& payload)
+{
+    return std::string("datastart", 10) + payload + std::string("dataend", 8);
+}
+
+// Feed `stream` in chunks of `chunk` bytes, collecting the payloads
+std::vector<std::string> feedChunked(StreamFramer& framer, const std::string& stream, std::size_t chunk)
+{
+    std::vector<std::string> frames;
+    for (std::size_t i = 0; i < stream.size(); i += chunk) {
+        const std::string part = stream.substr(i, chunk);
+        EXPECT_TRUE(framer.feed(reinterpret_cast<const std::uint8_t*>(part.data()), part.size(),
+                                [&](const std::uint8_t* data, std::size_t size) {
+                                    frames.emplace_back(reinterpret_cast<const char*>(data), size);
+                                }));
+    }
+    return frames;
+}
+
+} // namespace
+
+TEST(StreamFramerTest, LengthPrefixedAnySplit) {
+    const std::string stream = lengthFrame("first-jpeg") + lengthFrame("") + lengthFrame("second");
+    for (std::size_t chunk = 1; chunk <= stream.size(); ++chunk) {
+        StreamFramer framer;
+        const auto frames = feedChunked(framer, stream, chunk);
+        ASSERT_EQ(frames.size(), 3u) << "chunk " << chunk;
+        EXPECT_EQ(frames[0], "first-jpeg");
+        EXPECT_EQ(frames[1], "");
+        EXPECT_EQ(frames[2], "second");
+        EXPECT_EQ(framer.mode(), StreamFramer::Mode::LengthPrefixed);
+        EXPECT_EQ(framer.pending(), 0u);
+    }
+}
+
+TEST(StreamFramerTest, MarkersAnySplit) {
+    // Markers share chunks with image bytes and with each other
+    const std::string stream = markerFrame("\xFF\xD8jpeg-one\xFF\xD9") + markerFrame("two");
+    for (std::size_t chunk = 1; chunk <= stream.size(); ++chunk) {
+        StreamFramer framer;
+        const auto frames = feedChunked(framer, stream, chunk);
+        ASSERT_EQ(frames.size(), 2u) << "chunk " << chunk;
+        EXPECT_EQ(frames[0], "\xFF\xD8jpeg-one\xFF\xD9");
+        EXPECT_EQ(frames[1], "two");
+        EXPECT_EQ(framer.mode(), StreamFramer::Mode::Markers);
+    }
+}
+
+TEST(StreamFramerTest, MarkersWithoutNulAndLeadingGarbage) {
+    StreamFramer framer;
+    const auto frames = feedChunked(framer, "noise" "datastart" "abc" "dataend" "datastart" "d", 4);
+    ASSERT_EQ(frames.size(), 1u);
+    EXPECT_EQ(frames[0], "abc");
+    EXPECT_GT(framer.pending(), 0u);
+}
+
+TEST(StreamFramerTest, OversizedFrameFails) {
+    StreamFramer framer(16);
+    std::uint8_t header[kStreamFrameHeaderSize];
+    writeStreamFrameHeader(17, header);
+    int frames = 0;
+    EXPECT_FALSE(framer.feed(header, sizeof(header), [&](const std::uint8_t*, std::size_t) { ++frames; }));
+    EXPECT_TRUE(framer.failed());
+    EXPECT_EQ(frames, 0);
+
+    StreamFramer markers(16);
+    const std::string endless = "datastart" + std::string(32, 'x');
+    EXPECT_FALSE(markers.feed(reinterpret_cast<const std::uint8_t*>(endless.data()), endless.size(),
+                              [&](const std::uint8_t*, std::size_t) { ++frames; }));
+
+    framer.reset();
+    EXPECT_FALSE(framer.failed());
+    EXPECT_EQ(framer.mode(), StreamFramer::Mode::Detect);
+}
+
+TEST(StreamFramerTest, ReusesBufferAndPassesWholePayloadsInPlace) {
+    StreamFramer framer(kStreamFrameMaxSize, 64);
+    const std::size_t capacity = framer.capacity();
+    const std::string stream = lengthFrame(std::string(48, 'a')) + lengthFrame(std::string(48, 'b'));
+
+    // Split payloads are gathered in the reserved buffer
+    const auto split = feedChunked(framer, stream, 5);
+    ASSERT_EQ(split.size(), 2u);
+    EXPECT_EQ(framer.capacity(), capacity);
+
+    // A payload arriving whole points into the caller's chunk
+    framer.reset();
+    const std::uint8_t* begin = reinterpret_cast<const std::uint8_t*>(stream.data());
+    std::vector<const std::uint8_t*> pointers;
+    EXPECT_TRUE(framer.feed(begin, stream.size(),
+                            [&](const std::uint8_t* data, std::size_t) { pointers.push_back(data); }));
+    ASSERT_EQ(pointers.size(), 2u);
+    EXPECT_EQ(pointers[0], begin + kStreamFrameHeaderSize);
+    EXPECT_EQ(pointers[1], begin + 2 * kStreamFrameHeaderSize + 48);
+}
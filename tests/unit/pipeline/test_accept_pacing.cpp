@@ -0,0 +1,143 @@
+/**
+ * @file test_accept_pacing.cpp
+ * @brief Unit tests for reconnect-storm mitigation: server accept pacing and client backoff
+ *
+ * Tests validate:
+ * - The pacer admits a burst, then the configured rate; disabled, it admits everything
+ * - Refused connections get distinct slots one interval apart, and are all
+ *   admitted when they come back at them
+ * - A simulated fleet reconnecting at once is admitted within N / rate seconds
+ * - Backoff delays stay within the full-jitter window, capped, and honour a
+ *   server-advertised wait as a floor
+ */
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <vector>
+#include "acceptpacer.h"
+#include "reconnectbackoff.h"
+
+TEST(AcceptPacerTest, DisabledAdmitsEverything) {
+    AcceptPacer pacer;
+    EXPECT_FALSE(pacer.enabled());
+    for (int i = 0; i < 1000; ++i)
+        EXPECT_EQ(pacer.admit(0), 0);
+    EXPECT_EQ(pacer.deferred(), 0u);
+}
+
+TEST(AcceptPacerTest, BurstThenRate) {
+    AcceptPacer pacer;
+    pacer.configure(10.0, 5);
+    for (int i = 0; i < 5; ++i)
+        EXPECT_EQ(pacer.admit(1000), 0) << "burst connection " << i;
+    EXPECT_GT(pacer.admit(1000), 0);
+    // 100 ms refills one token
+    EXPECT_EQ(pacer.admit(1100), 0);
+    EXPECT_GT(pacer.admit(1100), 0);
+    EXPECT_EQ(pacer.deferred(), 2u);
+}
+
+TEST(AcceptPacerTest, RefusedConnectionsGetDistinctSlots) {
+    AcceptPacer pacer;
+    pacer.configure(20.0, 1);
+    ASSERT_EQ(pacer.admit(0), 0);
+    std::vector<std::int64_t> waits;
+    for (int i = 0; i < 10; ++i)
+        waits.push_back(pacer.admit(0));
+    for (std::size_t i = 0; i < waits.size(); ++i)
+        EXPECT_EQ(waits[i], static_cast<std::int64_t>(50 * (i + 1))) << "slot " << i;
+
+    // Each comes back on time and finds its token
+    for (std::size_t i = 0; i < waits.size(); ++i)
+        EXPECT_EQ(pacer.admit(waits[i]), 0) << "returning connection " << i;
+}
+
+TEST(AcceptPacerTest, EarlyReturnGetsLaterSlot) {
+    AcceptPacer pacer;
+    pacer.configure(10.0, 1);
+    ASSERT_EQ(pacer.admit(0), 0);
+    const std::int64_t first = pacer.admit(0);
+    ASSERT_EQ(first, 100);
+    const std::int64_t second = pacer.admit(50);   // before its slot
+    EXPECT_GE(50 + second, 200);
+}
+
+TEST(AcceptPacerTest, FleetRecoversWithinBound) {
+    // 500 cameras reconnect within the same 10 ms after a restart; the server admits 50/s.
+    // Clients honour RETRY_AFTER with the backoff's jitter.
+    const int fleet = 500;
+    const double rate = 50.0;
+    AcceptPacer pacer;
+    pacer.configure(rate, 50);
+    ReconnectBackoff backoff(1000, 30000, 1234);
+
+    std::multimap<std::int64_t, int> arrivals;
+    for (int i = 0; i < fleet; ++i)
+        arrivals.emplace(i % 10, i);
+    std::set<int> admitted;
+    std::int64_t lastAdmitMs = 0;
+    int attempts = 0;
+    while (!arrivals.empty()) {
+        const auto next = arrivals.begin();
+        const std::int64_t now = next->first;
+        const int client = next->second;
+        arrivals.erase(next);
+        ++attempts;
+        const std::int64_t wait = pacer.admit(now);
+        if (wait == 0) {
+            admitted.insert(client);
+            lastAdmitMs = now;
+        } else {
+            arrivals.emplace(now + backoff.delayMs(0, wait), client);
+        }
+    }
+    EXPECT_EQ(admitted.size(), static_cast<std::size_t>(fleet));
+    // (fleet - burst) / rate = 9 s, plus the clients' jitter
+    EXPECT_LE(lastAdmitMs, 11000);
+    // Most clients are admitted on their first return
+    EXPECT_LT(attempts, fleet * 3);
+}
+
+TEST(ReconnectBackoffTest, FullJitterWithinWindow) {
+    ReconnectBackoff backoff(1000, 30000, 42);
+    EXPECT_EQ(backoff.windowMs(0), 1000);
+    EXPECT_EQ(backoff.windowMs(3), 8000);
+    EXPECT_EQ(backoff.windowMs(5), 30000);
+    EXPECT_EQ(backoff.windowMs(60), 30000);
+    for (int attempt = 0; attempt < 8; ++attempt) {
+        std::int64_t low = backoff.windowMs(attempt);
+        std::int64_t high = 0;
+        for (int i = 0; i < 200; ++i) {
+            const std::int64_t delay = backoff.delayMs(attempt);
+            ASSERT_GE(delay, 0);
+            ASSERT_LE(delay, backoff.windowMs(attempt));
+            low = std::min(low, delay);
+            high = std::max(high, delay);
+        }
+        // Spread over the window, not clustered at its end
+        EXPECT_LT(low, backoff.windowMs(attempt) / 4) << "attempt " << attempt;
+        EXPECT_GT(high, backoff.windowMs(attempt) * 3 / 4) << "attempt " << attempt;
+    }
+}
+
+TEST(ReconnectBackoffTest, RetryAfterIsAFloor) {
+    ReconnectBackoff backoff(1000, 30000, 7);
+    for (int i = 0; i < 200; ++i) {
+        const std::int64_t delay = backoff.delayMs(4, 2000);
+        EXPECT_GE(delay, 2000);
+        EXPECT_LE(delay, 2200);
+    }
+    const std::int64_t capped = backoff.delayMs(0, 24 * 3600 * 1000LL);
+    EXPECT_GE(capped, ReconnectBackoff::maxRetryAfterMs());
+    EXPECT_LE(capped, ReconnectBackoff::maxRetryAfterMs() + 1000);
+}
+
+TEST(ReconnectBackoffTest, SameSeedSameDelays) {
+    ReconnectBackoff a(500, 10000, 99);
+    ReconnectBackoff b(500, 10000, 99);
+    for (int attempt = 0; attempt < 10; ++attempt)
+        EXPECT_EQ(a.delayMs(attempt), b.delayMs(attempt));
+}
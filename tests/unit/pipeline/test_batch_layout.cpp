@@ -0,0 +1,92 @@
+/**
+ * @file test_batch_layout.cpp
+ * @brief Unit tests for the inference batch tensor layout
+ *
+ * Tests validate:
+ * - Row, plane and image strides for NHWC and NCHW with alignment
+ * - RGB32 pixels land in the right channel positions
+ * - Row padding is cleared
+ */
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <vector>
+#include "batchlayout.h"
+
+namespace {
+
+// Native-order 0xffRRGGBB pixels, value derived from the position
+std::vector<std::uint32_t> makeRgb32(int width, int height)
+{
+    std::vector<std::uint32_t> pixels(static_cast<std::size_t>(width * height));
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            const std::uint32_t r = 10 + x, g = 100 + y, b = 200 + x + y;
+            pixels[static_cast<std::size_t>(y * width + x)] = 0xff000000u | (r << 16) | (g << 8) | b;
+        }
+    }
+    return pixels;
+}
+
+const std::uint8_t* bytesOf(const std::vector<std::uint32_t>& pixels)
+{
+    return reinterpret_cast<const std::uint8_t*>(pixels.data());
+}
+
+} // namespace
+
+TEST(BatchLayoutTest, NhwcStridesAreAligned) {
+    const BatchGeometry g = BatchGeometry::make(5, 3, BatchLayout::NHWC, 64);
+    EXPECT_EQ(g.rowStride, 64u); // 15 bytes rounded up
+    EXPECT_EQ(g.imageStride, 64u * 3u);
+    EXPECT_EQ(g.planeStride, g.imageStride);
+    EXPECT_EQ(g.bytesFor(4), 4u * 64u * 3u);
+}
+
+TEST(BatchLayoutTest, NchwStridesAreAligned) {
+    const BatchGeometry g = BatchGeometry::make(100, 2, BatchLayout::NCHW, 64);
+    EXPECT_EQ(g.rowStride, 128u);
+    EXPECT_EQ(g.planeStride, 256u);
+    EXPECT_EQ(g.imageStride, 768u);
+    EXPECT_EQ(g.imageStride % 64u, 0u);
+}
+
+TEST(BatchLayoutTest, PacksNhwcInterleaved) {
+    const int w = 4, h = 2;
+    const std::vector<std::uint32_t> src = makeRgb32(w, h);
+    const BatchGeometry g = BatchGeometry::make(w, h, BatchLayout::NHWC, 16);
+    std::vector<std::uint8_t> dst(g.imageStride, 0xAB);
+    packRgb32(bytesOf(src), w * 4, g, dst.data());
+
+    const std::uint8_t* px = dst.data() + g.rowStride * 1 + 3 * 2; // (x=2, y=1)
+    EXPECT_EQ(px[0], 12);  // R
+    EXPECT_EQ(px[1], 101); // G
+    EXPECT_EQ(px[2], 203); // B
+    EXPECT_EQ(dst[static_cast<std::size_t>(w * 3)], 0); // padding cleared
+}
+
+TEST(BatchLayoutTest, PacksNchwPlanar) {
+    const int w = 3, h = 2;
+    const std::vector<std::uint32_t> src = makeRgb32(w, h);
+    const BatchGeometry g = BatchGeometry::make(w, h, BatchLayout::NCHW, 8);
+    std::vector<std::uint8_t> dst(g.imageStride, 0xAB);
+    packRgb32(bytesOf(src), w * 4, g, dst.data());
+
+    const std::size_t at = g.rowStride * 1 + 1; // (x=1, y=1)
+    EXPECT_EQ(dst[at], 11);                      // R plane
+    EXPECT_EQ(dst[g.planeStride + at], 101);     // G plane
+    EXPECT_EQ(dst[2 * g.planeStride + at], 202); // B plane
+    EXPECT_EQ(dst[3], 0);                        // row padding cleared
+}
+
+TEST(BatchLayoutTest, SourceStrideIsHonoured) {
+    const int w = 2, h = 2, srcPitch = 4; // pixels per source row, 2 unused
+    std::vector<std::uint32_t> src(static_cast<std::size_t>(srcPitch * h), 0);
+    src[static_cast<std::size_t>(srcPitch + 1)] = 0xff010203u; // (1, 1)
+    const BatchGeometry g = BatchGeometry::make(w, h, BatchLayout::NHWC, 1);
+    std::vector<std::uint8_t> dst(g.imageStride);
+    packRgb32(bytesOf(src), srcPitch * 4, g, dst.data());
+    EXPECT_EQ(dst[g.rowStride + 3], 1);
+    EXPECT_EQ(dst[g.rowStride + 4], 2);
+    EXPECT_EQ(dst[g.rowStride + 5], 3);
+}
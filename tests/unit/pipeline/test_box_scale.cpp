@@ -0,0 +1,84 @@
+/**
+ * @file test_box_scale.cpp
+ * @brief Unit tests for the box filter the image providers scale frames with
+ *
+ * Tests validate:
+ * - Each output pixel is the rounded mean of its source block, per channel
+ * - Uneven ratios cut blocks at integer positions and cover every source pixel
+ * - Row padding on either side is skipped
+ * - Enlarging and empty sizes are rejected
+ */
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <vector>
+#include "boxscale.h"
+
+TEST(BoxScaleTest, MeanOfEachBlock)
+{
+    // 4x2 RGB32 to 2x1: each output pixel averages a 2x2 block
+    const std::uint8_t src[] = {
+        0,  0,  0,  255, 10, 20, 30, 255, 100, 100, 100, 255, 200, 200, 200, 255,
+        20, 40, 60, 255, 30, 41, 90, 255, 100, 100, 100, 255, 101, 100, 100, 255,
+    };
+    std::uint8_t dst[8] = {};
+    std::vector<std::uint32_t> sums;
+    ASSERT_TRUE(boxDownscale(src, 4, 2, 16, dst, 2, 1, 8, 4, sums));
+    EXPECT_EQ(dst[0], 15); // (0 + 10 + 20 + 30) / 4
+    EXPECT_EQ(dst[1], 25); // 101 / 4 rounds to 25
+    EXPECT_EQ(dst[2], 45);
+    EXPECT_EQ(dst[3], 255);
+    EXPECT_EQ(dst[4], 125); // 501 / 4
+    EXPECT_EQ(dst[7], 255);
+
+    // Same size: a copy
+    std::uint8_t copy[32] = {};
+    ASSERT_TRUE(boxDownscale(src, 4, 2, 16, copy, 4, 2, 16, 4, sums));
+    EXPECT_EQ(copy[21], 41);
+}
+
+TEST(BoxScaleTest, UnevenRatioCoversEverySource)
+{
+    // 5 gray columns to 2: blocks [0, 2) and [2, 5)
+    const std::uint8_t src[] = {10, 20, 30, 40, 50};
+    std::uint8_t dst[2] = {};
+    std::vector<std::uint32_t> sums;
+    ASSERT_TRUE(boxDownscale(src, 5, 1, 5, dst, 2, 1, 2, 1, sums));
+    EXPECT_EQ(dst[0], 15);
+    EXPECT_EQ(dst[1], 40);
+
+    // 3 rows to 1: all three averaged
+    const std::uint8_t column[] = {0, 90, 255};
+    ASSERT_TRUE(boxDownscale(column, 1, 3, 1, dst, 1, 1, 1, 1, sums));
+    EXPECT_EQ(dst[0], 115);
+}
+
+TEST(BoxScaleTest, PaddedRows)
+{
+    // 2x2 RGB888 with 2 padding bytes per source row, 1 per destination row
+    const std::uint8_t src[] = {
+        10, 20, 30, 30, 40, 50, 99, 99,
+        50, 60, 70, 70, 80, 90, 99, 99,
+    };
+    std::uint8_t dst[8] = {0, 0, 0, 7, 0, 0, 0, 7};
+    std::vector<std::uint32_t> sums;
+    ASSERT_TRUE(boxDownscale(src, 2, 2, 8, dst, 1, 2, 4, 3, sums));
+    EXPECT_EQ(dst[0], 20);
+    EXPECT_EQ(dst[2], 40);
+    EXPECT_EQ(dst[3], 7); // padding left alone
+    EXPECT_EQ(dst[4], 60);
+    EXPECT_EQ(dst[6], 80);
+    EXPECT_EQ(dst[7], 7);
+}
+
+TEST(BoxScaleTest, RejectsEnlargingAndEmpty)
+{
+    const std::uint8_t src[4] = {};
+    std::uint8_t dst[16] = {};
+    std::vector<std::uint32_t> sums;
+    EXPECT_FALSE(boxDownscale(src, 2, 2, 2, dst, 4, 2, 4, 1, sums));
+    EXPECT_FALSE(boxDownscale(src, 2, 2, 2, dst, 2, 3, 2, 1, sums));
+    EXPECT_FALSE(boxDownscale(src, 2, 2, 2, dst, 0, 1, 2, 1, sums));
+    EXPECT_FALSE(boxDownscale(src, 2, 2, 2, dst, 1, 1, 1, 0, sums));
+    EXPECT_FALSE(boxDownscale(nullptr, 2, 2, 2, dst, 1, 1, 1, 1, sums));
+}
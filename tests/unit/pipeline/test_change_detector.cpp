@@ -0,0 +1,140 @@
+/**
+ * @file test_change_detector.cpp
+ * @brief Unit tests for the sender's static-scene detection
+ *
+ * Tests validate:
+ * - The luma fingerprint of gray, BGR and BGRA images, padded rows
+ * - Sensor noise stays below the thresholds, global and local changes don't
+ * - Slow drift adds up against the last frame sent
+ * - A frame is sent after maxStaticUs however static the scene; reset() forces one
+ */
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "changedetector.h"
+
+namespace {
+const int kWidth = 320;
+const int kHeight = 240;
+const std::int64_t kFrameUs = 33333;
+
+struct Image {
+    int channels;
+    std::size_t stride;
+    std::vector<std::uint8_t> pixels;
+
+    Image(int c, std::uint8_t value, std::size_t padding = 0)
+        : channels(c), stride(static_cast<std::size_t>(kWidth * c) + padding),
+          pixels(stride * kHeight, value)
+    {
+    }
+
+    void fillRect(int x0, int y0, int x1, int y1, std::uint8_t value)
+    {
+        for (int y = y0; y < y1; ++y)
+            for (int x = x0 * channels; x < x1 * channels; ++x)
+                pixels[static_cast<std::size_t>(y) * stride + static_cast<std::size_t>(x)] = value;
+    }
+
+    // Deterministic +-1 "sensor noise" on every pixel
+    void addNoise(unsigned seed)
+    {
+        for (std::size_t i = 0; i < pixels.size(); ++i) {
+            seed = seed * 1103515245u + 12345u;
+            const int delta = static_cast<int>((seed >> 16) % 3) - 1;
+            pixels[i] = static_cast<std::uint8_t>(std::max(0, std::min(255, pixels[i] + delta)));
+        }
+    }
+
+    bool send(ChangeDetector& detector, std::int64_t nowUs) const
+    {
+        return detector.shouldSend(pixels.data(), kWidth, kHeight, stride, channels, nowUs);
+    }
+};
+} // namespace
+
+TEST(ChangeDetectorTest, FingerprintIsMeanLumaPerCell)
+{
+    ChangeDetector::Fingerprint gray;
+    Image flat(1, 100);
+    flat.fillRect(0, 0, kWidth / ChangeDetector::kGrid, kHeight / ChangeDetector::kGrid, 200);
+    ASSERT_TRUE(ChangeDetector::fingerprint(flat.pixels.data(), kWidth, kHeight, flat.stride, 1, gray));
+    EXPECT_EQ(gray.cells[0], 200);
+    EXPECT_EQ(gray.cells[1], 100);
+    EXPECT_EQ(gray.cells[ChangeDetector::kCells - 1], 100);
+
+    // BGR white is full luma whatever the padding; pure blue weighs least
+    ChangeDetector::Fingerprint color;
+    Image white(3, 255, 13);
+    ASSERT_TRUE(ChangeDetector::fingerprint(white.pixels.data(), kWidth, kHeight, white.stride, 3, color));
+    EXPECT_EQ(color.cells[0], 255);
+    Image blue(4, 0);
+    for (std::size_t i = 0; i < blue.pixels.size(); i += 4)
+        blue.pixels[i] = 255;
+    ASSERT_TRUE(ChangeDetector::fingerprint(blue.pixels.data(), kWidth, kHeight, blue.stride, 4, color));
+    EXPECT_EQ(color.cells[0], 28);
+
+    EXPECT_FALSE(ChangeDetector::fingerprint(flat.pixels.data(), 8, 8, 8, 1, gray));
+    EXPECT_FALSE(ChangeDetector::fingerprint(flat.pixels.data(), kWidth, kHeight, flat.stride, 2, gray));
+}
+
+TEST(ChangeDetectorTest, NoiseIsUnchangedMotionIsNot)
+{
+    ChangeDetector detector;
+    std::int64_t now = 0;
+    Image scene(3, 120);
+    EXPECT_TRUE(scene.send(detector, now)); // first frame
+
+    for (unsigned i = 1; i <= 10; ++i) {
+        Image noisy = scene;
+        noisy.addNoise(i);
+        EXPECT_FALSE(noisy.send(detector, now += kFrameUs)) << "frame " << i;
+    }
+    EXPECT_EQ(detector.unchangedFrames(), 10u);
+
+    // Lights on: the whole picture moves a little
+    Image brighter(3, 124);
+    EXPECT_TRUE(brighter.send(detector, now += kFrameUs));
+    EXPECT_GE(detector.lastDifference().mean(), 1.5);
+
+    // Something small in a corner: one cell, mean difference well below threshold
+    Image corner = brighter;
+    corner.fillRect(0, 0, 20, 15, 250);
+    EXPECT_TRUE(corner.send(detector, now += kFrameUs));
+    EXPECT_LT(detector.lastDifference().mean(), 1.5);
+    EXPECT_GE(detector.lastDifference().maxCell, 12);
+}
+
+TEST(ChangeDetectorTest, DriftAddsUpAgainstLastSentFrame)
+{
+    ChangeDetector detector(1.5, 0);
+    std::int64_t now = 0;
+    EXPECT_TRUE(Image(1, 100).send(detector, now));
+    // One level per frame never differs from the previous frame by more than 1
+    EXPECT_FALSE(Image(1, 101).send(detector, now += kFrameUs));
+    EXPECT_TRUE(Image(1, 102).send(detector, now += kFrameUs));
+    EXPECT_FALSE(Image(1, 103).send(detector, now += kFrameUs));
+}
+
+TEST(ChangeDetectorTest, RefreshAfterMaxStaticAndReset)
+{
+    ChangeDetector detector(1.5, 12, 1000000);
+    const Image scene(3, 80);
+    std::int64_t now = 0;
+    int sent = 0;
+    for (int i = 0; i < 90; ++i, now += kFrameUs)
+        sent += scene.send(detector, now) ? 1 : 0;
+    // 3 s at 30 fps: the first frame, then one a second
+    EXPECT_EQ(sent, 3);
+
+    EXPECT_FALSE(scene.send(detector, now));
+    detector.reset();
+    EXPECT_TRUE(scene.send(detector, now + 1));
+
+    // 0 disables the refresh
+    ChangeDetector never(1.5, 12, 0);
+    EXPECT_TRUE(scene.send(never, 0));
+    EXPECT_FALSE(scene.send(never, 3600000000LL));
+}
@@ -0,0 +1,74 @@
+/**
+ * @file test_clock_offset.cpp
+ * @brief Unit tests for the NTP-style PING/PONG clock offset estimator
+ *
+ * Tests validate:
+ * - Offset and RTT of a symmetric exchange are exact
+ * - The lowest-RTT exchange in the window wins over queued ones
+ * - Old exchanges leave the window
+ * - Inconsistent timestamps are rejected
+ */
+
+#include <gtest/gtest.h>
+#include "clockoffset.h"
+
+namespace {
+
+// Client clock runs 1 hour ahead of the server
+const std::int64_t kOffsetUs = 3600LL * 1000 * 1000;
+
+// Exchange sent at `t0` (server clock) with the given one-way times
+void exchange(ClockOffsetEstimator& estimator, std::int64_t t0, std::int64_t upUs, std::int64_t downUs,
+              std::int64_t processingUs = 100)
+{
+    const std::int64_t t1 = t0 + downUs + kOffsetUs;
+    const std::int64_t t2 = t1 + processingUs;
+    const std::int64_t t3 = t2 - kOffsetUs + upUs;
+    EXPECT_TRUE(estimator.addExchange(t0, t1, t2, t3));
+}
+
+} // namespace
+
+TEST(ClockOffsetTest, InvalidUntilFirstExchange) {
+    ClockOffsetEstimator estimator;
+    EXPECT_FALSE(estimator.valid());
+    EXPECT_EQ(estimator.offsetUs(), 0);
+    EXPECT_EQ(estimator.minRttUs(), -1);
+    EXPECT_EQ(estimator.lastRttUs(), -1);
+}
+
+TEST(ClockOffsetTest, SymmetricExchangeIsExact) {
+    ClockOffsetEstimator estimator;
+    exchange(estimator, 1000000, 5000, 5000);
+    ASSERT_TRUE(estimator.valid());
+    EXPECT_EQ(estimator.offsetUs(), kOffsetUs);
+    EXPECT_EQ(estimator.minRttUs(), 10000); // client processing time excluded
+    EXPECT_EQ(estimator.toServerTime(2000000 + kOffsetUs), 2000000);
+}
+
+TEST(ClockOffsetTest, LowestRttExchangeWins) {
+    ClockOffsetEstimator estimator;
+    exchange(estimator, 1000000, 5000, 5000);
+    // PONG queued 80 ms behind frames: asymmetric, would skew the offset by 40 ms
+    exchange(estimator, 2000000, 85000, 5000);
+    EXPECT_EQ(estimator.lastRttUs(), 90000);
+    EXPECT_EQ(estimator.minRttUs(), 10000);
+    EXPECT_EQ(estimator.offsetUs(), kOffsetUs);
+}
+
+TEST(ClockOffsetTest, OldExchangesLeaveWindow) {
+    ClockOffsetEstimator estimator;
+    exchange(estimator, 1000000, 1000, 1000);
+    for (std::size_t i = 0; i < ClockOffsetEstimator::kWindow; ++i)
+        exchange(estimator, 2000000 + static_cast<std::int64_t>(i) * 1000000, 12000, 8000);
+    EXPECT_EQ(estimator.minRttUs(), 20000);
+    EXPECT_EQ(estimator.offsetUs(), kOffsetUs - 2000); // half the 4 ms asymmetry
+}
+
+TEST(ClockOffsetTest, RejectsInconsistentTimestamps) {
+    ClockOffsetEstimator estimator;
+    EXPECT_FALSE(estimator.addExchange(1000, 5000, 4000, 2000)); // PONG sent before PING arrived
+    EXPECT_FALSE(estimator.addExchange(3000, 5000, 5100, 2000)); // received before sent
+    EXPECT_FALSE(estimator.addExchange(1000, 5000, 9000, 2000)); // client held it longer than the round trip
+    EXPECT_FALSE(estimator.valid());
+}
@@ -0,0 +1,127 @@
+/**
+ * @file test_cluster_placement.cpp
+ * @brief Unit tests for load-aware camera placement across cluster nodes
+ *
+ * Tests validate:
+ * - Utilization is the busiest known resource, scaled for added cameras
+ * - A camera moves to the least-utilized peer only for a clear gain
+ * - Pending redirects spread a burst of cameras over the peers
+ * - Stale, draining, full or unreachable peers are never chosen
+ */
+
+#include <gtest/gtest.h>
+#include "clusterplacement.h"
+
+namespace {
+
+NodeLoad node(const char* id, int sessions, double cpuPercent, int maxSessions = 0)
+{
+    NodeLoad load;
+    load.nodeId = id;
+    load.host = std::string(id) + ".local";
+    load.port = 5000;
+    load.sessions = sessions;
+    load.maxSessions = maxSessions;
+    load.cpuPercent = cpuPercent;
+    load.cpuCores = 4;
+    return load;
+}
+
+} // namespace
+
+TEST(ClusterPlacementTest, UtilizationIsTheBusiestResource) {
+    NodeLoad load = node("a", 10, 100.0); // a quarter of 4 cores
+    EXPECT_DOUBLE_EQ(nodeUtilization(load), 0.25);
+
+    load.maxSessions = 20;
+    EXPECT_DOUBLE_EQ(nodeUtilization(load), 0.5);
+    load.maxIngressBitsPerSecond = 100e6;
+    load.ingressBitsPerSecond = 80e6;
+    EXPECT_DOUBLE_EQ(nodeUtilization(load), 0.8);
+    EXPECT_DOUBLE_EQ(nodeUtilization(load, 10), 1.6); // ten more cameras like these
+
+    NodeLoad unknown;
+    unknown.sessions = 3;
+    EXPECT_DOUBLE_EQ(nodeUtilization(unknown), 0.0); // no limits, no CPU figure
+}
+
+TEST(ClusterPlacementTest, MovesOnlyForAClearGain) {
+    ClusterPlacement placement;
+    placement.update(node("b", 4, 120.0), 1000);
+    NodeLoad target;
+
+    // 0.35 here against 0.3 with the camera there: not worth a reconnect
+    EXPECT_FALSE(placement.choose(node("a", 7, 140.0), 1000, target));
+
+    EXPECT_TRUE(placement.choose(node("a", 10, 300.0), 1000, target));
+    EXPECT_EQ(target.nodeId, "b");
+    EXPECT_EQ(target.host, "b.local");
+
+    // The least utilized wins, ties go to fewer sessions
+    placement.update(node("c", 2, 40.0), 1000);
+    placement.update(node("d", 1, 30.0), 1000); // both 0.15 with the camera
+    EXPECT_TRUE(placement.choose(node("a", 10, 300.0), 1000, target));
+    EXPECT_EQ(target.nodeId, "d");
+}
+
+TEST(ClusterPlacementTest, PendingRedirectsSpreadABurst) {
+    ClusterPlacement placement;
+    placement.update(node("b", 4, 40.0, 10), 1000);
+    placement.update(node("c", 4, 40.0, 10), 1000);
+    const NodeLoad self = node("a", 9, 360.0, 10);
+
+    NodeLoad first;
+    NodeLoad second;
+    ASSERT_TRUE(placement.choose(self, 1000, first));
+    placement.placed(first.nodeId);
+    ASSERT_TRUE(placement.choose(self, 1000, second));
+    EXPECT_NE(first.nodeId, second.nodeId);
+    EXPECT_EQ(placement.pending(first.nodeId), 1);
+
+    // The next report counts them itself
+    placement.update(node(first.nodeId.c_str(), 5, 50.0, 10), 1100);
+    EXPECT_EQ(placement.pending(first.nodeId), 0);
+
+    // Full once the pending ones arrive: never chosen
+    placement.update(node("b", 9, 40.0, 10), 1200);
+    placement.update(node("c", 9, 40.0, 10), 1200);
+    placement.placed("b");
+    placement.placed("c");
+    NodeLoad target;
+    EXPECT_FALSE(placement.choose(self, 1200, target));
+}
+
+TEST(ClusterPlacementTest, SkipsPeersThatCannotTakeIt) {
+    ClusterPlacement placement;
+    const NodeLoad self = node("a", 10, 380.0);
+    NodeLoad target;
+
+    NodeLoad draining = node("b", 0, 10.0);
+    draining.acceptsClients = false;
+    placement.update(draining, 1000);
+    NodeLoad unreachable = node("c", 0, 10.0);
+    unreachable.host.clear();
+    placement.update(unreachable, 1000);
+    placement.update(self, 1000); // its own report, looped back
+    EXPECT_FALSE(placement.choose(self, 1000, target));
+
+    placement.update(node("d", 0, 10.0), 1000);
+    EXPECT_TRUE(placement.choose(self, 1000, target));
+    EXPECT_FALSE(placement.choose(self, 1000 + placement.config().staleAfterMs + 1, target));
+    EXPECT_EQ(placement.peers(1000).size(), 4u);
+
+    const std::vector<std::string> expired = placement.expire(1000 + placement.config().staleAfterMs + 1);
+    EXPECT_EQ(expired.size(), 4u);
+    EXPECT_TRUE(placement.peers(1000).empty());
+}
+
+TEST(ClusterPlacementTest, DrainingNodeHandsOffAnyway) {
+    ClusterPlacement placement;
+    placement.update(node("b", 8, 200.0), 1000);
+    NodeLoad self = node("a", 2, 40.0);
+    NodeLoad target;
+    EXPECT_FALSE(placement.choose(self, 1000, target));
+    self.acceptsClients = false;
+    EXPECT_TRUE(placement.choose(self, 1000, target));
+    EXPECT_EQ(target.nodeId, "b");
+}
@@ -0,0 +1,185 @@
+/**
+ * @file test_decode_scheduler.cpp
+ * @brief Unit tests for the decode scheduler's priority classes and deadlines
+ *
+ * Tests validate:
+ * - Classes run most urgent first, earliest deadline first within a class
+ * - Lower classes never take the reserved worker; the active client always finds one
+ * - Jobs past their deadline are dropped, and the expiry callback may queue newer ones
+ * - A saturated pool keeps the active client's frames flowing
+ * - Queued jobs of a client can be removed
+ */
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "decodescheduler.h"
+
+namespace {
+
+struct Job {
+    std::string client;
+    int frame = 0;
+};
+
+struct Started {
+    Job job;
+    DecodePriority priority;
+};
+
+// Starts jobs until the scheduler refuses; expired jobs go to `expired`
+std::vector<Started> startAll(DecodeScheduler<Job>& scheduler, std::int64_t nowUs,
+                              std::vector<Job>* expired = nullptr)
+{
+    std::vector<Started> started;
+    Job job;
+    DecodePriority priority;
+    while (scheduler.next(nowUs, job, priority, [&](const Job& late, DecodePriority) {
+        if (expired)
+            expired->push_back(late);
+    }))
+        started.push_back(Started{job, priority});
+    return started;
+}
+
+} // namespace
+
+TEST(DecodeSchedulerTest, UrgentClassFirstThenEarliestDeadline) {
+    DecodeScheduler<Job> scheduler(1, 1);
+    EXPECT_EQ(scheduler.reservedWorkers(), 0) << "a single worker serves every class";
+
+    scheduler.push(Job{"background", 1}, DecodePriority::Background, 1000);
+    scheduler.push(Job{"preview-late", 1}, DecodePriority::Preview, 900);
+    scheduler.push(Job{"preview-none", 1}, DecodePriority::Preview, 0);
+    scheduler.push(Job{"preview-early", 1}, DecodePriority::Preview, 500);
+    scheduler.push(Job{"active", 1}, DecodePriority::Active, 0);
+
+    const char* expected[] = {"active", "preview-early", "preview-late", "preview-none", "background"};
+    for (const char* client : expected) {
+        const std::vector<Started> started = startAll(scheduler, 100);
+        ASSERT_EQ(started.size(), 1u) << "one worker";
+        EXPECT_EQ(started[0].job.client, client);
+        scheduler.finished(started[0].priority);
+    }
+    EXPECT_TRUE(startAll(scheduler, 100).empty());
+    EXPECT_EQ(scheduler.started(DecodePriority::Preview), 3u);
+}
+
+TEST(DecodeSchedulerTest, ReservedWorkerIsKeptForTheActiveClient) {
+    DecodeScheduler<Job> scheduler(4, 1);
+    for (int frame = 0; frame < 10; ++frame)
+        scheduler.push(Job{"preview", frame}, DecodePriority::Preview, 0);
+
+    // Three previews run, the fourth worker stays free
+    EXPECT_EQ(startAll(scheduler, 0).size(), 3u);
+    EXPECT_EQ(scheduler.runningTotal(), 3);
+    EXPECT_EQ(scheduler.queued(DecodePriority::Preview), 7u);
+
+    scheduler.push(Job{"active", 1}, DecodePriority::Active, 0);
+    std::vector<Started> started = startAll(scheduler, 0);
+    ASSERT_EQ(started.size(), 1u);
+    EXPECT_EQ(started[0].priority, DecodePriority::Active);
+    EXPECT_EQ(scheduler.runningTotal(), 4);
+
+    // The active job finishing frees the reserved worker, not one for the previews
+    scheduler.finished(DecodePriority::Active);
+    EXPECT_TRUE(startAll(scheduler, 0).empty());
+    scheduler.finished(DecodePriority::Preview);
+    EXPECT_EQ(startAll(scheduler, 0).size(), 1u);
+
+    // Background shares the previews' workers and waits for them
+    scheduler.push(Job{"background", 1}, DecodePriority::Background, 0);
+    scheduler.finished(DecodePriority::Preview);
+    started = startAll(scheduler, 0);
+    ASSERT_EQ(started.size(), 1u);
+    EXPECT_EQ(started[0].priority, DecodePriority::Preview);
+}
+
+TEST(DecodeSchedulerTest, LateJobsExpireAndMakeWayForNewerFrames) {
+    DecodeScheduler<Job> scheduler(2, 1);
+    scheduler.push(Job{"a", 1}, DecodePriority::Preview, 0);
+    ASSERT_EQ(startAll(scheduler, 0).size(), 1u); // occupies the only preview worker
+
+    scheduler.push(Job{"b", 1}, DecodePriority::Preview, 300);
+    scheduler.push(Job{"c", 1}, DecodePriority::Background, 500);
+    EXPECT_TRUE(startAll(scheduler, 100).empty());
+
+    // At 400 b is late: its client's newer frame takes its place
+    std::vector<Job> expired;
+    std::vector<Started> started;
+    Job job;
+    DecodePriority priority;
+    EXPECT_FALSE(scheduler.next(400, job, priority, [&](const Job& late, DecodePriority latePriority) {
+        expired.push_back(late);
+        scheduler.push(Job{late.client, late.frame + 1}, latePriority, 700);
+    }));
+    ASSERT_EQ(expired.size(), 1u);
+    EXPECT_EQ(expired[0].client, "b");
+    EXPECT_EQ(scheduler.expired(DecodePriority::Preview), 1u);
+
+    // At 600 c is late too; the worker frees and b's newer frame runs
+    scheduler.finished(DecodePriority::Preview);
+    expired.clear();
+    started = startAll(scheduler, 600, &expired);
+    ASSERT_EQ(expired.size(), 1u);
+    EXPECT_EQ(expired[0].client, "c");
+    ASSERT_EQ(started.size(), 1u);
+    EXPECT_EQ(started[0].job.client, "b");
+    EXPECT_EQ(started[0].job.frame, 2);
+}
+
+TEST(DecodeSchedulerTest, SaturatedPoolKeepsActiveSmooth) {
+    // 4 workers, 40 preview clients at 10 ms a decode, the active one every 33 ms
+    DecodeScheduler<Job> scheduler(4, 1);
+    struct Running {
+        Started started;
+        std::int64_t endUs;
+    };
+    std::vector<Running> running;
+    int activeDecoded = 0;
+    std::int64_t worstActiveWaitUs = 0;
+    std::int64_t activeQueuedUs = -1;
+    for (std::int64_t now = 0; now < 2000000; now += 1000) {
+        for (auto it = running.begin(); it != running.end();) {
+            if (it->endUs <= now) {
+                scheduler.finished(it->started.priority);
+                it = running.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        if (now % 33000 == 0) {
+            scheduler.push(Job{"active", int(now / 33000)}, DecodePriority::Active, 0);
+            activeQueuedUs = now;
+        }
+        if (now % 100000 == 0) {
+            for (int client = 0; client < 40; ++client)
+                scheduler.push(Job{"preview", client}, DecodePriority::Preview, now + 100000);
+        }
+        for (const Started& started : startAll(scheduler, now)) {
+            running.push_back(Running{started, now + 10000});
+            if (started.priority == DecodePriority::Active) {
+                ++activeDecoded;
+                worstActiveWaitUs = std::max(worstActiveWaitUs, now - activeQueuedUs);
+            }
+        }
+    }
+    EXPECT_EQ(activeDecoded, 61) << "every active frame decoded";
+    EXPECT_EQ(worstActiveWaitUs, 0) << "none waited for a worker";
+    EXPECT_GT(scheduler.expired(DecodePriority::Preview), 0u) << "the previews shed their excess";
+}
+
+TEST(DecodeSchedulerTest, RemoveIfDropsAClientsQueuedJobs) {
+    DecodeScheduler<Job> scheduler(1, 0);
+    scheduler.push(Job{"a", 1}, DecodePriority::Preview, 0);
+    scheduler.push(Job{"b", 1}, DecodePriority::Preview, 0);
+    scheduler.push(Job{"a", 2}, DecodePriority::Background, 0);
+    EXPECT_EQ(scheduler.removeIf([](const Job& job) { return job.client == "a"; }), 2u);
+    const std::vector<Started> started = startAll(scheduler, 0);
+    ASSERT_EQ(started.size(), 1u);
+    EXPECT_EQ(started[0].job.client, "b");
+    scheduler.clear();
+    scheduler.finished(DecodePriority::Preview);
+    EXPECT_EQ(scheduler.runningTotal(), 0);
+}
@@ -0,0 +1,107 @@
+/**
+ * @file test_encode_pipeline.cpp
+ * @brief Unit tests for the parallel client encode stage
+ *
+ * Tests validate:
+ * - Outputs are emitted in submission order whatever order the workers finish in
+ * - Workers encode concurrently
+ * - Failed encodes are skipped without stalling the order
+ * - submit() holds back beyond the in-flight limit; flush() waits for the emits
+ */
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "encodepipeline.h"
+
+TEST(EncodePipelineTest, EmitsInSubmissionOrder) {
+    std::vector<int> emitted;
+    std::vector<std::uint64_t> sequences;
+    {
+        EncodePipeline<int, int> pipeline(4,
+            [](int& job, int& out) {
+                // Later jobs finish first
+                std::this_thread::sleep_for(std::chrono::milliseconds((7 - job % 8) * 2));
+                out = job * 10;
+                return true;
+            },
+            [&](std::uint64_t sequence, int& out) {
+                sequences.push_back(sequence);
+                emitted.push_back(out);
+            });
+        for (int i = 0; i < 40; ++i)
+            EXPECT_EQ(pipeline.submit(i), static_cast<std::uint64_t>(i));
+        pipeline.flush();
+        EXPECT_EQ(pipeline.emittedTotal(), 40u);
+    }
+    ASSERT_EQ(emitted.size(), 40u);
+    for (int i = 0; i < 40; ++i) {
+        EXPECT_EQ(emitted[i], i * 10);
+        EXPECT_EQ(sequences[i], static_cast<std::uint64_t>(i));
+    }
+}
+
+TEST(EncodePipelineTest, WorkersRunConcurrently) {
+    std::atomic<int> running{0};
+    std::atomic<int> peak{0};
+    EncodePipeline<int, int> pipeline(4,
+        [&](int&, int&) {
+            const int now = ++running;
+            int seen = peak.load();
+            while (now > seen && !peak.compare_exchange_weak(seen, now)) {
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            --running;
+            return true;
+        },
+        [](std::uint64_t, int&) {});
+    EXPECT_EQ(pipeline.workerCount(), 4);
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 8; ++i)
+        pipeline.submit(i);
+    pipeline.flush();
+    EXPECT_GE(peak.load(), 2);
+    // 8 x 20 ms on one thread would be 160 ms
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(150));
+}
+
+TEST(EncodePipelineTest, FailedEncodesAreSkipped) {
+    std::vector<int> emitted;
+    EncodePipeline<int, int> pipeline(3,
+        [](int& job, int& out) {
+            out = job;
+            return job % 3 != 1;
+        },
+        [&](std::uint64_t, int& out) { emitted.push_back(out); });
+    for (int i = 0; i < 9; ++i)
+        pipeline.submit(i);
+    pipeline.flush();
+    EXPECT_EQ(emitted, (std::vector<int>{0, 2, 3, 5, 6, 8}));
+    EXPECT_EQ(pipeline.failedTotal(), 3u);
+}
+
+TEST(EncodePipelineTest, SubmitWaitsBeyondInFlightLimit) {
+    std::atomic<bool> release{false};
+    std::atomic<int> submitted{0};
+    EncodePipeline<int, int> pipeline(1,
+        [&](int&, int&) {
+            while (!release)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            return true;
+        },
+        [](std::uint64_t, int&) {}, 2);
+    std::thread producer([&]() {
+        for (int i = 0; i < 3; ++i) {
+            pipeline.submit(i);
+            ++submitted;
+        }
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(submitted.load(), 2);
+    release = true;
+    producer.join();
+    pipeline.flush();
+    EXPECT_EQ(pipeline.emittedTotal(), 3u);
+}
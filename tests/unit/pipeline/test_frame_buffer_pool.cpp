@@ -0,0 +1,80 @@
+/**
+ * @file test_frame_buffer_pool.cpp
+ * @brief Unit tests for the recycled encode buffer pool
+ *
+ * Tests validate:
+ * - Released buffers come back with their capacity (no reallocation)
+ * - Buffers are handed out empty
+ * - Idle list is bounded
+ * - Buffers released after the pool is gone are freed safely
+ */
+
+#include <gtest/gtest.h>
+#include <thread>
+#include "framebufferpool.h"
+
+TEST(FrameBufferPoolTest, ReleasedBufferIsReusedWithCapacity) {
+    FrameBufferPool pool;
+    const std::uint8_t* storage = nullptr;
+    {
+        auto buf = pool.acquire();
+        buf->resize(64 * 1024);
+        storage = buf->data();
+    }
+    EXPECT_EQ(pool.idleCount(), 1u);
+
+    auto again = pool.acquire();
+    EXPECT_TRUE(again->empty());
+    EXPECT_GE(again->capacity(), 64u * 1024u);
+    again->resize(1024);
+    EXPECT_EQ(again->data(), storage);
+    EXPECT_EQ(pool.allocatedCount(), 1u);
+    EXPECT_EQ(pool.reusedCount(), 1u);
+}
+
+TEST(FrameBufferPoolTest, OutstandingBuffersAreDistinct) {
+    FrameBufferPool pool;
+    auto a = pool.acquire();
+    auto b = pool.acquire();
+    EXPECT_NE(a.get(), b.get());
+    EXPECT_EQ(pool.allocatedCount(), 2u);
+}
+
+TEST(FrameBufferPoolTest, IdleListIsBounded) {
+    FrameBufferPool pool(2);
+    {
+        auto a = pool.acquire();
+        auto b = pool.acquire();
+        auto c = pool.acquire();
+    }
+    EXPECT_EQ(pool.idleCount(), 2u);
+}
+
+TEST(FrameBufferPoolTest, SharedHolderDelaysRecycling) {
+    FrameBufferPool pool;
+    auto buf = pool.acquire();
+    std::shared_ptr<const FrameBufferPool::Buffer> inFlight = buf;
+    buf.reset();
+    EXPECT_EQ(pool.idleCount(), 0u);
+    inFlight.reset();
+    EXPECT_EQ(pool.idleCount(), 1u);
+}
+
+TEST(FrameBufferPoolTest, ReleaseAfterPoolDestroyedIsSafe) {
+    std::shared_ptr<FrameBufferPool::Buffer> survivor;
+    {
+        FrameBufferPool pool;
+        survivor = pool.acquire();
+        survivor->resize(16);
+    }
+    survivor.reset(); // must not touch the destroyed pool
+    SUCCEED();
+}
+
+TEST(FrameBufferPoolTest, ReleaseFromAnotherThread) {
+    FrameBufferPool pool;
+    auto buf = pool.acquire();
+    std::thread writer([held = std::move(buf)]() mutable { held.reset(); });
+    writer.join();
+    EXPECT_EQ(pool.idleCount(), 1u);
+}
@@ -0,0 +1,146 @@
+/**
+ * @file test_frame_header.cpp
+ * @brief Unit tests for the per-frame header and sequence loss accounting
+ *
+ * Tests validate:
+ * - writeFrameHeader() and parseFrameHeader() round-trip every field
+ * - The byte layout is little-endian and fixed-size; out-of-range values are clamped
+ * - Longer headers from newer peers are skipped, truncated or unknown ones rejected
+ * - FrameSequenceTracker counts gaps as loss (across wrap-around) and late frames as reordered
+ */
+
+#include <gtest/gtest.h>
+#include <vector>
+#include "frameheader.h"
+
+namespace {
+
+FrameHeader sampleHeader()
+{
+    FrameHeader h;
+    h.payload = FramePayload::Video;
+    h.keyframe = false;
+    h.sequence = 0x01020304u;
+    h.captureTimeUs = 1700000000123456LL;
+    h.width = 1920;
+    h.height = 1080;
+    h.streamId = 3;
+    h.sendDelayUs = 12340;
+    return h;
+}
+
+} // namespace
+
+TEST(FrameHeaderTest, RoundTripsFields) {
+    std::vector<std::uint8_t> bytes(kFrameHeaderSize + 10);
+    writeFrameHeader(sampleHeader(), bytes.data());
+
+    FrameHeader parsed;
+    std::size_t headerSize = 0;
+    ASSERT_TRUE(parseFrameHeader(bytes.data(), bytes.size(), parsed, headerSize));
+    EXPECT_EQ(headerSize, kFrameHeaderSize);
+    EXPECT_EQ(parsed.payload, FramePayload::Video);
+    EXPECT_FALSE(parsed.keyframe);
+    EXPECT_EQ(parsed.sequence, 0x01020304u);
+    EXPECT_EQ(parsed.captureTimeUs, 1700000000123456LL);
+    EXPECT_EQ(parsed.width, 1920);
+    EXPECT_EQ(parsed.height, 1080);
+    EXPECT_EQ(parsed.streamId, 3);
+    EXPECT_EQ(parsed.sendDelayUs, 12300); // 100 us resolution
+}
+
+TEST(FrameHeaderTest, LittleEndianLayout) {
+    std::uint8_t bytes[kFrameHeaderSize];
+    writeFrameHeader(sampleHeader(), bytes);
+    EXPECT_EQ(bytes[0], kFrameHeaderSize);
+    EXPECT_EQ(bytes[1], 0x03);
+    EXPECT_EQ(bytes[2], 0x00);
+    EXPECT_EQ(bytes[4], 0x04);
+    EXPECT_EQ(bytes[7], 0x01);
+    EXPECT_EQ(bytes[16], 1920 & 0xFF);
+    EXPECT_EQ(bytes[17], 1920 >> 8);
+    EXPECT_EQ(bytes[20], 3);
+    EXPECT_EQ(bytes[22], 123);
+}
+
+TEST(FrameHeaderTest, OversizedDimensionsSentAsUnknown) {
+    FrameHeader h = sampleHeader();
+    h.width = 70000;
+    h.height = -1;
+    h.sendDelayUs = 60000000; // a minute: saturates
+    std::uint8_t bytes[kFrameHeaderSize];
+    writeFrameHeader(h, bytes);
+
+    FrameHeader parsed;
+    std::size_t headerSize = 0;
+    ASSERT_TRUE(parseFrameHeader(bytes, sizeof(bytes), parsed, headerSize));
+    EXPECT_EQ(parsed.width, 0);
+    EXPECT_EQ(parsed.height, 0);
+    EXPECT_EQ(parsed.sendDelayUs, 0xFFFF * 100);
+}
+
+TEST(FrameHeaderTest, SkipsLongerHeaders) {
+    std::vector<std::uint8_t> bytes(kFrameHeaderSize + 8);
+    writeFrameHeader(sampleHeader(), bytes.data());
+    bytes[0] = static_cast<std::uint8_t>(kFrameHeaderSize + 4); // newer peer appended a field
+
+    FrameHeader parsed;
+    std::size_t headerSize = 0;
+    ASSERT_TRUE(parseFrameHeader(bytes.data(), bytes.size(), parsed, headerSize));
+    EXPECT_EQ(headerSize, kFrameHeaderSize + 4);
+    EXPECT_EQ(parsed.sequence, 0x01020304u);
+}
+
+TEST(FrameHeaderTest, RejectsInvalidHeaders) {
+    std::vector<std::uint8_t> bytes(kFrameHeaderSize);
+    writeFrameHeader(sampleHeader(), bytes.data());
+    FrameHeader parsed;
+    std::size_t headerSize = 0;
+
+    EXPECT_FALSE(parseFrameHeader(bytes.data(), kFrameHeaderSize - 1, parsed, headerSize));
+    EXPECT_FALSE(parseFrameHeader(nullptr, kFrameHeaderSize, parsed, headerSize));
+
+    std::vector<std::uint8_t> unknown = bytes;
+    unknown[1] = 0x01; // control prefix is not a payload format
+    EXPECT_FALSE(parseFrameHeader(unknown.data(), unknown.size(), parsed, headerSize));
+
+    std::vector<std::uint8_t> shortDeclared = bytes;
+    shortDeclared[0] = 8;
+    EXPECT_FALSE(parseFrameHeader(shortDeclared.data(), shortDeclared.size(), parsed, headerSize));
+
+    std::vector<std::uint8_t> longDeclared = bytes;
+    longDeclared[0] = static_cast<std::uint8_t>(kFrameHeaderSize + 1); // past the end of the message
+    EXPECT_FALSE(parseFrameHeader(longDeclared.data(), longDeclared.size(), parsed, headerSize));
+}
+
+TEST(FrameSequenceTrackerTest, CountsGapsAsLoss) {
+    FrameSequenceTracker tracker;
+    EXPECT_EQ(tracker.observe(10), 0u);
+    EXPECT_EQ(tracker.observe(11), 0u);
+    EXPECT_EQ(tracker.observe(14), 2u);
+    EXPECT_EQ(tracker.received(), 3u);
+    EXPECT_EQ(tracker.lost(), 2u);
+    EXPECT_EQ(tracker.reordered(), 0u);
+}
+
+TEST(FrameSequenceTrackerTest, HandlesWrapAround) {
+    FrameSequenceTracker tracker;
+    tracker.observe(0xFFFFFFFEu);
+    EXPECT_EQ(tracker.observe(0xFFFFFFFFu), 0u);
+    EXPECT_EQ(tracker.observe(1u), 1u);
+    EXPECT_EQ(tracker.lost(), 1u);
+}
+
+TEST(FrameSequenceTrackerTest, LateFramesAreReordered) {
+    FrameSequenceTracker tracker;
+    tracker.observe(5);
+    tracker.observe(8);
+    EXPECT_EQ(tracker.observe(7), 0u);
+    EXPECT_EQ(tracker.observe(8), 0u);
+    EXPECT_EQ(tracker.reordered(), 2u);
+    EXPECT_EQ(tracker.observe(9), 0u);
+
+    tracker.reset();
+    EXPECT_EQ(tracker.observe(100), 0u);
+    EXPECT_EQ(tracker.lost(), 0u);
+}
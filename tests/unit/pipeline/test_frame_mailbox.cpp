@@ -0,0 +1,93 @@
+/**
+ * @file test_frame_mailbox.cpp
+ * @brief Unit tests for the latest-wins FrameMailbox
+ *
+ * Tests validate:
+ * - Single-slot replacement (newer frame replaces the pending one)
+ * - Drop counting per push and in total
+ * - FIFO order within an N-slot mailbox
+ * - Capacity changes trimming the oldest pending items
+ */
+
+#include <gtest/gtest.h>
+#include <string>
+#include "framemailbox.h"
+
+TEST(FrameMailboxTest, StartsEmpty) {
+    FrameMailbox<int> box;
+    int out = 0;
+    EXPECT_TRUE(box.empty());
+    EXPECT_EQ(box.capacity(), 1u);
+    EXPECT_FALSE(box.take(out));
+    EXPECT_EQ(box.droppedTotal(), 0u);
+}
+
+TEST(FrameMailboxTest, ZeroCapacityIsClampedToOne) {
+    FrameMailbox<int> box(0);
+    EXPECT_EQ(box.capacity(), 1u);
+}
+
+TEST(FrameMailboxTest, SingleSlotKeepsLatest) {
+    FrameMailbox<int> box(1);
+    EXPECT_EQ(box.push(1), 0u);
+    EXPECT_EQ(box.push(2), 1u);
+    EXPECT_EQ(box.push(3), 1u);
+
+    int out = 0;
+    ASSERT_TRUE(box.take(out));
+    EXPECT_EQ(out, 3);
+    EXPECT_TRUE(box.empty());
+    EXPECT_EQ(box.droppedTotal(), 2u);
+}
+
+TEST(FrameMailboxTest, MultiSlotPreservesOrderAndDropsOldest) {
+    FrameMailbox<std::string> box(3);
+    for (int i = 0; i < 5; ++i)
+        box.push("frame" + std::to_string(i));
+
+    EXPECT_EQ(box.size(), 3u);
+    EXPECT_EQ(box.droppedTotal(), 2u);
+
+    std::string out;
+    ASSERT_TRUE(box.take(out));
+    EXPECT_EQ(out, "frame2");
+    ASSERT_TRUE(box.take(out));
+    EXPECT_EQ(out, "frame3");
+    ASSERT_TRUE(box.take(out));
+    EXPECT_EQ(out, "frame4");
+    EXPECT_FALSE(box.take(out));
+}
+
+TEST(FrameMailboxTest, NoDropsWhenConsumerKeepsUp) {
+    FrameMailbox<int> box(1);
+    int out = 0;
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(box.push(i), 0u);
+        ASSERT_TRUE(box.take(out));
+        EXPECT_EQ(out, i);
+    }
+    EXPECT_EQ(box.droppedTotal(), 0u);
+}
+
+TEST(FrameMailboxTest, ShrinkingCapacityDropsOldest) {
+    FrameMailbox<int> box(4);
+    for (int i = 0; i < 4; ++i)
+        box.push(i);
+
+    EXPECT_EQ(box.setCapacity(2), 2u);
+    EXPECT_EQ(box.size(), 2u);
+    EXPECT_EQ(box.droppedTotal(), 2u);
+
+    int out = 0;
+    ASSERT_TRUE(box.take(out));
+    EXPECT_EQ(out, 2);
+}
+
+TEST(FrameMailboxTest, ClearDoesNotCountDrops) {
+    FrameMailbox<int> box(2);
+    box.push(1);
+    box.push(2);
+    box.clear();
+    EXPECT_TRUE(box.empty());
+    EXPECT_EQ(box.droppedTotal(), 0u);
+}
@@ -0,0 +1,103 @@
+/**
+ * @file test_frame_pacer.cpp
+ * @brief Unit tests for the fixed-rate capture schedule
+ *
+ * Tests validate:
+ * - Deadlines are absolute: no drift over many frames, whatever the work per frame
+ * - A late frame keeps the schedule, one more than a period late skips the missed slots
+ * - Rate changes apply from the last deadline; reset() re-anchors
+ * - The decimator keeps evenly spread source frames for a lower rate, all of them otherwise
+ */
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <vector>
+#include "framepacer.h"
+
+namespace {
+const std::int64_t kStart = 5000000; // monotonic clock
+} // namespace
+
+TEST(FramePacerTest, AbsoluteDeadlinesDoNotDrift) {
+    FramePacer pacer(30.0);
+    EXPECT_EQ(pacer.nextDueUs(kStart), kStart);
+    std::int64_t due = kStart;
+    for (int i = 1; i <= 300; ++i) {
+        // Waking up a little after each deadline (sleep granularity, work) doesn't shift the next one
+        due = pacer.nextDueUs(due + 1500);
+    }
+    EXPECT_EQ(due, kStart + 10000000);
+    EXPECT_EQ(pacer.skippedSlots(), 0u);
+}
+
+TEST(FramePacerTest, LateFramesCatchUpOrSkip) {
+    FramePacer pacer(10.0); // 100 ms
+    pacer.nextDueUs(kStart);
+    // 80 ms late: due at once, the one after keeps its slot
+    EXPECT_EQ(pacer.nextDueUs(kStart + 180000), kStart + 100000);
+    EXPECT_EQ(pacer.nextDueUs(kStart + 180000), kStart + 200000);
+    // 350 ms late: three slots are given up instead of a burst
+    EXPECT_EQ(pacer.nextDueUs(kStart + 650000), kStart + 600000);
+    EXPECT_EQ(pacer.skippedSlots(), 3u);
+    EXPECT_EQ(pacer.nextDueUs(kStart + 650000), kStart + 700000);
+}
+
+TEST(FramePacerTest, RateChangeAndReset) {
+    FramePacer pacer(10.0);
+    pacer.nextDueUs(kStart);
+    EXPECT_EQ(pacer.nextDueUs(kStart), kStart + 100000);
+    pacer.setFps(20.0);
+    EXPECT_DOUBLE_EQ(pacer.fps(), 20.0);
+    EXPECT_EQ(pacer.nextDueUs(kStart + 100000), kStart + 150000);
+    EXPECT_EQ(pacer.nextDueUs(kStart + 150000), kStart + 200000);
+
+    pacer.setFps(0.0); // falls back to 30
+    EXPECT_DOUBLE_EQ(pacer.fps(), 30.0);
+
+    pacer.reset();
+    EXPECT_EQ(pacer.nextDueUs(kStart + 9000000), kStart + 9000000);
+}
+
+namespace {
+// Kept frames among `count` source frames at `sourceFps`, timestamped on their ideal schedule
+std::vector<int> keptFrames(FrameDecimator& decimator, double sourceFps, int count)
+{
+    std::vector<int> kept;
+    for (int i = 0; i < count; ++i) {
+        if (decimator.keep(kStart + static_cast<std::int64_t>(i * 1e6 / sourceFps)))
+            kept.push_back(i);
+    }
+    return kept;
+}
+} // namespace
+
+TEST(FrameDecimatorTest, KeepsEvenlySpreadFrames) {
+    FrameDecimator five(5.0, 30.0);
+    EXPECT_EQ(keptFrames(five, 30.0, 31), (std::vector<int>{0, 6, 12, 18, 24, 30}));
+
+    FrameDecimator twelve(12.0, 30.0);
+    EXPECT_EQ(keptFrames(twelve, 30.0, 30).size(), 12u);
+
+    // 29.97 fps source at 10 fps: one in three, no drift over a minute
+    FrameDecimator ntsc(10.0, 29.97);
+    EXPECT_EQ(keptFrames(ntsc, 29.97, 1798).size(), 600u);
+}
+
+TEST(FrameDecimatorTest, SlowerSourceKeepsEverything) {
+    FrameDecimator decimator(30.0, 25.0);
+    EXPECT_TRUE(decimator.keepsAll());
+    EXPECT_EQ(keptFrames(decimator, 25.0, 10).size(), 10u);
+
+    decimator.setRates(0.0, 30.0);
+    EXPECT_TRUE(decimator.keepsAll());
+}
+
+TEST(FrameDecimatorTest, GapsAreNotMadeUp) {
+    FrameDecimator decimator(10.0, 30.0);
+    EXPECT_TRUE(decimator.keep(kStart));
+    // Source stalls for a second: the next frame is kept, the schedule restarts from it
+    EXPECT_TRUE(decimator.keep(kStart + 1000000));
+    EXPECT_FALSE(decimator.keep(kStart + 1033333));
+    EXPECT_FALSE(decimator.keep(kStart + 1066667));
+    EXPECT_TRUE(decimator.keep(kStart + 1100000));
+}
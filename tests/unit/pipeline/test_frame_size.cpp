@@ -0,0 +1,143 @@
+/**
+ * @file test_frame_size.cpp
+ * @brief Unit tests for thumbnail frame size fitting, ROI crops, display bounds and decode scaling
+ *
+ * Tests validate:
+ * - Frames within the bound are left untouched (no upscaling)
+ * - Aspect ratio follows the tighter bound
+ * - Zero bounds leave a dimension unconstrained
+ * - Results are even-sized and never degenerate
+ * - ROI crops are clamped to the frame on even pixels; empty regions keep it whole
+ * - Display bounds round up to the step
+ * - DCT scaling picks the smallest decode that still covers the target
+ */
+
+#include <gtest/gtest.h>
+#include "framesize.h"
+
+TEST(FrameSizeTest, SmallFrameIsNotUpscaled) {
+    FrameSize s = fitFrameSize(320, 180, 640, 360);
+    EXPECT_EQ(s.width, 320);
+    EXPECT_EQ(s.height, 180);
+}
+
+TEST(FrameSizeTest, NoBoundKeepsFullResolution) {
+    FrameSize s = fitFrameSize(1920, 1080, 0, 0);
+    EXPECT_EQ(s.width, 1920);
+    EXPECT_EQ(s.height, 1080);
+}
+
+TEST(FrameSizeTest, WideFrameBoundByWidth) {
+    FrameSize s = fitFrameSize(1920, 1080, 320, 240);
+    EXPECT_EQ(s.width, 320);
+    EXPECT_EQ(s.height, 180);
+}
+
+TEST(FrameSizeTest, TallFrameBoundByHeight) {
+    FrameSize s = fitFrameSize(1080, 1920, 320, 180);
+    EXPECT_EQ(s.height, 180);
+    EXPECT_EQ(s.width, 100);
+}
+
+TEST(FrameSizeTest, SingleBound) {
+    FrameSize s = fitFrameSize(1280, 720, 0, 360);
+    EXPECT_EQ(s.width, 640);
+    EXPECT_EQ(s.height, 360);
+}
+
+TEST(FrameSizeTest, ResultIsEvenAndNotDegenerate) {
+    FrameSize s = fitFrameSize(1001, 999, 333, 333);
+    EXPECT_EQ(s.width % 2, 0);
+    EXPECT_EQ(s.height % 2, 0);
+
+    FrameSize tiny = fitFrameSize(4000, 10, 100, 100);
+    EXPECT_GE(tiny.height, 2);
+}
+
+TEST(FrameSizeTest, CropRectOfRegion) {
+    FrameRegion center;
+    center.x = 0.25;
+    center.y = 0.25;
+    center.width = 0.5;
+    center.height = 0.5;
+    FrameRect r = cropRect(1920, 1080, center);
+    EXPECT_EQ(r.x, 480);
+    EXPECT_EQ(r.y, 270);
+    EXPECT_EQ(r.width, 960);
+    EXPECT_EQ(r.height, 540);
+
+    // Odd edges round outwards to even pixels
+    FrameRegion odd;
+    odd.x = 0.1;
+    odd.y = 0.1;
+    odd.width = 0.3;
+    odd.height = 0.3;
+    r = cropRect(101, 51, odd);
+    EXPECT_EQ(r.x, 10);
+    EXPECT_EQ(r.y, 4);
+    EXPECT_EQ(r.width % 2, 0);
+    EXPECT_EQ(r.height % 2, 0);
+    EXPECT_GE(r.x + r.width, 40);
+    EXPECT_LE(r.x + r.width, 100);
+}
+
+TEST(FrameSizeTest, CropRectClampsAndKeepsWholeFrame) {
+    FrameRegion whole;
+    FrameRect r = cropRect(640, 480, whole);
+    EXPECT_EQ(r.x, 0);
+    EXPECT_EQ(r.width, 640);
+    EXPECT_EQ(r.height, 480);
+
+    // Past the right edge: cut to the frame
+    FrameRegion outside;
+    outside.x = 0.9;
+    outside.y = -0.5;
+    outside.width = 0.5;
+    outside.height = 2.0;
+    r = cropRect(640, 480, outside);
+    EXPECT_EQ(r.x, 576);
+    EXPECT_EQ(r.y, 0);
+    EXPECT_EQ(r.x + r.width, 640);
+    EXPECT_EQ(r.height, 480);
+
+    // A sliver still leaves 2 x 2 pixels inside the frame
+    FrameRegion sliver;
+    sliver.x = 1.0;
+    sliver.y = 1.0;
+    sliver.width = 0.0001;
+    sliver.height = 0.0001;
+    r = cropRect(640, 480, sliver);
+    EXPECT_EQ(r.width, 2);
+    EXPECT_EQ(r.height, 2);
+    EXPECT_EQ(r.x + r.width, 640);
+    EXPECT_EQ(r.y + r.height, 480);
+}
+
+TEST(FrameSizeTest, DisplayBoundRoundsUp) {
+    FrameSize b = displayFrameBound(321, 180);
+    EXPECT_EQ(b.width, 384);
+    EXPECT_EQ(b.height, 192);
+    b = displayFrameBound(1280, 720, 16);
+    EXPECT_EQ(b.width, 1280);
+    EXPECT_EQ(b.height, 720);
+    b = displayFrameBound(0, 720);
+    EXPECT_EQ(b.width, 0);
+    EXPECT_EQ(b.height, 0);
+}
+
+TEST(FrameSizeTest, JpegScaleCoversTarget) {
+    // 1920x1080 in a 320x180 tile: 1/4 (480x270) covers it, 1/8 (240x135) doesn't
+    EXPECT_EQ(jpegScaleDenominator(1920, 1080, 320, 180), 4);
+    EXPECT_EQ(jpegScaleDenominator(1920, 1080, 240, 135), 8);
+    EXPECT_EQ(jpegScaleDenominator(1920, 1080, 100, 50), 8);
+    EXPECT_EQ(jpegScaleDenominator(1920, 1080, 961, 1080), 1);
+    EXPECT_EQ(jpegScaleDenominator(1920, 1080, 960, 540), 2);
+    // A tall target is bound by the width: the height may fall short of it
+    EXPECT_EQ(jpegScaleDenominator(1920, 1080, 480, 1000), 4);
+    // Rounded up like libjpeg: 1001 / 8 -> 126
+    EXPECT_EQ(jpegScaleDenominator(1001, 1001, 126, 126), 8);
+    // No target, or a bigger one: full size
+    EXPECT_EQ(jpegScaleDenominator(1920, 1080, 0, 0), 1);
+    EXPECT_EQ(jpegScaleDenominator(640, 480, 1280, 960), 1);
+    EXPECT_EQ(jpegScaleDenominator(0, 0, 320, 180), 1);
+}
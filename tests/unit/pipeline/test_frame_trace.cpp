@@ -0,0 +1,151 @@
+/**
+ * @file test_frame_trace.cpp
+ * @brief Unit tests for the frame-lifecycle trace rings and their Chrome trace export
+ *
+ * Tests validate:
+ * - Nothing is recorded while tracing is disabled
+ * - Complete and instant events, frame numbers and thread names in the JSON
+ * - One ring per thread; a full ring keeps the newest events
+ * - Dumps while other threads record only contain whole events
+ */
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "frametrace.h"
+
+namespace {
+bool contains(const std::string& text, const std::string& part)
+{
+    return text.find(part) != std::string::npos;
+}
+
+std::size_t occurrences(const std::string& text, const std::string& part)
+{
+    std::size_t count = 0;
+    for (std::size_t at = text.find(part); at != std::string::npos; at = text.find(part, at + part.size()))
+        ++count;
+    return count;
+}
+
+// Events are recorded into process-wide rings: each test uses its own names
+class FrameTraceTest : public ::testing::Test
+{
+protected:
+    void SetUp() override { FrameTrace::setEnabled(true); }
+    void TearDown() override { FrameTrace::setEnabled(false); }
+};
+} // namespace
+
+TEST_F(FrameTraceTest, DisabledRecordsNothing) {
+    FrameTrace::setEnabled(false);
+    {
+        FrameTraceScope scope("disabled-scope", "test", 1);
+    }
+    FrameTrace::instant("disabled-instant", "test");
+    FrameTrace::complete("disabled-complete", "test", 10, 5);
+
+    const std::string json = FrameTrace::chromeJson();
+    EXPECT_FALSE(contains(json, "disabled-"));
+}
+
+TEST_F(FrameTraceTest, RecordsCompleteAndInstantEvents) {
+    FrameTrace::setThreadName("main \"test\"");
+    FrameTrace::complete("decode-event", "server", 1000, 250, 42);
+    FrameTrace::instant("queue-event", "client");
+    {
+        FrameTraceScope scope("scope-event", "server");
+        scope.setFrame(7);
+    }
+
+    const std::string json = FrameTrace::chromeJson(123, "server");
+    EXPECT_EQ(json.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["), 0u);
+    EXPECT_TRUE(contains(json, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":123,\"tid\":0,"
+                               "\"args\":{\"name\":\"server\"}}"));
+    EXPECT_TRUE(contains(json, "\"args\":{\"name\":\"main \\\"test\\\"\"}"));
+    EXPECT_TRUE(contains(json, "{\"name\":\"decode-event\",\"cat\":\"server\",\"ph\":\"X\",\"ts\":1000,\"dur\":250,"
+                               "\"pid\":123,"));
+    EXPECT_TRUE(contains(json, "\"args\":{\"frame\":42}"));
+    EXPECT_TRUE(contains(json, "{\"name\":\"queue-event\",\"cat\":\"client\",\"ph\":\"i\",\"s\":\"t\",\"ts\":"));
+    EXPECT_TRUE(contains(json, "\"args\":{\"frame\":7}"));
+    EXPECT_EQ(json.substr(json.size() - 3), "]}\n");
+}
+
+TEST_F(FrameTraceTest, EachThreadHasItsOwnRing) {
+    std::thread first([]() {
+        FrameTrace::setThreadName("ring-thread-a");
+        FrameTrace::instant("ring-event-a", "test");
+    });
+    first.join();
+    std::thread second([]() {
+        FrameTrace::setThreadName("ring-thread-b");
+        FrameTrace::instant("ring-event-b", "test");
+    });
+    second.join();
+
+    // The rings outlive their threads
+    const std::string json = FrameTrace::chromeJson();
+    const std::size_t nameA = json.find("ring-thread-a");
+    const std::size_t nameB = json.find("ring-thread-b");
+    const std::size_t eventA = json.find("ring-event-a");
+    const std::size_t eventB = json.find("ring-event-b");
+    ASSERT_NE(nameA, std::string::npos);
+    ASSERT_NE(nameB, std::string::npos);
+    ASSERT_NE(eventA, std::string::npos);
+    ASSERT_NE(eventB, std::string::npos);
+    // Each thread's events follow its own metadata entry
+    EXPECT_LT(nameA, eventA);
+    EXPECT_LT(eventA, nameB);
+    EXPECT_LT(nameB, eventB);
+}
+
+TEST_F(FrameTraceTest, FullRingKeepsTheNewestEvents) {
+    const std::size_t capacity = FrameTrace::kRingEvents;
+    std::thread writer([capacity]() {
+        for (std::size_t i = 0; i < capacity + 100; ++i)
+            FrameTrace::complete("wrap-event", "test", 1, 1, static_cast<std::int64_t>(i));
+    });
+    writer.join();
+
+    // The slot the writer would fill next is never dumped
+    const std::string json = FrameTrace::chromeJson();
+    EXPECT_EQ(occurrences(json, "\"wrap-event\""), capacity - 1);
+    EXPECT_FALSE(contains(json, "\"args\":{\"frame\":100}"));
+    EXPECT_TRUE(contains(json, "\"args\":{\"frame\":101}"));
+    EXPECT_TRUE(contains(json, "\"args\":{\"frame\":" + std::to_string(capacity + 99) + "}"));
+}
+
+TEST_F(FrameTraceTest, DumpWhileRecordingHasOnlyWholeEvents) {
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 2; ++t) {
+        writers.emplace_back([&stop]() {
+            std::int64_t frame = 0;
+            while (!stop.load()) {
+                FrameTraceScope scope("busy-event", "test", frame);
+                frame = (frame + 1) % 1000;
+            }
+        });
+    }
+    for (int i = 0; i < 5; ++i) {
+        const std::string json = FrameTrace::chromeJson();
+        // Every busy event came out complete: name, duration and frame
+        const std::size_t events = occurrences(json, "{\"name\":\"busy-event\",\"cat\":\"test\",\"ph\":\"X\",");
+        EXPECT_EQ(events, occurrences(json, "\"busy-event\""));
+        EXPECT_EQ(json.substr(json.size() - 3), "]}\n");
+    }
+    stop = true;
+    for (std::thread& writer : writers)
+        writer.join();
+}
+
+TEST_F(FrameTraceTest, EnablesFromEnvironment) {
+    FrameTrace::setEnabled(false);
+    setenv("IMAGESOCKET_TRACE", "0", 1);
+    EXPECT_FALSE(FrameTrace::enableFromEnvironment());
+    setenv("IMAGESOCKET_TRACE", "1", 1);
+    EXPECT_TRUE(FrameTrace::enableFromEnvironment());
+    unsetenv("IMAGESOCKET_TRACE");
+}
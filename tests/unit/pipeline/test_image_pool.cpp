@@ -0,0 +1,109 @@
+/**
+ * @file test_image_pool.cpp
+ * @brief Unit tests for the pooled decoded-frame pixel buffers
+ *
+ * Tests validate:
+ * - Acquired images are writable RGB32 with a packed stride
+ * - Pixels return to the pool when the last copy is destroyed, not before
+ * - Buffers are only reused for the same resolution
+ * - Idle list is bounded and buffers released after the pool is gone are freed
+ * - Idle memory is reported and freed on demand (memory pressure)
+ */
+
+#include <gtest/gtest.h>
+#include <QImage>
+#include <thread>
+#include "imagepool.h"
+
+TEST(ImagePoolTest, AcquiredImageIsWritableRgb32) {
+    ImagePool pool;
+    QImage image = pool.acquire(64, 48);
+    ASSERT_FALSE(image.isNull());
+    EXPECT_EQ(image.format(), QImage::Format_RGB32);
+    EXPECT_EQ(image.size(), QSize(64, 48));
+    EXPECT_EQ(image.bytesPerLine(), 64 * 4);
+
+    const uchar* before = image.constBits();
+    image.fill(Qt::red); // a sole owner writes in place
+    EXPECT_EQ(image.constBits(), before);
+    EXPECT_EQ(image.pixel(10, 10), qRgb(255, 0, 0));
+}
+
+TEST(ImagePoolTest, PixelsReturnWhenLastCopyIsReleased) {
+    ImagePool pool;
+    const uchar* storage = nullptr;
+    {
+        QImage image = pool.acquire(32, 32);
+        storage = image.constBits();
+        QImage consumer = image; // e.g. the image provider's copy
+        image = QImage();
+        EXPECT_EQ(pool.idleCount(), 0u);
+    }
+    EXPECT_EQ(pool.idleCount(), 1u);
+
+    QImage again = pool.acquire(32, 32);
+    EXPECT_EQ(again.constBits(), storage);
+    EXPECT_EQ(pool.allocatedCount(), 1u);
+    EXPECT_EQ(pool.reusedCount(), 1u);
+}
+
+TEST(ImagePoolTest, ReuseIsPerResolution) {
+    ImagePool pool;
+    pool.acquire(32, 32);
+    EXPECT_EQ(pool.idleCount(), 1u);
+
+    QImage other = pool.acquire(64, 32);
+    EXPECT_EQ(pool.reusedCount(), 0u);
+    EXPECT_EQ(pool.idleCount(), 1u); // the 32x32 buffer still waits
+
+    QImage same = pool.acquire(32, 32);
+    EXPECT_EQ(pool.reusedCount(), 1u);
+    EXPECT_EQ(pool.idleCount(), 0u);
+}
+
+TEST(ImagePoolTest, IdleListIsBounded) {
+    ImagePool pool(2);
+    {
+        QImage a = pool.acquire(16, 16);
+        QImage b = pool.acquire(16, 16);
+        QImage c = pool.acquire(16, 16);
+    }
+    EXPECT_EQ(pool.idleCount(), 2u);
+    EXPECT_EQ(pool.allocatedCount(), 3u);
+}
+
+TEST(ImagePoolTest, IdleBytesAndTrim) {
+    ImagePool pool;
+    {
+        QImage a = pool.acquire(16, 16);
+        QImage b = pool.acquire(32, 8);
+    }
+    EXPECT_EQ(pool.idleBytes(), 2u * 16 * 16 * 4);
+    QImage kept = pool.acquire(16, 16);
+    pool.trim();
+    EXPECT_EQ(pool.idleCount(), 0u);
+    EXPECT_EQ(pool.idleBytes(), 0u);
+    kept = QImage(); // in use during the trim: comes back as usual
+    EXPECT_EQ(pool.idleCount(), 1u);
+}
+
+TEST(ImagePoolTest, InvalidSizesGiveNullImages) {
+    ImagePool pool;
+    EXPECT_TRUE(pool.acquire(0, 10).isNull());
+    EXPECT_TRUE(pool.acquire(10, -1).isNull());
+    EXPECT_TRUE(pool.acquire(1 << 16, 1 << 16).isNull());
+    EXPECT_EQ(pool.allocatedCount(), 0u);
+}
+
+TEST(ImagePoolTest, ReleaseFromOtherThreadAndAfterPoolDestruction) {
+    QImage survivor;
+    {
+        ImagePool pool;
+        QImage image = pool.acquire(16, 16);
+        std::thread([moved = std::move(image)]() mutable { moved = QImage(); }).join();
+        EXPECT_EQ(pool.idleCount(), 1u);
+        survivor = pool.acquire(16, 16);
+    }
+    survivor.fill(Qt::blue); // still valid, freed when released
+    survivor = QImage();
+}
@@ -0,0 +1,117 @@
+/**
+ * @file test_ingress_budget.cpp
+ * @brief Unit tests for the server-wide ingress budget scheduler
+ *
+ * Tests validate:
+ * - Without limits (or within them) every client keeps its ceiling
+ * - Bandwidth is split by priority, unused shares go to the others
+ * - The decode-time budget limits decoded clients only
+ * - The minimum rate is kept and a quality cap covers the shortfall
+ */
+
+#include <gtest/gtest.h>
+#include "ingressbudget.h"
+
+namespace {
+
+IngressDemand demand(const char* id, IngressPriority priority, int maxFps, double bytesPerFrame,
+                     double decodeMsPerFrame = -1.0, int quality = 75)
+{
+    IngressDemand d;
+    d.clientId = id;
+    d.priority = priority;
+    d.maxFps = maxFps;
+    d.bytesPerFrame = bytesPerFrame;
+    d.decodeMsPerFrame = decodeMsPerFrame;
+    d.quality = quality;
+    return d;
+}
+
+IngressBudgetConfig bandwidth(double mbps)
+{
+    IngressBudgetConfig config;
+    config.maxBitsPerSecond = mbps * 1e6;
+    return config;
+}
+
+} // namespace
+
+TEST(IngressBudgetTest, WithinBudgetKeepsCeilings) {
+    EXPECT_FALSE(IngressBudget().enabled());
+    IngressBudget budget(bandwidth(100.0));
+    EXPECT_TRUE(budget.enabled());
+
+    // 2 x 30 fps x 50 KB = 24 Mbit/s
+    const std::vector<IngressGrant> grants = budget.allocate({
+        demand("a", IngressPriority::Active, 30, 50000),
+        demand("b", IngressPriority::Background, 30, 50000),
+    });
+    ASSERT_EQ(grants.size(), 2u);
+    EXPECT_EQ(grants[0].clientId, "a");
+    EXPECT_EQ(grants[0].fps, 30);
+    EXPECT_EQ(grants[1].fps, 30);
+    EXPECT_EQ(grants[0].maxQuality, 0);
+}
+
+TEST(IngressBudgetTest, SplitsBandwidthByPriority) {
+    // 10 Mbit/s, weights 4:2:1; every client would need 12 Mbit/s at its ceiling
+    IngressBudget budget(bandwidth(10.0));
+    const std::vector<IngressGrant> grants = budget.allocate({
+        demand("active", IngressPriority::Active, 30, 50000),
+        demand("pinned", IngressPriority::Pinned, 30, 50000),
+        demand("background", IngressPriority::Background, 30, 50000),
+    });
+    // 400 kbit per frame: 5.71, 2.86 and 1.43 Mbit/s
+    EXPECT_EQ(grants[0].fps, 14);
+    EXPECT_EQ(grants[1].fps, 7);
+    EXPECT_EQ(grants[2].fps, 3);
+    EXPECT_GT(grants[0].fps, grants[1].fps);
+}
+
+TEST(IngressBudgetTest, UnusedShareGoesToTheOthers) {
+    IngressBudget budget(bandwidth(10.0));
+    // The preview only needs 2 fps x 400 kbit = 0.8 Mbit/s of its share
+    const std::vector<IngressGrant> grants = budget.allocate({
+        demand("active", IngressPriority::Active, 30, 50000),
+        demand("preview", IngressPriority::Background, 2, 50000),
+    });
+    EXPECT_EQ(grants[1].fps, 2);
+    EXPECT_EQ(grants[0].fps, 23); // (10 - 0.8) Mbit/s / 400 kbit
+}
+
+TEST(IngressBudgetTest, DecodeBudgetLimitsDecodedClients) {
+    IngressBudgetConfig config;
+    config.maxDecodeMsPerSecond = 200.0;
+    IngressBudget budget(config);
+    const std::vector<IngressGrant> grants = budget.allocate({
+        demand("decoded", IngressPriority::Active, 60, 50000, 10.0),
+        demand("forwarded", IngressPriority::Background, 60, 50000), // not decoded
+    });
+    EXPECT_EQ(grants[0].fps, 20);
+    EXPECT_EQ(grants[1].fps, 60);
+}
+
+TEST(IngressBudgetTest, UnknownCostDoesNotLimit) {
+    IngressBudget budget(bandwidth(1.0));
+    const std::vector<IngressGrant> grants = budget.allocate({
+        demand("new", IngressPriority::Background, 30, -1.0),
+        demand("idle", IngressPriority::Background, 0, 50000),
+    });
+    EXPECT_EQ(grants[0].fps, 30);
+    EXPECT_EQ(grants[1].fps, 0);
+}
+
+TEST(IngressBudgetTest, KeepsMinimumRateAndCapsQuality) {
+    IngressBudgetConfig config = bandwidth(1.0);
+    config.minFps = 2;
+    IngressBudget budget(config);
+    // Two equal clients, 0.5 Mbit/s each; 2 fps of 100 KB would take 1.6 Mbit/s
+    const std::vector<IngressGrant> grants = budget.allocate({
+        demand("a", IngressPriority::Background, 30, 100000, -1.0, 80),
+        demand("b", IngressPriority::Background, 30, 100000, -1.0, 80),
+    });
+    EXPECT_EQ(grants[0].fps, 2);
+    EXPECT_EQ(grants[1].fps, 2);
+    EXPECT_EQ(grants[0].maxQuality, 30); // 80 * 0.5 / 1.6 = 25, floored at minQuality
+    EXPECT_EQ(grants[1].maxQuality, 30);
+}
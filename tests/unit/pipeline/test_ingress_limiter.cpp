@@ -0,0 +1,94 @@
+/**
+ * @file test_ingress_limiter.cpp
+ * @brief Unit tests for the per-client ingress cap (admission control)
+ *
+ * Tests validate:
+ * - Clients within the cap (or without one) are left alone
+ * - An interval over the cap asks for an fps that fits it
+ * - Persistently over the cap ends in a disconnect; a good interval resets the count
+ * - Evaluations are paced by the configured interval
+ */
+
+#include <gtest/gtest.h>
+#include "ingresslimiter.h"
+
+namespace {
+
+const std::int64_t kStartMs = 1000000;
+
+IngressLimiterConfig cap(std::int64_t bytesPerSecond, int graceIntervals = 3)
+{
+    IngressLimiterConfig config;
+    config.maxBytesPerSecond = bytesPerSecond;
+    config.graceIntervals = graceIntervals;
+    return config;
+}
+
+// One second of `frames` frames of `bytes` each
+IngressAction runInterval(IngressLimiter& limiter, std::int64_t& now, int frames, std::size_t bytes)
+{
+    for (int i = 0; i < frames; ++i)
+        limiter.onFrame(bytes);
+    now += 1000;
+    return limiter.evaluate(now);
+}
+
+IngressLimiter started(const IngressLimiterConfig& config, std::int64_t& now)
+{
+    IngressLimiter limiter(config);
+    now = kStartMs;
+    limiter.evaluate(now);
+    return limiter;
+}
+
+} // namespace
+
+TEST(IngressLimiterTest, WithinCapDoesNothing) {
+    std::int64_t now = 0;
+    IngressLimiter limiter = started(cap(1000000), now);
+    EXPECT_EQ(runInterval(limiter, now, 30, 30000).kind, IngressAction::None); // 900 KB/s
+
+    IngressLimiter unlimited = started(IngressLimiterConfig(), now);
+    EXPECT_EQ(runInterval(unlimited, now, 60, 1000000).kind, IngressAction::None);
+}
+
+TEST(IngressLimiterTest, OverCapThrottlesToFit) {
+    std::int64_t now = 0;
+    IngressLimiter limiter = started(cap(1000000), now);
+    // 30 fps x 100 KB = 3 MB/s: 10 fps fit
+    const IngressAction action = runInterval(limiter, now, 30, 100000);
+    EXPECT_EQ(action.kind, IngressAction::Throttle);
+    EXPECT_EQ(action.fps, 10);
+    EXPECT_EQ(limiter.overIntervals(), 1);
+
+    // Frames larger than the whole cap still keep the minimum rate
+    const IngressAction floor = runInterval(limiter, now, 2, 4000000);
+    EXPECT_EQ(floor.kind, IngressAction::Throttle);
+    EXPECT_EQ(floor.fps, 1);
+}
+
+TEST(IngressLimiterTest, PersistentClientIsDisconnected) {
+    std::int64_t now = 0;
+    IngressLimiter limiter = started(cap(1000000, 3), now);
+    for (int i = 0; i < 3; ++i)
+        EXPECT_EQ(runInterval(limiter, now, 30, 100000).kind, IngressAction::Throttle);
+    EXPECT_EQ(runInterval(limiter, now, 30, 100000).kind, IngressAction::Disconnect);
+}
+
+TEST(IngressLimiterTest, ComplyingIntervalResetsCount) {
+    std::int64_t now = 0;
+    IngressLimiter limiter = started(cap(1000000, 2), now);
+    runInterval(limiter, now, 30, 100000);
+    runInterval(limiter, now, 30, 100000);
+    EXPECT_EQ(runInterval(limiter, now, 10, 50000).kind, IngressAction::None);
+    EXPECT_EQ(limiter.overIntervals(), 0);
+    EXPECT_EQ(runInterval(limiter, now, 30, 100000).kind, IngressAction::Throttle);
+}
+
+TEST(IngressLimiterTest, EvaluationPacedByInterval) {
+    std::int64_t now = 0;
+    IngressLimiter limiter = started(cap(1000), now);
+    limiter.onFrame(1000000);
+    EXPECT_EQ(limiter.evaluate(now + 500).kind, IngressAction::None);
+    EXPECT_EQ(limiter.evaluate(now + 1000).kind, IngressAction::Throttle);
+}
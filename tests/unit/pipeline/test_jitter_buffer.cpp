@@ -0,0 +1,154 @@
+/**
+ * @file test_jitter_buffer.cpp
+ * @brief Unit tests for the display jitter buffer's pacing and adaptive delay
+ *
+ * Tests validate:
+ * - Jittered arrivals are shown at the capture pace, each frame once
+ * - Smooth mode holds frames longer than low-latency mode and has fewer late frames
+ * - The delay rises at once with more jitter and eases back down when it is gone
+ * - Late frames show at the next refresh; frames older than a shown one are dropped
+ * - Out-of-order arrivals are put back in capture order; a transit jump restarts
+ */
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "jitterbuffer.h"
+
+namespace {
+
+const std::int64_t kFrameUs = 33333;  // 30 fps capture
+const std::int64_t kVsyncUs = 16667;  // 60 Hz display
+
+struct Shown {
+    int frame;
+    std::int64_t displayUs;
+};
+
+// Frames captured every kFrameUs arrive after 40 ms plus up to `jitterUs`;
+// the display takes one at each vsync. Returns what was shown, in order.
+std::vector<Shown> run(JitterBuffer<int>& buffer, int frames, std::int64_t jitterUs, unsigned seed = 1,
+                       std::int64_t startUs = 0)
+{
+    std::mt19937 random(seed);
+    std::uniform_int_distribution<std::int64_t> jitter(0, jitterUs);
+    std::vector<std::pair<std::int64_t, int>> arrivals; // (arrival, frame)
+    for (int i = 0; i < frames; ++i)
+        arrivals.emplace_back(startUs + i * kFrameUs + 40000 + jitter(random), i);
+    std::sort(arrivals.begin(), arrivals.end());
+
+    std::vector<Shown> shown;
+    std::size_t next = 0;
+    const std::int64_t endUs = startUs + frames * kFrameUs + 1000000;
+    for (std::int64_t vsync = startUs; vsync < endUs; vsync += kVsyncUs) {
+        while (next < arrivals.size() && arrivals[next].first <= vsync) {
+            const int frame = arrivals[next].second;
+            buffer.push(frame, startUs + frame * kFrameUs, arrivals[next].first);
+            ++next;
+        }
+        int frame = -1;
+        if (buffer.take(vsync, frame))
+            shown.push_back(Shown{frame, vsync});
+    }
+    return shown;
+}
+
+} // namespace
+
+TEST(JitterBufferTest, JitteredArrivalsShowAtCapturePace) {
+    JitterBuffer<int> buffer(JitterMode::Smooth);
+    const std::vector<Shown> shown = run(buffer, 300, 30000);
+
+    // After the first second every frame is shown, two refreshes apart
+    int uneven = 0;
+    for (std::size_t i = 31; i < shown.size(); ++i) {
+        EXPECT_EQ(shown[i].frame, shown[i - 1].frame + 1);
+        if (shown[i].displayUs - shown[i - 1].displayUs != 2 * kVsyncUs)
+            ++uneven;
+    }
+    EXPECT_EQ(uneven, 0);
+    EXPECT_EQ(shown.back().frame, 299);
+    EXPECT_GE(buffer.targetDelayUs(), 40000 + 29000);
+    EXPECT_LE(buffer.targetDelayUs(), 40000 + 30000 + kFrameUs + 1000);
+}
+
+TEST(JitterBufferTest, SmoothHoldsLongerWithFewerLateFrames) {
+    JitterBuffer<int> lowLatency(JitterMode::LowLatency);
+    JitterBuffer<int> smooth(JitterMode::Smooth);
+    run(lowLatency, 600, 30000, 7);
+    run(smooth, 600, 30000, 7);
+    EXPECT_LT(lowLatency.targetDelayUs(), smooth.targetDelayUs());
+    EXPECT_GT(lowLatency.targetDelayUs(), 40000 + 20000) << "still absorbs most of the jitter";
+    EXPECT_LT(smooth.late(), lowLatency.late());
+    EXPECT_LE(smooth.late(), 2u);
+}
+
+TEST(JitterBufferTest, DelayRisesAtOnceAndEasesDown) {
+    JitterBuffer<int> buffer(JitterMode::LowLatency);
+    run(buffer, 100, 2000);
+    const std::int64_t calm = buffer.targetDelayUs();
+    EXPECT_NEAR(calm, 42000, 2000);
+
+    // A frame 50 ms later than the rest raises the target right away (at 90% of a short window)
+    for (int i = 0; i < 10; ++i)
+        buffer.push(1000 + i, 10000000 + i * kFrameUs, 10000000 + i * kFrameUs + 100000);
+    EXPECT_GE(buffer.targetDelayUs(), 100000);
+    buffer.clear();
+
+    // Calm again: down by at most a step per frame shown, back near the calm delay
+    const std::int64_t raised = buffer.targetDelayUs();
+    std::int64_t previous = raised;
+    int frame = 0;
+    for (int i = 0; i < 200; ++i) {
+        const std::int64_t capture = 20000000 + i * kFrameUs;
+        buffer.push(i, capture, capture + 42000);
+        if (buffer.take(capture + 200000, frame)) {
+            EXPECT_GE(buffer.targetDelayUs(), previous - JitterBuffer<int>::kDecreaseStepUs);
+            previous = buffer.targetDelayUs();
+        }
+    }
+    EXPECT_NEAR(buffer.targetDelayUs(), 42000, 1000);
+}
+
+TEST(JitterBufferTest, LateFrameShowsNextAndStaleIsDropped) {
+    JitterBuffer<int> buffer(JitterMode::LowLatency);
+    for (int i = 0; i < 10; ++i)
+        buffer.push(i, i * kFrameUs, i * kFrameUs + 40000);
+    int frame = -1;
+    ASSERT_TRUE(buffer.take(9 * kFrameUs + 40000, frame));
+    EXPECT_EQ(frame, 9);
+    EXPECT_EQ(buffer.skipped(), 9u) << "older due frames replaced by the newest";
+
+    // Frame 10 is 60 ms late: it is shown at the next refresh anyway
+    buffer.push(10, 10 * kFrameUs, 10 * kFrameUs + 100000);
+    EXPECT_EQ(buffer.late(), 1u);
+    ASSERT_TRUE(buffer.take(10 * kFrameUs + 100000, frame));
+    EXPECT_EQ(frame, 10);
+
+    // A frame captured before the one shown is of no use any more
+    EXPECT_FALSE(buffer.push(8, 8 * kFrameUs, 10 * kFrameUs + 110000));
+    EXPECT_TRUE(buffer.empty());
+}
+
+TEST(JitterBufferTest, ReordersAndRestartsOnTransitJump) {
+    JitterBuffer<int> buffer(JitterMode::LowLatency);
+    // Frame 3 overtakes frame 2 on the way
+    buffer.push(1, 1 * kFrameUs, 1 * kFrameUs + 40000);
+    buffer.push(3, 3 * kFrameUs, 3 * kFrameUs + 5000);
+    buffer.push(2, 2 * kFrameUs, 2 * kFrameUs + 40000);
+    EXPECT_EQ(buffer.nextDueUs(), 1 * kFrameUs + 40000);
+    int frame = -1;
+    ASSERT_TRUE(buffer.take(2 * kFrameUs + 40000, frame));
+    EXPECT_EQ(frame, 2);
+    ASSERT_TRUE(buffer.take(3 * kFrameUs + 40000, frame));
+    EXPECT_EQ(frame, 3);
+    EXPECT_FALSE(buffer.take(4 * kFrameUs + 40000, frame));
+
+    // The clock offset moved by 5 s: a new stream, not a 5 s delay
+    buffer.push(4, 4 * kFrameUs, 4 * kFrameUs + 5040000);
+    EXPECT_EQ(buffer.targetDelayUs(), 5040000);
+    EXPECT_EQ(buffer.size(), 1u);
+    ASSERT_TRUE(buffer.take(4 * kFrameUs + 5040000, frame));
+    EXPECT_EQ(frame, 4);
+}
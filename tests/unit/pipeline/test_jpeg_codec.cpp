@@ -0,0 +1,131 @@
+/**
+ * @file test_jpeg_codec.cpp
+ * @brief Unit tests for the pluggable JPEG codec layer
+ *
+ * Runs against the best available backend (TurboJPEG when built with it) and the
+ * generic OpenCV/Qt fallback. Tests validate:
+ * - Encode/decode round trip preserves dimensions and approximate color
+ * - Decoded images use the GPU-friendly QImage::Format_RGB32
+ * - Output buffers keep their capacity across encodes
+ * - Scaled decodes come out at the DCT-scaled size that covers the target
+ * - Invalid input is rejected
+ */
+
+#include <gtest/gtest.h>
+#include <QImage>
+#include <vector>
+#include "jpegcodec.h"
+
+namespace {
+
+std::vector<unsigned char> solidBgr(int width, int height, unsigned char b, unsigned char g, unsigned char r)
+{
+    std::vector<unsigned char> pixels(static_cast<std::size_t>(width * height * 3));
+    for (std::size_t i = 0; i < pixels.size(); i += 3) {
+        pixels[i] = b;
+        pixels[i + 1] = g;
+        pixels[i + 2] = r;
+    }
+    return pixels;
+}
+
+void expectRoundTrip(JpegCodec& codec)
+{
+    const int width = 160, height = 120;
+    const std::vector<unsigned char> pixels = solidBgr(width, height, 200, 120, 40);
+
+    std::vector<unsigned char> jpeg;
+    ASSERT_TRUE(codec.encodeBgr(pixels.data(), width, height, width * 3, 80, jpeg)) << codec.name();
+    ASSERT_GT(jpeg.size(), 2u);
+    EXPECT_EQ(jpeg[0], 0xFF); // SOI marker
+    EXPECT_EQ(jpeg[1], 0xD8);
+
+    QImage image;
+    ASSERT_TRUE(codec.decode(jpeg.data(), static_cast<int>(jpeg.size()), image)) << codec.name();
+    EXPECT_EQ(image.width(), width);
+    EXPECT_EQ(image.height(), height);
+    EXPECT_EQ(image.format(), QImage::Format_RGB32);
+
+    const QRgb center = image.pixel(width / 2, height / 2);
+    EXPECT_NEAR(qRed(center), 40, 6);
+    EXPECT_NEAR(qGreen(center), 120, 6);
+    EXPECT_NEAR(qBlue(center), 200, 6);
+}
+
+void expectScaledDecode(JpegCodec& codec)
+{
+    const int width = 160, height = 120;
+    const std::vector<unsigned char> pixels = solidBgr(width, height, 200, 120, 40);
+    std::vector<unsigned char> jpeg;
+    ASSERT_TRUE(codec.encodeBgr(pixels.data(), width, height, width * 3, 80, jpeg)) << codec.name();
+
+    // 40x30 shows a quarter of each side: decoded at 1/4
+    QImage image;
+    ASSERT_TRUE(codec.decodeScaled(jpeg.data(), static_cast<int>(jpeg.size()), 40, 30, image)) << codec.name();
+    EXPECT_EQ(image.width(), 40);
+    EXPECT_EQ(image.height(), 30);
+    EXPECT_EQ(image.format(), QImage::Format_RGB32);
+    const QRgb center = image.pixel(20, 15);
+    EXPECT_NEAR(qRed(center), 40, 6);
+    EXPECT_NEAR(qBlue(center), 200, 6);
+
+    // Slightly larger than 1/4: 1/2
+    ASSERT_TRUE(codec.decodeScaled(jpeg.data(), static_cast<int>(jpeg.size()), 41, 31, image));
+    EXPECT_EQ(image.width(), 80);
+    EXPECT_EQ(image.height(), 60);
+
+    // No target: full size
+    ASSERT_TRUE(codec.decodeScaled(jpeg.data(), static_cast<int>(jpeg.size()), 0, 0, image));
+    EXPECT_EQ(image.width(), width);
+    EXPECT_EQ(image.height(), height);
+}
+
+} // namespace
+
+TEST(JpegCodecTest, BestBackendRoundTrip) {
+    std::unique_ptr<JpegCodec> codec = JpegCodec::create();
+    ASSERT_TRUE(codec);
+    expectRoundTrip(*codec);
+}
+
+TEST(JpegCodecTest, GenericBackendRoundTrip) {
+    std::unique_ptr<JpegCodec> codec = JpegCodec::createGeneric();
+    EXPECT_STREQ(codec->name(), "generic");
+    expectRoundTrip(*codec);
+}
+
+TEST(JpegCodecTest, ScaledDecode) {
+    expectScaledDecode(JpegCodec::forCurrentThread());
+    std::unique_ptr<JpegCodec> generic = JpegCodec::createGeneric();
+    expectScaledDecode(*generic);
+}
+
+TEST(JpegCodecTest, ThreadCodecIsStable) {
+    JpegCodec& a = JpegCodec::forCurrentThread();
+    JpegCodec& b = JpegCodec::forCurrentThread();
+    EXPECT_EQ(&a, &b);
+    EXPECT_STREQ(a.name(), JpegCodec::turboJpegAvailable() ? "turbojpeg" : "generic");
+}
+
+TEST(JpegCodecTest, OutputBufferCapacityIsReused) {
+    // cv::imencode manages its output vector itself; only TurboJPEG guarantees reuse
+    if (!JpegCodec::turboJpegAvailable())
+        GTEST_SKIP() << "built without TurboJPEG";
+    JpegCodec& codec = JpegCodec::forCurrentThread();
+    const std::vector<unsigned char> pixels = solidBgr(320, 240, 10, 20, 30);
+
+    std::vector<unsigned char> jpeg;
+    ASSERT_TRUE(codec.encodeBgr(pixels.data(), 320, 240, 320 * 3, 75, jpeg));
+    jpeg.reserve(jpeg.size() * 4);
+    const unsigned char* storage = jpeg.data();
+
+    ASSERT_TRUE(codec.encodeBgr(pixels.data(), 320, 240, 320 * 3, 75, jpeg));
+    EXPECT_EQ(jpeg.data(), storage);
+}
+
+TEST(JpegCodecTest, InvalidDataIsRejected) {
+    JpegCodec& codec = JpegCodec::forCurrentThread();
+    const unsigned char garbage[] = {0x00, 0x01, 0x02, 0x03, 0x04};
+    QImage image;
+    EXPECT_FALSE(codec.decode(garbage, sizeof(garbage), image));
+}
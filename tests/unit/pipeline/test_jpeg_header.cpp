@@ -0,0 +1,80 @@
+/**
+ * @file test_jpeg_header.cpp
+ * @brief Unit tests for the JPEG SOF header parser
+ *
+ * Tests validate:
+ * - Dimensions and component count read from baseline (SOF0) and progressive (SOF2) headers
+ * - APPn / DQT segments before the frame header are skipped
+ * - Non-JPEG and truncated input are rejected
+ */
+
+#include <gtest/gtest.h>
+#include <vector>
+#include "jpegheader.h"
+
+namespace {
+
+// SOI + APP0 (JFIF) + SOFn for a width x height, 3-component image
+std::vector<std::uint8_t> makeHeader(std::uint8_t sofMarker, int width, int height)
+{
+    std::vector<std::uint8_t> data = {0xFF, 0xD8};
+    const std::uint8_t app0[] = {0xFF, 0xE0, 0x00, 0x10, 'J', 'F', 'I', 'F', 0x00,
+                                 0x01, 0x01, 0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00};
+    data.insert(data.end(), app0, app0 + sizeof(app0));
+    const std::uint8_t sof[] = {0xFF, sofMarker, 0x00, 0x11, 0x08,
+                                static_cast<std::uint8_t>(height >> 8), static_cast<std::uint8_t>(height & 0xFF),
+                                static_cast<std::uint8_t>(width >> 8), static_cast<std::uint8_t>(width & 0xFF),
+                                0x03, 0x01, 0x22, 0x00, 0x02, 0x11, 0x01, 0x03, 0x11, 0x01};
+    data.insert(data.end(), sof, sof + sizeof(sof));
+    return data;
+}
+
+} // namespace
+
+TEST(JpegHeaderTest, ParsesBaselineDimensions) {
+    const auto data = makeHeader(0xC0, 1920, 1080);
+    JpegHeaderInfo info;
+    ASSERT_TRUE(parseJpegHeader(data.data(), data.size(), info));
+    EXPECT_EQ(info.width, 1920);
+    EXPECT_EQ(info.height, 1080);
+    EXPECT_EQ(info.components, 3);
+    EXPECT_FALSE(info.progressive);
+}
+
+TEST(JpegHeaderTest, DetectsProgressive) {
+    const auto data = makeHeader(0xC2, 640, 480);
+    JpegHeaderInfo info;
+    ASSERT_TRUE(parseJpegHeader(data.data(), data.size(), info));
+    EXPECT_TRUE(info.progressive);
+}
+
+TEST(JpegHeaderTest, SkipsDhtMarker) {
+    // DHT (C4) shares the SOF range but is not a frame header
+    std::vector<std::uint8_t> data = {0xFF, 0xD8, 0xFF, 0xC4, 0x00, 0x04, 0x00, 0x00};
+    const auto rest = makeHeader(0xC0, 32, 16);
+    data.insert(data.end(), rest.begin() + 2, rest.end());
+    JpegHeaderInfo info;
+    ASSERT_TRUE(parseJpegHeader(data.data(), data.size(), info));
+    EXPECT_EQ(info.width, 32);
+    EXPECT_EQ(info.height, 16);
+}
+
+TEST(JpegHeaderTest, RejectsNonJpeg) {
+    const std::uint8_t png[] = {0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A};
+    JpegHeaderInfo info;
+    EXPECT_FALSE(parseJpegHeader(png, sizeof(png), info));
+    EXPECT_FALSE(parseJpegHeader(nullptr, 0, info));
+}
+
+TEST(JpegHeaderTest, RejectsTruncatedHeader) {
+    auto data = makeHeader(0xC0, 1280, 720);
+    data.resize(data.size() - 8);
+    JpegHeaderInfo info;
+    EXPECT_FALSE(parseJpegHeader(data.data(), data.size(), info));
+}
+
+TEST(JpegHeaderTest, RejectsScanBeforeFrameHeader) {
+    const std::uint8_t data[] = {0xFF, 0xD8, 0xFF, 0xDA, 0x00, 0x08, 0x01, 0x01, 0x00, 0x00, 0x3F, 0x00};
+    JpegHeaderInfo info;
+    EXPECT_FALSE(parseJpegHeader(data, sizeof(data), info));
+}
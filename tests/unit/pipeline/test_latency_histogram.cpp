@@ -0,0 +1,104 @@
+/**
+ * @file test_latency_histogram.cpp
+ * @brief Unit tests for the logarithmic latency histogram
+ *
+ * Tests validate:
+ * - Percentiles land within one bucket (~9%) of the recorded values
+ * - Tiny, negative and huge samples are kept in the edge buckets
+ * - decay() halves the counts so old samples fade out
+ * - Stage keys used by QML are stable
+ */
+
+#include <gtest/gtest.h>
+#include "latencyhistogram.h"
+
+TEST(LatencyHistogramTest, EmptyHasNoPercentiles) {
+    LatencyHistogram histogram;
+    EXPECT_EQ(histogram.count(), 0u);
+    EXPECT_LT(histogram.percentile(50), 0.0);
+}
+
+TEST(LatencyHistogramTest, PercentilesWithinOneBucket) {
+    LatencyHistogram histogram;
+    for (int i = 1; i <= 100; ++i)
+        histogram.record(static_cast<double>(i)); // 1..100 ms
+
+    const double p50 = histogram.percentile(50);
+    const double p99 = histogram.percentile(99);
+    EXPECT_GE(p50, 50.0);
+    EXPECT_LE(p50, 50.0 * 1.1);
+    EXPECT_GE(p99, 99.0);
+    EXPECT_LE(p99, 99.0 * 1.1);
+    EXPECT_EQ(histogram.count(), 100u);
+}
+
+TEST(LatencyHistogramTest, OutliersOnlyMoveTheTail) {
+    LatencyHistogram histogram;
+    for (int i = 0; i < 995; ++i)
+        histogram.record(20.0);
+    for (int i = 0; i < 5; ++i)
+        histogram.record(800.0);
+
+    EXPECT_LE(histogram.percentile(50), 22.0);
+    EXPECT_LE(histogram.percentile(99), 22.0);
+    EXPECT_GE(histogram.percentile(99.9), 800.0);
+}
+
+TEST(LatencyHistogramTest, EdgeSamplesKept) {
+    LatencyHistogram histogram;
+    histogram.record(-3.0);   // clock skew
+    histogram.record(0.0);
+    histogram.record(1e9);    // far beyond the last bucket
+    EXPECT_EQ(histogram.count(), 3u);
+    EXPECT_EQ(LatencyHistogram::bucketFor(-3.0), 0);
+    EXPECT_EQ(LatencyHistogram::bucketFor(1e9), LatencyHistogram::kBucketCount - 1);
+    EXPECT_LE(histogram.percentile(50), kLatencyMinMs);
+    EXPECT_GT(histogram.percentile(100), 20000.0);
+}
+
+TEST(LatencyHistogramTest, DecayFadesOldSamples) {
+    LatencyHistogram histogram;
+    for (int i = 0; i < 8; ++i)
+        histogram.record(100.0);
+    histogram.decay();
+    EXPECT_EQ(histogram.count(), 4u);
+
+    // New samples now outweigh the old ones
+    for (int i = 0; i < 6; ++i)
+        histogram.record(5.0);
+    EXPECT_LE(histogram.percentile(50), 5.5);
+
+    histogram.decay();
+    histogram.decay();
+    histogram.decay();
+    EXPECT_EQ(histogram.count(), 0u);
+}
+
+TEST(LatencyHistogramTest, MergeAddsSamples) {
+    LatencyHistogram fast, slow;
+    for (int i = 0; i < 98; ++i)
+        fast.record(2.0);
+    slow.record(400.0);
+    slow.record(400.0);
+
+    LatencyHistogram all;
+    all.merge(fast);
+    all.merge(slow);
+    EXPECT_EQ(all.count(), 100u);
+    EXPECT_LE(all.percentile(50), 2.2);
+    EXPECT_GE(all.percentile(99), 400.0);
+    EXPECT_EQ(fast.count(), 98u); // sources untouched
+}
+
+TEST(LatencyHistogramTest, BreakdownAndStageKeys) {
+    LatencyBreakdown breakdown;
+    breakdown[LatencyStage::Decode].record(4.0);
+    EXPECT_EQ(breakdown[LatencyStage::Decode].count(), 1u);
+    EXPECT_EQ(breakdown[LatencyStage::Network].count(), 0u);
+
+    EXPECT_STREQ(latencyStageKey(LatencyStage::CaptureToSend), "captureToSend");
+    EXPECT_STREQ(latencyStageKey(LatencyStage::Network), "network");
+    EXPECT_STREQ(latencyStageKey(LatencyStage::Decode), "decode");
+    EXPECT_STREQ(latencyStageKey(LatencyStage::Display), "display");
+    EXPECT_STREQ(latencyStageKey(LatencyStage::EndToEnd), "endToEnd");
+}
@@ -0,0 +1,141 @@
+/**
+ * @file test_memory_budget.cpp
+ * @brief Unit tests for the server memory budget (bounded per-client buffering)
+ *
+ * Tests validate:
+ * - A charge is held until its last copy goes away, then released
+ * - A connection beyond its cap is refused, one with nothing in flight never is
+ * - The total counts every connection plus the bytes the owner reports
+ * - Pressure starts at the configured share of the total
+ * - The usage report lists the connections holding memory, largest first
+ */
+
+#include <gtest/gtest.h>
+#include <vector>
+#include "memorybudget.h"
+
+namespace {
+
+MemoryBudgetConfig limits(std::int64_t total, std::int64_t perClient)
+{
+    MemoryBudgetConfig config;
+    config.totalBytes = total;
+    config.perClientBytes = perClient;
+    return config;
+}
+
+} // namespace
+
+TEST(MemoryBudgetTest, ChargeFollowsTheLastCopy) {
+    MemoryBudget budget;
+    auto account = budget.openAccount("camera");
+    MemoryBudget::Charge charge = account->charge(1000);
+    ASSERT_TRUE(charge);
+    EXPECT_EQ(account->bytes(), 1000);
+    EXPECT_EQ(budget.chargedBytes(), 1000);
+
+    MemoryBudget::Charge queued = charge; // a queued signal's copy of the frame
+    charge.reset();
+    EXPECT_EQ(budget.chargedBytes(), 1000);
+    queued.reset();
+    EXPECT_EQ(account->bytes(), 0);
+    EXPECT_EQ(budget.chargedBytes(), 0);
+
+    // Without limits everything is admitted, and still counted
+    std::vector<MemoryBudget::Charge> held;
+    for (int i = 0; i < 100; ++i)
+        held.push_back(account->charge(1 << 20));
+    EXPECT_EQ(budget.chargedBytes(), 100LL << 20);
+    EXPECT_FALSE(budget.underPressure());
+}
+
+TEST(MemoryBudgetTest, PerClientCap) {
+    MemoryBudget budget(limits(0, 3000));
+    auto slow = budget.openAccount("slow");
+    auto other = budget.openAccount("other");
+
+    std::vector<MemoryBudget::Charge> held;
+    held.push_back(slow->charge(1500));
+    held.push_back(slow->charge(1500));
+    EXPECT_FALSE(slow->charge(1)); // the slow consumer's frames pile up no further
+    EXPECT_EQ(slow->refused(), 1u);
+    EXPECT_TRUE(other->charge(2000)); // others are not affected
+
+    held.clear();
+    EXPECT_TRUE(slow->charge(1500)); // drained: admitted again
+
+    // Nothing in flight: even a frame larger than the cap gets through
+    auto big = budget.openAccount("big");
+    MemoryBudget::Charge first = big->charge(10000);
+    EXPECT_TRUE(first);
+    EXPECT_FALSE(big->charge(10000));
+    first.reset();
+    EXPECT_TRUE(big->charge(10000));
+}
+
+TEST(MemoryBudgetTest, TotalCountsEveryoneAndExternalBytes) {
+    MemoryBudget budget(limits(10000, 0));
+    auto a = budget.openAccount("a");
+    auto b = budget.openAccount("b");
+
+    std::vector<MemoryBudget::Charge> held;
+    held.push_back(a->charge(4000));
+    held.push_back(b->charge(4000));
+    EXPECT_FALSE(a->charge(3000));
+    EXPECT_TRUE(a->charge(2000));
+
+    budget.setExternalBytes(3000); // decoded images the owner holds
+    EXPECT_EQ(budget.heldBytes(), 11000);
+    EXPECT_FALSE(b->charge(100));
+    budget.setExternalBytes(0); // evicted
+    EXPECT_TRUE(b->charge(100));
+
+    auto idle = budget.openAccount("idle");
+    EXPECT_TRUE(idle->charge(5000)); // over the total, but its first frame
+    EXPECT_EQ(budget.usage().refused, 2u);
+}
+
+TEST(MemoryBudgetTest, Pressure) {
+    MemoryBudgetConfig config = limits(10000, 0);
+    config.pressurePercent = 80;
+    MemoryBudget budget(config);
+    auto account = budget.openAccount("a");
+
+    MemoryBudget::Charge charge = account->charge(7000);
+    EXPECT_FALSE(budget.underPressure());
+    budget.setExternalBytes(1000);
+    EXPECT_TRUE(budget.underPressure());
+    charge.reset();
+    EXPECT_FALSE(budget.underPressure());
+
+    budget.setConfig(limits(0, 0));
+    budget.setExternalBytes(1LL << 40);
+    EXPECT_FALSE(budget.underPressure()); // no total: never under pressure
+}
+
+TEST(MemoryBudgetTest, UsageReport) {
+    MemoryBudget budget(limits(0, 1000));
+    auto small = budget.openAccount("small");
+    auto large = budget.openAccount("large");
+    auto quiet = budget.openAccount("quiet");
+
+    MemoryBudget::Charge s = small->charge(100);
+    MemoryBudget::Charge l = large->charge(900);
+    EXPECT_FALSE(large->charge(200));
+    budget.setExternalBytes(4096);
+
+    const MemoryUsage usage = budget.usage();
+    EXPECT_EQ(usage.receivedBytes, 1000);
+    EXPECT_EQ(usage.externalBytes, 4096);
+    EXPECT_EQ(usage.refused, 1u);
+    ASSERT_EQ(usage.accounts.size(), 2u); // the quiet one holds nothing
+    EXPECT_EQ(usage.accounts[0].name, "large");
+    EXPECT_EQ(usage.accounts[0].refused, 1u);
+    EXPECT_EQ(usage.accounts[1].name, "small");
+
+    // A closed connection drops out once its last frame is gone
+    large.reset();
+    EXPECT_EQ(budget.usage().accounts.size(), 2u);
+    l.reset();
+    EXPECT_EQ(budget.usage().accounts.size(), 1u);
+}
@@ -0,0 +1,59 @@
+/**
+ * @file test_mosaic_layout.cpp
+ * @brief Unit tests for the GPU mosaic grid layout
+ *
+ * Tests validate:
+ * - Column choice maximizes tile size for the area's shape
+ * - Cells tile the area with spacing, row-major
+ * - Frames are letterboxed inside their cell with the aspect ratio kept
+ */
+
+#include <gtest/gtest.h>
+#include "mosaiclayout.h"
+
+TEST(MosaicLayoutTest, SingleTileUsesOneColumn) {
+    EXPECT_EQ(mosaicColumns(0, 1920, 1080), 1);
+    EXPECT_EQ(mosaicColumns(1, 1920, 1080), 1);
+}
+
+TEST(MosaicLayoutTest, ColumnsFollowAreaShape) {
+    EXPECT_EQ(mosaicColumns(4, 1920, 1080), 2);
+    EXPECT_EQ(mosaicColumns(16, 1920, 1080), 4);
+    EXPECT_EQ(mosaicColumns(4, 4000, 500), 4);  // wide strip: single row
+    EXPECT_EQ(mosaicColumns(4, 400, 2000), 1);  // tall strip: single column
+}
+
+TEST(MosaicLayoutTest, CellsTileAreaWithSpacing) {
+    MosaicRect first = mosaicCell(0, 4, 2, 1000, 500, 10);
+    MosaicRect last = mosaicCell(3, 4, 2, 1000, 500, 10);
+    EXPECT_DOUBLE_EQ(first.x, 0.0);
+    EXPECT_DOUBLE_EQ(first.width, 495.0);
+    EXPECT_DOUBLE_EQ(first.height, 245.0);
+    EXPECT_DOUBLE_EQ(last.x, 505.0);
+    EXPECT_DOUBLE_EQ(last.y, 255.0);
+    EXPECT_DOUBLE_EQ(last.x + last.width, 1000.0);
+    EXPECT_DOUBLE_EQ(last.y + last.height, 500.0);
+}
+
+TEST(MosaicLayoutTest, PartialLastRowKeepsCellSize) {
+    MosaicRect a = mosaicCell(0, 3, 2, 800, 600);
+    MosaicRect c = mosaicCell(2, 3, 2, 800, 600);
+    EXPECT_DOUBLE_EQ(a.width, c.width);
+    EXPECT_DOUBLE_EQ(c.x, 0.0);
+    EXPECT_DOUBLE_EQ(c.y, 300.0);
+}
+
+TEST(MosaicLayoutTest, FitLetterboxesFrame) {
+    MosaicRect cell{100, 0, 400, 400};
+    MosaicRect r = fitInCell(cell, 1920, 1080);
+    EXPECT_DOUBLE_EQ(r.width, 400.0);
+    EXPECT_DOUBLE_EQ(r.height, 225.0);
+    EXPECT_DOUBLE_EQ(r.x, 100.0);
+    EXPECT_DOUBLE_EQ(r.y, 87.5);
+}
+
+TEST(MosaicLayoutTest, FitRejectsEmptyImage) {
+    MosaicRect r = fitInCell(MosaicRect{0, 0, 100, 100}, 0, 10);
+    EXPECT_DOUBLE_EQ(r.width, 0.0);
+    EXPECT_DOUBLE_EQ(r.height, 0.0);
+}
@@ -0,0 +1,94 @@
+/**
+ * @file test_mpsc_queue.cpp
+ * @brief Unit tests for the multi-producer, single-consumer ingest queue
+ *
+ * Tests validate:
+ * - FIFO order and the empty queue
+ * - Draining in bounded batches
+ * - Items left in the queue are released with it
+ * - Concurrent producers: nothing lost, each producer's order kept
+ */
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "mpscqueue.h"
+
+TEST(MpscQueueTest, TakesInPushOrder) {
+    MpscQueue<int> queue;
+    int value = 0;
+    EXPECT_FALSE(queue.take(value));
+
+    for (int i = 1; i <= 3; ++i)
+        queue.push(i);
+    for (int i = 1; i <= 3; ++i) {
+        ASSERT_TRUE(queue.take(value));
+        EXPECT_EQ(value, i);
+    }
+    EXPECT_FALSE(queue.take(value));
+
+    // Usable again once emptied (the stub node went round)
+    queue.push(4);
+    ASSERT_TRUE(queue.take(value));
+    EXPECT_EQ(value, 4);
+    EXPECT_FALSE(queue.take(value));
+}
+
+TEST(MpscQueueTest, DrainsInBatches) {
+    MpscQueue<int> queue;
+    for (int i = 0; i < 10; ++i)
+        queue.push(i);
+
+    std::vector<int> seen;
+    EXPECT_EQ(queue.drain([&seen](int value) { seen.push_back(value); }, 4), 4u);
+    EXPECT_EQ(seen, (std::vector<int>{0, 1, 2, 3}));
+    EXPECT_EQ(queue.drain([&seen](int value) { seen.push_back(value); }), 6u);
+    EXPECT_EQ(seen.size(), 10u);
+    EXPECT_EQ(seen.back(), 9);
+    EXPECT_EQ(queue.drain([&seen](int value) { seen.push_back(value); }), 0u);
+}
+
+TEST(MpscQueueTest, ReleasesPendingItems) {
+    auto item = std::make_shared<int>(1);
+    {
+        MpscQueue<std::shared_ptr<int>> queue;
+        queue.push(item);
+        queue.push(item);
+        EXPECT_EQ(item.use_count(), 3);
+    }
+    EXPECT_EQ(item.use_count(), 1);
+}
+
+TEST(MpscQueueTest, ConcurrentProducersLoseNothing) {
+    const int kProducers = 4;
+    const int kItems = 20000;
+    MpscQueue<std::pair<int, int>> queue; // producer, index
+    std::atomic<int> done{0};
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; ++p) {
+        producers.emplace_back([&queue, &done, p]() {
+            for (int i = 0; i < kItems; ++i)
+                queue.push(std::make_pair(p, i));
+            ++done;
+        });
+    }
+
+    std::vector<int> next(kProducers, 0);
+    int received = 0;
+    bool ordered = true;
+    const auto sink = [&](std::pair<int, int> item) {
+        ordered = ordered && item.second == next[item.first];
+        next[item.first] = item.second + 1;
+        ++received;
+    };
+    while (done.load() < kProducers)
+        queue.drain(sink);
+    for (std::thread& producer : producers)
+        producer.join();
+    queue.drain(sink);
+
+    EXPECT_EQ(received, kProducers * kItems);
+    EXPECT_TRUE(ordered);
+}
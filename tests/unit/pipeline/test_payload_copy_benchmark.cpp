@@ -0,0 +1,109 @@
+/**
+ * @file test_payload_copy_benchmark.cpp
+ * @brief Bytes copied per frame on the server receive path, before and after EncodedFrame views
+ *
+ * Compares two ways of extracting the JPEG payload from a prefixed WebSocket message:
+ * - Legacy: message.mid(1), which allocates and copies the whole payload
+ * - Current: EncodedFrame::fromMessage(message, 1), which shares the message storage
+ *
+ * A payload counts as copied when its data pointer does not point into the original message.
+ * Results are printed per frame size; the test asserts the view path copies nothing.
+ */
+
+#include <gtest/gtest.h>
+#include <QByteArray>
+#include <chrono>
+#include <cstdio>
+#include "encodedframe.h"
+
+namespace {
+
+constexpr int kIterations = 2000;
+
+QByteArray makeMessage(int payloadSize)
+{
+    QByteArray message(payloadSize + 1, char(0x5A));
+    message[0] = char(0x00); // image prefix
+    return message;
+}
+
+bool pointsInto(const QByteArray& message, const char* data)
+{
+    return data >= message.constData() && data < message.constData() + message.size();
+}
+
+struct CopyStats {
+    long long bytesCopiedPerFrame = 0;
+    double nsPerFrame = 0.0;
+};
+
+template <typename Extract>
+CopyStats measure(const QByteArray& message, Extract extract)
+{
+    CopyStats stats;
+    long long copied = 0;
+    volatile char sink = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        const char* data = nullptr;
+        int size = 0;
+        extract(message, data, size);
+        if (!pointsInto(message, data))
+            copied += size;
+        sink = data[size - 1];
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    (void)sink;
+
+    stats.bytesCopiedPerFrame = copied / kIterations;
+    stats.nsPerFrame = std::chrono::duration<double, std::nano>(elapsed).count() / kIterations;
+    return stats;
+}
+
+} // namespace
+
+TEST(PayloadCopyBenchmark, ViewAvoidsPayloadCopies) {
+    const int sizes[] = {16 * 1024, 256 * 1024, 2 * 1024 * 1024};
+
+    for (int payloadSize : sizes) {
+        const QByteArray message = makeMessage(payloadSize);
+
+        // Keep the extracted payload alive across the measurement, like a queued signal does
+        QByteArray legacyHold;
+        const CopyStats before = measure(message, [&](const QByteArray& msg, const char*& data, int& size) {
+            legacyHold = msg.mid(1);
+            data = legacyHold.constData();
+            size = legacyHold.size();
+        });
+
+        EncodedFrame viewHold;
+        const CopyStats after = measure(message, [&](const QByteArray& msg, const char*& data, int& size) {
+            viewHold = EncodedFrame::fromMessage(msg, 1);
+            data = viewHold.data();
+            size = viewHold.size();
+        });
+
+        std::printf("payload %8d B | before: %8lld B copied/frame %10.0f ns | after: %8lld B copied/frame %10.0f ns\n",
+                    payloadSize, before.bytesCopiedPerFrame, before.nsPerFrame,
+                    after.bytesCopiedPerFrame, after.nsPerFrame);
+
+        EXPECT_EQ(before.bytesCopiedPerFrame, payloadSize);
+        EXPECT_EQ(after.bytesCopiedPerFrame, 0);
+        EXPECT_EQ(viewHold.size(), payloadSize);
+    }
+}
+
+TEST(PayloadCopyBenchmark, UnprefixedMessageIsViewedWhole) {
+    const QByteArray message(1024, char(0x11));
+    const EncodedFrame frame = EncodedFrame::fromMessage(message, 0);
+    EXPECT_EQ(frame.data(), message.constData());
+    EXPECT_EQ(frame.size(), message.size());
+}
+
+TEST(PayloadCopyBenchmark, OffsetPastEndYieldsEmptyFrame) {
+    const QByteArray message(1, char(0x00));
+    const EncodedFrame frame = EncodedFrame::fromMessage(message, 1);
+    EXPECT_TRUE(frame.isEmpty());
+    EXPECT_TRUE(EncodedFrame::fromMessage(message, 5).isEmpty());
+}
@@ -0,0 +1,71 @@
+/**
+ * @file test_pixel_swizzle.cpp
+ * @brief Unit tests for the BGR to RGB32 pixel conversion
+ *
+ * Tests validate:
+ * - Pixels become 0xffRRGGBB, whatever the width (vector steps and tail)
+ * - Row strides on both sides are honoured; bytes past a row are left alone
+ * - Only the image's own bytes are read (exact-size source buffer)
+ */
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <vector>
+#include "pixelswizzle.h"
+
+namespace {
+
+std::uint8_t patternByte(int row, int index)
+{
+    return static_cast<std::uint8_t>(row * 31 + index * 7 + 3);
+}
+
+} // namespace
+
+TEST(PixelSwizzleTest, ConvertsEveryWidth) {
+    for (int width = 1; width <= 67; ++width) {
+        const int height = 3;
+        // Exact size, no padding: reading past the last pixel would be caught by sanitizers
+        std::vector<std::uint8_t> bgr(static_cast<std::size_t>(width) * 3 * height);
+        for (int row = 0; row < height; ++row) {
+            for (int i = 0; i < width * 3; ++i)
+                bgr[static_cast<std::size_t>(row) * width * 3 + i] = patternByte(row, i);
+        }
+        std::vector<std::uint32_t> rgb32(static_cast<std::size_t>(width) * height, 0);
+        bgrToRgb32(bgr.data(), width * 3, reinterpret_cast<std::uint8_t*>(rgb32.data()), width * 4, width, height);
+
+        for (int row = 0; row < height; ++row) {
+            for (int x = 0; x < width; ++x) {
+                const std::uint32_t expected = 0xFF000000u | (std::uint32_t(patternByte(row, x * 3 + 2)) << 16)
+                    | (std::uint32_t(patternByte(row, x * 3 + 1)) << 8) | patternByte(row, x * 3);
+                ASSERT_EQ(rgb32[static_cast<std::size_t>(row) * width + x], expected)
+                    << "width " << width << " row " << row << " x " << x;
+            }
+        }
+    }
+}
+
+TEST(PixelSwizzleTest, HonoursStrides) {
+    const int width = 21;
+    const int height = 4;
+    const int srcStride = width * 3 + 5;   // padded rows, as a cropped cv::Mat has
+    const int dstStride = width * 4 + 12;
+    std::vector<std::uint8_t> bgr(static_cast<std::size_t>(srcStride) * height, 0xEE);
+    for (int row = 0; row < height; ++row) {
+        for (int x = 0; x < width; ++x) {
+            bgr[row * srcStride + x * 3] = static_cast<std::uint8_t>(x);        // blue
+            bgr[row * srcStride + x * 3 + 1] = static_cast<std::uint8_t>(row);  // green
+            bgr[row * srcStride + x * 3 + 2] = 0x80;                            // red
+        }
+    }
+    std::vector<std::uint8_t> out(static_cast<std::size_t>(dstStride) * height, 0x11);
+    bgrToRgb32(bgr.data(), srcStride, out.data(), dstStride, width, height);
+
+    for (int row = 0; row < height; ++row) {
+        const std::uint32_t* pixels = reinterpret_cast<const std::uint32_t*>(out.data() + row * dstStride);
+        for (int x = 0; x < width; ++x)
+            EXPECT_EQ(pixels[x], 0xFF800000u | (std::uint32_t(row) << 8) | std::uint32_t(x));
+        for (int pad = width * 4; pad < dstStride; ++pad)
+            EXPECT_EQ(out[row * dstStride + pad], 0x11) << "row padding written";
+    }
+}
@@ -0,0 +1,159 @@
+/**
+ * @file test_preroll_ring.cpp
+ * @brief Unit tests for the compressed pre-roll ring behind event clips
+ *
+ * Tests validate:
+ * - Frames stay byte for byte as records until the slab or the window is full,
+ *   then the oldest go first, across many wraps of the slab
+ * - Frames larger than the slab are refused, the ring keeps what it had
+ * - Clips start at the first keyframe at or after the requested time
+ * - Exported clips are valid recorder segments: parsed, indexed, seekable
+ */
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <vector>
+#include "prerollring.h"
+
+namespace {
+
+RecordHeader frameAt(std::int64_t timestampUs, std::uint32_t sequence, std::uint32_t size, bool keyframe = true)
+{
+    RecordHeader header;
+    header.payloadSize = size;
+    header.timestampUs = timestampUs;
+    header.sequence = sequence;
+    header.payload = keyframe ? FramePayload::Jpeg : FramePayload::Video;
+    header.keyframe = keyframe;
+    header.width = 640;
+    header.height = 480;
+    return header;
+}
+
+std::vector<std::uint8_t> payloadFor(std::uint32_t sequence, std::uint32_t size)
+{
+    std::vector<std::uint8_t> payload(size);
+    for (std::uint32_t i = 0; i < size; ++i)
+        payload[i] = static_cast<std::uint8_t>(sequence * 13 + i);
+    return payload;
+}
+
+// Sequence numbers of the records a clip from `fromUs` holds, payloads checked
+std::vector<std::uint32_t> clipSequences(const PrerollRing& ring, std::int64_t fromUs)
+{
+    std::vector<std::uint32_t> sequences;
+    ring.forEachFrom(fromUs, [&](const std::uint8_t* record, std::size_t span) {
+        RecordHeader header;
+        std::size_t payload = 0;
+        // A record parses on its own when placed after a segment header's worth of bytes
+        std::vector<std::uint8_t> segment(kSegmentHeaderSize);
+        segment.insert(segment.end(), record, record + span);
+        EXPECT_TRUE(parseRecord(segment.data(), segment.size(), kSegmentHeaderSize, header, payload));
+        EXPECT_EQ(std::vector<std::uint8_t>(segment.begin() + payload, segment.begin() + payload + header.payloadSize),
+                  payloadFor(header.sequence, header.payloadSize));
+        sequences.push_back(header.sequence);
+    });
+    return sequences;
+}
+
+} // namespace
+
+TEST(PrerollRingTest, KeepsNewestFramesWithinSlab) {
+    // Room for 10 records of 1000 bytes payload
+    PrerollRing ring(10 * recordSpan(1000), 0);
+    for (std::uint32_t i = 0; i < 95; ++i) {
+        const std::uint32_t size = 900 + (i * 37) % 101;   // varying, so wraps land anywhere
+        const std::vector<std::uint8_t> payload = payloadFor(i, size);
+        ASSERT_TRUE(ring.push(frameAt(i * 40000, i, size), payload.data()));
+        ASSERT_LE(ring.bytesUsed(), ring.capacity());
+    }
+    const std::vector<std::uint32_t> kept = clipSequences(ring, 0);
+    ASSERT_GE(kept.size(), 9u);
+    for (std::size_t i = 0; i < kept.size(); ++i)
+        EXPECT_EQ(kept[i], 95 - kept.size() + i);
+    EXPECT_EQ(ring.frameCount(), kept.size());
+    EXPECT_EQ(ring.evicted(), 95 - kept.size());
+    EXPECT_EQ(ring.newestTimestampUs(), 94 * 40000);
+}
+
+TEST(PrerollRingTest, WindowBoundsAge) {
+    PrerollRing ring(1 << 20, 2000000);   // 2 s, room for far more
+    const std::vector<std::uint8_t> payload = payloadFor(0, 100);
+    for (std::uint32_t i = 0; i < 100; ++i)
+        ASSERT_TRUE(ring.push(frameAt(i * 100000, 0, 100), payload.data()));   // 10 fps for 10 s
+    EXPECT_EQ(ring.oldestTimestampUs(), 7900000);
+    EXPECT_EQ(ring.newestTimestampUs(), 9900000);
+    EXPECT_EQ(ring.frameCount(), 21u);
+}
+
+TEST(PrerollRingTest, RefusesFrameLargerThanSlab) {
+    PrerollRing ring(4096, 0);
+    const std::vector<std::uint8_t> small = payloadFor(1, 1000);
+    ASSERT_TRUE(ring.push(frameAt(0, 1, 1000), small.data()));
+    const std::vector<std::uint8_t> huge = payloadFor(2, 5000);
+    EXPECT_FALSE(ring.push(frameAt(1, 2, 5000), huge.data()));
+    EXPECT_EQ(ring.rejected(), 1u);
+    EXPECT_EQ(ring.frameCount(), 1u);
+
+    PrerollRing off;
+    EXPECT_FALSE(off.push(frameAt(0, 1, 1000), small.data()));
+}
+
+TEST(PrerollRingTest, ClipStartsAtKeyframe) {
+    PrerollRing ring(1 << 20, 0);
+    // Video: a keyframe every 10 frames, 25 fps
+    for (std::uint32_t i = 0; i < 40; ++i) {
+        const std::vector<std::uint8_t> payload = payloadFor(i, 200);
+        ASSERT_TRUE(ring.push(frameAt(i * 40000, i, 200, i % 10 == 0), payload.data()));
+    }
+    const std::vector<std::uint32_t> clip = clipSequences(ring, 13 * 40000);
+    ASSERT_FALSE(clip.empty());
+    EXPECT_EQ(clip.front(), 20u);
+    EXPECT_EQ(clip.back(), 39u);
+    EXPECT_EQ(clipSequences(ring, 0).front(), 0u);
+    EXPECT_TRUE(clipSequences(ring, 40 * 40000).empty());
+}
+
+TEST(PrerollRingTest, ExportsRecorderSegment) {
+    PrerollRing ring(64 * 1024, 0);
+    for (std::uint32_t i = 0; i < 200; ++i) {
+        const std::vector<std::uint8_t> payload = payloadFor(i, 500);
+        ASSERT_TRUE(ring.push(frameAt(1000000 + i * 100000, i, 500), payload.data()));
+    }
+    std::vector<std::uint8_t> segment;
+    std::vector<std::uint8_t> index;
+    const std::size_t frames = ring.exportSegment(0, 1000000, segment, index);
+    ASSERT_EQ(frames, ring.frameCount());
+
+    SegmentHeader header;
+    ASSERT_TRUE(parseSegmentHeader(segment.data(), segment.size(), header));
+    EXPECT_EQ(header.used, segment.size());
+    EXPECT_EQ(header.records, frames);
+    EXPECT_EQ(header.firstTimestampUs, ring.oldestTimestampUs());
+    EXPECT_EQ(header.lastTimestampUs, ring.newestTimestampUs());
+
+    // Every record parses in order; the index seeks to the right one
+    std::size_t offset = kSegmentHeaderSize;
+    RecordHeader record;
+    std::size_t payload = 0;
+    std::size_t count = 0;
+    while (parseRecord(segment.data(), segment.size(), offset, record, payload)) {
+        offset += recordSpan(record.payloadSize);
+        ++count;
+    }
+    EXPECT_EQ(count, frames);
+    EXPECT_EQ(offset, segment.size());
+    ASSERT_EQ(index.size() % kIndexEntrySize, 0u);
+    EXPECT_GE(index.size() / kIndexEntrySize, 10u);
+
+    const std::int64_t target = ring.newestTimestampUs() - 550000;
+    const std::uint64_t start = seekIndex(index.data(), index.size() / kIndexEntrySize, target);
+    const std::size_t found = findRecord(segment.data(), segment.size(), static_cast<std::size_t>(start), target);
+    ASSERT_TRUE(parseRecord(segment.data(), segment.size(), found, record, payload));
+    EXPECT_EQ(record.timestampUs, ring.newestTimestampUs() - 500000);
+
+    std::vector<std::uint8_t> empty;
+    EXPECT_EQ(ring.exportSegment(ring.newestTimestampUs() + 1, 1000000, empty, index), 0u);
+    EXPECT_TRUE(empty.empty());
+    EXPECT_TRUE(index.empty());
+}
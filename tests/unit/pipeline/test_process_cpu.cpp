@@ -0,0 +1,33 @@
+/**
+ * @file test_process_cpu.cpp
+ * @brief Unit tests for the process CPU meter used by the capacity benchmark
+ *
+ * Tests validate:
+ * - A busy thread shows up as roughly one core
+ * - An idle interval reports (almost) nothing
+ */
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
+#include "processcpu.h"
+
+TEST(ProcessCpuMeterTest, BusyLoopIsAboutOneCore) {
+    ProcessCpuMeter meter;
+    const auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(200);
+    volatile std::uint64_t spins = 0;
+    while (std::chrono::steady_clock::now() < end)
+        spins = spins + 1;
+    const double percent = meter.sample();
+    ASSERT_GE(percent, 0.0) << "no CPU accounting on this platform";
+    EXPECT_GT(percent, 25.0);
+    EXPECT_LT(percent, 150.0);
+}
+
+TEST(ProcessCpuMeterTest, SleepingIsIdle) {
+    ProcessCpuMeter meter;
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    const double percent = meter.sample();
+    ASSERT_GE(percent, 0.0);
+    EXPECT_LT(percent, 25.0);
+}
@@ -0,0 +1,197 @@
+/**
+ * @file test_rate_controller.cpp
+ * @brief Unit tests for the server-side MJPEG rate controller
+ *
+ * Tests validate:
+ * - Throughput and queueing delay estimation (clock offset cancels out)
+ * - Quality is lowered before FPS under congestion, within bounds
+ * - Recovery restores FPS to the configured ceiling before raising quality
+ * - Evaluations are paced by the configured interval
+ * - PING/PONG round trips above their base count as queueing delay
+ * - A quality ceiling (ingress budget) bounds the quality
+ */
+
+#include <gtest/gtest.h>
+#include "ratecontroller.h"
+
+namespace {
+
+// Client clock runs 1 hour ahead of the server: only delay changes matter
+const std::int64_t kClockOffsetMs = 3600 * 1000;
+const std::int64_t kStartMs = 1000000;
+
+// Simulate one second of traffic with the given one-way delay and client queue
+RateDecision runInterval(RateController& rc, std::int64_t& now, std::int64_t owdMs, int queued,
+                         std::size_t bytesPerFrame = 20000, int frames = 10)
+{
+    for (int i = 0; i < frames; ++i)
+        rc.onFrame(now + i * 100, bytesPerFrame);
+    rc.onReport(now + 500, now + 500 - owdMs + kClockOffsetMs, queued);
+    now += 1000;
+    return rc.evaluate(now);
+}
+
+RateController startedController(std::int64_t& now, int maxFps = 30)
+{
+    RateController rc;
+    rc.setMaxFps(maxFps);
+    now = kStartMs;
+    rc.evaluate(now); // starts the first interval
+    return rc;
+}
+
+} // namespace
+
+TEST(RateControllerTest, MeasuresThroughputAndQueueDelay) {
+    std::int64_t now = 0;
+    RateController rc = startedController(now);
+    EXPECT_EQ(rc.queueDelayMs(), -1);
+
+    runInterval(rc, now, 20, 0);
+    EXPECT_DOUBLE_EQ(rc.throughputBps(), 200000.0);
+    EXPECT_EQ(rc.measuredFps(), 10);
+    EXPECT_EQ(rc.queueDelayMs(), 0);
+
+    runInterval(rc, now, 60, 0);
+    EXPECT_EQ(rc.queueDelayMs(), 40); // 60 ms one-way against a 20 ms base
+}
+
+TEST(RateControllerTest, StableLinkKeepsSettings) {
+    std::int64_t now = 0;
+    RateController rc = startedController(now);
+    for (int i = 0; i < 2; ++i) {
+        RateDecision d = runInterval(rc, now, 15, 0);
+        EXPECT_FALSE(d.changed());
+    }
+    EXPECT_EQ(rc.quality(), 75);
+    EXPECT_EQ(rc.fps(), 30);
+}
+
+TEST(RateControllerTest, CongestionLowersQualityFirst) {
+    std::int64_t now = 0;
+    RateController rc = startedController(now);
+    runInterval(rc, now, 10, 0);
+
+    RateDecision d = runInterval(rc, now, 10 + 300, 0);
+    EXPECT_TRUE(d.qualityChanged);
+    EXPECT_FALSE(d.fpsChanged);
+    EXPECT_EQ(d.quality, 65);
+}
+
+TEST(RateControllerTest, ClientQueueCountsAsCongestion) {
+    std::int64_t now = 0;
+    RateController rc = startedController(now);
+    RateDecision d = runInterval(rc, now, 10, 2);
+    EXPECT_TRUE(d.qualityChanged);
+    EXPECT_EQ(rc.quality(), 65);
+}
+
+TEST(RateControllerTest, MildDelayTrimsQuality) {
+    std::int64_t now = 0;
+    RateController rc = startedController(now);
+    runInterval(rc, now, 10, 0);
+    RateDecision d = runInterval(rc, now, 10 + 100, 0);
+    EXPECT_EQ(d.quality, 70);
+}
+
+TEST(RateControllerTest, FpsDropsOnlyAtQualityFloor) {
+    std::int64_t now = 0;
+    RateController rc = startedController(now);
+    runInterval(rc, now, 10, 0);
+
+    int lastQuality = rc.quality();
+    while (rc.quality() > RateControllerConfig().minQuality) {
+        runInterval(rc, now, 500, 3);
+        EXPECT_EQ(rc.fps(), 30);
+        EXPECT_LT(rc.quality(), lastQuality);
+        lastQuality = rc.quality();
+    }
+
+    RateDecision d = runInterval(rc, now, 500, 3);
+    EXPECT_TRUE(d.fpsChanged);
+    EXPECT_EQ(d.fps, 22);
+    EXPECT_EQ(rc.quality(), RateControllerConfig().minQuality);
+
+    for (int i = 0; i < 20; ++i)
+        runInterval(rc, now, 500, 3);
+    EXPECT_EQ(rc.fps(), RateControllerConfig().minFps);
+}
+
+TEST(RateControllerTest, RecoveryRestoresFpsBeforeQuality) {
+    std::int64_t now = 0;
+    RateController rc = startedController(now);
+    runInterval(rc, now, 10, 0);
+    for (int i = 0; i < 12; ++i)
+        runInterval(rc, now, 500, 3);
+    ASSERT_LT(rc.fps(), 30);
+    const int floorQuality = rc.quality();
+
+    // Backlog drains: delay back to base, queue empty
+    for (int i = 0; i < 200 && rc.fps() < 30; ++i) {
+        runInterval(rc, now, 10, 0);
+        EXPECT_EQ(rc.quality(), floorQuality);
+    }
+    EXPECT_EQ(rc.fps(), 30);
+
+    for (int i = 0; i < 200; ++i)
+        runInterval(rc, now, 10, 0);
+    EXPECT_EQ(rc.quality(), RateControllerConfig().maxQuality);
+    EXPECT_EQ(rc.fps(), 30);
+}
+
+TEST(RateControllerTest, EvaluationPacedByInterval) {
+    std::int64_t now = 0;
+    RateController rc = startedController(now);
+    rc.onReport(now + 10, now + 10, 5);
+    RateDecision d = rc.evaluate(now + 500);
+    EXPECT_FALSE(d.changed());
+    EXPECT_EQ(rc.quality(), 75);
+}
+
+TEST(RateControllerTest, SetMaxFpsResetsCeiling) {
+    std::int64_t now = 0;
+    RateController rc = startedController(now, 30);
+    runInterval(rc, now, 10, 0);
+    for (int i = 0; i < 12; ++i)
+        runInterval(rc, now, 500, 3);
+    ASSERT_LT(rc.fps(), 30);
+
+    rc.setMaxFps(15);
+    EXPECT_EQ(rc.fps(), 15);
+    EXPECT_EQ(rc.maxFps(), 15);
+}
+
+TEST(RateControllerTest, RoundTripInflationCountsAsDelay) {
+    std::int64_t now = 0;
+    RateController rc = startedController(now);
+    EXPECT_EQ(rc.rttMs(), -1);
+
+    rc.onRoundTrip(now + 200, 30);
+    runInterval(rc, now, 20, 0);
+    EXPECT_EQ(rc.rttMs(), 30);
+    EXPECT_EQ(rc.queueDelayMs(), 0);
+
+    // One-way reports look clean but the PONG waited behind queued frames
+    rc.onRoundTrip(now + 200, 30 + 300);
+    RateDecision d = runInterval(rc, now, 20, 0);
+    EXPECT_EQ(rc.queueDelayMs(), 300);
+    EXPECT_TRUE(d.qualityChanged);
+    EXPECT_EQ(d.quality, 65);
+}
+
+TEST(RateControllerTest, QualityCeilingBoundsRecovery) {
+    std::int64_t now = 0;
+    RateController rc = startedController(now);
+    rc.setQualityCeiling(50);
+    EXPECT_EQ(rc.quality(), 50);
+
+    // A clear path raises quality up to the ceiling only
+    for (int i = 0; i < 20; ++i)
+        runInterval(rc, now, 10, 0);
+    EXPECT_EQ(rc.quality(), 50);
+
+    rc.setQualityCeiling(0);
+    for (int i = 0; i < 6; ++i)
+        runInterval(rc, now, 10, 0);
+    EXPECT_GT(rc.quality(), 50);
+}
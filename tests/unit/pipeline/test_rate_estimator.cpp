@@ -0,0 +1,111 @@
+/**
+ * @file test_rate_estimator.cpp
+ * @brief Unit tests for the sliding-window frame rate and bitrate estimator
+ *
+ * Tests validate:
+ * - A steady stream measures its exact, fractional rate and bitrate
+ * - A rate change is followed within one window
+ * - A stopped stream decays to 0; a slow stream still measures
+ * - The ring bounds the arrivals kept; late timestamps don't go backwards
+ */
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include "rateestimator.h"
+
+namespace {
+
+// Adds frames every `intervalUs` from `startUs` (excluded) up to `endUs`; returns the last time
+std::int64_t feed(RateEstimator& estimator, std::int64_t startUs, std::int64_t endUs, std::int64_t intervalUs,
+                  std::int64_t bytes)
+{
+    std::int64_t t = startUs;
+    while (t + intervalUs <= endUs) {
+        t += intervalUs;
+        estimator.add(t, bytes);
+    }
+    return t;
+}
+
+} // namespace
+
+TEST(RateEstimatorTest, SteadyStreamIsExactAndFractional) {
+    RateEstimator estimator;
+    EXPECT_EQ(estimator.fps(0), 0.0);
+    estimator.add(0, 5000);
+    EXPECT_EQ(estimator.fps(0), 0.0) << "one arrival has no interval";
+
+    // 29.97 fps (NTSC), 5000 bytes a frame
+    const std::int64_t intervalUs = 33367;
+    const std::int64_t last = feed(estimator, 0, 2000000, intervalUs, 5000);
+    EXPECT_NEAR(estimator.fps(last), 1e6 / intervalUs, 1e-9);
+    EXPECT_NEAR(estimator.bytesPerSecond(last), 5000 * 1e6 / intervalUs, 1e-6);
+    // Between two frames nothing changes
+    EXPECT_NEAR(estimator.fps(last + intervalUs / 2), 1e6 / intervalUs, 1e-9);
+    EXPECT_LE(estimator.arrivals(last), estimator.capacity());
+    EXPECT_GE(estimator.arrivals(last), std::size_t(500000 / intervalUs));
+}
+
+TEST(RateEstimatorTest, FollowsRateChangeWithinOneWindow) {
+    RateEstimator estimator(500000);
+    std::int64_t t = feed(estimator, 0, 2000000, 100000, 1000); // 10 fps
+    EXPECT_NEAR(estimator.fps(t), 10.0, 1e-9);
+
+    // Up to 30 fps: halfway through a window the estimate is already between, after one it is there
+    const std::int64_t switchUs = t;
+    t = feed(estimator, switchUs, switchUs + 250000, 33333, 1000);
+    const double halfway = estimator.fps(t);
+    EXPECT_GT(halfway, 12.0);
+    EXPECT_LT(halfway, 30.0);
+    t = feed(estimator, t, switchUs + 600000, 33333, 1000);
+    EXPECT_NEAR(estimator.fps(t), 30.0, 0.01);
+    EXPECT_NEAR(estimator.bytesPerSecond(t), 30000.0, 10.0);
+
+    // And back down to 5 fps
+    const std::int64_t downUs = t;
+    t = feed(estimator, downUs, downUs + 1200000, 200000, 1000);
+    EXPECT_NEAR(estimator.fps(t), 5.0, 1e-9);
+}
+
+TEST(RateEstimatorTest, StoppedStreamDecaysAndSlowStreamMeasures) {
+    RateEstimator estimator(500000, 128, 10000000);
+    const std::int64_t last = feed(estimator, 0, 1000000, 40000, 100); // 25 fps
+
+    // Within one interval of silence: unchanged; then falling, never up
+    EXPECT_NEAR(estimator.fps(last + 30000), 25.0, 1e-9);
+    double previous = estimator.fps(last + 40000);
+    for (std::int64_t silence = 100000; silence <= 9000000; silence += 100000) {
+        const double fps = estimator.fps(last + silence);
+        EXPECT_LE(fps, previous) << "silence " << silence;
+        previous = fps;
+    }
+    EXPECT_LT(estimator.fps(last + 1000000), 3.0);
+    EXPECT_EQ(estimator.fps(last + 10000000), 0.0) << "nothing left after the longest span";
+    EXPECT_EQ(estimator.bytesPerSecond(last + 10000000), 0.0);
+
+    // One frame a second, longer than the window: still measured from the last arrivals
+    RateEstimator slow(500000);
+    const std::int64_t slowLast = feed(slow, 0, 6000000, 1000000, 20000);
+    EXPECT_EQ(slow.arrivals(slowLast), RateEstimator::minArrivals());
+    EXPECT_NEAR(slow.fps(slowLast), 1.0, 1e-9);
+    EXPECT_NEAR(slow.bytesPerSecond(slowLast), 20000.0, 1e-6);
+}
+
+TEST(RateEstimatorTest, RingBoundsArrivalsAndTimeNeverGoesBack) {
+    // 1000 fps into 16 slots: measured over the slots, still the right rate
+    RateEstimator estimator(500000, 16);
+    const std::int64_t last = feed(estimator, 0, 1000000, 1000, 10);
+    EXPECT_EQ(estimator.arrivals(last), std::size_t(16));
+    EXPECT_NEAR(estimator.fps(last), 1000.0, 1e-9);
+
+    // A timestamp before the last arrival counts as the same instant
+    RateEstimator ordered;
+    ordered.add(1000000, 100);
+    ordered.add(1100000, 100);
+    ordered.add(1050000, 100);
+    EXPECT_NEAR(ordered.fps(1100000), 20.0, 1e-9);
+
+    ordered.clear();
+    EXPECT_EQ(ordered.arrivals(1100000), std::size_t(0));
+    EXPECT_EQ(ordered.fps(1100000), 0.0);
+}
@@ -0,0 +1,104 @@
+/**
+ * @file test_raw_frame.cpp
+ * @brief Unit tests for the raw YUV frame header
+ *
+ * Tests validate:
+ * - prepareRawFrame() and parseRawFrameHeader() round-trip format, size and range
+ * - Plane views point at the right offsets for I420 and NV12
+ * - Odd sizes, unknown formats and size mismatches are rejected
+ */
+
+#include <gtest/gtest.h>
+#include <vector>
+#include "rawframe.h"
+
+namespace {
+
+RawFrameHeader header(RawFrameFormat format, int width, int height, bool limitedRange = false)
+{
+    RawFrameHeader h;
+    h.format = format;
+    h.width = width;
+    h.height = height;
+    h.limitedRange = limitedRange;
+    return h;
+}
+
+} // namespace
+
+TEST(RawFrameTest, RoundTripsHeader) {
+    std::vector<std::uint8_t> payload;
+    ASSERT_TRUE(prepareRawFrame(header(RawFrameFormat::NV12, 640, 480, true), payload));
+    EXPECT_EQ(payload.size(), kRawFrameHeaderSize + 640u * 480u * 3u / 2u);
+
+    RawFrameHeader parsed;
+    ASSERT_TRUE(parseRawFrameHeader(payload.data(), payload.size(), parsed));
+    EXPECT_EQ(parsed.format, RawFrameFormat::NV12);
+    EXPECT_EQ(parsed.width, 640);
+    EXPECT_EQ(parsed.height, 480);
+    EXPECT_TRUE(parsed.limitedRange);
+}
+
+TEST(RawFrameTest, PrepareReusesCapacity) {
+    std::vector<std::uint8_t> payload;
+    ASSERT_TRUE(prepareRawFrame(header(RawFrameFormat::I420, 64, 48), payload));
+    const std::uint8_t* storage = payload.data();
+    ASSERT_TRUE(prepareRawFrame(header(RawFrameFormat::I420, 32, 24), payload));
+    EXPECT_EQ(payload.data(), storage);
+}
+
+TEST(RawFrameTest, I420PlaneOffsets) {
+    std::vector<std::uint8_t> payload;
+    ASSERT_TRUE(prepareRawFrame(header(RawFrameFormat::I420, 8, 4), payload));
+    RawFrameHeader parsed;
+    ASSERT_TRUE(parseRawFrameHeader(payload.data(), payload.size(), parsed));
+
+    const YuvFrameView view = rawFrameView(parsed, payload.data());
+    EXPECT_EQ(view.layout, YuvLayout::I420);
+    EXPECT_EQ(view.y, payload.data() + kRawFrameHeaderSize);
+    EXPECT_EQ(view.u, view.y + 32);
+    EXPECT_EQ(view.v, view.u + 8);
+    EXPECT_EQ(view.yStride, 8);
+    EXPECT_EQ(view.uvStride, 4);
+    EXPECT_FALSE(view.limitedRange);
+}
+
+TEST(RawFrameTest, Nv12PlaneOffsets) {
+    std::vector<std::uint8_t> payload;
+    ASSERT_TRUE(prepareRawFrame(header(RawFrameFormat::NV12, 8, 4), payload));
+    RawFrameHeader parsed;
+    ASSERT_TRUE(parseRawFrameHeader(payload.data(), payload.size(), parsed));
+
+    const YuvFrameView view = rawFrameView(parsed, payload.data());
+    EXPECT_EQ(view.layout, YuvLayout::NV12);
+    EXPECT_EQ(view.u, view.y + 32);
+    EXPECT_EQ(view.v, nullptr);
+    EXPECT_EQ(view.uvStride, 8);
+}
+
+TEST(RawFrameTest, RejectsUnsendableSizes) {
+    std::vector<std::uint8_t> payload;
+    EXPECT_FALSE(prepareRawFrame(header(RawFrameFormat::I420, 641, 480), payload));
+    EXPECT_FALSE(prepareRawFrame(header(RawFrameFormat::I420, 640, 0), payload));
+    EXPECT_FALSE(prepareRawFrame(header(RawFrameFormat::I420, 70000, 2), payload));
+}
+
+TEST(RawFrameTest, RejectsMalformedPayloads) {
+    std::vector<std::uint8_t> payload;
+    ASSERT_TRUE(prepareRawFrame(header(RawFrameFormat::I420, 16, 8), payload));
+    RawFrameHeader parsed;
+
+    std::vector<std::uint8_t> truncated(payload.begin(), payload.end() - 1);
+    EXPECT_FALSE(parseRawFrameHeader(truncated.data(), truncated.size(), parsed));
+
+    std::vector<std::uint8_t> unknownFormat = payload;
+    unknownFormat[0] = 7;
+    EXPECT_FALSE(parseRawFrameHeader(unknownFormat.data(), unknownFormat.size(), parsed));
+
+    std::vector<std::uint8_t> oddWidth = payload;
+    oddWidth[2] = 15;
+    EXPECT_FALSE(parseRawFrameHeader(oddWidth.data(), oddWidth.size(), parsed));
+
+    EXPECT_FALSE(parseRawFrameHeader(payload.data(), kRawFrameHeaderSize - 1, parsed));
+    EXPECT_FALSE(parseRawFrameHeader(nullptr, 0, parsed));
+}
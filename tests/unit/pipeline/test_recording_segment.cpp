@@ -0,0 +1,156 @@
+/**
+ * @file test_recording_segment.cpp
+ * @brief Unit tests for the recorder's segment and index format
+ *
+ * Tests validate:
+ * - Segment header round trip and rejection of foreign or truncated files
+ * - Records padded to 8 bytes, payload kept byte for byte
+ * - Torn records (recorder stopped mid-write) end the segment
+ * - Seeking through the index, then walking the records
+ */
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "recordingsegment.h"
+
+namespace {
+
+// Segment buffer with `count` records, one every 100 ms, and an index entry every 3rd
+struct Recording {
+    std::vector<std::uint8_t> segment;
+    std::vector<std::uint8_t> index;
+    std::vector<std::size_t> offsets;
+};
+
+Recording makeRecording(int count, std::int64_t startUs)
+{
+    Recording recording;
+    recording.segment.resize(kSegmentHeaderSize + static_cast<std::size_t>(count) * recordSpan(64));
+    SegmentHeader header;
+    for (int i = 0; i < count; ++i) {
+        RecordHeader record;
+        record.timestampUs = startUs + i * 100000;
+        record.sequence = static_cast<std::uint32_t>(i);
+        const std::string payload(static_cast<std::size_t>(10 + i), static_cast<char>('a' + i));
+        record.payloadSize = static_cast<std::uint32_t>(payload.size());
+        recording.offsets.push_back(header.used);
+        if (i % 3 == 0) {
+            IndexEntry entry;
+            entry.timestampUs = record.timestampUs;
+            entry.offset = header.used;
+            std::uint8_t bytes[kIndexEntrySize];
+            writeIndexEntry(entry, bytes);
+            recording.index.insert(recording.index.end(), bytes, bytes + kIndexEntrySize);
+        }
+        header.used += writeRecord(record, payload.data(), recording.segment.data() + header.used);
+        ++header.records;
+    }
+    writeSegmentHeader(header, recording.segment.data());
+    recording.segment.resize(header.used);
+    return recording;
+}
+
+} // namespace
+
+TEST(RecordingSegmentTest, SegmentHeaderRoundTrip) {
+    std::vector<std::uint8_t> bytes(kSegmentHeaderSize + 100);
+    SegmentHeader header;
+    header.used = kSegmentHeaderSize + 100;
+    header.firstTimestampUs = 1700000000000000;
+    header.lastTimestampUs = 1700000000500000;
+    header.records = 7;
+    writeSegmentHeader(header, bytes.data());
+
+    SegmentHeader parsed;
+    ASSERT_TRUE(parseSegmentHeader(bytes.data(), bytes.size(), parsed));
+    EXPECT_EQ(parsed.used, header.used);
+    EXPECT_EQ(parsed.firstTimestampUs, header.firstTimestampUs);
+    EXPECT_EQ(parsed.lastTimestampUs, header.lastTimestampUs);
+    EXPECT_EQ(parsed.records, 7u);
+
+    // Truncated copy: the header claims more than the file holds
+    EXPECT_FALSE(parseSegmentHeader(bytes.data(), bytes.size() - 1, parsed));
+    bytes[0] = 'X';
+    EXPECT_FALSE(parseSegmentHeader(bytes.data(), bytes.size(), parsed));
+}
+
+TEST(RecordingSegmentTest, RecordsArePaddedAndKeepThePayload) {
+    EXPECT_EQ(recordSpan(0), kRecordHeaderSize);
+    EXPECT_EQ(recordSpan(1), kRecordHeaderSize + 8);
+    EXPECT_EQ(recordSpan(8), kRecordHeaderSize + 8);
+    EXPECT_EQ(recordSpan(9), kRecordHeaderSize + 16);
+
+    std::vector<std::uint8_t> segment(kSegmentHeaderSize + recordSpan(5), 0xEE);
+    RecordHeader record;
+    record.payloadSize = 5;
+    record.timestampUs = 123456789;
+    record.sequence = 42;
+    record.payload = FramePayload::Video;
+    record.keyframe = false;
+    record.width = 1920;
+    record.height = 1080;
+    EXPECT_EQ(writeRecord(record, "hello", segment.data() + kSegmentHeaderSize), recordSpan(5));
+
+    RecordHeader parsed;
+    std::size_t payload = 0;
+    ASSERT_TRUE(parseRecord(segment.data(), segment.size(), kSegmentHeaderSize, parsed, payload));
+    EXPECT_EQ(parsed.payloadSize, 5u);
+    EXPECT_EQ(parsed.timestampUs, 123456789);
+    EXPECT_EQ(parsed.sequence, 42u);
+    EXPECT_EQ(parsed.payload, FramePayload::Video);
+    EXPECT_FALSE(parsed.keyframe);
+    EXPECT_EQ(parsed.width, 1920);
+    EXPECT_EQ(parsed.height, 1080);
+    EXPECT_EQ(std::string(reinterpret_cast<const char*>(segment.data() + payload), 5), "hello");
+    // Padding is cleared
+    EXPECT_EQ(segment[payload + 5], 0);
+    EXPECT_EQ(segment.back(), 0);
+}
+
+TEST(RecordingSegmentTest, TornRecordEndsTheSegment) {
+    Recording recording = makeRecording(3, 1000000);
+    const std::size_t last = recording.offsets.back();
+    RecordHeader parsed;
+    std::size_t payload = 0;
+    ASSERT_TRUE(parseRecord(recording.segment.data(), recording.segment.size(), last, parsed, payload));
+    // The used size stops inside the last record
+    EXPECT_FALSE(parseRecord(recording.segment.data(), recording.segment.size() - 1, last, parsed, payload));
+    // Not a record boundary
+    EXPECT_FALSE(parseRecord(recording.segment.data(), recording.segment.size(), last + 8, parsed, payload));
+    EXPECT_FALSE(parseRecord(recording.segment.data(), recording.segment.size(), recording.segment.size(), parsed,
+                             payload));
+}
+
+TEST(RecordingSegmentTest, SeekUsesTheIndexThenWalks) {
+    const std::int64_t start = 1700000000000000;
+    Recording recording = makeRecording(10, start);
+    const std::size_t entries = recording.index.size() / kIndexEntrySize;
+    ASSERT_EQ(entries, 4u); // records 0, 3, 6, 9
+
+    // Before the first entry: from the first record
+    EXPECT_EQ(seekIndex(recording.index.data(), entries, start - 1), kSegmentHeaderSize);
+    // Between entries: the last entry not later
+    EXPECT_EQ(seekIndex(recording.index.data(), entries, start + 450000), recording.offsets[3]);
+    EXPECT_EQ(seekIndex(recording.index.data(), entries, start + 600000), recording.offsets[6]);
+    EXPECT_EQ(seekIndex(nullptr, 0, start), kSegmentHeaderSize);
+
+    const std::size_t used = recording.segment.size();
+    const std::uint64_t from = seekIndex(recording.index.data(), entries, start + 450000);
+    EXPECT_EQ(findRecord(recording.segment.data(), used, from, start + 450000), recording.offsets[5]);
+    EXPECT_EQ(findRecord(recording.segment.data(), used, from, start + 400000), recording.offsets[4]);
+    // Past the last frame
+    EXPECT_EQ(findRecord(recording.segment.data(), used, kSegmentHeaderSize, start + 2000000), used);
+}
+
+TEST(RecordingSegmentTest, IndexEntryRoundTrip) {
+    IndexEntry entry;
+    entry.timestampUs = -5; // signed, survives the round trip
+    entry.offset = 0x123456789ull;
+    std::uint8_t bytes[kIndexEntrySize];
+    writeIndexEntry(entry, bytes);
+    const IndexEntry parsed = readIndexEntry(bytes);
+    EXPECT_EQ(parsed.timestampUs, -5);
+    EXPECT_EQ(parsed.offset, 0x123456789ull);
+}
@@ -0,0 +1,91 @@
+/**
+ * @file test_relay_queue.cpp
+ * @brief Unit tests for the per-viewer queue of relayed frames
+ *
+ * Tests validate:
+ * - Independent frames follow the viewer's drop policy
+ * - A video stream starts at a keyframe and resumes at one after a drop
+ * - A keyframe replaces the frames waiting in a full queue, never the one in flight
+ * - Control messages are never dropped and go out first
+ */
+
+#include <gtest/gtest.h>
+#include <string>
+#include "relayqueue.h"
+
+namespace {
+
+std::string drain(RelayQueue<std::string>& queue)
+{
+    std::string sent;
+    while (!queue.empty()) {
+        queue.beginWrite();
+        sent += queue.front();
+        queue.finishWrite();
+    }
+    return sent;
+}
+
+} // namespace
+
+TEST(RelayQueueTest, IndependentFramesFollowPolicy) {
+    RelayQueue<std::string> oldest(2, OutboundDropPolicy::DropOldest);
+    oldest.pushFrame("a", RelayFrameKind::Independent);
+    oldest.pushFrame("b", RelayFrameKind::Independent);
+    EXPECT_TRUE(oldest.pushFrame("c", RelayFrameKind::Independent));
+    EXPECT_EQ(drain(oldest), "bc");
+    EXPECT_EQ(oldest.droppedTotal(), 1u);
+
+    RelayQueue<std::string> newest(2, OutboundDropPolicy::DropNewest);
+    newest.pushFrame("a", RelayFrameKind::Independent);
+    newest.pushFrame("b", RelayFrameKind::Independent);
+    EXPECT_FALSE(newest.pushFrame("c", RelayFrameKind::Independent));
+    EXPECT_EQ(drain(newest), "ab");
+    EXPECT_EQ(newest.droppedTotal(), 1u);
+}
+
+TEST(RelayQueueTest, VideoStartsAndResumesAtKeyframe) {
+    RelayQueue<std::string> queue(2);
+    EXPECT_TRUE(queue.awaitingKeyframe());
+    EXPECT_FALSE(queue.pushFrame("d", RelayFrameKind::Delta)); // joined mid-GOP
+    EXPECT_TRUE(queue.pushFrame("K", RelayFrameKind::Keyframe));
+    EXPECT_TRUE(queue.pushFrame("1", RelayFrameKind::Delta));
+    EXPECT_FALSE(queue.pushFrame("2", RelayFrameKind::Delta)); // full: dropped...
+    queue.beginWrite();
+    queue.finishWrite();
+    EXPECT_FALSE(queue.pushFrame("3", RelayFrameKind::Delta)); // ...so "3" would not decode
+    EXPECT_TRUE(queue.awaitingKeyframe());
+    EXPECT_TRUE(queue.pushFrame("L", RelayFrameKind::Keyframe));
+    EXPECT_EQ(drain(queue), "1L");
+    EXPECT_EQ(queue.droppedTotal(), 3u);
+
+    queue.configure(2, OutboundDropPolicy::DropOldest); // new subscription
+    EXPECT_FALSE(queue.pushFrame("4", RelayFrameKind::Delta));
+}
+
+TEST(RelayQueueTest, KeyframeReplacesWaitingFrames) {
+    RelayQueue<std::string> queue(3);
+    queue.pushFrame("K", RelayFrameKind::Keyframe);
+    queue.pushFrame("1", RelayFrameKind::Delta);
+    queue.pushFrame("2", RelayFrameKind::Delta);
+    queue.beginWrite(); // "K" on the wire
+    EXPECT_TRUE(queue.pushFrame("L", RelayFrameKind::Keyframe));
+    EXPECT_EQ(queue.frameCount(), 2u);
+    queue.finishWrite();
+    EXPECT_EQ(drain(queue), "L");
+
+    RelayQueue<std::string> single(1);
+    single.pushFrame("K", RelayFrameKind::Keyframe);
+    single.beginWrite();
+    EXPECT_FALSE(single.pushFrame("L", RelayFrameKind::Keyframe)); // only the frame in flight
+    EXPECT_TRUE(single.awaitingKeyframe());
+}
+
+TEST(RelayQueueTest, ControlNeverDropped) {
+    RelayQueue<std::string> queue(1);
+    queue.pushFrame("a", RelayFrameKind::Independent);
+    queue.pushControl("C");
+    queue.pushControl("D");
+    EXPECT_EQ(drain(queue), "CDa");
+    EXPECT_EQ(queue.droppedTotal(), 0u);
+}
@@ -0,0 +1,65 @@
+/**
+ * @file test_replay_pacer.cpp
+ * @brief Unit tests for the recorded-stream replay schedule
+ *
+ * Tests validate:
+ * - Frames are due at their original spacing, scaled by the speed
+ * - Speed 0 sends at once
+ * - Backward jumps, long gaps and a lagging sender restart the schedule
+ */
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include "replaypacer.h"
+
+namespace {
+const std::int64_t kStream = 1700000000000000; // recorded timestamps
+const std::int64_t kWall = 5000000;            // monotonic clock of the sender
+} // namespace
+
+TEST(ReplayPacerTest, OriginalSpacingAtSpeedOne) {
+    ReplayPacer pacer;
+    EXPECT_EQ(pacer.dueUs(kStream, kWall), kWall);
+    EXPECT_EQ(pacer.dueUs(kStream + 33333, kWall + 100), kWall + 33333);
+    EXPECT_EQ(pacer.dueUs(kStream + 66666, kWall + 33400), kWall + 66666);
+    EXPECT_EQ(pacer.reanchors(), 0u);
+}
+
+TEST(ReplayPacerTest, SpeedScalesTheSpacing) {
+    ReplayPacer fast(4.0);
+    fast.dueUs(kStream, kWall);
+    EXPECT_EQ(fast.dueUs(kStream + 400000, kWall), kWall + 100000);
+
+    ReplayPacer unpaced(0.0);
+    unpaced.dueUs(kStream, kWall);
+    EXPECT_EQ(unpaced.dueUs(kStream + 400000, kWall + 7), kWall + 7);
+}
+
+TEST(ReplayPacerTest, BackwardJumpRestarts) {
+    ReplayPacer pacer;
+    pacer.dueUs(kStream, kWall);
+    pacer.dueUs(kStream + 500000, kWall + 500000);
+    // Looped source: back to the first timestamp
+    EXPECT_EQ(pacer.dueUs(kStream, kWall + 540000), kWall + 540000);
+    EXPECT_EQ(pacer.dueUs(kStream + 40000, kWall + 540000), kWall + 580000);
+    EXPECT_EQ(pacer.reanchors(), 1u);
+}
+
+TEST(ReplayPacerTest, LongGapIsNotWaitedOut) {
+    ReplayPacer pacer(1.0, 2000000);
+    pacer.dueUs(kStream, kWall);
+    // Recording paused for an hour
+    EXPECT_EQ(pacer.dueUs(kStream + 3600000000ll, kWall + 40000), kWall + 40000);
+    EXPECT_EQ(pacer.reanchors(), 1u);
+}
+
+TEST(ReplayPacerTest, LaggingSenderDoesNotBurst) {
+    ReplayPacer pacer(1.0, 2000000, 1000000);
+    pacer.dueUs(kStream, kWall);
+    // The sender was held up 3 s (paused by the server): continue from now
+    EXPECT_EQ(pacer.dueUs(kStream + 40000, kWall + 3000000), kWall + 3000000);
+    EXPECT_EQ(pacer.dueUs(kStream + 80000, kWall + 3000000), kWall + 3040000);
+
+    pacer.reset();
+    EXPECT_EQ(pacer.dueUs(kStream, kWall + 9000000), kWall + 9000000);
+}
@@ -0,0 +1,113 @@
+/**
+ * @file test_scene_activity.cpp
+ * @brief Unit tests for the server's per-client scene activity estimate
+ *
+ * Tests validate:
+ * - Steady JPEG sizes turn idle after the quiet intervals, a size swing ends it at once
+ * - Video deltas are measured against the last keyframe
+ * - UNCHANGED heartbeats count as still frames
+ * - Intervals without samples (raw frames, paused) change nothing
+ */
+
+#include <gtest/gtest.h>
+#include <cstddef>
+#include "sceneactivity.h"
+
+namespace {
+const int kFps = 10;
+
+// One evaluation interval of JPEG frames alternating around `bytes` by `swing`
+bool jpegInterval(SceneActivity& scene, std::size_t bytes, std::size_t swing)
+{
+    for (int i = 0; i < kFps; ++i)
+        scene.onFrame(i % 2 ? bytes + swing : bytes, false, false);
+    return scene.evaluate();
+}
+} // namespace
+
+TEST(SceneActivityTest, JpegSizeVarianceTracksMotion)
+{
+    SceneActivity scene;
+    // Encoder noise: 0.5 % size jitter stays quiet
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_FALSE(jpegInterval(scene, 40000, 200));
+        EXPECT_FALSE(scene.idle());
+    }
+    EXPECT_LT(scene.activity(), 1.0);
+    EXPECT_TRUE(jpegInterval(scene, 40000, 200)); // fifth quiet interval
+    EXPECT_TRUE(scene.idle());
+    EXPECT_FALSE(jpegInterval(scene, 40000, 200));
+
+    // Someone walks in: 10 % swings end idle at the next evaluation
+    EXPECT_TRUE(jpegInterval(scene, 40000, 4000));
+    EXPECT_FALSE(scene.idle());
+    EXPECT_GE(scene.activity(), 1.0);
+    // ... and it takes the full quiet streak again to go back
+    for (int i = 0; i < 4; ++i)
+        EXPECT_FALSE(jpegInterval(scene, 40000, 0));
+    EXPECT_TRUE(jpegInterval(scene, 40000, 0));
+}
+
+TEST(SceneActivityTest, VideoDeltasAgainstKeyframe)
+{
+    SceneActivityConfig config;
+    config.quietIntervalsBeforeIdle = 1;
+    SceneActivity scene(config);
+
+    // A delta before any keyframe says nothing
+    scene.onFrame(500, true, false);
+    EXPECT_FALSE(scene.evaluate());
+
+    scene.onFrame(100000, true, true);
+    for (int i = 0; i < kFps; ++i)
+        scene.onFrame(1500, true, false); // 1.5 % of the keyframe
+    EXPECT_TRUE(scene.evaluate());
+    EXPECT_TRUE(scene.idle());
+
+    for (int i = 0; i < kFps; ++i)
+        scene.onFrame(20000, true, false);
+    EXPECT_TRUE(scene.evaluate());
+    EXPECT_FALSE(scene.idle());
+    EXPECT_NEAR(scene.activity(), 2.5, 1e-9);
+}
+
+TEST(SceneActivityTest, UnchangedHeartbeatsAreStill)
+{
+    SceneActivityConfig config;
+    config.quietIntervalsBeforeIdle = 2;
+    SceneActivity scene(config);
+    for (int i = 0; i < kFps; ++i)
+        scene.onUnchanged();
+    EXPECT_FALSE(scene.evaluate());
+    EXPECT_EQ(scene.activity(), 0.0);
+    for (int i = 0; i < kFps; ++i)
+        scene.onUnchanged();
+    EXPECT_TRUE(scene.evaluate());
+    EXPECT_TRUE(scene.idle());
+
+    // Tiled frames: a few changed tiles among heartbeats still average out as quiet
+    scene.onFrame(60000, true, true);
+    scene.onFrame(1200, true, false);
+    for (int i = 0; i < kFps - 2; ++i)
+        scene.onUnchanged();
+    EXPECT_FALSE(scene.evaluate());
+    EXPECT_TRUE(scene.idle());
+}
+
+TEST(SceneActivityTest, NoSamplesKeepState)
+{
+    SceneActivityConfig config;
+    config.quietIntervalsBeforeIdle = 1;
+    SceneActivity scene(config);
+    EXPECT_FALSE(scene.evaluate());
+    EXPECT_FALSE(scene.idle());
+
+    EXPECT_TRUE(jpegInterval(scene, 30000, 0));
+    // Paused: nothing arrives, the client stays idle instead of flapping
+    for (int i = 0; i < 3; ++i)
+        EXPECT_FALSE(scene.evaluate());
+    EXPECT_TRUE(scene.idle());
+    // Empty frames are ignored
+    scene.onFrame(0, false, false);
+    EXPECT_FALSE(scene.evaluate());
+}
@@ -0,0 +1,168 @@
+/**
+ * @file test_shm_frame_ring.cpp
+ * @brief Unit tests for the same-host shared-memory frame ring and its doorbell
+ *
+ * Tests validate:
+ * - Messages written in pieces are read back whole, in order
+ * - A full ring and messages larger than a slot are refused
+ * - Consumers only map segments made by a producer, and announce themselves
+ * - The doorbell is due only while the consumer waits for it
+ * - A producer in another process reaches a consumer sleeping on the doorbell
+ */
+
+#include <gtest/gtest.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include "shmframering.h"
+
+namespace {
+
+std::string ringName(const char* test)
+{
+    return std::string(kShmRingNamePrefix) + "test-" + std::to_string(::getpid()) + "-" + test;
+}
+
+std::string readOne(ShmFrameRing& ring)
+{
+    std::string message;
+    ring.read([&](const std::uint8_t* data, std::size_t size) {
+        message.assign(reinterpret_cast<const char*>(data), size);
+    });
+    return message;
+}
+
+bool writeString(ShmFrameRing& ring, const std::string& message)
+{
+    return ring.write({{message.data(), message.size()}});
+}
+
+} // namespace
+
+TEST(ShmFrameRingTest, GathersPiecesIntoOneMessage) {
+    const std::string name = ringName("gather");
+    ShmFrameRing producer;
+    ASSERT_TRUE(producer.create(name, 4, 4096)) << producer.errorString();
+    ShmFrameRing consumer;
+    ASSERT_TRUE(consumer.open(name)) << consumer.errorString();
+    EXPECT_EQ(consumer.slotCount(), 4u);
+
+    const std::uint8_t prefix = 0x04;
+    const std::string header(24, 'h');
+    const std::string payload = "jpeg bytes";
+    ASSERT_TRUE(producer.write({{&prefix, 1}, {header.data(), header.size()}, {payload.data(), payload.size()}}));
+    ASSERT_TRUE(writeString(producer, "second"));
+    EXPECT_EQ(consumer.pending(), 2u);
+
+    EXPECT_EQ(readOne(consumer), std::string("\x04", 1) + header + payload);
+    EXPECT_EQ(readOne(consumer), "second");
+    EXPECT_FALSE(consumer.read([](const std::uint8_t*, std::size_t) {}));
+}
+
+TEST(ShmFrameRingTest, FullRingAndOversizedMessagesRefused) {
+    const std::string name = ringName("full");
+    ShmFrameRing producer;
+    ASSERT_TRUE(producer.create(name, 2, 64));
+    ShmFrameRing consumer;
+    ASSERT_TRUE(consumer.open(name));
+
+    EXPECT_EQ(producer.maxMessageSize(), 64u - kShmSlotHeaderSize);
+    EXPECT_FALSE(writeString(producer, std::string(producer.maxMessageSize() + 1, 'x')));
+    EXPECT_TRUE(writeString(producer, std::string(producer.maxMessageSize(), 'x')));
+    EXPECT_TRUE(writeString(producer, "b"));
+    EXPECT_FALSE(writeString(producer, "c")); // both slots taken
+
+    readOne(consumer);
+    EXPECT_TRUE(writeString(producer, "c")); // the read freed one, wrapping around
+    EXPECT_EQ(readOne(consumer), "b");
+    EXPECT_EQ(readOne(consumer), "c");
+}
+
+TEST(ShmFrameRingTest, ConsumerChecksSegmentAndAnnouncesItself) {
+    ShmFrameRing consumer;
+    EXPECT_FALSE(consumer.open(ringName("missing")));
+    EXPECT_FALSE(consumer.errorString().empty());
+
+    const std::string name = ringName("attach");
+    ShmFrameRing producer;
+    ASSERT_TRUE(producer.create(name, 2, 1024));
+    EXPECT_FALSE(producer.consumerAttached());
+    ASSERT_TRUE(consumer.open(name));
+    EXPECT_TRUE(producer.consumerAttached());
+
+    // Unlinked: the mappings stay usable, the name is gone
+    producer.unlink();
+    ASSERT_TRUE(writeString(producer, "still here"));
+    EXPECT_EQ(readOne(consumer), "still here");
+    ShmFrameRing late;
+    EXPECT_FALSE(late.open(name));
+}
+
+TEST(ShmFrameRingTest, DoorbellDueOnlyWhileConsumerWaits) {
+    const std::string name = ringName("doorbell");
+    ShmFrameRing producer;
+    ASSERT_TRUE(producer.create(name, 4, 1024));
+    ShmFrameRing consumer;
+    ASSERT_TRUE(consumer.open(name));
+
+    ASSERT_TRUE(writeString(producer, "a"));
+    EXPECT_FALSE(producer.takeDoorbell()); // consumer busy
+    EXPECT_FALSE(consumer.prepareToWait()); // "a" pending: read on
+    readOne(consumer);
+
+    EXPECT_TRUE(consumer.prepareToWait());
+    ASSERT_TRUE(writeString(producer, "b"));
+    EXPECT_TRUE(producer.takeDoorbell());
+    EXPECT_FALSE(producer.takeDoorbell()); // once per wait
+}
+
+TEST(ShmFrameRingTest, ProducerInAnotherProcessWakesConsumer) {
+    const std::string name = ringName("process");
+    const int kMessages = 200;
+    ShmFrameRing producer;
+    ASSERT_TRUE(producer.create(name, 4, 1024));
+    ShmFrameRing consumer;
+    ASSERT_TRUE(consumer.open(name));
+    ShmDoorbell bell;
+    ASSERT_TRUE(bell.listen(name)) << bell.errorString();
+
+    const pid_t child = ::fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        // The inherited mapping is the producer's
+        ShmDoorbell ring;
+        if (!ring.connect(name))
+            ::_exit(1);
+        for (int i = 0; i < kMessages;) {
+            if (!writeString(producer, std::to_string(i))) {
+                ::usleep(100); // full: the consumer is behind
+                continue;
+            }
+            if (producer.takeDoorbell())
+                ring.ring();
+            ++i;
+        }
+        ::_exit(0);
+    }
+
+    std::vector<std::string> received;
+    while (static_cast<int>(received.size()) < kMessages) {
+        while (consumer.read([&](const std::uint8_t* data, std::size_t size) {
+            received.emplace_back(reinterpret_cast<const char*>(data), size);
+        })) {
+        }
+        if (static_cast<int>(received.size()) >= kMessages || !consumer.prepareToWait())
+            continue;
+        pollfd wait = {bell.fd(), POLLIN, 0};
+        ASSERT_EQ(::poll(&wait, 1, 5000), 1) << "doorbell never rang";
+        bell.drain();
+    }
+
+    int status = 0;
+    ASSERT_EQ(::waitpid(child, &status, 0), child);
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+    for (int i = 0; i < kMessages; ++i)
+        ASSERT_EQ(received[i], std::to_string(i));
+}
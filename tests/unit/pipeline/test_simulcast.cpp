@@ -0,0 +1,93 @@
+/**
+ * @file test_simulcast.cpp
+ * @brief Unit tests for simulcast layer bookkeeping and the per-consumer layer pick
+ *
+ * Tests validate:
+ * - The smallest layer that covers the display target is picked; no target: full
+ * - Unseen layer sizes are derived from the full layer
+ * - Layers over the consumer's bitrate give way to smaller ones
+ * - Bitrates per interval, kept for layers that went quiet; layer count clamped
+ */
+
+#include <gtest/gtest.h>
+#include <vector>
+#include "simulcast.h"
+
+namespace {
+std::vector<SimulcastLayer> threeLayers()
+{
+    std::vector<SimulcastLayer> layers(3);
+    layers[0].width = 1920;
+    layers[0].height = 1080;
+    layers[1].width = 960;
+    layers[1].height = 540;
+    layers[2].width = 480;
+    layers[2].height = 270;
+    return layers;
+}
+} // namespace
+
+TEST(SimulcastTest, SmallestLayerCoveringTarget)
+{
+    const std::vector<SimulcastLayer> layers = threeLayers();
+    EXPECT_EQ(pickSimulcastLayer(layers, 0, 0, 0.0), 0);
+    EXPECT_EQ(pickSimulcastLayer(layers, 1920, 1080, 0.0), 0);
+    EXPECT_EQ(pickSimulcastLayer(layers, 961, 541, 0.0), 0);
+    EXPECT_EQ(pickSimulcastLayer(layers, 960, 540, 0.0), 1);
+    EXPECT_EQ(pickSimulcastLayer(layers, 320, 180, 0.0), 2);
+    // A tall tile is bound by its width
+    EXPECT_EQ(pickSimulcastLayer(layers, 480, 1000, 0.0), 2);
+    // One layer: nothing to pick
+    EXPECT_EQ(pickSimulcastLayer(std::vector<SimulcastLayer>(1), 10, 10, 1.0), 0);
+    EXPECT_EQ(pickSimulcastLayer(std::vector<SimulcastLayer>(), 10, 10, 1.0), 0);
+}
+
+TEST(SimulcastTest, UnseenSizesFollowFullLayer)
+{
+    std::vector<SimulcastLayer> layers(3);
+    // Nothing known: only the full layer covers
+    EXPECT_EQ(pickSimulcastLayer(layers, 320, 180, 0.0), 0);
+    layers[0].width = 1280;
+    layers[0].height = 720;
+    EXPECT_EQ(pickSimulcastLayer(layers, 320, 180, 0.0), 2);
+    EXPECT_EQ(pickSimulcastLayer(layers, 600, 300, 0.0), 1);
+}
+
+TEST(SimulcastTest, BitrateMovesDown)
+{
+    std::vector<SimulcastLayer> layers = threeLayers();
+    layers[0].bitrateBps = 8e6;
+    layers[1].bitrateBps = 2.5e6;
+    layers[2].bitrateBps = 0.7e6;
+    EXPECT_EQ(pickSimulcastLayer(layers, 0, 0, 10e6), 0);
+    EXPECT_EQ(pickSimulcastLayer(layers, 0, 0, 3e6), 1);
+    EXPECT_EQ(pickSimulcastLayer(layers, 1920, 1080, 1e6), 2);
+    // Even the smallest is over: it still gets that one
+    EXPECT_EQ(pickSimulcastLayer(layers, 0, 0, 0.1e6), 2);
+    // Never moves up for bandwidth
+    EXPECT_EQ(pickSimulcastLayer(layers, 320, 180, 100e6), 2);
+}
+
+TEST(SimulcastTest, MeterTracksLayers)
+{
+    SimulcastMeter meter(6);
+    EXPECT_EQ(meter.layerCount(), kMaxSimulcastLayers);
+    meter.setLayerCount(2);
+    ASSERT_EQ(meter.layerCount(), 2);
+
+    meter.onFrame(0, 50000, 1280, 720);
+    meter.onFrame(0, 50000, 0, 0); // no size: keeps the known one
+    meter.onFrame(1, 10000, 640, 360);
+    meter.onFrame(2, 99999, 1, 1);  // not a layer
+    meter.evaluate(500);
+    EXPECT_EQ(meter.layers()[0].width, 1280);
+    EXPECT_DOUBLE_EQ(meter.layers()[0].bitrateBps, 1.6e6);
+    EXPECT_DOUBLE_EQ(meter.layers()[1].bitrateBps, 160e3);
+
+    // Layer 1 paused: its last bitrate stays
+    meter.onFrame(0, 25000, 1280, 720);
+    meter.evaluate(1000);
+    EXPECT_DOUBLE_EQ(meter.layers()[0].bitrateBps, 200e3);
+    EXPECT_DOUBLE_EQ(meter.layers()[1].bitrateBps, 160e3);
+    EXPECT_EQ(meter.layers()[1].height, 360);
+}
@@ -0,0 +1,113 @@
+/**
+ * @file test_stats_history.cpp
+ * @brief Unit tests for the per-client statistics history behind the trend charts
+ *
+ * Tests validate:
+ * - The 1 s ring keeps the newest samples as given, oldest first, in fixed capacity
+ * - 10 s and 1 min points are averages over aligned intervals; unmeasured
+ *   latency stays out of the average
+ * - Queries by start time and by point count
+ */
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <vector>
+#include "statshistory.h"
+
+namespace {
+
+StatsPoint sampleAt(std::int64_t second, float fps, float latencyMs = -1.0f)
+{
+    StatsPoint point;
+    point.timeMs = second * 1000;
+    point.fps = fps;
+    point.bytesPerSecond = fps * 1000.0f;
+    point.latencyMs = latencyMs;
+    point.drops = fps > 20.0f ? 1.0f : 0.0f;
+    return point;
+}
+
+std::vector<StatsPoint> pointsOf(const StatsHistory& history, int resolution, std::int64_t sinceMs = 0,
+                                 std::size_t maxPoints = 0)
+{
+    std::vector<StatsPoint> points;
+    history.forEach(resolution, sinceMs, maxPoints, [&](const StatsPoint& point) { points.push_back(point); });
+    return points;
+}
+
+} // namespace
+
+TEST(StatsHistoryTest, SecondsRingKeepsNewest) {
+    StatsHistory history(5, 4, 3);
+    for (int second = 0; second < 12; ++second)
+        history.add(sampleAt(second, float(second)));
+    const std::vector<StatsPoint> points = pointsOf(history, StatsHistory::Seconds);
+    ASSERT_EQ(points.size(), 5u);
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        EXPECT_EQ(points[i].timeMs, std::int64_t(7 + i) * 1000);
+        EXPECT_FLOAT_EQ(points[i].fps, float(7 + i));
+    }
+    EXPECT_EQ(history.capacity(StatsHistory::Seconds), 5u);
+}
+
+TEST(StatsHistoryTest, CoarserResolutionsAverageAlignedIntervals) {
+    StatsHistory history;
+    // 0-9 s at 10 fps, 10-19 s at 30 fps, then one sample to close the second interval
+    for (int second = 0; second < 20; ++second)
+        history.add(sampleAt(second, second < 10 ? 10.0f : 30.0f, second % 2 == 0 ? 40.0f : -1.0f));
+    history.add(sampleAt(20, 0.0f));
+
+    const std::vector<StatsPoint> tens = pointsOf(history, StatsHistory::TenSeconds);
+    ASSERT_EQ(tens.size(), 2u);
+    EXPECT_EQ(tens[0].timeMs, 0);
+    EXPECT_FLOAT_EQ(tens[0].fps, 10.0f);
+    EXPECT_FLOAT_EQ(tens[0].bytesPerSecond, 10000.0f);
+    EXPECT_FLOAT_EQ(tens[0].drops, 0.0f);
+    EXPECT_FLOAT_EQ(tens[0].latencyMs, 40.0f);     // unmeasured seconds left out
+    EXPECT_EQ(tens[1].timeMs, 10000);
+    EXPECT_FLOAT_EQ(tens[1].fps, 30.0f);
+    EXPECT_FLOAT_EQ(tens[1].drops, 1.0f);
+
+    // The minute is still open
+    EXPECT_EQ(history.size(StatsHistory::Minutes), 0u);
+    for (int second = 21; second <= 60; ++second)
+        history.add(sampleAt(second, 0.0f));
+    const std::vector<StatsPoint> minutes = pointsOf(history, StatsHistory::Minutes);
+    ASSERT_EQ(minutes.size(), 1u);
+    EXPECT_EQ(minutes[0].timeMs, 0);
+    EXPECT_FLOAT_EQ(minutes[0].fps, (10.0f * 10 + 30.0f * 10) / 60.0f);
+}
+
+TEST(StatsHistoryTest, GapsStartNewIntervals) {
+    StatsHistory history;
+    history.add(sampleAt(5, 10.0f));
+    history.add(sampleAt(47, 20.0f));   // the client was gone in between
+    history.add(sampleAt(55, 20.0f));
+    const std::vector<StatsPoint> tens = pointsOf(history, StatsHistory::TenSeconds);
+    // 0-9 s from one sample, 40-49 s from one; nothing in between, 50-59 s still open
+    ASSERT_EQ(tens.size(), 2u);
+    EXPECT_EQ(tens[0].timeMs, 0);
+    EXPECT_FLOAT_EQ(tens[0].fps, 10.0f);
+    EXPECT_EQ(tens[1].timeMs, 40000);
+    EXPECT_FLOAT_EQ(tens[1].fps, 20.0f);
+    EXPECT_FLOAT_EQ(tens[1].latencyMs, -1.0f);
+}
+
+TEST(StatsHistoryTest, QueriesBySinceAndCount) {
+    StatsHistory history;
+    for (int second = 0; second < 100; ++second)
+        history.add(sampleAt(second, float(second)));
+    EXPECT_EQ(pointsOf(history, StatsHistory::Seconds, 90 * 1000).size(), 10u);
+    const std::vector<StatsPoint> last = pointsOf(history, StatsHistory::Seconds, 0, 3);
+    ASSERT_EQ(last.size(), 3u);
+    EXPECT_FLOAT_EQ(last.front().fps, 97.0f);
+    EXPECT_EQ(pointsOf(history, StatsHistory::Seconds, 200 * 1000).size(), 0u);
+
+    EXPECT_EQ(StatsHistory::resolutionFor(1), StatsHistory::Seconds);
+    EXPECT_EQ(StatsHistory::resolutionFor(10), StatsHistory::TenSeconds);
+    EXPECT_EQ(StatsHistory::resolutionFor(300), StatsHistory::Minutes);
+
+    history.clear();
+    EXPECT_EQ(history.size(StatsHistory::Seconds), 0u);
+    EXPECT_EQ(history.size(StatsHistory::TenSeconds), 0u);
+}
@@ -0,0 +1,139 @@
+/**
+ * @file test_stream_metrics.cpp
+ * @brief Unit tests for the per-client stream counters and their Prometheus rendering
+ *
+ * Tests validate:
+ * - Counters and server totals in the text exposition format
+ * - Cumulative decode histogram buckets, sum and count
+ * - Disconnected clients leave their counts in the totals
+ * - Label escaping and locale-independent seconds
+ * - Writers on other threads never lose counts
+ */
+
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "streammetrics.h"
+
+namespace {
+bool contains(const std::string& text, const std::string& line)
+{
+    return text.find(line) != std::string::npos;
+}
+} // namespace
+
+TEST(StreamMetricsTest, RendersCountersAndTotals) {
+    StreamMetrics metrics;
+    std::shared_ptr<StreamCounters> counters = metrics.addClient("c1");
+    metrics.setAlias("c1", "cam-1");
+    counters->recordFrame(1000);
+    counters->recordFrame(500);
+    counters->recordDropped(2);
+    counters->recordClientQueue(3, 7);
+    counters->recordUnchanged();
+
+    const std::string text = metrics.render();
+    EXPECT_TRUE(contains(text, "# TYPE imagesocket_frames_received_total counter\n"));
+    EXPECT_TRUE(contains(text, "imagesocket_frames_received_total{client=\"c1\",alias=\"cam-1\"} 2\n"));
+    EXPECT_TRUE(contains(text, "imagesocket_bytes_received_total{client=\"c1\",alias=\"cam-1\"} 1500\n"));
+    EXPECT_TRUE(contains(text, "imagesocket_frames_dropped_total{client=\"c1\",alias=\"cam-1\"} 2\n"));
+    EXPECT_TRUE(contains(text, "imagesocket_client_send_queue_frames{client=\"c1\",alias=\"cam-1\"} 3\n"));
+    EXPECT_TRUE(contains(text, "imagesocket_client_frames_dropped_total{client=\"c1\",alias=\"cam-1\"} 7\n"));
+    EXPECT_TRUE(contains(text, "imagesocket_frames_unchanged_total{client=\"c1\",alias=\"cam-1\"} 1\n"));
+    EXPECT_TRUE(contains(text, "imagesocket_clients 1\n"));
+    EXPECT_TRUE(contains(text, "imagesocket_server_frames_received_total 2\n"));
+    EXPECT_EQ(metrics.addClient("c1"), counters);
+}
+
+TEST(StreamMetricsTest, DecodeHistogramIsCumulative) {
+    StreamMetrics metrics;
+    std::shared_ptr<StreamCounters> counters = metrics.addClient("c1");
+    counters->recordDecode(800);     // <= 1 ms
+    counters->recordDecode(1000);    // edge belongs to its bucket
+    counters->recordDecode(4000);    // <= 5 ms
+    counters->recordDecode(3000000); // above every edge
+
+    const std::string text = metrics.render();
+    const std::string labels = "client=\"c1\",alias=\"\"";
+    EXPECT_TRUE(contains(text, "imagesocket_decode_seconds_bucket{" + labels + ",le=\"0.001000\"} 2\n"));
+    EXPECT_TRUE(contains(text, "imagesocket_decode_seconds_bucket{" + labels + ",le=\"0.002000\"} 2\n"));
+    EXPECT_TRUE(contains(text, "imagesocket_decode_seconds_bucket{" + labels + ",le=\"0.005000\"} 3\n"));
+    EXPECT_TRUE(contains(text, "imagesocket_decode_seconds_bucket{" + labels + ",le=\"1.000000\"} 3\n"));
+    EXPECT_TRUE(contains(text, "imagesocket_decode_seconds_bucket{" + labels + ",le=\"+Inf\"} 4\n"));
+    EXPECT_TRUE(contains(text, "imagesocket_decode_seconds_sum{" + labels + "} 3.005800\n"));
+    EXPECT_TRUE(contains(text, "imagesocket_decode_seconds_count{" + labels + "} 4\n"));
+    EXPECT_TRUE(contains(text, "imagesocket_server_frames_decoded_total 4\n"));
+}
+
+TEST(StreamMetricsTest, LatencyQuantilesPerStage) {
+    StreamMetrics metrics;
+    metrics.addClient("c1");
+    LatencyQuantiles network;
+    network.stage = "network";
+    network.p50Us = 12500;
+    network.p99Us = 40000;
+    LatencyQuantiles display;
+    display.stage = "display"; // no samples yet: p50/p99 stay -1
+    metrics.setLatency("c1", {network, display});
+
+    const std::string text = metrics.render();
+    EXPECT_TRUE(contains(text,
+        "imagesocket_latency_seconds{client=\"c1\",alias=\"\",stage=\"network\",quantile=\"0.5\"} 0.012500\n"));
+    EXPECT_TRUE(contains(text,
+        "imagesocket_latency_seconds{client=\"c1\",alias=\"\",stage=\"network\",quantile=\"0.99\"} 0.040000\n"));
+    EXPECT_FALSE(contains(text, "stage=\"display\""));
+}
+
+TEST(StreamMetricsTest, RemovedClientsStayInTotals) {
+    StreamMetrics metrics;
+    metrics.addClient("c1")->recordFrame(100);
+    metrics.addClient("c2")->recordFrame(50);
+    metrics.removeClient("c1");
+    metrics.removeClient("unknown");
+
+    const std::string text = metrics.render();
+    EXPECT_EQ(metrics.clientCount(), 1u);
+    EXPECT_FALSE(contains(text, "client=\"c1\""));
+    EXPECT_TRUE(contains(text, "imagesocket_clients 1\n"));
+    EXPECT_TRUE(contains(text, "imagesocket_server_frames_received_total 2\n"));
+    EXPECT_TRUE(contains(text, "imagesocket_server_bytes_received_total 150\n"));
+
+    metrics.removeClient("c2");
+    const std::string empty = metrics.render();
+    EXPECT_TRUE(contains(empty, "imagesocket_clients 0\n"));
+    EXPECT_TRUE(contains(empty, "imagesocket_server_frames_received_total 2\n"));
+    EXPECT_FALSE(contains(empty, "imagesocket_frames_received_total{"));
+}
+
+TEST(StreamMetricsTest, EscapingAndSeconds) {
+    EXPECT_EQ(StreamMetrics::escape("cam \"north\"\\1\nx"), "cam \\\"north\\\"\\\\1\\nx");
+    EXPECT_EQ(StreamMetrics::seconds(0), "0.000000");
+    EXPECT_EQ(StreamMetrics::seconds(1234567), "1.234567");
+    EXPECT_EQ(StreamMetrics::seconds(-2500), "-0.002500");
+}
+
+TEST(StreamMetricsTest, ConcurrentWritersWhileScraping) {
+    StreamMetrics metrics;
+    std::shared_ptr<StreamCounters> counters = metrics.addClient("c1");
+    const int kThreads = 4;
+    const int kFrames = 20000;
+    std::vector<std::thread> writers;
+    for (int t = 0; t < kThreads; ++t) {
+        writers.emplace_back([&]() {
+            for (int i = 0; i < kFrames; ++i) {
+                counters->recordFrame(10);
+                counters->recordDecode(i % 3000);
+            }
+        });
+    }
+    for (int i = 0; i < 50; ++i)
+        EXPECT_FALSE(metrics.render().empty());
+    for (std::thread& writer : writers)
+        writer.join();
+
+    EXPECT_EQ(counters->framesReceived.load(), static_cast<std::uint64_t>(kThreads * kFrames));
+    EXPECT_EQ(counters->bytesReceived.load(), static_cast<std::uint64_t>(kThreads * kFrames * 10));
+    EXPECT_TRUE(contains(metrics.render(), "imagesocket_decode_seconds_count{client=\"c1\",alias=\"\"} "
+                                           + std::to_string(kThreads * kFrames) + "\n"));
+}
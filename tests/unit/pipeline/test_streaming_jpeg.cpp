@@ -0,0 +1,158 @@
+/**
+ * @file test_streaming_jpeg.cpp
+ * @brief Unit tests for decoding JPEG frames while their bytes arrive
+ *
+ * Tests validate:
+ * - A picture fed in small pieces, from a buffer that moves as it grows, comes
+ *   out exactly as one fed at once, with rows done before the last piece
+ * - Pixels land in RGB32 layout at the DCT scale that covers the target
+ * - A message that ends early still finishes (gray rows), garbage fails
+ * - Storage refused by the allocator fails the decode
+ */
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include "jpegcodec.h"
+#include "streamingjpeg.h"
+
+namespace {
+
+std::vector<unsigned char> gradientJpeg(int width, int height)
+{
+    std::vector<unsigned char> bgr(static_cast<std::size_t>(width * height * 3));
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            unsigned char* pixel = &bgr[static_cast<std::size_t>((y * width + x) * 3)];
+            pixel[0] = static_cast<unsigned char>(200);             // blue
+            pixel[1] = static_cast<unsigned char>(x * 255 / width);  // green
+            pixel[2] = static_cast<unsigned char>(y * 255 / height); // red
+        }
+    }
+    std::vector<unsigned char> jpeg;
+    std::unique_ptr<JpegCodec> codec = JpegCodec::createSoftware();
+    if (!codec->encodeBgr(bgr.data(), width, height, width * 3, 85, jpeg))
+        jpeg.clear();
+    return jpeg;
+}
+
+struct Picture {
+    int width = 0;
+    int height = 0;
+    std::size_t stride = 0;
+    std::vector<std::uint8_t> pixels;
+
+    StreamingJpegDecoder::Allocator allocator()
+    {
+        return [this](int w, int h, std::size_t& rowBytes) -> std::uint8_t* {
+            width = w;
+            height = h;
+            stride = static_cast<std::size_t>(w) * 4 + 16; // padded rows, as QImage may have
+            rowBytes = stride;
+            pixels.assign(stride * static_cast<std::size_t>(h), 0);
+            return pixels.data();
+        };
+    }
+
+    const std::uint8_t* pixel(int x, int y) const { return &pixels[static_cast<std::size_t>(y) * stride + x * 4]; }
+};
+
+} // namespace
+
+class StreamingJpegTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        if (!StreamingJpegDecoder::available())
+            GTEST_SKIP() << "built without libjpeg";
+    }
+};
+
+TEST_F(StreamingJpegTest, PiecesMatchWholePicture)
+{
+    const std::vector<unsigned char> jpeg = gradientJpeg(640, 480);
+    ASSERT_GT(jpeg.size(), 1000u);
+
+    Picture whole;
+    StreamingJpegDecoder decoder;
+    decoder.begin(0, 0, whole.allocator());
+    ASSERT_EQ(decoder.feed(jpeg.data(), jpeg.size(), true), StreamingJpegDecoder::Status::Done);
+    EXPECT_EQ(whole.width, 640);
+    EXPECT_EQ(whole.height, 480);
+
+    // 700-byte pieces into a buffer that is reallocated on every append, as a growing receive buffer may be
+    Picture pieces;
+    decoder.begin(0, 0, pieces.allocator());
+    std::vector<unsigned char> received;
+    int rowsBeforeLast = 0;
+    StreamingJpegDecoder::Status status = StreamingJpegDecoder::Status::NeedData;
+    for (std::size_t at = 0; at < jpeg.size(); at += 700) {
+        const std::size_t end = std::min(jpeg.size(), at + 700);
+        std::vector<unsigned char> grown(received);
+        grown.insert(grown.end(), jpeg.begin() + static_cast<std::ptrdiff_t>(at),
+                     jpeg.begin() + static_cast<std::ptrdiff_t>(end));
+        received.swap(grown);
+        const bool complete = end == jpeg.size();
+        if (complete)
+            rowsBeforeLast = decoder.rowsDone();
+        status = decoder.feed(received.data(), received.size(), complete);
+        if (!complete) {
+            ASSERT_EQ(status, StreamingJpegDecoder::Status::NeedData) << "at " << at;
+        }
+    }
+    ASSERT_EQ(status, StreamingJpegDecoder::Status::Done);
+    EXPECT_GT(rowsBeforeLast, 240); // most of the picture was decoded before its last bytes came in
+    EXPECT_EQ(decoder.rowsDone(), 480);
+    for (int y = 0; y < 480; ++y)
+        ASSERT_EQ(0, std::memcmp(whole.pixel(0, y), pieces.pixel(0, y), 640 * 4)) << "row " << y;
+}
+
+TEST_F(StreamingJpegTest, ScaledToTargetInRgb32Layout)
+{
+    const std::vector<unsigned char> jpeg = gradientJpeg(640, 480);
+    Picture picture;
+    StreamingJpegDecoder decoder;
+    decoder.begin(150, 100, picture.allocator());
+    ASSERT_EQ(decoder.feed(jpeg.data(), jpeg.size(), true), StreamingJpegDecoder::Status::Done);
+    EXPECT_EQ(picture.width, 160); // 1/4 covers 150 x 100, 1/8 would not
+    EXPECT_EQ(picture.height, 120);
+
+    // QImage::Format_RGB32 on a little-endian host: B, G, R, 0xff
+    const std::uint8_t* center = picture.pixel(80, 60);
+    EXPECT_NEAR(center[0], 200, 8);
+    EXPECT_NEAR(center[1], 127, 8);
+    EXPECT_NEAR(center[2], 127, 8);
+    EXPECT_EQ(center[3], 0xff);
+}
+
+TEST_F(StreamingJpegTest, TruncatedFinishesGarbageFails)
+{
+    const std::vector<unsigned char> jpeg = gradientJpeg(320, 240);
+    Picture picture;
+    StreamingJpegDecoder decoder;
+    decoder.begin(0, 0, picture.allocator());
+    EXPECT_EQ(decoder.feed(jpeg.data(), jpeg.size() / 2, false), StreamingJpegDecoder::Status::NeedData);
+    EXPECT_EQ(decoder.feed(jpeg.data(), jpeg.size() / 2, true), StreamingJpegDecoder::Status::Done);
+    EXPECT_EQ(decoder.rowsDone(), 240);
+
+    const std::vector<unsigned char> garbage(4096, 0x5a);
+    decoder.begin(0, 0, picture.allocator());
+    EXPECT_EQ(decoder.feed(garbage.data(), garbage.size(), false), StreamingJpegDecoder::Status::Failed);
+    EXPECT_FALSE(decoder.active());
+    // Usable again afterwards
+    decoder.begin(0, 0, picture.allocator());
+    EXPECT_EQ(decoder.feed(jpeg.data(), jpeg.size(), true), StreamingJpegDecoder::Status::Done);
+}
+
+TEST_F(StreamingJpegTest, RefusedStorageFails)
+{
+    const std::vector<unsigned char> jpeg = gradientJpeg(320, 240);
+    StreamingJpegDecoder decoder;
+    decoder.begin(0, 0, [](int, int, std::size_t&) -> std::uint8_t* { return nullptr; });
+    EXPECT_EQ(decoder.feed(jpeg.data(), jpeg.size(), true), StreamingJpegDecoder::Status::Failed);
+    EXPECT_EQ(decoder.feed(jpeg.data(), jpeg.size(), true), StreamingJpegDecoder::Status::Failed);
+}
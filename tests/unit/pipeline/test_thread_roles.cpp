@@ -0,0 +1,118 @@
+/**
+ * @file test_thread_roles.cpp
+ * @brief Unit tests for thread-role CPU placement (affinity and priority)
+ *
+ * Tests validate:
+ * - Role specs parse into CPU sets and niceness / real-time priorities
+ * - Malformed specs are rejected and leave the configuration alone
+ * - A thread taking its role gets the configured CPUs and niceness (Linux)
+ * - Unconfigured roles and repeated calls leave the thread as it is
+ */
+
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "threadroles.h"
+
+namespace {
+
+const ThreadRolePolicy& policyOf(const ThreadRoleConfig& config, ThreadRole role)
+{
+    return config[static_cast<std::size_t>(role)];
+}
+
+#ifdef __linux__
+std::vector<int> allowedCpus()
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    std::vector<int> cpus;
+    if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+        return cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &set))
+            cpus.push_back(cpu);
+    }
+    return cpus;
+}
+#endif
+
+} // namespace
+
+TEST(ThreadRolesTest, ParsesRoles) {
+    ThreadRoleConfig config;
+    ASSERT_TRUE(ThreadRoles::parse(" io=3/-5; decode=0-1 ;processing=0,2/5;render=3/fifo:10;client-encode=*/rr:2",
+                                   config));
+
+    EXPECT_EQ(policyOf(config, ThreadRole::Io).cpus, std::vector<int>({3}));
+    EXPECT_EQ(policyOf(config, ThreadRole::Io).scheduling, ThreadRolePolicy::Nice);
+    EXPECT_EQ(policyOf(config, ThreadRole::Io).priority, -5);
+
+    EXPECT_EQ(policyOf(config, ThreadRole::Decode).cpus, std::vector<int>({0, 1}));
+    EXPECT_EQ(policyOf(config, ThreadRole::Decode).scheduling, ThreadRolePolicy::Inherit);
+
+    EXPECT_EQ(policyOf(config, ThreadRole::Processing).cpus, std::vector<int>({0, 2}));
+    EXPECT_EQ(policyOf(config, ThreadRole::Processing).priority, 5);
+
+    EXPECT_EQ(policyOf(config, ThreadRole::Render).scheduling, ThreadRolePolicy::Fifo);
+    EXPECT_EQ(policyOf(config, ThreadRole::Render).priority, 10);
+
+    EXPECT_TRUE(policyOf(config, ThreadRole::ClientEncode).cpus.empty());
+    EXPECT_EQ(policyOf(config, ThreadRole::ClientEncode).scheduling, ThreadRolePolicy::RoundRobin);
+
+    ASSERT_TRUE(ThreadRoles::parse("", config));
+    for (const ThreadRolePolicy& policy : config)
+        EXPECT_FALSE(policy.configured());
+}
+
+TEST(ThreadRolesTest, RejectsMalformedSpecs) {
+    ThreadRoleConfig config;
+    ASSERT_TRUE(ThreadRoles::parse("decode=1", config));
+    std::string error;
+    for (const char* spec : {"gpu=1", "decode", "decode=a", "decode=3-1", "decode=-1", "io=1/30", "io=1/fifo:0",
+                             "io=1/idle:3", "io=1,,2"}) {
+        error.clear();
+        EXPECT_FALSE(ThreadRoles::parse(spec, config, &error)) << spec;
+        EXPECT_FALSE(error.empty()) << spec;
+    }
+    EXPECT_EQ(policyOf(config, ThreadRole::Decode).cpus, std::vector<int>({1})); // untouched
+}
+
+#ifdef __linux__
+TEST(ThreadRolesTest, ThreadTakesItsRole) {
+    const std::vector<int> allowed = allowedCpus();
+    ASSERT_FALSE(allowed.empty());
+    const int cpu = allowed.back();
+
+    ThreadRoleConfig config;
+    ASSERT_TRUE(ThreadRoles::parse("decode=" + std::to_string(cpu) + "/7", config));
+    ThreadRoles::configure(config);
+
+    std::vector<int> pinned;
+    std::vector<int> untouched;
+    int niceness = 0;
+    bool applied = false;
+    std::thread worker([&]() {
+        applied = ThreadRoles::apply(ThreadRole::Decode);
+        applied = ThreadRoles::apply(ThreadRole::Decode) && applied; // repeated per job: nothing to do
+        pinned = allowedCpus();
+        errno = 0;
+        niceness = ::getpriority(PRIO_PROCESS, static_cast<id_t>(::syscall(SYS_gettid)));
+    });
+    worker.join();
+    EXPECT_TRUE(applied);
+    EXPECT_EQ(pinned, std::vector<int>({cpu}));
+    EXPECT_EQ(niceness, 7);
+
+    // A role without a policy stays where it started
+    std::thread other([&]() {
+        EXPECT_TRUE(ThreadRoles::apply(ThreadRole::Render));
+        untouched = allowedCpus();
+    });
+    other.join();
+    EXPECT_EQ(untouched, allowed);
+
+    ThreadRoles::configure(ThreadRoleConfig());
+}
+#endif
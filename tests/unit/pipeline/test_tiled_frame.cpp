@@ -0,0 +1,181 @@
+/**
+ * @file test_tiled_frame.cpp
+ * @brief Unit tests for the tiled JPEG payload layout
+ *
+ * Tests validate:
+ * - Tiles written in index order read back with their bytes, complete flag
+ * - Tiles in the last column and row are cut to the picture size
+ * - Headers the layout can't describe, out-of-order tiles rejected
+ * - Bitmap / count mismatch, stray bits, truncated tiles and trailing bytes rejected
+ * - blockSad over padded rows
+ */
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <vector>
+#include "tiledframe.h"
+
+namespace {
+TiledFrameHeader header(int width, int height, int tileSize = 64)
+{
+    TiledFrameHeader h;
+    h.width = width;
+    h.height = height;
+    h.tileSize = tileSize;
+    return h;
+}
+
+// 200x100 in 64 px tiles: 4 x 2, tiles 0, 5 and 7 present
+std::vector<std::uint8_t> sampleFrame()
+{
+    std::vector<std::uint8_t> out;
+    TiledFrameWriter writer;
+    EXPECT_TRUE(writer.begin(header(200, 100), out));
+    const std::uint8_t a[] = {1, 2, 3};
+    const std::uint8_t b[] = {4};
+    const std::uint8_t c[] = {5, 6};
+    EXPECT_TRUE(writer.addTile(0, a, sizeof(a)));
+    EXPECT_TRUE(writer.addTile(5, b, sizeof(b)));
+    EXPECT_TRUE(writer.addTile(7, c, sizeof(c)));
+    EXPECT_EQ(writer.tilesPresent(), 3);
+    EXPECT_FALSE(writer.complete());
+    return out;
+}
+} // namespace
+
+TEST(TiledFrameTest, RoundTrip)
+{
+    const std::vector<std::uint8_t> frame = sampleFrame();
+    // Header, one bitmap byte, three size prefixes and six JPEG bytes
+    ASSERT_EQ(frame.size(), kTiledFrameHeaderSize + 1 + 3 * 4 + 6);
+    EXPECT_EQ(frame[kTiledFrameHeaderSize], 0xA1);
+
+    TiledFrameReader reader;
+    ASSERT_TRUE(reader.open(frame.data(), frame.size()));
+    EXPECT_EQ(reader.header().width, 200);
+    EXPECT_EQ(reader.header().height, 100);
+    EXPECT_EQ(reader.header().tileSize, 64);
+    EXPECT_EQ(reader.header().tilesPresent, 3);
+    EXPECT_FALSE(reader.complete());
+
+    int index = -1;
+    const std::uint8_t* jpeg = nullptr;
+    std::size_t size = 0;
+    ASSERT_TRUE(reader.next(index, jpeg, size));
+    EXPECT_EQ(index, 0);
+    ASSERT_EQ(size, 3u);
+    EXPECT_EQ(jpeg[2], 3);
+    ASSERT_TRUE(reader.next(index, jpeg, size));
+    EXPECT_EQ(index, 5);
+    ASSERT_EQ(size, 1u);
+    EXPECT_EQ(jpeg[0], 4);
+    ASSERT_TRUE(reader.next(index, jpeg, size));
+    EXPECT_EQ(index, 7);
+    ASSERT_EQ(size, 2u);
+    EXPECT_EQ(jpeg[1], 6);
+    EXPECT_FALSE(reader.next(index, jpeg, size));
+    EXPECT_FALSE(reader.failed());
+
+    // Every tile: a keyframe; the frame is appended after what's in the buffer
+    std::vector<std::uint8_t> full(2, 0xEE);
+    TiledFrameWriter writer;
+    ASSERT_TRUE(writer.begin(header(64, 64), full));
+    const std::uint8_t tile[] = {9};
+    ASSERT_TRUE(writer.addTile(0, tile, sizeof(tile)));
+    EXPECT_TRUE(writer.complete());
+    ASSERT_TRUE(reader.open(full.data() + 2, full.size() - 2));
+    EXPECT_TRUE(reader.complete());
+}
+
+TEST(TiledFrameTest, EdgeTilesAreCut)
+{
+    const TiledFrameHeader h = header(200, 100);
+    EXPECT_EQ(h.columns(), 4);
+    EXPECT_EQ(h.rows(), 2);
+    EXPECT_EQ(h.tileCount(), 8);
+    EXPECT_EQ(h.bitmapSize(), 1u);
+
+    const TileRect first = tileRect(h, 0);
+    EXPECT_EQ(first.x, 0);
+    EXPECT_EQ(first.width, 64);
+    EXPECT_EQ(first.height, 64);
+    const TileRect corner = tileRect(h, 7);
+    EXPECT_EQ(corner.x, 192);
+    EXPECT_EQ(corner.y, 64);
+    EXPECT_EQ(corner.width, 8);
+    EXPECT_EQ(corner.height, 36);
+    EXPECT_EQ(tileRect(h, 8).width, 0);
+    EXPECT_EQ(tileRect(h, -1).width, 0);
+}
+
+TEST(TiledFrameTest, WriterRejectsBadInput)
+{
+    std::vector<std::uint8_t> out;
+    TiledFrameWriter writer;
+    EXPECT_FALSE(writer.begin(header(0, 100), out));
+    EXPECT_FALSE(writer.begin(header(70000, 100), out));
+    EXPECT_FALSE(writer.begin(header(200, 100, 40), out));   // not a multiple of 16
+    EXPECT_FALSE(writer.begin(header(200, 100, 4096), out)); // past 255 units
+    EXPECT_FALSE(writer.begin(header(4096, 4096, 16), out)); // 65536 tiles
+    EXPECT_TRUE(out.empty());
+
+    const std::uint8_t tile[] = {1};
+    EXPECT_FALSE(writer.addTile(0, tile, sizeof(tile))); // begin() not called
+    ASSERT_TRUE(writer.begin(header(200, 100), out));
+    EXPECT_TRUE(writer.addTile(3, tile, sizeof(tile)));
+    EXPECT_FALSE(writer.addTile(3, tile, sizeof(tile)));
+    EXPECT_FALSE(writer.addTile(1, tile, sizeof(tile)));
+    EXPECT_FALSE(writer.addTile(8, tile, sizeof(tile)));
+    EXPECT_EQ(writer.tilesPresent(), 1);
+}
+
+TEST(TiledFrameTest, ReaderRejectsInconsistentPayloads)
+{
+    const std::vector<std::uint8_t> frame = sampleFrame();
+    TiledFrameReader reader;
+    EXPECT_FALSE(reader.open(nullptr, 0));
+    EXPECT_FALSE(reader.open(frame.data(), kTiledFrameHeaderSize)); // no bitmap
+
+    std::vector<std::uint8_t> bad = frame;
+    bad[6] = 2; // count doesn't match the bitmap
+    EXPECT_FALSE(reader.open(bad.data(), bad.size()));
+    bad = frame;
+    bad[4] = 0; // no tile size
+    EXPECT_FALSE(reader.open(bad.data(), bad.size()));
+
+    // A bit past the last tile (1 column x 1 row uses only bit 0)
+    std::vector<std::uint8_t> single;
+    TiledFrameWriter writer;
+    ASSERT_TRUE(writer.begin(header(32, 32), single));
+    single[kTiledFrameHeaderSize] = 0x02;
+    single[6] = 1;
+    EXPECT_FALSE(reader.open(single.data(), single.size()));
+
+    int index = 0;
+    const std::uint8_t* jpeg = nullptr;
+    std::size_t size = 0;
+    // Truncated in the last tile
+    ASSERT_TRUE(reader.open(frame.data(), frame.size() - 1));
+    EXPECT_TRUE(reader.next(index, jpeg, size));
+    EXPECT_TRUE(reader.next(index, jpeg, size));
+    EXPECT_FALSE(reader.next(index, jpeg, size));
+    EXPECT_TRUE(reader.failed());
+
+    // Trailing bytes after the last tile
+    bad = frame;
+    bad.push_back(0);
+    ASSERT_TRUE(reader.open(bad.data(), bad.size()));
+    while (reader.next(index, jpeg, size)) {
+    }
+    EXPECT_TRUE(reader.failed());
+}
+
+TEST(TiledFrameTest, BlockSadSkipsPadding)
+{
+    // 4 bytes per row, 3 rows; padding bytes differ and must not count
+    const std::uint8_t a[] = {10, 10, 10, 10, 99, 0, 0, 0, 0, 99, 5, 5, 5, 5};
+    const std::uint8_t b[] = {10, 12, 10, 10, 0, 0, 0, 3, 5, 0, 5, 5};
+    EXPECT_EQ(blockSad(a, 5, b, 4, 4, 3), 2u + 3u + 5u);
+    EXPECT_EQ(blockSad(a, 5, a, 5, 4, 3), 0u);
+    EXPECT_EQ(blockSad(a, 5, b, 4, 4, 0), 0u);
+}
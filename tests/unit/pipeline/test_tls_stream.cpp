@@ -0,0 +1,259 @@
+/**
+ * @file test_tls_stream.cpp
+ * @brief Unit tests for the WebSocket stream with optional TLS (WSS)
+ *
+ * Tests validate:
+ * - A plain stream carries WebSocket frames unchanged
+ * - A TLS stream carries WebSocket frames both ways and closes cleanly
+ * - A reconnect resumes the previous session (no full handshake)
+ * - A client that verifies the server rejects an untrusted certificate or a
+ *   name or address the certificate doesn't cover
+ */
+
+#include <gtest/gtest.h>
+#include <boost/asio/io_context.hpp>
+#include <boost/beast/core/buffers_to_string.hpp>
+#include <boost/beast/core/flat_buffer.hpp>
+#include <boost/beast/websocket.hpp>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+#include <openssl/x509v3.h>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include "tlsstream.h"
+
+namespace asio = boost::asio;
+namespace websocket = boost::beast::websocket;
+using tcp = asio::ip::tcp;
+
+namespace {
+
+// Self-signed P-256 certificate for localhost and 127.0.0.1, written as PEM files
+struct TestCertificate {
+    std::string certFile;
+    std::string keyFile;
+
+    TestCertificate()
+    {
+        char certName[] = "/tmp/tls_stream_certXXXXXX";
+        char keyName[] = "/tmp/tls_stream_keyXXXXXX";
+        fclose(fdopen(mkstemp(certName), "w"));
+        fclose(fdopen(mkstemp(keyName), "w"));
+        certFile = certName;
+        keyFile = keyName;
+
+        EVP_PKEY* key = EVP_EC_gen("P-256");
+        X509* cert = X509_new();
+        X509_set_version(cert, 2);
+        ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+        X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+        X509_gmtime_adj(X509_getm_notAfter(cert), 3600);
+        X509_set_pubkey(cert, key);
+        X509_NAME* name = X509_get_subject_name(cert);
+        X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char*>("localhost"), -1, -1, 0);
+        X509_set_issuer_name(cert, name);
+        X509V3_CTX ctx;
+        X509V3_set_ctx_nodb(&ctx);
+        X509V3_set_ctx(&ctx, cert, cert, nullptr, nullptr, 0);
+        X509_EXTENSION* altNames = X509V3_EXT_conf_nid(nullptr, &ctx, NID_subject_alt_name, "DNS:localhost,IP:127.0.0.1");
+        X509_add_ext(cert, altNames, -1);
+        X509_EXTENSION_free(altNames);
+        X509_sign(cert, key, EVP_sha256());
+
+        FILE* out = fopen(certFile.c_str(), "w");
+        PEM_write_X509(out, cert);
+        fclose(out);
+        out = fopen(keyFile.c_str(), "w");
+        PEM_write_PrivateKey(out, key, nullptr, nullptr, 0, nullptr, nullptr);
+        fclose(out);
+        X509_free(cert);
+        EVP_PKEY_free(key);
+    }
+
+    ~TestCertificate()
+    {
+        std::remove(certFile.c_str());
+        std::remove(keyFile.c_str());
+    }
+};
+
+struct Result {
+    std::string echoed;
+    bool secure = false;
+    bool resumed = false;
+    bool serverResumed = false;
+    boost::system::error_code error;
+};
+
+// Server side of one connection: echo one message, then wait for the close
+void serveOnce(tcp::acceptor& acceptor, const std::shared_ptr<TlsContext>& tls, bool& resumed)
+{
+    asio::io_context io;
+    tcp::socket socket(io);
+    boost::system::error_code ec;
+    acceptor.accept(socket, ec);
+    if (ec)
+        return;
+    websocket::stream<TlsStream> ws(std::move(socket), tls);
+    boost::beast::flat_buffer buffer;
+    ws.next_layer().async_handshake([&](boost::system::error_code ec) {
+        if (ec)
+            return;
+        resumed = ws.next_layer().resumed();
+        ws.async_accept([&](boost::system::error_code ec) {
+            if (ec)
+                return;
+            ws.async_read(buffer, [&](boost::system::error_code ec, std::size_t) {
+                if (ec)
+                    return;
+                ws.text(ws.got_text());
+                ws.async_write(buffer.data(), [&](boost::system::error_code ec, std::size_t) {
+                    if (ec)
+                        return;
+                    buffer.consume(buffer.size());
+                    ws.async_read(buffer, [](boost::system::error_code, std::size_t) {}); // until the close
+                });
+            });
+        });
+    });
+    io.run();
+}
+
+// One client connection: send `message`, read the echo, close
+Result echoOnce(tcp::acceptor& acceptor, const std::shared_ptr<TlsContext>& serverTls,
+                const std::shared_ptr<TlsContext>& clientTls, const std::string& message,
+                const std::string& serverName = "localhost")
+{
+    Result result;
+    std::thread server([&]() { serveOnce(acceptor, serverTls, result.serverResumed); });
+
+    asio::io_context io;
+    tcp::socket socket(io);
+    socket.connect(acceptor.local_endpoint());
+    websocket::stream<TlsStream> ws(std::move(socket), clientTls);
+    ws.next_layer().setServerName(serverName);
+    result.secure = ws.next_layer().secure();
+    boost::beast::flat_buffer buffer;
+    ws.next_layer().async_handshake([&](boost::system::error_code ec) {
+        if (ec) {
+            result.error = ec;
+            ws.next_layer().socket().close();
+            return;
+        }
+        result.resumed = ws.next_layer().resumed();
+        ws.async_handshake("localhost", "/", [&](boost::system::error_code ec) {
+            if (ec) {
+                result.error = ec;
+                return;
+            }
+            ws.text(true);
+            ws.async_write(asio::buffer(message), [&](boost::system::error_code ec, std::size_t) {
+                if (ec) {
+                    result.error = ec;
+                    return;
+                }
+                ws.async_read(buffer, [&](boost::system::error_code ec, std::size_t) {
+                    if (ec) {
+                        result.error = ec;
+                        return;
+                    }
+                    result.echoed = boost::beast::buffers_to_string(buffer.data());
+                    ws.async_close(websocket::close_code::normal,
+                                   [&](boost::system::error_code ec) { result.error = ec; });
+                });
+            });
+        });
+    });
+    io.run();
+    server.join();
+    return result;
+}
+
+tcp::acceptor loopbackAcceptor(asio::io_context& io)
+{
+    return tcp::acceptor(io, tcp::endpoint(asio::ip::make_address("127.0.0.1"), 0));
+}
+
+} // namespace
+
+TEST(TlsStreamTest, PlainStreamCarriesFrames) {
+    asio::io_context io;
+    tcp::acceptor acceptor = loopbackAcceptor(io);
+    const Result result = echoOnce(acceptor, nullptr, nullptr, "plain frame");
+    EXPECT_FALSE(result.error) << result.error.message();
+    EXPECT_FALSE(result.secure);
+    EXPECT_EQ(result.echoed, "plain frame");
+}
+
+TEST(TlsStreamTest, TlsStreamCarriesFrames) {
+    TestCertificate certificate;
+    std::string error;
+    const std::shared_ptr<TlsContext> serverTls = TlsContext::server(certificate.certFile, certificate.keyFile, &error);
+    ASSERT_TRUE(serverTls) << error;
+    const std::shared_ptr<TlsContext> clientTls = TlsContext::client(certificate.certFile, true, &error);
+    ASSERT_TRUE(clientTls) << error;
+
+    asio::io_context io;
+    tcp::acceptor acceptor = loopbackAcceptor(io);
+    const std::string large(200 * 1024, 'x'); // several TLS records, partial writes
+    Result result = echoOnce(acceptor, serverTls, clientTls, large);
+    EXPECT_FALSE(result.error) << result.error.message();
+    EXPECT_TRUE(result.secure);
+    EXPECT_EQ(result.echoed, large);
+    EXPECT_FALSE(result.resumed);
+
+    result = echoOnce(acceptor, serverTls, clientTls, "small");
+    EXPECT_FALSE(result.error) << result.error.message();
+    EXPECT_EQ(result.echoed, "small");
+}
+
+TEST(TlsStreamTest, ReconnectResumesTheSession) {
+    TestCertificate certificate;
+    const std::shared_ptr<TlsContext> serverTls = TlsContext::server(certificate.certFile, certificate.keyFile);
+    const std::shared_ptr<TlsContext> clientTls = TlsContext::client(certificate.certFile, true);
+    ASSERT_TRUE(serverTls && clientTls);
+
+    asio::io_context io;
+    tcp::acceptor acceptor = loopbackAcceptor(io);
+    Result result = echoOnce(acceptor, serverTls, clientTls, "first");
+    ASSERT_FALSE(result.error) << result.error.message();
+    EXPECT_FALSE(result.resumed);
+
+    result = echoOnce(acceptor, serverTls, clientTls, "second");
+    ASSERT_FALSE(result.error) << result.error.message();
+    EXPECT_TRUE(result.resumed);
+    EXPECT_TRUE(result.serverResumed);
+    EXPECT_EQ(result.echoed, "second");
+
+    clientTls->forgetSession();
+    result = echoOnce(acceptor, serverTls, clientTls, "third");
+    EXPECT_FALSE(result.resumed);
+}
+
+TEST(TlsStreamTest, VerifyingClientRejectsUntrustedCertificate) {
+    TestCertificate certificate;
+    TestCertificate other; // a CA that didn't sign the server's certificate
+    const std::shared_ptr<TlsContext> serverTls = TlsContext::server(certificate.certFile, certificate.keyFile);
+    const std::shared_ptr<TlsContext> clientTls = TlsContext::client(other.certFile, true);
+    ASSERT_TRUE(serverTls && clientTls);
+
+    asio::io_context io;
+    tcp::acceptor acceptor = loopbackAcceptor(io);
+    Result result = echoOnce(acceptor, serverTls, clientTls, "never sent");
+    EXPECT_TRUE(result.error);
+    EXPECT_TRUE(result.echoed.empty());
+
+    // The name or address connected to must be in the certificate
+    const std::shared_ptr<TlsContext> trusting = TlsContext::client(certificate.certFile, true);
+    result = echoOnce(acceptor, serverTls, trusting, "by address", "127.0.0.1");
+    EXPECT_FALSE(result.error) << result.error.message();
+    EXPECT_EQ(result.echoed, "by address");
+    result = echoOnce(acceptor, serverTls, trusting, "wrong name", "camera-server.example");
+    EXPECT_TRUE(result.error);
+
+    std::string error;
+    EXPECT_FALSE(TlsContext::server("/nonexistent.pem", certificate.keyFile, &error));
+    EXPECT_NE(error.find("/nonexistent.pem"), std::string::npos);
+}
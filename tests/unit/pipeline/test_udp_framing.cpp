@@ -0,0 +1,250 @@
+/**
+ * @file test_udp_framing.cpp
+ * @brief Unit tests for the UDP frame transport: erasure code, fragmentation and reassembly
+ *
+ * Tests validate:
+ * - Any k of k + m Reed-Solomon shards give back the data
+ * - Frames are rebuilt from datagrams in any order, parity filling lost shards
+ * - 5 % random loss: nearly every frame still arrives, none out of order
+ * - Older incomplete frames are dropped once a newer one is delivered; age limit
+ * - Malformed and mismatched datagrams are rejected
+ */
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "erasurecode.h"
+#include "udpframing.h"
+
+namespace {
+using Datagram = std::vector<std::uint8_t>;
+
+std::vector<std::uint8_t> pattern(std::size_t size, std::uint32_t seed)
+{
+    std::vector<std::uint8_t> bytes(size);
+    std::mt19937 rng(seed);
+    for (std::uint8_t& byte : bytes)
+        byte = static_cast<std::uint8_t>(rng());
+    return bytes;
+}
+
+std::vector<Datagram> datagramsOf(UdpFrameSender& sender, const std::vector<std::uint8_t>& message)
+{
+    std::vector<Datagram> datagrams;
+    // Split in two parts as the client does (prefix, then the rest)
+    sender.send({{message.data(), 1}, {message.data() + 1, message.size() - 1}},
+                [&datagrams](const std::uint8_t* data, std::size_t size) {
+                    datagrams.emplace_back(data, data + size);
+                });
+    return datagrams;
+}
+
+struct Delivered {
+    std::vector<std::vector<std::uint8_t>> messages;
+    void operator()(const std::uint8_t* data, std::size_t size) { messages.emplace_back(data, data + size); }
+};
+} // namespace
+
+TEST(UdpFramingTest, ErasureCodeRecoversAnyKShards)
+{
+    const int k = 10;
+    const int m = 4;
+    const std::size_t size = 37;
+    std::vector<std::vector<std::uint8_t>> data;
+    for (int i = 0; i < k; ++i)
+        data.push_back(pattern(size, static_cast<std::uint32_t>(i + 1)));
+    std::vector<std::vector<std::uint8_t>> parity(m, std::vector<std::uint8_t>(size));
+    std::vector<const std::uint8_t*> dataIn;
+    for (const auto& shard : data)
+        dataIn.push_back(shard.data());
+    std::vector<std::uint8_t*> parityOut;
+    for (auto& shard : parity)
+        parityOut.push_back(shard.data());
+    ASSERT_TRUE(erasureEncode(dataIn.data(), k, parityOut.data(), m, size));
+
+    // Every way of losing up to m shards among the first data and parity ones
+    std::mt19937 rng(7);
+    for (int trial = 0; trial < 200; ++trial) {
+        std::vector<int> order(k + m);
+        for (int i = 0; i < k + m; ++i)
+            order[static_cast<std::size_t>(i)] = i;
+        std::shuffle(order.begin(), order.end(), rng);
+        const int losses = trial % (m + 1);
+        std::vector<std::uint8_t> have(k + m, 1);
+        for (int l = 0; l < losses; ++l)
+            have[static_cast<std::size_t>(order[static_cast<std::size_t>(l)])] = 0;
+
+        std::vector<std::vector<std::uint8_t>> received = data;
+        std::vector<std::uint8_t*> dataPtrs;
+        for (int i = 0; i < k; ++i) {
+            if (!have[static_cast<std::size_t>(i)])
+                std::fill(received[static_cast<std::size_t>(i)].begin(), received[static_cast<std::size_t>(i)].end(), 0xAA);
+            dataPtrs.push_back(received[static_cast<std::size_t>(i)].data());
+        }
+        std::vector<const std::uint8_t*> parityPtrs(parityOut.begin(), parityOut.end());
+        ASSERT_TRUE(erasureRecover(dataPtrs.data(), have.data(), k, parityPtrs.data(), have.data() + k, m, size));
+        EXPECT_EQ(received, data) << "trial " << trial;
+    }
+
+    // One shard more than the parity covers can't be rebuilt
+    std::vector<std::uint8_t> have(k + m, 1);
+    for (int i = 0; i <= m; ++i)
+        have[static_cast<std::size_t>(i)] = 0;
+    std::vector<std::uint8_t*> dataPtrs;
+    for (auto& shard : data)
+        dataPtrs.push_back(shard.data());
+    std::vector<const std::uint8_t*> parityPtrs(parityOut.begin(), parityOut.end());
+    EXPECT_FALSE(erasureRecover(dataPtrs.data(), have.data(), k, parityPtrs.data(), have.data() + k, m, size));
+}
+
+TEST(UdpFramingTest, ReassemblesAnyOrderWithParity)
+{
+    UdpFrameSender sender(0.2);
+    sender.setKey(0x1234);
+    // 100 shards: two blocks (64 + 36) with 13 and 8 parity shards
+    const std::vector<std::uint8_t> message = pattern(kUdpShardSize * 99 + 100, 1);
+    std::vector<Datagram> datagrams = datagramsOf(sender, message);
+    ASSERT_EQ(datagrams.size(), 100u + 13u + 8u);
+    UdpDatagramHeader header;
+    ASSERT_TRUE(parseUdpDatagramHeader(datagrams.front().data(), datagrams.front().size(), header));
+    EXPECT_EQ(header.key, 0x1234u);
+    EXPECT_EQ(header.frame, 0u);
+
+    // Shuffled, and as many shards of each block lost as it has parity
+    std::mt19937 rng(3);
+    std::shuffle(datagrams.begin(), datagrams.end(), rng);
+    int lost[2] = {0, 0};
+    std::vector<Datagram> kept;
+    for (const Datagram& datagram : datagrams) {
+        ASSERT_TRUE(parseUdpDatagramHeader(datagram.data(), datagram.size(), header));
+        if (lost[header.block] < header.parityShards) {
+            ++lost[header.block];
+            continue;
+        }
+        kept.push_back(datagram);
+    }
+    UdpFrameAssembler assembler;
+    Delivered delivered;
+    for (const Datagram& datagram : kept)
+        EXPECT_TRUE(assembler.push(datagram.data(), datagram.size(), 0, delivered));
+    ASSERT_EQ(delivered.messages.size(), 1u);
+    EXPECT_EQ(delivered.messages.front(), message);
+    EXPECT_EQ(assembler.stats().recovered, 1u);
+    EXPECT_EQ(assembler.pendingFrames(), 0u);
+
+    // A small message is one shard of its own size (and its parity copy)
+    const std::vector<std::uint8_t> small = pattern(300, 2);
+    const std::vector<Datagram> two = datagramsOf(sender, small);
+    ASSERT_EQ(two.size(), 2u);
+    EXPECT_TRUE(assembler.push(two[1].data(), two[1].size(), 0, delivered)); // parity alone rebuilds it
+    ASSERT_EQ(delivered.messages.size(), 2u);
+    EXPECT_EQ(delivered.messages.back(), small);
+    EXPECT_TRUE(assembler.push(two[0].data(), two[0].size(), 0, delivered)); // late data shard: ignored
+    EXPECT_EQ(delivered.messages.size(), 2u);
+}
+
+TEST(UdpFramingTest, FivePercentLossKeepsFramesInOrder)
+{
+    UdpFrameSender sender;
+    UdpFrameAssembler assembler;
+    std::mt19937 rng(11);
+    std::bernoulli_distribution loss(0.05);
+    std::vector<std::uint32_t> sequences;
+    const int frames = 300;
+    for (int f = 0; f < frames; ++f) {
+        std::vector<std::uint8_t> message = pattern(20000 + static_cast<std::size_t>(f) * 97, static_cast<std::uint32_t>(f));
+        message[0] = static_cast<std::uint8_t>(f); // tells frames apart
+        message[1] = static_cast<std::uint8_t>(f >> 8);
+        std::vector<Datagram> datagrams = datagramsOf(sender, message);
+        std::shuffle(datagrams.begin(), datagrams.end(), rng); // reordered within the frame
+        for (const Datagram& datagram : datagrams) {
+            if (loss(rng))
+                continue;
+            assembler.push(datagram.data(), datagram.size(), f * 33000, [&](const std::uint8_t* data, std::size_t size) {
+                ASSERT_EQ(size, message.size());
+                EXPECT_TRUE(std::equal(message.begin(), message.end(), data));
+                sequences.push_back(static_cast<std::uint32_t>(data[0] | (data[1] << 8)));
+            });
+        }
+    }
+    // 18 shards + 4 parity per frame: losing 5 or more of 22 at 5 % is rare
+    EXPECT_GE(static_cast<int>(sequences.size()), frames * 99 / 100);
+    EXPECT_TRUE(std::is_sorted(sequences.begin(), sequences.end()));
+    EXPECT_GT(assembler.stats().recovered, 0u);
+    EXPECT_EQ(assembler.stats().malformed, 0u);
+}
+
+TEST(UdpFramingTest, StaleFramesDroppedNotWaitedFor)
+{
+    UdpFrameSender sender(0.0); // no parity: a lost shard loses the frame
+    const std::vector<Datagram> first = datagramsOf(sender, pattern(kUdpShardSize * 3, 1));
+    const std::vector<Datagram> second = datagramsOf(sender, pattern(kUdpShardSize * 2, 2));
+    const std::vector<Datagram> third = datagramsOf(sender, pattern(kUdpShardSize * 2, 3));
+    ASSERT_EQ(first.size(), 3u);
+
+    UdpFrameAssembler assembler(100000);
+    Delivered delivered;
+    // Frame 0 misses a shard; frame 1 completes: frame 0 is dropped, not waited for
+    assembler.push(first[0].data(), first[0].size(), 0, delivered);
+    assembler.push(first[1].data(), first[1].size(), 0, delivered);
+    for (const Datagram& datagram : second)
+        assembler.push(datagram.data(), datagram.size(), 1000, delivered);
+    ASSERT_EQ(delivered.messages.size(), 1u);
+    EXPECT_EQ(assembler.stats().late, 1u);
+    EXPECT_EQ(assembler.pendingFrames(), 0u);
+    // Its last shard arriving now changes nothing
+    assembler.push(first[2].data(), first[2].size(), 2000, delivered);
+    EXPECT_EQ(delivered.messages.size(), 1u);
+    EXPECT_EQ(assembler.pendingFrames(), 0u);
+
+    // Frame 2 half there, then the age limit passes: given up
+    assembler.push(third[0].data(), third[0].size(), 10000, delivered);
+    EXPECT_EQ(assembler.pendingFrames(), 1u);
+    assembler.expire(10000 + 100001);
+    EXPECT_EQ(assembler.pendingFrames(), 0u);
+    EXPECT_EQ(assembler.stats().expired, 1u);
+    assembler.push(third[1].data(), third[1].size(), 120000, delivered);
+    EXPECT_EQ(delivered.messages.size(), 1u);
+    EXPECT_EQ(assembler.stats().frames, 1u);
+}
+
+TEST(UdpFramingTest, RejectsMalformedDatagrams)
+{
+    UdpFrameSender sender;
+    const std::vector<Datagram> datagrams = datagramsOf(sender, pattern(kUdpShardSize + 10, 1));
+    UdpDatagramHeader header;
+    Datagram datagram = datagrams[0];
+    ASSERT_TRUE(parseUdpDatagramHeader(datagram.data(), datagram.size(), header));
+
+    Datagram badMagic = datagram;
+    badMagic[0] ^= 0xFF;
+    EXPECT_FALSE(parseUdpDatagramHeader(badMagic.data(), badMagic.size(), header));
+    Datagram truncated(datagram.begin(), datagram.end() - 1); // a data shard shorter than the layout says
+    EXPECT_FALSE(parseUdpDatagramHeader(truncated.data(), truncated.size(), header));
+    Datagram badIndex = datagram;
+    badIndex[20] = 200; // past k + m
+    EXPECT_FALSE(parseUdpDatagramHeader(badIndex.data(), badIndex.size(), header));
+    Datagram badBlock = datagram;
+    badBlock[16] = 1; // the message has one block
+    EXPECT_FALSE(parseUdpDatagramHeader(badBlock.data(), badBlock.size(), header));
+    EXPECT_FALSE(parseUdpDatagramHeader(datagram.data(), kUdpDatagramHeaderSize, header));
+
+    // Over the assembler's size limit, or disagreeing with the frame's first datagram
+    UdpFrameAssembler small(150000, 1000);
+    Delivered delivered;
+    EXPECT_FALSE(small.push(datagram.data(), datagram.size(), 0, delivered));
+    UdpFrameAssembler assembler;
+    EXPECT_TRUE(assembler.push(datagram.data(), datagram.size(), 0, delivered));
+    Datagram other = datagrams[1];
+    ASSERT_TRUE(parseUdpDatagramHeader(other.data(), other.size(), header));
+    UdpDatagramHeader changed = header;
+    changed.messageSize = static_cast<std::uint32_t>(kUdpShardSize + 9);
+    writeUdpDatagramHeader(changed, other.data());
+    other.pop_back();
+    EXPECT_FALSE(assembler.push(other.data(), other.size(), 0, delivered));
+    EXPECT_EQ(small.stats().malformed, 1u);
+    EXPECT_EQ(assembler.stats().malformed, 1u);
+    EXPECT_TRUE(delivered.messages.empty());
+}
@@ -0,0 +1,29 @@
+/**
+ * @file test_v4l2_decoder.cpp
+ * @brief Unit tests for V4L2 M2M decoder discovery and fallback conditions
+ *
+ * Hardware is not required: tests validate that unusable device nodes are rejected
+ * (so callers fall back to software), and decode a frame only when a device exists.
+ */
+
+#include <gtest/gtest.h>
+#include <vector>
+#include "v4l2m2mdecoder.h"
+
+TEST(V4l2M2mDecoderTest, MissingDeviceIsRejected) {
+    EXPECT_EQ(V4l2M2mDecoder::open("/dev/does-not-exist"), nullptr);
+}
+
+TEST(V4l2M2mDecoderTest, NonVideoDeviceIsRejected) {
+    EXPECT_EQ(V4l2M2mDecoder::open("/dev/null"), nullptr);
+}
+
+TEST(V4l2M2mDecoderTest, InvalidFrameIsRejected) {
+    std::unique_ptr<V4l2M2mDecoder> decoder = V4l2M2mDecoder::open();
+    if (!decoder)
+        GTEST_SKIP() << "no V4L2 M2M JPEG decoder on this machine";
+
+    const std::vector<std::uint8_t> garbage(256, 0x42);
+    YuvFrameView frame;
+    EXPECT_FALSE(decoder->decode(garbage.data(), garbage.size(), frame));
+}
@@ -0,0 +1,91 @@
+/**
+ * @file test_video_packet.cpp
+ * @brief Unit tests for the H.264/H.265 video packet header
+ *
+ * Tests validate:
+ * - prepareVideoPacket() and parseVideoPacketHeader() round-trip codec and keyframe flag
+ * - MJPEG, unknown codecs and packets without a bitstream are rejected
+ * - Codec values match imagesocket.control.VideoCodec
+ * - Tiled JPEG travels as video packets without being an inter-frame codec
+ */
+
+#include <gtest/gtest.h>
+#include <vector>
+#include "videopacket.h"
+
+namespace {
+
+VideoPacketHeader header(VideoCodec codec, bool keyframe)
+{
+    VideoPacketHeader h;
+    h.codec = codec;
+    h.keyframe = keyframe;
+    return h;
+}
+
+} // namespace
+
+TEST(VideoPacketTest, RoundTripsHeader) {
+    std::vector<std::uint8_t> packet;
+    prepareVideoPacket(header(VideoCodec::H265, true), 100, packet);
+    EXPECT_EQ(packet.size(), kVideoPacketHeaderSize + 100u);
+
+    VideoPacketHeader parsed;
+    ASSERT_TRUE(parseVideoPacketHeader(packet.data(), packet.size(), parsed));
+    EXPECT_EQ(parsed.codec, VideoCodec::H265);
+    EXPECT_TRUE(parsed.keyframe);
+
+    prepareVideoPacket(header(VideoCodec::H264, false), 10, packet);
+    ASSERT_TRUE(parseVideoPacketHeader(packet.data(), packet.size(), parsed));
+    EXPECT_EQ(parsed.codec, VideoCodec::H264);
+    EXPECT_FALSE(parsed.keyframe);
+}
+
+TEST(VideoPacketTest, PrepareReusesCapacity) {
+    std::vector<std::uint8_t> packet;
+    prepareVideoPacket(header(VideoCodec::H264, true), 4096, packet);
+    const std::uint8_t* storage = packet.data();
+    prepareVideoPacket(header(VideoCodec::H264, false), 512, packet);
+    EXPECT_EQ(packet.data(), storage);
+}
+
+TEST(VideoPacketTest, RejectsNonVideoCodecs) {
+    std::vector<std::uint8_t> packet;
+    prepareVideoPacket(header(VideoCodec::H264, true), 8, packet);
+    VideoPacketHeader parsed;
+
+    packet[0] = static_cast<std::uint8_t>(VideoCodec::Mjpeg);
+    EXPECT_FALSE(parseVideoPacketHeader(packet.data(), packet.size(), parsed));
+    packet[0] = 7;
+    EXPECT_FALSE(parseVideoPacketHeader(packet.data(), packet.size(), parsed));
+    EXPECT_FALSE(isInterFrameCodec(VideoCodec::Mjpeg));
+}
+
+TEST(VideoPacketTest, RejectsEmptyBitstream) {
+    std::vector<std::uint8_t> packet;
+    prepareVideoPacket(header(VideoCodec::H264, true), 0, packet);
+    VideoPacketHeader parsed;
+    EXPECT_FALSE(parseVideoPacketHeader(packet.data(), packet.size(), parsed));
+    EXPECT_FALSE(parseVideoPacketHeader(nullptr, 10, parsed));
+}
+
+TEST(VideoPacketTest, CodecValuesMatchProtocol) {
+    EXPECT_EQ(static_cast<int>(VideoCodec::Mjpeg), 0);
+    EXPECT_EQ(static_cast<int>(VideoCodec::H264), 1);
+    EXPECT_EQ(static_cast<int>(VideoCodec::H265), 2);
+    EXPECT_EQ(static_cast<int>(VideoCodec::TiledJpeg), 3);
+}
+
+TEST(VideoPacketTest, TiledJpegUsesVideoPackets) {
+    std::vector<std::uint8_t> packet;
+    prepareVideoPacket(header(VideoCodec::TiledJpeg, true), 16, packet);
+    VideoPacketHeader parsed;
+    ASSERT_TRUE(parseVideoPacketHeader(packet.data(), packet.size(), parsed));
+    EXPECT_EQ(parsed.codec, VideoCodec::TiledJpeg);
+    EXPECT_TRUE(parsed.keyframe);
+
+    EXPECT_TRUE(usesVideoPackets(VideoCodec::TiledJpeg));
+    EXPECT_TRUE(usesVideoPackets(VideoCodec::H264));
+    EXPECT_FALSE(usesVideoPackets(VideoCodec::Mjpeg));
+    EXPECT_FALSE(isInterFrameCodec(VideoCodec::TiledJpeg)); // no FFmpeg encoder or decoder
+}
@@ -0,0 +1,203 @@
+/**
+ * @file test_yuv_convert.cpp
+ * @brief Unit tests for 4:2:0 YUV to RGB32 conversion and BGR to 4:2:0
+ *
+ * Tests validate:
+ * - Neutral chroma maps to gray (R = G = B = Y)
+ * - Saturated primaries with full-range BT.601 (JFIF) coefficients
+ * - Limited (video) range expands Y 16-235 to 0-255
+ * - I420 and NV12 layouts give identical results
+ * - Source strides wider than the picture are honored
+ * - BGR to I420/NV12 is the inverse: gray, primaries and odd sizes round trip
+ */
+
+#include <gtest/gtest.h>
+#include <vector>
+#include "yuvconvert.h"
+
+namespace {
+
+struct Planes {
+    std::vector<std::uint8_t> y, u, v, uv;
+};
+
+// Solid-color picture in both layouts, with padded strides
+Planes solid(int height, int stride, std::uint8_t y, std::uint8_t u, std::uint8_t v)
+{
+    Planes p;
+    p.y.assign(static_cast<std::size_t>(stride * height), y);
+    p.u.assign(static_cast<std::size_t>((stride / 2) * (height / 2)), u);
+    p.v.assign(static_cast<std::size_t>((stride / 2) * (height / 2)), v);
+    p.uv.resize(static_cast<std::size_t>(stride * (height / 2)));
+    for (std::size_t i = 0; i + 1 < p.uv.size(); i += 2) {
+        p.uv[i] = u;
+        p.uv[i + 1] = v;
+    }
+    return p;
+}
+
+std::vector<std::uint32_t> convert(const Planes& p, YuvLayout layout, int width, int height, int stride,
+                                   bool limitedRange = false)
+{
+    YuvFrameView frame;
+    frame.limitedRange = limitedRange;
+    frame.layout = layout;
+    frame.width = width;
+    frame.height = height;
+    frame.y = p.y.data();
+    frame.yStride = stride;
+    if (layout == YuvLayout::I420) {
+        frame.u = p.u.data();
+        frame.v = p.v.data();
+        frame.uvStride = stride / 2;
+    } else {
+        frame.u = p.uv.data();
+        frame.uvStride = stride;
+    }
+    std::vector<std::uint32_t> out(static_cast<std::size_t>(width * height), 0);
+    yuvToRgb32(frame, reinterpret_cast<std::uint8_t*>(out.data()), width * 4);
+    return out;
+}
+
+int red(std::uint32_t px) { return (px >> 16) & 0xFF; }
+int green(std::uint32_t px) { return (px >> 8) & 0xFF; }
+int blue(std::uint32_t px) { return px & 0xFF; }
+
+} // namespace
+
+TEST(YuvConvertTest, NeutralChromaIsGray) {
+    const Planes p = solid(4, 4, 100, 128, 128);
+    for (std::uint32_t px : convert(p, YuvLayout::I420, 4, 4, 4)) {
+        EXPECT_EQ(px >> 24, 0xFFu);
+        EXPECT_EQ(red(px), 100);
+        EXPECT_EQ(green(px), 100);
+        EXPECT_EQ(blue(px), 100);
+    }
+}
+
+TEST(YuvConvertTest, SaturatedRed) {
+    // Full-range BT.601 red: Y=76, Cb=85, Cr=255
+    const Planes p = solid(2, 2, 76, 85, 255);
+    const std::uint32_t px = convert(p, YuvLayout::I420, 2, 2, 2)[0];
+    EXPECT_NEAR(red(px), 255, 2);
+    EXPECT_NEAR(green(px), 0, 2);
+    EXPECT_NEAR(blue(px), 0, 2);
+}
+
+TEST(YuvConvertTest, SaturatedBlueClamps) {
+    const Planes p = solid(2, 2, 29, 255, 107);
+    const std::uint32_t px = convert(p, YuvLayout::I420, 2, 2, 2)[0];
+    EXPECT_NEAR(red(px), 0, 2);
+    EXPECT_NEAR(green(px), 0, 2);
+    EXPECT_NEAR(blue(px), 255, 2);
+}
+
+TEST(YuvConvertTest, LimitedRangeExpandsLuma) {
+    const Planes black = solid(2, 2, 16, 128, 128);
+    const Planes white = solid(2, 2, 235, 128, 128);
+    EXPECT_EQ(red(convert(black, YuvLayout::I420, 2, 2, 2, true)[0]), 0);
+    EXPECT_EQ(red(convert(white, YuvLayout::I420, 2, 2, 2, true)[0]), 255);
+
+    // Video-range red: Y=81, Cb=90, Cr=240
+    const Planes p = solid(2, 2, 81, 90, 240);
+    const std::uint32_t px = convert(p, YuvLayout::I420, 2, 2, 2, true)[0];
+    EXPECT_NEAR(red(px), 255, 2);
+    EXPECT_NEAR(green(px), 0, 2);
+    EXPECT_NEAR(blue(px), 0, 2);
+}
+
+TEST(YuvConvertTest, Nv12MatchesI420) {
+    const Planes p = solid(6, 8, 150, 60, 200);
+    EXPECT_EQ(convert(p, YuvLayout::I420, 8, 6, 8), convert(p, YuvLayout::NV12, 8, 6, 8));
+}
+
+TEST(YuvConvertTest, PaddedStrideIsHonored) {
+    // Picture is 6x4 inside planes 16 bytes wide (hardware alignment)
+    Planes p = solid(4, 16, 50, 128, 128);
+    for (int row = 0; row < 4; ++row)
+        for (int col = 6; col < 16; ++col)
+            p.y[static_cast<std::size_t>(row * 16 + col)] = 255; // padding must not leak
+    for (std::uint32_t px : convert(p, YuvLayout::I420, 6, 4, 16))
+        EXPECT_EQ(red(px), 50);
+}
+
+TEST(YuvConvertTest, BgrToYuv420GrayAndPrimaries) {
+    // 2x2 blocks of gray, red and blue side by side (BGR order)
+    const std::uint8_t colors[3][3] = {{100, 100, 100}, {0, 0, 255}, {255, 0, 0}};
+    std::vector<std::uint8_t> bgr(6 * 2 * 3);
+    for (int row = 0; row < 2; ++row)
+        for (int col = 0; col < 6; ++col)
+            for (int c = 0; c < 3; ++c)
+                bgr[static_cast<std::size_t>((row * 6 + col) * 3 + c)] = colors[col / 2][c];
+
+    Planes p = solid(2, 6, 0, 0, 0);
+    YuvPlanes dst;
+    dst.y = p.y.data();
+    dst.u = p.u.data();
+    dst.v = p.v.data();
+    dst.yStride = 6;
+    dst.uvStride = 3;
+    bgrToYuv420(bgr.data(), 6, 2, 6 * 3, dst);
+
+    EXPECT_EQ(p.y[0], 100);
+    EXPECT_EQ(p.u[0], 128);
+    EXPECT_EQ(p.v[0], 128);
+    // The values SaturatedRed and SaturatedBlueClamps decode
+    EXPECT_NEAR(p.y[2], 76, 1);
+    EXPECT_NEAR(p.u[1], 85, 1);
+    EXPECT_NEAR(p.v[1], 255, 1);
+    EXPECT_NEAR(p.y[4], 29, 1);
+    EXPECT_NEAR(p.u[2], 255, 1);
+    EXPECT_NEAR(p.v[2], 107, 1);
+
+    // And back
+    const std::vector<std::uint32_t> rgb = convert(p, YuvLayout::I420, 6, 2, 6);
+    EXPECT_NEAR(red(rgb[3]), 255, 2);
+    EXPECT_NEAR(blue(rgb[3]), 0, 2);
+    EXPECT_NEAR(blue(rgb[5]), 255, 2);
+    EXPECT_NEAR(green(rgb[5]), 0, 2);
+}
+
+TEST(YuvConvertTest, BgrToYuv420OddSizeAndNv12) {
+    // 5x3: the last column and row have no partner and are repeated
+    const int width = 5, height = 3, stride = 16;
+    std::vector<std::uint8_t> bgr(static_cast<std::size_t>(stride * height), 0);
+    for (int row = 0; row < height; ++row)
+        for (int col = 0; col < width; ++col) {
+            std::uint8_t* px = &bgr[static_cast<std::size_t>(row * stride + col * 3)];
+            px[0] = static_cast<std::uint8_t>(40 * col);
+            px[1] = static_cast<std::uint8_t>(60 * row);
+            px[2] = 200;
+        }
+
+    Planes p = solid(4, 6, 0, 0, 0);
+    YuvPlanes i420;
+    i420.y = p.y.data();
+    i420.u = p.u.data();
+    i420.v = p.v.data();
+    i420.yStride = 6;
+    i420.uvStride = 3;
+    bgrToYuv420(bgr.data(), width, height, stride, i420);
+
+    YuvPlanes nv12;
+    nv12.layout = YuvLayout::NV12;
+    nv12.y = p.y.data();
+    nv12.u = p.uv.data();
+    nv12.yStride = 6;
+    nv12.uvStride = 6;
+    bgrToYuv420(bgr.data(), width, height, stride, nv12);
+
+    // Corner chroma comes from the single pixel (160, 120, 200)
+    EXPECT_EQ(p.u[5], p.uv[10]);
+    EXPECT_EQ(p.v[5], p.uv[11]);
+    for (int row = 0; row < 2; ++row)
+        for (int col = 0; col < 3; ++col) {
+            EXPECT_EQ(p.u[static_cast<std::size_t>(row * 3 + col)], p.uv[static_cast<std::size_t>(row * 6 + col * 2)]);
+            EXPECT_EQ(p.v[static_cast<std::size_t>(row * 3 + col)], p.uv[static_cast<std::size_t>(row * 6 + col * 2 + 1)]);
+        }
+    const std::vector<std::uint32_t> rgb = convert(p, YuvLayout::I420, width, height, 6);
+    const std::uint32_t corner = rgb[static_cast<std::size_t>(2 * width + 4)];
+    EXPECT_NEAR(red(corner), 200, 3);
+    EXPECT_NEAR(green(corner), 120, 3);
+    EXPECT_NEAR(blue(corner), 160, 3);
+}
@@ -0,0 +1,189 @@
+/**
+ * @file test_control_message.cpp
+ * @brief Unit tests for control messages parsed once and serialized in place
+ *
+ * Tests validate:
+ * - A parsed message carries every field, malformed bytes give null
+ * - The parsed message costs one allocation (short strings and repeated fields included)
+ * - It outlives the received bytes and is shared, not copied
+ * - Serializing into a QByteArray gives the same bytes as SerializeToString()
+ * - An appended stream_id overrides the message's own on the receiving side
+ * - Serialized messages appended as batch entries parse as a ControlBatch, in
+ *   order and sharing one arena
+ */
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+#include "controlmessage.h"
+
+using imagesocket::control::ControlMessage;
+
+namespace {
+
+std::atomic<bool> g_counting{false};
+std::atomic<int> g_allocations{0};
+
+} // namespace
+
+// Counts every allocation of the test binary while g_counting is set
+void* operator new(std::size_t size)
+{
+    if (g_counting.load(std::memory_order_relaxed))
+        g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size))
+        return p;
+    throw std::bad_alloc();
+}
+
+// Out of line: inlined into a new-expression, GCC would flag the free() as mismatched
+[[gnu::noinline]] void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+[[gnu::noinline]] void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace {
+
+ControlMessage hello()
+{
+    ControlMessage msg;
+    msg.set_type(imagesocket::control::HELLO);
+    msg.set_alias("camera-entrance");
+    msg.set_session_token("3f2a9c1e-5b7d-4e8f-a012-6c4d9e7b1a23");
+    msg.set_shm_ring("imagesocket-ring-7f3a2c");
+    msg.add_codecs(imagesocket::control::H264);
+    msg.set_fps(30);
+    return msg;
+}
+
+} // namespace
+
+TEST(ControlMessageTest, ParsesEveryField) {
+    const std::string bytes = hello().SerializeAsString();
+    const ControlMessagePtr msg = parseControlMessage(bytes.data(), static_cast<int>(bytes.size()));
+    ASSERT_TRUE(msg);
+    EXPECT_EQ(msg->type(), imagesocket::control::HELLO);
+    EXPECT_EQ(msg->alias(), "camera-entrance");
+    EXPECT_EQ(msg->session_token(), "3f2a9c1e-5b7d-4e8f-a012-6c4d9e7b1a23");
+    EXPECT_EQ(msg->shm_ring(), "imagesocket-ring-7f3a2c");
+    ASSERT_EQ(msg->codecs_size(), 1);
+    EXPECT_EQ(msg->fps(), 30);
+
+    EXPECT_FALSE(parseControlMessage("\xff\xff\xff", 3));
+}
+
+TEST(ControlMessageTest, OneAllocationPerParsedMessage) {
+    ControlMessage shortHello;
+    shortHello.set_type(imagesocket::control::HELLO);
+    shortHello.set_alias("entrance");
+    shortHello.add_codecs(imagesocket::control::H264);
+    shortHello.add_codecs(imagesocket::control::H265);
+    shortHello.set_fps(30);
+    const std::string bytes = shortHello.SerializeAsString();
+    parseControlMessage(bytes.data(), static_cast<int>(bytes.size())); // first use sets up protobuf's statics
+
+    g_allocations.store(0);
+    g_counting.store(true);
+    ControlMessagePtr msg = parseControlMessage(bytes.data(), static_cast<int>(bytes.size()));
+    g_counting.store(false);
+    ASSERT_TRUE(msg);
+    EXPECT_EQ(g_allocations.load(), 1); // the string and the repeated field are on the arena
+}
+
+TEST(ControlMessageTest, SharedNotCopied) {
+    ControlMessagePtr msg;
+    {
+        std::string bytes = hello().SerializeAsString();
+        msg = parseControlMessage(bytes.data(), static_cast<int>(bytes.size()));
+        bytes.assign(bytes.size(), '\0'); // the received buffer is reused for the next message
+    }
+    ASSERT_TRUE(msg);
+    const ControlMessagePtr receiver = msg; // what a queued signal hands on
+    EXPECT_EQ(receiver.get(), msg.get());
+    msg.reset();
+    EXPECT_EQ(receiver->alias(), "camera-entrance");
+}
+
+TEST(ControlMessageTest, SerializesInPlace) {
+    const ControlMessage msg = hello();
+    const QByteArray bytes = serializeControlMessage(msg);
+    const std::string expected = msg.SerializeAsString();
+    EXPECT_EQ(std::string(bytes.constData(), static_cast<std::size_t>(bytes.size())), expected);
+
+    ControlMessage empty;
+    EXPECT_EQ(serializeControlMessage(empty).size(), 0);
+}
+
+TEST(ControlMessageTest, AppendedStreamIdWins) {
+    ControlMessage msg;
+    msg.set_type(imagesocket::control::SET_FPS);
+    msg.set_fps(12);
+    msg.set_stream_id(1);
+    QByteArray bytes = serializeControlMessage(msg);
+
+    ControlMessage stream;
+    stream.set_stream_id(3);
+    appendControlMessage(bytes, stream);
+
+    const ControlMessagePtr parsed = parseControlMessage(bytes.constData(), bytes.size());
+    ASSERT_TRUE(parsed);
+    EXPECT_EQ(parsed->type(), imagesocket::control::SET_FPS);
+    EXPECT_EQ(parsed->fps(), 12);
+    EXPECT_EQ(parsed->stream_id(), 3u);
+}
+
+TEST(ControlMessageTest, BatchFromSerializedMessages) {
+    ControlMessage ping;
+    ping.set_type(imagesocket::control::PING);
+    ping.set_timestamp_us(1234);
+    ControlMessage fps;
+    fps.set_type(imagesocket::control::SET_FPS);
+    fps.set_fps(15);
+    ControlMessage config = hello();
+    const std::string large(300, 'x'); // a two-byte entry length
+    ControlMessage reason;
+    reason.set_type(imagesocket::control::PAUSE);
+    reason.set_reason(large);
+
+    QByteArray batch;
+    for (const ControlMessage* msg : {&ping, &fps, &config, &reason}) {
+        const std::string bytes = msg->SerializeAsString();
+        appendControlBatchEntry(batch, bytes.data(), bytes.size());
+    }
+    std::string viaString;
+    const std::string pingBytes = ping.SerializeAsString();
+    appendControlBatchEntry(viaString, pingBytes.data(), pingBytes.size());
+
+    // The same bytes protobuf writes for the batch message
+    imagesocket::control::ControlBatch expected;
+    *expected.add_messages() = ping;
+    *expected.add_messages() = fps;
+    *expected.add_messages() = config;
+    *expected.add_messages() = reason;
+    EXPECT_EQ(std::string(batch.constData(), static_cast<std::size_t>(batch.size())), expected.SerializeAsString());
+    EXPECT_EQ(viaString, std::string(expected.SerializeAsString(), 0, viaString.size()));
+
+    std::vector<ControlMessagePtr> messages;
+    ASSERT_TRUE(parseControlBatch(batch.constData(), batch.size(), messages));
+    ASSERT_EQ(messages.size(), 4u);
+    EXPECT_EQ(messages[0]->timestamp_us(), 1234);
+    EXPECT_EQ(messages[1]->fps(), 15);
+    EXPECT_EQ(messages[2]->alias(), "camera-entrance");
+    EXPECT_EQ(messages[3]->reason(), large);
+
+    // Each message keeps the whole batch alive
+    const ControlMessagePtr last = messages[3];
+    messages.clear();
+    EXPECT_EQ(last->reason(), large);
+
+    EXPECT_FALSE(parseControlBatch("\x0a\x05\x08", 3, messages)); // entry cut short
+    EXPECT_TRUE(messages.empty());
+}
@@ -184,6 +184,68 @@ TEST_F(TestProtobufSerialization, EmptyAliasRoundtrip) {
     EXPECT_TRUE(deserialized.alias().empty());
 }
 
+// Test: HELLO capabilities and the CONFIG answer survive the roundtrip
+TEST_F(TestProtobufSerialization, HelloAndConfigRoundtrip) {
+    auto hello = ProtobufHelpers::CreateControlMessage(imagesocket::control::HELLO);
+    hello.set_alias("camera-1");
+    hello.add_codecs(imagesocket::control::H264);
+    hello.set_fps(60);
+    hello.set_max_width(1920);
+    hello.set_max_height(1080);
+    hello.set_stream_count(2);
+    hello.set_session_token("cam-1");
+
+    imagesocket::control::ControlMessage parsedHello;
+    auto serialized = ProtobufHelpers::SerializeMessage(hello);
+    ASSERT_TRUE(ProtobufHelpers::DeserializeMessage(serialized.data(), serialized.size(), parsedHello));
+    EXPECT_EQ(parsedHello.type(), imagesocket::control::HELLO);
+    EXPECT_EQ(parsedHello.alias(), "camera-1");
+    ASSERT_EQ(parsedHello.codecs_size(), 1);
+    EXPECT_EQ(parsedHello.codecs(0), imagesocket::control::H264);
+    EXPECT_EQ(parsedHello.fps(), 60);
+    EXPECT_EQ(parsedHello.max_width(), 1920);
+    EXPECT_EQ(parsedHello.stream_count(), 2);
+    EXPECT_EQ(parsedHello.session_token(), "cam-1");
+
+    auto config = ProtobufHelpers::CreateControlMessage(imagesocket::control::CONFIG);
+    config.set_fps(15);
+    config.set_quality(70);
+    config.set_codec(imagesocket::control::H264);
+    config.set_paused(true);
+    config.set_frame_header(true);
+    config.set_session_token("cam-1");
+
+    imagesocket::control::ControlMessage parsedConfig;
+    serialized = ProtobufHelpers::SerializeMessage(config);
+    ASSERT_TRUE(ProtobufHelpers::DeserializeMessage(serialized.data(), serialized.size(), parsedConfig));
+    EXPECT_EQ(parsedConfig.fps(), 15);
+    EXPECT_EQ(parsedConfig.quality(), 70);
+    EXPECT_EQ(parsedConfig.codec(), imagesocket::control::H264);
+    EXPECT_TRUE(parsedConfig.paused());
+    EXPECT_TRUE(parsedConfig.frame_header());
+    EXPECT_EQ(parsedConfig.session_token(), "cam-1");
+    EXPECT_EQ(parsedConfig.max_width(), 0); // full resolution
+}
+
+// Test: A command addressed to one stream of a connection keeps its stream id
+TEST_F(TestProtobufSerialization, StreamIdRoundtrip) {
+    auto msg = ProtobufHelpers::CreateControlMessage(imagesocket::control::SET_FPS);
+    msg.set_fps(5);
+    msg.set_stream_id(3);
+
+    imagesocket::control::ControlMessage parsed;
+    auto serialized = ProtobufHelpers::SerializeMessage(msg);
+    ASSERT_TRUE(ProtobufHelpers::DeserializeMessage(serialized.data(), serialized.size(), parsed));
+    EXPECT_EQ(parsed.fps(), 5);
+    EXPECT_EQ(parsed.stream_id(), 3u);
+
+    // Older servers never set it: the main stream
+    auto plain = ProtobufHelpers::CreateControlMessage(imagesocket::control::PAUSE);
+    serialized = ProtobufHelpers::SerializeMessage(plain);
+    ASSERT_TRUE(ProtobufHelpers::DeserializeMessage(serialized.data(), serialized.size(), parsed));
+    EXPECT_EQ(parsed.stream_id(), 0u);
+}
+
 // Test: Serialization size is reasonable (< 10KB for normal messages)
 TEST_F(TestProtobufSerialization, SerializationSizeReasonable) {
     auto msg = ProtobufHelpers::CreateFullMessage(